@@ -81,6 +81,17 @@ namespace otb
  * GetHeightAboveEllipsoid() method.
  *
  * DEM directory can either contain DTED or SRTM formats.
+ *
+ * Height lookups can optionally go through an in-memory tile cache
+ * (SetUseCache()). Heights are then sampled once from OSSIM on 1x1 degree
+ * tiles with CacheSamplesPerDegree posts per degree (1200 by default,
+ * matching SRTM 3 arc-second posts), and later lookups are bilinearly
+ * interpolated from the cached grids. Reading a cached tile takes no lock,
+ * so all threads of the geometric filters share the cache without
+ * contention; tiles are sampled without lock and published atomically. Once
+ * CacheMaximumNumberOfTiles tiles are cached, lookups on other tiles
+ * go to OSSIM directly. The cache is dropped whenever the elevation
+ * configuration changes.
  * \ingroup Images
  *
  *
@@ -167,9 +178,38 @@ public:
    */
   void ClearDEMs();
 
+  /** Enable/disable the in-memory tile cache (disabled by default) */
+  void SetUseCache(bool useCache);
+  bool GetUseCache() const;
+
+  /** Set/Get the number of cached posts per degree */
+  void SetCacheSamplesPerDegree(unsigned int samples);
+  unsigned int GetCacheSamplesPerDegree() const;
+
+  /** Set/Get the maximum number of cached tiles */
+  void SetCacheMaximumNumberOfTiles(unsigned int nbTiles);
+  unsigned int GetCacheMaximumNumberOfTiles() const;
+
+  /** Enable/disable the counting of cache hits and misses (disabled by
+   * default, as every lookup then updates a shared counter) */
+  void SetCacheStatistics(bool statistics);
+  bool GetCacheStatistics() const;
+
+  /** Number of lookups served by a cached tile (0 if the statistics are
+   * disabled) */
+  unsigned long GetCacheHits() const;
+
+  /** Number of lookups that had to create a tile or go to OSSIM (0 if the
+   * statistics are disabled) */
+  unsigned long GetCacheMisses() const;
+
+  /** Drop the cached tiles and reset the counters. This must not be called
+   * while other threads are reading heights. */
+  void ClearCache();
+
 protected:
   DEMHandler();
-  ~DEMHandler() ITK_OVERRIDE {}
+  ~DEMHandler() ITK_OVERRIDE;
 
   void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
 
@@ -183,6 +223,21 @@ protected:
 
   static Pointer m_Singleton;
 
+private:
+  DEMHandler(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+
+  class TileCache;
+
+  bool         m_UseCache;
+  unsigned int m_CacheSamplesPerDegree;
+  unsigned int m_CacheMaximumNumberOfTiles;
+  bool         m_CacheStatistics;
+
+  // One cache per kind of height, built on demand
+  TileCache * m_MSLCache;
+  TileCache * m_EllipsoidCache;
+
 };
 
 } // namespace otb
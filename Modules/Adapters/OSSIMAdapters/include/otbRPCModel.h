@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbRPCModel_h
+#define otbRPCModel_h
+
+#include <iosfwd>
+
+#include "itkIndent.h"
+
+#include "OTBOSSIMAdaptersExport.h"
+
+namespace otb
+{
+
+class ImageKeywordlist;
+
+/**
+ * \class RPCModel
+ * \brief Native evaluation of Rational Polynomial Coefficients sensor models
+ *
+ * This class reads the RPC parameters stored in an ImageKeywordlist (as
+ * written by ossimRpcModel and ossimRpcProjection, polynomial format A or B)
+ * and evaluates the model without going through OSSIM.
+ *
+ * Points are processed by blocks laid out as structure of arrays, so that
+ * the evaluation of the 20 terms polynomials vectorizes. The ground to image
+ * direction is the closed form ratio of polynomials. The image to ground
+ * direction at a given height is solved by Newton iterations using the
+ * analytic derivatives of the polynomials.
+ *
+ * Image coordinates are expressed in the RPC frame, where the centre of the
+ * first pixel is at (0,0). Ground coordinates are longitude, latitude in
+ * degrees and height above ellipsoid in meters.
+ *
+ * This class is used by SensorModelAdapter, which should be preferred.
+ *
+ * \sa SensorModelAdapter
+ *
+ * \ingroup OTBOSSIMAdapters
+ **/
+
+class OTBOSSIMAdapters_EXPORT RPCModel
+{
+public:
+  /** Number of terms of each polynomial */
+  static const unsigned int NumberOfCoefficients = 20;
+
+  RPCModel();
+
+  /** Read the model from a keywordlist. Returns false (and leaves the model
+   *  invalid) if the keywordlist does not hold a complete RPC model. */
+  bool SetFromKeywordlist(const ImageKeywordlist& kwl);
+
+  /** Reset to an invalid model */
+  void Clear();
+
+  /** Is the model usable */
+  bool IsValid() const
+  {
+    return m_Valid;
+  }
+
+  /** Normalization of the ground coordinates. The height offset is used
+   *  when no height is available. */
+  double GetLatitudeOffset() const
+  {
+    return m_LatitudeOffset;
+  }
+  double GetLatitudeScale() const
+  {
+    return m_LatitudeScale;
+  }
+  double GetLongitudeOffset() const
+  {
+    return m_LongitudeOffset;
+  }
+  double GetLongitudeScale() const
+  {
+    return m_LongitudeScale;
+  }
+  double GetHeightOffset() const
+  {
+    return m_HeightOffset;
+  }
+  double GetHeightScale() const
+  {
+    return m_HeightScale;
+  }
+
+  /** Image to ground projection of nbPoints points at the given heights */
+  void ForwardTransformPoints(const double * x, const double * y, const double * h,
+                              double * lon, double * lat,
+                              unsigned long nbPoints) const;
+
+  /** Ground to image projection of nbPoints points */
+  void InverseTransformPoints(const double * lon, const double * lat, const double * h,
+                              double * x, double * y,
+                              unsigned long nbPoints) const;
+
+  /** Maximum number of Newton iterations of the image to ground projection */
+  void SetMaximumNumberOfIterations(unsigned int nbIterations)
+  {
+    m_MaximumNumberOfIterations = nbIterations;
+  }
+  unsigned int GetMaximumNumberOfIterations() const
+  {
+    return m_MaximumNumberOfIterations;
+  }
+
+  /** Convergence threshold (in pixels) of the image to ground projection */
+  void SetConvergenceThreshold(double threshold)
+  {
+    m_ConvergenceThreshold = threshold;
+  }
+  double GetConvergenceThreshold() const
+  {
+    return m_ConvergenceThreshold;
+  }
+
+  void Print(std::ostream& os, itk::Indent indent = 0) const;
+
+private:
+  /** Number of points processed together */
+  static const unsigned int BlockSize = 64;
+
+  /** Ground to image projection of a block of normalized points */
+  void InverseTransformBlock(const double * P, const double * L, const double * H,
+                             double * U, double * V, unsigned int nbPoints) const;
+
+  /** Image to ground projection of a block of normalized points */
+  void ForwardTransformBlock(const double * U, const double * V, const double * H,
+                             double * P, double * L, unsigned int nbPoints) const;
+
+  bool m_Valid;
+
+  double m_LineOffset;
+  double m_SampleOffset;
+  double m_LatitudeOffset;
+  double m_LongitudeOffset;
+  double m_HeightOffset;
+  double m_LineScale;
+  double m_SampleScale;
+  double m_LatitudeScale;
+  double m_LongitudeScale;
+  double m_HeightScale;
+
+  /** Coefficients, always stored in the B (RPC00B) term order */
+  double m_LineNumerator[NumberOfCoefficients];
+  double m_LineDenominator[NumberOfCoefficients];
+  double m_SampleNumerator[NumberOfCoefficients];
+  double m_SampleDenominator[NumberOfCoefficients];
+
+  unsigned int m_MaximumNumberOfIterations;
+  double       m_ConvergenceThreshold;
+};
+
+} // namespace otb
+
+#endif
@@ -22,6 +22,7 @@
 #define otbSensorModelAdapter_h
 
 #include "otbDEMHandler.h"
+#include "otbRPCModel.h"
 
 class ossimProjection;
 class ossimTieGptSet;
@@ -39,6 +40,11 @@ class ImageKeywordlist;
  * InverseSensorModel and ForwardSensorModel. If you feel that you need to use
  * it directly, think again!
  *
+ * When SetUseNativeRPCModel() is on and the sensor model is a RPC model,
+ * projections are evaluated by the native RPCModel instead of OSSIM. The
+ * native model is only enabled if it reproduces the OSSIM ground to image
+ * projection on a set of check points, otherwise OSSIM is used.
+ *
  * \sa InverseSensorModel
  * \sa ForwardSensorModel
  * \ingroup Projection
@@ -87,6 +93,20 @@ public:
   void InverseTransformPoint(double lon, double lat,
                              double& x, double& y, double& z) const;
 
+  /** Forward sensor modelling of a batch of nbPoints points. If z is
+   *  null, the elevation is estimated by the algorithm as in the single
+   *  point version. Output arrays must hold nbPoints values. */
+  void ForwardTransformPoints(const double * x, const double * y, const double * z,
+                              double * lon, double * lat, double * h,
+                              unsigned long nbPoints) const;
+
+  /** Inverse sensor modelling of a batch of nbPoints points. If h is
+   *  null, the elevation (above ellipsoid) is read from the DEMHandler.
+   *  Output arrays must hold nbPoints values. */
+  void InverseTransformPoints(const double * lon, const double * lat, const double * h,
+                              double * x, double * y, double * z,
+                              unsigned long nbPoints) const;
+
 
   /** Add a tie point with elevation (above ellipsoid) provided by the user */
   void AddTiePoint(double x, double y, double z, double lon, double lat);
@@ -103,6 +123,23 @@ public:
   /** Is sensor model valid method. return false if the m_SensorModel is null*/
   bool IsValidSensorModel() const;
 
+  /** Enable the native evaluation of RPC models (default is false). It
+   * must be set before CreateProjection() or ReadGeomFile(). */
+  void SetUseNativeRPCModel(bool flag)
+  {
+    m_UseNativeRPCModel = flag;
+  }
+  bool GetUseNativeRPCModel() const
+  {
+    return m_UseNativeRPCModel;
+  }
+
+  /** Is the sensor model evaluated by the native RPC model */
+  bool IsNativeRPCModel() const
+  {
+    return m_UseNativeRPCModel && m_RPCModel.IsValid();
+  }
+
   /** Read geom file and instantiate sensor model */
   bool ReadGeomFile(const std::string & infile);
 
@@ -121,6 +158,18 @@ private:
 
   InternalTiePointsContainerPointer m_TiePoints;
 
+  /** Set up the native RPC model from the keywordlist of a RPC sensor model */
+  void InitializeNativeRPCModel(const ImageKeywordlist& image_kwl);
+
+  /** Image to ground projection on the DEM with the native RPC model */
+  void NativeForwardTransformPointsOnDEM(const double * x, const double * y,
+                                         double * lon, double * lat, double * h,
+                                         unsigned long nbPoints) const;
+
+  /** Native RPC model, valid only for RPC sensor models */
+  RPCModel m_RPCModel;
+  bool     m_UseNativeRPCModel;
+
   /** Object that read and use DEM */
   DEMHandler::Pointer m_DEMHandler;
 };
@@ -22,6 +22,10 @@
 #include "otbMacro.h"
 
 #include <cassert>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cmath>
 
 #if defined(__GNUC__) || defined(__clang__)
 #pragma GCC diagnostic push
@@ -50,6 +54,164 @@
 
 namespace otb
 {
+
+/** \class DEMHandler::TileCache
+ * Heights sampled on 1x1 degree tiles. Tiles are published through atomic
+ * pointers and never modified afterwards, so readers never lock. A tile
+ * is sampled outside of any lock and published by compare-and-swap: when
+ * two threads build the same tile, the loser drops its copy. Hits and
+ * misses are only counted when the statistics are enabled.
+ */
+class DEMHandler::TileCache
+{
+public:
+  typedef double (ossimElevManager::*HeightFunctionType)(const ossimGpt &);
+
+  TileCache(HeightFunctionType heightFunction, unsigned int samplesPerDegree, unsigned int maxTiles,
+            bool collectStatistics)
+    : m_HeightFunction(heightFunction),
+      m_SamplesPerDegree(std::max(samplesPerDegree, 1U)),
+      m_MaximumNumberOfTiles(maxTiles),
+      m_CollectStatistics(collectStatistics),
+      m_NumberOfTiles(0),
+      m_Slots(new std::atomic<const float *>[NumberOfSlots]),
+      m_Hits(0),
+      m_Misses(0)
+  {
+    for (unsigned int i = 0; i < NumberOfSlots; ++i)
+      {
+      m_Slots[i].store(ITK_NULLPTR, std::memory_order_relaxed);
+      }
+  }
+
+  ~TileCache()
+  {
+    for (unsigned int i = 0; i < NumberOfSlots; ++i)
+      {
+      delete [] m_Slots[i].load(std::memory_order_relaxed);
+      }
+  }
+
+  /** Bilinear height at (lon, lat), or NaN if the tile is not available
+   * or one of the surrounding posts is not defined */
+  double GetHeight(double lon, double lat)
+  {
+    if (!(lat >= -90. && lat <= 90.) || ossim::isnan(lon))
+      {
+      return ossim::nan();
+      }
+    lon = lon - 360. * std::floor((lon + 180.) / 360.);
+
+    const int lonTile = std::min(static_cast<int>(std::floor(lon)), 179);
+    const int latTile = std::min(static_cast<int>(std::floor(lat)), 89);
+    const float * tile = this->GetTile(lonTile, latTile);
+    if (tile == ITK_NULLPTR)
+      {
+      return ossim::nan();
+      }
+
+    const unsigned int n = m_SamplesPerDegree;
+    const double fx = (lon - lonTile) * n;
+    const double fy = (lat - latTile) * n;
+    const unsigned int i = std::min(static_cast<unsigned int>(fx), n - 1);
+    const unsigned int j = std::min(static_cast<unsigned int>(fy), n - 1);
+    const double dx = fx - i;
+    const double dy = fy - j;
+
+    const float * row0 = tile + j * (n + 1) + i;
+    const float * row1 = row0 + (n + 1);
+    return (1. - dy) * ((1. - dx) * row0[0] + dx * row0[1])
+      + dy * ((1. - dx) * row1[0] + dx * row1[1]);
+  }
+
+  unsigned long GetHits() const
+  {
+    return m_Hits.load(std::memory_order_relaxed);
+  }
+
+  unsigned long GetMisses() const
+  {
+    return m_Misses.load(std::memory_order_relaxed);
+  }
+
+private:
+  TileCache(const TileCache &); //purposely not implemented
+  void operator =(const TileCache &); //purposely not implemented
+
+  static const unsigned int NumberOfSlots = 360 * 180;
+
+  const float * GetTile(int lonTile, int latTile)
+  {
+    std::atomic<const float *> & slot = m_Slots[(latTile + 90) * 360 + lonTile + 180];
+
+    // Lock-free path: the tile is published once and never modified
+    const float * tile = slot.load(std::memory_order_acquire);
+    if (tile != ITK_NULLPTR)
+      {
+      if (m_CollectStatistics)
+        {
+        m_Hits.fetch_add(1, std::memory_order_relaxed);
+        }
+      return tile;
+      }
+
+    if (m_CollectStatistics)
+      {
+      m_Misses.fetch_add(1, std::memory_order_relaxed);
+      }
+
+    // Reserve room for a new tile
+    unsigned int nbTiles = m_NumberOfTiles.load(std::memory_order_relaxed);
+    do
+      {
+      if (nbTiles >= m_MaximumNumberOfTiles)
+        {
+        return ITK_NULLPTR;
+        }
+      }
+    while (!m_NumberOfTiles.compare_exchange_weak(nbTiles, nbTiles + 1, std::memory_order_relaxed));
+
+    // Sample the tile without holding any lock, then publish it unless
+    // another thread was faster
+    const float * newTile = this->BuildTile(lonTile, latTile);
+    if (slot.compare_exchange_strong(tile, newTile, std::memory_order_acq_rel, std::memory_order_acquire))
+      {
+      return newTile;
+      }
+
+    delete [] newTile;
+    m_NumberOfTiles.fetch_sub(1, std::memory_order_relaxed);
+    return tile;
+  }
+
+  const float * BuildTile(int lonTile, int latTile) const
+  {
+    const unsigned int n = m_SamplesPerDegree;
+    float * tile = new float[(n + 1) * (n + 1)];
+    ossimElevManager * manager = ossimElevManager::instance();
+    ossimGpt point;
+    for (unsigned int j = 0; j <= n; ++j)
+      {
+      point.lat = latTile + static_cast<double>(j) / n;
+      for (unsigned int i = 0; i <= n; ++i)
+        {
+        point.lon = lonTile + static_cast<double>(i) / n;
+        tile[j * (n + 1) + i] = static_cast<float>((manager->*m_HeightFunction)(point));
+        }
+      }
+    return tile;
+  }
+
+  HeightFunctionType                         m_HeightFunction;
+  const unsigned int                         m_SamplesPerDegree;
+  const unsigned int                         m_MaximumNumberOfTiles;
+  const bool                                 m_CollectStatistics;
+  std::atomic<unsigned int>                  m_NumberOfTiles;
+  std::unique_ptr<std::atomic<const float *>[]> m_Slots;
+  std::atomic<unsigned long>                 m_Hits;
+  std::atomic<unsigned long>                 m_Misses;
+};
+
 /** Initialize the singleton */
 DEMHandler::Pointer DEMHandler::m_Singleton = ITK_NULLPTR;
 
@@ -72,7 +234,13 @@ DEMHandler::Pointer DEMHandler::Instance()
 DEMHandler
 ::DEMHandler() :
   m_GeoidFile(""),
-  m_DefaultHeightAboveEllipsoid(0)
+  m_DefaultHeightAboveEllipsoid(0),
+  m_UseCache(false),
+  m_CacheSamplesPerDegree(1200),
+  m_CacheMaximumNumberOfTiles(16),
+  m_CacheStatistics(false),
+  m_MSLCache(ITK_NULLPTR),
+  m_EllipsoidCache(ITK_NULLPTR)
 {
   assert( ossimElevManager::instance()!=NULL );
 
@@ -81,6 +249,133 @@ DEMHandler
   ossimElevManager::instance()->setUseGeoidIfNullFlag(true);
 }
 
+DEMHandler
+::~DEMHandler()
+{
+  delete m_MSLCache;
+  delete m_EllipsoidCache;
+}
+
+void
+DEMHandler
+::ClearCache()
+{
+  delete m_MSLCache;
+  delete m_EllipsoidCache;
+  m_MSLCache = ITK_NULLPTR;
+  m_EllipsoidCache = ITK_NULLPTR;
+
+  if (m_UseCache)
+    {
+    m_MSLCache = new TileCache(&ossimElevManager::getHeightAboveMSL,
+                               m_CacheSamplesPerDegree, m_CacheMaximumNumberOfTiles,
+                               m_CacheStatistics);
+    m_EllipsoidCache = new TileCache(&ossimElevManager::getHeightAboveEllipsoid,
+                                     m_CacheSamplesPerDegree, m_CacheMaximumNumberOfTiles,
+                                     m_CacheStatistics);
+    }
+}
+
+void
+DEMHandler
+::SetUseCache(bool useCache)
+{
+  if (useCache != m_UseCache)
+    {
+    m_UseCache = useCache;
+    this->ClearCache();
+    }
+}
+
+bool
+DEMHandler
+::GetUseCache() const
+{
+  return m_UseCache;
+}
+
+void
+DEMHandler
+::SetCacheSamplesPerDegree(unsigned int samples)
+{
+  if (samples == 0)
+    {
+    itkExceptionMacro(<< "The number of cached samples per degree must be positive");
+    }
+  if (samples != m_CacheSamplesPerDegree)
+    {
+    m_CacheSamplesPerDegree = samples;
+    this->ClearCache();
+    }
+}
+
+unsigned int
+DEMHandler
+::GetCacheSamplesPerDegree() const
+{
+  return m_CacheSamplesPerDegree;
+}
+
+void
+DEMHandler
+::SetCacheMaximumNumberOfTiles(unsigned int nbTiles)
+{
+  if (nbTiles != m_CacheMaximumNumberOfTiles)
+    {
+    m_CacheMaximumNumberOfTiles = nbTiles;
+    this->ClearCache();
+    }
+}
+
+unsigned int
+DEMHandler
+::GetCacheMaximumNumberOfTiles() const
+{
+  return m_CacheMaximumNumberOfTiles;
+}
+
+void
+DEMHandler
+::SetCacheStatistics(bool statistics)
+{
+  if (statistics != m_CacheStatistics)
+    {
+    m_CacheStatistics = statistics;
+    this->ClearCache();
+    }
+}
+
+bool
+DEMHandler
+::GetCacheStatistics() const
+{
+  return m_CacheStatistics;
+}
+
+unsigned long
+DEMHandler
+::GetCacheHits() const
+{
+  unsigned long hits = 0;
+  if (m_MSLCache)
+    {
+    hits += m_MSLCache->GetHits() + m_EllipsoidCache->GetHits();
+    }
+  return hits;
+}
+
+unsigned long
+DEMHandler
+::GetCacheMisses() const
+{
+  unsigned long misses = 0;
+  if (m_MSLCache)
+    {
+    misses += m_MSLCache->GetMisses() + m_EllipsoidCache->GetMisses();
+    }
+  return misses;
+}
+
 void
 DEMHandler
 ::OpenDEMDirectory(const char* DEMDirectory)
@@ -109,6 +404,8 @@ DEMHandler
       ossimElevManager::instance()->addDatabase(imageElevationDatabase.get());
       }
     }
+
+  this->ClearCache();
 }
 
 
@@ -119,6 +416,8 @@ DEMHandler
   assert( ossimElevManager::instance()!=NULL );
 
   ossimElevManager::instance()->clear();
+
+  this->ClearCache();
 }
 
 
@@ -172,6 +471,8 @@ DEMHandler
 
       ossimElevManager::instance()->setDefaultHeightAboveEllipsoid(ossim::nan());
 
+      this->ClearCache();
+
       return true;
       }
     else
@@ -205,6 +506,15 @@ DEMHandler
   ossimWorldPoint.lon = lon;
   ossimWorldPoint.lat = lat;
 
+  if (m_MSLCache)
+    {
+    height = m_MSLCache->GetHeight(lon, lat);
+    if (!ossim::isnan(height))
+      {
+      return height;
+      }
+    }
+
   assert( ossimElevManager::instance()!=NULL );
 
   height = ossimElevManager::instance()->getHeightAboveMSL(ossimWorldPoint);
@@ -229,6 +539,15 @@ DEMHandler
   ossimWorldPoint.lon = lon;
   ossimWorldPoint.lat = lat;
 
+  if (m_EllipsoidCache)
+    {
+    height = m_EllipsoidCache->GetHeight(lon, lat);
+    if (!ossim::isnan(height))
+      {
+      return height;
+      }
+    }
+
   assert( ossimElevManager::instance()!=NULL );
 
   height = ossimElevManager::instance()->getHeightAboveEllipsoid(ossimWorldPoint);
@@ -249,11 +568,17 @@ DEMHandler
 {
   // Ossim does not allow retrieving the default height above
   // ellipsoid We therefore must keep it on our side
+  const bool changed = (h != m_DefaultHeightAboveEllipsoid);
   m_DefaultHeightAboveEllipsoid = h;
 
   assert( ossimElevManager::instance()!=NULL );
 
   ossimElevManager::instance()->setDefaultHeightAboveEllipsoid(h);
+
+  if (changed)
+    {
+    this->ClearCache();
+    }
 }
 
 double
@@ -300,6 +625,12 @@ DEMHandler
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "DEMHandler" << std::endl;
+  os << indent << "UseCache: " << m_UseCache << std::endl;
+  os << indent << "CacheSamplesPerDegree: " << m_CacheSamplesPerDegree << std::endl;
+  os << indent << "CacheMaximumNumberOfTiles: " << m_CacheMaximumNumberOfTiles << std::endl;
+  os << indent << "CacheStatistics: " << m_CacheStatistics << std::endl;
+  os << indent << "CacheHits: " << this->GetCacheHits() << std::endl;
+  os << indent << "CacheMisses: " << this->GetCacheMisses() << std::endl;
 }
 
 } // namespace otb
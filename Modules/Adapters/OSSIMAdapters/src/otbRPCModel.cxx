@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbRPCModel.h"
+
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include <locale>
+#include <algorithm>
+
+#include "otbImageKeywordlist.h"
+
+namespace otb
+{
+
+namespace
+{
+/** Terms of the A (RPC00A) format, in the B (RPC00B) order */
+const unsigned int ATermsInBOrder[RPCModel::NumberOfCoefficients] =
+  {0, 1, 2, 3, 4, 5, 6, 8, 9, 10, 7, 11, 14, 17, 12, 15, 18, 13, 16, 19};
+
+/** Value of a RPC00B polynomial at normalized latitude P, longitude L and
+ *  height H. The expression follows the term order of the standard so that
+ *  the result matches the OSSIM evaluation. */
+inline double Polynomial(const double * c, double P, double L, double H)
+{
+  return c[ 0]       + c[ 1]*L     + c[ 2]*P     + c[ 3]*H     +
+         c[ 4]*L*P   + c[ 5]*L*H   + c[ 6]*P*H   + c[ 7]*L*L   +
+         c[ 8]*P*P   + c[ 9]*H*H   + c[10]*L*P*H + c[11]*L*L*L +
+         c[12]*L*P*P + c[13]*L*H*H + c[14]*L*L*P + c[15]*P*P*P +
+         c[16]*P*H*H + c[17]*L*L*H + c[18]*P*P*H + c[19]*H*H*H;
+}
+
+/** Derivative of a RPC00B polynomial with respect to L */
+inline double PolynomialDerivativeL(const double * c, double P, double L, double H)
+{
+  return c[ 1] + c[ 4]*P + c[ 5]*H + 2.*c[ 7]*L + c[10]*P*H + 3.*c[11]*L*L
+    + c[12]*P*P + c[13]*H*H + 2.*c[14]*L*P + 2.*c[17]*L*H;
+}
+
+/** Derivative of a RPC00B polynomial with respect to P */
+inline double PolynomialDerivativeP(const double * c, double P, double L, double H)
+{
+  return c[ 2] + c[ 4]*L + c[ 6]*H + 2.*c[ 8]*P + c[10]*L*H + 2.*c[12]*L*P
+    + c[14]*L*L + 3.*c[15]*P*P + c[16]*H*H + 2.*c[18]*P*H;
+}
+
+/** Read a floating point value of the keywordlist */
+bool ReadValue(const ImageKeywordlist& kwl, const std::string& key, double& value)
+{
+  if (!kwl.HasKey(key))
+    {
+    return false;
+    }
+  std::istringstream iss(kwl.GetMetadataByKey(key));
+  iss.imbue(std::locale::classic());
+  iss >> value;
+  return !iss.fail();
+}
+
+/** Read the 20 coefficients of a polynomial, keyed prefix00 to prefix19 */
+bool ReadCoefficients(const ImageKeywordlist& kwl, const std::string& prefix, double * coefficients)
+{
+  for (unsigned int i = 0; i < RPCModel::NumberOfCoefficients; ++i)
+    {
+    std::ostringstream oss;
+    oss << prefix << std::setw(2) << std::setfill('0') << i;
+    if (!ReadValue(kwl, oss.str(), coefficients[i]))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+} // end of anonymous namespace
+
+const unsigned int RPCModel::NumberOfCoefficients;
+const unsigned int RPCModel::BlockSize;
+
+RPCModel::RPCModel()
+  : m_MaximumNumberOfIterations(20),
+    m_ConvergenceThreshold(1e-8)
+{
+  this->Clear();
+}
+
+void RPCModel::Clear()
+{
+  m_Valid = false;
+  m_LineOffset = m_SampleOffset = 0.;
+  m_LatitudeOffset = m_LongitudeOffset = m_HeightOffset = 0.;
+  m_LineScale = m_SampleScale = 1.;
+  m_LatitudeScale = m_LongitudeScale = m_HeightScale = 1.;
+  std::fill(m_LineNumerator, m_LineNumerator + NumberOfCoefficients, 0.);
+  std::fill(m_LineDenominator, m_LineDenominator + NumberOfCoefficients, 0.);
+  std::fill(m_SampleNumerator, m_SampleNumerator + NumberOfCoefficients, 0.);
+  std::fill(m_SampleDenominator, m_SampleDenominator + NumberOfCoefficients, 0.);
+}
+
+bool RPCModel::SetFromKeywordlist(const ImageKeywordlist& kwl)
+{
+  this->Clear();
+
+  if (!kwl.HasKey("polynomial_format"))
+    {
+    return false;
+    }
+  const std::string format = kwl.GetMetadataByKey("polynomial_format");
+  if (format != "A" && format != "B")
+    {
+    return false;
+    }
+
+  double lineNum[NumberOfCoefficients], lineDen[NumberOfCoefficients];
+  double sampNum[NumberOfCoefficients], sampDen[NumberOfCoefficients];
+
+  bool ok = ReadValue(kwl, "line_off", m_LineOffset)
+    && ReadValue(kwl, "samp_off", m_SampleOffset)
+    && ReadValue(kwl, "lat_off", m_LatitudeOffset)
+    && ReadValue(kwl, "long_off", m_LongitudeOffset)
+    && ReadValue(kwl, "height_off", m_HeightOffset)
+    && ReadValue(kwl, "line_scale", m_LineScale)
+    && ReadValue(kwl, "samp_scale", m_SampleScale)
+    && ReadValue(kwl, "lat_scale", m_LatitudeScale)
+    && ReadValue(kwl, "long_scale", m_LongitudeScale)
+    && ReadValue(kwl, "height_scale", m_HeightScale)
+    && ReadCoefficients(kwl, "line_num_coeff_", lineNum)
+    && ReadCoefficients(kwl, "line_den_coeff_", lineDen)
+    && ReadCoefficients(kwl, "samp_num_coeff_", sampNum)
+    && ReadCoefficients(kwl, "samp_den_coeff_", sampDen);
+
+  if (!ok || m_LatitudeScale == 0. || m_LongitudeScale == 0. || m_HeightScale == 0.)
+    {
+    this->Clear();
+    return false;
+    }
+
+  for (unsigned int i = 0; i < NumberOfCoefficients; ++i)
+    {
+    const unsigned int j = (format == "A") ? ATermsInBOrder[i] : i;
+    m_LineNumerator[i] = lineNum[j];
+    m_LineDenominator[i] = lineDen[j];
+    m_SampleNumerator[i] = sampNum[j];
+    m_SampleDenominator[i] = sampDen[j];
+    }
+
+  m_Valid = true;
+  return true;
+}
+
+void RPCModel::InverseTransformBlock(const double * P, const double * L, const double * H,
+                                     double * U, double * V, unsigned int nbPoints) const
+{
+  for (unsigned int i = 0; i < nbPoints; ++i)
+    {
+    U[i] = Polynomial(m_SampleNumerator, P[i], L[i], H[i]) / Polynomial(m_SampleDenominator, P[i], L[i], H[i]);
+    V[i] = Polynomial(m_LineNumerator, P[i], L[i], H[i]) / Polynomial(m_LineDenominator, P[i], L[i], H[i]);
+    }
+}
+
+void RPCModel::ForwardTransformBlock(const double * U, const double * V, const double * H,
+                                     double * P, double * L, unsigned int nbPoints) const
+{
+  // Convergence thresholds in normalized image coordinates
+  const double thresholdU = m_ConvergenceThreshold / std::abs(m_SampleScale);
+  const double thresholdV = m_ConvergenceThreshold / std::abs(m_LineScale);
+
+  bool active[BlockSize];
+  unsigned int nbActive = nbPoints;
+  for (unsigned int i = 0; i < nbPoints; ++i)
+    {
+    // Start from the centre of the model validity domain
+    P[i] = 0.;
+    L[i] = 0.;
+    active[i] = true;
+    }
+
+  for (unsigned int iteration = 0; iteration < m_MaximumNumberOfIterations && nbActive > 0; ++iteration)
+    {
+    for (unsigned int i = 0; i < nbPoints; ++i)
+      {
+      if (!active[i])
+        {
+        continue;
+        }
+
+      const double sn = Polynomial(m_SampleNumerator, P[i], L[i], H[i]);
+      const double sd = Polynomial(m_SampleDenominator, P[i], L[i], H[i]);
+      const double ln = Polynomial(m_LineNumerator, P[i], L[i], H[i]);
+      const double ld = Polynomial(m_LineDenominator, P[i], L[i], H[i]);
+
+      const double du = U[i] - sn / sd;
+      const double dv = V[i] - ln / ld;
+
+      if (std::abs(du) <= thresholdU && std::abs(dv) <= thresholdV)
+        {
+        active[i] = false;
+        --nbActive;
+        continue;
+        }
+
+      // Jacobian of the ratios, from the analytic derivatives
+      const double dUdP = (PolynomialDerivativeP(m_SampleNumerator, P[i], L[i], H[i]) * sd
+                           - sn * PolynomialDerivativeP(m_SampleDenominator, P[i], L[i], H[i])) / (sd * sd);
+      const double dUdL = (PolynomialDerivativeL(m_SampleNumerator, P[i], L[i], H[i]) * sd
+                           - sn * PolynomialDerivativeL(m_SampleDenominator, P[i], L[i], H[i])) / (sd * sd);
+      const double dVdP = (PolynomialDerivativeP(m_LineNumerator, P[i], L[i], H[i]) * ld
+                           - ln * PolynomialDerivativeP(m_LineDenominator, P[i], L[i], H[i])) / (ld * ld);
+      const double dVdL = (PolynomialDerivativeL(m_LineNumerator, P[i], L[i], H[i]) * ld
+                           - ln * PolynomialDerivativeL(m_LineDenominator, P[i], L[i], H[i])) / (ld * ld);
+
+      const double det = dUdP * dVdL - dUdL * dVdP;
+      if (det == 0.)
+        {
+        active[i] = false;
+        --nbActive;
+        continue;
+        }
+
+      P[i] += (du * dVdL - dv * dUdL) / det;
+      L[i] += (dv * dUdP - du * dVdP) / det;
+      }
+    }
+}
+
+void RPCModel::InverseTransformPoints(const double * lon, const double * lat, const double * h,
+                                      double * x, double * y,
+                                      unsigned long nbPoints) const
+{
+  double P[BlockSize], L[BlockSize], H[BlockSize], U[BlockSize], V[BlockSize];
+
+  for (unsigned long start = 0; start < nbPoints; start += BlockSize)
+    {
+    const unsigned int n = static_cast<unsigned int>(std::min<unsigned long>(BlockSize, nbPoints - start));
+
+    for (unsigned int i = 0; i < n; ++i)
+      {
+      const double height = (h == ITK_NULLPTR || std::isnan(h[start + i])) ? m_HeightOffset : h[start + i];
+      P[i] = (lat[start + i] - m_LatitudeOffset) / m_LatitudeScale;
+      L[i] = (lon[start + i] - m_LongitudeOffset) / m_LongitudeScale;
+      H[i] = (height - m_HeightOffset) / m_HeightScale;
+      }
+
+    this->InverseTransformBlock(P, L, H, U, V, n);
+
+    for (unsigned int i = 0; i < n; ++i)
+      {
+      x[start + i] = U[i] * m_SampleScale + m_SampleOffset;
+      y[start + i] = V[i] * m_LineScale + m_LineOffset;
+      }
+    }
+}
+
+void RPCModel::ForwardTransformPoints(const double * x, const double * y, const double * h,
+                                      double * lon, double * lat,
+                                      unsigned long nbPoints) const
+{
+  double P[BlockSize], L[BlockSize], H[BlockSize], U[BlockSize], V[BlockSize];
+
+  for (unsigned long start = 0; start < nbPoints; start += BlockSize)
+    {
+    const unsigned int n = static_cast<unsigned int>(std::min<unsigned long>(BlockSize, nbPoints - start));
+
+    for (unsigned int i = 0; i < n; ++i)
+      {
+      const double height = (h == ITK_NULLPTR || std::isnan(h[start + i])) ? m_HeightOffset : h[start + i];
+      U[i] = (x[start + i] - m_SampleOffset) / m_SampleScale;
+      V[i] = (y[start + i] - m_LineOffset) / m_LineScale;
+      H[i] = (height - m_HeightOffset) / m_HeightScale;
+      }
+
+    this->ForwardTransformBlock(U, V, H, P, L, n);
+
+    for (unsigned int i = 0; i < n; ++i)
+      {
+      lat[start + i] = P[i] * m_LatitudeScale + m_LatitudeOffset;
+      lon[start + i] = L[i] * m_LongitudeScale + m_LongitudeOffset;
+      }
+    }
+}
+
+void RPCModel::Print(std::ostream& os, itk::Indent indent) const
+{
+  os << indent << "Valid: " << m_Valid << std::endl;
+  if (!m_Valid)
+    {
+    return;
+    }
+  os << indent << "Line offset/scale: " << m_LineOffset << " / " << m_LineScale << std::endl;
+  os << indent << "Sample offset/scale: " << m_SampleOffset << " / " << m_SampleScale << std::endl;
+  os << indent << "Latitude offset/scale: " << m_LatitudeOffset << " / " << m_LatitudeScale << std::endl;
+  os << indent << "Longitude offset/scale: " << m_LongitudeOffset << " / " << m_LongitudeScale << std::endl;
+  os << indent << "Height offset/scale: " << m_HeightOffset << " / " << m_HeightScale << std::endl;
+  os << indent << "Maximum number of iterations: " << m_MaximumNumberOfIterations << std::endl;
+  os << indent << "Convergence threshold: " << m_ConvergenceThreshold << std::endl;
+}
+
+} // namespace otb
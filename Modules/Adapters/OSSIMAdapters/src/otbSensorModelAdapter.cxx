@@ -22,6 +22,9 @@
 #include "otbSensorModelAdapter.h"
 
 #include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <vector>
 
 #include "otbMacro.h"
 #include "otbImageKeywordlist.h"
@@ -35,6 +38,7 @@
 #include "ossim/projection/ossimSensorModelFactory.h"
 #include "ossim/projection/ossimSensorModel.h"
 #include "ossim/projection/ossimRpcProjection.h"
+#include "ossim/projection/ossimRpcModel.h"
 #include "ossim/ossimPluginProjectionFactory.h"
 #include "ossim/base/ossimTieGptSet.h"
 
@@ -44,6 +48,7 @@
 #include "ossim/projection/ossimSensorModelFactory.h"
 #include "ossim/projection/ossimSensorModel.h"
 #include "ossim/projection/ossimRpcProjection.h"
+#include "ossim/projection/ossimRpcModel.h"
 #include "ossim/ossimPluginProjectionFactory.h"
 #include "ossim/base/ossimTieGptSet.h"
 
@@ -54,7 +59,8 @@ namespace otb
 {
 
 SensorModelAdapter::SensorModelAdapter():
-  m_SensorModel(ITK_NULLPTR), m_TiePoints(ITK_NULLPTR) // FIXME keeping the original value but...
+  m_SensorModel(ITK_NULLPTR), m_TiePoints(ITK_NULLPTR), // FIXME keeping the original value but...
+  m_UseNativeRPCModel(false)
 {
   m_DEMHandler = DEMHandler::Instance();
   m_TiePoints = new ossimTieGptSet();
@@ -79,6 +85,115 @@ void SensorModelAdapter::CreateProjection(const ImageKeywordlist& image_kwl)
     {
     m_SensorModel = ossimplugins::ossimPluginProjectionFactory::instance()->createProjection(geom);
     }
+
+  this->InitializeNativeRPCModel(image_kwl);
+}
+
+void SensorModelAdapter::InitializeNativeRPCModel(const ImageKeywordlist& image_kwl)
+{
+  m_RPCModel.Clear();
+
+  if (!m_UseNativeRPCModel)
+    {
+    return;
+    }
+
+  // Only RPC models (including the plugin models deriving from ossimRpcModel)
+  if (dynamic_cast<ossimRpcModel *>(m_SensorModel) == ITK_NULLPTR
+      && dynamic_cast<ossimRpcProjection *>(m_SensorModel) == ITK_NULLPTR)
+    {
+    return;
+    }
+
+  if (!m_RPCModel.SetFromKeywordlist(image_kwl))
+    {
+    otbMsgDevMacro(<< "RPC sensor model not readable by the native RPC model, using OSSIM");
+    return;
+    }
+
+  // Check the native model against OSSIM across the validity domain. This
+  // also rules out models with adjustments that the native model ignores.
+  static const double tolerance = 1e-6;
+  for (int i = -1; i <= 1; ++i)
+    {
+    for (int j = -1; j <= 1; ++j)
+      {
+      for (int k = -1; k <= 1; ++k)
+        {
+        double lon = m_RPCModel.GetLongitudeOffset() + 0.5 * i * m_RPCModel.GetLongitudeScale();
+        double lat = m_RPCModel.GetLatitudeOffset() + 0.5 * j * m_RPCModel.GetLatitudeScale();
+        double h = m_RPCModel.GetHeightOffset() + 0.5 * k * m_RPCModel.GetHeightScale();
+
+        ossimGpt ossimGPoint(lat, lon, h);
+        ossimDpt ossimDPoint;
+        this->m_SensorModel->worldToLineSample(ossimGPoint, ossimDPoint);
+
+        double x, y;
+        m_RPCModel.InverseTransformPoints(&lon, &lat, &h, &x, &y, 1);
+
+        if (!(std::abs(x - ossimDPoint.x) <= tolerance && std::abs(y - ossimDPoint.y) <= tolerance))
+          {
+          otbMsgDevMacro(<< "Native RPC model differs from OSSIM, using OSSIM");
+          m_RPCModel.Clear();
+          return;
+          }
+        }
+      }
+    }
+}
+
+void SensorModelAdapter::NativeForwardTransformPointsOnDEM(const double * x, const double * y,
+                                                           double * lon, double * lat, double * h,
+                                                           unsigned long nbPoints) const
+{
+  static const unsigned int maximumNumberOfIterations = 20;
+  static const double       heightThreshold = 0.001;
+
+  // Alternate the projection at a given height and the DEM lookup at the
+  // projected position, starting from the mean height of the model
+  std::vector<unsigned long> active(nbPoints), next;
+  for (unsigned long i = 0; i < nbPoints; ++i)
+    {
+    active[i] = i;
+    h[i] = m_RPCModel.GetHeightOffset();
+    }
+
+  std::vector<double> ax, ay, ah, alon, alat;
+
+  for (unsigned int iteration = 0; iteration < maximumNumberOfIterations && !active.empty(); ++iteration)
+    {
+    const unsigned long nbActive = active.size();
+    ax.resize(nbActive);
+    ay.resize(nbActive);
+    ah.resize(nbActive);
+    alon.resize(nbActive);
+    alat.resize(nbActive);
+
+    for (unsigned long k = 0; k < nbActive; ++k)
+      {
+      ax[k] = x[active[k]];
+      ay[k] = y[active[k]];
+      ah[k] = h[active[k]];
+      }
+
+    m_RPCModel.ForwardTransformPoints(&ax[0], &ay[0], &ah[0], &alon[0], &alat[0], nbActive);
+
+    next.clear();
+    for (unsigned long k = 0; k < nbActive; ++k)
+      {
+      const unsigned long idx = active[k];
+      lon[idx] = alon[k];
+      lat[idx] = alat[k];
+
+      const double demHeight = m_DEMHandler->GetHeightAboveEllipsoid(alon[k], alat[k]);
+      if (iteration + 1 < maximumNumberOfIterations && std::abs(demHeight - h[idx]) > heightThreshold)
+        {
+        h[idx] = demHeight;
+        next.push_back(idx);
+        }
+      }
+    active.swap(next);
+    }
 }
 
 bool SensorModelAdapter::IsValidSensorModel() const
@@ -94,6 +209,12 @@ void SensorModelAdapter::ForwardTransformPoint(double x, double y, double z,
     itkExceptionMacro(<< "ForwardTransformPoint(): Invalid sensor model (m_SensorModel pointer is null)");
     }
 
+  if (this->IsNativeRPCModel())
+    {
+    this->ForwardTransformPoints(&x, &y, &z, &lon, &lat, &h, 1);
+    return;
+    }
+
   ossimDpt ossimPoint( internal::ConvertToOSSIMFrame(x),
                        internal::ConvertToOSSIMFrame(y));
   ossimGpt ossimGPoint;
@@ -113,6 +234,12 @@ void SensorModelAdapter::ForwardTransformPoint(double x, double y,
     itkExceptionMacro(<< "ForwardTransformPoint(): Invalid sensor model (m_SensorModel pointer is null)");
     }
 
+  if (this->IsNativeRPCModel())
+    {
+    this->ForwardTransformPoints(&x, &y, ITK_NULLPTR, &lon, &lat, &h, 1);
+    return;
+    }
+
   ossimDpt ossimPoint( internal::ConvertToOSSIMFrame(x),
                        internal::ConvertToOSSIMFrame(y));
   ossimGpt ossimGPoint;
@@ -132,6 +259,12 @@ void SensorModelAdapter::InverseTransformPoint(double lon, double lat, double h,
     itkExceptionMacro(<< "InverseTransformPoint(): Invalid sensor model (m_SensorModel pointer is null)");
     }
 
+  if (this->IsNativeRPCModel())
+    {
+    this->InverseTransformPoints(&lon, &lat, &h, &x, &y, &z, 1);
+    return;
+    }
+
   // Initialize with value from the function parameters
   ossimGpt ossimGPoint(lat, lon, h);
   ossimDpt ossimDPoint;
@@ -152,6 +285,12 @@ void SensorModelAdapter::InverseTransformPoint(double lon, double lat,
     itkExceptionMacro(<< "InverseTransformPoint(): Invalid sensor model (m_SensorModel pointer is null)");
     }
 
+  if (this->IsNativeRPCModel())
+    {
+    this->InverseTransformPoints(&lon, &lat, ITK_NULLPTR, &x, &y, &z, 1);
+    return;
+    }
+
   // Get elevation from DEMHandler
   double h = m_DEMHandler->GetHeightAboveEllipsoid(lon,lat);
 
@@ -166,6 +305,111 @@ void SensorModelAdapter::InverseTransformPoint(double lon, double lat,
   z = ossimGPoint.height();
 }
 
+void SensorModelAdapter::ForwardTransformPoints(const double * x, const double * y, const double * z,
+                                                double * lon, double * lat, double * h,
+                                                unsigned long nbPoints) const
+{
+  if (this->m_SensorModel == ITK_NULLPTR)
+    {
+    itkExceptionMacro(<< "ForwardTransformPoints(): Invalid sensor model (m_SensorModel pointer is null)");
+    }
+
+  if (this->IsNativeRPCModel())
+    {
+    std::vector<double> xr(nbPoints), yr(nbPoints);
+    for (unsigned long i = 0; i < nbPoints; ++i)
+      {
+      xr[i] = internal::ConvertToOSSIMFrame(x[i]);
+      yr[i] = internal::ConvertToOSSIMFrame(y[i]);
+      }
+
+    if (z != ITK_NULLPTR)
+      {
+      m_RPCModel.ForwardTransformPoints(&xr[0], &yr[0], z, lon, lat, nbPoints);
+      std::copy(z, z + nbPoints, h);
+      }
+    else
+      {
+      this->NativeForwardTransformPointsOnDEM(&xr[0], &yr[0], lon, lat, h, nbPoints);
+      }
+    return;
+    }
+
+  // The ossim points are built once for the whole batch
+  ossimDpt ossimPoint;
+  ossimGpt ossimGPoint;
+
+  for (unsigned long i = 0; i < nbPoints; ++i)
+    {
+    ossimPoint.x = internal::ConvertToOSSIMFrame(x[i]);
+    ossimPoint.y = internal::ConvertToOSSIMFrame(y[i]);
+
+    if (z != ITK_NULLPTR)
+      {
+      this->m_SensorModel->lineSampleHeightToWorld(ossimPoint, z[i], ossimGPoint);
+      }
+    else
+      {
+      this->m_SensorModel->lineSampleToWorld(ossimPoint, ossimGPoint);
+      }
+
+    lon[i] = ossimGPoint.lon;
+    lat[i] = ossimGPoint.lat;
+    h[i] = ossimGPoint.hgt;
+    }
+}
+
+void SensorModelAdapter::InverseTransformPoints(const double * lon, const double * lat, const double * h,
+                                                double * x, double * y, double * z,
+                                                unsigned long nbPoints) const
+{
+  if (this->m_SensorModel == ITK_NULLPTR)
+    {
+    itkExceptionMacro(<< "InverseTransformPoints(): Invalid sensor model (m_SensorModel pointer is null)");
+    }
+
+  if (this->IsNativeRPCModel())
+    {
+    if (h != ITK_NULLPTR)
+      {
+      std::copy(h, h + nbPoints, z);
+      }
+    else
+      {
+      for (unsigned long i = 0; i < nbPoints; ++i)
+        {
+        z[i] = m_DEMHandler->GetHeightAboveEllipsoid(lon[i], lat[i]);
+        }
+      }
+
+    m_RPCModel.InverseTransformPoints(lon, lat, z, x, y, nbPoints);
+    for (unsigned long i = 0; i < nbPoints; ++i)
+      {
+      x[i] = internal::ConvertFromOSSIMFrame(x[i]);
+      y[i] = internal::ConvertFromOSSIMFrame(y[i]);
+      }
+    return;
+    }
+
+  ossimGpt ossimGPoint;
+  ossimDpt ossimDPoint;
+
+  for (unsigned long i = 0; i < nbPoints; ++i)
+    {
+    ossimGPoint.lon = lon[i];
+    ossimGPoint.lat = lat[i];
+    ossimGPoint.hgt = (h != ITK_NULLPTR) ? h[i] : m_DEMHandler->GetHeightAboveEllipsoid(lon[i], lat[i]);
+    // Same normalisation as the ossimGpt constructor
+    ossimGPoint.limitLonTo180();
+
+    this->m_SensorModel->worldToLineSample(ossimGPoint, ossimDPoint);
+
+    x[i] = internal::ConvertFromOSSIMFrame(ossimDPoint.x);
+    y[i] = internal::ConvertFromOSSIMFrame(ossimDPoint.y);
+    z[i] = ossimGPoint.height();
+    }
+}
+
 void SensorModelAdapter::AddTiePoint(double x, double y, double z, double lon, double lat)
 {
   // Create the tie point
@@ -224,6 +468,16 @@ double SensorModelAdapter::Optimize()
       // Call optimize fit
       precision  = simpleRpcModel->optimizeFit(*m_TiePoints);
       }
+
+    // The native RPC model has to follow the optimized model
+    if (m_UseNativeRPCModel)
+      {
+      ossimKeywordlist geom;
+      m_SensorModel->saveState(geom);
+      ImageKeywordlist otb_kwl;
+      otb_kwl.SetKeywordlist(geom);
+      this->InitializeNativeRPCModel(otb_kwl);
+      }
     }
 
   // Return the precision
@@ -243,6 +497,10 @@ bool SensorModelAdapter::ReadGeomFile(const std::string & infile)
     m_SensorModel = ossimplugins::ossimPluginProjectionFactory::instance()->createProjection(geom);
     }
 
+  ImageKeywordlist otb_kwl;
+  otb_kwl.SetKeywordlist(geom);
+  this->InitializeNativeRPCModel(otb_kwl);
+
   // otbMsgDevMacro(<< "ReadGeomFile("<<geom<<") -> " << m_SensorModel);
   return (m_SensorModel != ITK_NULLPTR);
 }
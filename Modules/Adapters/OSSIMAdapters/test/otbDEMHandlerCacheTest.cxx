@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "itkMacro.h"
+#include "otbDEMHandler.h"
+
+int otbDEMHandlerCacheTest(int argc, char * argv[])
+{
+  if(argc!=4)
+    {
+    std::cerr<<"Usage: "<<argv[0]<<" demdir geoid tolerance"<<std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const double tolerance = atof(argv[3]);
+
+  otb::DEMHandler::Pointer demHandler = otb::DEMHandler::Instance();
+  demHandler->OpenDEMDirectory(argv[1]);
+  demHandler->OpenGeoidFile(argv[2]);
+
+  // Reference heights read through OSSIM
+  const unsigned int nbPoints = 20;
+  std::vector<double> ellipsoid, msl;
+  for(unsigned int j = 0; j < nbPoints; ++j)
+    {
+    for(unsigned int i = 0; i < nbPoints; ++i)
+      {
+      const double lon = 8.40 + 0.0037 * i;
+      const double lat = 44.60 + 0.0023 * j;
+      ellipsoid.push_back(demHandler->GetHeightAboveEllipsoid(lon, lat));
+      msl.push_back(demHandler->GetHeightAboveMSL(lon, lat));
+      }
+    }
+
+  demHandler->SetCacheStatistics(true);
+  demHandler->SetUseCache(true);
+
+  bool fail = false;
+  double maxError = 0.;
+  for(unsigned int j = 0; j < nbPoints; ++j)
+    {
+    for(unsigned int i = 0; i < nbPoints; ++i)
+      {
+      const double lon = 8.40 + 0.0037 * i;
+      const double lat = 44.60 + 0.0023 * j;
+      const double cachedEllipsoid = demHandler->GetHeightAboveEllipsoid(lon, lat);
+      const double cachedMSL = demHandler->GetHeightAboveMSL(lon, lat);
+      maxError = std::max(maxError, vcl_abs(cachedEllipsoid - ellipsoid[j * nbPoints + i]));
+      maxError = std::max(maxError, vcl_abs(cachedMSL - msl[j * nbPoints + i]));
+      }
+    }
+
+  std::cout<<"Maximum difference with OSSIM: "<<maxError<<" meters"<<std::endl;
+  std::cout<<"Cache hits: "<<demHandler->GetCacheHits()<<", misses: "<<demHandler->GetCacheMisses()<<std::endl;
+
+  if(maxError > tolerance)
+    {
+    std::cerr<<"Cached heights differ from OSSIM heights by more than "<<tolerance<<" meters"<<std::endl;
+    fail = true;
+    }
+
+  // One miss per kind of height: all points lie in the same tile
+  if(demHandler->GetCacheMisses() != 2 || demHandler->GetCacheHits() != 2 * nbPoints * nbPoints - 2)
+    {
+    std::cerr<<"Unexpected cache counters"<<std::endl;
+    fail = true;
+    }
+
+  demHandler->ClearCache();
+  if(demHandler->GetCacheHits() != 0 || demHandler->GetCacheMisses() != 0)
+    {
+    std::cerr<<"ClearCache() should reset the counters"<<std::endl;
+    fail = true;
+    }
+
+  // Without statistics, lookups leave the counters untouched
+  demHandler->SetCacheStatistics(false);
+  demHandler->GetHeightAboveEllipsoid(8.40, 44.60);
+  demHandler->GetHeightAboveEllipsoid(8.40, 44.60);
+  if(demHandler->GetCacheHits() != 0 || demHandler->GetCacheMisses() != 0)
+    {
+    std::cerr<<"Cache counters should stay at 0 without statistics"<<std::endl;
+    fail = true;
+    }
+
+  demHandler->SetUseCache(false);
+
+  if(fail)
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -32,5 +32,8 @@ void RegisterTests()
   REGISTER_TEST(otbPlatformPositionComputeBaselineNewTest);
   REGISTER_TEST(otbPlatformPositionComputeBaselineTest);
   REGISTER_TEST(otbDEMHandlerTest);
+  REGISTER_TEST(otbDEMHandlerCacheTest);
   REGISTER_TEST(otbRPCSolverAdapterTest);
+  REGISTER_TEST(otbRPCModelTest);
+  REGISTER_TEST(otbRPCModelOnDEMTest);
 }
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "itkMacro.h"
+#include "otbImage.h"
+#include "otbImageFileReader.h"
+#include "otbSensorModelAdapter.h"
+#include "otbDEMHandler.h"
+#include "otbMath.h"
+
+typedef otb::Image<double>              ImageType;
+typedef otb::ImageFileReader<ImageType> ReaderType;
+
+int otbRPCModelTest(int argc, char* argv[])
+{
+  if (argc != 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " input grid_size img_tol" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // This test compares the native evaluation of a RPC model with the
+  // OSSIM one, in both directions and at several heights
+  const unsigned int gridSize = atoi(argv[2]);
+  const double imgTol = atof(argv[3]);
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(argv[1]);
+  reader->UpdateOutputInformation();
+
+  const otb::ImageKeywordlist kwl = reader->GetOutput()->GetImageKeywordlist();
+
+  otb::SensorModelAdapter::Pointer nativeModel = otb::SensorModelAdapter::New();
+  nativeModel->SetUseNativeRPCModel(true);
+  nativeModel->CreateProjection(kwl);
+
+  otb::SensorModelAdapter::Pointer ossimModel = otb::SensorModelAdapter::New();
+  ossimModel->CreateProjection(kwl);
+
+  if (!nativeModel->IsNativeRPCModel())
+    {
+    std::cerr << "The sensor model of " << argv[1] << " is not handled by the native RPC model" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const ImageType::SizeType size = reader->GetOutput()->GetLargestPossibleRegion().GetSize();
+
+  // Image points of the grid at three heights
+  std::vector<double> x, y, z;
+  for (unsigned int k = 0; k < 3; ++k)
+    {
+    for (unsigned int j = 0; j <= gridSize; ++j)
+      {
+      for (unsigned int i = 0; i <= gridSize; ++i)
+        {
+        x.push_back(0.5 + static_cast<double>(i * size[0]) / gridSize);
+        y.push_back(0.5 + static_cast<double>(j * size[1]) / gridSize);
+        z.push_back(-100. + 500. * k);
+        }
+      }
+    }
+  const unsigned long nbPoints = x.size();
+
+  std::vector<double> lon(nbPoints), lat(nbPoints), h(nbPoints);
+  std::vector<double> xNative(nbPoints), yNative(nbPoints), zNative(nbPoints);
+
+  nativeModel->ForwardTransformPoints(&x[0], &y[0], &z[0], &lon[0], &lat[0], &h[0], nbPoints);
+  nativeModel->InverseTransformPoints(&lon[0], &lat[0], &h[0], &xNative[0], &yNative[0], &zNative[0], nbPoints);
+
+  double maxForwardError = 0., maxInverseError = 0.;
+  for (unsigned long n = 0; n < nbPoints; ++n)
+    {
+    // Native image to ground, checked by OSSIM ground to image
+    double xOssim, yOssim, zOssim;
+    ossimModel->InverseTransformPoint(lon[n], lat[n], h[n], xOssim, yOssim, zOssim);
+    maxForwardError = std::max(maxForwardError, std::max(vcl_abs(xOssim - x[n]), vcl_abs(yOssim - y[n])));
+
+    // Native and OSSIM ground to image
+    maxInverseError = std::max(maxInverseError, std::max(vcl_abs(xOssim - xNative[n]), vcl_abs(yOssim - yNative[n])));
+    }
+
+  std::cout << "Maximum error of the native image to ground projection: " << maxForwardError << " pixels" << std::endl;
+  std::cout << "Maximum difference of the ground to image projections: " << maxInverseError << " pixels" << std::endl;
+
+  if (maxForwardError > imgTol || maxInverseError > imgTol)
+    {
+    std::cerr << "Native RPC model differs from OSSIM by more than " << imgTol << " pixels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+int otbRPCModelOnDEMTest(int argc, char* argv[])
+{
+  if (argc != 6)
+    {
+    std::cerr << "Usage: " << argv[0] << " input grid_size geo_tol demdir geoid" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // This test compares the native image to ground projection on the DEM
+  // with the OSSIM one
+  const unsigned int gridSize = atoi(argv[2]);
+  const double geoTol = atof(argv[3]);
+
+  otb::DEMHandler::Pointer demHandler = otb::DEMHandler::Instance();
+  demHandler->SetDefaultHeightAboveEllipsoid(0);
+  demHandler->OpenDEMDirectory(argv[4]);
+  demHandler->OpenGeoidFile(argv[5]);
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(argv[1]);
+  reader->UpdateOutputInformation();
+
+  const otb::ImageKeywordlist kwl = reader->GetOutput()->GetImageKeywordlist();
+
+  otb::SensorModelAdapter::Pointer nativeModel = otb::SensorModelAdapter::New();
+  nativeModel->SetUseNativeRPCModel(true);
+  nativeModel->CreateProjection(kwl);
+
+  otb::SensorModelAdapter::Pointer ossimModel = otb::SensorModelAdapter::New();
+  ossimModel->CreateProjection(kwl);
+
+  if (!nativeModel->IsNativeRPCModel() || ossimModel->IsNativeRPCModel())
+    {
+    std::cerr << "The sensor model of " << argv[1] << " is not handled by the native RPC model" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const ImageType::SizeType size = reader->GetOutput()->GetLargestPossibleRegion().GetSize();
+
+  std::vector<double> x, y;
+  for (unsigned int j = 0; j <= gridSize; ++j)
+    {
+    for (unsigned int i = 0; i <= gridSize; ++i)
+      {
+      x.push_back(0.5 + static_cast<double>(i * size[0]) / gridSize);
+      y.push_back(0.5 + static_cast<double>(j * size[1]) / gridSize);
+      }
+    }
+  const unsigned long nbPoints = x.size();
+
+  std::vector<double> lon(nbPoints), lat(nbPoints), h(nbPoints);
+  nativeModel->ForwardTransformPoints(&x[0], &y[0], ITK_NULLPTR, &lon[0], &lat[0], &h[0], nbPoints);
+
+  // Distances in meters, with a local spherical approximation
+  const double earthRadius = 6378137.;
+  const double degToMeters = earthRadius * otb::CONST_PI_180;
+
+  double maxGeoError = 0.;
+  for (unsigned long n = 0; n < nbPoints; ++n)
+    {
+    double lonOssim, latOssim, hOssim;
+    ossimModel->ForwardTransformPoint(x[n], y[n], lonOssim, latOssim, hOssim);
+
+    const double dx = (lon[n] - lonOssim) * degToMeters * vcl_cos(latOssim * otb::CONST_PI_180);
+    const double dy = (lat[n] - latOssim) * degToMeters;
+    const double dz = h[n] - hOssim;
+    maxGeoError = std::max(maxGeoError, vcl_sqrt(dx * dx + dy * dy + dz * dz));
+    }
+
+  std::cout << "Maximum distance of the image to ground projections on the DEM: " << maxGeoError << " meters" << std::endl;
+
+  if (maxGeoError > geoTol)
+    {
+    std::cerr << "Native RPC model differs from OSSIM on the DEM by more than " << geoTol << " meters" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
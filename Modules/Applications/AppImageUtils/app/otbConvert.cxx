@@ -27,6 +27,9 @@
 #include "itkListSample.h"
 #include "otbListSampleToHistogramListGenerator.h"
 #include "itkImageRegionConstIterator.h"
+#include "otbStreamingStatisticsVectorImageFilter.h"
+#include "otbBinaryFunctorImageFilter.h"
+#include <limits>
 
 #include "otbImageListToVectorImageFilter.h"
 #include "otbMultiToMonoChannelExtractROI.h"
@@ -50,6 +53,49 @@ public:
     return vcl_log(v);
   }
 };
+
+/** Replace the pixels excluded by the mask (mask value >= 0.5) by NaN,
+ * so that they are ignored by the statistics */
+template< class TPixel, class TMaskPixel >
+class ITK_EXPORT MaskedToNaNFunctor
+{
+public:
+  MaskedToNaNFunctor() : m_OutputSize(0) {};
+  ~MaskedToNaNFunctor(){};
+
+  void SetOutputSize(unsigned int size)
+  {
+    m_OutputSize = size;
+  }
+  unsigned int GetOutputSize() const
+  {
+    return m_OutputSize;
+  }
+
+  bool operator!=(const MaskedToNaNFunctor & other) const
+  {
+    return m_OutputSize != other.m_OutputSize;
+  }
+  bool operator==(const MaskedToNaNFunctor & other) const
+  {
+    return !(*this != other);
+  }
+
+  TPixel operator() (const TPixel& v, const TMaskPixel& mask) const
+  {
+    // float values, so the threshold is set to 0.5
+    if (mask[0] < 0.5)
+      {
+      return v;
+      }
+    TPixel out(v.GetSize());
+    out.Fill(std::numeric_limits<typename TPixel::ValueType>::quiet_NaN());
+    return out;
+  }
+
+private:
+  unsigned int m_OutputSize;
+};
 } // end namespace Functor
 
 
@@ -75,6 +121,13 @@ public:
                                              DFContainerType> HistogramsGeneratorType;
   typedef StreamingShrinkImageFilter<FloatVectorImageType,
                                      FloatVectorImageType> ShrinkFilterType;
+  typedef StreamingStatisticsVectorImageFilter<FloatVectorImageType> StatisticsFilterType;
+  typedef Functor::MaskedToNaNFunctor<FloatVectorImageType::PixelType,
+                                      FloatVectorImageType::PixelType> MaskedToNaNFunctorType;
+  typedef BinaryFunctorImageFilter<FloatVectorImageType,
+                                   FloatVectorImageType,
+                                   FloatVectorImageType,
+                                   MaskedToNaNFunctorType>  MaskFilterType;
   typedef Functor::LogFunctor<FloatVectorImageType::InternalPixelType> TransferLogFunctor;
   typedef UnaryImageFunctorWithVectorImageFilter<FloatVectorImageType,
                                                  FloatVectorImageType,
@@ -148,6 +201,14 @@ private:
     SetDefaultParameterFloat("hcp.low", 2.0);
     DisableParameter("hcp.low");
 
+    AddParameter(ParameterType_Empty, "hcp.sketch", "Use quantile sketches");
+    SetParameterDescription("hcp.sketch", "If active, the cut quantiles are estimated "
+      "in one streamed pass over the full resolution image with quantile sketches, "
+      "instead of the histogram of a quicklook of 1000 pixels square at most. "
+      "Pixels null in every band are ignored.");
+    MandatoryOff("hcp.sketch");
+    DisableParameter("hcp.sketch");
+
     AddParameter(ParameterType_OutputImage, "out",  "Output Image");
     SetParameterDescription("out", "Output image");
     SetDefaultOutputPixelType("out",ImagePixelType_uint8);
@@ -268,25 +329,7 @@ private:
       rescaler->SetOutputMinimum(minimum);
       rescaler->SetOutputMaximum(maximum);
 
-      // We need to subsample the input image in order to estimate its
-      // histogram
-
-      typename ShrinkFilterType::Pointer shrinkFilter = ShrinkFilterType::New();
-
-      // Shrink factor is computed so as to load a quicklook of 1000
-      // pixels square at most
-      typename FloatVectorImageType::SizeType imageSize = tempImage->GetLargestPossibleRegion().GetSize();
-      unsigned int shrinkFactor =
-        std::max(imageSize[0], imageSize[1]) < 1000 ? 1 : std::max(imageSize[0], imageSize[1])/1000;
-
-      otbAppLogDEBUG( << "Shrink factor used to compute Min/Max: "<<shrinkFactor );
-
-      otbAppLogDEBUG( << "Shrink starts..." );
-
-      shrinkFilter->SetShrinkFactor(shrinkFactor);
-      shrinkFilter->GetStreamer()->SetAutomaticAdaptativeStreaming(GetParameterInt("ram"));
-      AddProcess(shrinkFilter->GetStreamer(), "Computing shrink Image for min/max estimation...");
-
+      FloatVectorImageType::Pointer statisticsInput;
       if ( rescaleType == "log2")
         {
         //define the transfer log
@@ -294,86 +337,41 @@ private:
         m_TransferLog->SetInput(tempImage);
         m_TransferLog->UpdateOutputInformation();
 
-        shrinkFilter->SetInput(m_TransferLog->GetOutput());
-        rescaler->SetInput(m_TransferLog->GetOutput());
-        shrinkFilter->Update();
+        statisticsInput = m_TransferLog->GetOutput();
         }
       else
         {
-        shrinkFilter->SetInput(tempImage);
-        rescaler->SetInput(tempImage);
-        shrinkFilter->Update();
+        statisticsInput = tempImage;
         }
+      rescaler->SetInput(statisticsInput);
 
-      ShrinkFilterType::Pointer maskShrinkFilter = ShrinkFilterType::New();
+      // Extract the lower and upper quantiles
+      typename FloatVectorImageType::PixelType inputMin(nbComp), inputMax(nbComp);
 
       otbAppLogDEBUG( << "Evaluating input Min/Max..." );
-      itk::ImageRegionConstIterator<FloatVectorImageType>
-        it(shrinkFilter->GetOutput(), shrinkFilter->GetOutput()->GetLargestPossibleRegion());
-      itk::ImageRegionConstIterator<FloatVectorImageType> itMask;
-
-      typename ListSampleType::Pointer listSample = ListSampleType::New();
-      listSample->SetMeasurementVectorSize(tempImage->GetNumberOfComponentsPerPixel());
-
-      // Now we generate the list of samples
-      if (IsParameterEnabled("mask"))
+      if (IsParameterEnabled("hcp.sketch"))
         {
-        maskShrinkFilter->SetShrinkFactor(shrinkFactor);
-        maskShrinkFilter->SetInput(mask);
-        maskShrinkFilter->GetStreamer()->SetAutomaticAdaptativeStreaming(GetParameterInt("ram"));
-        maskShrinkFilter->Update();
-
-        itMask = itk::ImageRegionConstIterator<FloatVectorImageType>(
-          maskShrinkFilter->GetOutput(),maskShrinkFilter->GetOutput()->GetLargestPossibleRegion());
-
-        // Remove masked pixels
-        it.GoToBegin();
-        itMask.GoToBegin();
-        while (!it.IsAtEnd())
+        bool quantilesComputed = false;
+        if (IsParameterEnabled("mask"))
           {
-          // float values, so the threshold is set to 0.5
-          if (itMask.Get()[0] < 0.5)
+          quantilesComputed = EstimateCutValuesFromSketches(statisticsInput, mask, inputMin, inputMax);
+          if (!quantilesComputed)
             {
-            listSample->PushBack(it.Get());
+            otbAppLogINFO( << "All pixels were masked, the application assume a wrong mask "
+              "and include all the image");
             }
-          ++it;
-          ++itMask;
-          }
-        if (listSample->Size() == 0)
-          {
-          otbAppLogINFO( << "All pixels were masked, the application assume a wrong mask "
-            "and include all the image");
           }
-        }
-
-      // if mask is disable and all pixels were masked
-      if ((!IsParameterEnabled("mask")) || (listSample->Size() == 0))
-        {
-        for(it.GoToBegin(); !it.IsAtEnd(); ++it)
+        if (!quantilesComputed)
           {
-          listSample->PushBack(it.Get());
+          if (!EstimateCutValuesFromSketches(statisticsInput, ITK_NULLPTR, inputMin, inputMax))
+            {
+            otbAppLogFATAL( << "No valid pixel to estimate the image dynamic.");
+            }
           }
         }
-
-      // And then the histogram
-      typename HistogramsGeneratorType::Pointer histogramsGenerator = HistogramsGeneratorType::New();
-      histogramsGenerator->SetListSample(listSample);
-      histogramsGenerator->SetNumberOfBins(255);
-      histogramsGenerator->NoDataFlagOn();
-      histogramsGenerator->Update();
-
-      // And extract the lower and upper quantile
-      typename FloatVectorImageType::PixelType inputMin(nbComp), inputMax(nbComp);
-
-      auto histOutput = histogramsGenerator->GetOutput();
-      assert(histOutput);
-
-      for(unsigned int i = 0; i < nbComp; ++i)
+      else
         {
-        auto && elm = histOutput->GetNthElement(i);
-        assert(elm);
-        inputMin[i] = elm->Quantile(0, 0.01 * GetParameterFloat("hcp.low"));
-        inputMax[i] = elm->Quantile(0, 1.0 - 0.01 * GetParameterFloat("hcp.high"));
+        EstimateCutValuesFromHistogram(statisticsInput, mask, inputMin, inputMax);
         }
 
       otbAppLogDEBUG( << std::setprecision(5) << "Min/Max computation done : min=" << inputMin
@@ -394,6 +392,152 @@ private:
       }
   }
 
+  /** Estimate the low and high cut values of each band from a 255 bins
+   * histogram of a quicklook of the image. Pixels excluded by the mask are
+   * ignored, unless every pixel is masked. Null values are ignored band
+   * per band. */
+  void EstimateCutValuesFromHistogram(FloatVectorImageType * image,
+                                      FloatVectorImageType * mask,
+                                      FloatVectorImageType::PixelType & inputMin,
+                                      FloatVectorImageType::PixelType & inputMax)
+  {
+    const unsigned int nbComp(image->GetNumberOfComponentsPerPixel());
+
+    // We need to subsample the input image in order to estimate its
+    // histogram
+
+    ShrinkFilterType::Pointer shrinkFilter = ShrinkFilterType::New();
+
+    // Shrink factor is computed so as to load a quicklook of 1000
+    // pixels square at most
+    FloatVectorImageType::SizeType imageSize = image->GetLargestPossibleRegion().GetSize();
+    unsigned int shrinkFactor =
+      std::max(imageSize[0], imageSize[1]) < 1000 ? 1 : std::max(imageSize[0], imageSize[1])/1000;
+
+    otbAppLogDEBUG( << "Shrink factor used to compute Min/Max: "<<shrinkFactor );
+
+    otbAppLogDEBUG( << "Shrink starts..." );
+
+    shrinkFilter->SetShrinkFactor(shrinkFactor);
+    shrinkFilter->GetStreamer()->SetAutomaticAdaptativeStreaming(GetParameterInt("ram"));
+    AddProcess(shrinkFilter->GetStreamer(), "Computing shrink Image for min/max estimation...");
+    shrinkFilter->SetInput(image);
+    shrinkFilter->Update();
+
+    ShrinkFilterType::Pointer maskShrinkFilter = ShrinkFilterType::New();
+
+    itk::ImageRegionConstIterator<FloatVectorImageType>
+      it(shrinkFilter->GetOutput(), shrinkFilter->GetOutput()->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<FloatVectorImageType> itMask;
+
+    ListSampleType::Pointer listSample = ListSampleType::New();
+    listSample->SetMeasurementVectorSize(nbComp);
+
+    // Now we generate the list of samples
+    if (mask)
+      {
+      maskShrinkFilter->SetShrinkFactor(shrinkFactor);
+      maskShrinkFilter->SetInput(mask);
+      maskShrinkFilter->GetStreamer()->SetAutomaticAdaptativeStreaming(GetParameterInt("ram"));
+      maskShrinkFilter->Update();
+
+      itMask = itk::ImageRegionConstIterator<FloatVectorImageType>(
+        maskShrinkFilter->GetOutput(),maskShrinkFilter->GetOutput()->GetLargestPossibleRegion());
+
+      // Remove masked pixels
+      it.GoToBegin();
+      itMask.GoToBegin();
+      while (!it.IsAtEnd())
+        {
+        // float values, so the threshold is set to 0.5
+        if (itMask.Get()[0] < 0.5)
+          {
+          listSample->PushBack(it.Get());
+          }
+        ++it;
+        ++itMask;
+        }
+      if (listSample->Size() == 0)
+        {
+        otbAppLogINFO( << "All pixels were masked, the application assume a wrong mask "
+          "and include all the image");
+        }
+      }
+
+    // if mask is disable and all pixels were masked
+    if ((!mask) || (listSample->Size() == 0))
+      {
+      for(it.GoToBegin(); !it.IsAtEnd(); ++it)
+        {
+        listSample->PushBack(it.Get());
+        }
+      }
+
+    // And then the histogram
+    HistogramsGeneratorType::Pointer histogramsGenerator = HistogramsGeneratorType::New();
+    histogramsGenerator->SetListSample(listSample);
+    histogramsGenerator->SetNumberOfBins(255);
+    histogramsGenerator->NoDataFlagOn();
+    histogramsGenerator->Update();
+
+    // And extract the lower and upper quantile
+    auto histOutput = histogramsGenerator->GetOutput();
+    assert(histOutput);
+
+    for(unsigned int i = 0; i < nbComp; ++i)
+      {
+      auto && elm = histOutput->GetNthElement(i);
+      assert(elm);
+      inputMin[i] = elm->Quantile(0, 0.01 * GetParameterFloat("hcp.low"));
+      inputMax[i] = elm->Quantile(0, 1.0 - 0.01 * GetParameterFloat("hcp.high"));
+      }
+  }
+
+  /** Estimate the low and high cut values of each band from quantile
+   * sketches accumulated in one streamed pass over the full resolution
+   * image. Pixels excluded by the mask, non-finite pixels and pixels null
+   * in every band are ignored. Returns false if no pixel is left. */
+  bool EstimateCutValuesFromSketches(FloatVectorImageType * image,
+                         FloatVectorImageType * mask,
+                         FloatVectorImageType::PixelType & inputMin,
+                         FloatVectorImageType::PixelType & inputMax)
+  {
+    StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
+    statisticsFilter->SetEnableSecondOrderStats(false);
+    statisticsFilter->SetEnableFirstOrderStats(false);
+    statisticsFilter->SetEnableMinMax(false);
+    statisticsFilter->SetEnableQuantiles(true);
+    statisticsFilter->SetIgnoreInfiniteValues(true);
+    statisticsFilter->SetIgnoreUserDefinedValue(true);
+    statisticsFilter->SetUserIgnoredValue(0.);
+    statisticsFilter->GetStreamer()->SetAutomaticAdaptativeStreaming(GetParameterInt("ram"));
+    AddProcess(statisticsFilter->GetStreamer(), "Computing quantiles for min/max estimation...");
+
+    if (mask)
+      {
+      MaskFilterType::Pointer maskFilter = MaskFilterType::New();
+      maskFilter->SetInput1(image);
+      maskFilter->SetInput2(mask);
+      maskFilter->GetFunctor().SetOutputSize(image->GetNumberOfComponentsPerPixel());
+      statisticsFilter->SetInput(maskFilter->GetOutput());
+      m_Filters.push_back(maskFilter.GetPointer());
+      }
+    else
+      {
+      statisticsFilter->SetInput(image);
+      }
+
+    statisticsFilter->Update();
+    if (statisticsFilter->GetNbRelevantPixels()[0] == 0)
+      {
+      return false;
+      }
+
+    inputMin = statisticsFilter->GetQuantile(0.01 * GetParameterFloat("hcp.low"));
+    inputMax = statisticsFilter->GetQuantile(1.0 - 0.01 * GetParameterFloat("hcp.high"));
+    return true;
+  }
+
   // Get the bands order
   std::vector<int> GetChannels()
   {
@@ -27,6 +27,9 @@
 #include "itkListSample.h"
 #include "otbListSampleToHistogramListGenerator.h"
 #include "itkImageRegionConstIterator.h"
+#include "otbStreamingStatisticsVectorImageFilter.h"
+#include "otbBinaryFunctorImageFilter.h"
+#include <limits>
 
 #include "otbImageListToVectorImageFilter.h"
 #include "otbMultiToMonoChannelExtractROI.h"
@@ -48,6 +51,48 @@ public:
     return std::log(v);
   }
 };
+
+  /** Replace the pixels excluded by the mask (mask value <= 0.5) by NaN,
+   * so that they are ignored by the statistics */
+  template< class TPixel, class TMaskPixel >
+  class ITK_EXPORT MaskedToNaNFunctor
+  {
+  public:
+    MaskedToNaNFunctor() : m_OutputSize(0) {};
+
+    void SetOutputSize(unsigned int size)
+    {
+      m_OutputSize = size;
+    }
+    unsigned int GetOutputSize() const
+    {
+      return m_OutputSize;
+    }
+
+    bool operator!=(const MaskedToNaNFunctor & other) const
+    {
+      return m_OutputSize != other.m_OutputSize;
+    }
+    bool operator==(const MaskedToNaNFunctor & other) const
+    {
+      return !(*this != other);
+    }
+
+    TPixel operator() (const TPixel& v, const TMaskPixel& mask) const
+    {
+      // float values, so the threshold is set to 0.5
+      if (mask[0] > 0.5)
+      {
+        return v;
+      }
+      TPixel out(v.GetSize());
+      out.Fill(std::numeric_limits<typename TPixel::ValueType>::quiet_NaN());
+      return out;
+    }
+
+  private:
+    unsigned int m_OutputSize;
+  };
 } // end namespace Functor
 
 
@@ -76,6 +121,14 @@ public:
   typedef StreamingShrinkImageFilter<FloatVectorImageType,
     FloatVectorImageType> ShrinkFilterType;
 
+  typedef StreamingStatisticsVectorImageFilter<FloatVectorImageType> StatisticsFilterType;
+  typedef Functor::MaskedToNaNFunctor<FloatVectorImageType::PixelType,
+    FloatVectorImageType::PixelType> MaskedToNaNFunctorType;
+  typedef BinaryFunctorImageFilter<FloatVectorImageType,
+    FloatVectorImageType,
+    FloatVectorImageType,
+    MaskedToNaNFunctorType> MaskFilterType;
+
   typedef Functor::LogFunctor<FloatVectorImageType::InternalPixelType> TransferLogFunctor;
   typedef UnaryImageFunctorWithVectorImageFilter<FloatVectorImageType,
     FloatVectorImageType,
@@ -158,6 +211,15 @@ private:
     SetDefaultParameterFloat("quantile.low", 2.0);
     DisableParameter("quantile.low");
 
+    AddParameter(ParameterType_Empty, "quantile.sketch", "Use quantile sketches");
+    SetParameterDescription("quantile.sketch",
+      "If active, the cut quantiles are estimated in one streamed pass over "
+      "the full resolution image with quantile sketches, instead of the "
+      "histogram of a quicklook of 1000 pixels square at most. Pixels null "
+      "in every band are ignored.");
+    MandatoryOff("quantile.sketch");
+    DisableParameter("quantile.sketch");
+
     AddParameter(ParameterType_Choice, "channels", "Channels selection");
     SetParameterDescription("channels", "It's possible to select the channels "
       "of the output image. There are 3 modes, the available choices are:");
@@ -252,48 +314,126 @@ private:
 
     const unsigned int nbComp(tempImage->GetNumberOfComponentsPerPixel());
 
+    FloatVectorImageType::Pointer statisticsInput;
+    if ( rescaleType == "log2")
+    {
+      //define the transfer log
+      m_TransferLog = TransferLogType::New();
+      m_TransferLog->SetInput(tempImage);
+      m_TransferLog->UpdateOutputInformation();
+      statisticsInput = m_TransferLog->GetOutput();
+    }
+    else
+    {
+      statisticsInput = tempImage;
+    }
+    rescaler->SetInput(statisticsInput);
+
+    // Extract the lower and upper quantiles
+    typename FloatVectorImageType::PixelType inputMin(nbComp), inputMax(nbComp);
+
+    otbAppLogDEBUG( << "Evaluating input Min/Max..." );
+    if (IsParameterEnabled("quantile.sketch"))
+    {
+      bool quantilesComputed = false;
+      if (IsParameterEnabled("mask"))
+      {
+        quantilesComputed = EstimateCutValuesFromSketches(statisticsInput,
+          this->GetParameterImage("mask"), inputMin, inputMax);
+        if (!quantilesComputed)
+        {
+          otbAppLogINFO( << "All pixels were masked, the application assume "
+            "a wrong mask and include all the image");
+        }
+      }
+      // use all pixels : if mask is disable or all pixels were masked
+      if (!quantilesComputed)
+      {
+        if (!EstimateCutValuesFromSketches(statisticsInput, ITK_NULLPTR,
+          inputMin, inputMax))
+        {
+          otbAppLogFATAL( << "No valid pixel to estimate the image dynamic.");
+        }
+      }
+    }
+    else
+    {
+      EstimateCutValuesFromHistogram(statisticsInput, inputMin, inputMax);
+    }
+
+    otbAppLogDEBUG( << std::setprecision(5) 
+                    << "Min/Max computation done : min=" 
+                    << inputMin
+                    << " max=" << inputMax );
+
+    rescaler->AutomaticInputMinMaxComputationOff();
+    rescaler->SetInputMinimum(inputMin);
+    rescaler->SetInputMaximum(inputMax);
+
+    if ( rescaleType == "linear")
+    {
+      rescaler->SetGamma(GetParameterFloat("type.linear.gamma"));
+    }
+
+    typename TImageType::PixelType minimum(nbComp);
+    typename TImageType::PixelType maximum(nbComp);
+
+    /*
+    float outminvalue = std::numeric_limits<typename TImageType::InternalPixelType>::min();
+    float outmaxvalue = std::numeric_limits<typename TImageType::InternalPixelType>::max();
+    // TODO test outmin/outmax values
+    if (outminvalue > GetParameterFloat("outmin"))
+      itkExceptionMacro("The outmin value at " << GetParameterFloat("outmin") << 
+                        " is too low, select a value in "<< outminvalue <<" min.");
+    if ( outmaxvalue < GetParameterFloat("outmax") )
+      itkExceptionMacro("The outmax value at " << GetParameterFloat("outmax") << 
+                        " is too high, select a value in "<< outmaxvalue <<" max.");
+    */
+
+    maximum.Fill( GetParameterFloat("outmax") );
+    minimum.Fill( GetParameterFloat("outmin") );
+
+    rescaler->SetOutputMinimum(minimum);
+    rescaler->SetOutputMaximum(maximum);
+
+    m_Filters.push_back(rescaler.GetPointer());
+    SetParameterOutputImage<TImageType>("out", rescaler->GetOutput());
+  }
+
+  /** Estimate the low and high cut values of each band from a 255 bins
+   * histogram of a quicklook of the image. Pixels excluded by the mask are
+   * ignored, unless every pixel is masked. Null values are ignored band
+   * per band. */
+  void EstimateCutValuesFromHistogram(FloatVectorImageType * image,
+    FloatVectorImageType::PixelType & inputMin,
+    FloatVectorImageType::PixelType & inputMax)
+  {
+    const unsigned int nbComp(image->GetNumberOfComponentsPerPixel());
+
     // We need to subsample the input image in order to estimate its histogram
     // Shrink factor is computed so as to load a quicklook of 1000
     // pixels square at most
-    auto imageSize = tempImage->GetLargestPossibleRegion().GetSize();
+    auto imageSize = image->GetLargestPossibleRegion().GetSize();
     unsigned int shrinkFactor = std::max({int(imageSize[0])/1000, 
       int(imageSize[1])/1000, 1});
     otbAppLogDEBUG( << "Shrink factor used to compute Min/Max: "<<shrinkFactor );
 
     otbAppLogDEBUG( << "Shrink starts..." );
-    typename ShrinkFilterType::Pointer shrinkFilter = ShrinkFilterType::New();
+    ShrinkFilterType::Pointer shrinkFilter = ShrinkFilterType::New();
     shrinkFilter->SetShrinkFactor(shrinkFactor);
     shrinkFilter->GetStreamer()->
       SetAutomaticAdaptativeStreaming(GetParameterInt("ram"));
     AddProcess(shrinkFilter->GetStreamer(), 
       "Computing shrink Image for min/max estimation...");
+    shrinkFilter->SetInput(image);
+    shrinkFilter->Update();
 
-    if ( rescaleType == "log2")
-    {
-      //define the transfer log
-      m_TransferLog = TransferLogType::New();
-      m_TransferLog->SetInput(tempImage);
-      m_TransferLog->UpdateOutputInformation();
-
-      shrinkFilter->SetInput(m_TransferLog->GetOutput());
-      rescaler->SetInput(m_TransferLog->GetOutput());
-      shrinkFilter->Update();
-    }
-    else
-    {
-      shrinkFilter->SetInput(tempImage);
-      rescaler->SetInput(tempImage);
-      shrinkFilter->Update();
-    }
-
-    otbAppLogDEBUG( << "Evaluating input Min/Max..." );
     itk::ImageRegionConstIterator<FloatVectorImageType>
       it(shrinkFilter->GetOutput(), 
         shrinkFilter->GetOutput()->GetLargestPossibleRegion());
 
-    typename ListSampleType::Pointer listSample = ListSampleType::New();
-    listSample->SetMeasurementVectorSize( 
-      tempImage->GetNumberOfComponentsPerPixel());
+    ListSampleType::Pointer listSample = ListSampleType::New();
+    listSample->SetMeasurementVectorSize(nbComp);
 
     // Now we generate the list of samples
     if (IsParameterEnabled("mask"))
@@ -339,7 +479,7 @@ private:
     }
 
     // And then the histogram
-    typename HistogramsGeneratorType::Pointer histogramsGenerator = 
+    HistogramsGeneratorType::Pointer histogramsGenerator = 
       HistogramsGeneratorType::New();
     histogramsGenerator->SetListSample(listSample);
     histogramsGenerator->SetNumberOfBins(255);
@@ -350,7 +490,6 @@ private:
     assert(histOutput);
 
     // And extract the lower and upper quantile
-    typename FloatVectorImageType::PixelType inputMin(nbComp), inputMax(nbComp);
     for(unsigned int i = 0; i < nbComp; ++i)
     {
       auto && elm = histOutput->GetNthElement(i);
@@ -360,44 +499,56 @@ private:
       inputMax[i] = elm->Quantile(0, 
         1.0 - 0.01 * GetParameterFloat("quantile.high"));
     }
+  }
 
-    otbAppLogDEBUG( << std::setprecision(5) 
-                    << "Min/Max computation done : min=" 
-                    << inputMin
-                    << " max=" << inputMax );
-
-    rescaler->AutomaticInputMinMaxComputationOff();
-    rescaler->SetInputMinimum(inputMin);
-    rescaler->SetInputMaximum(inputMax);
+  /** Estimate the low and high cut values of each band from quantile
+   * sketches accumulated in one streamed pass over the full resolution
+   * image. Pixels excluded by the mask, non-finite pixels and pixels null
+   * in every band are ignored. Returns false if no pixel is left. */
+  bool EstimateCutValuesFromSketches(FloatVectorImageType * image,
+    FloatVectorImageType * mask,
+    FloatVectorImageType::PixelType & inputMin,
+    FloatVectorImageType::PixelType & inputMax)
+  {
+    StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
+    statisticsFilter->SetEnableSecondOrderStats(false);
+    statisticsFilter->SetEnableFirstOrderStats(false);
+    statisticsFilter->SetEnableMinMax(false);
+    statisticsFilter->SetEnableQuantiles(true);
+    statisticsFilter->SetIgnoreInfiniteValues(true);
+    statisticsFilter->SetIgnoreUserDefinedValue(true);
+    statisticsFilter->SetUserIgnoredValue(0.);
+    statisticsFilter->GetStreamer()->
+      SetAutomaticAdaptativeStreaming(GetParameterInt("ram"));
+    AddProcess(statisticsFilter->GetStreamer(),
+      "Computing quantiles for min/max estimation...");
 
-    if ( rescaleType == "linear")
+    if (mask)
     {
-      rescaler->SetGamma(GetParameterFloat("type.linear.gamma"));
+      MaskFilterType::Pointer maskFilter = MaskFilterType::New();
+      maskFilter->SetInput1(image);
+      maskFilter->SetInput2(mask);
+      maskFilter->GetFunctor().SetOutputSize(
+        image->GetNumberOfComponentsPerPixel());
+      statisticsFilter->SetInput(maskFilter->GetOutput());
+      m_Filters.push_back(maskFilter.GetPointer());
+    }
+    else
+    {
+      statisticsFilter->SetInput(image);
     }
 
-    typename TImageType::PixelType minimum(nbComp);
-    typename TImageType::PixelType maximum(nbComp);
-
-    /*
-    float outminvalue = std::numeric_limits<typename TImageType::InternalPixelType>::min();
-    float outmaxvalue = std::numeric_limits<typename TImageType::InternalPixelType>::max();
-    // TODO test outmin/outmax values
-    if (outminvalue > GetParameterFloat("outmin"))
-      itkExceptionMacro("The outmin value at " << GetParameterFloat("outmin") << 
-                        " is too low, select a value in "<< outminvalue <<" min.");
-    if ( outmaxvalue < GetParameterFloat("outmax") )
-      itkExceptionMacro("The outmax value at " << GetParameterFloat("outmax") << 
-                        " is too high, select a value in "<< outmaxvalue <<" max.");
-    */
-
-    maximum.Fill( GetParameterFloat("outmax") );
-    minimum.Fill( GetParameterFloat("outmin") );
-
-    rescaler->SetOutputMinimum(minimum);
-    rescaler->SetOutputMaximum(maximum);
+    statisticsFilter->Update();
+    if (statisticsFilter->GetNbRelevantPixels()[0] == 0)
+    {
+      return false;
+    }
 
-    m_Filters.push_back(rescaler.GetPointer());
-    SetParameterOutputImage<TImageType>("out", rescaler->GetOutput());
+    inputMin = statisticsFilter->GetQuantile(
+      0.01 * GetParameterFloat("quantile.low"));
+    inputMax = statisticsFilter->GetQuantile(
+      1.0 - 0.01 * GetParameterFloat("quantile.high"));
+    return true;
   }
 
   // Get the bands order
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbWrapperApplication.h"
+#include "otbWrapperApplicationFactory.h"
+
+#include "otbStreamingStatisticsMapFromLabelImageFilter.h"
+
+#include <fstream>
+#include <iomanip>
+
+namespace otb
+{
+namespace Wrapper
+{
+
+class LabelImageStatistics : public Application
+{
+public:
+  /** Standard class typedefs. */
+  typedef LabelImageStatistics          Self;
+  typedef Application                   Superclass;
+  typedef itk::SmartPointer<Self>       Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+
+  typedef UInt32ImageType                                 LabelImageType;
+  typedef LabelImageType::PixelType                       LabelType;
+
+  typedef otb::StreamingStatisticsMapFromLabelImageFilter
+    <FloatVectorImageType, LabelImageType>                StatisticsFilterType;
+  typedef StatisticsFilterType::PixelValueMapType         PixelValueMapType;
+  typedef StatisticsFilterType::LabelPopulationMapType    LabelPopulationMapType;
+
+  /** Standard macro */
+  itkNewMacro(Self);
+
+  itkTypeMacro(LabelImageStatistics, otb::Application);
+
+private:
+  void DoInit() ITK_OVERRIDE
+  {
+    SetName("LabelImageStatistics");
+    SetDescription("Computes statistics of an image for each label of a label image.");
+
+    // Documentation
+    SetDocName("Label Image Statistics");
+    SetDocLongDescription("This application computes, for each label of a label image "
+      "and each band of the input image, the pixel count, minimum, maximum, mean "
+      "and standard deviation of the input image values, and optionally a set of "
+      "approximate quantiles. The image is read only once, by streaming. "
+      "Quantiles are estimated with one-pass mergeable sketches whose accuracy "
+      "is controlled by the compression parameter. "
+      "Results are written in a CSV file with one line per label.");
+    SetDocLimitations("The label image and the input image must have the same size. "
+      "Memory usage grows with the number of labels, and with the compression "
+      "when quantiles are computed.");
+    SetDocAuthors("OTB-Team");
+    SetDocSeeAlso("ComputeImagesStatistics, ColorMapping");
+
+    AddDocTag(Tags::Analysis);
+    AddDocTag(Tags::Segmentation);
+
+    AddParameter(ParameterType_InputImage, "in", "Input Image");
+    SetParameterDescription("in", "Image whose values are summarized for each label.");
+
+    AddParameter(ParameterType_InputImage, "inlabel", "Label Image");
+    SetParameterDescription("inlabel", "Label image, of the same size as the input image.");
+
+    AddParameter(ParameterType_OutputFilename, "out", "Output CSV file");
+    SetParameterDescription("out", "CSV file where the statistics of each label are written.");
+
+    AddParameter(ParameterType_Int, "bv", "Background label");
+    SetParameterDescription("bv", "Label to ignore in the output file.");
+    MandatoryOff("bv");
+
+    AddParameter(ParameterType_StringList, "quantiles", "Quantiles");
+    SetParameterDescription("quantiles", "Quantiles to estimate, in percent (for instance 2 50 98).");
+    MandatoryOff("quantiles");
+
+    AddParameter(ParameterType_Float, "compression", "Quantile sketch compression");
+    SetParameterDescription("compression", "Compression of the quantile sketches. Larger values "
+      "give more accurate quantiles at the cost of more memory per label and band.");
+    SetDefaultParameterFloat("compression", 200.);
+    SetMinimumParameterFloatValue("compression", 10.);
+    MandatoryOff("compression");
+
+    AddRAMParameter();
+
+    // Doc example parameter settings
+    SetDocExampleParameterValue("in", "QB_1_ortho.tif");
+    SetDocExampleParameterValue("inlabel", "QB_1_ortho_labels.tif");
+    SetDocExampleParameterValue("quantiles", "2 50 98");
+    SetDocExampleParameterValue("out", "LabelStatistics.csv");
+
+    SetOfficialDocLink();
+  }
+
+  void DoUpdateParameters() ITK_OVERRIDE
+  {
+    // Nothing to do here : all parameters are independent
+  }
+
+  void DoExecute() ITK_OVERRIDE
+  {
+    FloatVectorImageType::Pointer image = GetParameterImage("in");
+    LabelImageType::Pointer labels = GetParameterUInt32Image("inlabel");
+
+    image->UpdateOutputInformation();
+    labels->UpdateOutputInformation();
+    if (image->GetLargestPossibleRegion().GetSize() != labels->GetLargestPossibleRegion().GetSize())
+      {
+      otbAppLogFATAL(<< "The input image and the label image do not have the same size.");
+      }
+
+    std::vector<double> quantiles;
+    if (IsParameterEnabled("quantiles") && HasValue("quantiles"))
+      {
+      std::vector<std::string> values = GetParameterStringList("quantiles");
+      for (std::vector<std::string>::const_iterator it = values.begin(); it != values.end(); ++it)
+        {
+        const double value = atof(it->c_str());
+        if (value < 0. || value > 100.)
+          {
+          otbAppLogFATAL(<< "Quantiles must be given in percent, between 0 and 100 (got " << *it << ").");
+          }
+        quantiles.push_back(value);
+        }
+      }
+
+    m_StatisticsFilter = StatisticsFilterType::New();
+    m_StatisticsFilter->SetInput(image);
+    m_StatisticsFilter->SetInputLabelImage(labels);
+    m_StatisticsFilter->SetComputeQuantiles(!quantiles.empty());
+    m_StatisticsFilter->SetQuantileCompression(GetParameterFloat("compression"));
+    m_StatisticsFilter->GetStreamer()->SetAutomaticAdaptativeStreaming(GetParameterInt("ram"));
+    AddProcess(m_StatisticsFilter->GetStreamer(), "Computing label statistics...");
+    m_StatisticsFilter->Update();
+
+    const LabelPopulationMapType population = m_StatisticsFilter->GetLabelPopulationMap();
+    const PixelValueMapType minMap = m_StatisticsFilter->GetMinValueMap();
+    const PixelValueMapType maxMap = m_StatisticsFilter->GetMaxValueMap();
+    const PixelValueMapType meanMap = m_StatisticsFilter->GetMeanValueMap();
+    const PixelValueMapType stdDevMap = m_StatisticsFilter->GetStandardDeviationValueMap();
+    std::vector<PixelValueMapType> quantileMaps;
+    for (unsigned int i = 0; i < quantiles.size(); ++i)
+      {
+      quantileMaps.push_back(m_StatisticsFilter->GetQuantileValueMap(quantiles[i] / 100.));
+      }
+
+    const bool ignoreBackground = IsParameterEnabled("bv") && HasValue("bv");
+    const LabelType background = ignoreBackground ? static_cast<LabelType>(GetParameterInt("bv")) : 0;
+    const unsigned int nbBands = image->GetNumberOfComponentsPerPixel();
+
+    std::ofstream outFile(GetParameterString("out").c_str());
+    if (!outFile)
+      {
+      otbAppLogFATAL(<< "Unable to open " << GetParameterString("out") << " for writing.");
+      }
+
+    outFile << "label,count";
+    for (unsigned int band = 0; band < nbBands; ++band)
+      {
+      outFile << ",b" << band + 1 << "_min,b" << band + 1 << "_max,b" << band + 1 << "_mean,b" << band + 1 << "_std";
+      for (unsigned int i = 0; i < quantiles.size(); ++i)
+        {
+        outFile << ",b" << band + 1 << "_p" << quantiles[i];
+        }
+      }
+    outFile << std::endl;
+
+    outFile << std::setprecision(10);
+    unsigned int nbLabels = 0;
+    for (LabelPopulationMapType::const_iterator it = population.begin(); it != population.end(); ++it)
+      {
+      const LabelType label = it->first;
+      if (ignoreBackground && label == background)
+        {
+        continue;
+        }
+      ++nbLabels;
+      outFile << label << "," << it->second;
+      for (unsigned int band = 0; band < nbBands; ++band)
+        {
+        outFile << "," << minMap.find(label)->second[band]
+                << "," << maxMap.find(label)->second[band]
+                << "," << meanMap.find(label)->second[band]
+                << "," << stdDevMap.find(label)->second[band];
+        for (unsigned int i = 0; i < quantiles.size(); ++i)
+          {
+          outFile << "," << quantileMaps[i].find(label)->second[band];
+          }
+        }
+      outFile << std::endl;
+      }
+    outFile.close();
+
+    otbAppLogINFO(<< "Statistics of " << nbLabels << " labels written to " << GetParameterString("out"));
+  }
+
+  StatisticsFilterType::Pointer m_StatisticsFilter;
+};
+
+} // end namespace Wrapper
+} // end namespace otb
+
+OTB_APPLICATION_EXPORT(otb::Wrapper::LabelImageStatistics)
@@ -36,6 +36,14 @@
 
 #include "otbGeographicalDistance.h"
 
+// Deformation grid export and import
+#include "itkVectorIndexSelectionCastImageFilter.h"
+#include "itkVectorCastImageFilter.h"
+#include "otbImageListToVectorImageFilter.h"
+#include "otbMetaDataKey.h"
+
+#include <iomanip>
+
 namespace otb
 {
 
@@ -58,6 +66,9 @@ enum
 
 const float DefaultGridSpacingMeter = 4.0;
 
+// Tag of the deformation grid key in the metadata of exported grids
+const char * const OrthoGridKeyTag = "OTB_ORTHO_GRID_KEY";
+
 namespace Wrapper
 {
 
@@ -86,6 +97,16 @@ public:
                                                        double>     NearestNeighborInterpolationType;
   typedef otb::BCOInterpolateImageFunction<FloatVectorImageType>   BCOInterpolationType;
 
+  /** Deformation grid export and import */
+  typedef ResampleFilterType::DisplacementFieldType                DisplacementFieldType;
+  typedef itk::VectorIndexSelectionCastImageFilter<DisplacementFieldType,
+                                                   DoubleImageType> GridComponentFilterType;
+  typedef otb::ImageList<DoubleImageType>                          GridImageListType;
+  typedef otb::ImageListToVectorImageFilter<GridImageListType,
+                                            DoubleVectorImageType> GridListFilterType;
+  typedef itk::VectorCastImageFilter<DoubleVectorImageType,
+                                     DisplacementFieldType>        GridCastFilterType;
+
 private:
   void DoInit() ITK_OVERRIDE
   {
@@ -230,6 +251,53 @@ private:
                             "but increasing this parameter will reduce processing time.");
     MandatoryOff("opt.gridspacing");
 
+    // Adaptive displacement field
+    AddParameter(ParameterType_Float, "opt.gridtolerance", "Resampling grid tolerance");
+    SetParameterDescription("opt.gridtolerance",
+                            "When enabled, the deformation grid is refined where the bilinear "
+                            "interpolation of the sensor model differs from the exact model by more "
+                            "than this tolerance (expressed in input image pixels for sensor images). "
+                            "opt.gridspacing then sets the coarsest grid spacing, which is refined "
+                            "down to 1/8 of it, but never below the output spacing.");
+    SetMinimumParameterFloatValue("opt.gridtolerance", 0.);
+    MandatoryOff("opt.gridtolerance");
+    DisableParameter("opt.gridtolerance");
+
+    // Deformation grid reuse
+    AddParameter(ParameterType_OutputImage, "opt.outgrid", "Output deformation grid");
+    SetParameterDescription("opt.outgrid",
+                            "Export the deformation grid computed from the sensor model. "
+                            "It can be given to opt.ingrid to ortho-rectify other products "
+                            "sharing the same geometry (other bands, derived products) "
+                            "without evaluating the sensor model again.");
+    SetDefaultOutputPixelType("opt.outgrid", ImagePixelType_double);
+    MandatoryOff("opt.outgrid");
+    DisableParameter("opt.outgrid");
+
+    AddParameter(ParameterType_InputImage, "opt.ingrid", "Input deformation grid");
+    SetParameterDescription("opt.ingrid",
+                            "Deformation grid previously exported with opt.outgrid. The grid "
+                            "carries a key computed from the input image geometry, the output "
+                            "grid, the deformation grid parameters and the elevation settings: "
+                            "it is rejected if this key does not match the current settings.");
+    MandatoryOff("opt.ingrid");
+    DisableParameter("opt.ingrid");
+
+    AddParameter(ParameterType_Empty, "opt.nativerpc", "Native RPC model");
+    SetParameterDescription("opt.nativerpc",
+                            "Evaluate the RPC sensor model of the input image natively instead of "
+                            "through ossim. Only applies to products with an RPC model.");
+    MandatoryOff("opt.nativerpc");
+    DisableParameter("opt.nativerpc");
+
+    AddParameter(ParameterType_Empty, "opt.fastwarp", "Fast resampling kernels");
+    SetParameterDescription("opt.fastwarp",
+                            "Resample the output rows with dedicated kernels for the nearest, linear "
+                            "and bicubic interpolators. The output matches the default resampling "
+                            "up to floating point rounding.");
+    MandatoryOff("opt.fastwarp");
+    DisableParameter("opt.fastwarp");
+
     // Doc example parameter settings
     SetDocExampleParameterValue("io.in", "QB_TOULOUSE_MUL_Extract_500_500.tif");
     SetDocExampleParameterValue("io.out","QB_Toulouse_ortho.tif");
@@ -664,6 +732,18 @@ private:
       otbAppLogINFO("Generating RPC modeling with " << GetParameterInt("opt.rpc") << " points per axis");
       }
 
+    if(IsParameterEnabled("opt.nativerpc"))
+      {
+      m_ResampleFilter->SetUseNativeRPCModel(true);
+      otbAppLogINFO("Using the native RPC model evaluation");
+      }
+
+    if(IsParameterEnabled("opt.fastwarp"))
+      {
+      m_ResampleFilter->SetFastWarp(true);
+      otbAppLogINFO("Using the fast resampling kernels");
+      }
+
     // Set Output information
     ResampleFilterType::SizeType size;
     size[0] = GetParameterInt("outputs.sizex");
@@ -733,11 +813,183 @@ private:
       m_ResampleFilter->SetDisplacementFieldSpacing(gridSpacing);
       }
 
+    if (IsParameterEnabled("opt.gridtolerance") && HasValue("opt.gridtolerance"))
+      {
+      m_ResampleFilter->SetDisplacementFieldTolerance(GetParameterFloat("opt.gridtolerance"));
+      otbAppLogINFO("Refining the deformation grid where the interpolation error exceeds "
+                    << GetParameterFloat("opt.gridtolerance"));
+      }
+
+    // Deformation grid reuse
+    if (IsParameterEnabled("opt.ingrid") && HasValue("opt.ingrid"))
+      {
+      DoubleVectorImageType* inGrid = GetParameterDoubleVectorImage("opt.ingrid");
+      inGrid->UpdateOutputInformation();
+
+      if (inGrid->GetNumberOfComponentsPerPixel() != DisplacementFieldType::PixelType::Dimension)
+        {
+        otbAppLogFATAL("The input deformation grid should have "
+                       << DisplacementFieldType::PixelType::Dimension << " bands");
+        }
+
+      const std::string gridKey = ReadGridKey(inGrid->GetMetaDataDictionary());
+      if (gridKey.empty())
+        {
+        otbAppLogWARNING("The input deformation grid has no key: "
+                         "it can not be checked against the current settings");
+        }
+      else if (gridKey != ComputeGridKey(inImage))
+        {
+        otbAppLogFATAL("The input deformation grid was computed with another input "
+                       "geometry, output grid or elevation setting (key " << gridKey << ")");
+        }
+
+      m_GridCaster = GridCastFilterType::New();
+      m_GridCaster->SetInput(inGrid);
+      m_GridCaster->UpdateOutputInformation();
+      m_ResampleFilter->SetInputDisplacementField(m_GridCaster->GetOutput());
+      otbAppLogINFO("Using the precomputed deformation grid: the sensor model is not evaluated");
+
+      if (IsParameterEnabled("opt.outgrid") && HasValue("opt.outgrid"))
+        {
+        otbAppLogWARNING("opt.outgrid is ignored when opt.ingrid is set");
+        DisableParameter("opt.outgrid");
+        }
+      }
+    else if (IsParameterEnabled("opt.outgrid") && HasValue("opt.outgrid"))
+      {
+      // Size the displacement field before exporting it
+      m_ResampleFilter->UpdateOutputInformation();
+      DisplacementFieldType* field = m_ResampleFilter->GetDisplacementField();
+
+      // The key travels with the grid in the metadata of the written image
+      std::ostringstream keyTag;
+      keyTag << OrthoGridKeyTag << "=" << ComputeGridKey(inImage);
+      itk::EncapsulateMetaData<std::string>(field->GetMetaDataDictionary(),
+                                            std::string(MetaDataKey::MetadataKey) + OrthoGridKeyTag,
+                                            keyTag.str());
+
+      m_GridImageList = GridImageListType::New();
+      m_GridComponentFilters.clear();
+      for (unsigned int i = 0; i < DisplacementFieldType::PixelType::Dimension; ++i)
+        {
+        GridComponentFilterType::Pointer component = GridComponentFilterType::New();
+        component->SetInput(field);
+        component->SetIndex(i);
+        m_GridComponentFilters.push_back(component);
+        m_GridImageList->PushBack(component->GetOutput());
+        }
+      m_GridListFilter = GridListFilterType::New();
+      m_GridListFilter->SetInput(m_GridImageList);
+      SetParameterOutputImage("opt.outgrid", m_GridListFilter->GetOutput());
+      }
+
     // Output Image
     SetParameterOutputImage("io.out", m_ResampleFilter->GetOutput());
     }
 
+  /** Key identifying the deformation grid: it covers everything the grid
+   * depends on (input geometry and sensor model, output grid, deformation
+   * grid parameters and elevation settings). */
+  std::string ComputeGridKey(FloatVectorImageType* inImage)
+    {
+    std::ostringstream oss;
+    oss << std::setprecision(17);
+
+    const FloatVectorImageType::RegionType& region = inImage->GetLargestPossibleRegion();
+    oss << region.GetIndex() << region.GetSize() << inImage->GetOrigin()
+        << inImage->GetSignedSpacing() << inImage->GetProjectionRef() << ";";
+
+    const ImageKeywordlist::KeywordlistMap& kwl = inImage->GetImageKeywordlist().GetKeywordlist();
+    for (ImageKeywordlist::KeywordlistMap::const_iterator it = kwl.begin(); it != kwl.end(); ++it)
+      {
+      oss << it->first << "=" << it->second << ";";
+      }
+
+    oss << m_OutputProjectionRef << ";"
+        << GetParameterFloat("outputs.ulx") << ";" << GetParameterFloat("outputs.uly") << ";"
+        << GetParameterInt("outputs.sizex") << ";" << GetParameterInt("outputs.sizey") << ";"
+        << GetParameterFloat("outputs.spacingx") << ";" << GetParameterFloat("outputs.spacingy") << ";";
+
+    if (IsParameterEnabled("opt.gridspacing"))
+      {
+      oss << "gridspacing=" << GetParameterFloat("opt.gridspacing") << ";";
+      }
+    if (IsParameterEnabled("opt.gridtolerance") && HasValue("opt.gridtolerance"))
+      {
+      oss << "gridtolerance=" << GetParameterFloat("opt.gridtolerance") << ";";
+      }
+    if (IsParameterEnabled("opt.rpc"))
+      {
+      oss << "rpc=" << GetParameterInt("opt.rpc") << ";";
+      }
+
+    if (ElevationParametersHandler::IsDEMUsed(this, "elev"))
+      {
+      oss << "dem=" << ElevationParametersHandler::GetDEMDirectory(this, "elev") << ";";
+      }
+    if (ElevationParametersHandler::IsGeoidUsed(this, "elev"))
+      {
+      oss << "geoid=" << ElevationParametersHandler::GetGeoidFile(this, "elev") << ";";
+      }
+    oss << "default=" << ElevationParametersHandler::GetDefaultElevation(this, "elev");
+
+    // 64 bits FNV-1a hash of the description
+    const std::string description = oss.str();
+    unsigned long long hash = 14695981039346656037ULL;
+    for (std::string::const_iterator it = description.begin(); it != description.end(); ++it)
+      {
+      hash ^= static_cast<unsigned char>(*it);
+      hash *= 1099511628211ULL;
+      }
+
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return key.str();
+    }
+
+  /** Read the deformation grid key from the metadata of an exported grid,
+   * returns an empty string if there is none */
+  std::string ReadGridKey(const itk::MetaDataDictionary& dict)
+    {
+    const std::string metadataKey = MetaDataKey::MetadataKey;
+    const std::string tag = std::string(OrthoGridKeyTag) + "=";
+    std::vector<std::string> keys = dict.GetKeys();
+    for (unsigned int i = 0; i < keys.size(); ++i)
+      {
+      std::string value;
+      if (keys[i].compare(0, metadataKey.length(), metadataKey) == 0
+          && itk::ExposeMetaData<std::string>(dict, keys[i], value)
+          && value.compare(0, tag.length(), tag) == 0)
+        {
+        return value.substr(tag.length());
+        }
+      }
+    return std::string();
+    }
+
+  void AfterExecuteAndWriteOutputs() ITK_OVERRIDE
+    {
+    if (m_ResampleFilter.IsNotNull() && m_ResampleFilter->GetDisplacementFieldTolerance() > 0.
+        && m_ResampleFilter->GetInputDisplacementField() == ITK_NULLPTR)
+      {
+      otbAppLogINFO("Deformation grid: maximum interpolation error = "
+                    << m_ResampleFilter->GetDisplacementFieldMaximumError() << ", "
+                    << m_ResampleFilter->GetNumberOfExactEvaluations() << " exact model evaluations, "
+                    << m_ResampleFilter->GetNumberOfSavedEvaluations() << " evaluations saved");
+      }
+    if (m_ResampleFilter.IsNotNull() && m_ResampleFilter->GetReadAmplification() > 0.)
+      {
+      otbAppLogINFO("Input read amplification (requested input pixels over the exact "
+                    "footprint of the output streams): " << m_ResampleFilter->GetReadAmplification());
+      }
+    }
+
   ResampleFilterType::Pointer     m_ResampleFilter;
+  GridCastFilterType::Pointer     m_GridCaster;
+  GridImageListType::Pointer      m_GridImageList;
+  GridListFilterType::Pointer     m_GridListFilter;
+  std::vector<GridComponentFilterType::Pointer> m_GridComponentFilters;
   std::string                     m_OutputProjectionRef;
   };
 
@@ -148,6 +148,11 @@ private:
 
     AddChoice("interpolator.linear", "Linear interpolation");
     SetParameterDescription("interpolator.linear","Linear interpolation leads to average image quality but is quite fast");
+
+    AddParameter(ParameterType_Empty, "fastwarp", "Fast resampling kernels");
+    SetParameterDescription("fastwarp","Resample the output rows with dedicated kernels for the nearest, linear and bicubic interpolators. The output matches the default resampling up to floating point rounding.");
+    MandatoryOff("fastwarp");
+    DisableParameter("fastwarp");
     
     AddRAMParameter();
 
@@ -223,6 +228,13 @@ private:
     itk::NumericTraits<FloatVectorImageType::PixelType>::SetLength(defaultValue, movingImage->GetNumberOfComponentsPerPixel());
     defaultValue.Fill(GetParameterFloat("fv"));
 
+    if(IsParameterEnabled("fastwarp"))
+      {
+      otbAppLogINFO("Using the fast resampling kernels");
+      m_Resampler->SetFastWarp(true);
+      m_BasicResampler->SetFastWarp(true);
+      }
+
     if(GetParameterString("mode")=="default")
       {
       FloatVectorImageType::SpacingType defSpacing;
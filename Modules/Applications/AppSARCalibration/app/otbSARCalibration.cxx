@@ -22,6 +22,7 @@
 #include "otbWrapperApplicationFactory.h"
 
 #include "otbSarRadiometricCalibrationToImageFilter.h"
+#include "otbSarDeburstCalibrationImageFilter.h"
 
 namespace otb
 {
@@ -44,6 +45,9 @@ public:
   typedef otb::SarRadiometricCalibrationToImageFilter<ComplexFloatImageType,
                                                       FloatImageType>     CalibrationFilterType;
 
+  typedef otb::SarDeburstCalibrationImageFilter<ComplexFloatImageType,
+                                                FloatImageType>           DeburstCalibrationFilterType;
+
 private:
   void DoInit() ITK_OVERRIDE
   {
@@ -84,6 +88,10 @@ private:
     SetParameterDescription("lut.dn","Use DN value lookup value from product metadata");
     SetDefaultParameterInt("lut", 0);
 
+    AddParameter(ParameterType_Empty, "deburst", "Deburst the calibrated image");
+    SetParameterDescription("deburst", "If enabled, redundant lines between bursts are removed while calibrating, in a single pass. This is equivalent to running the SARDeburst application on the calibrated image. Only Sentinel1 IW SLC products are supported.");
+    MandatoryOff("deburst");
+
     // Doc example parameter settings
     SetDocExampleParameterValue("in", "RSAT_imagery_HH.tif");
     SetDocExampleParameterValue("out", "SarRadiometricCalibration.tif" );
@@ -101,6 +109,28 @@ private:
     // Get the input complex image
     ComplexFloatImageType*  floatComplexImage = GetParameterComplexFloatImage("in");
 
+    short lut = 0;
+
+    lut = GetParameterInt("lut");
+
+    if (IsParameterEnabled("deburst"))
+      {
+      // Calibrate and deburst in a single pass
+      m_DeburstCalibrationFilter = DeburstCalibrationFilterType::New();
+      m_DeburstCalibrationFilter->SetInput(floatComplexImage);
+
+      if (IsParameterEnabled("noise"))
+        {
+        m_DeburstCalibrationFilter->SetEnableNoise(false);
+        }
+
+      m_DeburstCalibrationFilter->SetLookupSelected(lut);
+
+      // Set the output image
+      SetParameterOutputImage("out", m_DeburstCalibrationFilter->GetOutput());
+      return;
+      }
+
     // Set the filer input
     m_CalibrationFilter = CalibrationFilterType::New();
     m_CalibrationFilter->SetInput(floatComplexImage);
@@ -110,10 +140,6 @@ private:
       m_CalibrationFilter->SetEnableNoise(false);
       }
 
-    short lut = 0;
-
-    lut = GetParameterInt("lut");
-
     m_CalibrationFilter->SetLookupSelected(lut);
 
     // Set the output image
@@ -121,7 +147,8 @@ private:
 
   }
 
-  CalibrationFilterType::Pointer   m_CalibrationFilter;
+  CalibrationFilterType::Pointer          m_CalibrationFilter;
+  DeburstCalibrationFilterType::Pointer   m_DeburstCalibrationFilter;
 
 };
 }
@@ -22,15 +22,9 @@
 #include "otbWrapperApplicationFactory.h"
 
 
-#include "otbReciprocalHAlphaImageFilter.h"
-#include "otbReciprocalBarnesDecompImageFilter.h"
-#include "otbReciprocalHuynenDecompImageFilter.h"
 #include "otbReciprocalPauliDecompImageFilter.h"
 
-#include "otbSinclairReciprocalImageFilter.h"
-#include "otbSinclairToReciprocalCoherencyMatrixFunctor.h"
-#include "otbPerBandVectorImageFilter.h"
-#include "itkMeanImageFilter.h"
+#include "otbSinclairReciprocalDecompositionImageFilter.h"
 #include "otbNRIBandImagesToOneNComplexBandsImage.h"
 #include "otbImageListToVectorImageFilter.h"
 #include "otbImageList.h"
@@ -52,29 +46,16 @@ public:
 
   
   
-  typedef otb::Functor::SinclairToReciprocalCoherencyMatrixFunctor<ComplexDoubleImageType::PixelType,
-                                    ComplexDoubleImageType::PixelType,
-                                    ComplexDoubleImageType::PixelType,
-                                    ComplexDoubleVectorImageType::PixelType>								FunctorType;
-                                    
-                                    								
-  typedef SinclairReciprocalImageFilter<ComplexDoubleImageType, 
-											 ComplexDoubleImageType, 
-											 ComplexDoubleImageType, 
-											 ComplexDoubleVectorImageType, 
-											 FunctorType > 												    SRFilterType;
-  
-  
-  typedef itk::MeanImageFilter<ComplexDoubleImageType, ComplexDoubleImageType>                                         MeanFilterType;
-  typedef otb::PerBandVectorImageFilter<ComplexDoubleVectorImageType, ComplexDoubleVectorImageType, MeanFilterType>    PerBandMeanFilterType;
+  typedef SinclairReciprocalDecompositionImageFilter<ComplexDoubleImageType,
+                                                     ComplexDoubleImageType,
+                                                     ComplexDoubleImageType,
+                                                     ComplexDoubleVectorImageType>                   DecompositionFilterType;
+
   //typedef otb::NRIBandImagesToOneNComplexBandsImage<DoubleVectorImageType, ComplexDoubleVectorImageType>               NRITOOneCFilterType;
   typedef otb::ImageList<ComplexDoubleImageType>                                                                       ImageListType;
   typedef ImageListToVectorImageFilter<ImageListType, ComplexDoubleVectorImageType >                                   ListConcatenerFilterType;
   
   
-  typedef otb::ReciprocalHAlphaImageFilter<ComplexDoubleVectorImageType, ComplexDoubleVectorImageType> 			       HAFilterType;
-  typedef otb::ReciprocalBarnesDecompImageFilter<ComplexDoubleVectorImageType, ComplexDoubleVectorImageType>           BarnesFilterType;
-  typedef otb::ReciprocalHuynenDecompImageFilter<ComplexDoubleVectorImageType, ComplexDoubleVectorImageType>           HuynenFilterType;
   typedef otb::ReciprocalPauliDecompImageFilter<ComplexDoubleVectorImageType, ComplexDoubleVectorImageType>            PauliFilterType;
 
 
@@ -174,12 +155,8 @@ private:
 	if ( (!inhv) && (!invh) )
 	  otbAppLogFATAL( << "Parameter inhv or invh not set. Please provide a HV or a VH complex image.");
     
-    m_SRFilter = SRFilterType::New();
-	m_HAFilter = HAFilterType::New();
-	m_MeanFilter = PerBandMeanFilterType::New();
-    MeanFilterType::InputSizeType radius;
-    m_BarnesFilter = BarnesFilterType::New();
-    m_HuynenFilter = HuynenFilterType::New();
+    m_DecompositionFilter = DecompositionFilterType::New();
+    DecompositionFilterType::SizeType radius;
     m_PauliFilter = PauliFilterType::New();
     m_Concatener = ListConcatenerFilterType::New();
     m_ImageList = ImageListType::New();    
@@ -187,59 +164,30 @@ private:
     switch (GetParameterInt("decomp"))
       {
 		case 0: // H-alpha-A
-		
-		if (inhv)
-		  m_SRFilter->SetInputHV_VH(GetParameterComplexDoubleImage("inhv"));
-	    else if (invh)
-		  m_SRFilter->SetInputHV_VH(GetParameterComplexDoubleImage("invh"));
-
-		m_SRFilter->SetInputHH(GetParameterComplexDoubleImage("inhh"));
-		m_SRFilter->SetInputVV(GetParameterComplexDoubleImage("invv"));
-		
-        radius.Fill( GetParameterInt("inco.kernelsize") );
-        m_MeanFilter->GetFilter()->SetRadius(radius);
-		
-		m_MeanFilter->SetInput(m_SRFilter->GetOutput());
-		m_HAFilter->SetInput(m_MeanFilter->GetOutput());
-		SetParameterComplexOutputImage("out", m_HAFilter->GetOutput() );
-    
-		break;
-        
 		case 1: // Barnes
+		case 2: // Huynen
 
+		// The coherency matrices are computed, averaged and decomposed
+		// in a single filter
 		if (inhv)
-		  m_SRFilter->SetInputHV_VH(GetParameterComplexDoubleImage("inhv"));
+		  m_DecompositionFilter->SetInputHV_VH(GetParameterComplexDoubleImage("inhv"));
 	    else if (invh)
-		  m_SRFilter->SetInputHV_VH(GetParameterComplexDoubleImage("invh"));
+		  m_DecompositionFilter->SetInputHV_VH(GetParameterComplexDoubleImage("invh"));
 
-		m_SRFilter->SetInputHH(GetParameterComplexDoubleImage("inhh"));
-		m_SRFilter->SetInputVV(GetParameterComplexDoubleImage("invv"));
+		m_DecompositionFilter->SetInputHH(GetParameterComplexDoubleImage("inhh"));
+		m_DecompositionFilter->SetInputVV(GetParameterComplexDoubleImage("invv"));
 		
         radius.Fill( GetParameterInt("inco.kernelsize") );
-        m_MeanFilter->GetFilter()->SetRadius(radius);
-		
-		m_MeanFilter->SetInput(m_SRFilter->GetOutput());
-		m_BarnesFilter->SetInput(m_MeanFilter->GetOutput());
-		SetParameterComplexOutputImage("out", m_BarnesFilter->GetOutput() );
-    
-		break;
-        
-		case 2: // Huynen
+        m_DecompositionFilter->SetRadius(radius);
 
-		if (inhv)
-		  m_SRFilter->SetInputHV_VH(GetParameterComplexDoubleImage("inhv"));
-	    else if (invh)
-		  m_SRFilter->SetInputHV_VH(GetParameterComplexDoubleImage("invh"));
+        if (GetParameterInt("decomp") == 0)
+          m_DecompositionFilter->SetDecomposition(DecompositionFilterType::HAlpha);
+        else if (GetParameterInt("decomp") == 1)
+          m_DecompositionFilter->SetDecomposition(DecompositionFilterType::Barnes);
+        else
+          m_DecompositionFilter->SetDecomposition(DecompositionFilterType::Huynen);
 
-		m_SRFilter->SetInputHH(GetParameterComplexDoubleImage("inhh"));
-		m_SRFilter->SetInputVV(GetParameterComplexDoubleImage("invv"));
-		
-        radius.Fill( GetParameterInt("inco.kernelsize") );
-        m_MeanFilter->GetFilter()->SetRadius(radius);
-		
-		m_MeanFilter->SetInput(m_SRFilter->GetOutput());
-		m_HuynenFilter->SetInput(m_MeanFilter->GetOutput());
-		SetParameterComplexOutputImage("out", m_HuynenFilter->GetOutput() );
+		SetParameterComplexOutputImage("out", m_DecompositionFilter->GetOutput() );
     
 		break;
         
@@ -265,12 +213,8 @@ private:
   }
 
   //MCPSFilterType::Pointer m_MCPSFilter;
-  SRFilterType::Pointer m_SRFilter;
-  HAFilterType::Pointer m_HAFilter;
-  BarnesFilterType::Pointer m_BarnesFilter;
-  HuynenFilterType::Pointer m_HuynenFilter;
+  DecompositionFilterType::Pointer m_DecompositionFilter;
   PauliFilterType::Pointer m_PauliFilter;
-  PerBandMeanFilterType::Pointer m_MeanFilter;
   ListConcatenerFilterType::Pointer  m_Concatener;
   ImageListType::Pointer        m_ImageList;
   
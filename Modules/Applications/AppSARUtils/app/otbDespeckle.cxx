@@ -25,7 +25,6 @@
 #include "otbLeeImageFilter.h"
 #include "otbGammaMAPImageFilter.h"
 #include "otbKuanImageFilter.h"
-#include "otbMultiToMonoChannelExtractROI.h"
 
 namespace otb
 {
@@ -41,12 +40,12 @@ public:
   typedef itk::SmartPointer<Self>             Pointer;
   typedef itk::SmartPointer<const Self>       ConstPointer;
 
-  typedef itk::ImageToImageFilter<FloatImageType, FloatImageType> SpeckleFilterType;
+  typedef itk::ImageToImageFilter<FloatVectorImageType, FloatVectorImageType> SpeckleFilterType;
 
-  typedef LeeImageFilter<FloatImageType, FloatImageType>        LeeFilterType;
-  typedef FrostImageFilter<FloatImageType, FloatImageType>      FrostFilterType;
-  typedef GammaMAPImageFilter<FloatImageType, FloatImageType>   GammaMAPFilterType;
-  typedef KuanImageFilter<FloatImageType, FloatImageType>       KuanFilterType;
+  typedef LeeImageFilter<FloatVectorImageType, FloatVectorImageType>        LeeFilterType;
+  typedef FrostImageFilter<FloatVectorImageType, FloatVectorImageType>      FrostFilterType;
+  typedef GammaMAPImageFilter<FloatVectorImageType, FloatVectorImageType>   GammaMAPFilterType;
+  typedef KuanImageFilter<FloatVectorImageType, FloatVectorImageType>       KuanFilterType;
 
   /** Standard macro */
   itkNewMacro(Self);
@@ -76,7 +75,7 @@ private:
       "  * Kuan : Also derived from the MMSE criteria under the assumption of non stationary mean and variance. It is quite similar to Lee filter in form."
       );
 
-    SetDocLimitations("The application does not handle complex image as input.");
+    SetDocLimitations("The application does not handle complex image as input. Each band of the input image (for instance each polarimetric channel) is filtered independently.");
 
     SetDocAuthors("OTB-Team");
 
@@ -176,18 +175,6 @@ private:
   {
     FloatVectorImageType* inVImage = GetParameterImage("in");
 
-    // Transform to otb::Image
-    typedef otb::Image<FloatVectorImageType::InternalPixelType> InternalFloatImageType;
-    typedef otb::MultiToMonoChannelExtractROI<float,float> ExtractFilterType;
-
-    ExtractFilterType::Pointer channelSelect = ExtractFilterType::New();
-    m_Ref.push_back(channelSelect.GetPointer());
-    channelSelect->SetChannel(1);
-    channelSelect->SetInput(inVImage);
-    channelSelect->UpdateOutputInformation();
-    InternalFloatImageType::Pointer inImage = channelSelect->GetOutput();
-    inImage->UpdateOutputInformation();
-
     switch (GetParameterInt("filter"))
       {
       case 0:
@@ -195,7 +182,7 @@ private:
       LeeFilterType::Pointer  filter = LeeFilterType::New();
       m_Ref.push_back(filter.GetPointer());
 
-      filter->SetInput(inImage);
+      filter->SetInput(inVImage);
 
       LeeFilterType::SizeType lradius;
       lradius.Fill(GetParameterInt("filter.lee.rad"));
@@ -212,7 +199,7 @@ private:
       FrostFilterType::Pointer  filter = FrostFilterType::New();
       m_Ref.push_back(filter.GetPointer());
 
-      filter->SetInput(inImage);
+      filter->SetInput(inVImage);
 
       FrostFilterType::SizeType lradius;
       lradius.Fill(GetParameterInt("filter.frost.rad"));
@@ -229,7 +216,7 @@ private:
       GammaMAPFilterType::Pointer  filter = GammaMAPFilterType::New();
       m_Ref.push_back(filter.GetPointer());
 
-      filter->SetInput(inImage);
+      filter->SetInput(inVImage);
 
       GammaMAPFilterType::SizeType lradius;
       lradius.Fill(GetParameterInt("filter.gammamap.rad"));
@@ -246,7 +233,7 @@ private:
       KuanFilterType::Pointer  filter = KuanFilterType::New();
       m_Ref.push_back(filter.GetPointer());
 
-      filter->SetInput(inImage);
+      filter->SetInput(inVImage);
 
       KuanFilterType::SizeType lradius;
       lradius.Fill(GetParameterInt("filter.kuan.rad"));
@@ -30,6 +30,7 @@
 #include "otbVectorImageToAmplitudeImageFilter.h"
 #include "itkGradientMagnitudeImageFilter.h"
 #include "otbWatershedSegmentationFilter.h"
+#include "otbStreamingWatershedSegmentationFilter.h"
 #include "otbMorphologicalProfilesSegmentationFilter.h"
 
 // Large scale vectorization framework
@@ -95,6 +96,9 @@ public:
   typedef otb::WatershedSegmentationFilter
   <FloatImageType,LabelImageType>         WatershedSegmentationFilterType;
 
+  typedef otb::StreamingWatershedSegmentationFilter
+  <FloatImageType,LabelImageType>         StreamingWatershedSegmentationFilterType;
+
   // Geodesic morphology multiscale segmentation
   typedef otb::MorphologicalProfilesSegmentationFilter<FloatImageType,LabelImageType> MorphologicalProfilesSegmentationFilterType;
 
@@ -225,6 +229,14 @@ private:
     SetMinimumParameterFloatValue("filter.watershed.level",0);
     SetMaximumParameterFloatValue("filter.watershed.level",1);
 
+    AddParameter(ParameterType_Empty,"filter.watershed.streaming","Streaming watershed");
+    SetParameterDescription("filter.watershed.streaming","Use the out-of-core tiled watershed in raster mode, so that the "
+                            "whole image is never loaded in memory. Its basins are not identical to the ones of the default "
+                            "watershed, whose merge tree is built differently. This option has no effect in vector mode, "
+                            "which is already tiled.");
+    MandatoryOff("filter.watershed.streaming");
+    DisableParameter("filter.watershed.streaming");
+
     AddParameter(ParameterType_Choice, "mode", "Processing mode");
     SetParameterDescription("mode", "Choice of processing mode, either raster or large-scale.");
 
@@ -615,25 +627,47 @@ private:
       {
       otbAppLogINFO(<<"Using watershed segmentation."<<std::endl);
 
-      AmplitudeFilterType::Pointer amplitudeFilter = AmplitudeFilterType::New();
+      m_AmplitudeFilter = AmplitudeFilterType::New();
+      m_AmplitudeFilter->SetInput(this->GetParameterFloatVectorImage("in"));
 
-      amplitudeFilter->SetInput(this->GetParameterFloatVectorImage("in"));
+      m_GradientMagnitudeFilter = GradientMagnitudeFilterType::New();
+      m_GradientMagnitudeFilter->SetInput(m_AmplitudeFilter->GetOutput());
 
-      GradientMagnitudeFilterType::Pointer gradientMagnitudeFilter = GradientMagnitudeFilterType::New();
-      gradientMagnitudeFilter->SetInput(amplitudeFilter->GetOutput());
+      if (IsParameterEnabled("filter.watershed.streaming") && segModeType == "raster")
+        {
+        otbAppLogINFO(<<"Using the streaming watershed."<<std::endl);
 
-      StreamingVectorizedWatershedFilterType::Pointer
-          watershedVectorizedFilter = StreamingVectorizedWatershedFilterType::New();
+        m_StreamingWatershedFilter = StreamingWatershedSegmentationFilterType::New();
+        m_StreamingWatershedFilter->SetInput(m_GradientMagnitudeFilter->GetOutput());
+        m_StreamingWatershedFilter->SetThreshold(GetParameterFloat("filter.watershed.threshold"));
+        m_StreamingWatershedFilter->SetLevel(GetParameterFloat("filter.watershed.level"));
 
-      watershedVectorizedFilter->GetSegmentationFilter()->SetThreshold(
-        GetParameterFloat("filter.watershed.threshold"));
-      watershedVectorizedFilter->GetSegmentationFilter()->SetLevel(GetParameterFloat("filter.watershed.level"));
+        DisableParameter("mode.vector.out");
+        EnableParameter("mode.raster.out");
 
-      streamSize = this->GenericApplySegmentation<FloatImageType,WatershedSegmentationFilterType>(
-        watershedVectorizedFilter,
-        gradientMagnitudeFilter->GetOutput(),
-        layer,
-        0);
+        // The label image is streamed by the writer
+        SetParameterOutputImage<UInt32ImageType>("mode.raster.out", m_StreamingWatershedFilter->GetOutput());
+        }
+      else
+        {
+        if (IsParameterEnabled("filter.watershed.streaming"))
+          {
+          otbAppLogWARNING(<<"filter.watershed.streaming only applies to the raster mode."<<std::endl);
+          }
+
+        StreamingVectorizedWatershedFilterType::Pointer
+            watershedVectorizedFilter = StreamingVectorizedWatershedFilterType::New();
+
+        watershedVectorizedFilter->GetSegmentationFilter()->SetThreshold(
+          GetParameterFloat("filter.watershed.threshold"));
+        watershedVectorizedFilter->GetSegmentationFilter()->SetLevel(GetParameterFloat("filter.watershed.level"));
+
+        streamSize = this->GenericApplySegmentation<FloatImageType,WatershedSegmentationFilterType>(
+          watershedVectorizedFilter,
+          m_GradientMagnitudeFilter->GetOutput(),
+          layer,
+          0);
+        }
       }
     else if (segType == "mprofiles")
       {
@@ -706,6 +740,11 @@ private:
   }
 
   ClampFilterType::Pointer m_ClampFilter;
+
+  // Kept as members so that the streaming watershed pipeline outlives DoExecute()
+  AmplitudeFilterType::Pointer                      m_AmplitudeFilter;
+  GradientMagnitudeFilterType::Pointer              m_GradientMagnitudeFilter;
+  StreamingWatershedSegmentationFilterType::Pointer m_StreamingWatershedFilter;
 };
 }
 }
@@ -28,6 +28,8 @@
 
 #include "otbSubPixelDisparityImageFilter.h"
 #include "otbDisparityMapMedianFilter.h"
+#include "otbStreamingShrinkImageFilter.h"
+#include "otbCoarseToFineDisparityRangeFilter.h"
 
 namespace otb
 {
@@ -97,6 +99,11 @@ public:
                                         FloatImageType,
                                         FloatImageType>   MedianFilterType;
 
+  typedef otb::StreamingShrinkImageFilter<FloatImageType,
+                                          FloatImageType>   ShrinkFilterType;
+
+  typedef otb::CoarseToFineDisparityRangeFilter<FloatImageType> DisparityRangeFilterType;
+
   /** Standard macro */
   itkNewMacro(Self);
 
@@ -160,7 +167,10 @@ private:
       "disable disparity investigation for some pixel: a no-data value, and a "
       "threshold on the local variance. This allows one to speed-up computation"
       " by avoiding to investigate disparities that will not be reliable anyway"
-      ". For efficiency reasons, if the image of optimal metric values is "
+      ". Large disparity ranges can be handled with a coarse-to-fine search: "
+      "disparities are first estimated on subsampled images, and each pixel "
+      "then only explores the range found around it at the coarser level. "
+      "For efficiency reasons, if the image of optimal metric values is "
       "desired, it will be concatenated to the output image (which will then "
       "have three bands : horizontal disparity, vertical disparity and metric "
       "value). One can split these images afterward.");
@@ -309,6 +319,12 @@ private:
       "search is performed to find the best sub-pixel position. The window in "
       "the right image is resampled at sub-pixel positions to estimate the match.");
 
+    AddChoice("bm.subpixel.fastdichotomy", "Fast dichotomy search");
+    SetParameterDescription("bm.subpixel.fastdichotomy", "Same search as the "
+      "dichotomy, but the window in the right image is interpolated directly "
+      "at each sub-pixel position, and the metric values around the best "
+      "integer disparity are taken from the block-matching step.");
+
     AddParameter(ParameterType_Int,"bm.step", "Computation step");
     SetParameterDescription("bm.step", "Location step between computed "
       "disparities. Disparities will be computed every 'step' pixels in the "
@@ -348,6 +364,34 @@ private:
     MandatoryOff("bm.medianfilter.incoherence");
     DisableParameter("bm.medianfilter.incoherence");
 
+    AddParameter(ParameterType_Group,"bm.pyramid",
+      "Coarse-to-fine disparity search");
+    SetParameterDescription("bm.pyramid","Estimate the disparities on "
+      "subsampled images first, and only explore the horizontal disparities "
+      "found around each pixel at the finer levels");
+
+    AddParameter(ParameterType_Int,"bm.pyramid.levels", "Number of coarse levels");
+    SetParameterDescription("bm.pyramid.levels", "Number of subsampled levels "
+      "(images are shrunk by a factor 2 from one level to the next). 0 "
+      "disables the coarse-to-fine search.");
+    SetDefaultParameterInt("bm.pyramid.levels",0);
+    SetMinimumParameterIntValue("bm.pyramid.levels",0);
+    MandatoryOff("bm.pyramid.levels");
+
+    AddParameter(ParameterType_Int,"bm.pyramid.radius", "Neighborhood radius");
+    SetParameterDescription("bm.pyramid.radius", "Radius (in coarse pixels) "
+      "of the neighborhood of coarse disparities used to bound the search "
+      "at the finer level");
+    SetDefaultParameterInt("bm.pyramid.radius",1);
+    SetMinimumParameterIntValue("bm.pyramid.radius",0);
+    MandatoryOff("bm.pyramid.radius");
+
+    AddParameter(ParameterType_Float,"bm.pyramid.margin", "Disparity margin");
+    SetParameterDescription("bm.pyramid.margin", "Margin (in pixels of the "
+      "finer level) added on both sides of the horizontal disparity ranges");
+    SetDefaultParameterFloat("bm.pyramid.margin",2.);
+    MandatoryOff("bm.pyramid.margin");
+
     AddParameter(ParameterType_Choice, "bm.initdisp", "Initial disparities");
     AddChoice("bm.initdisp.none", "None");
     SetParameterDescription("bm.initdisp.none", "No initial disparity used");
@@ -652,8 +696,14 @@ private:
         m_SSDBlockMatcher->SetVerticalDisparityInput(GetParameterFloatImage("bm.initdisp.maps.vmap"));
         }
 
+      if (GetParameterInt("bm.pyramid.levels") > 0)
+        {
+        SetupCoarseToFineSearch(m_SSDBlockMatcher.GetPointer(), leftImage, rightImage);
+        }
+
       if (GetParameterInt("bm.subpixel") > 0)
         {
+        m_SSDBlockMatcher->SetComputeNeighborMetrics(GetParameterInt("bm.subpixel") == 4);
         m_SSDSubPixFilter->SetInputsFromBlockMatchingFilter(m_SSDBlockMatcher);
         AddProcess(m_SSDSubPixFilter,"Sub-pixel refinement");
         switch (GetParameterInt("bm.subpixel"))
@@ -664,6 +714,8 @@ private:
             break;
           case 3 : m_SSDSubPixFilter->SetRefineMethod(SSDSubPixelDisparityFilterType::DICHOTOMY);
             break;
+          case 4 : m_SSDSubPixFilter->SetRefineMethod(SSDSubPixelDisparityFilterType::FAST_DICHOTOMY);
+            break;
           default : break;
           }
         hdispImage = m_SSDSubPixFilter->GetHorizontalDisparityOutput();
@@ -720,8 +772,14 @@ private:
         m_NCCBlockMatcher->SetVerticalDisparityInput(GetParameterFloatImage("bm.initdisp.maps.vmap"));
         }
 
+      if (GetParameterInt("bm.pyramid.levels") > 0)
+        {
+        SetupCoarseToFineSearch(m_NCCBlockMatcher.GetPointer(), leftImage, rightImage);
+        }
+
       if (GetParameterInt("bm.subpixel") > 0)
         {
+        m_NCCBlockMatcher->SetComputeNeighborMetrics(GetParameterInt("bm.subpixel") == 4);
         m_NCCSubPixFilter->SetInputsFromBlockMatchingFilter(m_NCCBlockMatcher);
         AddProcess(m_NCCSubPixFilter,"Sub-pixel refinement");
         switch (GetParameterInt("bm.subpixel"))
@@ -732,6 +790,8 @@ private:
             break;
           case 3 : m_NCCSubPixFilter->SetRefineMethod(NCCSubPixelDisparityFilterType::DICHOTOMY);
             break;
+          case 4 : m_NCCSubPixFilter->SetRefineMethod(NCCSubPixelDisparityFilterType::FAST_DICHOTOMY);
+            break;
           default : break;
           }
         hdispImage = m_NCCSubPixFilter->GetHorizontalDisparityOutput();
@@ -788,8 +848,14 @@ private:
         m_LPBlockMatcher->SetVerticalDisparityInput(GetParameterFloatImage("bm.initdisp.maps.vmap"));
         }
 
+      if (GetParameterInt("bm.pyramid.levels") > 0)
+        {
+        SetupCoarseToFineSearch(m_LPBlockMatcher.GetPointer(), leftImage, rightImage);
+        }
+
       if (GetParameterInt("bm.subpixel") > 0)
         {
+        m_LPBlockMatcher->SetComputeNeighborMetrics(GetParameterInt("bm.subpixel") == 4);
         m_LPSubPixFilter->SetInputsFromBlockMatchingFilter(m_LPBlockMatcher);
         AddProcess(m_LPSubPixFilter,"Sub-pixel refinement");
         switch (GetParameterInt("bm.subpixel"))
@@ -800,6 +866,8 @@ private:
             break;
           case 3 : m_LPSubPixFilter->SetRefineMethod(LPSubPixelDisparityFilterType::DICHOTOMY);
             break;
+          case 4 : m_LPSubPixFilter->SetRefineMethod(LPSubPixelDisparityFilterType::FAST_DICHOTOMY);
+            break;
           default : break;
           }
         hdispImage = m_LPSubPixFilter->GetHorizontalDisparityOutput();
@@ -863,6 +931,98 @@ private:
       }
   }
 
+  void AfterExecuteAndWriteOutputs() ITK_OVERRIDE
+  {
+    if (m_RangeFilter.IsNotNull())
+      {
+      const double exhaustiveRange = static_cast<double>(
+        GetParameterInt("bm.maxhd") - GetParameterInt("bm.minhd") + 1);
+      otbAppLogINFO("Coarse-to-fine search: " << m_RangeFilter->GetMeanRange()
+                    << " horizontal disparities explored per pixel at full resolution, instead of "
+                    << exhaustiveRange << " (" << 100. * m_RangeFilter->GetMeanRange() / exhaustiveRange << "%)");
+      }
+  }
+
+  /** Estimates the disparities on a pyramid of shrunk images, from the
+   * coarsest level, and bounds the horizontal search of each level with the
+   * disparities found at the previous one. The full resolution matcher gets
+   * the ranges of the finest coarse level. */
+  template <class TBlockMatchingFilter>
+  void SetupCoarseToFineSearch(TBlockMatchingFilter * matcher,
+                               FloatImageType * leftImage,
+                               FloatImageType * rightImage)
+  {
+    const int levels = GetParameterInt("bm.pyramid.levels");
+    const int minhdisp = GetParameterInt("bm.minhd");
+    const int maxhdisp = GetParameterInt("bm.maxhd");
+
+    m_PyramidFilters.clear();
+    m_RangeFilter = ITK_NULLPTR;
+
+    for (int level = levels; level >= 1; --level)
+      {
+      const unsigned int factor = 1U << level;
+
+      ShrinkFilterType::Pointer leftShrink = ShrinkFilterType::New();
+      leftShrink->SetInput(leftImage);
+      leftShrink->SetShrinkFactor(factor);
+      leftShrink->Update();
+
+      ShrinkFilterType::Pointer rightShrink = ShrinkFilterType::New();
+      rightShrink->SetInput(rightImage);
+      rightShrink->SetShrinkFactor(factor);
+      rightShrink->Update();
+
+      const int levelMinHDisp = static_cast<int>(vcl_floor(static_cast<double>(minhdisp) / factor));
+      const int levelMaxHDisp = static_cast<int>(vcl_ceil(static_cast<double>(maxhdisp) / factor));
+
+      typename TBlockMatchingFilter::Pointer coarseMatcher = TBlockMatchingFilter::New();
+      coarseMatcher->SetLeftInput(leftShrink->GetShrunkOutput());
+      coarseMatcher->SetRightInput(rightShrink->GetShrunkOutput());
+      coarseMatcher->SetRadius(matcher->GetRadius());
+      coarseMatcher->GetFunctor() = matcher->GetFunctor();
+      coarseMatcher->SetMinimize(matcher->GetMinimize());
+      coarseMatcher->UseBoxFilterOn();
+      coarseMatcher->SetMinimumHorizontalDisparity(levelMinHDisp);
+      coarseMatcher->SetMaximumHorizontalDisparity(levelMaxHDisp);
+      coarseMatcher->SetMinimumVerticalDisparity(
+        static_cast<int>(vcl_floor(static_cast<double>(matcher->GetMinimumVerticalDisparity()) / factor)));
+      coarseMatcher->SetMaximumVerticalDisparity(
+        static_cast<int>(vcl_ceil(static_cast<double>(matcher->GetMaximumVerticalDisparity()) / factor)));
+
+      // Bound the search with the previous level
+      if (m_RangeFilter.IsNotNull())
+        {
+        m_RangeFilter->SetOutputParametersFromImage(leftShrink->GetShrunkOutput());
+        coarseMatcher->SetMinimumHorizontalDisparityInput(m_RangeFilter->GetMinimumHorizontalDisparityOutput());
+        coarseMatcher->SetMaximumHorizontalDisparityInput(m_RangeFilter->GetMaximumHorizontalDisparityOutput());
+        }
+
+      otbAppLogINFO("Coarse-to-fine search: level 1/" << factor << ", horizontal disparities in ["
+                    << levelMinHDisp << ", " << levelMaxHDisp << "]");
+      coarseMatcher->Update();
+
+      // Ranges for the next level
+      const unsigned int nextFactor = factor / 2;
+      m_RangeFilter = DisparityRangeFilterType::New();
+      m_RangeFilter->SetHorizontalDisparityInput(coarseMatcher->GetHorizontalDisparityOutput());
+      m_RangeFilter->SetRadius(GetParameterInt("bm.pyramid.radius"));
+      m_RangeFilter->SetMargin(GetParameterFloat("bm.pyramid.margin"));
+      m_RangeFilter->SetMinimumHorizontalDisparity(
+        static_cast<int>(vcl_floor(static_cast<double>(minhdisp) / nextFactor)));
+      m_RangeFilter->SetMaximumHorizontalDisparity(
+        static_cast<int>(vcl_ceil(static_cast<double>(maxhdisp) / nextFactor)));
+
+      m_PyramidFilters.push_back(leftShrink.GetPointer());
+      m_PyramidFilters.push_back(rightShrink.GetPointer());
+      m_PyramidFilters.push_back(coarseMatcher.GetPointer());
+      }
+
+    m_RangeFilter->SetOutputParametersFromImage(leftImage);
+    matcher->SetMinimumHorizontalDisparityInput(m_RangeFilter->GetMinimumHorizontalDisparityOutput());
+    matcher->SetMaximumHorizontalDisparityInput(m_RangeFilter->GetMaximumHorizontalDisparityOutput());
+  }
+
   // SSD Block matching filter
   SSDBlockMatchingFilterType::Pointer m_SSDBlockMatcher;
 
@@ -904,6 +1064,12 @@ private:
 
   // Vertical Median filter
   MedianFilterType::Pointer           m_VMedianFilter;
+
+  // Shrink filters and block matchers of the coarse levels
+  std::vector<itk::ProcessObject::Pointer> m_PyramidFilters;
+
+  // Horizontal disparity ranges of the full resolution level
+  DisparityRangeFilterType::Pointer   m_RangeFilter;
 };
 
 }
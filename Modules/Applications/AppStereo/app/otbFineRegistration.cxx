@@ -228,6 +228,13 @@ private:
       "cross-correlation" );
     MandatoryOff("m");
 
+    AddParameter(ParameterType_Empty,  "fast",   "Fast correlation");
+    SetParameterDescription( "fast", "Compute the CC and CCSM metrics with the "
+      "multi-threaded fast correlation, which evaluates all the offsets of the "
+      "exploration window at once (using FFTs when available). Results are the "
+      "same as the default evaluation up to rounding errors." );
+    MandatoryOff("fast");
+
     AddParameter(ParameterType_Float,  "spa",   "SubPixelAccuracy");
     SetParameterDescription( "spa", "Metric extrema location will be refined up"
       " to the given accuracy. Default is 0.01" );
@@ -410,6 +417,11 @@ private:
       itkExceptionMacro("Metric not recognized. Possible choices are: CC, CCSM, MSD, MRSD, MI");
       }
 
+    if(metricId == "CC" || metricId == "CCSM")
+      {
+      m_Registration->SetUseFastCorrelation(IsParameterEnabled("fast"));
+      }
+
     m_XExtractor = VectorImageToImageFilterType::New();
     m_XExtractor->SetInput(m_Registration->GetOutputDisplacementField());
     m_XExtractor->SetIndex(0);
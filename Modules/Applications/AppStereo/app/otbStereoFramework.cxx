@@ -24,6 +24,7 @@
 #include "otbStreamingWarpImageFilter.h"
 #include "otbBandMathImageFilter.h"
 #include "otbSubPixelDisparityImageFilter.h"
+#include "otbSemiGlobalMatchingImageFilter.h"
 #include "otbDisparityMapMedianFilter.h"
 #include "otbDisparityMapToDEMFilter.h"
 #include "otbDisparityMapTo3DFilter.h"
@@ -239,6 +240,11 @@ public:
 
     typedef itk::ImageToImageFilter<FloatImageType,FloatImageType>  FilterType;
 
+    typedef otb::SemiGlobalMatchingImageFilter<FloatImageType,
+                                               FloatImageType,
+                                               FloatImageType,
+                                               FloatImageType> SemiGlobalMatchingFilterType;
+
     typedef otb::ImageToNoDataMaskFilter<FloatImageType,FloatImageType> NoDataMaskFilterType;
 private:
 
@@ -408,6 +414,9 @@ private:
     AddChoice("output.fusionmethod.mean","Mean");
     SetParameterDescription("output.fusionmethod.mean","The cell is filled with"
       " the mean of measured elevation values");
+    AddChoice("output.fusionmethod.median","Median");
+    SetParameterDescription("output.fusionmethod.median","The cell is filled with"
+      " the median of measured elevation values");
     AddChoice("output.fusionmethod.acc", "Accumulator");
     SetParameterDescription("output.fusionmethod.acc", "Accumulator mode. The"
       " cell is filled with the the number of values (for debugging purposes).");
@@ -502,12 +511,40 @@ private:
     SetDefaultParameterFloat("bm.metric.lp.p", 1.0);
     SetMinimumParameterFloatValue("bm.metric.lp.p", 0.0);
 
+    AddChoice("bm.metric.sgm","Semi-Global Matching");
+    SetParameterDescription("bm.metric.sgm","Semi-Global Matching of the census "
+      "transforms of the left and right images, instead of local block-matching. "
+      "The census window radius is the correlation window radius, limited to 3. "
+      "Disparities are refined with a parabola fit of the aggregated costs.");
+
+    AddParameter(ParameterType_Int,"bm.metric.sgm.p1","Small disparity change penalty");
+    SetParameterDescription("bm.metric.sgm.p1", "Penalty of disparity changes of one pixel between neighbors");
+    SetDefaultParameterInt("bm.metric.sgm.p1", 8);
+    SetMinimumParameterIntValue("bm.metric.sgm.p1", 0);
+
+    AddParameter(ParameterType_Int,"bm.metric.sgm.p2","Large disparity change penalty");
+    SetParameterDescription("bm.metric.sgm.p2", "Penalty of disparity changes of more than one pixel between neighbors (must not be lower than p1)");
+    SetDefaultParameterInt("bm.metric.sgm.p2", 32);
+    SetMinimumParameterIntValue("bm.metric.sgm.p2", 0);
+
+    AddParameter(ParameterType_Int,"bm.metric.sgm.paths","Number of aggregation paths");
+    SetParameterDescription("bm.metric.sgm.paths", "Number of paths along which the costs are aggregated (4, 8 or 16)");
+    SetDefaultParameterInt("bm.metric.sgm.paths", 8);
+
     AddParameter(ParameterType_Int,"bm.radius","Correlation window radius (in pixels)");
     SetParameterDescription("bm.radius","The radius of blocks in Block-Matching (in pixels)");
     SetDefaultParameterInt("bm.radius",2);
     SetMinimumParameterIntValue("bm.radius",1);
     MandatoryOff("bm.radius");
 
+    AddParameter(ParameterType_Empty,"bm.boxfilter","Box filter metrics");
+    SetParameterDescription("bm.boxfilter","Compute the ssd, ssdmean, ncc "
+      "and lp metrics with running box sums, whose cost does not depend on "
+      "the window radius. Results may differ from the default computation "
+      "by rounding errors.");
+    MandatoryOff("bm.boxfilter");
+    DisableParameter("bm.boxfilter");
+
     AddParameter(ParameterType_Float,"bm.minhoffset","Minimum altitude offset (in meters)");
     SetParameterDescription("bm.minhoffset","Minimum altitude below the "
       "selected elevation source (in meters)");
@@ -617,6 +654,7 @@ private:
     blockMatcherFilter->SetMaximumHorizontalDisparity(maxDisp);
     blockMatcherFilter->SetMinimumVerticalDisparity(0);
     blockMatcherFilter->SetMaximumVerticalDisparity(0);
+    blockMatcherFilter->SetUseBoxFilter(IsParameterEnabled("bm.boxfilter"));
 
     if (minimize)
       {
@@ -635,6 +673,7 @@ private:
       invBlockMatcherFilter->SetMaximumHorizontalDisparity(-minDisp);
       invBlockMatcherFilter->SetMinimumVerticalDisparity(0);
       invBlockMatcherFilter->SetMaximumVerticalDisparity(0);
+      invBlockMatcherFilter->SetUseBoxFilter(IsParameterEnabled("bm.boxfilter"));
 
       if (minimize)
         {
@@ -650,6 +689,25 @@ private:
   }
 
 
+  void SetSemiGlobalMatchingParameters(SemiGlobalMatchingFilterType * sgmFilter,
+                                       FloatImageType * leftImage, FloatImageType * rightImage,
+                                       FloatImageType * leftMask, FloatImageType * rightMask,
+                                       double minDisp, double maxDisp)
+  {
+    sgmFilter->SetLeftInput(leftImage);
+    sgmFilter->SetRightInput(rightImage);
+    sgmFilter->SetLeftMaskInput(leftMask);
+    sgmFilter->SetRightMaskInput(rightMask);
+    sgmFilter->SetRadius(std::min(this->GetParameterInt("bm.radius"), 3));
+    sgmFilter->SetMinimumHorizontalDisparity(static_cast<int>(vcl_floor(minDisp)));
+    sgmFilter->SetMaximumHorizontalDisparity(static_cast<int>(vcl_ceil(maxDisp)));
+    sgmFilter->SetP1(this->GetParameterInt("bm.metric.sgm.p1"));
+    sgmFilter->SetP2(this->GetParameterInt("bm.metric.sgm.p2"));
+    sgmFilter->SetNumberOfPaths(this->GetParameterInt("bm.metric.sgm.paths"));
+    sgmFilter->SetMaximumMemory(this->GetParameterInt("ram"));
+    sgmFilter->UpdateOutputInformation();
+  }
+
   void DoExecute() ITK_OVERRIDE
   {
     // Setup the DSM Handler
@@ -961,6 +1019,13 @@ private:
       FilterType* blockMatcherFilterPointer = ITK_NULLPTR;
       FilterType* invBlockMatcherFilterPointer = ITK_NULLPTR;
       FilterType* subPixelFilterPointer = ITK_NULLPTR;
+      SemiGlobalMatchingFilterType::Pointer sgmFilter;
+      SemiGlobalMatchingFilterType::Pointer invSgmFilter;
+
+      // Disparities and metric given by the matcher
+      FloatImageType::Pointer rawHDispOutput;
+      FloatImageType::Pointer rawVDispOutput;
+      FloatImageType::Pointer rawMetricOutput;
       BijectionFilterType::Pointer bijectFilter;
 
       // pointer
@@ -1114,11 +1179,50 @@ private:
             finalMaskFilter->GetOutput(),
             minimize, minDisp, maxDisp);
 
+          break;
+        case 4: //SGM
+          otbAppLogINFO(<<"Using Semi-Global Matching.");
+
+          sgmFilter = SemiGlobalMatchingFilterType::New();
+          blockMatcherFilterPointer = sgmFilter.GetPointer();
+          m_Filters.push_back(blockMatcherFilterPointer);
+          this->SetSemiGlobalMatchingParameters(sgmFilter,
+                                                leftResampleFilter->GetOutput(),
+                                                rightResampleFilter->GetOutput(),
+                                                lBandMathFilter->GetOutput(),
+                                                rBandMathFilter->GetOutput(),
+                                                minDisp, maxDisp);
+
+          if (IsParameterEnabled("postproc.bij"))
+            {
+            //Reverse matching
+            invSgmFilter = SemiGlobalMatchingFilterType::New();
+            invBlockMatcherFilterPointer = invSgmFilter.GetPointer();
+            m_Filters.push_back(invBlockMatcherFilterPointer);
+            this->SetSemiGlobalMatchingParameters(invSgmFilter,
+                                                  rightResampleFilter->GetOutput(),
+                                                  leftResampleFilter->GetOutput(),
+                                                  rBandMathFilter->GetOutput(),
+                                                  lBandMathFilter->GetOutput(),
+                                                  -maxDisp, -minDisp);
+            }
+
+          rawHDispOutput = sgmFilter->GetHorizontalDisparityOutput();
+          rawVDispOutput = sgmFilter->GetVerticalDisparityOutput();
+          rawMetricOutput = sgmFilter->GetMetricOutput();
+          minimize = true;
           break;
         default:
           break;
         }
 
+      if (subPixelFilterPointer)
+        {
+        rawHDispOutput = subPixelFilterPointer->GetOutput(0);
+        rawVDispOutput = subPixelFilterPointer->GetOutput(1);
+        rawMetricOutput = subPixelFilterPointer->GetOutput(2);
+        }
+
        if (IsParameterEnabled("postproc.bij"))
         {
         otbAppLogINFO(<<"Using reverse block-matching to filter incoherent disparity values.");
@@ -1147,12 +1251,12 @@ private:
         }
 
 
-     FloatImageType::Pointer hDispOutput = subPixelFilterPointer->GetOutput(0);
+     FloatImageType::Pointer hDispOutput = rawHDispOutput;
       FloatImageType::Pointer finalMaskImage=finalMaskFilter->GetOutput();
       if (IsParameterEnabled("postproc.med"))
         {
         MedianFilterType::Pointer hMedianFilter = MedianFilterType::New();
-        hMedianFilter->SetInput(subPixelFilterPointer->GetOutput(0));
+        hMedianFilter->SetInput(rawHDispOutput);
         hMedianFilter->SetRadius(2);
         hMedianFilter->SetIncoherenceThreshold(2.0);
         hMedianFilter->SetMaskInput(finalMaskFilter->GetOutput());
@@ -1164,7 +1268,7 @@ private:
 
       DisparityTranslateFilter::Pointer disparityTranslateFilter = DisparityTranslateFilter::New();
       disparityTranslateFilter->SetHorizontalDisparityMapInput(hDispOutput);
-      disparityTranslateFilter->SetVerticalDisparityMapInput(subPixelFilterPointer->GetOutput(1));
+      disparityTranslateFilter->SetVerticalDisparityMapInput(rawVDispOutput);
       disparityTranslateFilter->SetInverseEpipolarLeftGrid(leftInverseDisplacement);
       disparityTranslateFilter->SetDirectEpipolarRightGrid(rightDisplacement);
       // disparityTranslateFilter->SetDisparityMaskInput()
@@ -1280,7 +1384,7 @@ private:
       maskCondition << "(hdisp > " << minDisp << ") and (hdisp < " << maxDisp << ") and (mask>0)";
       if (IsParameterEnabled("postproc.metrict"))
         {
-        dispMaskFilter->SetNthInput(2, subPixelFilterPointer->GetOutput(2), "metric");
+        dispMaskFilter->SetNthInput(2, rawMetricOutput, "metric");
         maskCondition << " and (metric ";
         if (minimize == true)
           {
@@ -1354,6 +1458,10 @@ private:
       {
       m_Multi3DMapToDEMFilter ->SetCellFusionMode(otb::CellFusionMode::MEAN);
       }
+    else if(GetParameterString("output.fusionmethod") == "median")
+      {
+      m_Multi3DMapToDEMFilter ->SetCellFusionMode(otb::CellFusionMode::MEDIAN);
+      }
     else if(GetParameterString("output.fusionmethod") == "acc")
       {
       m_Multi3DMapToDEMFilter ->SetCellFusionMode(otb::CellFusionMode::ACC);
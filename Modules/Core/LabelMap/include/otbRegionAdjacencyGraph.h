@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbRegionAdjacencyGraph_h
+#define otbRegionAdjacencyGraph_h
+
+#include "itkDataObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageRegion.h"
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <unordered_map>
+#include <functional>
+
+namespace otb
+{
+
+/** \class RegionAdjacencyGraph
+ *  \brief Compact region adjacency graph of a 2D label image.
+ *
+ *  Regions are the labels of a label image, identified by a consecutive
+ *  region id (in increasing label order). For each region, the graph
+ *  stores its pixel count, the sum of the bands of an associated image
+ *  and its bounding box. Adjacency uses 4-connectivity and is stored in
+ *  compressed sparse row form: the neighbours of a region are sorted and
+ *  contiguous, and each adjacency carries the length of the common border
+ *  in pixel edges. Memory usage is linear in the number of regions and
+ *  adjacencies, and does not depend on the image size.
+ *
+ *  The graph is filled from an Accumulator, which gathers pixels and
+ *  borders in any order (typically one accumulator per thread, merged
+ *  afterwards), see StreamingRegionAdjacencyGraphFilter. It can be
+ *  contracted after region merging, and written to or read from a binary
+ *  file so that object-based processing can be chained without keeping
+ *  the label image in memory.
+ *
+ * \sa StreamingRegionAdjacencyGraphFilter
+ *
+ * \ingroup OTBLabelMap
+ */
+template <class TLabel>
+class ITK_EXPORT RegionAdjacencyGraph : public itk::DataObject
+{
+public:
+  /** Standard class typedefs */
+  typedef RegionAdjacencyGraph          Self;
+  typedef itk::DataObject               Superclass;
+  typedef itk::SmartPointer<Self>       Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(RegionAdjacencyGraph, DataObject);
+
+  typedef TLabel                               LabelType;
+  typedef unsigned int                         RegionIdType;
+  typedef itk::SizeValueType                   CountType;
+  typedef itk::IndexValueType                  IndexValueType;
+  typedef itk::ImageRegion<2>                  RegionType;
+
+  typedef std::vector<LabelType>               LabelVectorType;
+  typedef std::vector<RegionIdType>            RegionIdVectorType;
+  typedef std::vector<CountType>               CountVectorType;
+  typedef std::vector<double>                  SumVectorType;
+  typedef std::vector<IndexValueType>          IndexValueVectorType;
+
+  /** \class Accumulator
+   *  \brief Gathers the regions and borders of a part of a label image.
+   *
+   *  Pixels and borders can be added in any order. An accumulator is not
+   *  thread-safe: use one accumulator per thread and Merge() them.
+   *
+   * \ingroup OTBLabelMap
+   */
+  class Accumulator
+  {
+  public:
+    explicit Accumulator(unsigned int nbBands = 0)
+      : m_NumberOfBands(nbBands)
+    {
+    }
+
+    /** Set the number of bands summed per pixel (clears the accumulator) */
+    void SetNumberOfBands(unsigned int nbBands)
+    {
+      this->Clear();
+      m_NumberOfBands = nbBands;
+    }
+    unsigned int GetNumberOfBands() const
+    {
+      return m_NumberOfBands;
+    }
+
+    /** Add a pixel of a region. bands may be null if there are no bands. */
+    void AddPixel(const LabelType & label, IndexValueType x, IndexValueType y, const double * bands);
+
+    /** Add length pixel edges to the border between two different regions */
+    void AddBorder(const LabelType & a, const LabelType & b, CountType length = 1);
+
+    /** Add the content of another accumulator */
+    void Merge(const Accumulator & other);
+
+    void Clear();
+
+  private:
+    friend class RegionAdjacencyGraph;
+
+    typedef std::pair<LabelType, LabelType> LabelPairType;
+
+    struct LabelPairHash
+    {
+      std::size_t operator()(const LabelPairType & p) const
+      {
+        const std::size_t h = std::hash<LabelType>()(p.first);
+        return h ^ (std::hash<LabelType>()(p.second) + 0x9e3779b9 + (h << 6) + (h >> 2));
+      }
+    };
+
+    typedef std::unordered_map<LabelType, RegionIdType>                  SlotMapType;
+    typedef std::unordered_map<LabelPairType, CountType, LabelPairHash>  BorderMapType;
+
+    /** Slot of a region, created if needed */
+    RegionIdType GetSlot(const LabelType & label);
+
+    unsigned int         m_NumberOfBands;
+    SlotMapType          m_Slots;
+    LabelVectorType      m_Labels;
+    CountVectorType      m_PixelCounts;
+    SumVectorType        m_BandSums;
+    IndexValueVectorType m_BoundingBoxes;
+    BorderMapType        m_Borders;
+  };
+
+  /** Build the graph from an accumulator */
+  void Build(const Accumulator & accumulator);
+
+  /** Build in output the graph of the regions obtained by merging the
+   * regions of this graph: groups[id] is the new id of region id, and
+   * groupLabels[group] the label of the new region group. The output must
+   * be another graph. */
+  void Contract(const RegionIdVectorType & groups, const LabelVectorType & groupLabels, Self * output) const;
+
+  /** Write the graph to a binary file */
+  void Write(const std::string & filename) const;
+
+  /** Read the graph from a binary file written by Write() */
+  void Read(const std::string & filename);
+
+  /** Restore the graph to an empty state */
+  void Initialize() ITK_OVERRIDE;
+
+  RegionIdType GetNumberOfRegions() const
+  {
+    return static_cast<RegionIdType>(m_Labels.size());
+  }
+
+  unsigned int GetNumberOfBands() const
+  {
+    return m_NumberOfBands;
+  }
+
+  /** Number of adjacent region pairs */
+  CountType GetNumberOfEdges() const
+  {
+    return m_Neighbours.size() / 2;
+  }
+
+  /** Id of the region of a label, or GetNumberOfRegions() if not found.
+   * Labels are searched by dichotomy when they increase with the region
+   * ids, which is always the case for a graph built from an accumulator. */
+  RegionIdType GetRegionId(const LabelType & label) const;
+
+  const LabelType & GetLabel(RegionIdType id) const
+  {
+    return m_Labels[id];
+  }
+
+  CountType GetPixelCount(RegionIdType id) const
+  {
+    return m_PixelCounts[id];
+  }
+
+  double GetBandSum(RegionIdType id, unsigned int band) const
+  {
+    return m_BandSums[id * m_NumberOfBands + band];
+  }
+
+  double GetBandMean(RegionIdType id, unsigned int band) const
+  {
+    return m_PixelCounts[id] > 0 ? GetBandSum(id, band) / m_PixelCounts[id] : 0.;
+  }
+
+  /** Bounding box of a region, in index coordinates */
+  RegionType GetBoundingBox(RegionIdType id) const;
+
+  unsigned int GetNumberOfNeighbours(RegionIdType id) const
+  {
+    return static_cast<unsigned int>(m_Offsets[id + 1] - m_Offsets[id]);
+  }
+
+  /** k-th neighbour of a region, in increasing id order */
+  RegionIdType GetNeighbour(RegionIdType id, unsigned int k) const
+  {
+    return m_Neighbours[m_Offsets[id] + k];
+  }
+
+  /** Border length between a region and its k-th neighbour */
+  CountType GetBorderLength(RegionIdType id, unsigned int k) const
+  {
+    return m_BorderLengths[m_Offsets[id] + k];
+  }
+
+  /** Border length between two regions, 0 if they are not adjacent */
+  CountType GetBorderLengthBetween(RegionIdType a, RegionIdType b) const;
+
+  bool AreAdjacent(RegionIdType a, RegionIdType b) const
+  {
+    return this->GetBorderLengthBetween(a, b) > 0;
+  }
+
+protected:
+  RegionAdjacencyGraph();
+  ~RegionAdjacencyGraph() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+private:
+  RegionAdjacencyGraph(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+
+  typedef std::vector<CountType> OffsetVectorType;
+
+  /** Fill the adjacency arrays from a list of (a, b, length) borders, with a != b */
+  struct Border
+  {
+    RegionIdType a;
+    RegionIdType b;
+    CountType    length;
+  };
+  void BuildAdjacency(std::vector<Border> & borders);
+
+  /** Check if the labels increase with the region ids */
+  void UpdateLabelsSorted();
+
+  unsigned int         m_NumberOfBands;
+  LabelVectorType      m_Labels;
+  bool                 m_LabelsSorted;
+  CountVectorType      m_PixelCounts;
+  SumVectorType        m_BandSums;
+  IndexValueVectorType m_BoundingBoxes;
+
+  OffsetVectorType     m_Offsets;
+  RegionIdVectorType   m_Neighbours;
+  CountVectorType      m_BorderLengths;
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbRegionAdjacencyGraph.txx"
+#endif
+
+#endif
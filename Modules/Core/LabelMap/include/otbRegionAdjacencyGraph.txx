@@ -0,0 +1,538 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbRegionAdjacencyGraph_txx
+#define otbRegionAdjacencyGraph_txx
+
+#include "otbRegionAdjacencyGraph.h"
+#include "itkIntTypes.h"
+#include "itkNumericTraits.h"
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+namespace otb
+{
+
+namespace
+{
+const char RegionAdjacencyGraphMagic[8] = {'O', 'T', 'B', 'R', 'A', 'G', '0', '1'};
+}
+
+template <class TLabel>
+typename RegionAdjacencyGraph<TLabel>::RegionIdType
+RegionAdjacencyGraph<TLabel>::Accumulator
+::GetSlot(const LabelType & label)
+{
+  typename SlotMapType::const_iterator it = m_Slots.find(label);
+  if (it != m_Slots.end())
+    {
+    return it->second;
+    }
+
+  const RegionIdType slot = static_cast<RegionIdType>(m_Labels.size());
+  m_Slots.insert(std::make_pair(label, slot));
+  m_Labels.push_back(label);
+  m_PixelCounts.push_back(0);
+  m_BandSums.resize(m_BandSums.size() + m_NumberOfBands, 0.);
+  m_BoundingBoxes.push_back(itk::NumericTraits<IndexValueType>::max());
+  m_BoundingBoxes.push_back(itk::NumericTraits<IndexValueType>::max());
+  m_BoundingBoxes.push_back(itk::NumericTraits<IndexValueType>::NonpositiveMin());
+  m_BoundingBoxes.push_back(itk::NumericTraits<IndexValueType>::NonpositiveMin());
+  return slot;
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>::Accumulator
+::AddPixel(const LabelType & label, IndexValueType x, IndexValueType y, const double * bands)
+{
+  const RegionIdType slot = this->GetSlot(label);
+  ++m_PixelCounts[slot];
+
+  double * sums = m_NumberOfBands > 0 ? &m_BandSums[slot * m_NumberOfBands] : ITK_NULLPTR;
+  for (unsigned int band = 0; band < m_NumberOfBands; ++band)
+    {
+    sums[band] += bands[band];
+    }
+
+  IndexValueType * box = &m_BoundingBoxes[4 * slot];
+  box[0] = std::min(box[0], x);
+  box[1] = std::min(box[1], y);
+  box[2] = std::max(box[2], x);
+  box[3] = std::max(box[3], y);
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>::Accumulator
+::AddBorder(const LabelType & a, const LabelType & b, CountType length)
+{
+  if (a == b)
+    {
+    return;
+    }
+  const LabelPairType key = a < b ? LabelPairType(a, b) : LabelPairType(b, a);
+  m_Borders[key] += length;
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>::Accumulator
+::Merge(const Accumulator & other)
+{
+  if (other.m_NumberOfBands != m_NumberOfBands)
+    {
+    itkGenericExceptionMacro(<< "Can not merge accumulators with different numbers of bands");
+    }
+
+  for (RegionIdType otherSlot = 0; otherSlot < other.m_Labels.size(); ++otherSlot)
+    {
+    const RegionIdType slot = this->GetSlot(other.m_Labels[otherSlot]);
+    m_PixelCounts[slot] += other.m_PixelCounts[otherSlot];
+    for (unsigned int band = 0; band < m_NumberOfBands; ++band)
+      {
+      m_BandSums[slot * m_NumberOfBands + band] += other.m_BandSums[otherSlot * m_NumberOfBands + band];
+      }
+    IndexValueType * box = &m_BoundingBoxes[4 * slot];
+    const IndexValueType * otherBox = &other.m_BoundingBoxes[4 * otherSlot];
+    box[0] = std::min(box[0], otherBox[0]);
+    box[1] = std::min(box[1], otherBox[1]);
+    box[2] = std::max(box[2], otherBox[2]);
+    box[3] = std::max(box[3], otherBox[3]);
+    }
+
+  for (typename BorderMapType::const_iterator it = other.m_Borders.begin(); it != other.m_Borders.end(); ++it)
+    {
+    m_Borders[it->first] += it->second;
+    }
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>::Accumulator
+::Clear()
+{
+  SlotMapType().swap(m_Slots);
+  LabelVectorType().swap(m_Labels);
+  CountVectorType().swap(m_PixelCounts);
+  SumVectorType().swap(m_BandSums);
+  IndexValueVectorType().swap(m_BoundingBoxes);
+  BorderMapType().swap(m_Borders);
+}
+
+template <class TLabel>
+RegionAdjacencyGraph<TLabel>
+::RegionAdjacencyGraph()
+  : m_NumberOfBands(0),
+    m_LabelsSorted(true)
+{
+  m_Offsets.push_back(0);
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>
+::Initialize()
+{
+  Superclass::Initialize();
+  m_NumberOfBands = 0;
+  LabelVectorType().swap(m_Labels);
+  m_LabelsSorted = true;
+  CountVectorType().swap(m_PixelCounts);
+  SumVectorType().swap(m_BandSums);
+  IndexValueVectorType().swap(m_BoundingBoxes);
+  OffsetVectorType(1, 0).swap(m_Offsets);
+  RegionIdVectorType().swap(m_Neighbours);
+  CountVectorType().swap(m_BorderLengths);
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>
+::UpdateLabelsSorted()
+{
+  m_LabelsSorted = true;
+  for (RegionIdType id = 1; id < m_Labels.size() && m_LabelsSorted; ++id)
+    {
+    m_LabelsSorted = m_Labels[id - 1] < m_Labels[id];
+    }
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>
+::BuildAdjacency(std::vector<Border> & borders)
+{
+  const RegionIdType nbRegions = this->GetNumberOfRegions();
+
+  // Scatter both directions of each border in rows
+  OffsetVectorType start(nbRegions + 1, 0);
+  for (typename std::vector<Border>::const_iterator it = borders.begin(); it != borders.end(); ++it)
+    {
+    ++start[it->a + 1];
+    ++start[it->b + 1];
+    }
+  for (RegionIdType id = 0; id < nbRegions; ++id)
+    {
+    start[id + 1] += start[id];
+    }
+
+  typedef std::pair<RegionIdType, CountType> HalfEdgeType;
+  std::vector<HalfEdgeType> halfEdges(start[nbRegions]);
+  OffsetVectorType cursor(start.begin(), start.end() - 1);
+  for (typename std::vector<Border>::const_iterator it = borders.begin(); it != borders.end(); ++it)
+    {
+    halfEdges[cursor[it->a]++] = HalfEdgeType(it->b, it->length);
+    halfEdges[cursor[it->b]++] = HalfEdgeType(it->a, it->length);
+    }
+  std::vector<Border>().swap(borders);
+
+  // Sort each row and merge duplicated neighbours
+  m_Offsets.assign(nbRegions + 1, 0);
+  m_Neighbours.clear();
+  m_BorderLengths.clear();
+  m_Neighbours.reserve(halfEdges.size());
+  m_BorderLengths.reserve(halfEdges.size());
+  for (RegionIdType id = 0; id < nbRegions; ++id)
+    {
+    std::sort(halfEdges.begin() + start[id], halfEdges.begin() + start[id + 1]);
+    for (CountType pos = start[id]; pos < start[id + 1]; ++pos)
+      {
+      if (m_Neighbours.size() > m_Offsets[id] && m_Neighbours.back() == halfEdges[pos].first)
+        {
+        m_BorderLengths.back() += halfEdges[pos].second;
+        }
+      else
+        {
+        m_Neighbours.push_back(halfEdges[pos].first);
+        m_BorderLengths.push_back(halfEdges[pos].second);
+        }
+      }
+    m_Offsets[id + 1] = m_Neighbours.size();
+    }
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>
+::Build(const Accumulator & accumulator)
+{
+  this->Initialize();
+  m_NumberOfBands = accumulator.m_NumberOfBands;
+
+  // Region ids follow the label order
+  const RegionIdType nbRegions = static_cast<RegionIdType>(accumulator.m_Labels.size());
+  std::vector<std::pair<LabelType, RegionIdType> > order(nbRegions);
+  for (RegionIdType slot = 0; slot < nbRegions; ++slot)
+    {
+    order[slot] = std::make_pair(accumulator.m_Labels[slot], slot);
+    }
+  std::sort(order.begin(), order.end());
+
+  RegionIdVectorType idOfSlot(nbRegions);
+  m_Labels.resize(nbRegions);
+  m_PixelCounts.resize(nbRegions);
+  m_BandSums.resize(nbRegions * m_NumberOfBands);
+  m_BoundingBoxes.resize(4 * nbRegions);
+  for (RegionIdType id = 0; id < nbRegions; ++id)
+    {
+    const RegionIdType slot = order[id].second;
+    idOfSlot[slot] = id;
+    m_Labels[id] = order[id].first;
+    m_PixelCounts[id] = accumulator.m_PixelCounts[slot];
+    std::copy(accumulator.m_BandSums.begin() + slot * m_NumberOfBands,
+              accumulator.m_BandSums.begin() + (slot + 1) * m_NumberOfBands,
+              m_BandSums.begin() + id * m_NumberOfBands);
+    std::copy(accumulator.m_BoundingBoxes.begin() + 4 * slot,
+              accumulator.m_BoundingBoxes.begin() + 4 * (slot + 1),
+              m_BoundingBoxes.begin() + 4 * id);
+    }
+  m_LabelsSorted = true;
+
+  std::vector<Border> borders;
+  borders.reserve(accumulator.m_Borders.size());
+  for (typename Accumulator::BorderMapType::const_iterator it = accumulator.m_Borders.begin();
+       it != accumulator.m_Borders.end(); ++it)
+    {
+    typename Accumulator::SlotMapType::const_iterator slotA = accumulator.m_Slots.find(it->first.first);
+    typename Accumulator::SlotMapType::const_iterator slotB = accumulator.m_Slots.find(it->first.second);
+    if (slotA == accumulator.m_Slots.end() || slotB == accumulator.m_Slots.end())
+      {
+      itkExceptionMacro(<< "Border between labels " << it->first.first << " and " << it->first.second
+                        << " refers to a region without pixels");
+      }
+    Border border;
+    border.a = idOfSlot[slotA->second];
+    border.b = idOfSlot[slotB->second];
+    border.length = it->second;
+    borders.push_back(border);
+    }
+  this->BuildAdjacency(borders);
+  this->Modified();
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>
+::Contract(const RegionIdVectorType & groups, const LabelVectorType & groupLabels, Self * output) const
+{
+  const RegionIdType nbGroups = static_cast<RegionIdType>(groupLabels.size());
+  if (output == this)
+    {
+    itkExceptionMacro(<< "A graph can not be contracted in place");
+    }
+  if (groups.size() != m_Labels.size())
+    {
+    itkExceptionMacro(<< "Expected " << m_Labels.size() << " region groups, got " << groups.size());
+    }
+
+  output->Initialize();
+  output->m_NumberOfBands = m_NumberOfBands;
+  output->m_Labels = groupLabels;
+  output->m_PixelCounts.assign(nbGroups, 0);
+  output->m_BandSums.assign(nbGroups * m_NumberOfBands, 0.);
+  output->m_BoundingBoxes.resize(4 * nbGroups);
+  for (RegionIdType group = 0; group < nbGroups; ++group)
+    {
+    output->m_BoundingBoxes[4 * group] = itk::NumericTraits<IndexValueType>::max();
+    output->m_BoundingBoxes[4 * group + 1] = itk::NumericTraits<IndexValueType>::max();
+    output->m_BoundingBoxes[4 * group + 2] = itk::NumericTraits<IndexValueType>::NonpositiveMin();
+    output->m_BoundingBoxes[4 * group + 3] = itk::NumericTraits<IndexValueType>::NonpositiveMin();
+    }
+
+  std::vector<Border> borders;
+  for (RegionIdType id = 0; id < m_Labels.size(); ++id)
+    {
+    const RegionIdType group = groups[id];
+    if (group >= nbGroups)
+      {
+      itkExceptionMacro(<< "Invalid group " << group << " for region " << id);
+      }
+    output->m_PixelCounts[group] += m_PixelCounts[id];
+    for (unsigned int band = 0; band < m_NumberOfBands; ++band)
+      {
+      output->m_BandSums[group * m_NumberOfBands + band] += m_BandSums[id * m_NumberOfBands + band];
+      }
+    IndexValueType * box = &output->m_BoundingBoxes[4 * group];
+    const IndexValueType * regionBox = &m_BoundingBoxes[4 * id];
+    box[0] = std::min(box[0], regionBox[0]);
+    box[1] = std::min(box[1], regionBox[1]);
+    box[2] = std::max(box[2], regionBox[2]);
+    box[3] = std::max(box[3], regionBox[3]);
+
+    for (CountType pos = m_Offsets[id]; pos < m_Offsets[id + 1]; ++pos)
+      {
+      const RegionIdType neighbourGroup = groups[m_Neighbours[pos]];
+      if (m_Neighbours[pos] > id && neighbourGroup != group)
+        {
+        Border border;
+        border.a = group;
+        border.b = neighbourGroup;
+        border.length = m_BorderLengths[pos];
+        borders.push_back(border);
+        }
+      }
+    }
+  output->UpdateLabelsSorted();
+  output->BuildAdjacency(borders);
+  output->Modified();
+}
+
+template <class TLabel>
+typename RegionAdjacencyGraph<TLabel>::RegionIdType
+RegionAdjacencyGraph<TLabel>
+::GetRegionId(const LabelType & label) const
+{
+  if (m_LabelsSorted)
+    {
+    typename LabelVectorType::const_iterator it = std::lower_bound(m_Labels.begin(), m_Labels.end(), label);
+    if (it != m_Labels.end() && *it == label)
+      {
+      return static_cast<RegionIdType>(it - m_Labels.begin());
+      }
+    return this->GetNumberOfRegions();
+    }
+  return static_cast<RegionIdType>(std::find(m_Labels.begin(), m_Labels.end(), label) - m_Labels.begin());
+}
+
+template <class TLabel>
+typename RegionAdjacencyGraph<TLabel>::RegionType
+RegionAdjacencyGraph<TLabel>
+::GetBoundingBox(RegionIdType id) const
+{
+  RegionType region;
+  const IndexValueType * box = &m_BoundingBoxes[4 * id];
+  if (box[2] < box[0])
+    {
+    return region;
+    }
+  typename RegionType::IndexType index;
+  typename RegionType::SizeType size;
+  index[0] = box[0];
+  index[1] = box[1];
+  size[0] = box[2] - box[0] + 1;
+  size[1] = box[3] - box[1] + 1;
+  region.SetIndex(index);
+  region.SetSize(size);
+  return region;
+}
+
+template <class TLabel>
+typename RegionAdjacencyGraph<TLabel>::CountType
+RegionAdjacencyGraph<TLabel>
+::GetBorderLengthBetween(RegionIdType a, RegionIdType b) const
+{
+  typename RegionIdVectorType::const_iterator first = m_Neighbours.begin() + m_Offsets[a];
+  typename RegionIdVectorType::const_iterator last = m_Neighbours.begin() + m_Offsets[a + 1];
+  typename RegionIdVectorType::const_iterator it = std::lower_bound(first, last, b);
+  if (it != last && *it == b)
+    {
+    return m_BorderLengths[it - m_Neighbours.begin()];
+    }
+  return 0;
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>
+::Write(const std::string & filename) const
+{
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!file)
+    {
+    itkExceptionMacro(<< "Unable to open " << filename << " for writing");
+    }
+
+  const itk::uint32_t labelSize = sizeof(LabelType);
+  const itk::uint32_t nbBands = m_NumberOfBands;
+  const itk::uint64_t nbRegions = m_Labels.size();
+  const itk::uint64_t nbHalfEdges = m_Neighbours.size();
+
+  file.write(RegionAdjacencyGraphMagic, sizeof(RegionAdjacencyGraphMagic));
+  file.write(reinterpret_cast<const char *>(&labelSize), sizeof(labelSize));
+  file.write(reinterpret_cast<const char *>(&nbBands), sizeof(nbBands));
+  file.write(reinterpret_cast<const char *>(&nbRegions), sizeof(nbRegions));
+  file.write(reinterpret_cast<const char *>(&nbHalfEdges), sizeof(nbHalfEdges));
+
+  if (nbRegions > 0)
+    {
+    file.write(reinterpret_cast<const char *>(&m_Labels[0]), nbRegions * sizeof(LabelType));
+    file.write(reinterpret_cast<const char *>(&m_PixelCounts[0]), nbRegions * sizeof(CountType));
+    if (nbBands > 0)
+      {
+      file.write(reinterpret_cast<const char *>(&m_BandSums[0]), nbRegions * nbBands * sizeof(double));
+      }
+    file.write(reinterpret_cast<const char *>(&m_BoundingBoxes[0]), 4 * nbRegions * sizeof(IndexValueType));
+    file.write(reinterpret_cast<const char *>(&m_Offsets[0]), (nbRegions + 1) * sizeof(CountType));
+    }
+  if (nbHalfEdges > 0)
+    {
+    file.write(reinterpret_cast<const char *>(&m_Neighbours[0]), nbHalfEdges * sizeof(RegionIdType));
+    file.write(reinterpret_cast<const char *>(&m_BorderLengths[0]), nbHalfEdges * sizeof(CountType));
+    }
+
+  if (!file)
+    {
+    itkExceptionMacro(<< "Error while writing " << filename);
+    }
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>
+::Read(const std::string & filename)
+{
+  std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!file)
+    {
+    itkExceptionMacro(<< "Unable to open " << filename << " for reading");
+    }
+
+  char magic[sizeof(RegionAdjacencyGraphMagic)];
+  itk::uint32_t labelSize = 0;
+  itk::uint32_t nbBands = 0;
+  itk::uint64_t nbRegions = 0;
+  itk::uint64_t nbHalfEdges = 0;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char *>(&labelSize), sizeof(labelSize));
+  file.read(reinterpret_cast<char *>(&nbBands), sizeof(nbBands));
+  file.read(reinterpret_cast<char *>(&nbRegions), sizeof(nbRegions));
+  file.read(reinterpret_cast<char *>(&nbHalfEdges), sizeof(nbHalfEdges));
+  if (!file || std::memcmp(magic, RegionAdjacencyGraphMagic, sizeof(magic)) != 0)
+    {
+    itkExceptionMacro(<< filename << " is not a region adjacency graph file");
+    }
+  if (labelSize != sizeof(LabelType))
+    {
+    itkExceptionMacro(<< filename << " has labels of " << labelSize << " bytes instead of " << sizeof(LabelType));
+    }
+
+  this->Initialize();
+  m_NumberOfBands = nbBands;
+  m_Labels.resize(nbRegions);
+  m_PixelCounts.resize(nbRegions);
+  m_BandSums.resize(nbRegions * nbBands);
+  m_BoundingBoxes.resize(4 * nbRegions);
+  m_Offsets.resize(nbRegions + 1);
+  m_Neighbours.resize(nbHalfEdges);
+  m_BorderLengths.resize(nbHalfEdges);
+
+  if (nbRegions > 0)
+    {
+    file.read(reinterpret_cast<char *>(&m_Labels[0]), nbRegions * sizeof(LabelType));
+    file.read(reinterpret_cast<char *>(&m_PixelCounts[0]), nbRegions * sizeof(CountType));
+    if (nbBands > 0)
+      {
+      file.read(reinterpret_cast<char *>(&m_BandSums[0]), nbRegions * nbBands * sizeof(double));
+      }
+    file.read(reinterpret_cast<char *>(&m_BoundingBoxes[0]), 4 * nbRegions * sizeof(IndexValueType));
+    file.read(reinterpret_cast<char *>(&m_Offsets[0]), (nbRegions + 1) * sizeof(CountType));
+    }
+  if (nbHalfEdges > 0)
+    {
+    file.read(reinterpret_cast<char *>(&m_Neighbours[0]), nbHalfEdges * sizeof(RegionIdType));
+    file.read(reinterpret_cast<char *>(&m_BorderLengths[0]), nbHalfEdges * sizeof(CountType));
+    }
+
+  if (!file || m_Offsets.back() != nbHalfEdges)
+    {
+    this->Initialize();
+    itkExceptionMacro(<< filename << " is truncated or corrupted");
+    }
+  this->UpdateLabelsSorted();
+  this->Modified();
+}
+
+template <class TLabel>
+void
+RegionAdjacencyGraph<TLabel>
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfRegions: " << this->GetNumberOfRegions() << std::endl;
+  os << indent << "NumberOfEdges: " << this->GetNumberOfEdges() << std::endl;
+  os << indent << "NumberOfBands: " << m_NumberOfBands << std::endl;
+}
+
+} // end namespace otb
+
+#endif
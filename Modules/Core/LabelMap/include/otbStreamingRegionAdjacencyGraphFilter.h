@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbStreamingRegionAdjacencyGraphFilter_h
+#define otbStreamingRegionAdjacencyGraphFilter_h
+
+#include "otbPersistentImageFilter.h"
+#include "otbPersistentFilterStreamingDecorator.h"
+#include "otbRegionAdjacencyGraph.h"
+
+namespace otb
+{
+
+/** \class PersistentRegionAdjacencyGraphFilter
+ * \brief Accumulate the region adjacency graph of a label image over the streamed regions.
+ *
+ * For each label of the input label image, this filter gathers the pixel
+ * count, the bounding box, the sum of each band of the optional input image
+ * set with SetInputImage(), and the length of the borders with the other
+ * labels (4-connectivity). Each thread accumulates the pixels of its region
+ * and the borders with its left and top neighbours, so the input label
+ * image is requested with a margin of one pixel on these sides.
+ *
+ * Pixels with the BackgroundValue label are skipped when IgnoreBackground
+ * is on. Synthetize() merges the thread accumulators and builds the
+ * RegionAdjacencyGraph returned by GetGraph().
+ *
+ * \sa RegionAdjacencyGraph
+ * \sa StreamingRegionAdjacencyGraphFilter
+ * \ingroup Streamed
+ * \ingroup Multithreaded
+ *
+ * \ingroup OTBLabelMap
+ */
+template <class TLabelImage, class TInputImage = TLabelImage>
+class ITK_EXPORT PersistentRegionAdjacencyGraphFilter :
+  public PersistentImageFilter<TLabelImage, TLabelImage>
+{
+public:
+  /** Standard Self typedef */
+  typedef PersistentRegionAdjacencyGraphFilter            Self;
+  typedef PersistentImageFilter<TLabelImage, TLabelImage> Superclass;
+  typedef itk::SmartPointer<Self>                         Pointer;
+  typedef itk::SmartPointer<const Self>                   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(PersistentRegionAdjacencyGraphFilter, PersistentImageFilter);
+
+  /** Image related typedefs. */
+  typedef TLabelImage                              LabelImageType;
+  typedef typename LabelImageType::PixelType       LabelType;
+  typedef typename LabelImageType::RegionType      RegionType;
+  typedef typename LabelImageType::IndexType       IndexType;
+  typedef typename LabelImageType::SizeType        SizeType;
+  typedef TInputImage                              InputImageType;
+  typedef typename InputImageType::PixelType       InputPixelType;
+
+  typedef RegionAdjacencyGraph<LabelType>          GraphType;
+  typedef typename GraphType::Accumulator          AccumulatorType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TLabelImage::ImageDimension);
+
+  /** Smart Pointer type to a DataObject. */
+  typedef typename itk::DataObject::Pointer                  DataObjectPointer;
+  typedef itk::ProcessObject::DataObjectPointerArraySizeType DataObjectPointerArraySizeType;
+
+  /** Set/Get the image whose bands are summed per region (optional) */
+  void SetInputImage(const InputImageType * image);
+  const InputImageType * GetInputImage() const;
+
+  /** Set/Get the label of the pixels which belong to no region */
+  itkSetMacro(BackgroundValue, LabelType);
+  itkGetConstMacro(BackgroundValue, LabelType);
+
+  /** Set/Get the flag telling if background pixels are skipped */
+  itkSetMacro(IgnoreBackground, bool);
+  itkGetConstMacro(IgnoreBackground, bool);
+  itkBooleanMacro(IgnoreBackground);
+
+  /** Return the computed graph (valid after Synthetize()) */
+  GraphType * GetGraph();
+  const GraphType * GetGraph() const;
+
+  /** Make a DataObject of the correct type to be used as the specified
+   * output. */
+  DataObjectPointer MakeOutput(DataObjectPointerArraySizeType idx) ITK_OVERRIDE;
+  using Superclass::MakeOutput;
+
+  void AllocateOutputs() ITK_OVERRIDE;
+
+  void GenerateOutputInformation() ITK_OVERRIDE;
+
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  void Synthetize(void) ITK_OVERRIDE;
+
+  void Reset(void) ITK_OVERRIDE;
+
+protected:
+  PersistentRegionAdjacencyGraphFilter();
+  ~PersistentRegionAdjacencyGraphFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Multi-thread version GenerateData. */
+  void ThreadedGenerateData(const RegionType& outputRegionForThread,
+                            itk::ThreadIdType threadId) ITK_OVERRIDE;
+
+private:
+  PersistentRegionAdjacencyGraphFilter(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+
+  bool IsRegion(const LabelType & label) const
+  {
+    return !m_IgnoreBackground || label != m_BackgroundValue;
+  }
+
+  LabelType                    m_BackgroundValue;
+  bool                         m_IgnoreBackground;
+  std::vector<AccumulatorType> m_ThreadAccumulators;
+}; // end of class PersistentRegionAdjacencyGraphFilter
+
+/** \class StreamingRegionAdjacencyGraphFilter
+ * \brief This class streams a label image through the PersistentRegionAdjacencyGraphFilter.
+ *
+ * It builds the region adjacency graph of a label image of any size in one
+ * streaming pass:
+ *
+ * \code
+ * typedef otb::StreamingRegionAdjacencyGraphFilter<LabelImageType, VectorImageType> RAGFilterType;
+ * RAGFilterType::Pointer rag = RAGFilterType::New();
+ * rag->SetInput(labelReader->GetOutput());
+ * rag->SetInputImage(imageReader->GetOutput());
+ * rag->Update();
+ * rag->GetGraph()->Write("graph.rag");
+ * \endcode
+ *
+ * \sa PersistentRegionAdjacencyGraphFilter
+ * \sa RegionAdjacencyGraph
+ * \sa PersistentFilterStreamingDecorator
+ * \ingroup Streamed
+ * \ingroup Multithreaded
+ *
+ * \ingroup OTBLabelMap
+ */
+template <class TLabelImage, class TInputImage = TLabelImage>
+class ITK_EXPORT StreamingRegionAdjacencyGraphFilter :
+  public PersistentFilterStreamingDecorator<PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage> >
+{
+public:
+  /** Standard Self typedef */
+  typedef StreamingRegionAdjacencyGraphFilter Self;
+  typedef PersistentFilterStreamingDecorator
+  <PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage> > Superclass;
+  typedef itk::SmartPointer<Self>       Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+
+  /** Type macro */
+  itkNewMacro(Self);
+
+  /** Creation through object factory macro */
+  itkTypeMacro(StreamingRegionAdjacencyGraphFilter, PersistentFilterStreamingDecorator);
+
+  typedef typename Superclass::FilterType    GraphFilterType;
+  typedef typename GraphFilterType::GraphType GraphType;
+  typedef TLabelImage                        LabelImageType;
+  typedef TInputImage                        InputImageType;
+
+  using Superclass::SetInput;
+  void SetInput(const LabelImageType * input)
+  {
+    this->GetFilter()->SetInput(input);
+  }
+  const LabelImageType * GetInput()
+  {
+    return this->GetFilter()->GetInput();
+  }
+
+  void SetInputImage(const InputImageType * image)
+  {
+    this->GetFilter()->SetInputImage(image);
+  }
+  const InputImageType * GetInputImage()
+  {
+    return this->GetFilter()->GetInputImage();
+  }
+
+  /** Return the computed graph */
+  GraphType * GetGraph()
+  {
+    return this->GetFilter()->GetGraph();
+  }
+  const GraphType * GetGraph() const
+  {
+    return this->GetFilter()->GetGraph();
+  }
+
+protected:
+  /** Constructor */
+  StreamingRegionAdjacencyGraphFilter() {}
+  /** Destructor */
+  ~StreamingRegionAdjacencyGraphFilter() ITK_OVERRIDE {}
+
+private:
+  StreamingRegionAdjacencyGraphFilter(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbStreamingRegionAdjacencyGraphFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbStreamingRegionAdjacencyGraphFilter_txx
+#define otbStreamingRegionAdjacencyGraphFilter_txx
+
+#include "otbStreamingRegionAdjacencyGraphFilter.h"
+#include "itkImageScanlineConstIterator.h"
+#include "itkDefaultConvertPixelTraits.h"
+#include "itkProgressReporter.h"
+#include "itkNumericTraits.h"
+
+namespace otb
+{
+
+template <class TLabelImage, class TInputImage>
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::PersistentRegionAdjacencyGraphFilter()
+  : m_BackgroundValue(itk::NumericTraits<LabelType>::ZeroValue()),
+    m_IgnoreBackground(false)
+{
+  // first output is a copy of the image, DataObject created by
+  // superclass
+  this->itk::ProcessObject::SetNthOutput(1, this->MakeOutput(1));
+}
+
+template <class TLabelImage, class TInputImage>
+typename itk::DataObject::Pointer
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::MakeOutput(DataObjectPointerArraySizeType output)
+{
+  itk::DataObject::Pointer ret;
+  switch (output)
+    {
+    case 0:
+      ret = static_cast<itk::DataObject*>(TLabelImage::New().GetPointer());
+      break;
+    case 1:
+      ret = static_cast<itk::DataObject*>(GraphType::New().GetPointer());
+      break;
+    }
+  return ret;
+}
+
+template <class TLabelImage, class TInputImage>
+void
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::SetInputImage(const InputImageType * image)
+{
+  // Process object is not const-correct so the const casting is required.
+  this->SetNthInput(1, const_cast<InputImageType *>(image));
+}
+
+template <class TLabelImage, class TInputImage>
+const typename PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>::InputImageType *
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::GetInputImage() const
+{
+  if (this->GetNumberOfInputs() < 2)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const InputImageType *>(this->itk::ProcessObject::GetInput(1));
+}
+
+template <class TLabelImage, class TInputImage>
+typename PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>::GraphType *
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::GetGraph()
+{
+  return static_cast<GraphType *>(this->itk::ProcessObject::GetOutput(1));
+}
+
+template <class TLabelImage, class TInputImage>
+const typename PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>::GraphType *
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::GetGraph() const
+{
+  return static_cast<const GraphType *>(this->itk::ProcessObject::GetOutput(1));
+}
+
+template <class TLabelImage, class TInputImage>
+void
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+  if (this->GetInput())
+    {
+    this->GetOutput()->CopyInformation(this->GetInput());
+    this->GetOutput()->SetLargestPossibleRegion(this->GetInput()->GetLargestPossibleRegion());
+
+    if (this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() == 0)
+      {
+      this->GetOutput()->SetRequestedRegion(this->GetOutput()->GetLargestPossibleRegion());
+      }
+    }
+}
+
+template <class TLabelImage, class TInputImage>
+void
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::GenerateInputRequestedRegion()
+{
+  LabelImageType * labelImage = const_cast<LabelImageType *>(this->GetInput());
+  if (!labelImage)
+    {
+    return;
+    }
+
+  // Borders are accumulated with the left and top neighbours
+  RegionType requested = this->GetOutput()->GetRequestedRegion();
+  RegionType labelRequested = requested;
+  IndexType index = labelRequested.GetIndex();
+  SizeType size = labelRequested.GetSize();
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+    {
+    index[dim] -= 1;
+    size[dim] += 1;
+    }
+  labelRequested.SetIndex(index);
+  labelRequested.SetSize(size);
+  labelRequested.Crop(labelImage->GetLargestPossibleRegion());
+  labelImage->SetRequestedRegion(labelRequested);
+
+  InputImageType * image = const_cast<InputImageType *>(this->GetInputImage());
+  if (image)
+    {
+    image->SetRequestedRegion(requested);
+    }
+}
+
+template <class TLabelImage, class TInputImage>
+void
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::AllocateOutputs()
+{
+  // Nothing that needs to be allocated: the output image of this filter is
+  // not intended to be used.
+}
+
+template <class TLabelImage, class TInputImage>
+void
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::Reset()
+{
+  m_ThreadAccumulators.clear();
+}
+
+template <class TLabelImage, class TInputImage>
+void
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::BeforeThreadedGenerateData()
+{
+  // The number of bands is only known once the pipeline information is up to date
+  if (m_ThreadAccumulators.empty())
+    {
+    const unsigned int nbBands = this->GetInputImage() ? this->GetInputImage()->GetNumberOfComponentsPerPixel() : 0;
+    m_ThreadAccumulators.assign(this->GetNumberOfThreads(), AccumulatorType(nbBands));
+    }
+}
+
+template <class TLabelImage, class TInputImage>
+void
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::Synthetize()
+{
+  if (m_ThreadAccumulators.empty())
+    {
+    this->GetGraph()->Initialize();
+    return;
+    }
+
+  for (unsigned int threadId = 1; threadId < m_ThreadAccumulators.size(); ++threadId)
+    {
+    m_ThreadAccumulators[0].Merge(m_ThreadAccumulators[threadId]);
+    m_ThreadAccumulators[threadId].Clear();
+    }
+  this->GetGraph()->Build(m_ThreadAccumulators[0]);
+  m_ThreadAccumulators.clear();
+}
+
+template <class TLabelImage, class TInputImage>
+void
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::ThreadedGenerateData(const RegionType& outputRegionForThread, itk::ThreadIdType threadId)
+{
+  typedef itk::DefaultConvertPixelTraits<InputPixelType> PixelTraitsType;
+
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetSize()[1]);
+
+  const LabelImageType * labelImage = this->GetInput();
+  const InputImageType * image = this->GetInputImage();
+  AccumulatorType & accumulator = m_ThreadAccumulators[threadId];
+  const unsigned int nbBands = accumulator.GetNumberOfBands();
+
+  // Region with the left and top neighbours of the thread region
+  RegionType extended = outputRegionForThread;
+  IndexType index = extended.GetIndex();
+  SizeType size = extended.GetSize();
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+    {
+    index[dim] -= 1;
+    size[dim] += 1;
+    }
+  extended.SetIndex(index);
+  extended.SetSize(size);
+  extended.Crop(labelImage->GetLargestPossibleRegion());
+
+  const unsigned int first = extended.GetIndex()[0] < outputRegionForThread.GetIndex()[0] ? 1 : 0;
+  const bool hasTopRow = extended.GetIndex()[1] < outputRegionForThread.GetIndex()[1];
+  const unsigned int width = extended.GetSize()[0];
+
+  std::vector<LabelType> previousLine(width);
+  std::vector<LabelType> currentLine(width);
+  std::vector<double>    bands(nbBands);
+
+  itk::ImageScanlineConstIterator<LabelImageType> labelIt(labelImage, extended);
+  itk::ImageScanlineConstIterator<InputImageType> imageIt;
+  if (image)
+    {
+    imageIt = itk::ImageScanlineConstIterator<InputImageType>(image, outputRegionForThread);
+    imageIt.GoToBegin();
+    }
+
+  typename IndexType::IndexValueType y = extended.GetIndex()[1];
+  for (labelIt.GoToBegin(); !labelIt.IsAtEnd(); labelIt.NextLine(), ++y)
+    {
+    for (unsigned int i = 0; !labelIt.IsAtEndOfLine(); ++labelIt, ++i)
+      {
+      currentLine[i] = labelIt.Get();
+      }
+
+    // The top neighbour row only provides the previous line
+    if (!(hasTopRow && y == extended.GetIndex()[1]))
+      {
+      for (unsigned int i = first; i < width; ++i)
+        {
+        const LabelType & label = currentLine[i];
+        if (image)
+          {
+          const InputPixelType & pixel = imageIt.Get();
+          for (unsigned int band = 0; band < nbBands; ++band)
+            {
+            bands[band] = static_cast<double>(PixelTraitsType::GetNthComponent(band, pixel));
+            }
+          ++imageIt;
+          }
+
+        if (!this->IsRegion(label))
+          {
+          continue;
+          }
+        accumulator.AddPixel(label, extended.GetIndex()[0] + i, y, nbBands > 0 ? &bands[0] : ITK_NULLPTR);
+
+        if (i > 0 && currentLine[i - 1] != label && this->IsRegion(currentLine[i - 1]))
+          {
+          accumulator.AddBorder(currentLine[i - 1], label);
+          }
+        if (y > extended.GetIndex()[1] && previousLine[i] != label && this->IsRegion(previousLine[i]))
+          {
+          accumulator.AddBorder(previousLine[i], label);
+          }
+        }
+      if (image)
+        {
+        imageIt.NextLine();
+        }
+      progress.CompletedPixel();
+      }
+
+    previousLine.swap(currentLine);
+    }
+}
+
+template <class TLabelImage, class TInputImage>
+void
+PersistentRegionAdjacencyGraphFilter<TLabelImage, TInputImage>
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "BackgroundValue: " << m_BackgroundValue << std::endl;
+  os << indent << "IgnoreBackground: " << m_IgnoreBackground << std::endl;
+}
+
+} // end namespace otb
+
+#endif
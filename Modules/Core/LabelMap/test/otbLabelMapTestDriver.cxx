@@ -47,4 +47,5 @@ void RegisterTests()
   REGISTER_TEST(otbShapeAttributesLabelMapFilterNew);
   REGISTER_TEST(otbBandsStatisticsAttributesLabelMapFilter);
   REGISTER_TEST(otbBandsStatisticsAttributesLabelMapFilterNew);
+  REGISTER_TEST(otbStreamingRegionAdjacencyGraphFilter);
 }
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbStreamingRegionAdjacencyGraphFilter.h"
+#include "otbImage.h"
+#include "otbVectorImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <map>
+
+typedef unsigned int                                LabelType;
+typedef otb::Image<LabelType, 2>                    LabelImageType;
+typedef otb::VectorImage<float, 2>                  VectorImageType;
+typedef otb::StreamingRegionAdjacencyGraphFilter
+<LabelImageType, VectorImageType>                   FilterType;
+typedef FilterType::GraphType                       GraphType;
+
+int otbStreamingRegionAdjacencyGraphFilter(int argc, char * argv[])
+{
+  if (argc != 3)
+    {
+    std::cerr << "Usage: " << argv[0] << " nbDivisions outputGraphFile" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const unsigned int nbDivisions = atoi(argv[1]);
+  const char * graphFileName = argv[2];
+
+  // Random blocky label image with a two bands image
+  LabelImageType::SizeType size;
+  size[0] = 123;
+  size[1] = 97;
+  LabelImageType::RegionType region;
+  region.SetSize(size);
+
+  LabelImageType::Pointer labels = LabelImageType::New();
+  labels->SetRegions(region);
+  labels->Allocate();
+  VectorImageType::Pointer image = VectorImageType::New();
+  image->SetRegions(region);
+  image->SetNumberOfComponentsPerPixel(2);
+  image->Allocate();
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(42);
+
+  itk::ImageRegionIteratorWithIndex<LabelImageType> labelIt(labels, region);
+  itk::ImageRegionIteratorWithIndex<VectorImageType> imageIt(image, region);
+  VectorImageType::PixelType pixel(2);
+  for (labelIt.GoToBegin(), imageIt.GoToBegin(); !labelIt.IsAtEnd(); ++labelIt, ++imageIt)
+    {
+    const LabelImageType::IndexType & index = labelIt.GetIndex();
+    LabelType label = 1 + (index[0] / 7) * 3 + (index[1] / 11) * 57;
+    if (generator->GetUniformVariate(0., 1.) < 0.1)
+      {
+      label = 1 + generator->GetIntegerVariate(200);
+      }
+    labelIt.Set(label);
+    pixel[0] = generator->GetUniformVariate(0., 100.);
+    pixel[1] = static_cast<float>(index[0]);
+    imageIt.Set(pixel);
+    }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(labels);
+  filter->SetInputImage(image);
+  filter->GetStreamer()->SetNumberOfDivisionsStrippedStreaming(nbDivisions);
+  filter->Update();
+  GraphType * graph = filter->GetGraph();
+
+  // Brute force reference
+  std::map<LabelType, unsigned long> counts;
+  std::map<LabelType, double> sums;
+  std::map<std::pair<LabelType, LabelType>, unsigned long> borders;
+  for (labelIt.GoToBegin(), imageIt.GoToBegin(); !labelIt.IsAtEnd(); ++labelIt, ++imageIt)
+    {
+    const LabelType label = labelIt.Get();
+    counts[label]++;
+    sums[label] += imageIt.Get()[0];
+    for (unsigned int dim = 0; dim < 2; ++dim)
+      {
+      LabelImageType::IndexType neighbour = labelIt.GetIndex();
+      neighbour[dim]++;
+      if (region.IsInside(neighbour) && labels->GetPixel(neighbour) != label)
+        {
+        const LabelType other = labels->GetPixel(neighbour);
+        borders[std::make_pair(std::min(label, other), std::max(label, other))]++;
+        }
+      }
+    }
+
+  if (graph->GetNumberOfRegions() != counts.size() || graph->GetNumberOfEdges() != borders.size())
+    {
+    std::cerr << "Wrong graph size: " << graph->GetNumberOfRegions() << " regions and "
+              << graph->GetNumberOfEdges() << " edges instead of " << counts.size() << " and "
+              << borders.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (std::map<LabelType, unsigned long>::const_iterator it = counts.begin(); it != counts.end(); ++it)
+    {
+    const GraphType::RegionIdType id = graph->GetRegionId(it->first);
+    if (id == graph->GetNumberOfRegions() || graph->GetPixelCount(id) != it->second
+        || std::abs(graph->GetBandSum(id, 0) - sums[it->first]) > 1e-6 * sums[it->first])
+      {
+      std::cerr << "Wrong statistics for label " << it->first << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  for (std::map<std::pair<LabelType, LabelType>, unsigned long>::const_iterator it = borders.begin();
+       it != borders.end(); ++it)
+    {
+    const GraphType::RegionIdType a = graph->GetRegionId(it->first.first);
+    const GraphType::RegionIdType b = graph->GetRegionId(it->first.second);
+    if (graph->GetBorderLengthBetween(a, b) != it->second || graph->GetBorderLengthBetween(b, a) != it->second)
+      {
+      std::cerr << "Wrong border length between labels " << it->first.first << " and " << it->first.second << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // The bounding box must contain all the pixels of the region
+  for (labelIt.GoToBegin(); !labelIt.IsAtEnd(); ++labelIt)
+    {
+    if (!graph->GetBoundingBox(graph->GetRegionId(labelIt.Get())).IsInside(labelIt.GetIndex()))
+      {
+      std::cerr << "Pixel " << labelIt.GetIndex() << " outside of the bounding box of its region" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Round trip through a file
+  graph->Write(graphFileName);
+  GraphType::Pointer readGraph = GraphType::New();
+  readGraph->Read(graphFileName);
+  if (readGraph->GetNumberOfRegions() != graph->GetNumberOfRegions()
+      || readGraph->GetNumberOfEdges() != graph->GetNumberOfEdges()
+      || readGraph->GetNumberOfBands() != 2)
+    {
+    std::cerr << "Graph read from " << graphFileName << " differs from the written one" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Merging all the regions in one keeps the totals and removes all edges
+  GraphType::RegionIdVectorType groups(graph->GetNumberOfRegions(), 0);
+  GraphType::LabelVectorType groupLabels(1, 1);
+  GraphType::Pointer contracted = GraphType::New();
+  readGraph->Contract(groups, groupLabels, contracted);
+  if (contracted->GetNumberOfRegions() != 1 || contracted->GetNumberOfEdges() != 0
+      || contracted->GetPixelCount(0) != region.GetNumberOfPixels()
+      || contracted->GetBoundingBox(0) != region)
+    {
+    std::cerr << "Wrong contracted graph" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
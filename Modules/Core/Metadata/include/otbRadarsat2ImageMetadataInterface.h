@@ -175,6 +175,18 @@ public:
     return lutVal;
   }
 
+  /** Gains only depend on the column, so the values of a line are a plain
+   *  copy of the gain vector */
+  void GetLineValues(const IndexValueType firstX, const IndexValueType itkNotUsed(y),
+                     std::vector<double> & values) const ITK_OVERRIDE
+  {
+    for (std::size_t i = 0; i < values.size(); ++i)
+      {
+      const size_t pos = firstX + static_cast<IndexValueType>(i) + m_Offset;
+      values[i] = pos < m_Gains.size() ? m_Gains[pos] : 1.0;
+      }
+  }
+
   void PrintSelf(std::ostream & os, itk::Indent indent) const ITK_OVERRIDE
   {
     os << indent << " offset:'" << m_Offset << "'" << std::endl;
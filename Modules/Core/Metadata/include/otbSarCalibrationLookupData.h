@@ -21,6 +21,7 @@
 #ifndef SarCalibrationLookupData_H
 #define SarCalibrationLookupData_H 1
 #include <string>
+#include <vector>
 #include <itkLightObject.h>
 #include <itkNumericTraits.h>
 #include <itkObjectFactory.h>
@@ -68,6 +69,18 @@ class OTBMetadata_EXPORT SarCalibrationLookupData : public itk::LightObject {
     return 1.0;
   }
 
+  /** Fill values with the lookup values of line y, from column firstX
+   *  onwards. Sub-classes may override it to factor the search of the
+   *  line, which is the same for the whole line */
+  virtual void GetLineValues(const IndexValueType firstX, const IndexValueType y,
+                             std::vector<double> & values) const
+  {
+    for (std::size_t i = 0; i < values.size(); ++i)
+      {
+      values[i] = this->GetValue(firstX + static_cast<IndexValueType>(i), y);
+      }
+  }
+
   void SetType(short t)
   {
     m_Type = t;
@@ -192,6 +192,43 @@ public:
     return lutVal;
   }
 
+  void GetLineValues(const IndexValueType firstX, const IndexValueType y,
+                     std::vector<double> & values) const ITK_OVERRIDE
+  {
+    if (values.empty())
+      {
+      return;
+      }
+
+    // Same interpolation as GetValue(), with the calibration vectors and
+    // the azimuth weight computed once for the line
+    const int calVecIdx = GetVectorIndex(y);
+    assert(calVecIdx>=0 && calVecIdx < count-1);
+    const Sentinel1CalibrationStruct & vec0 = calibrationVectorList[calVecIdx];
+    const Sentinel1CalibrationStruct & vec1 = calibrationVectorList[calVecIdx + 1];
+    const double azTime = firstLineTime + y * lineTimeInterval;
+    const double muY = (azTime - vec0.timeMJD) / vec1.deltaMJD;
+
+    // Columns are increasing, so that the upper bound of GetPixelIndex()
+    // only moves forward
+    const int size = vec0.pixels.size();
+    std::vector<int>::const_iterator wh = std::upper_bound(vec0.pixels.begin(), vec0.pixels.end(), static_cast<int>(firstX));
+
+    for (std::size_t i = 0; i < values.size(); ++i)
+      {
+      const IndexValueType x = firstX + static_cast<IndexValueType>(i);
+      while (wh != vec0.pixels.end() && *wh <= x)
+        {
+        ++wh;
+        }
+      const int pixelIdx = wh == vec0.pixels.end() ? size - 2 : std::distance(vec0.pixels.begin(),wh)-1;
+      const double muX = (x - vec0.pixels[pixelIdx]) / vec0.deltaPixels[pixelIdx + 1];
+      values[i]
+        = (1 - muY) * ((1 - muX) * vec0.vect[pixelIdx] + muX * vec0.vect[pixelIdx + 1])
+        +       muY * ((1 - muX) * vec1.vect[pixelIdx] + muX * vec1.vect[pixelIdx + 1]);
+      }
+  }
+
   int GetVectorIndex(int y) const
   {
     for (int i = 1; i < count; i++)
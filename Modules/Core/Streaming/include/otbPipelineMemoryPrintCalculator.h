@@ -55,6 +55,13 @@ namespace otb
  *  memory usage. The optimal number of stream divisions can be
  *  retrieved using the GetOptimalNumberOfStreamDivisions().
  *
+ *  Process objects may also hold memory that does not depend on the
+ *  requested regions, like a cache. They declare it, in bytes, with a
+ *  MemoryPrintType entry of their MetaDataDictionary under the
+ *  ReservedMemoryPrintKey key. This memory is summed separately in
+ *  GetReservedMemoryPrint(), without any bias correction, and should be
+ *  deducted from the memory available for streaming.
+ *
  *  Please note that for now this calculator suffers from the
  *  following limitations:
  *  - DataObject taken into account for memory usage estimation are
@@ -100,6 +107,10 @@ public:
   /** Get the total memory print (in bytes) */
   itkGetMacro(MemoryPrint, MemoryPrintType);
 
+  /** Get the memory (in bytes) reserved by the process objects of the
+   * pipeline, independently of the requested regions */
+  itkGetMacro(ReservedMemoryPrint, MemoryPrintType);
+
   /** Set/Get the bias correction factor which will weight the
    * estimated memory print (allows compensating bias between
    * estimated and real memory print, default is 1., i.e. no correction) */
@@ -120,6 +131,9 @@ public:
   static const double ByteToMegabyte;
   static const double MegabyteToByte;
 
+  /** MetaDataDictionary key of the memory reserved by a process object */
+  static const char * const ReservedMemoryPrintKey;
+
   /** Evaluate the print (in bytes) of a single data object */
   MemoryPrintType EvaluateDataObjectPrint(DataObjectType * data) const;
 
@@ -143,6 +157,9 @@ private:
   /** The total memory print of the pipeline */
   MemoryPrintType       m_MemoryPrint;
 
+  /** The memory reserved by the pipeline process objects */
+  MemoryPrintType       m_ReservedMemoryPrint;
+
   /** Pointer to the last pipeline filter */
   DataObjectPointerType m_DataToWrite;
 
@@ -145,6 +145,17 @@ StreamingManager<TImage>::EstimateOptimalNumberOfDivisions(itk::DataObject * inp
     pipelineMemoryPrint = memoryPrintCalculator->GetMemoryPrint();
     }
 
+  // Memory held by the pipeline whatever the stream size, like the
+  // reader block caches, is not available for streaming
+  const MemoryPrintType reservedMemoryPrint = memoryPrintCalculator->GetReservedMemoryPrint();
+  if (reservedMemoryPrint > 0)
+    {
+    otbMsgDevMacro("Memory reserved by the pipeline : " << reservedMemoryPrint / 1024 / 1024 << " MB")
+    const MemoryPrintType minimumRAMInBytes = 1024 * 1024;
+    availableRAMInBytes = reservedMemoryPrint + minimumRAMInBytes < availableRAMInBytes
+      ? availableRAMInBytes - reservedMemoryPrint : minimumRAMInBytes;
+    }
+
   unsigned int optimalNumberOfDivisions =
       otb::PipelineMemoryPrintCalculator::EstimateOptimalNumberOfStreamDivisions(pipelineMemoryPrint, availableRAMInBytes);
 
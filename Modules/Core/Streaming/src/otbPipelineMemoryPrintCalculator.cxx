@@ -27,15 +27,18 @@
 #include "otbVectorImage.h"
 #include "itkFixedArray.h"
 #include "otbImageList.h"
+#include "itkMetaDataObject.h"
 
 namespace otb
 {
 const double PipelineMemoryPrintCalculator::ByteToMegabyte = 1./vcl_pow(2.0, 20);
 const double PipelineMemoryPrintCalculator::MegabyteToByte = vcl_pow(2.0, 20);
+const char * const PipelineMemoryPrintCalculator::ReservedMemoryPrintKey = "ReservedMemoryPrint";
 
 PipelineMemoryPrintCalculator
 ::PipelineMemoryPrintCalculator()
   : m_MemoryPrint(0),
+    m_ReservedMemoryPrint(0),
     m_DataToWrite(ITK_NULLPTR),
     m_BiasCorrectionFactor(1.),
     m_VisitedProcessObjects()
@@ -66,6 +69,7 @@ PipelineMemoryPrintCalculator
   // Display parameters
   os<<indent<<"Data to write:                      "<<m_DataToWrite<<std::endl;
   os<<indent<<"Memory print of whole pipeline:     "<<m_MemoryPrint * ByteToMegabyte <<" Mb"<<std::endl;
+  os<<indent<<"Memory reserved by the pipeline:    "<<m_ReservedMemoryPrint * ByteToMegabyte <<" Mb"<<std::endl;
   os<<indent<<"Bias correction factor applied:     "<<m_BiasCorrectionFactor<<std::endl;
 }
 
@@ -75,6 +79,7 @@ PipelineMemoryPrintCalculator
 {
   // Clear the visited process objects set
   m_VisitedProcessObjects.clear();
+  m_ReservedMemoryPrint = 0;
 
   // Dry run of pipeline synchronisation
   m_DataToWrite->UpdateOutputInformation();
@@ -120,6 +125,13 @@ PipelineMemoryPrintCalculator
     m_VisitedProcessObjects.insert(process);
     }
 
+  // Memory held by the process object itself, like a cache
+  MemoryPrintType reserved = 0;
+  if(itk::ExposeMetaData<MemoryPrintType>(process->GetMetaDataDictionary(), ReservedMemoryPrintKey, reserved))
+    {
+    m_ReservedMemoryPrint += reserved;
+    }
+
   // Retrieve the array of inputs
   ProcessObjectType::DataObjectPointerArray inputs = process->GetInputs();
   // First, recurse on each input source
@@ -96,6 +96,11 @@ public:
    *  with Second Transform Input */
   typedef typename Superclass::OutputPointType SecondTransformOutputPointType;
 
+  /** Point containers used by the batch transformation */
+  typedef typename Superclass::InputPointContainerType  FirstTransformInputPointContainerType;
+  typedef std::vector<FirstTransformOutputPointType>    FirstTransformOutputPointContainerType;
+  typedef typename Superclass::OutputPointContainerType SecondTransformOutputPointContainerType;
+
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
 
@@ -120,6 +125,12 @@ public:
   /**  Method to transform a point. */
   SecondTransformOutputPointType TransformPoint(const FirstTransformInputPointType&) const ITK_OVERRIDE;
 
+  /**  Method to transform a batch of points. Each transform of the
+   * composition is called once for the whole batch when it provides a
+   * batch implementation (i.e. when it is an otb::Transform). */
+  void TransformPoints(const FirstTransformInputPointContainerType& inputPoints,
+                       SecondTransformOutputPointContainerType& outputPoints) const ITK_OVERRIDE;
+
   /**  Method to transform a vector. */
   //  virtual OutputVectorType TransformVector(const InputVectorType &) const;
 
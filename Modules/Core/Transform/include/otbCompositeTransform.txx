@@ -89,6 +89,60 @@ CompositeTransform<TFirstTransform,
   return outputPoint;
 }
 
+template<class TFirstTransform,
+    class TSecondTransform,
+    class TScalarType,
+    unsigned int NInputDimensions,
+    unsigned int NOutputDimensions>
+void
+CompositeTransform<TFirstTransform,
+    TSecondTransform,
+    TScalarType,
+    NInputDimensions,
+    NOutputDimensions>
+::TransformPoints(const FirstTransformInputPointContainerType& inputPoints,
+                  SecondTransformOutputPointContainerType& outputPoints) const
+{
+  typedef otb::Transform<typename TFirstTransform::ScalarType,
+                         TFirstTransform::InputSpaceDimension,
+                         TFirstTransform::OutputSpaceDimension> FirstBatchTransformType;
+  typedef otb::Transform<typename TSecondTransform::ScalarType,
+                         TSecondTransform::InputSpaceDimension,
+                         TSecondTransform::OutputSpaceDimension> SecondBatchTransformType;
+
+  const FirstBatchTransformType * firstBatch =
+    dynamic_cast<const FirstBatchTransformType *>(m_FirstTransform.GetPointer());
+  const SecondBatchTransformType * secondBatch =
+    dynamic_cast<const SecondBatchTransformType *>(m_SecondTransform.GetPointer());
+
+  FirstTransformOutputPointContainerType geoPoints;
+  if (firstBatch != ITK_NULLPTR)
+    {
+    firstBatch->TransformPoints(inputPoints, geoPoints);
+    }
+  else
+    {
+    geoPoints.resize(inputPoints.size());
+    for (unsigned long i = 0; i < inputPoints.size(); ++i)
+      {
+      geoPoints[i] = m_FirstTransform->TransformPoint(inputPoints[i]);
+      }
+    }
+
+  if (secondBatch != ITK_NULLPTR)
+    {
+    secondBatch->TransformPoints(geoPoints, outputPoints);
+    }
+  else
+    {
+    outputPoints.resize(geoPoints.size());
+    for (unsigned long i = 0; i < geoPoints.size(); ++i)
+      {
+      outputPoints[i] = m_SecondTransform->TransformPoint(geoPoints[i]);
+      }
+    }
+}
+
 /*template<class TFirstTransform, class TSecondTransform, class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
   typename CompositeTransform<TFirstTransform, TSecondTransform, TScalarType, NInputDimensions, NOutputDimensions>::OutputVectorType
   CompositeTransform<TFirstTransform, TSecondTransform, TScalarType, NInputDimensions, NOutputDimensions>
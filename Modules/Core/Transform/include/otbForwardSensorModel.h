@@ -64,6 +64,9 @@ public:
   typedef typename Superclass::InputPointType  InputPointType;
   typedef typename Superclass::OutputPointType OutputPointType;
 
+  typedef typename Superclass::InputPointContainerType  InputPointContainerType;
+  typedef typename Superclass::OutputPointContainerType OutputPointContainerType;
+
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
 
@@ -76,6 +79,11 @@ public:
   /** Compute the world coordinates. */
   OutputPointType TransformPoint(const InputPointType& point) const ITK_OVERRIDE;
 
+  /** Compute the world coordinates of a batch of points in a single call to
+   * the sensor model. */
+  void TransformPoints(const InputPointContainerType& inputPoints,
+                       OutputPointContainerType& outputPoints) const ITK_OVERRIDE;
+
 protected:
   ForwardSensorModel();
   ~ForwardSensorModel() ITK_OVERRIDE;
@@ -66,6 +66,8 @@ public:
   typedef typename Superclass::JacobianType         JacobianType;
   typedef itk::Point<ScalarType, NInputDimensions>  InputPointType;
   typedef itk::Point<ScalarType, NOutputDimensions> OutputPointType;
+  typedef typename Superclass::InputPointContainerType  InputPointContainerType;
+  typedef typename Superclass::OutputPointContainerType OutputPointContainerType;
 
   typedef itk::Vector<double, 2> SpacingType;
   typedef itk::Point<double, 2>  OriginType;
@@ -165,11 +167,22 @@ public:
   /** Get Transform accuracy */
   itkGetMacro(TransformAccuracy, Projection::TransformAccuracy);
 
+  /** Evaluate the RPC sensor models natively instead of through ossim
+   * (off by default). Takes effect at the next InstantiateTransform(). */
+  itkSetMacro(UseNativeRPCModel, bool);
+  itkGetConstMacro(UseNativeRPCModel, bool);
+  itkBooleanMacro(UseNativeRPCModel);
+
   /** Methods prototypes */
   virtual const TransformType * GetTransform() const;
 
   OutputPointType TransformPoint(const InputPointType& point) const ITK_OVERRIDE;
 
+  /** Transform a batch of points. Sensor models involved in the
+   * transformation are called once for the whole batch. */
+  void TransformPoints(const InputPointContainerType& inputPoints,
+                       OutputPointContainerType& outputPoints) const ITK_OVERRIDE;
+
   virtual void  InstantiateTransform();
   
   // Get inverse methods
@@ -218,6 +231,7 @@ private:
   GenericTransformPointerType   m_OutputTransform;
   mutable bool                  m_TransformUpToDate;
   Projection::TransformAccuracy m_TransformAccuracy;
+  bool                          m_UseNativeRPCModel;
 };
 
 } // namespace otb
@@ -51,6 +51,7 @@ GenericRSTransform<TScalarType, NInputDimensions, NOutputDimensions>
   m_OutputTransform = ITK_NULLPTR;
   m_TransformUpToDate = false;
   m_TransformAccuracy = Projection::UNKNOWN;
+  m_UseNativeRPCModel = false;
 }
 
 template<class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
@@ -146,6 +147,7 @@ GenericRSTransform<TScalarType, NInputDimensions, NOutputDimensions>
     typedef otb::ForwardSensorModel<double, InputSpaceDimension, InputSpaceDimension> ForwardSensorModelType;
     typename ForwardSensorModelType::Pointer sensorModel = ForwardSensorModelType::New();
 
+    sensorModel->SetUseNativeRPCModel(m_UseNativeRPCModel);
     sensorModel->SetImageGeometry(m_InputKeywordList);
 
     if (sensorModel->IsValidSensorModel())
@@ -207,6 +209,7 @@ GenericRSTransform<TScalarType, NInputDimensions, NOutputDimensions>
     typedef otb::InverseSensorModel<double, InputSpaceDimension, OutputSpaceDimension> InverseSensorModelType;
     typename InverseSensorModelType::Pointer sensorModel = InverseSensorModelType::New();
 
+    sensorModel->SetUseNativeRPCModel(m_UseNativeRPCModel);
     sensorModel->SetImageGeometry(m_OutputKeywordList);
 
     if (sensorModel->IsValidSensorModel())
@@ -280,6 +283,30 @@ GenericRSTransform<TScalarType, NInputDimensions, NOutputDimensions>
   return outputPoint;
 }
 
+template<class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+GenericRSTransform<TScalarType, NInputDimensions, NOutputDimensions>
+::TransformPoints(const InputPointContainerType& inputPoints, OutputPointContainerType& outputPoints) const
+{
+  // Apply input origin/spacing
+  InputPointContainerType points(inputPoints);
+  for (unsigned long i = 0; i < points.size(); ++i)
+    {
+    points[i][0] = points[i][0] * m_InputSpacing[0] + m_InputOrigin[0];
+    points[i][1] = points[i][1] * m_InputSpacing[1] + m_InputOrigin[1];
+    }
+
+  // Transform points
+  this->GetTransform()->TransformPoints(points, outputPoints);
+
+  // Apply output origin/spacing
+  for (unsigned long i = 0; i < outputPoints.size(); ++i)
+    {
+    outputPoints[i][0] = (outputPoints[i][0] - m_OutputOrigin[0]) / m_OutputSpacing[0];
+    outputPoints[i][1] = (outputPoints[i][1] - m_OutputOrigin[1]) / m_OutputSpacing[1];
+    }
+}
+
 template<class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
 bool
 GenericRSTransform<TScalarType, NInputDimensions, NOutputDimensions>
@@ -311,6 +338,8 @@ GenericRSTransform<TScalarType, NInputDimensions, NOutputDimensions>
   inverseTransform->SetInputOrigin(m_OutputOrigin);
   inverseTransform->SetOutputOrigin(m_InputOrigin);
 
+  inverseTransform->SetUseNativeRPCModel(m_UseNativeRPCModel);
+
   // Instantiate transform
   inverseTransform->InstantiateTransform();
 
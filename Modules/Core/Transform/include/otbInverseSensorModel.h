@@ -64,6 +64,9 @@ public:
   typedef typename Superclass::InputPointType  InputPointType;
   typedef typename Superclass::OutputPointType OutputPointType;
 
+  typedef typename Superclass::InputPointContainerType  InputPointContainerType;
+  typedef typename Superclass::OutputPointContainerType OutputPointContainerType;
+
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
 
@@ -75,6 +78,11 @@ public:
 
   // Transform of geographic point in image sensor index
   OutputPointType TransformPoint(const InputPointType& point) const ITK_OVERRIDE;
+
+  /** Compute the image coordinates of a batch of points in a single call to
+   * the sensor model. */
+  void TransformPoints(const InputPointContainerType& inputPoints,
+                       OutputPointContainerType& outputPoints) const ITK_OVERRIDE;
   // Transform of geographic point in image sensor index -- Backward Compatibility
   //  OutputPointType TransformPoint(const InputPointType &point, double height) const;
 
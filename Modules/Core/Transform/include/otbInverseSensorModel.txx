@@ -73,6 +73,52 @@ InverseSensorModel<TScalarType, NInputDimensions, NOutputDimensions>
 }
 
 
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+InverseSensorModel<TScalarType, NInputDimensions, NOutputDimensions>
+::TransformPoints(const InputPointContainerType& inputPoints, OutputPointContainerType& outputPoints) const
+{
+  const unsigned long nbPoints = inputPoints.size();
+  outputPoints.resize(nbPoints);
+  if (nbPoints == 0)
+    {
+    return;
+    }
+
+  // Structure of arrays layout expected by the adapter
+  std::vector<double> lon(nbPoints), lat(nbPoints), h;
+  std::vector<double> x(nbPoints), y(nbPoints), z(nbPoints);
+
+  for (unsigned long i = 0; i < nbPoints; ++i)
+    {
+    lon[i] = inputPoints[i][0];
+    lat[i] = inputPoints[i][1];
+    }
+
+  if (InputPointType::PointDimension == 3)
+    {
+    h.resize(nbPoints);
+    for (unsigned long i = 0; i < nbPoints; ++i)
+      {
+      h[i] = inputPoints[i][2];
+      }
+    }
+
+  this->m_Model->InverseTransformPoints(&lon[0], &lat[0], h.empty() ? ITK_NULLPTR : &h[0],
+                                        &x[0], &y[0], &z[0], nbPoints);
+
+  for (unsigned long i = 0; i < nbPoints; ++i)
+    {
+    outputPoints[i][0] = x[i];
+    outputPoints[i][1] = y[i];
+
+    if (OutputPointType::PointDimension == 3)
+      {
+      outputPoints[i][2] = z[i];
+      }
+    }
+}
+
 template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
 void
 InverseSensorModel<TScalarType, NInputDimensions, NOutputDimensions>
@@ -90,6 +90,17 @@ public:
     return m_Model->IsValidSensorModel();
   }
 
+  /** Evaluate RPC models natively instead of through ossim (default is
+   * false). Must be set before SetImageGeometry(). */
+  void SetUseNativeRPCModel(bool flag)
+  {
+    m_Model->SetUseNativeRPCModel(flag);
+  }
+  bool GetUseNativeRPCModel() const
+  {
+    return m_Model->GetUseNativeRPCModel();
+  }
+
 protected:
   SensorModelBase();
   ~SensorModelBase() ITK_OVERRIDE;
@@ -40,6 +40,22 @@ namespace otb
  * If the maximum displacement is wrong, this filter is likely to request data outside of the input image buffered region. In this case, pixels
  * outside the region will be set to Zero according to itk::NumericTraits.
  *
+ * When FastWarp is on and the interpolator is a nearest neighbour, linear or
+ * BCO interpolator, the generic per-pixel path of itk::WarpImageFilter is
+ * replaced by a row-based one: the continuous indices in the displacement
+ * field and in the input image are stepped incrementally along each output
+ * row, the displacement is interpolated directly from the field buffer, and
+ * all bands of a pixel are computed at once from the input buffer without
+ * any per-pixel allocation. Other interpolators always use the generic path.
+ *
+ * The input requested region is the exact footprint of the output requested
+ * region: since the displacement is interpolated bilinearly, the mapped
+ * positions are extremal at the output region corners, at the displacement
+ * grid nodes inside the region and where the region boundary crosses the
+ * grid lines, so only these positions are evaluated. The ratio between the
+ * requested input pixels and the area of this footprint (the read
+ * amplification) is accumulated over the streams.
+ *
  * \sa itk::WarpImageFilter
  *
  * \ingroup Streamed
@@ -79,11 +95,45 @@ public:
   typedef typename DisplacementFieldType::PixelType  DisplacementValueType;
   typedef typename DisplacementFieldType::Pointer    DisplacementFieldPointerType;
   typedef typename DisplacementFieldType::RegionType DisplacementFieldRegionType;
+  typedef typename Superclass::InterpolatorType      InterpolatorType;
+  typedef typename Superclass::CoordRepType          CoordRepType;
+
+  typedef typename InputImageType::RegionType        InputImageRegionType;
+  typedef itk::ContinuousIndex<double,
+                               InputImageType::ImageDimension> InputContinuousIndexType;
+  typedef itk::ContinuousIndex<double,
+                               DisplacementFieldType::ImageDimension> FieldContinuousIndexType;
 
   /** Accessors */
   itkSetMacro(MaximumDisplacement, DisplacementValueType);
   itkGetConstReferenceMacro(MaximumDisplacement, DisplacementValueType);
 
+  /** Enable/disable the row-based warp kernels (off by default) */
+  itkSetMacro(FastWarp, bool);
+  itkGetConstMacro(FastWarp, bool);
+  itkBooleanMacro(FastWarp);
+
+  /** Read amplification of the last requested region: requested input
+   * pixels divided by the area of the exact footprint of the output region */
+  itkGetConstMacro(LastReadAmplification, double);
+
+  /** Read amplification accumulated over the requested regions since the
+   * last output information update */
+  double GetReadAmplification() const
+  {
+    return m_FootprintInputPixels > 0. ? m_RequestedInputPixels / m_FootprintInputPixels : 0.;
+  }
+  itkGetConstMacro(RequestedInputPixels, double);
+  itkGetConstMacro(FootprintInputPixels, double);
+  itkGetConstMacro(NumberOfRequestedRegions, unsigned long);
+
+  /** Continuous index in the input image of an output physical point,
+   * interpolated from the displacement field (which is updated on the
+   * surrounding nodes only). Returns false if the point is outside the
+   * displacement grid. */
+  bool EvaluateInputContinuousIndex(const PointType & outputPoint,
+                                    InputContinuousIndexType & inputIndex);
+
   const SpacingType & GetOutputSpacing() const override
   {
     return m_OutputSignedSpacing;
@@ -107,12 +157,19 @@ protected:
 
   void GenerateOutputInformation() ITK_OVERRIDE;
 
+  /** Select the warp kernel matching the interpolator */
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
   /**
    * Re-implement the method ThreadedGenerateData to mask area outside the deformation grid
    */
   void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
                             itk::ThreadIdType threadId ) ITK_OVERRIDE;
 
+  /** Row-based warping used when a specialised kernel is available */
+  void FastWarpThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                                    itk::ThreadIdType threadId );
+
 private:
   StreamingWarpImageFilter(const Self &); //purposely not implemented
   void operator =(const Self&); //purposely not implemented
@@ -123,6 +180,43 @@ private:
 
   // Assessment of the maximum displacement for streaming
   DisplacementValueType m_MaximumDisplacement;
+
+  /** Kernels available for the row-based path */
+  typedef enum
+    {
+    GENERIC_KERNEL,
+    NEAREST_KERNEL,
+    LINEAR_KERNEL,
+    BCO_KERNEL
+    } WarpKernelType;
+
+  /** Compute the normalised BCO weights of a window centred on the nearest
+   * integer position of x (same weights as otb::BCOInterpolateImageFunction) */
+  void EvaluateBCOCoefficients(double x, double * coefs) const;
+
+  /** Map a continuous index of the displacement field to a continuous index
+   * of the input image, interpolating the buffered field bilinearly with the
+   * same clamping as the row-based kernels */
+  void FieldIndexToInputIndex(const DisplacementFieldType * fieldPtr,
+                              const InputImageType * inputPtr,
+                              const FieldContinuousIndexType & fieldIndex,
+                              InputContinuousIndexType & inputIndex) const;
+
+  // Use the row-based kernels when possible
+  bool m_FastWarp;
+
+  // Kernel selected for the current update
+  WarpKernelType m_WarpKernel;
+
+  // BCO interpolator parameters
+  unsigned int m_BCORadius;
+  double       m_BCOAlpha;
+
+  // Read amplification statistics
+  double        m_LastReadAmplification;
+  double        m_RequestedInputPixels;
+  double        m_FootprintInputPixels;
+  unsigned long m_NumberOfRequestedRegions;
 };
 
 } // end namespace otb
@@ -24,9 +24,14 @@
 
 #include "otbStreamingWarpImageFilter.h"
 #include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageScanlineIterator.h"
 #include "itkDefaultConvertPixelTraits.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "otbBCOInterpolateImageFunction.h"
 #include "itkMetaDataObject.h"
 #include "otbMetaDataKey.h"
+#include "otbMacro.h"
 
 namespace otb
 {
@@ -38,6 +43,14 @@ StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
   // Fill the default maximum displacement
   m_MaximumDisplacement.Fill(1);
   m_OutputSignedSpacing = this->Superclass::GetOutputSpacing();
+  m_FastWarp = false;
+  m_WarpKernel = GENERIC_KERNEL;
+  m_BCORadius = 2;
+  m_BCOAlpha = -0.5;
+  m_LastReadAmplification = 0.;
+  m_RequestedInputPixels = 0.;
+  m_FootprintInputPixels = 0.;
+  m_NumberOfRequestedRegions = 0;
  }
 
 
@@ -102,31 +115,51 @@ StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
     return;
     }
 
+  const unsigned int dimension = DisplacementFieldType::ImageDimension;
+
   // Here we are breaking traditional pipeline steps because we need to access the displacement field data
   // so as to compute the input image requested region
 
   // 1) First, evaluate the displacement field requested region corresponding to the output requested region
   // (Here we suppose that the displacement field and the output image are in the same geometry/map projection)
   typename OutputImageType::RegionType outputRequestedRegion = outputPtr->GetRequestedRegion();
-  typename OutputImageType::IndexType outIndexStart = outputRequestedRegion.GetIndex();
-  typename OutputImageType::IndexType outIndexEnd;
-  for(unsigned int dim = 0; dim<OutputImageType::ImageDimension; ++dim)
-    outIndexEnd[dim]= outIndexStart[dim] + outputRequestedRegion.GetSize()[dim]-1;
-  typename OutputImageType::PointType outPointStart, outPointEnd;
-  outputPtr->TransformIndexToPhysicalPoint(outIndexStart, outPointStart);
-  outputPtr->TransformIndexToPhysicalPoint(outIndexEnd, outPointEnd);
-
-  typename DisplacementFieldType::IndexType defIndexStart, defIndexEnd;
-  displacementPtr->TransformPhysicalPointToIndex(outPointStart, defIndexStart);
-  displacementPtr->TransformPhysicalPointToIndex(outPointEnd, defIndexEnd);
 
+  // Extent of the output pixel centres in the field continuous index space,
+  // computed from all the corners of the region
+  FieldContinuousIndexType fieldMin, fieldMax;
+  for (unsigned int corner = 0; corner < (1u << dimension); ++corner)
+    {
+    IndexType cornerIndex = outputRequestedRegion.GetIndex();
+    for(unsigned int dim = 0; dim<dimension; ++dim)
+      {
+      if ((corner >> dim) & 1)
+        {
+        cornerIndex[dim] += outputRequestedRegion.GetSize()[dim]-1;
+        }
+      }
+    PointType cornerPoint;
+    FieldContinuousIndexType cornerFieldIndex;
+    outputPtr->TransformIndexToPhysicalPoint(cornerIndex, cornerPoint);
+    displacementPtr->TransformPhysicalPointToContinuousIndex(cornerPoint, cornerFieldIndex);
+    for(unsigned int dim = 0; dim<dimension; ++dim)
+      {
+      if (corner == 0 || cornerFieldIndex[dim] < fieldMin[dim])
+        fieldMin[dim] = cornerFieldIndex[dim];
+      if (corner == 0 || cornerFieldIndex[dim] > fieldMax[dim])
+        fieldMax[dim] = cornerFieldIndex[dim];
+      }
+    }
+
+  // The interpolation of the displacement uses the two nodes around each
+  // position
   typename DisplacementFieldType::SizeType defRequestedSize;
   typename DisplacementFieldType::IndexType defRequestedIndex;
 
-  for(unsigned int dim = 0; dim<OutputImageType::ImageDimension; ++dim)
+  for(unsigned int dim = 0; dim<dimension; ++dim)
     {
-    defRequestedIndex[dim] = std::min(defIndexStart[dim], defIndexEnd[dim]);
-    defRequestedSize[dim] = std::max(defIndexStart[dim], defIndexEnd[dim]) - defRequestedIndex[dim] + 1;
+    defRequestedIndex[dim] = static_cast<typename DisplacementFieldType::IndexValueType>(vcl_floor(fieldMin[dim]));
+    defRequestedSize[dim] = static_cast<typename DisplacementFieldType::SizeValueType>(
+      vcl_floor(fieldMax[dim]) - defRequestedIndex[dim] + 2);
     }
 
   // Finally, build the displacement field requested region
@@ -134,9 +167,6 @@ StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
   displacementRequestedRegion.SetIndex(defRequestedIndex);
   displacementRequestedRegion.SetSize(defRequestedSize);
 
-  // Avoid extrapolation
-  displacementRequestedRegion.PadByRadius(1);
-
   // crop the input requested region at the input's largest possible region
   if (displacementRequestedRegion.Crop(displacementPtr->GetLargestPossibleRegion()))
     {
@@ -167,72 +197,150 @@ StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
   displacementPtr->PropagateRequestedRegion();
   displacementPtr->UpdateOutputData();
 
-  // Walk the loaded displacement field to derive maximum and minimum
-  itk::ImageRegionIteratorWithIndex<DisplacementFieldType> defIt(displacementPtr, displacementRequestedRegion);
-  defIt.GoToBegin();
-
-  typename InputImageType::PointType currentPoint;
-  typename InputImageType::PointType inputStartPoint, inputEndPoint;
-
-  // Initialise start and end points
-  displacementPtr->TransformIndexToPhysicalPoint(defIt.GetIndex(), currentPoint);
-  for(unsigned int dim = 0; dim<DisplacementFieldType::ImageDimension; ++dim)
+  // 3) Exact footprint: output pixels outside the grid are padded, so the
+  // extent is restricted to the grid. Within a grid cell each coordinate of
+  // the mapped position is bilinear, hence extremal at the corners of the
+  // cell clipped by the region: the region bounds and the grid lines in
+  // between are enough.
+  const DisplacementFieldRegionType defRegion = displacementPtr->GetLargestPossibleRegion();
+  std::vector<std::vector<double> > coordinates(dimension);
+  bool emptyFootprint = false;
+  for(unsigned int dim = 0; dim<dimension; ++dim)
     {
-    currentPoint[dim]+=defIt.Get()[dim];
+    const double lower = std::max(fieldMin[dim], static_cast<double>(defRegion.GetIndex(dim)));
+    const double upper = std::min(fieldMax[dim],
+                                  static_cast<double>(defRegion.GetIndex(dim)+defRegion.GetSize(dim)-1));
+    if (lower > upper)
+      {
+      emptyFootprint = true;
+      break;
+      }
+    coordinates[dim].push_back(lower);
+    for (double node = vcl_floor(lower) + 1.; node < upper; node += 1.)
+      {
+      coordinates[dim].push_back(node);
+      }
+    if (upper > lower)
+      {
+      coordinates[dim].push_back(upper);
+      }
     }
-  inputStartPoint = currentPoint;
-  inputEndPoint = currentPoint;
 
-  ++defIt;
+  InputImageRegionType inputRequestedRegion;
+  double footprintArea = 0.;
 
-  // 3) Now Walk the field and compute the physical bounding box
-  while(!defIt.IsAtEnd())
+  if (!emptyFootprint)
     {
-    displacementPtr->TransformIndexToPhysicalPoint(defIt.GetIndex(), currentPoint);
-    for(unsigned int dim = 0; dim<DisplacementFieldType::ImageDimension; ++dim)
+    // Walk all the combinations of the coordinates
+    InputContinuousIndexType inputMin, inputMax, inputIndex;
+    FieldContinuousIndexType fieldIndex;
+    std::vector<unsigned int> position(dimension, 0);
+    bool first = true;
+    bool done = false;
+    while (!done)
       {
-      currentPoint[dim]+=defIt.Get()[dim];
-      if(inputStartPoint[dim] > currentPoint[dim])
-        inputStartPoint[dim] = currentPoint[dim];
-      if(inputEndPoint[dim] < currentPoint[dim])
-        inputEndPoint[dim] = currentPoint[dim];
-      }
-    ++defIt;
-    }
+      for(unsigned int dim = 0; dim<dimension; ++dim)
+        {
+        fieldIndex[dim] = coordinates[dim][position[dim]];
+        }
+      this->FieldIndexToInputIndex(displacementPtr, inputPtr, fieldIndex, inputIndex);
+      for(unsigned int dim = 0; dim<InputImageType::ImageDimension; ++dim)
+        {
+        if (first || inputIndex[dim] < inputMin[dim])
+          inputMin[dim] = inputIndex[dim];
+        if (first || inputIndex[dim] > inputMax[dim])
+          inputMax[dim] = inputIndex[dim];
+        }
+      first = false;
 
-  // Convert physical bounding box to requested region
-  typename InputImageType::IndexType inputStartIndex, inputEndIndex;
-  inputPtr->TransformPhysicalPointToIndex(inputStartPoint, inputStartIndex);
-  inputPtr->TransformPhysicalPointToIndex(inputEndPoint, inputEndIndex);
+      done = true;
+      for(unsigned int dim = 0; dim<dimension && done; ++dim)
+        {
+        if (++position[dim] < coordinates[dim].size())
+          {
+          done = false;
+          }
+        else
+          {
+          position[dim] = 0;
+          }
+        }
+      }
 
-  typename InputImageType::SizeType inputFinalSize;
-  typename InputImageType::IndexType inputFinalIndex;
+    // Area of the footprint polygon (the mapped boundary of the region)
+    if (dimension == 2 && InputImageType::ImageDimension == 2)
+      {
+      std::vector<FieldContinuousIndexType> boundary;
+      const std::vector<double> & xs = coordinates[0];
+      const std::vector<double> & ys = coordinates[1];
+      for (unsigned int i = 0; i < xs.size(); ++i)
+        {
+        fieldIndex[0] = xs[i]; fieldIndex[1] = ys.front(); boundary.push_back(fieldIndex);
+        }
+      for (unsigned int j = 1; j < ys.size(); ++j)
+        {
+        fieldIndex[0] = xs.back(); fieldIndex[1] = ys[j]; boundary.push_back(fieldIndex);
+        }
+      for (unsigned int i = xs.size() - 1; i-- > 0 && ys.size() > 1;)
+        {
+        fieldIndex[0] = xs[i]; fieldIndex[1] = ys.back(); boundary.push_back(fieldIndex);
+        }
+      for (unsigned int j = ys.size() - 1; j-- > 1 && xs.size() > 1;)
+        {
+        fieldIndex[0] = xs.front(); fieldIndex[1] = ys[j]; boundary.push_back(fieldIndex);
+        }
 
-  for(unsigned int dim = 0; dim<DisplacementFieldType::ImageDimension; ++dim)
-    {
-    inputFinalIndex[dim] = std::min(inputStartIndex[dim], inputEndIndex[dim]);
-    inputFinalSize[dim] = std::max(inputStartIndex[dim], inputEndIndex[dim])-inputFinalIndex[dim]+1;
-    }
+      std::vector<InputContinuousIndexType> polygon(boundary.size());
+      for (unsigned int k = 0; k < boundary.size(); ++k)
+        {
+        this->FieldIndexToInputIndex(displacementPtr, inputPtr, boundary[k], polygon[k]);
+        }
+      for (unsigned int k = 0; k < polygon.size(); ++k)
+        {
+        const InputContinuousIndexType & a = polygon[k];
+        const InputContinuousIndexType & b = polygon[(k + 1) % polygon.size()];
+        footprintArea += a[0] * b[1] - b[0] * a[1];
+        }
+      footprintArea = 0.5 * vcl_abs(footprintArea);
+      }
+    else
+      {
+      footprintArea = 1.;
+      for(unsigned int dim = 0; dim<InputImageType::ImageDimension; ++dim)
+        {
+        footprintArea *= inputMax[dim] - inputMin[dim];
+        }
+      }
 
-  typename InputImageType::RegionType inputRequestedRegion;
-  inputRequestedRegion.SetIndex(inputFinalIndex);
-  inputRequestedRegion.SetSize(inputFinalSize);
+    // Convert the footprint to requested region
+    typename InputImageType::IndexType inputFinalIndex;
+    typename InputImageType::SizeType  inputFinalSize;
+    for(unsigned int dim = 0; dim<InputImageType::ImageDimension; ++dim)
+      {
+      inputFinalIndex[dim] = static_cast<typename InputImageType::IndexValueType>(vcl_floor(inputMin[dim] + 0.5));
+      inputFinalSize[dim] = static_cast<typename InputImageType::SizeValueType>(
+        vcl_floor(inputMax[dim] + 0.5) - inputFinalIndex[dim] + 1);
+      }
+    inputRequestedRegion.SetIndex(inputFinalIndex);
+    inputRequestedRegion.SetSize(inputFinalSize);
 
-  // Compute the padding due to the interpolator
-  unsigned int interpolatorRadius =
-      StreamingTraits<typename Superclass::InputImageType>::CalculateNeededRadiusForInterpolator(this->GetInterpolator());
+    // Compute the padding due to the interpolator
+    unsigned int interpolatorRadius =
+        StreamingTraits<typename Superclass::InputImageType>::CalculateNeededRadiusForInterpolator(this->GetInterpolator());
 
-  // pad the input requested region by the operator radius
-  inputRequestedRegion.PadByRadius(interpolatorRadius);
+    // pad the input requested region by the operator radius
+    inputRequestedRegion.PadByRadius(interpolatorRadius);
+    }
 
   // crop the input requested region at the input's largest possible region
-  if (inputRequestedRegion.Crop(inputPtr->GetLargestPossibleRegion()))
+  if (!emptyFootprint && inputRequestedRegion.Crop(inputPtr->GetLargestPossibleRegion()))
     {
     inputPtr->SetRequestedRegion(inputRequestedRegion);
     }
   else
     {
-
+    typename InputImageType::IndexType inputFinalIndex;
+    typename InputImageType::SizeType  inputFinalSize;
     inputFinalSize.Fill(0);
     inputRequestedRegion.SetSize(inputFinalSize);
     inputFinalIndex.Fill(0);
@@ -240,16 +348,115 @@ StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
 
     // store what we tried to request (prior to trying to crop)
     inputPtr->SetRequestedRegion(inputRequestedRegion);
-
-//    // build an exception
-//    itk::InvalidRequestedRegionError e(__FILE__, __LINE__);
-//    e.SetLocation(ITK_LOCATION);
-//    e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
-//    e.SetDataObject(inputPtr);
-//    throw e;
     }
+
+  // Read amplification of this request
+  const double requestedPixels = static_cast<double>(inputRequestedRegion.GetNumberOfPixels());
+  m_LastReadAmplification = footprintArea > 0. ? requestedPixels / footprintArea : 0.;
+  m_RequestedInputPixels += requestedPixels;
+  m_FootprintInputPixels += footprintArea;
+  ++m_NumberOfRequestedRegions;
+
+  otbMsgDevMacro(<< "Output region " << outputRequestedRegion.GetIndex() << outputRequestedRegion.GetSize()
+                 << ": input requested region " << inputRequestedRegion.GetIndex() << inputRequestedRegion.GetSize()
+                 << ", footprint of " << footprintArea << " pixels, read amplification "
+                 << m_LastReadAmplification);
  }
 
+template<class TInputImage, class TOutputImage, class TDisplacementField>
+void
+StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
+::FieldIndexToInputIndex(const DisplacementFieldType * fieldPtr,
+                         const InputImageType * inputPtr,
+                         const FieldContinuousIndexType & fieldIndex,
+                         InputContinuousIndexType & inputIndex) const
+{
+  const unsigned int dimension = DisplacementFieldType::ImageDimension;
+  const DisplacementFieldRegionType bufferedRegion = fieldPtr->GetBufferedRegion();
+
+  typename DisplacementFieldType::IndexType baseIndex;
+  double fraction[DisplacementFieldType::ImageDimension];
+  for (unsigned int dim = 0; dim < dimension; ++dim)
+    {
+    baseIndex[dim] = static_cast<typename DisplacementFieldType::IndexValueType>(vcl_floor(fieldIndex[dim]));
+    fraction[dim] = fieldIndex[dim] - baseIndex[dim];
+    }
+
+  // Multilinear interpolation, clamped to the buffered region
+  double displacement[DisplacementFieldType::ImageDimension];
+  std::fill(displacement, displacement + dimension, 0.);
+  for (unsigned int corner = 0; corner < (1u << dimension); ++corner)
+    {
+    double weight = 1.;
+    typename DisplacementFieldType::IndexType nodeIndex;
+    for (unsigned int dim = 0; dim < dimension; ++dim)
+      {
+      const bool upper = (corner >> dim) & 1;
+      weight *= upper ? fraction[dim] : 1. - fraction[dim];
+      const long start = bufferedRegion.GetIndex(dim);
+      const long end = start + static_cast<long>(bufferedRegion.GetSize(dim)) - 1;
+      nodeIndex[dim] = std::min(std::max(static_cast<long>(baseIndex[dim]) + (upper ? 1 : 0), start), end);
+      }
+    if (weight == 0.)
+      {
+      continue;
+      }
+    const DisplacementValueType & value = fieldPtr->GetPixel(nodeIndex);
+    for (unsigned int dim = 0; dim < dimension; ++dim)
+      {
+      displacement[dim] += weight * value[dim];
+      }
+    }
+
+  typename InputImageType::PointType point;
+  fieldPtr->TransformContinuousIndexToPhysicalPoint(fieldIndex, point);
+  for (unsigned int dim = 0; dim < dimension; ++dim)
+    {
+    point[dim] += displacement[dim];
+    }
+  inputPtr->TransformPhysicalPointToContinuousIndex(point, inputIndex);
+}
+
+template<class TInputImage, class TOutputImage, class TDisplacementField>
+bool
+StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
+::EvaluateInputContinuousIndex(const PointType & outputPoint,
+                               InputContinuousIndexType & inputIndex)
+{
+  const InputImageType * inputPtr = this->GetInput();
+  DisplacementFieldType * displacementPtr
+    = const_cast<DisplacementFieldType*>(this->GetDisplacementField());
+  if (!inputPtr || !displacementPtr)
+    {
+    return false;
+    }
+
+  const DisplacementFieldRegionType defRegion = displacementPtr->GetLargestPossibleRegion();
+  FieldContinuousIndexType fieldIndex;
+  displacementPtr->TransformPhysicalPointToContinuousIndex(outputPoint, fieldIndex);
+
+  typename DisplacementFieldType::RegionType nodesRegion;
+  for (unsigned int dim = 0; dim < DisplacementFieldType::ImageDimension; ++dim)
+    {
+    if (fieldIndex[dim] < static_cast<double>(defRegion.GetIndex(dim)) ||
+        fieldIndex[dim] > static_cast<double>(defRegion.GetIndex(dim)+defRegion.GetSize(dim)-1))
+      {
+      return false;
+      }
+    nodesRegion.SetIndex(dim, static_cast<typename DisplacementFieldType::IndexValueType>(vcl_floor(fieldIndex[dim])));
+    nodesRegion.SetSize(dim, 2);
+    }
+  nodesRegion.Crop(defRegion);
+
+  // Update the field on the surrounding nodes only
+  displacementPtr->SetRequestedRegion(nodesRegion);
+  displacementPtr->PropagateRequestedRegion();
+  displacementPtr->UpdateOutputData();
+
+  this->FieldIndexToInputIndex(displacementPtr, inputPtr, fieldIndex, inputIndex);
+  return true;
+}
+
 
 template<class TInputImage, class TOutputImage, class TDisplacementField>
 void
@@ -258,6 +465,12 @@ StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
 {
   Superclass::GenerateOutputInformation();
 
+  // Start a new set of read amplification statistics
+  m_LastReadAmplification = 0.;
+  m_RequestedInputPixels = 0.;
+  m_FootprintInputPixels = 0.;
+  m_NumberOfRequestedRegions = 0;
+
   // Set the NoData flag to the edge padding value
   itk::MetaDataDictionary& dict = this->GetOutput()->GetMetaDataDictionary();
   std::vector<bool> noDataValueAvailable;
@@ -290,6 +503,301 @@ StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
   itk::EncapsulateMetaData<std::vector<double> >(dict,MetaDataKey::NoDataValue,noDataValue);
 }
 
+template<class TInputImage, class TOutputImage, class TDisplacementField>
+void
+StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
+::BeforeThreadedGenerateData()
+{
+  Superclass::BeforeThreadedGenerateData();
+
+  m_WarpKernel = GENERIC_KERNEL;
+
+  typedef typename InputImageType::InternalPixelType               InputInternalPixelType;
+  typedef typename itk::DefaultConvertPixelTraits<InputInternalPixelType>::ComponentType
+                                                                   InputComponentType;
+
+  // The row-based kernels read the input buffer directly: they need a 2D
+  // input storing one scalar per component (otb::Image or otb::VectorImage)
+  if (!m_FastWarp
+      || InputImageType::ImageDimension != 2
+      || sizeof(InputInternalPixelType) != sizeof(InputComponentType)
+      || this->GetInput()->GetBufferedRegion().GetNumberOfPixels() == 0)
+    {
+    return;
+    }
+
+  const InterpolatorType * interpolator = this->GetInterpolator();
+
+  typedef itk::NearestNeighborInterpolateImageFunction<InputImageType, CoordRepType> NearestInterpolatorType;
+  typedef itk::LinearInterpolateImageFunction<InputImageType, CoordRepType>          LinearInterpolatorType;
+  typedef BCOInterpolateImageFunctionBase<InputImageType, CoordRepType>              BCOInterpolatorType;
+
+  if (dynamic_cast<const NearestInterpolatorType *>(interpolator))
+    {
+    m_WarpKernel = NEAREST_KERNEL;
+    }
+  else if (dynamic_cast<const LinearInterpolatorType *>(interpolator))
+    {
+    m_WarpKernel = LINEAR_KERNEL;
+    }
+  else if (const BCOInterpolatorType * bco = dynamic_cast<const BCOInterpolatorType *>(interpolator))
+    {
+    m_WarpKernel = BCO_KERNEL;
+    m_BCORadius = bco->GetRadius();
+    m_BCOAlpha = bco->GetAlpha();
+    }
+}
+
+template<class TInputImage, class TOutputImage, class TDisplacementField>
+void
+StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
+::EvaluateBCOCoefficients(double x, double * coefs) const
+{
+  const unsigned int winSize = 2 * m_BCORadius + 1;
+  const double offset = x - vcl_floor(x + 0.5);
+  const double step = 4. / static_cast<double>(2 * m_BCORadius);
+  double position = - static_cast<double>(m_BCORadius) * step;
+  double sum = 0.;
+
+  for (unsigned int i = 0; i < winSize; ++i)
+    {
+    const double dist = vcl_abs(position - offset * step);
+    double coef = 0.;
+    if (dist <= 1.)
+      {
+      coef = (m_BCOAlpha + 2.) * dist * dist * dist - (m_BCOAlpha + 3.) * dist * dist + 1;
+      }
+    else if (dist <= 2.)
+      {
+      coef = m_BCOAlpha * dist * dist * dist - 5 * m_BCOAlpha * dist * dist
+        + 8 * m_BCOAlpha * dist - 4 * m_BCOAlpha;
+      }
+    coefs[i] = coef;
+    sum += coef;
+    position += step;
+    }
+
+  for (unsigned int i = 0; i < winSize; ++i)
+    {
+    coefs[i] /= sum;
+    }
+}
+
+template<class TInputImage, class TOutputImage, class TDisplacementField>
+void
+StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
+::FastWarpThreadedGenerateData(
+  const OutputImageRegionType& outputRegionForThread,
+  itk::ThreadIdType itkNotUsed(threadId) )
+{
+  typedef typename InputImageType::InternalPixelType                InputInternalPixelType;
+  typedef typename itk::DefaultConvertPixelTraits<InputInternalPixelType>::ComponentType
+                                                                    InputComponentType;
+  typedef typename itk::NumericTraits<InputComponentType>::RealType RealType;
+  typedef typename itk::DefaultConvertPixelTraits<PixelType>::ComponentType
+                                                                    OutputComponentType;
+  typedef itk::ContinuousIndex<double, InputImageType::ImageDimension> ContinuousIndexType;
+
+  const InputImageType * inputPtr = this->GetInput();
+  const DisplacementFieldType * fieldPtr = this->GetDisplacementField();
+  OutputImageType * outputPtr = this->GetOutput();
+
+  const unsigned int nbComp = inputPtr->GetNumberOfComponentsPerPixel();
+  const PixelType paddingValue = this->GetEdgePaddingValue();
+
+  // Input buffer layout
+  const InputComponentType * inBuffer =
+    reinterpret_cast<const InputComponentType *>(inputPtr->GetBufferPointer());
+  const typename InputImageType::RegionType inRegion = inputPtr->GetBufferedRegion();
+  const long inStartX = inRegion.GetIndex(0);
+  const long inStartY = inRegion.GetIndex(1);
+  const long inEndX = inStartX + static_cast<long>(inRegion.GetSize(0)) - 1;
+  const long inEndY = inStartY + static_cast<long>(inRegion.GetSize(1)) - 1;
+  const long inLineStride = static_cast<long>(inRegion.GetSize(0) * nbComp);
+
+  // Displacement field buffer layout, and extent of the whole grid used to
+  // mask the output pixels falling outside of it
+  const DisplacementValueType * fieldBuffer = fieldPtr->GetBufferPointer();
+  const DisplacementFieldRegionType fieldRegion = fieldPtr->GetBufferedRegion();
+  const long fieldStartX = fieldRegion.GetIndex(0);
+  const long fieldStartY = fieldRegion.GetIndex(1);
+  const long fieldEndX = fieldStartX + static_cast<long>(fieldRegion.GetSize(0)) - 1;
+  const long fieldEndY = fieldStartY + static_cast<long>(fieldRegion.GetSize(1)) - 1;
+  const long fieldLineStride = static_cast<long>(fieldRegion.GetSize(0));
+  const DisplacementFieldRegionType defRegion = fieldPtr->GetLargestPossibleRegion();
+  const double gridMinX = static_cast<double>(defRegion.GetIndex(0));
+  const double gridMinY = static_cast<double>(defRegion.GetIndex(1));
+  const double gridMaxX = gridMinX + static_cast<double>(defRegion.GetSize(0)) - 1;
+  const double gridMaxY = gridMinY + static_cast<double>(defRegion.GetSize(1)) - 1;
+
+  // Mappings are affine: derive the per-column steps of the continuous
+  // indices, and the linear part mapping a displacement to an input offset
+  IndexType index = outputRegionForThread.GetIndex();
+  PointType p0, p1;
+  outputPtr->TransformIndexToPhysicalPoint(index, p0);
+  ++index[0];
+  outputPtr->TransformIndexToPhysicalPoint(index, p1);
+
+  ContinuousIndexType c0, c1;
+  double fieldStep[2], inStep[2], dispToIndex[2][2];
+  fieldPtr->TransformPhysicalPointToContinuousIndex(p0, c0);
+  fieldPtr->TransformPhysicalPointToContinuousIndex(p1, c1);
+  fieldStep[0] = c1[0] - c0[0];
+  fieldStep[1] = c1[1] - c0[1];
+  inputPtr->TransformPhysicalPointToContinuousIndex(p0, c0);
+  inputPtr->TransformPhysicalPointToContinuousIndex(p1, c1);
+  inStep[0] = c1[0] - c0[0];
+  inStep[1] = c1[1] - c0[1];
+  for (unsigned int j = 0; j < 2; ++j)
+    {
+    p1 = p0;
+    p1[j] += 1.;
+    inputPtr->TransformPhysicalPointToContinuousIndex(p1, c1);
+    dispToIndex[0][j] = c1[0] - c0[0];
+    dispToIndex[1][j] = c1[1] - c0[1];
+    }
+
+  // Per-thread work buffers, allocated once
+  PixelType outPixel = paddingValue;
+  itk::NumericTraits<PixelType>::SetLength(outPixel, nbComp);
+  std::vector<RealType> value(nbComp);
+  std::vector<RealType> lineValue(nbComp);
+  const unsigned int winSize = 2 * m_BCORadius + 1;
+  std::vector<double> coefX(winSize);
+  std::vector<double> coefY(winSize);
+
+  itk::ImageScanlineIterator<OutputImageType> outputIt(outputPtr, outputRegionForThread);
+  outputIt.GoToBegin();
+
+  while (!outputIt.IsAtEnd())
+    {
+    outputPtr->TransformIndexToPhysicalPoint(outputIt.GetIndex(), p0);
+    ContinuousIndexType fieldIndex, inIndex;
+    fieldPtr->TransformPhysicalPointToContinuousIndex(p0, fieldIndex);
+    inputPtr->TransformPhysicalPointToContinuousIndex(p0, inIndex);
+
+    for (; !outputIt.IsAtEndOfLine(); ++outputIt,
+           fieldIndex[0] += fieldStep[0], fieldIndex[1] += fieldStep[1],
+           inIndex[0] += inStep[0], inIndex[1] += inStep[1])
+      {
+      const double fx = fieldIndex[0];
+      const double fy = fieldIndex[1];
+      if (!(fx >= gridMinX && fx <= gridMaxX && fy >= gridMinY && fy <= gridMaxY))
+        {
+        outputIt.Set(paddingValue);
+        continue;
+        }
+
+      // Bilinear interpolation of the displacement, clamped to the buffer
+      const long bx = static_cast<long>(vcl_floor(fx));
+      const long by = static_cast<long>(vcl_floor(fy));
+      const double dx = fx - bx;
+      const double dy = fy - by;
+      const long fx0 = std::min(std::max(bx, fieldStartX), fieldEndX) - fieldStartX;
+      const long fx1 = std::min(std::max(bx + 1, fieldStartX), fieldEndX) - fieldStartX;
+      const long fy0 = std::min(std::max(by, fieldStartY), fieldEndY) - fieldStartY;
+      const long fy1 = std::min(std::max(by + 1, fieldStartY), fieldEndY) - fieldStartY;
+      const DisplacementValueType & d00 = fieldBuffer[fy0 * fieldLineStride + fx0];
+      const DisplacementValueType & d10 = fieldBuffer[fy0 * fieldLineStride + fx1];
+      const DisplacementValueType & d01 = fieldBuffer[fy1 * fieldLineStride + fx0];
+      const DisplacementValueType & d11 = fieldBuffer[fy1 * fieldLineStride + fx1];
+      double disp[2];
+      for (unsigned int j = 0; j < 2; ++j)
+        {
+        disp[j] = (1. - dy) * ((1. - dx) * d00[j] + dx * d10[j])
+          + dy * ((1. - dx) * d01[j] + dx * d11[j]);
+        }
+
+      const double x = inIndex[0] + dispToIndex[0][0] * disp[0] + dispToIndex[0][1] * disp[1];
+      const double y = inIndex[1] + dispToIndex[1][0] * disp[0] + dispToIndex[1][1] * disp[1];
+
+      // Same bounds as itk::ImageFunction::IsInsideBuffer()
+      if (!(x >= inStartX - 0.5 && x < inEndX + 0.5 && y >= inStartY - 0.5 && y < inEndY + 0.5))
+        {
+        outputIt.Set(paddingValue);
+        continue;
+        }
+
+      switch (m_WarpKernel)
+        {
+        case NEAREST_KERNEL:
+        {
+        const long nx = std::min(std::max(static_cast<long>(vcl_floor(x + 0.5)), inStartX), inEndX);
+        const long ny = std::min(std::max(static_cast<long>(vcl_floor(y + 0.5)), inStartY), inEndY);
+        const InputComponentType * pix =
+          inBuffer + (ny - inStartY) * inLineStride + (nx - inStartX) * nbComp;
+        for (unsigned int k = 0; k < nbComp; ++k)
+          {
+          value[k] = static_cast<RealType>(pix[k]);
+          }
+        break;
+        }
+        case LINEAR_KERNEL:
+        {
+        const long lx = std::max(static_cast<long>(vcl_floor(x)), inStartX);
+        const long ly = std::max(static_cast<long>(vcl_floor(y)), inStartY);
+        const double wx = std::max(x - lx, 0.);
+        const double wy = std::max(y - ly, 0.);
+        const long ox0 = (lx - inStartX) * nbComp;
+        const long ox1 = (std::min(lx + 1, inEndX) - inStartX) * nbComp;
+        const InputComponentType * row0 = inBuffer + (ly - inStartY) * inLineStride;
+        const InputComponentType * row1 = inBuffer + (std::min(ly + 1, inEndY) - inStartY) * inLineStride;
+        const double w00 = (1. - wx) * (1. - wy);
+        const double w10 = wx * (1. - wy);
+        const double w01 = (1. - wx) * wy;
+        const double w11 = wx * wy;
+        for (unsigned int k = 0; k < nbComp; ++k)
+          {
+          value[k] = static_cast<RealType>(row0[ox0 + k]) * w00
+            + static_cast<RealType>(row0[ox1 + k]) * w10
+            + static_cast<RealType>(row1[ox0 + k]) * w01
+            + static_cast<RealType>(row1[ox1 + k]) * w11;
+          }
+        break;
+        }
+        case BCO_KERNEL:
+        {
+        EvaluateBCOCoefficients(x, &coefX[0]);
+        EvaluateBCOCoefficients(y, &coefY[0]);
+        const long baseX = static_cast<long>(vcl_floor(x + 0.5)) - m_BCORadius;
+        const long baseY = static_cast<long>(vcl_floor(y + 0.5)) - m_BCORadius;
+        std::fill(value.begin(), value.end(), itk::NumericTraits<RealType>::Zero);
+        for (unsigned int j = 0; j < winSize; ++j)
+          {
+          const long ny = std::min(std::max(baseY + static_cast<long>(j), inStartY), inEndY);
+          const InputComponentType * row = inBuffer + (ny - inStartY) * inLineStride;
+          std::fill(lineValue.begin(), lineValue.end(), itk::NumericTraits<RealType>::Zero);
+          for (unsigned int i = 0; i < winSize; ++i)
+            {
+            const long nx = std::min(std::max(baseX + static_cast<long>(i), inStartX), inEndX);
+            const InputComponentType * pix = row + (nx - inStartX) * nbComp;
+            for (unsigned int k = 0; k < nbComp; ++k)
+              {
+              lineValue[k] += static_cast<RealType>(pix[k]) * coefX[i];
+              }
+            }
+          for (unsigned int k = 0; k < nbComp; ++k)
+            {
+            value[k] += lineValue[k] * coefY[j];
+            }
+          }
+        break;
+        }
+        default:
+          break;
+        }
+
+      for (unsigned int k = 0; k < nbComp; ++k)
+        {
+        itk::DefaultConvertPixelTraits<PixelType>::SetNthComponent(
+          k, outPixel, static_cast<OutputComponentType>(value[k]));
+        }
+      outputIt.Set(outPixel);
+      }
+    outputIt.NextLine();
+    }
+}
+
 template<class TInputImage, class TOutputImage, class TDisplacementField>
 void
 StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
@@ -297,6 +805,13 @@ StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
   const OutputImageRegionType& outputRegionForThread,
   itk::ThreadIdType threadId )
   {
+  if (m_WarpKernel != GENERIC_KERNEL)
+    {
+    // the row-based path handles the grid mask itself
+    this->FastWarpThreadedGenerateData(outputRegionForThread, threadId);
+    return;
+    }
+
   // the superclass itk::WarpImageFilter is doing the actual warping
   Superclass::ThreadedGenerateData(outputRegionForThread,threadId);
 
@@ -340,6 +855,9 @@ StreamingWarpImageFilter<TInputImage, TOutputImage, TDisplacementField>
  {
   Superclass::PrintSelf(os, indent);
   os << indent << "Maximum displacement: " << m_MaximumDisplacement << std::endl;
+  os << indent << "Fast warp: " << m_FastWarp << std::endl;
+  os << indent << "Read amplification: " << this->GetReadAmplification()
+     << " over " << m_NumberOfRequestedRegions << " requested regions" << std::endl;
  }
 
 } // end namespace otb
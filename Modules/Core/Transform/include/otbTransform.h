@@ -23,6 +23,7 @@
 
 #include "itkTransform.h"
 #include "vnl/vnl_vector_fixed.h"
+#include <vector>
 
 
 namespace otb
@@ -100,6 +101,23 @@ public:
 
   OutputPointType TransformPoint(const InputPointType  & ) const ITK_OVERRIDE
     { return OutputPointType(); }
+
+  /** Containers of points for batch transformations. */
+  typedef std::vector<InputPointType>  InputPointContainerType;
+  typedef std::vector<OutputPointType> OutputPointContainerType;
+
+  /** Method to transform a batch of points. The default implementation
+   * calls TransformPoint() on each point; subclasses with a cheaper batch
+   * path (e.g. sensor models) should override it. */
+  virtual void TransformPoints(const InputPointContainerType & inputPoints,
+                               OutputPointContainerType & outputPoints) const
+  {
+    outputPoints.resize(inputPoints.size());
+    for (unsigned long i = 0; i < inputPoints.size(); ++i)
+      {
+      outputPoints[i] = this->TransformPoint(inputPoints[i]);
+      }
+  }
   
   using Superclass::TransformVector;
   /**  Method to transform a vector. */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbGenericRSTransform.h"
+#include "otbImage.h"
+#include "otbImageFileReader.h"
+#include "otbDEMHandler.h"
+#include <ogr_spatialref.h>
+
+int otbGenericRSTransformNativeRPC(int argc, char* argv[])
+{
+  if (argc != 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " input grid_size img_tol" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // This test compares the image to WGS84 and WGS84 to image transforms
+  // built with the native RPC model with the ones built with the OSSIM
+  // model. Errors are measured in input image pixels.
+  typedef otb::Image<double>              ImageType;
+  typedef otb::ImageFileReader<ImageType> ReaderType;
+  typedef otb::GenericRSTransform<>       TransformType;
+  typedef TransformType::InputPointType   PointType;
+
+  const unsigned int gridSize = atoi(argv[2]);
+  const double imgTol = atof(argv[3]);
+
+  otb::DEMHandler::Instance()->SetDefaultHeightAboveEllipsoid(0);
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(argv[1]);
+  reader->UpdateOutputInformation();
+  ImageType::Pointer image = reader->GetOutput();
+
+  OGRSpatialReference oSRS;
+  oSRS.SetWellKnownGeogCS("WGS84");
+  char * wgsRef = ITK_NULLPTR;
+  oSRS.exportToWkt(&wgsRef);
+
+  TransformType::Pointer transforms[2][2];
+  for (unsigned int native = 0; native < 2; ++native)
+    {
+    // Image to WGS84
+    transforms[native][0] = TransformType::New();
+    transforms[native][0]->SetUseNativeRPCModel(native == 1);
+    transforms[native][0]->SetInputKeywordList(image->GetImageKeywordlist());
+    transforms[native][0]->SetOutputProjectionRef(wgsRef);
+    transforms[native][0]->InstantiateTransform();
+
+    // WGS84 to image
+    transforms[native][1] = TransformType::New();
+    transforms[native][0]->GetInverse(transforms[native][1]);
+    }
+
+  if (!transforms[1][1]->GetUseNativeRPCModel())
+    {
+    std::cerr << "The inverse transform does not use the native RPC model" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const ImageType::SizeType size = image->GetLargestPossibleRegion().GetSize();
+
+  double maxForwardError = 0., maxInverseError = 0.;
+  for (unsigned int j = 0; j <= gridSize; ++j)
+    {
+    for (unsigned int i = 0; i <= gridSize; ++i)
+      {
+      PointType imgPoint;
+      imgPoint[0] = 0.5 + static_cast<double>(i * size[0]) / gridSize;
+      imgPoint[1] = 0.5 + static_cast<double>(j * size[1]) / gridSize;
+
+      // Native image to ground, checked by OSSIM ground to image
+      const PointType geoPoint = transforms[1][0]->TransformPoint(imgPoint);
+      const PointType ossimImgPoint = transforms[0][1]->TransformPoint(geoPoint);
+      maxForwardError = std::max(maxForwardError,
+                                 std::max(vcl_abs(ossimImgPoint[0] - imgPoint[0]),
+                                          vcl_abs(ossimImgPoint[1] - imgPoint[1])));
+
+      // Native and OSSIM ground to image
+      const PointType nativeImgPoint = transforms[1][1]->TransformPoint(geoPoint);
+      maxInverseError = std::max(maxInverseError,
+                                 std::max(vcl_abs(ossimImgPoint[0] - nativeImgPoint[0]),
+                                          vcl_abs(ossimImgPoint[1] - nativeImgPoint[1])));
+      }
+    }
+
+  std::cout << "Maximum error of the native image to ground transform: " << maxForwardError << " pixels" << std::endl;
+  std::cout << "Maximum difference of the ground to image transforms: " << maxInverseError << " pixels" << std::endl;
+
+  if (maxForwardError > imgTol || maxInverseError > imgTol)
+    {
+    std::cerr << "Native RPC transform differs from OSSIM by more than " << imgTol << " pixels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbVectorImage.h"
+#include "otbImage.h"
+#include "itkVector.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "otbBCOInterpolateImageFunction.h"
+#include "otbStreamingWarpImageFilter.h"
+
+namespace
+{
+typedef otb::VectorImage<float, 2>                                                    ImageType;
+typedef itk::Vector<double, 2>                                                         DisplacementValueType;
+typedef otb::Image<DisplacementValueType, 2>                                           DisplacementFieldType;
+typedef otb::StreamingWarpImageFilter<ImageType, ImageType, DisplacementFieldType>    WarperType;
+typedef WarperType::InterpolatorType                                                   InterpolatorType;
+
+ImageType::Pointer Warp(ImageType * input, DisplacementFieldType * field,
+                        InterpolatorType * interpolator, bool fastWarp)
+{
+  ImageType::SizeType size;
+  size[0] = 70;
+  size[1] = 60;
+  ImageType::PointType origin;
+  origin[0] = -4.5;
+  origin[1] = -2.5;
+
+  ImageType::PixelType padding(input->GetNumberOfComponentsPerPixel());
+  padding.Fill(-1000.);
+
+  DisplacementValueType maxDisplacement;
+  maxDisplacement.Fill(4.);
+
+  WarperType::Pointer warper = WarperType::New();
+  warper->SetInput(input);
+  warper->SetDisplacementField(field);
+  warper->SetInterpolator(interpolator);
+  warper->SetMaximumDisplacement(maxDisplacement);
+  warper->SetOutputOrigin(origin);
+  warper->SetOutputSize(size);
+  warper->SetEdgePaddingValue(padding);
+  warper->SetFastWarp(fastWarp);
+  warper->Update();
+
+  ImageType::Pointer output = warper->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+bool Compare(ImageType * ref, ImageType * test, double tolerance, const char * name)
+{
+  itk::ImageRegionConstIterator<ImageType> refIt(ref, ref->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<ImageType> testIt(test, test->GetLargestPossibleRegion());
+  unsigned int nbErrors = 0;
+
+  for (refIt.GoToBegin(), testIt.GoToBegin(); !refIt.IsAtEnd(); ++refIt, ++testIt)
+    {
+    for (unsigned int k = 0; k < ref->GetNumberOfComponentsPerPixel(); ++k)
+      {
+      if (vcl_abs(refIt.Get()[k] - testIt.Get()[k]) > tolerance)
+        {
+        if (nbErrors < 10)
+          {
+          std::cerr << name << ": pixel " << refIt.GetIndex() << " band " << k << " generic="
+                    << refIt.Get()[k] << " fast=" << testIt.Get()[k] << std::endl;
+          }
+        ++nbErrors;
+        }
+      }
+    }
+  std::cout << name << ": " << nbErrors << " differences above " << tolerance << std::endl;
+  return nbErrors == 0;
+}
+}
+
+int otbStreamingWarpImageFilterFastWarp(int argc, char * argv[])
+{
+  // The fast kernels must match the generic warp within the given
+  // absolute tolerance (default 1e-3)
+  const double tolerance = argc > 1 ? atof(argv[1]) : 1e-3;
+
+  // 3-band input with a smooth content plus some texture
+  ImageType::RegionType inRegion;
+  inRegion.SetSize(0, 60);
+  inRegion.SetSize(1, 50);
+  ImageType::Pointer input = ImageType::New();
+  input->SetRegions(inRegion);
+  input->SetNumberOfComponentsPerPixel(3);
+  input->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> inIt(input, inRegion);
+  ImageType::PixelType pixel(3);
+  for (inIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt)
+    {
+    const double x = inIt.GetIndex()[0];
+    const double y = inIt.GetIndex()[1];
+    pixel[0] = 100. * vcl_sin(0.3 * x) * vcl_cos(0.2 * y);
+    pixel[1] = x * y;
+    pixel[2] = static_cast<float>((static_cast<int>(x) * 7 + static_cast<int>(y) * 13) % 17);
+    inIt.Set(pixel);
+    }
+
+  // Coarse displacement grid not covering the whole output
+  DisplacementFieldType::RegionType fieldRegion;
+  fieldRegion.SetSize(0, 13);
+  fieldRegion.SetSize(1, 11);
+  DisplacementFieldType::SpacingType fieldSpacing;
+  fieldSpacing.Fill(5.);
+  DisplacementFieldType::PointType fieldOrigin;
+  fieldOrigin[0] = -1.5;
+  fieldOrigin[1] = 0.;
+  DisplacementFieldType::Pointer field = DisplacementFieldType::New();
+  field->SetRegions(fieldRegion);
+  field->SetSpacing(fieldSpacing);
+  field->SetOrigin(fieldOrigin);
+  field->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<DisplacementFieldType> fieldIt(field, fieldRegion);
+  for (fieldIt.GoToBegin(); !fieldIt.IsAtEnd(); ++fieldIt)
+    {
+    const double x = fieldIt.GetIndex()[0];
+    const double y = fieldIt.GetIndex()[1];
+    DisplacementValueType displacement;
+    displacement[0] = 2.3 * vcl_sin(0.7 * x + 0.2 * y) + 0.37;
+    displacement[1] = 1.7 * vcl_cos(0.4 * x - 0.5 * y) - 0.21;
+    fieldIt.Set(displacement);
+    }
+
+  typedef itk::NearestNeighborInterpolateImageFunction<ImageType, double> NearestType;
+  typedef itk::LinearInterpolateImageFunction<ImageType, double>          LinearType;
+  typedef otb::BCOInterpolateImageFunction<ImageType, double>             BCOType;
+
+  std::vector<InterpolatorType::Pointer> interpolators;
+  std::vector<std::string> names;
+  interpolators.push_back(NearestType::New().GetPointer());
+  names.push_back("nearest");
+  interpolators.push_back(LinearType::New().GetPointer());
+  names.push_back("linear");
+  BCOType::Pointer bco = BCOType::New();
+  bco->SetRadius(3);
+  bco->SetAlpha(-0.75);
+  interpolators.push_back(bco.GetPointer());
+  names.push_back("bco");
+
+  bool success = true;
+  for (unsigned int i = 0; i < interpolators.size(); ++i)
+    {
+    ImageType::Pointer ref = Warp(input, field, interpolators[i], false);
+    ImageType::Pointer test = Warp(input, field, interpolators[i], true);
+    success = Compare(ref, test, tolerance, names[i].c_str()) && success;
+    }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
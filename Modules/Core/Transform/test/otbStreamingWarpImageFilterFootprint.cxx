@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbImage.h"
+#include "otbMath.h"
+#include "itkVector.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "otbStreamingWarpImageFilter.h"
+#include "otbWarpStreamingManager.h"
+#include "otbNumberOfDivisionsTiledStreamingManager.h"
+
+namespace
+{
+typedef otb::Image<float, 2>                                                          ImageType;
+typedef itk::Vector<double, 2>                                                        DisplacementValueType;
+typedef otb::Image<DisplacementValueType, 2>                                          DisplacementFieldType;
+typedef otb::StreamingWarpImageFilter<ImageType, ImageType, DisplacementFieldType>   WarperType;
+typedef WarperType::InputContinuousIndexType                                          ContinuousIndexType;
+
+// Input position of an output pixel, interpolated bilinearly from the whole field
+bool MappedIndex(const ImageType * output, const ImageType * input,
+                 const DisplacementFieldType * field, const ImageType::IndexType & index,
+                 ContinuousIndexType & inputIndex)
+{
+  ImageType::PointType point;
+  output->TransformIndexToPhysicalPoint(index, point);
+  itk::ContinuousIndex<double, 2> fieldIndex;
+  field->TransformPhysicalPointToContinuousIndex(point, fieldIndex);
+
+  const DisplacementFieldType::RegionType region = field->GetLargestPossibleRegion();
+  DisplacementFieldType::IndexType base;
+  double fraction[2];
+  for (unsigned int dim = 0; dim < 2; ++dim)
+    {
+    const double last = region.GetIndex(dim) + region.GetSize(dim) - 1.;
+    if (fieldIndex[dim] < region.GetIndex(dim) || fieldIndex[dim] > last)
+      {
+      return false;
+      }
+    base[dim] = static_cast<long>(vcl_floor(fieldIndex[dim]));
+    fraction[dim] = fieldIndex[dim] - base[dim];
+    }
+
+  DisplacementValueType displacement;
+  displacement.Fill(0.);
+  for (unsigned int corner = 0; corner < 4; ++corner)
+    {
+    DisplacementFieldType::IndexType node = base;
+    double weight = 1.;
+    for (unsigned int dim = 0; dim < 2; ++dim)
+      {
+      const bool upper = (corner >> dim) & 1;
+      weight *= upper ? fraction[dim] : 1. - fraction[dim];
+      node[dim] = std::min<long>(node[dim] + (upper ? 1 : 0),
+                                 region.GetIndex(dim) + region.GetSize(dim) - 1);
+      }
+    displacement += field->GetPixel(node) * weight;
+    }
+
+  point[0] += displacement[0];
+  point[1] += displacement[1];
+  input->TransformPhysicalPointToContinuousIndex(point, inputIndex);
+  return true;
+}
+}
+
+int otbStreamingWarpImageFilterFootprint(int itkNotUsed(argc), char * itkNotUsed(argv) [])
+{
+  ImageType::RegionType inRegion;
+  inRegion.SetSize(0, 400);
+  inRegion.SetSize(1, 400);
+  ImageType::Pointer input = ImageType::New();
+  input->SetRegions(inRegion);
+  input->Allocate();
+  input->FillBuffer(1.);
+
+  // Displacement field of a rotation of 35 degrees with some distortion,
+  // not covering the whole output
+  DisplacementFieldType::RegionType fieldRegion;
+  fieldRegion.SetSize(0, 60);
+  fieldRegion.SetSize(1, 45);
+  DisplacementFieldType::SpacingType fieldSpacing;
+  fieldSpacing.Fill(4.);
+  DisplacementFieldType::PointType fieldOrigin;
+  fieldOrigin[0] = 1.5;
+  fieldOrigin[1] = -0.5;
+  DisplacementFieldType::Pointer field = DisplacementFieldType::New();
+  field->SetRegions(fieldRegion);
+  field->SetSpacing(fieldSpacing);
+  field->SetOrigin(fieldOrigin);
+  field->Allocate();
+
+  const double angle = 35. * otb::CONST_PI / 180.;
+  itk::ImageRegionIteratorWithIndex<DisplacementFieldType> fieldIt(field, fieldRegion);
+  for (fieldIt.GoToBegin(); !fieldIt.IsAtEnd(); ++fieldIt)
+    {
+    DisplacementFieldType::PointType p;
+    field->TransformIndexToPhysicalPoint(fieldIt.GetIndex(), p);
+    const double x = vcl_cos(angle) * p[0] - vcl_sin(angle) * p[1] + 150. + 3. * vcl_sin(0.05 * p[1]);
+    const double y = vcl_sin(angle) * p[0] + vcl_cos(angle) * p[1] + 20. + 2. * vcl_cos(0.07 * p[0]);
+    DisplacementValueType displacement;
+    displacement[0] = x - p[0];
+    displacement[1] = y - p[1];
+    fieldIt.Set(displacement);
+    }
+
+  ImageType::SizeType outSize;
+  outSize[0] = 250;
+  outSize[1] = 200;
+
+  WarperType::Pointer warper = WarperType::New();
+  warper->SetInput(input);
+  warper->SetDisplacementField(field);
+  warper->SetInterpolator(itk::LinearInterpolateImageFunction<ImageType, double>::New());
+  warper->SetOutputSize(outSize);
+  warper->UpdateOutputInformation();
+
+  ImageType * output = warper->GetOutput();
+  const unsigned int radius = 1;
+  bool success = true;
+
+  // Check the input requested region of several tiles against a brute force
+  // evaluation of the positions of all the output pixels
+  for (long ty = 0; ty < 200; ty += 64)
+    {
+    for (long tx = 0; tx < 250; tx += 48)
+      {
+      ImageType::RegionType tile;
+      tile.SetIndex(0, tx);
+      tile.SetIndex(1, ty);
+      tile.SetSize(0, std::min<long>(48, 250 - tx));
+      tile.SetSize(1, std::min<long>(64, 200 - ty));
+
+      output->SetRequestedRegion(tile);
+      output->PropagateRequestedRegion();
+      const ImageType::RegionType requested = input->GetRequestedRegion();
+
+      ImageType::IndexType minIndex, maxIndex;
+      bool any = false;
+      itk::ImageRegionIteratorWithIndex<ImageType> outIt(output, tile);
+      for (outIt.GoToBegin(); !outIt.IsAtEnd(); ++outIt)
+        {
+        ContinuousIndexType position;
+        if (!MappedIndex(output, input, field, outIt.GetIndex(), position))
+          {
+          continue;
+          }
+        for (unsigned int dim = 0; dim < 2; ++dim)
+          {
+          const long nearest = static_cast<long>(vcl_floor(position[dim] + 0.5));
+          if (!any || nearest < minIndex[dim]) minIndex[dim] = nearest;
+          if (!any || nearest > maxIndex[dim]) maxIndex[dim] = nearest;
+          }
+        any = true;
+        }
+
+      if (!any)
+        {
+        continue;
+        }
+
+      // Needed region: nearest positions padded by the interpolator radius
+      ImageType::RegionType needed;
+      needed.SetIndex(minIndex);
+      needed.SetSize(0, maxIndex[0] - minIndex[0] + 1);
+      needed.SetSize(1, maxIndex[1] - minIndex[1] + 1);
+      needed.PadByRadius(radius);
+      if (!needed.Crop(inRegion))
+        {
+        continue;
+        }
+
+      // The requested region must contain the needed region, and exceed it by
+      // at most one pixel on each side (positions between pixel centres)
+      ImageType::RegionType tolerance = needed;
+      tolerance.PadByRadius(1);
+      if (!requested.IsInside(needed) || !tolerance.IsInside(requested))
+        {
+        std::cerr << "Tile " << tile.GetIndex() << tile.GetSize() << ": requested region "
+                  << requested.GetIndex() << requested.GetSize() << ", needed region "
+                  << needed.GetIndex() << needed.GetSize() << std::endl;
+        success = false;
+        }
+      }
+    }
+
+  std::cout << "Read amplification: " << warper->GetReadAmplification()
+            << " over " << warper->GetNumberOfRequestedRegions() << " regions" << std::endl;
+  if (!(warper->GetReadAmplification() >= 1.))
+    {
+    std::cerr << "Unexpected read amplification" << std::endl;
+    success = false;
+    }
+
+  // Splits ordered along the input block rows, then the input columns
+  const long blockHeight = 64;
+  typedef otb::WarpStreamingManager<WarperType>               WarpStreamingManagerType;
+  typedef otb::NumberOfDivisionsTiledStreamingManager<ImageType> TiledStreamingManagerType;
+
+  TiledStreamingManagerType::Pointer tiledManager = TiledStreamingManagerType::New();
+  tiledManager->SetNumberOfDivisions(16);
+  WarpStreamingManagerType::Pointer manager = WarpStreamingManagerType::New();
+  manager->SetSplitManager(tiledManager);
+  manager->SetWarpFilter(warper);
+  manager->SetInputBlockHeight(blockHeight);
+  manager->PrepareStreaming(output, output->GetLargestPossibleRegion());
+
+  if (manager->GetNumberOfSplits() != tiledManager->GetNumberOfSplits())
+    {
+    std::cerr << "Wrong number of splits" << std::endl;
+    success = false;
+    }
+
+  unsigned long nbPixels = 0;
+  bool outside = false;
+  long previousBlockRow = -1;
+  double previousColumn = -1e30;
+  for (unsigned int i = 0; i < manager->GetNumberOfSplits(); ++i)
+    {
+    const ImageType::RegionType split = manager->GetSplit(i);
+    nbPixels += split.GetNumberOfPixels();
+
+    bool found = false;
+    for (unsigned int j = 0; j < tiledManager->GetNumberOfSplits(); ++j)
+      {
+      found = found || tiledManager->GetSplit(j) == split;
+      }
+
+    ImageType::PointType centre;
+    itk::ContinuousIndex<double, 2> centreIndex;
+    centreIndex[0] = split.GetIndex(0) + 0.5 * (split.GetSize(0) - 1.);
+    centreIndex[1] = split.GetIndex(1) + 0.5 * (split.GetSize(1) - 1.);
+    output->TransformContinuousIndexToPhysicalPoint(centreIndex, centre);
+    ContinuousIndexType position;
+    const bool inside = warper->EvaluateInputContinuousIndex(centre, position);
+
+    const long blockRow = static_cast<long>(vcl_floor(position[1] / blockHeight));
+    if (!found || (inside && (outside || blockRow < previousBlockRow
+                              || (blockRow == previousBlockRow && position[0] < previousColumn))))
+      {
+      std::cerr << "Split " << i << " " << split.GetIndex() << split.GetSize()
+                << " is not in input block order" << std::endl;
+      success = false;
+      }
+    if (inside)
+      {
+      previousBlockRow = blockRow;
+      previousColumn = position[0];
+      }
+    outside = outside || !inside;
+    }
+
+  if (nbPixels != output->GetLargestPossibleRegion().GetNumberOfPixels())
+    {
+    std::cerr << "The splits do not cover the output" << std::endl;
+    success = false;
+    }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -30,12 +30,15 @@ void RegisterTests()
   REGISTER_TEST(otbStreamingWarpImageFilterNew);
   REGISTER_TEST(otbLogPolarTransform);
   REGISTER_TEST(otbGenericRSTransformNew);
+  REGISTER_TEST(otbGenericRSTransformNativeRPC);
   REGISTER_TEST(otbLogPolarTransformNew);
   REGISTER_TEST(otbGeocentricTransform);
   REGISTER_TEST(otbCreateProjectionWithOTB);
   REGISTER_TEST(otbGeocentricTransformNew);
   REGISTER_TEST(otbGenericMapProjection);
   REGISTER_TEST(otbStreamingWarpImageFilter);
+  REGISTER_TEST(otbStreamingWarpImageFilterFastWarp);
+  REGISTER_TEST(otbStreamingWarpImageFilterFootprint);
   REGISTER_TEST(otbSensorModelsNew);
   REGISTER_TEST(otbGenericMapProjectionNew);
   REGISTER_TEST(otbInverseLogPolarTransform);
@@ -26,6 +26,7 @@
 #include "itkNumericTraits.h"
 #include "itkArray.h"
 #include "itkZeroFluxNeumannBoundaryCondition.h"
+#include "otbOverlapSaveConvolutionImageFilter.h"
 
 namespace otb
 {
@@ -45,9 +46,12 @@ namespace otb
  * This filter allows the user to choose the boundary condtions in the template parameters.
  Default boundary conditions are zero flux Neumann boundary conditions.
  *
- * An optimized version of this filter using FFTW is available in the Orfeo ToolBox and
- * will significantly improves performances especially for large kernels
- * (see OverlapSaveConvolutionImageFilter).
+ * For large kernels on 2D images, the convolution is computed in the Fourier
+ * domain by an internal OverlapSaveConvolutionImageFilter, when ITK is built
+ * with FFTW (double implementation). The FFT is used as soon as the kernel
+ * holds at least FFTKernelSizeThreshold weights, 225 (a 15x15 kernel) being
+ * a good choice. Both methods give the same result, up to rounding errors.
+ * The threshold is 0 by default, which always uses the direct convolution.
  *
  * \sa Image
  * \sa Neighborhood
@@ -148,6 +152,15 @@ public:
   itkGetMacro(NormalizeFilter, bool);
   itkBooleanMacro(NormalizeFilter);
 
+  /** Set/Get the number of kernel weights from which the convolution is
+   * computed in the Fourier domain. 0 (the default) disables the FFT
+   * convolution. */
+  itkSetMacro(FFTKernelSizeThreshold, unsigned int);
+  itkGetConstMacro(FFTKernelSizeThreshold, unsigned int);
+
+  /** Return true if the convolution is computed in the Fourier domain */
+  bool IsFFTConvolutionSelected() const;
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro(InputHasNumericTraitsCheck,
@@ -173,6 +186,10 @@ protected:
   void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
                             itk::ThreadIdType threadId) ITK_OVERRIDE;
 
+  /** Run the internal FFT convolution filter if it is selected, the
+   * multi-threaded direct convolution otherwise */
+  void GenerateData() ITK_OVERRIDE;
+
   /** ConvolutionImageFilter needs a larger input requested region than
    * the output requested region.  As such, ConvolutionImageFilter needs
    * to provide an implementation for GenerateInputRequestedRegion()
@@ -192,6 +209,16 @@ private:
   ArrayType m_Filter;
   /** Flag for filter coefficients normalization */
   bool m_NormalizeFilter;
+  /** Number of kernel weights from which the FFT is used */
+  unsigned int m_FFTKernelSizeThreshold;
+
+  typedef OverlapSaveConvolutionImageFilter<InputImageType,
+                                            OutputImageType,
+                                            BoundaryConditionType> FFTConvolutionFilterType;
+
+  /** Internal FFT convolution filter, kept across the stream divisions so
+   * that its FFTW plans are reused */
+  typename FFTConvolutionFilterType::Pointer m_FFTConvolutionFilter;
 };
 
 } // end namespace itk
@@ -28,6 +28,7 @@
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkOffset.h"
 #include "itkProgressReporter.h"
+#include "itkProgressAccumulator.h"
 #include "itkConstantBoundaryCondition.h"
 
 #include "otbMacro.h"
@@ -44,6 +45,7 @@ ConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition, TFilterPre
   m_Filter.SetSize(3 * 3);
   m_Filter.Fill(1);
   m_NormalizeFilter = false;
+  m_FFTKernelSizeThreshold = 0;
 }
 
 template <class TInputImage, class TOutputImage, class TBoundaryCondition, class TFilterPrecision>
@@ -162,6 +164,74 @@ ConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition, TFilterPre
     }
 }
 
+template <class TInputImage, class TOutputImage, class TBoundaryCondition, class TFilterPrecision>
+bool
+ConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition, TFilterPrecision>
+::IsFFTConvolutionSelected() const
+{
+#if defined ITK_USE_FFTWD
+  return InputImageDimension == 2
+    && m_FFTKernelSizeThreshold > 0
+    && m_Filter.Size() >= m_FFTKernelSizeThreshold;
+#else
+  return false;
+#endif
+}
+
+template <class TInputImage, class TOutputImage, class TBoundaryCondition, class TFilterPrecision>
+void
+ConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition, TFilterPrecision>
+::GenerateData()
+{
+  if (!this->IsFFTConvolutionSelected())
+    {
+    Superclass::GenerateData();
+    return;
+    }
+
+  if (m_FFTConvolutionFilter.IsNull())
+    {
+    m_FFTConvolutionFilter = FFTConvolutionFilterType::New();
+    m_FFTConvolutionFilter->NormalizeFilterOff();
+    }
+
+  // The normalization is folded into the kernel, with the same norm as
+  // the direct convolution
+  double norm = 1.;
+  if (m_NormalizeFilter)
+    {
+    norm = 0.;
+    for (unsigned int i = 0; i < m_Filter.Size(); ++i)
+      {
+      norm += vcl_abs(static_cast<double>(m_Filter(i)));
+      }
+    }
+
+  typename FFTConvolutionFilterType::ArrayType kernel(m_Filter.Size());
+  for (unsigned int i = 0; i < m_Filter.Size(); ++i)
+    {
+    kernel[i] = static_cast<double>(m_Filter(i)) / norm;
+    }
+
+  // Only touch the internal filter on changes, to keep its kernel
+  // transforms
+  m_FFTConvolutionFilter->SetInput(this->GetInput());
+  m_FFTConvolutionFilter->SetRadius(m_Radius);
+  if (kernel != m_FFTConvolutionFilter->GetFilter())
+    {
+    m_FFTConvolutionFilter->SetFilter(kernel);
+    }
+  m_FFTConvolutionFilter->SetNumberOfThreads(this->GetNumberOfThreads());
+
+  typename itk::ProgressAccumulator::Pointer progress = itk::ProgressAccumulator::New();
+  progress->SetMiniPipelineFilter(this);
+  progress->RegisterInternalFilter(m_FFTConvolutionFilter, 1.0f);
+
+  m_FFTConvolutionFilter->GraftOutput(this->GetOutput());
+  m_FFTConvolutionFilter->Update();
+  this->GraftOutput(m_FFTConvolutionFilter->GetOutput());
+}
+
 /**
  * Standard "PrintSelf" method
  */
@@ -172,6 +242,7 @@ ConvolutionImageFilter<TInputImage, TOutput, TBoundaryCondition, TFilterPrecisio
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "Radius: " << m_Radius << std::endl;
+  os << indent << "FFTKernelSizeThreshold: " << m_FFTKernelSizeThreshold << std::endl;
 
 }
 
@@ -25,7 +25,15 @@
 #include "itkImage.h"
 #include "itkNumericTraits.h"
 #include "itkArray.h"
-#include "itkZeroFluxNeumannBoundaryCondition.h"
+#include "itkConstantBoundaryCondition.h"
+#include "itkFastMutexLock.h"
+#include "itkConfigure.h"
+
+#ifdef ITK_USE_FFTWD
+#include "itkFFTWCommon.h"
+#endif
+
+#include <map>
 
 namespace otb
 {
@@ -37,14 +45,21 @@ namespace otb
  * This method takes advantages of the FFTW implementation of Fast Fourrier Transform to
  * exchange an intensive convolution product in the space domain for a simple term by term
  * product in the Fourrier domain. This result in tremendous speed gain when using large kernel
- * with exactly the same result as the classical convolution filter.
+ * with the same result as the classical convolution filter (the kernel is applied in the
+ * same orientation, and the pixels outside the image are given by the boundary condition).
  *
- * \note This filter could be threaded but requires additional design due to limited thread-safety
- * of the FFTW library.
+ * The filter is multi-threaded: each thread transforms its own piece of
+ * the image. The FFTW plans only depend on the piece size, so they are
+ * created once per piece size and reused by all the threads and all the
+ * stream divisions, as is the Fourier transform of the kernel (which is
+ * recomputed only when the filter is modified).
  *
- * \note For the moment only constant zero boundary conditions are used in this filter. This could produce
- *  very different results from the classical convolution filter with zero flux neumann boundary condition,
- * especially with large kernels.
+ * Both scalar images and vector images are supported, in which case each
+ * band is convolved with the same kernel.
+ *
+ * \note The default boundary condition is a constant zero boundary
+ * condition, which is what this filter has always used. Any boundary
+ * condition can be given as template parameter.
  *
  * \note ITK must be set to use FFTW (double implementation) for this filter to work properly. If not, exception
  *  will be raised at filter creation.
@@ -52,14 +67,14 @@ namespace otb
  *
  * \sa ConvolutionImageFilter
  *
- * \ingroup ShouldBeThreaded
+ * \ingroup MultiThreaded
  * \ingroup Streamed
  * \ingroup IntensityImageFilters
  *
  * \ingroup OTBConvolution
  */
 template <class TInputImage, class TOutputImage,
-    class TBoundaryCondition = itk::ZeroFluxNeumannBoundaryCondition<TInputImage> >
+    class TBoundaryCondition = itk::ConstantBoundaryCondition<TInputImage> >
 class ITK_EXPORT OverlapSaveConvolutionImageFilter
   : public itk::ImageToImageFilter<TInputImage, TOutputImage>
 {
@@ -87,7 +102,9 @@ public:
   /** Image typedef support. */
   typedef typename InputImageType::PixelType                    InputPixelType;
   typedef typename OutputImageType::PixelType                   OutputPixelType;
-  typedef typename itk::NumericTraits<InputPixelType>::RealType InputRealType;
+  typedef typename InputImageType::InternalPixelType            InputInternalPixelType;
+  typedef typename OutputImageType::InternalPixelType           OutputInternalPixelType;
+  typedef typename itk::NumericTraits<InputInternalPixelType>::RealType InputRealType;
   typedef typename InputImageType::RegionType                   InputImageRegionType;
   typedef typename OutputImageType::RegionType                  OutputImageRegionType;
   typedef typename InputImageType::SizeType                     InputSizeType;
@@ -146,7 +163,7 @@ public:
 
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
-  itkConceptMacro(InputHasNumericTraitsCheck, (itk::Concept::HasNumericTraits<InputPixelType>));
+  itkConceptMacro(InputHasNumericTraitsCheck, (itk::Concept::HasNumericTraits<InputInternalPixelType>));
   /** End concept checking */
 #endif
 
@@ -154,14 +171,18 @@ protected:
   /** Constructor */
   OverlapSaveConvolutionImageFilter();
   /** destructor */
-  ~OverlapSaveConvolutionImageFilter() ITK_OVERRIDE {}
+  ~OverlapSaveConvolutionImageFilter() ITK_OVERRIDE;
   void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
 
-  /* TODO For the moment this class provide only a GenerateData(),
-   * due to limited thread-safety of FFTW plan creation.
-   */
-  void GenerateData() ITK_OVERRIDE;
-  // void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, itk::ThreadIdType threadId);
+  /** The output has as many components as the input */
+  void GenerateOutputInformation() ITK_OVERRIDE;
+
+  /** Flush the cached kernel transforms if the filter has been modified */
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Each thread convolves its own piece, band by band */
+  void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                            itk::ThreadIdType threadId) ITK_OVERRIDE;
 
 private:
   OverlapSaveConvolutionImageFilter(const Self &); //purposely not implemented
@@ -175,6 +196,40 @@ private:
 
   /** Flag for filter normalization */
   bool m_NormalizeFilter;
+
+#ifdef ITK_USE_FFTWD
+  typedef itk::fftw::Proxy<double> FFTWProxyType;
+
+  /** Forward and inverse plans for a piece size, with the transform
+   *  of the kernel padded to that size */
+  struct PieceTransforms
+  {
+    PieceTransforms()
+      : forwardPlan(ITK_NULLPTR), inversePlan(ITK_NULLPTR), kernelFFT(ITK_NULLPTR)
+    {}
+
+    FFTWProxyType::PlanType      forwardPlan;
+    FFTWProxyType::PlanType      inversePlan;
+    FFTWProxyType::ComplexType * kernelFFT;
+  };
+
+  /** Piece sizes (x, y) */
+  typedef std::pair<unsigned long, unsigned long>       PieceSizeType;
+  typedef std::map<PieceSizeType, PieceTransforms>      PieceTransformsMapType;
+
+  /** Return the transforms for the given piece size, creating them on
+   *  first use. Thread-safe. */
+  const PieceTransforms & GetPieceTransforms(const PieceSizeType & pieceSize);
+
+  /** Destroy all the plans and kernel transforms */
+  void ClearPieceTransforms();
+
+  PieceTransformsMapType   m_PieceTransforms;
+  itk::SimpleFastMutexLock m_PieceTransformsLock;
+
+  /** Modification time of the filter when the kernel transforms were computed */
+  itk::ModifiedTimeType    m_KernelTransformsTime;
+#endif
 };
 } // end namespace otb
 
@@ -25,19 +25,13 @@
 
 #include "otbOverlapSaveConvolutionImageFilter.h"
 
-#include "itkConstNeighborhoodIterator.h"
-#include "itkImageRegionIteratorWithIndex.h"
-#include "itkNeighborhoodAlgorithm.h"
-#include "itkOffset.h"
 #include "itkProgressReporter.h"
+#include "itkDefaultConvertPixelTraits.h"
 
-//debug
-#include "itkImageRegionIterator.h"
 #include "otbMath.h"
 
-#ifdef ITK_USE_FFTWD
-#include "itkFFTWCommon.h"
-#endif
+#include <cstring>
+#include <algorithm>
 
 namespace otb
 {
@@ -50,6 +44,18 @@ OverlapSaveConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition>
   m_Filter.SetSize(3 * 3);
   m_Filter.Fill(1);
   m_NormalizeFilter = false;
+#ifdef ITK_USE_FFTWD
+  m_KernelTransformsTime = 0;
+#endif
+}
+
+template <class TInputImage, class TOutputImage, class TBoundaryCondition>
+OverlapSaveConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition>
+::~OverlapSaveConvolutionImageFilter()
+{
+#ifdef ITK_USE_FFTWD
+  this->ClearPieceTransforms();
+#endif
 }
 
 template <class TInputImage, class TOutputImage, class TBoundaryCondition>
@@ -106,201 +112,274 @@ OverlapSaveConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition>
 #endif
   }
 
-template<class TInputImage, class TOutputImage, class TBoundaryCondition>
+template <class TInputImage, class TOutputImage, class TBoundaryCondition>
 void
 OverlapSaveConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition>
-/* TODO commented out since multi-threading is not supported for the moment
- * ::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, itk::ThreadIdType threadId) */
-::GenerateData()
+::GenerateOutputInformation()
 {
-#if defined ITK_USE_FFTWD
-  // Input/Output pointers
-  typename OutputImageType::Pointer     output = this->GetOutput();
-  typename InputImageType::ConstPointer input = this->GetInput();
-
-  /* TODO: This is a patch to switch from GenerateData() to ThreadedGenerateData(). Remove these two lines
-  once multi-threading problem is solved */
-  this->AllocateOutputs();
-  OutputImageRegionType outputRegionForThread = output->GetRequestedRegion();
+  Superclass::GenerateOutputInformation();
 
-  // Size of the filter
-  typename InputImageType::SizeType sizeOfFilter;
-  sizeOfFilter[0] = 2 * m_Radius[0] + 1;
-  sizeOfFilter[1] = 2 * m_Radius[1] + 1;
-
-  // Filter normalization
-  InputRealType norm;
-
-  // Compute the input region for the given thread
-  OutputImageRegionType inputRegionForThread = outputRegionForThread;
-  inputRegionForThread.PadByRadius(m_Radius);
-
-  // Compute the piece region for the input thread. Piece region is different
-  // from input region on boundaries
-  typename InputImageType::RegionType pieceRegion = inputRegionForThread;
-  typename InputImageType::SizeType   pieceSize = pieceRegion.GetSize();
-  typename InputImageType::IndexType  pieceIndex = pieceRegion.GetIndex();
-
-  // Compute the size of the FFT and the size of the piece
-  unsigned int pieceNbOfPixel = pieceRegion.GetNumberOfPixels();
-  unsigned int sizeFFT = (pieceSize[0] / 2 + 1) * pieceSize[1];
+  if (this->GetInput())
+    {
+    this->GetOutput()->SetNumberOfComponentsPerPixel(
+      this->GetInput()->GetNumberOfComponentsPerPixel());
+    }
+}
 
-  // Achieve the computation of the inputRegionForThread
-  inputRegionForThread.Crop(input->GetLargestPossibleRegion());
-  typename InputImageType::IndexType inputIndex = inputRegionForThread.GetIndex();
-  typename InputImageType::SizeType  inputSize =   inputRegionForThread.GetSize();
+template <class TInputImage, class TOutputImage, class TBoundaryCondition>
+void
+OverlapSaveConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition>
+::BeforeThreadedGenerateData()
+{
+#if defined ITK_USE_FFTWD
+  // The plans only depend on the piece sizes and are kept, whereas the
+  // kernel transforms are recomputed if the kernel may have changed
+  if (this->GetMTime() != m_KernelTransformsTime)
+    {
+    for (typename PieceTransformsMapType::iterator it = m_PieceTransforms.begin();
+         it != m_PieceTransforms.end(); ++it)
+      {
+      fftw_free(it->second.kernelFFT);
+      it->second.kernelFFT = ITK_NULLPTR;
+      }
+    m_KernelTransformsTime = this->GetMTime();
+    }
+#else
+  itkGenericExceptionMacro(
+    <<
+    "The OverlapSaveConvolutionImageFilter can not operate without the FFTW library (double implementation). Please build ITK with USE_FFTD set to ON, and rebuild OTB.");
+#endif
+}
 
-  //Iterator of input image
-  itk::ConstNeighborhoodIterator<InputImageType, BoundaryConditionType>
-  inputIt(m_Radius, input, inputRegionForThread);
-  inputIt.GoToBegin();
+#if defined ITK_USE_FFTWD
+template <class TInputImage, class TOutputImage, class TBoundaryCondition>
+const typename OverlapSaveConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition>::PieceTransforms &
+OverlapSaveConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition>
+::GetPieceTransforms(const PieceSizeType & pieceSize)
+{
+  m_PieceTransformsLock.Lock();
 
-  //Iterator of output image
-  itk::ImageRegionIteratorWithIndex<OutputImageType> outputIt;
-  outputIt = itk::ImageRegionIteratorWithIndex<OutputImageType>(output, outputRegionForThread);
+  PieceTransforms & transforms = m_PieceTransforms[pieceSize];
 
-  //variables for loops
-  unsigned int i, j, k, l;
+  const unsigned long pieceNbOfPixel = pieceSize.first * pieceSize.second;
+  const unsigned long sizeFFT = (pieceSize.first / 2 + 1) * pieceSize.second;
 
-  // ITK proxy to the fftw library
-  typedef typename itk::fftw::Proxy<double> FFTWProxyType;
+  if (transforms.kernelFFT == ITK_NULLPTR)
+    {
+    // Planning with FFTW_MEASURE overwrites the arrays, so that the
+    // plans are created on scratch arrays
+    FFTWProxyType::PixelType * realPiece =
+      static_cast<FFTWProxyType::PixelType*>(fftw_malloc(pieceNbOfPixel * sizeof(FFTWProxyType::PixelType)));
+    FFTWProxyType::ComplexType * complexPiece =
+      static_cast<FFTWProxyType::ComplexType*>(fftw_malloc(sizeFFT * sizeof(FFTWProxyType::ComplexType)));
+
+    if (transforms.forwardPlan == ITK_NULLPTR)
+      {
+      transforms.forwardPlan = FFTWProxyType::Plan_dft_r2c_2d(pieceSize.second,
+                                                              pieceSize.first,
+                                                              realPiece,
+                                                              complexPiece,
+                                                              FFTW_MEASURE);
+      transforms.inversePlan = FFTWProxyType::Plan_dft_c2r_2d(pieceSize.second,
+                                                              pieceSize.first,
+                                                              complexPiece,
+                                                              realPiece,
+                                                              FFTW_MEASURE);
+      }
 
-  //memory allocation
-  InputPixelType* resampledFilterPiece;
-  resampledFilterPiece = static_cast<FFTWProxyType::PixelType*>(fftw_malloc(pieceNbOfPixel * sizeof(InputPixelType)));
+    // The kernel is flipped, so that the circular convolution applies it
+    // in the same orientation as ConvolutionImageFilter
+    const unsigned int sizeOfFilterX = 2 * m_Radius[0] + 1;
+    const unsigned int sizeOfFilterY = 2 * m_Radius[1] + 1;
 
-  FFTWProxyType::ComplexType* filterPieceFFT;
-  filterPieceFFT = static_cast<FFTWProxyType::ComplexType*>(fftw_malloc(sizeFFT * sizeof(FFTWProxyType::ComplexType)));
+    InputRealType norm = 1.0;
+    if (m_NormalizeFilter)
+      {
+      norm = itk::NumericTraits<InputRealType>::Zero;
+      for (unsigned int i = 0; i < sizeOfFilterX * sizeOfFilterY; ++i)
+        {
+        norm += static_cast<InputRealType>(m_Filter(i));
+        }
+      norm = (norm == 0.0) ? 1.0 : 1 / norm;
+      }
 
-  InputPixelType *inputPiece;
-  inputPiece = static_cast<FFTWProxyType::PixelType*>(fftw_malloc(pieceNbOfPixel * sizeof(InputPixelType)));
+    memset(realPiece, 0, pieceNbOfPixel * sizeof(FFTWProxyType::PixelType));
+    unsigned int k = 0;
+    for (unsigned int j = 0; j < sizeOfFilterY; ++j)
+      {
+      for (unsigned int i = 0; i < sizeOfFilterX; ++i, ++k)
+        {
+        // The normalization by the number of pixels of the unnormalized
+        // inverse transform is folded into the kernel
+        realPiece[(sizeOfFilterX - 1 - i) + (sizeOfFilterY - 1 - j) * pieceSize.first]
+          = m_Filter.GetElement(k) * norm / pieceNbOfPixel;
+        }
+      }
 
-  FFTWProxyType::ComplexType* inputPieceFFT;
-  inputPieceFFT = static_cast<FFTWProxyType::ComplexType*>(fftw_malloc(sizeFFT * sizeof(FFTWProxyType::ComplexType)));
+    transforms.kernelFFT =
+      static_cast<FFTWProxyType::ComplexType*>(fftw_malloc(sizeFFT * sizeof(FFTWProxyType::ComplexType)));
+    fftw_execute_dft_r2c(transforms.forwardPlan, realPiece, transforms.kernelFFT);
 
-  // Image piece FFT
-  FFTWProxyType::PlanType inputPlan = FFTWProxyType::Plan_dft_r2c_2d(pieceSize[1],
-                                                                     pieceSize[0],
-                                                                     inputPiece,
-                                                                     inputPieceFFT,
-                                                                     FFTW_MEASURE);
+    fftw_free(realPiece);
+    fftw_free(complexPiece);
+    }
 
-  // left zero padding
-  unsigned int leftskip = static_cast<unsigned int>(std::max(0L, inputIndex[0] - pieceIndex[0]));
-  unsigned int topskip =  pieceSize[0] * static_cast<unsigned int>(std::max(0L, inputIndex[1] - pieceIndex[1]));
+  m_PieceTransformsLock.Unlock();
 
-  // zero filling
-  memset(inputPiece,0,pieceNbOfPixel * sizeof(InputPixelType));
+  return transforms;
+}
 
-  // Filling the buffer with image values
-  for (l = 0; l < inputSize[1]; ++l)
+template <class TInputImage, class TOutputImage, class TBoundaryCondition>
+void
+OverlapSaveConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition>
+::ClearPieceTransforms()
+{
+  m_PieceTransformsLock.Lock();
+  for (typename PieceTransformsMapType::iterator it = m_PieceTransforms.begin();
+       it != m_PieceTransforms.end(); ++it)
     {
-    for (k = 0; k < inputSize[0]; ++k)
+    if (it->second.forwardPlan != ITK_NULLPTR)
       {
-      inputPiece[topskip + pieceSize[0] * l + k + leftskip] = inputIt.GetCenterPixel();
-      ++inputIt;
+      FFTWProxyType::DestroyPlan(it->second.forwardPlan);
+      FFTWProxyType::DestroyPlan(it->second.inversePlan);
       }
+    fftw_free(it->second.kernelFFT);
     }
+  m_PieceTransforms.clear();
+  m_PieceTransformsLock.Unlock();
+}
+#endif
 
-  FFTWProxyType::Execute(inputPlan);
+template<class TInputImage, class TOutputImage, class TBoundaryCondition>
+void
+OverlapSaveConvolutionImageFilter<TInputImage, TOutputImage, TBoundaryCondition>
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, itk::ThreadIdType threadId)
+{
+#if defined ITK_USE_FFTWD
+  // Input/Output pointers
+  OutputImageType *      output = this->GetOutput();
+  const InputImageType * input = this->GetInput();
 
-  // Resampled filter FFT
-  FFTWProxyType::PlanType filterPlan = FFTWProxyType::Plan_dft_r2c_2d(pieceSize[1],
-                                                                      pieceSize[0],
-                                                                      resampledFilterPiece,
-                                                                      filterPieceFFT,
-                                                                      FFTW_MEASURE);
+  const unsigned int nbComponents = input->GetNumberOfComponentsPerPixel();
 
-  // zero filling
-  memset(resampledFilterPiece,0,pieceNbOfPixel * sizeof(InputPixelType));
+  // support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetSize()[1] * nbComponents);
 
-  k = 0;
-  // Filling the buffer with filter values
-  for (j = 0; j < sizeOfFilter[1]; ++j)
-    {
-    for (i = 0; i < sizeOfFilter[0]; ++i)
-      {
-      resampledFilterPiece[i + j * pieceSize[0]] = m_Filter.GetElement(k); //Copy values
-      ++k;
-      }
-    }
+  // The piece is the output region padded by the radius. It may extend
+  // beyond the image, where the boundary condition applies.
+  InputImageRegionType pieceRegion = outputRegionForThread;
+  pieceRegion.PadByRadius(m_Radius);
 
-  FFTWProxyType::Execute(filterPlan);
+  const typename InputImageType::SizeType  pieceSize = pieceRegion.GetSize();
+  const typename InputImageType::IndexType pieceIndex = pieceRegion.GetIndex();
 
-  // memory allocation for inverse FFT
-  FFTWProxyType::ComplexType* multipliedFFTarray;
-  multipliedFFTarray = static_cast<FFTWProxyType::ComplexType*>(fftw_malloc(sizeFFT * sizeof(FFTWProxyType::ComplexType)));
+  const unsigned long pieceNbOfPixel = pieceRegion.GetNumberOfPixels();
+  const unsigned long sizeFFT = (pieceSize[0] / 2 + 1) * pieceSize[1];
 
-  FFTWProxyType::PixelType* inverseFFTpiece;
-  inverseFFTpiece = static_cast<FFTWProxyType::PixelType*>(fftw_malloc(pieceNbOfPixel * sizeof(FFTWProxyType::PixelType)));
+  const PieceTransforms & transforms = this->GetPieceTransforms(PieceSizeType(pieceSize[0], pieceSize[1]));
 
-  // Inverse FFT of the product of FFT (actually do filtering here)
-  FFTWProxyType::PlanType outputPlan = FFTWProxyType::Plan_dft_c2r_2d(pieceSize[1],
-                                                                      pieceSize[0],
-                                                                      multipliedFFTarray,
-                                                                      inverseFFTpiece,
-                                                                      FFTW_MEASURE);
+  // Thread buffers, aligned as the ones used for planning
+  FFTWProxyType::PixelType * inputPiece =
+    static_cast<FFTWProxyType::PixelType*>(fftw_malloc(pieceNbOfPixel * sizeof(FFTWProxyType::PixelType)));
+  FFTWProxyType::ComplexType * inputPieceFFT =
+    static_cast<FFTWProxyType::ComplexType*>(fftw_malloc(sizeFFT * sizeof(FFTWProxyType::ComplexType)));
 
-  // Filling the buffer with complex product values
-  for (k = 0; k < sizeFFT; ++k)
-    {
-    //complex mutiplication
-    multipliedFFTarray[k][0] = inputPieceFFT[k][0] * filterPieceFFT[k][0] - inputPieceFFT[k][1] * filterPieceFFT[k][1];
-    multipliedFFTarray[k][1] = inputPieceFFT[k][0] * filterPieceFFT[k][1] + inputPieceFFT[k][1] * filterPieceFFT[k][0];
-    }
+  // Part of each piece row lying in the input buffer
+  const InputImageRegionType bufferedRegion = input->GetBufferedRegion();
+  const long bufferFirstX = bufferedRegion.GetIndex()[0];
+  const long bufferFirstY = bufferedRegion.GetIndex()[1];
+  const long bufferStride = bufferedRegion.GetSize()[0];
+  const long bufferLastX = bufferFirstX + bufferStride - 1;
+  const long bufferLastY = bufferFirstY + static_cast<long>(bufferedRegion.GetSize()[1]) - 1;
+  const long innerFirstX = std::max<long>(pieceIndex[0], bufferFirstX);
+  const long innerLastX  = std::min<long>(pieceIndex[0] + pieceSize[0] - 1, bufferLastX);
+
+  const InputInternalPixelType * inputBuffer = input->GetBufferPointer();
 
-  FFTWProxyType::Execute(outputPlan);
+  const OutputImageRegionType outputBufferedRegion = output->GetBufferedRegion();
+  const long outputStride = outputBufferedRegion.GetSize()[0];
+  OutputInternalPixelType * outputBuffer = output->GetBufferPointer();
 
-  // Computing the filter normalization
+  const unsigned int sizeOfFilterX = 2 * m_Radius[0] + 1;
+  const unsigned int sizeOfFilterY = 2 * m_Radius[1] + 1;
 
-  if (m_NormalizeFilter)
+  BoundaryConditionType boundaryCondition;
+  typedef itk::DefaultConvertPixelTraits<InputPixelType> InputPixelTraits;
+
+  for (unsigned int band = 0; band < nbComponents; ++band)
     {
-    norm = itk::NumericTraits<InputRealType>::Zero;
-    for (i = 0; i < sizeOfFilter[0] * sizeOfFilter[1]; ++i)
+    // Filling the piece with image values
+    for (unsigned long l = 0; l < pieceSize[1]; ++l)
       {
-      norm += static_cast<InputRealType>(m_Filter(i));
+      typename InputImageType::IndexType index;
+      index[1] = pieceIndex[1] + l;
+      FFTWProxyType::PixelType * pieceRow = inputPiece + l * pieceSize[0];
+
+      const bool rowInside = index[1] >= bufferFirstY && index[1] <= bufferLastY;
+
+      for (unsigned long k = 0; k < pieceSize[0]; ++k)
+        {
+        index[0] = pieceIndex[0] + k;
+        if (rowInside && index[0] >= innerFirstX && index[0] <= innerLastX)
+          {
+          // Jump over the part of the row lying in the buffer
+          const InputInternalPixelType * bufferRow = inputBuffer
+            + ((index[1] - bufferFirstY) * bufferStride + (index[0] - bufferFirstX)) * nbComponents + band;
+          for (long x = innerFirstX; x <= innerLastX; ++x, ++k)
+            {
+            pieceRow[k] = static_cast<FFTWProxyType::PixelType>(bufferRow[(x - innerFirstX) * nbComponents]);
+            }
+          --k;
+          }
+        else
+          {
+          // A constant boundary condition may hold a default, empty,
+          // vector pixel: missing components are zero
+          const InputPixelType outsidePixel = boundaryCondition.GetPixel(index, input);
+          pieceRow[k] = band < itk::NumericTraits<InputPixelType>::GetLength(outsidePixel)
+            ? static_cast<FFTWProxyType::PixelType>(InputPixelTraits::GetNthComponent(band, outsidePixel))
+            : 0.;
+          }
+        }
       }
-    if (norm == 0.0)
+
+    fftw_execute_dft_r2c(transforms.forwardPlan, inputPiece, inputPieceFFT);
+
+    // Product with the kernel transform (actually do filtering here)
+    for (unsigned long k = 0; k < sizeFFT; ++k)
       {
-      norm = 1.0;
+      const double re = inputPieceFFT[k][0] * transforms.kernelFFT[k][0] - inputPieceFFT[k][1] * transforms.kernelFFT[k][1];
+      const double im = inputPieceFFT[k][0] * transforms.kernelFFT[k][1] + inputPieceFFT[k][1] * transforms.kernelFFT[k][0];
+      inputPieceFFT[k][0] = re;
+      inputPieceFFT[k][1] = im;
       }
-    else
+
+    fftw_execute_dft_c2r(transforms.inversePlan, inputPieceFFT, inputPiece);
+
+    // Fill the output image. The valid part of the circular convolution
+    // starts at the kernel size minus one.
+    for (unsigned long l = 0; l < outputRegionForThread.GetSize()[1]; ++l)
       {
-      norm = 1 / norm;
+      const FFTWProxyType::PixelType * validRow = inputPiece
+        + (l + sizeOfFilterY - 1) * pieceSize[0] + (sizeOfFilterX - 1);
+      OutputInternalPixelType * outputRow = outputBuffer
+        + ((outputRegionForThread.GetIndex()[1] + l - outputBufferedRegion.GetIndex()[1]) * outputStride
+           + (outputRegionForThread.GetIndex()[0] - outputBufferedRegion.GetIndex()[0])) * nbComponents + band;
+
+      for (unsigned long k = 0; k < outputRegionForThread.GetSize()[0]; ++k)
+        {
+        outputRow[k * nbComponents] = static_cast<OutputInternalPixelType>(validRow[k]);
+        }
+      progress.CompletedPixel();
       }
     }
-  else
-    {
-    norm = 1.0;
-    }
-
-  // Fill the output image
-  outputIt.GoToBegin();
-  while (!outputIt.IsAtEnd())
-    {
-    typename InputImageType::IndexType index = outputIt.GetIndex();
-    unsigned int                       linearIndex =
-      (index[1] + sizeOfFilter[1] - 1 -
-       outputRegionForThread.GetIndex()[1]) * pieceSize[0] - 1 + index[0] + sizeOfFilter[0] -
-      outputRegionForThread.GetIndex()[0];
-    outputIt.Set(static_cast<OutputPixelType>((inverseFFTpiece[linearIndex] /
-                                               pieceNbOfPixel) * static_cast<double>(norm)));
-    ++outputIt;
-    }
-
-  // destroy the FFT plans
-  FFTWProxyType::DestroyPlan(inputPlan);
-  FFTWProxyType::DestroyPlan(filterPlan);
-  FFTWProxyType::DestroyPlan(outputPlan);
 
   //frees memory
-  fftw_free(resampledFilterPiece);
   fftw_free(inputPiece);
-  fftw_free(filterPieceFFT);
   fftw_free(inputPieceFFT);
-  fftw_free(multipliedFFTarray);
-  fftw_free(inverseFFTpiece);
 #else
+  (void) outputRegionForThread;
+  (void) threadId;
   itkGenericExceptionMacro(
     <<
     "The OverlapSaveConvolutionImageFilter can not operate without the FFTW library (double implementation). Please build ITK with USE_FFTD set to ON, and rebuild OTB.");
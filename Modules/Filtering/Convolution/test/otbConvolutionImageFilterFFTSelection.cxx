@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbImage.h"
+#include "otbImageFileReader.h"
+#include "otbImageFileWriter.h"
+#include "otbConvolutionImageFilter.h"
+#include "itkConstantBoundaryCondition.h"
+
+int otbConvolutionImageFilterFFTSelection(int itkNotUsed(argc), char * argv[])
+{
+  const char * inputFileName = argv[1];
+  const char * directFileName = argv[2];
+  const char * fftFileName = argv[3];
+
+  typedef double PixelType;
+  const unsigned int Dimension = 2;
+
+  typedef otb::Image<PixelType, Dimension>                         ImageType;
+  typedef otb::ImageFileReader<ImageType>                          ReaderType;
+  typedef otb::ImageFileWriter<ImageType>                          WriterType;
+  typedef itk::ConstantBoundaryCondition<ImageType>                BoundaryConditionType;
+  typedef otb::ConvolutionImageFilter<ImageType, ImageType,
+                                      BoundaryConditionType>       ConvFilterType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(inputFileName);
+
+  // Non symmetric kernel, to check the orientation of both methods
+  ConvFilterType::InputSizeType radius;
+  radius[0] = 8;
+  radius[1] = 5;
+  ConvFilterType::ArrayType filterCoeffs;
+  filterCoeffs.SetSize((2 * radius[0] + 1) * (2 * radius[1] + 1));
+  for (unsigned int i = 0; i < filterCoeffs.Size(); ++i)
+    {
+    filterCoeffs[i] = static_cast<double>((i * 7) % 13) - 4.;
+    }
+
+  ConvFilterType::Pointer direct = ConvFilterType::New();
+  direct->SetRadius(radius);
+  direct->SetFilter(filterCoeffs);
+  direct->NormalizeFilterOn();
+  direct->SetFFTKernelSizeThreshold(0);
+  direct->SetInput(reader->GetOutput());
+
+  ConvFilterType::Pointer fft = ConvFilterType::New();
+  fft->SetRadius(radius);
+  fft->SetFilter(filterCoeffs);
+  fft->NormalizeFilterOn();
+  fft->SetFFTKernelSizeThreshold(filterCoeffs.Size());
+  fft->SetInput(reader->GetOutput());
+
+  if (direct->IsFFTConvolutionSelected() || !fft->IsFFTConvolutionSelected())
+    {
+    std::cerr << "Unexpected convolution method selection" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  WriterType::Pointer writer1 = WriterType::New();
+  writer1->SetFileName(directFileName);
+  writer1->SetInput(direct->GetOutput());
+  writer1->Update();
+
+  // Stream the FFT convolution, so that the cached transforms are reused
+  WriterType::Pointer writer2 = WriterType::New();
+  writer2->SetFileName(fftFileName);
+  writer2->SetInput(fft->GetOutput());
+  writer2->SetNumberOfDivisionsStrippedStreaming(5);
+  writer2->Update();
+
+  return EXIT_SUCCESS;
+}
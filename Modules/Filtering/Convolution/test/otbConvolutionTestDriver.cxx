@@ -28,6 +28,7 @@ void RegisterTests()
 #if defined(ITK_USE_FFTWD)
   REGISTER_TEST(otbOverlapSaveConvolutionImageFilter);
   REGISTER_TEST(otbCompareOverlapSaveAndClassicalConvolutionWithGaborFilter);
+  REGISTER_TEST(otbConvolutionImageFilterFFTSelection);
 #endif
   REGISTER_TEST(otbGaborFilterGenerator);
   REGISTER_TEST(otbGaborFilterGeneratorNew);
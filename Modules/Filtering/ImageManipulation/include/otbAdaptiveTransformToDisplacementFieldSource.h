@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbAdaptiveTransformToDisplacementFieldSource_h
+#define otbAdaptiveTransformToDisplacementFieldSource_h
+
+#include "itkTransformToDisplacementFieldSource.h"
+#include "otbTransform.h"
+#include <vector>
+
+namespace otb
+{
+
+/** \class AdaptiveTransformToDisplacementFieldSource
+ * \brief Generate a displacement field from a transform, evaluating the
+ * transform only where bilinear interpolation is not accurate enough.
+ *
+ * The output grid is tiled in cells of 2^SubdivisionLevels nodes. The
+ * transform is evaluated exactly at the cell corners and at the cell
+ * centre. If the bilinear interpolation of the corner displacements at the
+ * centre differs from the exact displacement by more than Tolerance, the
+ * cell is split in four and the test is repeated on each sub-cell, down to
+ * single grid steps. Nodes of accepted cells are filled by bilinear
+ * interpolation, so smooth areas of the transform cost a handful of exact
+ * evaluations per cell while rough areas (relief for sensor models) get
+ * the full grid density.
+ *
+ * When Tolerance is zero, when SubdivisionLevels is zero or when the
+ * transform is linear, the filter behaves exactly like
+ * itk::TransformToDisplacementFieldSource.
+ *
+ * In the adaptive case, if the transform is an otb::Transform, the exact
+ * evaluations at the cell corners of a region are sent in a single call
+ * to its TransformPoints() batch method.
+ *
+ * The largest error measured at an accepted cell centre, the number of
+ * exact evaluations and the number of generated nodes are accumulated
+ * over all the updates following an output information update.
+ *
+ * \sa itk::TransformToDisplacementFieldSource
+ *
+ * \ingroup OTBImageManipulation
+ */
+template <class TOutputImage, class TTransformPrecisionType = double>
+class ITK_EXPORT AdaptiveTransformToDisplacementFieldSource
+  : public itk::TransformToDisplacementFieldSource<TOutputImage, TTransformPrecisionType>
+{
+public:
+  /** Standard class typedefs. */
+  typedef AdaptiveTransformToDisplacementFieldSource                                     Self;
+  typedef itk::TransformToDisplacementFieldSource<TOutputImage, TTransformPrecisionType> Superclass;
+  typedef itk::SmartPointer<Self>                                                        Pointer;
+  typedef itk::SmartPointer<const Self>                                                  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(AdaptiveTransformToDisplacementFieldSource, itk::TransformToDisplacementFieldSource);
+
+  typedef typename Superclass::OutputImageType       OutputImageType;
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+  typedef typename Superclass::TransformType         TransformType;
+  typedef typename Superclass::PixelType             PixelType;
+  typedef typename Superclass::PixelValueType        PixelValueType;
+  typedef typename Superclass::IndexType             IndexType;
+  typedef typename Superclass::PointType             PointType;
+  typedef typename Superclass::SizeType              SizeType;
+  typedef typename Superclass::SpacingType           SpacingType;
+  typedef typename Superclass::OriginType            OriginType;
+  typedef typename Superclass::RegionType            RegionType;
+
+  /** Maximum interpolation error allowed, in the physical units of the
+   * transform output space (0 disables the adaptive evaluation) */
+  itkSetMacro(Tolerance, double);
+  itkGetConstMacro(Tolerance, double);
+
+  /** Number of subdivisions of the initial cells: cells span
+   * 2^SubdivisionLevels grid steps (0 disables the adaptive evaluation) */
+  itkSetMacro(SubdivisionLevels, unsigned int);
+  itkGetConstMacro(SubdivisionLevels, unsigned int);
+
+  /** Largest interpolation error measured at an accepted cell centre */
+  itkGetConstMacro(MaximumError, double);
+
+  /** Number of exact transform evaluations */
+  itkGetConstMacro(NumberOfExactEvaluations, unsigned long);
+
+  /** Number of generated grid nodes */
+  itkGetConstMacro(NumberOfNodes, unsigned long);
+
+  /** Number of transform evaluations saved compared to a dense grid */
+  unsigned long GetNumberOfSavedEvaluations() const
+  {
+    return m_NumberOfNodes > m_NumberOfExactEvaluations ? m_NumberOfNodes - m_NumberOfExactEvaluations : 0;
+  }
+
+  /** Reset the evaluation statistics */
+  void GenerateOutputInformation(void) ITK_OVERRIDE;
+
+protected:
+  AdaptiveTransformToDisplacementFieldSource();
+  ~AdaptiveTransformToDisplacementFieldSource() ITK_OVERRIDE {}
+
+  void PrintSelf(std::ostream & os, itk::Indent indent) const ITK_OVERRIDE;
+
+  void BeforeThreadedGenerateData(void) ITK_OVERRIDE;
+
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            itk::ThreadIdType threadId) ITK_OVERRIDE;
+
+  void AfterThreadedGenerateData(void) ITK_OVERRIDE;
+
+private:
+  AdaptiveTransformToDisplacementFieldSource(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+
+  /** Per-thread evaluation statistics */
+  struct ThreadStatistics
+  {
+    double        m_MaximumError;
+    unsigned long m_NumberOfExactEvaluations;
+    unsigned long m_NumberOfNodes;
+  };
+
+  /** Transform type providing batch evaluations */
+  typedef otb::Transform<TTransformPrecisionType,
+                         TOutputImage::ImageDimension,
+                         TOutputImage::ImageDimension> BatchTransformType;
+  typedef typename BatchTransformType::InputPointContainerType  BatchPointContainerType;
+
+  /** Displacement at a grid node, computed with the transform */
+  PixelType EvaluateExact(long x, long y, ThreadStatistics & stats) const;
+
+  /** Test and fill (or split) the cell [x0,x1]x[y0,y1] given its corner
+   * displacements, writing only the nodes inside region */
+  void ProcessCell(long x0, long y0, long x1, long y1,
+                   const PixelType & d00, const PixelType & d10,
+                   const PixelType & d01, const PixelType & d11,
+                   const OutputImageRegionType & region,
+                   ThreadStatistics & stats);
+
+  double        m_Tolerance;
+  unsigned int  m_SubdivisionLevels;
+
+  double        m_MaximumError;
+  unsigned long m_NumberOfExactEvaluations;
+  unsigned long m_NumberOfNodes;
+
+  std::vector<ThreadStatistics> m_ThreadStatistics;
+  bool                          m_Adaptive;
+  const BatchTransformType *    m_BatchTransform;
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbAdaptiveTransformToDisplacementFieldSource.txx"
+#endif
+
+#endif
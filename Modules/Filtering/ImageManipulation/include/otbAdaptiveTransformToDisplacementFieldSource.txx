@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbAdaptiveTransformToDisplacementFieldSource_txx
+#define otbAdaptiveTransformToDisplacementFieldSource_txx
+
+#include "otbAdaptiveTransformToDisplacementFieldSource.h"
+
+namespace otb
+{
+
+template <class TOutputImage, class TTransformPrecisionType>
+AdaptiveTransformToDisplacementFieldSource<TOutputImage, TTransformPrecisionType>
+::AdaptiveTransformToDisplacementFieldSource()
+  : m_Tolerance(0.),
+    m_SubdivisionLevels(3),
+    m_MaximumError(0.),
+    m_NumberOfExactEvaluations(0),
+    m_NumberOfNodes(0),
+    m_Adaptive(false),
+    m_BatchTransform(ITK_NULLPTR)
+{
+}
+
+template <class TOutputImage, class TTransformPrecisionType>
+void
+AdaptiveTransformToDisplacementFieldSource<TOutputImage, TTransformPrecisionType>
+::GenerateOutputInformation(void)
+{
+  Superclass::GenerateOutputInformation();
+
+  m_MaximumError = 0.;
+  m_NumberOfExactEvaluations = 0;
+  m_NumberOfNodes = 0;
+}
+
+template <class TOutputImage, class TTransformPrecisionType>
+void
+AdaptiveTransformToDisplacementFieldSource<TOutputImage, TTransformPrecisionType>
+::BeforeThreadedGenerateData(void)
+{
+  Superclass::BeforeThreadedGenerateData();
+
+  m_Adaptive = m_Tolerance > 0.
+    && m_SubdivisionLevels > 0
+    && OutputImageType::ImageDimension == 2
+    && !this->GetTransform()->IsLinear();
+
+  // Linear transforms are better handled by the superclass
+  m_BatchTransform = this->GetTransform()->IsLinear() ? ITK_NULLPTR
+    : dynamic_cast<const BatchTransformType *>(this->GetTransform());
+
+  ThreadStatistics init;
+  init.m_MaximumError = 0.;
+  init.m_NumberOfExactEvaluations = 0;
+  init.m_NumberOfNodes = 0;
+  m_ThreadStatistics.assign(this->GetNumberOfThreads(), init);
+}
+
+template <class TOutputImage, class TTransformPrecisionType>
+void
+AdaptiveTransformToDisplacementFieldSource<TOutputImage, TTransformPrecisionType>
+::AfterThreadedGenerateData(void)
+{
+  if (!m_Adaptive)
+    {
+    // Dense evaluation: one transform call per node
+    const unsigned long nbNodes = this->GetOutput()->GetRequestedRegion().GetNumberOfPixels();
+    m_NumberOfExactEvaluations += nbNodes;
+    m_NumberOfNodes += nbNodes;
+    return;
+    }
+
+  for (unsigned int i = 0; i < m_ThreadStatistics.size(); ++i)
+    {
+    m_MaximumError = std::max(m_MaximumError, m_ThreadStatistics[i].m_MaximumError);
+    m_NumberOfExactEvaluations += m_ThreadStatistics[i].m_NumberOfExactEvaluations;
+    m_NumberOfNodes += m_ThreadStatistics[i].m_NumberOfNodes;
+    }
+}
+
+template <class TOutputImage, class TTransformPrecisionType>
+typename AdaptiveTransformToDisplacementFieldSource<TOutputImage, TTransformPrecisionType>::PixelType
+AdaptiveTransformToDisplacementFieldSource<TOutputImage, TTransformPrecisionType>
+::EvaluateExact(long x, long y, ThreadStatistics & stats) const
+{
+  IndexType index;
+  index[0] = x;
+  index[1] = y;
+
+  PointType outputPoint;
+  this->GetOutput()->TransformIndexToPhysicalPoint(index, outputPoint);
+  const PointType transformedPoint = this->GetTransform()->TransformPoint(outputPoint);
+
+  PixelType displacement;
+  for (unsigned int i = 0; i < 2; ++i)
+    {
+    displacement[i] = static_cast<PixelValueType>(transformedPoint[i] - outputPoint[i]);
+    }
+  ++stats.m_NumberOfExactEvaluations;
+  return displacement;
+}
+
+template <class TOutputImage, class TTransformPrecisionType>
+void
+AdaptiveTransformToDisplacementFieldSource<TOutputImage, TTransformPrecisionType>
+::ProcessCell(long x0, long y0, long x1, long y1,
+              const PixelType & d00, const PixelType & d10,
+              const PixelType & d01, const PixelType & d11,
+              const OutputImageRegionType & region,
+              ThreadStatistics & stats)
+{
+  const long rx0 = region.GetIndex(0);
+  const long ry0 = region.GetIndex(1);
+  const long rx1 = rx0 + static_cast<long>(region.GetSize(0)) - 1;
+  const long ry1 = ry0 + static_cast<long>(region.GetSize(1)) - 1;
+
+  const long mx = (x0 + x1) / 2;
+  const long my = (y0 + y1) / 2;
+  const double du = x1 > x0 ? 1. / static_cast<double>(x1 - x0) : 0.;
+  const double dv = y1 > y0 ? 1. / static_cast<double>(y1 - y0) : 0.;
+
+  bool accept = (x1 - x0 <= 1 && y1 - y0 <= 1);
+  PixelType dc;
+
+  if (!accept)
+    {
+    // Compare the exact displacement at the cell centre with the bilinear
+    // interpolation of the corners
+    dc = this->EvaluateExact(mx, my, stats);
+    const double u = (mx - x0) * du;
+    const double v = (my - y0) * dv;
+    double error = 0.;
+    for (unsigned int i = 0; i < 2; ++i)
+      {
+      const double interpolated = (1. - v) * ((1. - u) * d00[i] + u * d10[i])
+        + v * ((1. - u) * d01[i] + u * d11[i]);
+      error += (dc[i] - interpolated) * (dc[i] - interpolated);
+      }
+    error = vcl_sqrt(error);
+
+    if (error <= m_Tolerance)
+      {
+      stats.m_MaximumError = std::max(stats.m_MaximumError, error);
+      accept = true;
+      }
+    }
+
+  if (accept)
+    {
+    OutputImageType * outputPtr = this->GetOutput();
+    IndexType index;
+    for (index[1] = std::max(y0, ry0); index[1] <= std::min(y1, ry1); ++index[1])
+      {
+      const double v = (index[1] - y0) * dv;
+      for (index[0] = std::max(x0, rx0); index[0] <= std::min(x1, rx1); ++index[0])
+        {
+        const double u = (index[0] - x0) * du;
+        PixelType displacement;
+        for (unsigned int i = 0; i < 2; ++i)
+          {
+          displacement[i] = static_cast<PixelValueType>((1. - v) * ((1. - u) * d00[i] + u * d10[i])
+                                                        + v * ((1. - u) * d01[i] + u * d11[i]));
+          }
+        outputPtr->SetPixel(index, displacement);
+        }
+      }
+    return;
+    }
+
+  // Split the cell (along the axes that can still be split)
+  long xs[3], ys[3];
+  unsigned int nbX = 0, nbY = 0;
+  xs[nbX++] = x0;
+  if (x1 - x0 > 1)
+    {
+    xs[nbX++] = mx;
+    }
+  xs[nbX++] = x1;
+  ys[nbY++] = y0;
+  if (y1 - y0 > 1)
+    {
+    ys[nbY++] = my;
+    }
+  ys[nbY++] = y1;
+
+  PixelType nodes[3][3];
+  bool      known[3][3];
+  for (unsigned int j = 0; j < nbY; ++j)
+    {
+    for (unsigned int i = 0; i < nbX; ++i)
+      {
+      known[j][i] = false;
+      if (xs[i] == mx && ys[j] == my)
+        {
+        nodes[j][i] = dc;
+        known[j][i] = true;
+        }
+      }
+    }
+  nodes[0][0] = d00;
+  nodes[0][nbX - 1] = d10;
+  nodes[nbY - 1][0] = d01;
+  nodes[nbY - 1][nbX - 1] = d11;
+  known[0][0] = known[0][nbX - 1] = known[nbY - 1][0] = known[nbY - 1][nbX - 1] = true;
+
+  for (unsigned int j = 0; j + 1 < nbY; ++j)
+    {
+    for (unsigned int i = 0; i + 1 < nbX; ++i)
+      {
+      // Skip the sub-cells outside of the region to generate
+      if (xs[i + 1] < rx0 || xs[i] > rx1 || ys[j + 1] < ry0 || ys[j] > ry1)
+        {
+        continue;
+        }
+      for (unsigned int b = j; b <= j + 1; ++b)
+        {
+        for (unsigned int a = i; a <= i + 1; ++a)
+          {
+          if (!known[b][a])
+            {
+            nodes[b][a] = this->EvaluateExact(xs[a], ys[b], stats);
+            known[b][a] = true;
+            }
+          }
+        }
+      this->ProcessCell(xs[i], ys[j], xs[i + 1], ys[j + 1],
+                        nodes[j][i], nodes[j][i + 1], nodes[j + 1][i], nodes[j + 1][i + 1],
+                        region, stats);
+      }
+    }
+}
+
+template <class TOutputImage, class TTransformPrecisionType>
+void
+AdaptiveTransformToDisplacementFieldSource<TOutputImage, TTransformPrecisionType>
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                       itk::ThreadIdType threadId)
+{
+  if (!m_Adaptive)
+    {
+    // Dense generation: keep the per-point evaluation of the superclass so
+    // that the field is bit-identical to itk::TransformToDisplacementFieldSource
+    Superclass::ThreadedGenerateData(outputRegionForThread, threadId);
+    return;
+    }
+
+  if (outputRegionForThread.GetNumberOfPixels() == 0)
+    {
+    return;
+    }
+
+  ThreadStatistics & stats = m_ThreadStatistics[threadId];
+  stats.m_NumberOfNodes += outputRegionForThread.GetNumberOfPixels();
+
+  // Cells are anchored on the largest possible region so that the result
+  // does not depend on the region splitting
+  const RegionType largest = this->GetOutput()->GetLargestPossibleRegion();
+  const long cellSize = 1L << m_SubdivisionLevels;
+  long start[2], end[2], firstCell[2], nbNodes[2];
+  for (unsigned int dim = 0; dim < 2; ++dim)
+    {
+    start[dim] = largest.GetIndex(dim);
+    end[dim] = start[dim] + static_cast<long>(largest.GetSize(dim)) - 1;
+    const long r0 = outputRegionForThread.GetIndex(dim) - start[dim];
+    const long r1 = r0 + static_cast<long>(outputRegionForThread.GetSize(dim)) - 1;
+    firstCell[dim] = r0 / cellSize;
+    nbNodes[dim] = std::max((r1 + cellSize - 1) / cellSize - firstCell[dim], 1L) + 1;
+    }
+
+  // Exact displacements on the cell corners
+  std::vector<long> nodeX(nbNodes[0]), nodeY(nbNodes[1]);
+  for (long i = 0; i < nbNodes[0]; ++i)
+    {
+    nodeX[i] = std::min(start[0] + (firstCell[0] + i) * cellSize, end[0]);
+    }
+  for (long j = 0; j < nbNodes[1]; ++j)
+    {
+    nodeY[j] = std::min(start[1] + (firstCell[1] + j) * cellSize, end[1]);
+    }
+
+  std::vector<PixelType> corners(nbNodes[0] * nbNodes[1]);
+  if (m_BatchTransform != ITK_NULLPTR)
+    {
+    // All the corners of the region in a single batch
+    const OutputImageType * outputPtr = this->GetOutput();
+    BatchPointContainerType outputPoints(corners.size()), transformedPoints;
+    IndexType index;
+    for (long j = 0; j < nbNodes[1]; ++j)
+      {
+      index[1] = nodeY[j];
+      for (long i = 0; i < nbNodes[0]; ++i)
+        {
+        index[0] = nodeX[i];
+        outputPtr->TransformIndexToPhysicalPoint(index, outputPoints[j * nbNodes[0] + i]);
+        }
+      }
+    m_BatchTransform->TransformPoints(outputPoints, transformedPoints);
+    for (unsigned long n = 0; n < corners.size(); ++n)
+      {
+      for (unsigned int i = 0; i < 2; ++i)
+        {
+        corners[n][i] = static_cast<PixelValueType>(transformedPoints[n][i] - outputPoints[n][i]);
+        }
+      }
+    stats.m_NumberOfExactEvaluations += corners.size();
+    }
+  else
+    {
+    for (long j = 0; j < nbNodes[1]; ++j)
+      {
+      for (long i = 0; i < nbNodes[0]; ++i)
+        {
+        corners[j * nbNodes[0] + i] = this->EvaluateExact(nodeX[i], nodeY[j], stats);
+        }
+      }
+    }
+
+  for (long j = 0; j + 1 < nbNodes[1]; ++j)
+    {
+    for (long i = 0; i + 1 < nbNodes[0]; ++i)
+      {
+      this->ProcessCell(nodeX[i], nodeY[j], nodeX[i + 1], nodeY[j + 1],
+                        corners[j * nbNodes[0] + i], corners[j * nbNodes[0] + i + 1],
+                        corners[(j + 1) * nbNodes[0] + i], corners[(j + 1) * nbNodes[0] + i + 1],
+                        outputRegionForThread, stats);
+      }
+    }
+}
+
+template <class TOutputImage, class TTransformPrecisionType>
+void
+AdaptiveTransformToDisplacementFieldSource<TOutputImage, TTransformPrecisionType>
+::PrintSelf(std::ostream & os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Tolerance: " << m_Tolerance << std::endl;
+  os << indent << "SubdivisionLevels: " << m_SubdivisionLevels << std::endl;
+  os << indent << "MaximumError: " << m_MaximumError << std::endl;
+  os << indent << "NumberOfExactEvaluations: " << m_NumberOfExactEvaluations << std::endl;
+  os << indent << "NumberOfNodes: " << m_NumberOfNodes << std::endl;
+}
+
+} // end namespace otb
+
+#endif
@@ -130,46 +130,47 @@ GridResampleImageFilter<TInputImage, TOutputImage, TInterpolatorPrecision>
 
   typename TOutputImage::RegionType outputRequestedRegion = outputPtr->GetRequestedRegion();
 
-  IndexType outULIndex,outLRIndex;
-
   typedef itk::ContinuousIndex<double,TInputImage::ImageDimension> ContinuousIndexType;
-  
-  ContinuousIndexType inULCIndex,inLRCIndex;
- 
-  // Get output image requested region corners as Index
-  outULIndex = outputRequestedRegion.GetIndex();
-  outLRIndex = outULIndex+outputRequestedRegion.GetSize();
-  outLRIndex[0]-=1;
-  outLRIndex[1]-=1;
-  
-  // Transform to physiscal points
-  PointType outULPoint,outLRPoint;
-  outputPtr->TransformIndexToPhysicalPoint(outULIndex,outULPoint);
-  outputPtr->TransformIndexToPhysicalPoint(outLRIndex,outLRPoint);
 
-  // Transform to input image Index
-  inputPtr->TransformPhysicalPointToContinuousIndex(outULPoint,inULCIndex);
-  inputPtr->TransformPhysicalPointToContinuousIndex(outLRPoint,inLRCIndex);
+  // The mapping is affine: the footprint of the output requested region is
+  // the bounding box of its corners, all of them being needed when the
+  // input or output directions are not diagonal
+  ContinuousIndexType inMinCIndex, inMaxCIndex;
+  for (unsigned int corner = 0; corner < (1u << ImageDimension); ++corner)
+    {
+    IndexType outIndex = outputRequestedRegion.GetIndex();
+    for(unsigned int dim = 0; dim < ImageDimension;++dim)
+      {
+      if ((corner >> dim) & 1)
+        {
+        outIndex[dim] += outputRequestedRegion.GetSize()[dim] - 1;
+        }
+      }
+
+    // Transform to physical point, then to input image continuous index
+    PointType outPoint;
+    ContinuousIndexType inCIndex;
+    outputPtr->TransformIndexToPhysicalPoint(outIndex,outPoint);
+    inputPtr->TransformPhysicalPointToContinuousIndex(outPoint,inCIndex);
+
+    for(unsigned int dim = 0; dim < ImageDimension;++dim)
+      {
+      if (corner == 0 || inCIndex[dim] < inMinCIndex[dim])
+        inMinCIndex[dim] = inCIndex[dim];
+      if (corner == 0 || inCIndex[dim] > inMaxCIndex[dim])
+        inMaxCIndex[dim] = inCIndex[dim];
+      }
+    }
 
   SizeType inSize;
   IndexType inULIndex,inLRIndex;
-   
-  // Reorder index properly and compute size
+
   for(unsigned int dim = 0; dim < ImageDimension;++dim)
     {
-    if(inULCIndex[dim] > inLRCIndex[dim])
-      {
-      // swap
-      typename ContinuousIndexType::ValueType tmp(inULCIndex[dim]);
-      inULCIndex[dim]=inLRCIndex[dim];
-      inLRCIndex[dim]=tmp;
-      }
-
     // Ensure correct rounding of coordinates
-   
-    inULIndex[dim] = vcl_floor(inULCIndex[dim]);
-    inLRIndex[dim] = vcl_ceil(inLRCIndex[dim]);
-    
+    inULIndex[dim] = vcl_floor(inMinCIndex[dim]);
+    inLRIndex[dim] = vcl_ceil(inMaxCIndex[dim]);
+
     inSize[dim] = static_cast<typename SizeType::SizeValueType>(inLRIndex[dim]-inULIndex[dim])+1;
     }
 
@@ -23,7 +23,7 @@
 
 #include "itkImageToImageFilter.h"
 #include "otbStreamingWarpImageFilter.h"
-#include "itkTransformToDisplacementFieldSource.h"
+#include "otbAdaptiveTransformToDisplacementFieldSource.h"
 #include "itkLinearInterpolateImageFunction.h"
 #include "otbImage.h"
 #include "itkVector.h"
@@ -88,8 +88,8 @@ public:
                                    DisplacementFieldType>        WarpImageFilterType;
 
   /** Internal filters typedefs*/
-  typedef itk::TransformToDisplacementFieldSource<DisplacementFieldType,
-                                                 double>        DisplacementFieldGeneratorType;
+  typedef AdaptiveTransformToDisplacementFieldSource<DisplacementFieldType,
+                                                     double>    DisplacementFieldGeneratorType;
   typedef typename DisplacementFieldGeneratorType::TransformType TransformType;
   typedef typename DisplacementFieldGeneratorType::SizeType      SizeType;
   typedef typename DisplacementFieldGeneratorType::SpacingType   SpacingType;
@@ -124,6 +124,37 @@ public:
     return m_SignedOutputSpacing;
   };
 
+  /** Adaptive displacement field: maximum interpolation error of the field,
+   * in the physical units of the input image (0, the default, disables it).
+   * When enabled, the DisplacementFieldSpacing cells are subdivided where
+   * needed, down to DisplacementFieldSubdivisionLevels levels but never
+   * below the output spacing. */
+  void SetDisplacementFieldTolerance(double tolerance)
+  {
+    m_DisplacementFilter->SetTolerance(tolerance);
+    this->Modified();
+  }
+  double GetDisplacementFieldTolerance() const
+  {
+    return m_DisplacementFilter->GetTolerance();
+  }
+  itkSetMacro(DisplacementFieldSubdivisionLevels, unsigned int);
+  itkGetConstMacro(DisplacementFieldSubdivisionLevels, unsigned int);
+
+  /** Statistics of the displacement field generation */
+  double GetDisplacementFieldMaximumError() const
+  {
+    return m_DisplacementFilter->GetMaximumError();
+  }
+  unsigned long GetNumberOfExactEvaluations() const
+  {
+    return m_DisplacementFilter->GetNumberOfExactEvaluations();
+  }
+  unsigned long GetNumberOfSavedEvaluations() const
+  {
+    return m_DisplacementFilter->GetNumberOfSavedEvaluations();
+  }
+
   /** The resampled image parameters */
   // Output Origin
   void SetOutputOrigin(const OriginType & origin)
@@ -162,6 +193,45 @@ public:
                                         EdgePaddingValue,
                                         typename OutputImageType::PixelType);
 
+  /** Displacement field generated from the transform. Its content is
+   * only valid once the output information has been updated. */
+  DisplacementFieldType * GetDisplacementField()
+  {
+    return m_DisplacementFilter->GetOutput();
+  }
+
+  /** Precomputed displacement field (for instance a field previously
+   * exported with GetDisplacementField()). When set, the transform is not
+   * evaluated and the input image is only warped with this field. */
+  void SetInputDisplacementField(const DisplacementFieldType * field)
+  {
+    if (m_InputDisplacementField != field)
+      {
+      m_InputDisplacementField = field;
+      this->Modified();
+      }
+  }
+  const DisplacementFieldType * GetInputDisplacementField() const
+  {
+    return m_InputDisplacementField;
+  }
+
+  /** Read amplification of the input requests of the internal warp filter */
+  otbGetObjectMemberConstMacro(WarpFilter, ReadAmplification, double);
+  otbGetObjectMemberConstMacro(WarpFilter, LastReadAmplification, double);
+
+  /** Continuous index in the input image of an output physical point */
+  typedef typename WarpImageFilterType::InputContinuousIndexType InputContinuousIndexType;
+  bool EvaluateInputContinuousIndex(const OriginType & outputPoint,
+                                    InputContinuousIndexType & inputIndex)
+  {
+    return m_WarpFilter->EvaluateInputContinuousIndex(outputPoint, inputIndex);
+  }
+
+  /** Use the row-based warp kernels of the internal warp filter */
+  otbSetObjectMemberMacro(WarpFilter, FastWarp, bool);
+  otbGetObjectMemberMacro(WarpFilter, FastWarp, bool);
+
   /** Import output parameters from a given image */
   void SetOutputParametersFromImage(const ImageBaseType * image);
 
@@ -194,6 +264,12 @@ private:
   //spacing
   SpacingType m_SignedOutputSpacing;
 
+  // Maximum number of subdivisions of the adaptive displacement field
+  unsigned int m_DisplacementFieldSubdivisionLevels;
+
+  // Optional precomputed displacement field
+  typename DisplacementFieldType::ConstPointer       m_InputDisplacementField;
+
   typename DisplacementFieldGeneratorType::Pointer   m_DisplacementFilter;
   typename WarpImageFilterType::Pointer             m_WarpFilter;
 };
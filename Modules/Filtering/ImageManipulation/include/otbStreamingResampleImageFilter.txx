@@ -36,6 +36,7 @@ StreamingResampleImageFilter<TInputImage, TOutputImage, TInterpolatorPrecisionTy
   m_DisplacementFilter = DisplacementFieldGeneratorType::New();
   m_WarpFilter        = WarpImageFilterType::New();
   m_SignedOutputSpacing = m_DisplacementFilter->GetOutputSpacing();
+  m_DisplacementFieldSubdivisionLevels = 3;
   // Initialize the displacement field spacing to zero : inconsistent
   // value
   this->SetDisplacementFieldSpacing(itk::NumericTraits<SpacingType>::ZeroValue());
@@ -67,6 +68,18 @@ void
 StreamingResampleImageFilter<TInputImage, TOutputImage, TInterpolatorPrecisionType>
 ::GenerateOutputInformation()
 {
+  // A precomputed displacement field bypasses the field generation
+  if (m_InputDisplacementField.IsNotNull())
+    {
+    m_WarpFilter->SetDisplacementField(m_InputDisplacementField);
+    m_WarpFilter->SetInput(this->GetInput());
+    m_WarpFilter->GraftOutput(this->GetOutput());
+    m_WarpFilter->UpdateOutputInformation();
+    this->GraftOutput(m_WarpFilter->GetOutput());
+    return;
+    }
+  m_WarpFilter->SetDisplacementField(m_DisplacementFilter->GetOutput());
+
   // check the output spacing of the displacement field
   if(this->GetDisplacementFieldSpacing()== itk::NumericTraits<SpacingType>::ZeroValue())
     {
@@ -76,6 +89,33 @@ StreamingResampleImageFilter<TInputImage, TOutputImage, TInterpolatorPrecisionTy
   // Retrieve output largest region
   SizeType largestSize       = this->GetOutputSize();
 
+  // The adaptive displacement field is generated on its finest grid, which
+  // is never finer than the output grid
+  SpacingType fieldSpacing;
+  for(unsigned int dim = 0; dim < InputImageType::ImageDimension; ++dim)
+    {
+    fieldSpacing[dim] = vcl_abs(this->GetDisplacementFieldSpacing()[dim]);
+    }
+  unsigned int levels = 0;
+  if (m_DisplacementFilter->GetTolerance() > 0.)
+    {
+    bool canSplit = true;
+    while (canSplit && levels < m_DisplacementFieldSubdivisionLevels)
+      {
+      for(unsigned int dim = 0; dim < InputImageType::ImageDimension; ++dim)
+        {
+        canSplit = canSplit && 0.5 * fieldSpacing[dim] >= vcl_abs(this->GetOutputSpacing()[dim]);
+        }
+      if (canSplit)
+        {
+        fieldSpacing *= 0.5;
+        ++levels;
+        }
+      }
+    }
+  m_DisplacementFilter->SetSubdivisionLevels(levels);
+  m_DisplacementFilter->SetOutputSpacing(fieldSpacing);
+
   // Set up displacement field filter
   SizeType displacementFieldLargestSize;
 
@@ -90,7 +130,7 @@ StreamingResampleImageFilter<TInputImage, TOutputImage, TInterpolatorPrecisionTy
     displacementFieldLargestSize[dim] = static_cast<unsigned int>(
       vcl_ceil( largestSize[dim]*
                 vcl_abs(this->GetOutputSpacing()[dim] /
-                        this->GetDisplacementFieldSpacing()[dim]))) + 1;
+                        fieldSpacing[dim]))) + 1;
     }
   m_DisplacementFilter->SetOutputSize(displacementFieldLargestSize);
   m_DisplacementFilter->SetOutputIndex(this->GetOutputStartIndex());
@@ -163,6 +203,9 @@ StreamingResampleImageFilter<TInputImage, TOutputImage, TInterpolatorPrecisionTy
   os << indent << "OutputSpacing: " << this->GetOutputSpacing() << std::endl;
   os << indent << "OutputStartIndex: " << this->GetOutputStartIndex() << std::endl;
   os << indent << "OutputSize: " << this->GetOutputSize() << std::endl;
+  os << indent << "DisplacementFieldTolerance: " << this->GetDisplacementFieldTolerance() << std::endl;
+  os << indent << "DisplacementFieldSubdivisionLevels: " << m_DisplacementFieldSubdivisionLevels << std::endl;
+  os << indent << "InputDisplacementField: " << (m_InputDisplacementField.IsNotNull() ? "yes" : "no") << std::endl;
 }
 
 
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbWarpStreamingManager_h
+#define otbWarpStreamingManager_h
+
+#include "otbStreamingManager.h"
+#include <vector>
+
+namespace otb
+{
+
+/** \class WarpStreamingManager
+ *  \brief Streaming manager ordering the splits of a warped image along the
+ *  rows of the input image.
+ *
+ * The splits are computed by another streaming manager (a
+ * RAMDrivenAdaptativeStreamingManager by default), then sorted by the
+ * position of their centre in the input image of the warp filter: by
+ * row of input blocks (InputBlockHeight rows each), then by column.
+ * Consecutive splits then read neighbouring input areas, which
+ * maximises the reuse of the input blocks kept in cache when the output
+ * and input geometries are rotated or strongly distorted with respect to
+ * each other.
+ *
+ * The warp filter must provide EvaluateInputContinuousIndex(), like
+ * StreamingWarpImageFilter, StreamingResampleImageFilter or
+ * GenericRSResampleImageFilter. Only the displacement field nodes around each
+ * split centre are evaluated. Splits whose centre is outside the
+ * displacement grid are processed last, in their original order.
+ *
+ * \sa StreamingWarpImageFilter
+ * \sa RAMDrivenAdaptativeStreamingManager
+ *
+ * \ingroup OTBImageManipulation
+ */
+template<class TWarpFilter>
+class ITK_EXPORT WarpStreamingManager
+  : public StreamingManager<typename TWarpFilter::OutputImageType>
+{
+public:
+  /** Standard class typedefs. */
+  typedef WarpStreamingManager                                  Self;
+  typedef StreamingManager<typename TWarpFilter::OutputImageType> Superclass;
+  typedef itk::SmartPointer<Self>                               Pointer;
+  typedef itk::SmartPointer<const Self>                         ConstPointer;
+
+  typedef TWarpFilter                                   WarpFilterType;
+  typedef typename WarpFilterType::OutputImageType      ImageType;
+  typedef typename Superclass::RegionType               RegionType;
+  typedef Superclass                                    SplitManagerType;
+
+  /** Creation through object factory macro */
+  itkNewMacro(Self);
+
+  /** Type macro */
+  itkTypeMacro(WarpStreamingManager, StreamingManager);
+
+  /** Warp filter producing the streamed image */
+  itkSetObjectMacro(WarpFilter, WarpFilterType);
+  itkGetObjectMacro(WarpFilter, WarpFilterType);
+
+  /** Height of the input blocks, in input rows. If 0 (the default), the
+   * block height of the ImageFileReader cache is used: the TileHintY of
+   * the input rounded up to at least 256 rows */
+  itkSetMacro(InputBlockHeight, unsigned int);
+  itkGetConstMacro(InputBlockHeight, unsigned int);
+
+  /** Streaming manager computing the splits before they are ordered */
+  itkSetObjectMacro(SplitManager, SplitManagerType);
+  itkGetObjectMacro(SplitManager, SplitManagerType);
+
+  /** Computes the splits with the split manager and sorts them along the
+   * input block rows */
+  void PrepareStreaming(itk::DataObject * input, const RegionType &region) ITK_OVERRIDE;
+
+  RegionType GetSplit(unsigned int i) ITK_OVERRIDE;
+
+protected:
+  WarpStreamingManager();
+  ~WarpStreamingManager() ITK_OVERRIDE;
+
+private:
+  WarpStreamingManager(const WarpStreamingManager &); //purposely not implemented
+  void operator =(const WarpStreamingManager&);   //purposely not implemented
+
+  typename WarpFilterType::Pointer   m_WarpFilter;
+  typename SplitManagerType::Pointer m_SplitManager;
+  unsigned int                       m_InputBlockHeight;
+
+  // Ordered splits
+  std::vector<RegionType> m_Splits;
+};
+
+} // End namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbWarpStreamingManager.txx"
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbWarpStreamingManager_txx
+#define otbWarpStreamingManager_txx
+
+#include "otbWarpStreamingManager.h"
+#include "otbRAMDrivenAdaptativeStreamingManager.h"
+#include "otbMacro.h"
+#include "itkMetaDataObject.h"
+#include "otbMetaDataKey.h"
+#include <algorithm>
+
+namespace otb
+{
+
+namespace internal
+{
+/** Sort key of a split: input block row and input column of its centre */
+struct WarpSplitKey
+{
+  bool         inside;
+  long         blockRow;
+  double       column;
+  unsigned int split;
+
+  bool operator<(const WarpSplitKey & other) const
+  {
+    if (inside != other.inside)
+      {
+      return inside;
+      }
+    if (!inside)
+      {
+      return split < other.split;
+      }
+    if (blockRow != other.blockRow)
+      {
+      return blockRow < other.blockRow;
+      }
+    if (column != other.column)
+      {
+      return column < other.column;
+      }
+    return split < other.split;
+  }
+};
+} // End namespace internal
+
+template <class TWarpFilter>
+WarpStreamingManager<TWarpFilter>::WarpStreamingManager()
+  : m_InputBlockHeight(0)
+{
+}
+
+template <class TWarpFilter>
+WarpStreamingManager<TWarpFilter>::~WarpStreamingManager()
+{
+}
+
+template <class TWarpFilter>
+void
+WarpStreamingManager<TWarpFilter>::PrepareStreaming( itk::DataObject * input, const RegionType &region )
+{
+  if (m_SplitManager.IsNull())
+    {
+    m_SplitManager = RAMDrivenAdaptativeStreamingManager<ImageType>::New().GetPointer();
+    }
+  m_SplitManager->PrepareStreaming(input, region);
+
+  const unsigned int nbSplits = m_SplitManager->GetNumberOfSplits();
+  std::vector<internal::WarpSplitKey> keys(nbSplits);
+  std::vector<RegionType> splits(nbSplits);
+
+  // Height of the input blocks: splits whose centres fall in the same
+  // block row are ordered by column
+  long blockHeight = m_InputBlockHeight;
+  if (blockHeight == 0 && m_WarpFilter.IsNotNull() && m_WarpFilter->GetInput())
+    {
+    // Same block grid as the block cache of the image file reader
+    const long minimumBlockSize = 256;
+    unsigned int tileHintY(0);
+    itk::ExposeMetaData<unsigned int>(m_WarpFilter->GetInput()->GetMetaDataDictionary(),
+                                      MetaDataKey::TileHintY,
+                                      tileHintY);
+    blockHeight = tileHintY > 0 ? static_cast<long>(tileHintY) : minimumBlockSize;
+    blockHeight *= (minimumBlockSize + blockHeight - 1) / blockHeight;
+    }
+  blockHeight = std::max(blockHeight, 1L);
+
+  for (unsigned int i = 0; i < nbSplits; ++i)
+    {
+    splits[i] = m_SplitManager->GetSplit(i);
+    keys[i].split = i;
+    keys[i].inside = false;
+    keys[i].blockRow = 0;
+    keys[i].column = 0.;
+
+    if (m_WarpFilter.IsNotNull())
+      {
+      // Centre of the split in the output image
+      typename ImageType::PointType                     centre;
+      itk::ContinuousIndex<double, ImageType::ImageDimension> centreIndex;
+      for (unsigned int dim = 0; dim < ImageType::ImageDimension; ++dim)
+        {
+        centreIndex[dim] = splits[i].GetIndex(dim) + 0.5 * (splits[i].GetSize(dim) - 1.);
+        }
+      m_WarpFilter->GetOutput()->TransformContinuousIndexToPhysicalPoint(centreIndex, centre);
+
+      typename WarpFilterType::InputContinuousIndexType inputIndex;
+      if (m_WarpFilter->EvaluateInputContinuousIndex(centre, inputIndex))
+        {
+        keys[i].inside = true;
+        keys[i].blockRow = static_cast<long>(vcl_floor(inputIndex[1] / blockHeight));
+        keys[i].column = inputIndex[0];
+        }
+      }
+    }
+
+  std::sort(keys.begin(), keys.end());
+
+  m_Splits.resize(nbSplits);
+  for (unsigned int i = 0; i < nbSplits; ++i)
+    {
+    m_Splits[i] = splits[keys[i].split];
+    }
+
+  this->m_ComputedNumberOfSplits = nbSplits;
+  this->m_Region = region;
+  otbMsgDevMacro(<< "Number of split : " << this->m_ComputedNumberOfSplits)
+}
+
+template <class TWarpFilter>
+typename WarpStreamingManager<TWarpFilter>::RegionType
+WarpStreamingManager<TWarpFilter>::GetSplit(unsigned int i)
+{
+  return m_Splits[i];
+}
+
+} // End namespace otb
+
+#endif
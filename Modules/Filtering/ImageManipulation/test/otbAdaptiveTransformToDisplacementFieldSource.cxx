@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbImage.h"
+#include "itkVector.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "otbLogPolarTransform.h"
+#include "otbAdaptiveTransformToDisplacementFieldSource.h"
+
+int otbAdaptiveTransformToDisplacementFieldSource(int itkNotUsed(argc), char * itkNotUsed(argv) [])
+{
+  typedef itk::Vector<double, 2>                                              DisplacementType;
+  typedef otb::Image<DisplacementType, 2>                                     DisplacementFieldType;
+  typedef otb::AdaptiveTransformToDisplacementFieldSource<DisplacementFieldType> SourceType;
+  typedef otb::LogPolarTransform<double>                                      TransformType;
+
+  const double tolerance = 0.1;
+
+  // Strongly non-linear transform: the field gets denser as rho grows
+  TransformType::Pointer transform = TransformType::New();
+  TransformType::InputPointType center;
+  center.Fill(0.);
+  TransformType::ScaleType scale;
+  scale[0] = 1.;
+  scale[1] = 0.05;
+  transform->SetCenter(center);
+  transform->SetScale(scale);
+
+  SourceType::SizeType size;
+  size[0] = 101;
+  size[1] = 81;
+
+  SourceType::Pointer dense = SourceType::New();
+  dense->SetTransform(transform);
+  dense->SetOutputSize(size);
+  dense->Update();
+
+  SourceType::Pointer adaptive = SourceType::New();
+  adaptive->SetTransform(transform);
+  adaptive->SetOutputSize(size);
+  adaptive->SetTolerance(tolerance);
+  adaptive->SetSubdivisionLevels(3);
+  adaptive->Update();
+
+  itk::ImageRegionConstIteratorWithIndex<DisplacementFieldType> denseIt(dense->GetOutput(),
+                                                                       dense->GetOutput()->GetLargestPossibleRegion());
+  double maxDifference = 0.;
+  for (denseIt.GoToBegin(); !denseIt.IsAtEnd(); ++denseIt)
+    {
+    const DisplacementType difference = denseIt.Get() - adaptive->GetOutput()->GetPixel(denseIt.GetIndex());
+    maxDifference = std::max(maxDifference, difference.GetNorm());
+    }
+
+  std::cout << "Exact evaluations: " << adaptive->GetNumberOfExactEvaluations()
+            << " / " << adaptive->GetNumberOfNodes() << std::endl;
+  std::cout << "Saved evaluations: " << adaptive->GetNumberOfSavedEvaluations() << std::endl;
+  std::cout << "Maximum error at cell centres: " << adaptive->GetMaximumError() << std::endl;
+  std::cout << "Maximum difference with the dense field: " << maxDifference << std::endl;
+
+  if (dense->GetNumberOfExactEvaluations() != size[0] * size[1])
+    {
+    std::cerr << "The dense field should evaluate the transform on every node" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (adaptive->GetNumberOfNodes() != size[0] * size[1]
+      || 2 * adaptive->GetNumberOfExactEvaluations() > adaptive->GetNumberOfNodes())
+    {
+    std::cerr << "The adaptive field should evaluate the transform on less than half of the nodes" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (adaptive->GetMaximumError() > tolerance || maxDifference > 3 * tolerance)
+    {
+    std::cerr << "Adaptive field is not accurate enough" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -57,6 +57,7 @@ void RegisterTests()
   REGISTER_TEST(otbPerBandVectorImageFilterNew);
   REGISTER_TEST(otbUnaryFunctorNeighborhoodImageFilter);
   REGISTER_TEST(otbStreamingResampleImageFilterNew);
+  REGISTER_TEST(otbAdaptiveTransformToDisplacementFieldSource);
   REGISTER_TEST(otbStreamingInnerProductVectorImageFilter);
   REGISTER_TEST(otbPhaseFunctorTest);
   REGISTER_TEST(otbShiftScaleVectorImageFilterNew);
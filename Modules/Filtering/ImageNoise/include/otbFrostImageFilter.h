@@ -40,6 +40,11 @@ namespace otb
  *
  * (http://www.isprs.org/proceedings/XXXV/congress/comm2/papers/110.pdf)
  * 
+ * Mean and variance come from SpeckleLocalStatistics. Neighbours at the
+ * same distance share their kernel coefficient, so exp() is evaluated
+ * once per distinct distance. Each band of an otb::VectorImage is
+ * filtered independently.
+ *
  * \ingroup OTBImageNoise
  */
 
@@ -73,8 +78,9 @@ public:
   itkTypeMacro(FrostImageFilter, ImageToImageFilter);
 
   /** Supported images definition. */
-  typedef typename InputImageType::PixelType  InputPixelType;
-  typedef typename OutputImageType::PixelType OutputPixelType;
+  typedef typename InputImageType::PixelType          InputPixelType;
+  typedef typename OutputImageType::PixelType         OutputPixelType;
+  typedef typename OutputImageType::InternalPixelType OutputInternalPixelType;
   /** "typedef" to define a real. */
   typedef typename itk::NumericTraits<InputPixelType>::RealType InputRealType;
 
@@ -24,12 +24,10 @@
 #include "otbFrostImageFilter.h"
 
 #include "itkDataObject.h"
-#include "itkConstNeighborhoodIterator.h"
-#include "itkNeighborhoodInnerProduct.h"
-#include "itkImageRegionIterator.h"
-#include "itkNeighborhoodAlgorithm.h"
-#include "itkOffset.h"
 #include "itkProgressReporter.h"
+#include "otbSpeckleLocalStatistics.h"
+
+#include <algorithm>
 
 namespace otb
 {
@@ -100,28 +98,61 @@ void FrostImageFilter<TInputImage, TOutputImage>::ThreadedGenerateData(
   itk::ThreadIdType threadId
   )
 {
-  unsigned int                                                        i;
-  itk::ZeroFluxNeumannBoundaryCondition<InputImageType>               nbc;
-  itk::ConstNeighborhoodIterator<InputImageType>                      bit;
-  typename itk::ConstNeighborhoodIterator<InputImageType>::OffsetType off;
-  itk::ImageRegionIterator<OutputImageType>                           it;
-
-  // Allocate output
   typename OutputImageType::Pointer     output = this->GetOutput();
   typename InputImageType::ConstPointer input  = this->GetInput();
 
-  // Find the data-set boundary "faces"
-  typename itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType>::FaceListType           faceList;
-  typename itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType>::FaceListType::iterator fit;
+  // Local statistics of each band, computed line by line with running sums
+  SpeckleLocalStatistics<InputImageType> stats(input, outputRegionForThread, m_Radius);
+  const unsigned int nbBands = stats.GetNumberOfBands();
+  const unsigned long width = outputRegionForThread.GetSize()[0];
 
-  itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType> bC;
-  faceList = bC(input, outputRegionForThread, m_Radius);
+  if (output->GetNumberOfComponentsPerPixel() != nbBands)
+    {
+    itkExceptionMacro(<< "Output must have as many bands as the input (" << nbBands << ")");
+    }
 
   // support progress methods/callbacks
   itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
 
-  InputRealType sum;
-  InputRealType sum2;
+  const int rad_x = m_Radius[0];
+  const int rad_y = m_Radius[1];
+
+  // Distance table: neighbours at the same distance from the center share
+  // the same kernel coefficient, so the exponential is only evaluated once
+  // per distinct distance
+  std::vector<int> squaredDistances;
+  for (int x = 0; x <= rad_x; ++x)
+    {
+    for (int y = 0; y <= rad_y; ++y)
+      {
+      squaredDistances.push_back(x * x + y * y);
+      }
+    }
+  std::sort(squaredDistances.begin(), squaredDistances.end());
+  squaredDistances.erase(std::unique(squaredDistances.begin(), squaredDistances.end()), squaredDistances.end());
+
+  const unsigned int nbDistances = squaredDistances.size();
+  std::vector<double> distances(nbDistances);
+  std::vector<double> distanceCounts(nbDistances, 0.0);
+  for (unsigned int k = 0; k < nbDistances; ++k)
+    {
+    distances[k] = vcl_sqrt(static_cast<double>(squaredDistances[k]));
+    }
+
+  // Class of each neighbour, in the order of the window scan below
+  std::vector<unsigned int> distanceClass;
+  for (int x = -rad_x; x <= rad_x; ++x)
+    {
+    for (int y = -rad_y; y <= rad_y; ++y)
+      {
+      const unsigned int k = std::lower_bound(squaredDistances.begin(), squaredDistances.end(), x * x + y * y)
+        - squaredDistances.begin();
+      distanceClass.push_back(k);
+      distanceCounts[k] += 1.0;
+      }
+    }
+
+  std::vector<double> distanceSums(nbDistances);
 
   double Mean, Variance;
   double Alpha;
@@ -130,81 +161,63 @@ void FrostImageFilter<TInputImage, TOutputImage>::ThreadedGenerateData(
   double CoefFilter;
   double dPixel;
 
-  // Process each of the boundary faces.  These are N-d regions which border
-  // the edge of the buffer.
-  for (fit = faceList.begin(); fit != faceList.end(); ++fit)
+  typename OutputImageType::IndexType index = outputRegionForThread.GetIndex();
+
+  for (stats.GoToBegin(); !stats.IsAtEnd(); stats.NextLine())
     {
-    bit = itk::ConstNeighborhoodIterator<InputImageType>(m_Radius, input, *fit);
-    unsigned int neighborhoodSize = bit.Size();
-    it = itk::ImageRegionIterator<OutputImageType>(output, *fit);
-    bit.OverrideBoundaryCondition(&nbc);
-    
-    bit.GoToBegin();
-    it.GoToBegin();
-
-    while (!bit.IsAtEnd())
+    index[1] = stats.GetLine();
+    OutputInternalPixelType * outputLine = output->GetBufferPointer() + output->ComputeOffset(index) * nbBands;
+
+    for (unsigned long px = 0; px < width; ++px)
       {
-      sum  = itk::NumericTraits<InputRealType>::Zero;
-      sum2 = itk::NumericTraits<InputRealType>::Zero;
-      
-      for (i = 0; i < neighborhoodSize; ++i)
+      const long centerX = index[0] + static_cast<long>(px);
+
+      for (unsigned int band = 0; band < nbBands; ++band)
         {
-        dPixel = static_cast<double>(bit.GetPixel(i));
-        sum += dPixel;
+        Mean     = stats.GetMean(px, band);
+        Variance = stats.GetVariance(px, band);
+
+        const double epsilon = 0.0000000001;
+        if (vcl_abs(Mean) < epsilon)
+        {
+          dPixel = itk::NumericTraits<OutputInternalPixelType>::Zero;
         }
-      Mean   = sum / static_cast<double>(neighborhoodSize);
-      
-      for (i = 0; i < neighborhoodSize; ++i)
+        else if (vcl_abs(Variance) < epsilon)
         {
-        dPixel = static_cast<double>(bit.GetPixel(i));
-        sum2 += (dPixel-Mean) * (dPixel-Mean);
+          dPixel = Mean;
+        }
+        else
+        {
+          Alpha = m_Deramp * Variance / (Mean * Mean);
+
+          // Sum of the neighbours at each distance
+          std::fill(distanceSums.begin(), distanceSums.end(), 0.0);
+          std::vector<unsigned int>::const_iterator classIt = distanceClass.begin();
+          for (int x = -rad_x; x <= rad_x; ++x)
+            {
+            for (int y = -rad_y; y <= rad_y; ++y, ++classIt)
+              {
+              distanceSums[*classIt] += stats.GetValue(centerX + x, index[1] + y, band);
+              }
+            }
+
+          NormFilter  = 0.0;
+          FrostFilter = 0.0;
+
+          for (unsigned int k = 0; k < nbDistances; ++k)
+            {
+            CoefFilter = vcl_exp(-Alpha * distances[k]);
+            NormFilter += CoefFilter * distanceCounts[k];
+            FrostFilter += CoefFilter * distanceSums[k];
+            }
+
+          dPixel = FrostFilter / NormFilter;
         }
-      Variance  = sum2 / double(neighborhoodSize-1);
-
-      const double epsilon = 0.0000000001;
-      if (vcl_abs(Mean) < epsilon)
-      {
-        dPixel = itk::NumericTraits<OutputPixelType>::Zero;
-      }
-      else if (vcl_abs(Variance) < epsilon)
-      {
-		dPixel = Mean;
-      }
-	  else
-	  {
-		  Alpha = m_Deramp * Variance / (Mean * Mean);
-
-		  NormFilter  = 0.0;
-		  FrostFilter = 0.0;
-
-		  const int rad_x = m_Radius[0];
-		  const int rad_y = m_Radius[1];
-
-		  for (int x = -rad_x; x <= rad_x; ++x)
-			{
-			for (int y = -rad_y; y <= rad_y; ++y)
-			  {
-			  double Dist = vcl_sqrt(static_cast<double>(x * x + y * y));
-			  off[0] = x;
-			  off[1] = y;
-
-			  dPixel = static_cast<double>(bit.GetPixel(off));
-
-			  CoefFilter = vcl_exp(-Alpha * Dist);
-			  NormFilter += CoefFilter;
-			  FrostFilter += (CoefFilter * dPixel);
-			  }
-			}
-
-		  dPixel = FrostFilter / NormFilter;
-	  }
 
-      it.Set(static_cast<OutputPixelType>(dPixel));
+        outputLine[px * nbBands + band] = static_cast<OutputInternalPixelType>(dPixel);
+        }
 
-      ++bit;
-      ++it;
       progress.CompletedPixel();
-
       }
     }
 }
@@ -24,12 +24,8 @@
 #include "otbGammaMAPImageFilter.h"
 
 #include "itkDataObject.h"
-#include "itkConstNeighborhoodIterator.h"
-#include "itkNeighborhoodInnerProduct.h"
-#include "itkImageRegionIterator.h"
-#include "itkNeighborhoodAlgorithm.h"
-#include "itkOffset.h"
 #include "itkProgressReporter.h"
+#include "otbSpeckleLocalStatistics.h"
 
 namespace otb
 {
@@ -99,108 +95,79 @@ void GammaMAPImageFilter<TInputImage, TOutputImage>::ThreadedGenerateData(
   itk::ThreadIdType threadId
   )
 {
-  unsigned int                                          i;
-  itk::ZeroFluxNeumannBoundaryCondition<InputImageType> nbc;
-
-  itk::ConstNeighborhoodIterator<InputImageType> bit;
-  itk::ImageRegionIterator<OutputImageType>      it;
-
   typename OutputImageType::Pointer     output = this->GetOutput();
   typename InputImageType::ConstPointer input  = this->GetInput();
 
-  // Find the data-set boundary "faces"
-  typename itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType>::FaceListType           faceList;
-  typename itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType>::FaceListType::iterator fit;
+  // Local statistics of each band, computed line by line with running sums
+  SpeckleLocalStatistics<InputImageType> stats(input, outputRegionForThread, m_Radius);
+  const unsigned int nbBands = stats.GetNumberOfBands();
+  const unsigned long width = outputRegionForThread.GetSize()[0];
 
-  itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType> bC;
-  faceList = bC(input, outputRegionForThread, m_Radius);
+  if (output->GetNumberOfComponentsPerPixel() != nbBands)
+    {
+    itkExceptionMacro(<< "Output must have as many bands as the input (" << nbBands << ")");
+    }
 
   // support progress methods/callbacks
   itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
 
-  //  InputRealType pixel;
-  InputRealType sum;
-  InputRealType sum2;
-
   double Ci, Ci2, Cu, Cu2, E_I, I, Var_I, dPixel, alpha, b, d, Cmax;
 
   //Compute the ratio using the number of looks
   Cu2 = 1.0/m_NbLooks;
   Cu = vcl_sqrt(Cu2);
 
-  // Process each of the boundary faces.  These are N-d regions which border
-  // the edge of the buffer.
-  for (fit = faceList.begin(); fit != faceList.end(); ++fit)
-    {
-    bit = itk::ConstNeighborhoodIterator<InputImageType>(m_Radius, input, *fit);
-    const unsigned int neighborhoodSize = bit.Size();
-    it = itk::ImageRegionIterator<OutputImageType>(output, *fit);
-    bit.OverrideBoundaryCondition(&nbc);
-    
-    bit.GoToBegin();
-	it.GoToBegin();
+  typename OutputImageType::IndexType index = outputRegionForThread.GetIndex();
 
+  for (stats.GoToBegin(); !stats.IsAtEnd(); stats.NextLine())
+    {
+    index[1] = stats.GetLine();
+    OutputInternalPixelType * outputLine = output->GetBufferPointer() + output->ComputeOffset(index) * nbBands;
 
-    while (!bit.IsAtEnd())
+    for (unsigned long x = 0; x < width; ++x)
       {
-      sum = itk::NumericTraits<InputRealType>::Zero;
-      sum2 = itk::NumericTraits<InputRealType>::Zero;
-      
-      //Parcours du voisinage
-      for (i = 0; i < neighborhoodSize; ++i)
+      for (unsigned int band = 0; band < nbBands; ++band)
+        {
+        E_I   = stats.GetMean(x, band);
+        Var_I = stats.GetVariance(x, band);
+
+        I = stats.GetValue(index[0] + static_cast<long>(x), index[1], band);
+
+        Ci2 = Var_I / (E_I * E_I);
+        Ci  = vcl_sqrt(Ci2);
+
+        const double epsilon = 0.0000000001;
+        if (vcl_abs(E_I) < epsilon)
         {
-        dPixel = static_cast<double>(bit.GetPixel(i));
-        sum += dPixel;
+          dPixel = itk::NumericTraits<OutputInternalPixelType>::Zero;
         }
-      E_I   = sum / static_cast<double>(neighborhoodSize);
-      
-      for (i = 0; i < neighborhoodSize; ++i)
+        else if (vcl_abs(Var_I) < epsilon)
         {
-        dPixel = static_cast<double>(bit.GetPixel(i));
-        sum2 += (dPixel-E_I) * (dPixel-E_I);
+          dPixel = E_I;
         }
-      Var_I = sum2 / static_cast<double>(neighborhoodSize -1);
-      
-      I = static_cast<double>(bit.GetCenterPixel());
-      
-      Ci2 = Var_I / (E_I * E_I);
-      Ci  = vcl_sqrt(Ci2);
-
-      const double epsilon = 0.0000000001;
-      if (vcl_abs(E_I) < epsilon)
-      {
-        dPixel = itk::NumericTraits<OutputPixelType>::Zero;
-      }
-      else if (vcl_abs(Var_I) < epsilon)
-      {
-		dPixel = E_I;
-      }
-      else if (Ci2 < Cu2)
-      {
-		dPixel = E_I;
-      }
-      else
-      {
-        Cmax = vcl_sqrt(2.0) * Cu;
-      
-        if (Ci < Cmax) 
+        else if (Ci2 < Cu2)
         {
-                alpha = (1 + Cu2) / (Ci2 - Cu2);
-                b = alpha - m_NbLooks - 1;
-                d = E_I * E_I * b * b + 4 * alpha * m_NbLooks * E_I * I;
-                dPixel = (b * E_I + vcl_sqrt(d)) / (2 * alpha);
+          dPixel = E_I;
         }
         else
-			dPixel = I;
+        {
+          Cmax = vcl_sqrt(2.0) * Cu;
+
+          if (Ci < Cmax)
+          {
+            alpha = (1 + Cu2) / (Ci2 - Cu2);
+            b = alpha - m_NbLooks - 1;
+            d = E_I * E_I * b * b + 4 * alpha * m_NbLooks * E_I * I;
+            dPixel = (b * E_I + vcl_sqrt(d)) / (2 * alpha);
+          }
+          else
+            dPixel = I;
+        }
 
-      }
-      
-      // set the weighted value
-      it.Set(static_cast<OutputPixelType>(dPixel));
+        // set the weighted value
+        outputLine[x * nbBands + band] = static_cast<OutputInternalPixelType>(dPixel);
+        }
 
-      ++bit;
-      ++it;
-      
       progress.CompletedPixel();
       }
     }
@@ -36,6 +36,9 @@ namespace otb
  *
  * (http://www.isprs.org/proceedings/XXXV/congress/comm2/papers/110.pdf)
  * 
+ * Local statistics are computed by SpeckleLocalStatistics. Each band of
+ * an otb::VectorImage is filtered independently.
+ *
  * \ingroup OTBImageNoise
  */
 
@@ -68,6 +71,7 @@ public:
 
   typedef typename InputImageType::PixelType                    InputPixelType;
   typedef typename OutputImageType::PixelType                   OutputPixelType;
+  typedef typename OutputImageType::InternalPixelType           OutputInternalPixelType;
   typedef typename itk::NumericTraits<InputPixelType>::RealType InputRealType;
   typedef typename InputImageType::RegionType                   InputImageRegionType;
   typedef typename OutputImageType::RegionType                  OutputImageRegionType;
@@ -43,6 +43,11 @@ namespace otb
  * 
  *
  *
+ * Local mean and variance are computed with running sums (see
+ * SpeckleLocalStatistics), so their cost does not depend on the radius.
+ * Input and output can be otb::VectorImage, each band (for instance each
+ * polarimetric channel) being filtered independently.
+ *
  * \ingroup OTBImageNoise
  */
 
@@ -75,6 +80,7 @@ public:
 
   typedef typename InputImageType::PixelType                    InputPixelType;
   typedef typename OutputImageType::PixelType                   OutputPixelType;
+  typedef typename OutputImageType::InternalPixelType           OutputInternalPixelType;
   typedef typename itk::NumericTraits<InputPixelType>::RealType InputRealType;
   typedef typename InputImageType::RegionType                   InputImageRegionType;
   typedef typename OutputImageType::RegionType                  OutputImageRegionType;
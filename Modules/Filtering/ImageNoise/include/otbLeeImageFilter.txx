@@ -24,12 +24,8 @@
 #include "otbLeeImageFilter.h"
 
 #include "itkDataObject.h"
-#include "itkConstNeighborhoodIterator.h"
-#include "itkNeighborhoodInnerProduct.h"
-#include "itkImageRegionIterator.h"
-#include "itkNeighborhoodAlgorithm.h"
-#include "itkOffset.h"
 #include "itkProgressReporter.h"
+#include "otbSpeckleLocalStatistics.h"
 
 namespace otb
 {
@@ -99,96 +95,68 @@ void LeeImageFilter<TInputImage, TOutputImage>::ThreadedGenerateData(
   itk::ThreadIdType threadId
   )
 {
-  unsigned int                                          i;
-  itk::ZeroFluxNeumannBoundaryCondition<InputImageType> nbc;
-
-  itk::ConstNeighborhoodIterator<InputImageType> bit;
-  itk::ImageRegionIterator<OutputImageType>      it;
-
   typename OutputImageType::Pointer     output = this->GetOutput();
   typename InputImageType::ConstPointer input  = this->GetInput();
 
-  // Find the data-set boundary "faces"
-  typename itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType>::FaceListType           faceList;
-  typename itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType>::FaceListType::iterator fit;
+  // Local statistics of each band, computed line by line with running sums
+  SpeckleLocalStatistics<InputImageType> stats(input, outputRegionForThread, m_Radius);
+  const unsigned int nbBands = stats.GetNumberOfBands();
+  const unsigned long width = outputRegionForThread.GetSize()[0];
 
-  itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<InputImageType> bC;
-  faceList = bC(input, outputRegionForThread, m_Radius);
+  if (output->GetNumberOfComponentsPerPixel() != nbBands)
+    {
+    itkExceptionMacro(<< "Output must have as many bands as the input (" << nbBands << ")");
+    }
 
   // support progress methods/callbacks
   itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
 
-  //  InputRealType pixel;
-  InputRealType sum;
-  InputRealType sum2;
-
   double Ci2, Cu2, w, E_I, I, Var_I, dPixel;
 
   //Compute the ratio using the number of looks
   Cu2 = 1.0/m_NbLooks;
 
-  // Process each of the boundary faces.  These are N-d regions which border
-  // the edge of the buffer.
-  for (fit = faceList.begin(); fit != faceList.end(); ++fit)
-    {
-    bit = itk::ConstNeighborhoodIterator<InputImageType>(m_Radius, input, *fit);
-    const unsigned int neighborhoodSize = bit.Size();
-    it = itk::ImageRegionIterator<OutputImageType>(output, *fit);
-    bit.OverrideBoundaryCondition(&nbc);
-    
-    bit.GoToBegin();
-	it.GoToBegin();
+  typename OutputImageType::IndexType index = outputRegionForThread.GetIndex();
 
+  for (stats.GoToBegin(); !stats.IsAtEnd(); stats.NextLine())
+    {
+    index[1] = stats.GetLine();
+    OutputInternalPixelType * outputLine = output->GetBufferPointer() + output->ComputeOffset(index) * nbBands;
 
-    while (!bit.IsAtEnd())
+    for (unsigned long x = 0; x < width; ++x)
       {
-      sum = itk::NumericTraits<InputRealType>::Zero;
-      sum2 = itk::NumericTraits<InputRealType>::Zero;
-      
-      //Parcours du voisinage
-      for (i = 0; i < neighborhoodSize; ++i)
+      for (unsigned int band = 0; band < nbBands; ++band)
         {
-        dPixel = static_cast<double>(bit.GetPixel(i));
-        sum += dPixel;
+        E_I   = stats.GetMean(x, band);
+        Var_I = stats.GetVariance(x, band);
+
+        I = stats.GetValue(index[0] + static_cast<long>(x), index[1], band);
+
+        Ci2    = Var_I / (E_I * E_I);
+
+        const double epsilon = 0.0000000001;
+        if (vcl_abs(E_I) < epsilon)
+        {
+          dPixel = itk::NumericTraits<OutputInternalPixelType>::Zero;
         }
-      E_I   = sum / static_cast<double>(neighborhoodSize);
-      
-      for (i = 0; i < neighborhoodSize; ++i)
+        else if (vcl_abs(Var_I) < epsilon)
         {
-        dPixel = static_cast<double>(bit.GetPixel(i));
-        sum2 += (dPixel-E_I) * (dPixel-E_I);
+          dPixel = E_I;
+        }
+        else if (Ci2 < Cu2)
+        {
+          dPixel = E_I;
+        }
+        else
+        {
+          w = 1 - Cu2 / Ci2;
+          dPixel = I*w + E_I*(1-w);
+        }
+
+        // set the weighted value
+        outputLine[x * nbBands + band] = static_cast<OutputInternalPixelType>(dPixel);
         }
-      Var_I = sum2 / static_cast<double>(neighborhoodSize -1);
-      
-      I = static_cast<double>(bit.GetCenterPixel());
-      
-      Ci2    = Var_I / (E_I * E_I);
-
-      const double epsilon = 0.0000000001;
-      if (vcl_abs(E_I) < epsilon)
-      {
-        dPixel = itk::NumericTraits<OutputPixelType>::Zero;
-      }
-      else if (vcl_abs(Var_I) < epsilon)
-      {
-		dPixel = E_I;
-      }
-      else if (Ci2 < Cu2)
-      {
-		dPixel = E_I;
-      }
-      else
-      {
-		w = 1 - Cu2 / Ci2;
-		dPixel = I*w + E_I*(1-w);
-      }
-      
-      // set the weighted value
-      it.Set(static_cast<OutputPixelType>(dPixel));
 
-      ++bit;
-      ++it;
-      
       progress.CompletedPixel();
       }
     }
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbSpeckleLocalStatistics_h
+#define otbSpeckleLocalStatistics_h
+
+#include "itkImageRegion.h"
+#include <vector>
+#include <algorithm>
+
+namespace otb
+{
+
+/** \class SpeckleLocalStatistics
+ * \brief Local mean and variance of each band, line by line, with running sums
+ *
+ * This helper computes the mean and the unbiased variance of every band
+ * on a rectangular window centered on each pixel of a region, as used
+ * by the speckle filters. Sums over the window height are kept for each
+ * column and updated when moving to the next line, and the window sum
+ * is then slid along the line, so that the cost per pixel does not
+ * depend on the window size.
+ *
+ * To limit rounding errors, the sums are accumulated on the differences
+ * between the values and a per-band offset, the value of the first
+ * pixel of the region, and the column sums are rebuilt from scratch
+ * every SumsRefreshPeriod lines instead of being slid over the whole
+ * region height. The window sums along a line are rebuilt with the
+ * same period.
+ *
+ * Pixels outside the buffered region of the input image are replaced by
+ * the nearest buffered pixel, like itk::ZeroFluxNeumannBoundaryCondition.
+ *
+ * The input image can be an otb::Image with scalar pixels or an
+ * otb::VectorImage, whose bands are processed independently.
+ *
+ * This class is not thread safe: each thread must use its own instance.
+ *
+ * \ingroup OTBImageNoise
+ */
+template <class TInputImage>
+class SpeckleLocalStatistics
+{
+public:
+  /** Number of lines (resp. columns) after which the sums are rebuilt */
+  static const unsigned long SumsRefreshPeriod = 64;
+
+  typedef TInputImage                                InputImageType;
+  typedef typename InputImageType::InternalPixelType InternalPixelType;
+  typedef typename InputImageType::RegionType        RegionType;
+  typedef typename InputImageType::IndexType         IndexType;
+  typedef typename InputImageType::SizeType          SizeType;
+
+  /** Statistics are computed for the pixels of region, on a window of
+   *  the given radius. region must be inside the buffered region */
+  SpeckleLocalStatistics(const InputImageType * image, const RegionType & region, const SizeType & radius);
+
+  /** Go to the first line of the region */
+  void GoToBegin();
+
+  /** Go to the next line of the region */
+  void NextLine();
+
+  /** Is the last line of the region passed ? */
+  bool IsAtEnd() const
+  {
+    return m_Line >= m_Region.GetIndex()[1] + static_cast<long>(m_Region.GetSize()[1]);
+  }
+
+  /** Index of the current line */
+  long GetLine() const
+  {
+    return m_Line;
+  }
+
+  /** Number of bands of the input image */
+  unsigned int GetNumberOfBands() const
+  {
+    return m_NumberOfBands;
+  }
+
+  /** Number of pixels of the window */
+  unsigned long GetNeighborhoodSize() const
+  {
+    return m_NeighborhoodSize;
+  }
+
+  /** Mean of the window centered on the x-th pixel of the current line */
+  double GetMean(unsigned long x, unsigned int band) const
+  {
+    return m_Mean[x * m_NumberOfBands + band];
+  }
+
+  /** Unbiased variance of the window centered on the x-th pixel of the
+   *  current line */
+  double GetVariance(unsigned long x, unsigned int band) const
+  {
+    return m_Variance[x * m_NumberOfBands + band];
+  }
+
+  /** Value of a band of the input pixel at (x, y), with the boundary
+   *  condition applied */
+  double GetValue(long x, long y, unsigned int band) const
+  {
+    const IndexType & bufferIndex = m_BufferedRegion.GetIndex();
+    const SizeType & bufferSize = m_BufferedRegion.GetSize();
+    x = std::min(std::max(x, bufferIndex[0]), bufferIndex[0] + static_cast<long>(bufferSize[0]) - 1);
+    y = std::min(std::max(y, bufferIndex[1]), bufferIndex[1] + static_cast<long>(bufferSize[1]) - 1);
+    return static_cast<double>(m_Buffer[((y - bufferIndex[1]) * bufferSize[0] + (x - bufferIndex[0]))
+                                        * m_NumberOfBands + band]);
+  }
+
+private:
+  /** Add (sign = 1) or remove (sign = -1) input line y to the column sums */
+  void AccumulateLine(long y, double sign);
+
+  /** Reset the column sums and accumulate all the lines of the window
+   *  centered on the current line */
+  void RebuildColumnSums();
+
+  /** Compute the mean and variance of the current line from the column sums */
+  void ComputeLineStatistics();
+
+  const InternalPixelType * m_Buffer;
+  RegionType                m_BufferedRegion;
+  RegionType                m_Region;
+  SizeType                  m_Radius;
+  unsigned int              m_NumberOfBands;
+  unsigned long             m_NeighborhoodSize;
+  long                      m_Line;
+
+  /** Value subtracted from each band before accumulation */
+  std::vector<double>       m_Offset;
+
+  /** Buffer offset of each column of the padded region */
+  std::vector<long>         m_ColumnOffsets;
+
+  /** Sums of values and squared values over the window height, for each
+   *  column of the padded region and each band */
+  std::vector<double>       m_ColumnSum;
+  std::vector<double>       m_ColumnSquareSum;
+
+  /** Statistics of the current line, for each pixel and each band */
+  std::vector<double>       m_Mean;
+  std::vector<double>       m_Variance;
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbSpeckleLocalStatistics.txx"
+#endif
+
+#endif
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbSpeckleLocalStatistics_txx
+#define otbSpeckleLocalStatistics_txx
+
+#include "otbSpeckleLocalStatistics.h"
+
+namespace otb
+{
+
+template <class TInputImage>
+SpeckleLocalStatistics<TInputImage>
+::SpeckleLocalStatistics(const InputImageType * image, const RegionType & region, const SizeType & radius)
+  : m_Buffer(image->GetBufferPointer()),
+    m_BufferedRegion(image->GetBufferedRegion()),
+    m_Region(region),
+    m_Radius(radius),
+    m_NumberOfBands(image->GetNumberOfComponentsPerPixel()),
+    m_NeighborhoodSize((2 * radius[0] + 1) * (2 * radius[1] + 1)),
+    m_Line(region.GetIndex()[1])
+{
+  const unsigned long width = m_Region.GetSize()[0];
+  const unsigned long paddedWidth = width + 2 * m_Radius[0];
+
+  const long firstBufferColumn = m_BufferedRegion.GetIndex()[0];
+  const long lastBufferColumn = firstBufferColumn + static_cast<long>(m_BufferedRegion.GetSize()[0]) - 1;
+  const long firstColumn = m_Region.GetIndex()[0] - static_cast<long>(m_Radius[0]);
+
+  m_ColumnOffsets.resize(paddedWidth);
+  for (unsigned long c = 0; c < paddedWidth; ++c)
+    {
+    const long x = std::min(std::max(firstColumn + static_cast<long>(c), firstBufferColumn), lastBufferColumn);
+    m_ColumnOffsets[c] = x - firstBufferColumn;
+    }
+
+  m_Offset.resize(m_NumberOfBands);
+  for (unsigned int b = 0; b < m_NumberOfBands; ++b)
+    {
+    m_Offset[b] = this->GetValue(m_Region.GetIndex()[0], m_Region.GetIndex()[1], b);
+    }
+
+  m_ColumnSum.resize(paddedWidth * m_NumberOfBands);
+  m_ColumnSquareSum.resize(paddedWidth * m_NumberOfBands);
+  m_Mean.resize(width * m_NumberOfBands);
+  m_Variance.resize(width * m_NumberOfBands);
+}
+
+template <class TInputImage>
+void
+SpeckleLocalStatistics<TInputImage>
+::AccumulateLine(long y, double sign)
+{
+  const long firstBufferLine = m_BufferedRegion.GetIndex()[1];
+  const long lastBufferLine = firstBufferLine + static_cast<long>(m_BufferedRegion.GetSize()[1]) - 1;
+  y = std::min(std::max(y, firstBufferLine), lastBufferLine);
+
+  const InternalPixelType * line = m_Buffer
+    + (y - firstBufferLine) * m_BufferedRegion.GetSize()[0] * m_NumberOfBands;
+
+  for (unsigned long c = 0; c < m_ColumnOffsets.size(); ++c)
+    {
+    const InternalPixelType * pixel = line + m_ColumnOffsets[c] * m_NumberOfBands;
+    for (unsigned int b = 0; b < m_NumberOfBands; ++b)
+      {
+      const double value = static_cast<double>(pixel[b]) - m_Offset[b];
+      m_ColumnSum[c * m_NumberOfBands + b] += sign * value;
+      m_ColumnSquareSum[c * m_NumberOfBands + b] += sign * value * value;
+      }
+    }
+}
+
+template <class TInputImage>
+void
+SpeckleLocalStatistics<TInputImage>
+::ComputeLineStatistics()
+{
+  const unsigned long width = m_Region.GetSize()[0];
+  const unsigned long windowWidth = 2 * m_Radius[0] + 1;
+  const double n = static_cast<double>(m_NeighborhoodSize);
+
+  for (unsigned int b = 0; b < m_NumberOfBands; ++b)
+    {
+    double sum = 0.0;
+    double squareSum = 0.0;
+
+    for (unsigned long x = 0; x < width; ++x)
+      {
+      if (x % SumsRefreshPeriod == 0)
+        {
+        sum = 0.0;
+        squareSum = 0.0;
+        for (unsigned long c = x; c < x + windowWidth; ++c)
+          {
+          sum += m_ColumnSum[c * m_NumberOfBands + b];
+          squareSum += m_ColumnSquareSum[c * m_NumberOfBands + b];
+          }
+        }
+
+      // Rounding may give a slightly negative variance on flat areas
+      const double variance = std::max((squareSum - sum * sum / n) / (n - 1), 0.0);
+
+      m_Mean[x * m_NumberOfBands + b] = m_Offset[b] + sum / n;
+      m_Variance[x * m_NumberOfBands + b] = variance;
+
+      if (x + 1 < width && (x + 1) % SumsRefreshPeriod != 0)
+        {
+        sum += m_ColumnSum[(x + windowWidth) * m_NumberOfBands + b] - m_ColumnSum[x * m_NumberOfBands + b];
+        squareSum += m_ColumnSquareSum[(x + windowWidth) * m_NumberOfBands + b]
+          - m_ColumnSquareSum[x * m_NumberOfBands + b];
+        }
+      }
+    }
+}
+
+template <class TInputImage>
+void
+SpeckleLocalStatistics<TInputImage>
+::RebuildColumnSums()
+{
+  std::fill(m_ColumnSum.begin(), m_ColumnSum.end(), 0.0);
+  std::fill(m_ColumnSquareSum.begin(), m_ColumnSquareSum.end(), 0.0);
+
+  const long radiusY = static_cast<long>(m_Radius[1]);
+  for (long dy = -radiusY; dy <= radiusY; ++dy)
+    {
+    this->AccumulateLine(m_Line + dy, 1.0);
+    }
+}
+
+template <class TInputImage>
+void
+SpeckleLocalStatistics<TInputImage>
+::GoToBegin()
+{
+  m_Line = m_Region.GetIndex()[1];
+
+  this->RebuildColumnSums();
+
+  if (!this->IsAtEnd())
+    {
+    this->ComputeLineStatistics();
+    }
+}
+
+template <class TInputImage>
+void
+SpeckleLocalStatistics<TInputImage>
+::NextLine()
+{
+  ++m_Line;
+
+  if (this->IsAtEnd())
+    {
+    return;
+    }
+
+  if ((m_Line - m_Region.GetIndex()[1]) % static_cast<long>(SumsRefreshPeriod) == 0)
+    {
+    // Start again from exact sums, so that rounding errors do not build up
+    this->RebuildColumnSums();
+    }
+  else
+    {
+    // Slide the window down by one line
+    const long radiusY = static_cast<long>(m_Radius[1]);
+    this->AccumulateLine(m_Line - radiusY - 1, -1.0);
+    this->AccumulateLine(m_Line + radiusY, 1.0);
+    }
+
+  this->ComputeLineStatistics();
+}
+
+} // end namespace otb
+
+#endif
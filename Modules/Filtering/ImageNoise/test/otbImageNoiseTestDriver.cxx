@@ -27,4 +27,6 @@ void RegisterTests()
   REGISTER_TEST(otbGammaMAPFilter);
   REGISTER_TEST(otbKuanFilter);
   REGISTER_TEST(otbFrostFilterNew);
+  REGISTER_TEST(otbSpeckleFilterVectorImage);
+  REGISTER_TEST(otbLeeFilterTallImage);
 }
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "itkMacro.h"
+#include <iostream>
+
+#include "otbImage.h"
+#include "otbLeeImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+// Reference Lee filter, computing the statistics of each window directly
+static double otbLeeFilterTallImageReference(const otb::Image<double, 2> * image,
+                                             long x0, long y0,
+                                             long radiusX, long radiusY,
+                                             double Cu2)
+{
+  const otb::Image<double, 2>::SizeType size = image->GetLargestPossibleRegion().GetSize();
+  const double n = static_cast<double>((2 * radiusX + 1) * (2 * radiusY + 1));
+
+  otb::Image<double, 2>::IndexType index;
+  double sum = 0.0;
+  for (long y = y0 - radiusY; y <= y0 + radiusY; ++y)
+    {
+    for (long x = x0 - radiusX; x <= x0 + radiusX; ++x)
+      {
+      index[0] = std::min(std::max(x, 0L), static_cast<long>(size[0]) - 1);
+      index[1] = std::min(std::max(y, 0L), static_cast<long>(size[1]) - 1);
+      sum += image->GetPixel(index);
+      }
+    }
+  const double E_I = sum / n;
+
+  double sum2 = 0.0;
+  for (long y = y0 - radiusY; y <= y0 + radiusY; ++y)
+    {
+    for (long x = x0 - radiusX; x <= x0 + radiusX; ++x)
+      {
+      index[0] = std::min(std::max(x, 0L), static_cast<long>(size[0]) - 1);
+      index[1] = std::min(std::max(y, 0L), static_cast<long>(size[1]) - 1);
+      sum2 += (image->GetPixel(index) - E_I) * (image->GetPixel(index) - E_I);
+      }
+    }
+  const double Var_I = sum2 / (n - 1);
+
+  index[0] = x0;
+  index[1] = y0;
+  const double I = image->GetPixel(index);
+  const double Ci2 = Var_I / (E_I * E_I);
+
+  const double epsilon = 0.0000000001;
+  if (vcl_abs(E_I) < epsilon)
+    {
+    return 0.0;
+    }
+  else if (vcl_abs(Var_I) < epsilon || Ci2 < Cu2)
+    {
+    return E_I;
+    }
+  const double w = 1 - Cu2 / Ci2;
+  return I * w + E_I * (1 - w);
+}
+
+// Filter a tall image in a single region, so that the running sums of the
+// local statistics are slid along the whole image height, and check the
+// result against the statistics computed directly on each window
+int otbLeeFilterTallImage(int itkNotUsed(argc), char * argv[])
+{
+  const unsigned int width = atoi(argv[1]);
+  const unsigned int height = atoi(argv[2]);
+  const double       tolerance = atof(argv[3]);
+
+  typedef otb::Image<double, 2>                       ImageType;
+  typedef otb::LeeImageFilter<ImageType, ImageType>   FilterType;
+
+  ImageType::SizeType size;
+  size[0] = width;
+  size[1] = height;
+  ImageType::RegionType region;
+  region.SetSize(size);
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  // Bright textured areas separated by flat strips
+  unsigned long seed = 12345;
+  itk::ImageRegionIterator<ImageType> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    seed = (seed * 1103515245 + 12345) % 2147483648UL;
+    if (it.GetIndex()[1] % 1000 < 100)
+      {
+      it.Set(20000.0);
+      }
+    else
+      {
+      it.Set(10000.0 + static_cast<double>(seed % 4000));
+      }
+    }
+
+  FilterType::SizeType radius;
+  radius[0] = 2;
+  radius[1] = 3;
+  const double nbLooks = 4.0;
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetRadius(radius);
+  filter->SetNbLooks(nbLooks);
+  filter->SetNumberOfThreads(1);
+  filter->Update();
+
+  unsigned int nbErrors = 0;
+  itk::ImageRegionConstIteratorWithIndex<ImageType> oit(filter->GetOutput(), region);
+  for (oit.GoToBegin(); !oit.IsAtEnd(); ++oit)
+    {
+    const double expected = otbLeeFilterTallImageReference(image, oit.GetIndex()[0], oit.GetIndex()[1],
+                                                           radius[0], radius[1], 1.0 / nbLooks);
+    if (vcl_abs(oit.Get() - expected) > tolerance * vcl_abs(expected))
+      {
+      if (nbErrors < 10)
+        {
+        std::cerr << "Pixel " << oit.GetIndex() << ": got " << oit.Get()
+                  << ", expected " << expected << std::endl;
+        }
+      ++nbErrors;
+      }
+    }
+
+  if (nbErrors > 0)
+    {
+    std::cerr << nbErrors << " pixels differ from the reference" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
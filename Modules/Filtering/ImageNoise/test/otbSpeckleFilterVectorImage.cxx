@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbVectorImage.h"
+#include "otbImage.h"
+#include "otbImageFileReader.h"
+#include "otbMultiToMonoChannelExtractROI.h"
+#include "otbFrostImageFilter.h"
+#include "otbLeeImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+
+// Check that filtering a multi-band image gives, for each band, the same
+// result as filtering the band alone
+template <class TVectorFilter, class TFilter>
+int otbSpeckleFilterVectorImageCheck(typename TVectorFilter::InputImageType * image,
+                                     TVectorFilter * vectorFilter,
+                                     TFilter * filter)
+{
+  typedef typename TVectorFilter::OutputImageType                             VectorImageType;
+  typedef typename TFilter::OutputImageType                                   ImageType;
+  typedef otb::MultiToMonoChannelExtractROI<typename ImageType::PixelType,
+                                            typename ImageType::PixelType>    ExtractorType;
+
+  vectorFilter->SetInput(image);
+  vectorFilter->Update();
+
+  for (unsigned int band = 0; band < image->GetNumberOfComponentsPerPixel(); ++band)
+    {
+    typename ExtractorType::Pointer extractor = ExtractorType::New();
+    extractor->SetInput(image);
+    extractor->SetChannel(band + 1);
+
+    filter->SetInput(extractor->GetOutput());
+    filter->Modified();
+    filter->Update();
+
+    itk::ImageRegionConstIterator<VectorImageType> vit(vectorFilter->GetOutput(),
+                                                       vectorFilter->GetOutput()->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<ImageType> it(filter->GetOutput(),
+                                                filter->GetOutput()->GetLargestPossibleRegion());
+
+    for (vit.GoToBegin(), it.GoToBegin(); !vit.IsAtEnd() && !it.IsAtEnd(); ++vit, ++it)
+      {
+      const double vectorValue = vit.Get()[band];
+      const double value = it.Get();
+      if (vcl_abs(vectorValue - value) > 1e-6 * (1 + vcl_abs(value)))
+        {
+        std::cerr << "Band " << band << " differs at " << it.GetIndex()
+                  << ": " << vectorValue << " instead of " << value << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+int otbSpeckleFilterVectorImage(int itkNotUsed(argc), char * argv[])
+{
+  typedef float                                                       PixelType;
+  typedef otb::VectorImage<PixelType, 2>                              VectorImageType;
+  typedef otb::Image<PixelType, 2>                                    ImageType;
+  typedef otb::ImageFileReader<VectorImageType>                       ReaderType;
+  typedef otb::LeeImageFilter<VectorImageType, VectorImageType>       VectorLeeFilterType;
+  typedef otb::LeeImageFilter<ImageType, ImageType>                   LeeFilterType;
+  typedef otb::FrostImageFilter<VectorImageType, VectorImageType>     VectorFrostFilterType;
+  typedef otb::FrostImageFilter<ImageType, ImageType>                 FrostFilterType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(argv[1]);
+  reader->Update();
+
+  VectorLeeFilterType::SizeType radius;
+  radius[0] = atoi(argv[2]);
+  radius[1] = atoi(argv[3]);
+
+  VectorLeeFilterType::Pointer vectorLee = VectorLeeFilterType::New();
+  vectorLee->SetRadius(radius);
+  vectorLee->SetNbLooks(4.0);
+
+  LeeFilterType::Pointer lee = LeeFilterType::New();
+  lee->SetRadius(radius);
+  lee->SetNbLooks(4.0);
+
+  VectorFrostFilterType::Pointer vectorFrost = VectorFrostFilterType::New();
+  vectorFrost->SetRadius(radius);
+  vectorFrost->SetDeramp(0.1);
+
+  FrostFilterType::Pointer frost = FrostFilterType::New();
+  frost->SetRadius(radius);
+  frost->SetDeramp(0.1);
+
+  if (otbSpeckleFilterVectorImageCheck(reader->GetOutput(), vectorLee.GetPointer(), lee.GetPointer()) != EXIT_SUCCESS)
+    {
+    std::cerr << "Lee filter: vector image output differs from band by band output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (otbSpeckleFilterVectorImageCheck(reader->GetOutput(), vectorFrost.GetPointer(), frost.GetPointer()) != EXIT_SUCCESS)
+    {
+    std::cerr << "Frost filter: vector image output differs from band by band output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
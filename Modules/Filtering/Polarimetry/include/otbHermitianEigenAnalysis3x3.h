@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbHermitianEigenAnalysis3x3_h
+#define otbHermitianEigenAnalysis3x3_h
+
+#include "otbMath.h"
+#include <complex>
+#include <algorithm>
+
+namespace otb
+{
+
+/** \class HermitianEigenAnalysis3x3
+ * \brief Closed-form eigen decomposition of a 3x3 Hermitian matrix.
+ *
+ * The eigenvalues are first estimated with the trigonometric solution
+ * of the characteristic polynomial. The eigenvector of the extreme
+ * eigenvalue which is the farthest from the two others is the cross
+ * product of two rows of \f$ A - \lambda I \f$. The matrix is then
+ * restricted to the plane orthogonal to this eigenvector, and the
+ * remaining 2x2 Hermitian problem is solved directly. Unlike the roots
+ * of the cubic alone, this keeps close eigenvalues (like the two null
+ * eigenvalues of a rank one matrix) accurate.
+ *
+ * This avoids the general complex eigensystem of vnl, which is costly
+ * when a matrix has to be diagonalised for each pixel of an image.
+ *
+ * The matrix is given by its real diagonal \f$ (a_{00}, a_{11}, a_{22}) \f$
+ * and by its upper elements \f$ (a_{01}, a_{02}, a_{12}) \f$.
+ * Eigenvalues are sorted in decreasing order, and eigenVectors[i] is the
+ * unit eigenvector of eigenValues[i]. The phase of the eigenvectors is
+ * arbitrary. When an eigenvalue is multiple, its eigenvectors are an
+ * arbitrary orthonormal basis of its eigenspace.
+ *
+ * \ingroup OTBPolarimetry
+ */
+class HermitianEigenAnalysis3x3
+{
+public:
+  typedef std::complex<double> ComplexType;
+
+  static void Compute(const double diagonal[3], const ComplexType upper[3],
+                      double eigenValues[3], ComplexType eigenVectors[3][3])
+  {
+    const ComplexType matrix[3][3] = {
+      {ComplexType(diagonal[0], 0.0), upper[0], upper[1]},
+      {std::conj(upper[0]), ComplexType(diagonal[1], 0.0), upper[2]},
+      {std::conj(upper[1]), std::conj(upper[2]), ComplexType(diagonal[2], 0.0)}
+    };
+
+    const double mean = (diagonal[0] + diagonal[1] + diagonal[2]) / 3.0;
+    const double d0 = diagonal[0] - mean;
+    const double d1 = diagonal[1] - mean;
+    const double d2 = diagonal[2] - mean;
+    const double n01 = std::norm(upper[0]);
+    const double n02 = std::norm(upper[1]);
+    const double n12 = std::norm(upper[2]);
+
+    const double p2 = d0 * d0 + d1 * d1 + d2 * d2 + 2.0 * (n01 + n02 + n12);
+
+    // Eigenvalues of B = (A - mean I) / p are 2 cos(phi + 2k pi / 3),
+    // with cos(3 phi) = det(B) / 2
+    double estimates[3] = {mean, mean, mean};
+    if (p2 > 0.0)
+      {
+      const double p = vcl_sqrt(p2 / 6.0);
+      const double det = d0 * d1 * d2 + 2.0 * std::real(upper[0] * upper[2] * std::conj(upper[1]))
+                         - d0 * n12 - d1 * n02 - d2 * n01;
+      const double r = std::min(std::max(det / (2.0 * p * p * p), -1.0), 1.0);
+      const double phi = vcl_acos(r) / 3.0;
+
+      estimates[0] = mean + 2.0 * p * vcl_cos(phi);
+      estimates[2] = mean + 2.0 * p * vcl_cos(phi + 2.0 * CONST_PI / 3.0);
+      estimates[1] = 3.0 * mean - estimates[0] - estimates[2];
+      }
+
+    // Eigenvector of the best separated extreme eigenvalue
+    const unsigned int first = (estimates[0] - estimates[1] >= estimates[1] - estimates[2]) ? 0 : 2;
+    ComplexType v[3];
+    if (!NullVector(matrix, estimates[first], v))
+      {
+      // Scalar matrix: any basis is an eigenbasis
+      for (unsigned int i = 0; i < 3; ++i)
+        {
+        eigenValues[i] = mean;
+        for (unsigned int j = 0; j < 3; ++j)
+          {
+          eigenVectors[i][j] = ComplexType(i == j ? 1.0 : 0.0, 0.0);
+          }
+        }
+      return;
+      }
+
+    // Orthonormal basis (w, z) of the plane orthogonal to v
+    ComplexType w[3];
+    ComplexType z[3];
+    Orthogonal(v, w);
+    ConjugateCrossProduct(v, w, z);
+    Normalize(z);
+
+    // Restriction of the matrix to this plane: [[b00, b01], [conj(b01), b11]]
+    const double b00 = std::real(QuadraticForm(matrix, w, w));
+    const double b11 = std::real(QuadraticForm(matrix, z, z));
+    const ComplexType b01 = QuadraticForm(matrix, w, z);
+
+    const double halfSum = 0.5 * (b00 + b11);
+    const double halfDiff = 0.5 * (b00 - b11);
+    const double radius = vcl_sqrt(halfDiff * halfDiff + std::norm(b01));
+
+    // Eigenvector (x0, x1) of the greatest eigenvalue of the 2x2 matrix,
+    // the other one being (-conj(x1), conj(x0))
+    ComplexType x0(1.0, 0.0);
+    ComplexType x1(0.0, 0.0);
+    if (radius > 0.0)
+      {
+      if (halfDiff >= 0.0)
+        {
+        x0 = ComplexType(halfDiff + radius, 0.0);
+        x1 = std::conj(b01);
+        }
+      else
+        {
+        x0 = b01;
+        x1 = ComplexType(radius - halfDiff, 0.0);
+        }
+      const double norm = vcl_sqrt(std::norm(x0) + std::norm(x1));
+      x0 /= norm;
+      x1 /= norm;
+      }
+
+    double values[3];
+    ComplexType vectors[3][3];
+    values[0] = std::real(QuadraticForm(matrix, v, v));
+    values[1] = halfSum + radius;
+    values[2] = halfSum - radius;
+    for (unsigned int i = 0; i < 3; ++i)
+      {
+      vectors[0][i] = v[i];
+      vectors[1][i] = x0 * w[i] + x1 * z[i];
+      vectors[2][i] = std::conj(x0) * z[i] - std::conj(x1) * w[i];
+      }
+
+    // Sort in decreasing order
+    unsigned int order[3] = {0, 1, 2};
+    if (first == 2)
+      {
+      order[0] = 1;
+      order[1] = 2;
+      order[2] = 0;
+      }
+    for (unsigned int i = 0; i < 2; ++i)
+      {
+      for (unsigned int j = 2; j > i; --j)
+        {
+        if (values[order[j]] > values[order[j - 1]])
+          {
+          std::swap(order[j], order[j - 1]);
+          }
+        }
+      }
+    for (unsigned int i = 0; i < 3; ++i)
+      {
+      eigenValues[i] = values[order[i]];
+      std::copy(vectors[order[i]], vectors[order[i]] + 3, eigenVectors[i]);
+      }
+  }
+
+private:
+  HermitianEigenAnalysis3x3(); //purposely not implemented
+
+  /** Unit vector v such that (A - lambda I) v = 0, as the bilinear cross
+   *  product of the two most independent rows of A - lambda I. Returns
+   *  false when A - lambda I is null. */
+  static bool NullVector(const ComplexType matrix[3][3], double lambda, ComplexType v[3])
+  {
+    ComplexType rows[3][3];
+    for (unsigned int i = 0; i < 3; ++i)
+      {
+      std::copy(matrix[i], matrix[i] + 3, rows[i]);
+      rows[i][i] -= lambda;
+      }
+
+    const unsigned int pairs[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+    double bestNorm = 0.0;
+    for (unsigned int k = 0; k < 3; ++k)
+      {
+      const ComplexType * a = rows[pairs[k][0]];
+      const ComplexType * b = rows[pairs[k][1]];
+      const ComplexType c[3] = {a[1] * b[2] - a[2] * b[1],
+                                a[2] * b[0] - a[0] * b[2],
+                                a[0] * b[1] - a[1] * b[0]};
+      const double norm = std::norm(c[0]) + std::norm(c[1]) + std::norm(c[2]);
+      if (norm > bestNorm)
+        {
+        bestNorm = norm;
+        std::copy(c, c + 3, v);
+        }
+      }
+
+    if (!(bestNorm > 0.0))
+      {
+      return false;
+      }
+
+    Normalize(v);
+    return true;
+  }
+
+  /** Unit vector w orthogonal to the unit vector v */
+  static void Orthogonal(const ComplexType v[3], ComplexType w[3])
+  {
+    // Project the canonical vector along the smallest component of v
+    unsigned int k = 0;
+    for (unsigned int i = 1; i < 3; ++i)
+      {
+      if (std::norm(v[i]) < std::norm(v[k]))
+        {
+        k = i;
+        }
+      }
+    const ComplexType projection = std::conj(v[k]);
+    for (unsigned int i = 0; i < 3; ++i)
+      {
+      w[i] = (i == k ? ComplexType(1.0, 0.0) : ComplexType(0.0, 0.0)) - v[i] * projection;
+      }
+    Normalize(w);
+  }
+
+  /** w = conj(a x b), orthogonal to both a and b for the Hermitian product */
+  static void ConjugateCrossProduct(const ComplexType a[3], const ComplexType b[3], ComplexType w[3])
+  {
+    w[0] = std::conj(a[1] * b[2] - a[2] * b[1]);
+    w[1] = std::conj(a[2] * b[0] - a[0] * b[2]);
+    w[2] = std::conj(a[0] * b[1] - a[1] * b[0]);
+  }
+
+  /** a^H A b */
+  static ComplexType QuadraticForm(const ComplexType matrix[3][3], const ComplexType a[3], const ComplexType b[3])
+  {
+    ComplexType result(0.0, 0.0);
+    for (unsigned int i = 0; i < 3; ++i)
+      {
+      result += std::conj(a[i]) * (matrix[i][0] * b[0] + matrix[i][1] * b[1] + matrix[i][2] * b[2]);
+      }
+    return result;
+  }
+
+  static void Normalize(ComplexType v[3])
+  {
+    const double norm = vcl_sqrt(std::norm(v[0]) + std::norm(v[1]) + std::norm(v[2]));
+    for (unsigned int i = 0; i < 3; ++i)
+      {
+      v[i] /= norm;
+      }
+  }
+};
+
+} // end namespace otb
+
+#endif
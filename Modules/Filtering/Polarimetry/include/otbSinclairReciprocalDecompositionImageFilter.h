@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbSinclairReciprocalDecompositionImageFilter_h
+#define otbSinclairReciprocalDecompositionImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include <complex>
+
+namespace otb
+{
+
+/** \class SinclairReciprocalDecompositionImageFilter
+ * \brief Incoherent decomposition computed directly from the Sinclair matrix images.
+ *
+ * This filter gives the same results as the following pipeline, without
+ * the intermediate complex vector images:
+ * - SinclairReciprocalImageFilter, with the SinclairToReciprocalCoherencyMatrixFunctor
+ *   or the SinclairToReciprocalCovarianceMatrixFunctor,
+ * - itk::MeanImageFilter on each of the 6 channels (through a PerBandVectorImageFilter),
+ * - ReciprocalHAlphaImageFilter, ReciprocalBarnesDecompImageFilter or
+ *   ReciprocalHuynenDecompImageFilter.
+ *
+ * For each tile, the elements of the reciprocal matrices of the padded
+ * region are stored plane by plane (real and imaginary parts apart),
+ * averaged with running sums along the lines, and each averaged matrix
+ * is decomposed in fixed size arrays. The H-Alpha decomposition uses the
+ * closed-form HermitianEigenAnalysis3x3 instead of the vnl complex
+ * eigensystem, so that results may differ from ReciprocalHAlphaImageFilter
+ * by rounding errors, or when two eigenvalues are equal.
+ *
+ * As in itk::MeanImageFilter, pixels outside the image are replaced by the
+ * nearest pixel of the image.
+ *
+ * The output image must be a VectorImage of complex values. It has 3
+ * channels for the H-Alpha decomposition, and 9 channels for the Barnes
+ * and Huynen decompositions.
+ *
+ * \sa SinclairReciprocalImageFilter
+ * \sa ReciprocalHAlphaImageFilter
+ * \sa ReciprocalBarnesDecompImageFilter
+ * \sa ReciprocalHuynenDecompImageFilter
+ * \sa HermitianEigenAnalysis3x3
+ *
+ * \ingroup OTBPolarimetry
+ */
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+class ITK_EXPORT SinclairReciprocalDecompositionImageFilter
+  : public itk::ImageToImageFilter<TInputImageHH, TOutputImage>
+{
+public:
+  /** Standard typedefs */
+  typedef SinclairReciprocalDecompositionImageFilter           Self;
+  typedef itk::ImageToImageFilter<TInputImageHH, TOutputImage> Superclass;
+  typedef itk::SmartPointer<Self>                              Pointer;
+  typedef itk::SmartPointer<const Self>                        ConstPointer;
+
+  /** Type macro */
+  itkNewMacro(Self);
+
+  /** Creation through object factory macro */
+  itkTypeMacro(SinclairReciprocalDecompositionImageFilter, ImageToImageFilter);
+
+  /** Template parameters typedefs */
+  typedef TInputImageHH                                 HHInputImageType;
+  typedef TInputImageHV_VH                              HV_VHInputImageType;
+  typedef TInputImageVV                                 VVInputImageType;
+  typedef TOutputImage                                  OutputImageType;
+  typedef typename OutputImageType::InternalPixelType   OutputInternalPixelType;
+  typedef typename OutputImageType::RegionType          OutputImageRegionType;
+  typedef typename HHInputImageType::RegionType         InputImageRegionType;
+  typedef typename HHInputImageType::IndexType          IndexType;
+  typedef typename HHInputImageType::SizeType           SizeType;
+  typedef std::complex<double>                          ComplexType;
+
+  /** Available decompositions */
+  typedef enum
+  {
+    HAlpha,
+    Barnes,
+    Huynen
+  } DecompositionType;
+
+  /** Matrix computed from the Sinclair matrix and averaged before the
+   *  decomposition */
+  typedef enum
+  {
+    Coherency,
+    Covariance
+  } MatrixRepresentationType;
+
+  void SetInputHH(const TInputImageHH * image);
+  // This method set the second input, same as SetInputVH
+  void SetInputHV(const TInputImageHV_VH * image);
+  // This method set the second input, same as SetInputHV
+  void SetInputVH(const TInputImageHV_VH * image);
+  // This method set the second input, same as SetInputHV and SetInputVH
+  void SetInputHV_VH(const TInputImageHV_VH * image);
+  void SetInputVV(const TInputImageVV * image);
+
+  const TInputImageHH * GetInputHH() const;
+  const TInputImageHV_VH * GetInputHV_VH() const;
+  const TInputImageVV * GetInputVV() const;
+
+  /** Radius of the averaging window */
+  itkSetMacro(Radius, SizeType);
+  itkGetConstReferenceMacro(Radius, SizeType);
+
+  /** Decomposition to compute (HAlpha by default) */
+  itkSetMacro(Decomposition, DecompositionType);
+  itkGetConstMacro(Decomposition, DecompositionType);
+
+  /** Matrix to average (Coherency by default) */
+  itkSetMacro(MatrixRepresentation, MatrixRepresentationType);
+  itkGetConstMacro(MatrixRepresentation, MatrixRepresentationType);
+
+protected:
+  SinclairReciprocalDecompositionImageFilter();
+  ~SinclairReciprocalDecompositionImageFilter() ITK_OVERRIDE {}
+
+  void GenerateOutputInformation() ITK_OVERRIDE;
+
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                            itk::ThreadIdType threadId) ITK_OVERRIDE;
+
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+  /** Number of real values of the reciprocal matrix: T00, T01 (real and
+   *  imaginary parts), T02 (real, imaginary), T11, T12 (real, imaginary), T22 */
+  itkStaticConstMacro(NumberOfElements, unsigned int, 9);
+
+  /** Decompositions of the averaged matrix, given by its real diagonal
+   *  and its upper elements (T01, T02, T12) */
+  static void ComputeHAlpha(const double diagonal[3], const ComplexType upper[3], OutputInternalPixelType * result);
+  static void ComputeBarnes(const double diagonal[3], const ComplexType upper[3], OutputInternalPixelType * result);
+  static void ComputeHuynen(const double diagonal[3], const ComplexType upper[3], OutputInternalPixelType * result);
+
+private:
+  SinclairReciprocalDecompositionImageFilter(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+
+  /** Target vector of the Sinclair matrix, whose outer product is the
+   *  coherency or covariance matrix */
+  void ComputeTargetVector(const ComplexType& hh, const ComplexType& hv, const ComplexType& vv,
+                           ComplexType target[3]) const;
+
+  SizeType                 m_Radius;
+  DecompositionType        m_Decomposition;
+  MatrixRepresentationType m_MatrixRepresentation;
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbSinclairReciprocalDecompositionImageFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,443 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbSinclairReciprocalDecompositionImageFilter_txx
+#define otbSinclairReciprocalDecompositionImageFilter_txx
+
+#include "otbSinclairReciprocalDecompositionImageFilter.h"
+#include "otbHermitianEigenAnalysis3x3.h"
+#include "otbMath.h"
+#include "itkProgressReporter.h"
+#include <vector>
+#include <algorithm>
+
+namespace otb
+{
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::SinclairReciprocalDecompositionImageFilter()
+  : m_Decomposition(HAlpha),
+    m_MatrixRepresentation(Coherency)
+{
+  this->SetNumberOfRequiredInputs(3);
+  m_Radius.Fill(1);
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::SetInputHH(const TInputImageHH * image)
+{
+  this->itk::ProcessObject::SetNthInput(0, const_cast<TInputImageHH *>(image));
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::SetInputHV(const TInputImageHV_VH * image)
+{
+  this->SetInputHV_VH(image);
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::SetInputVH(const TInputImageHV_VH * image)
+{
+  this->SetInputHV_VH(image);
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::SetInputHV_VH(const TInputImageHV_VH * image)
+{
+  this->itk::ProcessObject::SetNthInput(1, const_cast<TInputImageHV_VH *>(image));
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::SetInputVV(const TInputImageVV * image)
+{
+  this->itk::ProcessObject::SetNthInput(2, const_cast<TInputImageVV *>(image));
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+const TInputImageHH *
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::GetInputHH() const
+{
+  return static_cast<const TInputImageHH *>(this->itk::ProcessObject::GetInput(0));
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+const TInputImageHV_VH *
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::GetInputHV_VH() const
+{
+  return static_cast<const TInputImageHV_VH *>(this->itk::ProcessObject::GetInput(1));
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+const TInputImageVV *
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::GetInputVV() const
+{
+  return static_cast<const TInputImageVV *>(this->itk::ProcessObject::GetInput(2));
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::GenerateOutputInformation()
+{
+  // Call to the superclass implementation
+  Superclass::GenerateOutputInformation();
+
+  // initialize the number of channels of the output image
+  this->GetOutput()->SetNumberOfComponentsPerPixel(m_Decomposition == HAlpha ? 3 : 9);
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  typedef itk::ImageBase<HHInputImageType::ImageDimension> ImageBaseType;
+
+  // pad the output requested region by the averaging radius
+  InputImageRegionType paddedRegion = this->GetOutput()->GetRequestedRegion();
+  paddedRegion.PadByRadius(m_Radius);
+
+  for (unsigned int i = 0; i < 3; ++i)
+    {
+    ImageBaseType * inputPtr = dynamic_cast<ImageBaseType *>(this->itk::ProcessObject::GetInput(i));
+    if (!inputPtr)
+      {
+      continue;
+      }
+
+    // crop the input requested region at the input's largest possible region
+    InputImageRegionType inputRequestedRegion = paddedRegion;
+    if (inputRequestedRegion.Crop(inputPtr->GetLargestPossibleRegion()))
+      {
+      inputPtr->SetRequestedRegion(inputRequestedRegion);
+      }
+    else
+      {
+      // store what we tried to request (prior to trying to crop)
+      inputPtr->SetRequestedRegion(inputRequestedRegion);
+
+      // build an exception
+      itk::InvalidRequestedRegionError e(__FILE__, __LINE__);
+      std::ostringstream msg;
+      msg << static_cast<const char *>(this->GetNameOfClass())
+          << "::GenerateInputRequestedRegion()";
+      e.SetLocation(msg.str().c_str());
+      e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
+      e.SetDataObject(inputPtr);
+      throw e;
+      }
+    }
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::ComputeTargetVector(const ComplexType& hh, const ComplexType& hv, const ComplexType& vv,
+                      ComplexType target[3]) const
+{
+  if (m_MatrixRepresentation == Coherency)
+    {
+    // Same as SinclairToReciprocalCoherencyMatrixFunctor
+    target[0] = (hh + vv) / std::sqrt(2.0);
+    target[1] = (hh - vv) / std::sqrt(2.0);
+    target[2] = std::sqrt(2.0) * hv;
+    }
+  else
+    {
+    // Same as SinclairToReciprocalCovarianceMatrixFunctor
+    target[0] = hh;
+    target[1] = std::sqrt(2.0) * hv;
+    target[2] = vv;
+    }
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, itk::ThreadIdType threadId)
+{
+  const HHInputImageType *    inputHH = this->GetInputHH();
+  const HV_VHInputImageType * inputHV = this->GetInputHV_VH();
+  const VVInputImageType *    inputVV = this->GetInputVV();
+  OutputImageType *           output = this->GetOutput();
+  const unsigned int          nbComponents = output->GetNumberOfComponentsPerPixel();
+
+  // Region covered by the averaging windows, pixels outside the image
+  // being replaced by the nearest one
+  InputImageRegionType paddedRegion = outputRegionForThread;
+  paddedRegion.PadByRadius(m_Radius);
+  paddedRegion.Crop(inputHH->GetLargestPossibleRegion());
+
+  const long          paddedX = paddedRegion.GetIndex()[0];
+  const long          paddedY = paddedRegion.GetIndex()[1];
+  const long          paddedWidth = static_cast<long>(paddedRegion.GetSize()[0]);
+  const long          paddedHeight = static_cast<long>(paddedRegion.GetSize()[1]);
+  const unsigned long planeSize = paddedRegion.GetNumberOfPixels();
+
+  // Elements of the reciprocal matrices of the padded region, stored
+  // plane by plane
+  std::vector<double> elements(NumberOfElements * planeSize);
+
+  IndexType index;
+  index[0] = paddedX;
+  for (long y = 0; y < paddedHeight; ++y)
+    {
+    index[1] = paddedY + y;
+    const typename HHInputImageType::InternalPixelType * hh =
+      inputHH->GetBufferPointer() + inputHH->ComputeOffset(index);
+    const typename HV_VHInputImageType::InternalPixelType * hv =
+      inputHV->GetBufferPointer() + inputHV->ComputeOffset(index);
+    const typename VVInputImageType::InternalPixelType * vv =
+      inputVV->GetBufferPointer() + inputVV->ComputeOffset(index);
+
+    double * line = &elements[y * paddedWidth];
+    for (long x = 0; x < paddedWidth; ++x)
+      {
+      ComplexType f[3];
+      this->ComputeTargetVector(static_cast<ComplexType>(hh[x]),
+                                static_cast<ComplexType>(hv[x]),
+                                static_cast<ComplexType>(vv[x]), f);
+
+      // Upper elements of f.f^H
+      const ComplexType t01 = f[0] * std::conj(f[1]);
+      const ComplexType t02 = f[0] * std::conj(f[2]);
+      const ComplexType t12 = f[1] * std::conj(f[2]);
+
+      line[x]                 = std::norm(f[0]);
+      line[x + planeSize]     = t01.real();
+      line[x + 2 * planeSize] = t01.imag();
+      line[x + 3 * planeSize] = t02.real();
+      line[x + 4 * planeSize] = t02.imag();
+      line[x + 5 * planeSize] = std::norm(f[1]);
+      line[x + 6 * planeSize] = t12.real();
+      line[x + 7 * planeSize] = t12.imag();
+      line[x + 8 * planeSize] = std::norm(f[2]);
+      }
+    }
+
+  // support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
+
+  const long   radiusX = static_cast<long>(m_Radius[0]);
+  const long   radiusY = static_cast<long>(m_Radius[1]);
+  const double scale = 1.0 / static_cast<double>((2 * radiusX + 1) * (2 * radiusY + 1));
+  const long   firstX = outputRegionForThread.GetIndex()[0] - paddedX;
+  const long   width = static_cast<long>(outputRegionForThread.GetSize()[0]);
+
+  // Sums over the window height, for each column of the padded region
+  std::vector<double> columnSums(NumberOfElements * paddedWidth);
+
+  IndexType outputIndex = outputRegionForThread.GetIndex();
+  for (unsigned long line = 0; line < outputRegionForThread.GetSize()[1]; ++line, ++outputIndex[1])
+    {
+    const long y = outputIndex[1] - paddedY;
+
+    std::fill(columnSums.begin(), columnSums.end(), 0.0);
+    for (long dy = -radiusY; dy <= radiusY; ++dy)
+      {
+      const long yy = std::min(std::max(y + dy, 0L), paddedHeight - 1);
+      for (unsigned int k = 0; k < NumberOfElements; ++k)
+        {
+        const double * src = &elements[k * planeSize + yy * paddedWidth];
+        double *       dst = &columnSums[k * paddedWidth];
+        for (long x = 0; x < paddedWidth; ++x)
+          {
+          dst[x] += src[x];
+          }
+        }
+      }
+
+    // Window sums, slid along the line
+    double sums[NumberOfElements];
+    for (unsigned int k = 0; k < NumberOfElements; ++k)
+      {
+      const double * column = &columnSums[k * paddedWidth];
+      sums[k] = 0.0;
+      for (long dx = -radiusX; dx <= radiusX; ++dx)
+        {
+        sums[k] += column[std::min(std::max(firstX + dx, 0L), paddedWidth - 1)];
+        }
+      }
+
+    OutputInternalPixelType * outputLine =
+      output->GetBufferPointer() + output->ComputeOffset(outputIndex) * nbComponents;
+
+    for (long x = 0; x < width; ++x)
+      {
+      if (x > 0)
+        {
+        const long entering = std::min(firstX + x + radiusX, paddedWidth - 1);
+        const long leaving = std::max(firstX + x - 1 - radiusX, 0L);
+        for (unsigned int k = 0; k < NumberOfElements; ++k)
+          {
+          const double * column = &columnSums[k * paddedWidth];
+          sums[k] += column[entering] - column[leaving];
+          }
+        }
+
+      const double diagonal[3] = {sums[0] * scale, sums[5] * scale, sums[8] * scale};
+      const ComplexType upper[3] = {ComplexType(sums[1] * scale, sums[2] * scale),
+                                    ComplexType(sums[3] * scale, sums[4] * scale),
+                                    ComplexType(sums[6] * scale, sums[7] * scale)};
+
+      OutputInternalPixelType * result = outputLine + x * nbComponents;
+      switch (m_Decomposition)
+        {
+        case HAlpha:
+          ComputeHAlpha(diagonal, upper, result);
+          break;
+        case Barnes:
+          ComputeBarnes(diagonal, upper, result);
+          break;
+        case Huynen:
+          ComputeHuynen(diagonal, upper, result);
+          break;
+        }
+
+      progress.CompletedPixel();
+      }
+    }
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::ComputeHAlpha(const double diagonal[3], const ComplexType upper[3], OutputInternalPixelType * result)
+{
+  // Same post-processing as ReciprocalHAlphaFunctor
+  const double epsilon = 1e-6;
+
+  double eigenValues[3];
+  ComplexType eigenVectors[3][3];
+  HermitianEigenAnalysis3x3::Compute(diagonal, upper, eigenValues, eigenVectors);
+
+  double totalEigenValues = 0.0;
+  for (unsigned int k = 0; k < 3; ++k)
+    {
+    eigenValues[k] = std::max(eigenValues[k], 0.);
+    totalEigenValues += eigenValues[k];
+    }
+
+  double entropy = 0.0;
+  double alpha = 0.0;
+  for (unsigned int k = 0; k < 3; ++k)
+    {
+    const double p = eigenValues[k] / totalEigenValues;
+
+    //n=log(n)-->0 when n-->0
+    entropy += (p < epsilon) ? 0.0 : -p * log(p) / log(3.0);
+
+    alpha += p * acos(std::min(std::abs(eigenVectors[k][0]), 1.0)) * CONST_180_PI;
+    }
+
+  const double anisotropy = (eigenValues[1] - eigenValues[2]) / (eigenValues[1] + eigenValues[2] + epsilon);
+
+  result[0] = static_cast<OutputInternalPixelType>(entropy);
+  result[1] = static_cast<OutputInternalPixelType>(alpha);
+  result[2] = static_cast<OutputInternalPixelType>(anisotropy);
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::ComputeBarnes(const double diagonal[3], const ComplexType upper[3], OutputInternalPixelType * result)
+{
+  // Same as ReciprocalBarnesDecompFunctor: k_i = C.q_i / sqrt(q_i^H.C.q_i)
+  const ComplexType cov[3][3] = {
+    {ComplexType(diagonal[0], 0.), upper[0], upper[1]},
+    {std::conj(upper[0]), ComplexType(diagonal[1], 0.), upper[2]},
+    {std::conj(upper[1]), std::conj(upper[2]), ComplexType(diagonal[2], 0.)}
+  };
+
+  const double s = 1. / std::sqrt(2.);
+  const ComplexType q[3][3] = {
+    {ComplexType(1., 0.), ComplexType(0., 0.), ComplexType(0., 0.)},
+    {ComplexType(0., 0.), ComplexType(s, 0.), ComplexType(0., s)},
+    {ComplexType(0., 0.), ComplexType(0., s), ComplexType(s, 0.)}
+  };
+
+  for (unsigned int i = 0; i < 3; ++i)
+    {
+    ComplexType cq[3];
+    ComplexType norm(0., 0.);
+    for (unsigned int r = 0; r < 3; ++r)
+      {
+      cq[r] = cov[r][0] * q[i][0] + cov[r][1] * q[i][1] + cov[r][2] * q[i][2];
+      norm += std::conj(q[i][r]) * cq[r];
+      }
+
+    const ComplexType sqrtNorm = std::sqrt(norm);
+    for (unsigned int r = 0; r < 3; ++r)
+      {
+      result[3 * i + r] = static_cast<OutputInternalPixelType>(cq[r] / sqrtNorm);
+      }
+    }
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::ComputeHuynen(const double diagonal[3], const ComplexType upper[3], OutputInternalPixelType * result)
+{
+  // Same as ReciprocalHuynenDecompFunctor
+  const double B0 = (diagonal[1] + diagonal[2]) / 2.0;
+
+  result[0] = static_cast<OutputInternalPixelType>(diagonal[0] / 2.0);
+  result[1] = static_cast<OutputInternalPixelType>(B0);
+  result[2] = static_cast<OutputInternalPixelType>(diagonal[1] - B0);
+  result[3] = static_cast<OutputInternalPixelType>(upper[0].real());
+  result[4] = static_cast<OutputInternalPixelType>(-upper[0].imag());
+  result[5] = static_cast<OutputInternalPixelType>(upper[2].real());
+  result[6] = static_cast<OutputInternalPixelType>(upper[2].imag());
+  result[7] = static_cast<OutputInternalPixelType>(upper[1].imag());
+  result[8] = static_cast<OutputInternalPixelType>(upper[1].real());
+}
+
+template <class TInputImageHH, class TInputImageHV_VH, class TInputImageVV, class TOutputImage>
+void
+SinclairReciprocalDecompositionImageFilter<TInputImageHH, TInputImageHV_VH, TInputImageVV, TOutputImage>
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Radius: " << m_Radius << std::endl;
+  os << indent << "Decomposition: " << m_Decomposition << std::endl;
+  os << indent << "MatrixRepresentation: " << m_MatrixRepresentation << std::endl;
+}
+
+} // end namespace otb
+
+#endif
@@ -60,4 +60,5 @@ void RegisterTests()
   REGISTER_TEST(otbReciprocalHuynenDecompImageFilter);
   REGISTER_TEST(otbReciprocalPauliDecompImageFilterNew);
   REGISTER_TEST(otbReciprocalPauliDecompImageFilter);
+  REGISTER_TEST(otbSinclairReciprocalDecompositionImageFilter);
 }
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "itkMacro.h"
+
+#include "otbImage.h"
+#include "otbVectorImage.h"
+#include "otbImageFileReader.h"
+#include "itkMeanImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "otbPerBandVectorImageFilter.h"
+#include "otbSinclairReciprocalImageFilter.h"
+#include "otbSinclairToReciprocalCoherencyMatrixFunctor.h"
+#include "otbSinclairToReciprocalCovarianceMatrixFunctor.h"
+#include "otbReciprocalHAlphaImageFilter.h"
+#include "otbReciprocalBarnesDecompImageFilter.h"
+#include "otbReciprocalHuynenDecompImageFilter.h"
+#include "otbSinclairReciprocalDecompositionImageFilter.h"
+
+typedef std::complex<double>                     ComplexPixelType;
+typedef otb::Image<ComplexPixelType, 2>          ComplexImageType;
+typedef otb::VectorImage<ComplexPixelType, 2>    ComplexVectorImageType;
+typedef otb::ImageFileReader<ComplexImageType>   ReaderType;
+typedef otb::SinclairReciprocalDecompositionImageFilter<ComplexImageType, ComplexImageType,
+  ComplexImageType, ComplexVectorImageType>      DecompositionFilterType;
+
+// Decomposition computed with the pipeline of SinclairReciprocalImageFilter,
+// PerBandVectorImageFilter<MeanImageFilter> and one of the decomposition filters
+template <class TSinclairFunctor>
+ComplexVectorImageType::Pointer
+ComputeReferenceDecomposition(ReaderType * readerHH, ReaderType * readerHV, ReaderType * readerVV,
+                              unsigned int size, DecompositionFilterType::DecompositionType decomposition)
+{
+  typedef otb::SinclairReciprocalImageFilter<ComplexImageType, ComplexImageType, ComplexImageType,
+    ComplexVectorImageType, TSinclairFunctor>                                         SinclairFilterType;
+  typedef itk::MeanImageFilter<ComplexImageType, ComplexImageType>                    MeanFilterType;
+  typedef otb::PerBandVectorImageFilter<ComplexVectorImageType, ComplexVectorImageType,
+    MeanFilterType>                                                                   PerBandMeanFilterType;
+  typedef itk::ImageToImageFilter<ComplexVectorImageType, ComplexVectorImageType>    DecompFilterType;
+  typedef otb::ReciprocalHAlphaImageFilter<ComplexVectorImageType, ComplexVectorImageType>       HAlphaFilterType;
+  typedef otb::ReciprocalBarnesDecompImageFilter<ComplexVectorImageType, ComplexVectorImageType> BarnesFilterType;
+  typedef otb::ReciprocalHuynenDecompImageFilter<ComplexVectorImageType, ComplexVectorImageType> HuynenFilterType;
+
+  typename SinclairFilterType::Pointer sinclair = SinclairFilterType::New();
+  typename PerBandMeanFilterType::Pointer perBand = PerBandMeanFilterType::New();
+
+  typename MeanFilterType::InputSizeType radius;
+  radius.Fill(size);
+  perBand->GetFilter()->SetRadius(radius);
+
+  sinclair->SetInputHH(readerHH->GetOutput());
+  sinclair->SetInputHV_VH(readerHV->GetOutput());
+  sinclair->SetInputVV(readerVV->GetOutput());
+  perBand->SetInput(sinclair->GetOutput());
+
+  DecompFilterType::Pointer decomp;
+  switch (decomposition)
+    {
+    case DecompositionFilterType::HAlpha:
+      decomp = HAlphaFilterType::New().GetPointer();
+      break;
+    case DecompositionFilterType::Barnes:
+      decomp = BarnesFilterType::New().GetPointer();
+      break;
+    default:
+      decomp = HuynenFilterType::New().GetPointer();
+      break;
+    }
+  decomp->SetInput(perBand->GetOutput());
+  decomp->Update();
+
+  ComplexVectorImageType::Pointer output = decomp->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+int otbSinclairReciprocalDecompositionImageFilter(int itkNotUsed(argc), char * argv[])
+{
+  const char * inputFilenameHH = argv[1];
+  const char * inputFilenameHV = argv[2];
+  const char * inputFilenameVV = argv[3];
+  const unsigned int size = atoi(argv[4]);
+  const std::string decompositionName = argv[5];
+  const std::string matrixName = argv[6];
+  const double tolerance = atof(argv[7]);
+
+  DecompositionFilterType::DecompositionType decomposition = DecompositionFilterType::HAlpha;
+  if (decompositionName == "barnes")
+    {
+    decomposition = DecompositionFilterType::Barnes;
+    }
+  else if (decompositionName == "huynen")
+    {
+    decomposition = DecompositionFilterType::Huynen;
+    }
+
+  ReaderType::Pointer readerHH = ReaderType::New();
+  ReaderType::Pointer readerHV = ReaderType::New();
+  ReaderType::Pointer readerVV = ReaderType::New();
+  readerHH->SetFileName(inputFilenameHH);
+  readerHV->SetFileName(inputFilenameHV);
+  readerVV->SetFileName(inputFilenameVV);
+
+  DecompositionFilterType::Pointer filter = DecompositionFilterType::New();
+  DecompositionFilterType::SizeType radius;
+  radius.Fill(size);
+  filter->SetRadius(radius);
+  filter->SetDecomposition(decomposition);
+  filter->SetInputHH(readerHH->GetOutput());
+  filter->SetInputHV_VH(readerHV->GetOutput());
+  filter->SetInputVV(readerVV->GetOutput());
+
+  ComplexVectorImageType::Pointer reference;
+  if (matrixName == "covariance")
+    {
+    filter->SetMatrixRepresentation(DecompositionFilterType::Covariance);
+    reference = ComputeReferenceDecomposition<otb::Functor::SinclairToReciprocalCovarianceMatrixFunctor<
+      ComplexPixelType, ComplexPixelType, ComplexPixelType, ComplexVectorImageType::PixelType> >(
+        readerHH, readerHV, readerVV, size, decomposition);
+    }
+  else
+    {
+    filter->SetMatrixRepresentation(DecompositionFilterType::Coherency);
+    reference = ComputeReferenceDecomposition<otb::Functor::SinclairToReciprocalCoherencyMatrixFunctor<
+      ComplexPixelType, ComplexPixelType, ComplexPixelType, ComplexVectorImageType::PixelType> >(
+        readerHH, readerHV, readerVV, size, decomposition);
+    }
+
+  filter->Update();
+
+  if (filter->GetOutput()->GetNumberOfComponentsPerPixel() != reference->GetNumberOfComponentsPerPixel())
+    {
+    std::cerr << "Wrong number of components: " << filter->GetOutput()->GetNumberOfComponentsPerPixel()
+              << " instead of " << reference->GetNumberOfComponentsPerPixel() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Compare the outputs, relatively to the magnitude of the reference
+  typedef itk::ImageRegionConstIterator<ComplexVectorImageType> IteratorType;
+  IteratorType itRef(reference, reference->GetLargestPossibleRegion());
+  IteratorType itOut(filter->GetOutput(), filter->GetOutput()->GetLargestPossibleRegion());
+
+  const unsigned int nbComponents = reference->GetNumberOfComponentsPerPixel();
+  unsigned long nbErrors = 0;
+  double maxError = 0.0;
+  for (itRef.GoToBegin(), itOut.GoToBegin(); !itRef.IsAtEnd(); ++itRef, ++itOut)
+    {
+    for (unsigned int band = 0; band < nbComponents; ++band)
+      {
+      const ComplexPixelType ref = itRef.Get()[band];
+      const double error = std::abs(itOut.Get()[band] - ref) / std::max(1.0, std::abs(ref));
+      maxError = std::max(maxError, error);
+      if (error > tolerance)
+        {
+        ++nbErrors;
+        }
+      }
+    }
+
+  std::cout << "Maximum error: " << maxError << std::endl;
+  std::cout << "Number of errors: " << nbErrors << std::endl;
+
+  return nbErrors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
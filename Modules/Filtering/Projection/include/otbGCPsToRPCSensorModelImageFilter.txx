@@ -248,43 +248,40 @@ GCPsToRPCSensorModelImageFilter<TImage>
   rsTransform->SetInputKeywordList(m_Keywordlist);
   rsTransform->InstantiateTransform();
 
-  ContinuousIndexType   idFix, idOut;
   Continuous3DIndexType idOut3D, idTrans3D;
 
-  Point2DType sensorPoint;
-  Point3DType groundPoint;
-
   double sum = 0.;
   m_MeanError = 0.;
 
   // Clear Error container
   m_ErrorsContainer.clear();
 
+  // Project all the GCPs at once
+  RSTransformType::InputPointContainerType  sensorPoints(m_GCPsContainer.size());
+  RSTransformType::OutputPointContainerType groundPoints;
+
   for (unsigned int i = 0; i < m_GCPsContainer.size(); ++i)
     {
-    // GCP value
-    sensorPoint = m_GCPsContainer[i].first;
-    groundPoint = m_GCPsContainer[i].second;
+    sensorPoints[i][0] = m_GCPsContainer[i].first[0];
+    sensorPoints[i][1] = m_GCPsContainer[i].first[1];
+    sensorPoints[i][2] = m_GCPsContainer[i].second[2];
+    }
 
-    // Compute Transform
-    Point3DType groundPointTemp, sensorPointTemp;
-    sensorPointTemp[0] = sensorPoint[0];
-    sensorPointTemp[1] = sensorPoint[1];
-    sensorPointTemp[2] = groundPoint[2];
+  rsTransform->TransformPoints(sensorPoints, groundPoints);
 
-    groundPointTemp = rsTransform->TransformPoint(sensorPointTemp);
+  for (unsigned int i = 0; i < m_GCPsContainer.size(); ++i)
+    {
+    // GCP value
+    const Point3DType & groundPoint = m_GCPsContainer[i].second;
 
     // Compute Euclidian distance
-    idFix[0] = sensorPoint[0];
-    idFix[1] = sensorPoint[1];
-
     idOut3D[0] = groundPoint[0];
     idOut3D[1] = groundPoint[1];
     idOut3D[2] = groundPoint[2];
 
-    idTrans3D[0] = groundPointTemp[0];
-    idTrans3D[1] = groundPointTemp[1];
-    idTrans3D[2] = groundPointTemp[2];
+    idTrans3D[0] = groundPoints[i][0];
+    idTrans3D[1] = groundPoints[i][1];
+    idTrans3D[2] = groundPoints[i][2];
 
     double error = idOut3D.EuclideanDistanceTo(idTrans3D);
 
@@ -85,6 +85,7 @@ public:
   typedef typename ResamplerType::IndexType                IndexType;
   typedef typename ResamplerType::RegionType               RegionType;
   typedef typename ResamplerType::InterpolatorType         InterpolatorType;
+  typedef typename ResamplerType::DisplacementFieldType    DisplacementFieldType;
 
   /** Estimate the rpc model */
   typedef PhysicalToRPCSensorModelImageFilter<InputImageType>  InputRpcModelEstimatorType;
@@ -146,6 +147,60 @@ public:
                           EdgePaddingValue,
                           typename OutputImageType::PixelType);
 
+  /** Use the row-based warp kernels for nearest, linear and BCO
+   * interpolators (off by default) */
+  otbSetObjectMemberMacro(Resampler, FastWarp, bool);
+  otbGetObjectMemberMacro(Resampler, FastWarp, bool);
+
+  /** Evaluate the RPC sensor models natively instead of through ossim
+   * (off by default) */
+  otbSetObjectMemberMacro(Transform, UseNativeRPCModel, bool);
+  otbGetObjectMemberMacro(Transform, UseNativeRPCModel, bool);
+
+  /** Adaptive displacement field: maximum interpolation error of the
+   * sensor model, in input image physical units (0 disables it) */
+  otbSetObjectMemberMacro(Resampler, DisplacementFieldTolerance, double);
+  otbGetObjectMemberMacro(Resampler, DisplacementFieldTolerance, double);
+
+  /** Maximum number of subdivisions of the DisplacementFieldSpacing cells */
+  otbSetObjectMemberMacro(Resampler, DisplacementFieldSubdivisionLevels, unsigned int);
+  otbGetObjectMemberMacro(Resampler, DisplacementFieldSubdivisionLevels, unsigned int);
+
+  /** Statistics of the displacement field generation: largest
+   * interpolation error at the checked cell centres, number of exact model
+   * evaluations and number of evaluations saved compared to a dense grid */
+  otbGetObjectMemberMacro(Resampler, DisplacementFieldMaximumError, double);
+  otbGetObjectMemberMacro(Resampler, NumberOfExactEvaluations, unsigned long);
+  otbGetObjectMemberMacro(Resampler, NumberOfSavedEvaluations, unsigned long);
+
+  /** Displacement field computed from the sensor models, to be exported
+   * and reused with SetInputDisplacementField() */
+  DisplacementFieldType * GetDisplacementField()
+  {
+    return m_Resampler->GetDisplacementField();
+  }
+
+  /** Precomputed displacement field: when set, neither the transform nor
+   * the rpc estimation are performed and the input is only resampled */
+  void SetInputDisplacementField(const DisplacementFieldType * field)
+  {
+    m_Resampler->SetInputDisplacementField(field);
+    this->Modified();
+  }
+  otbGetObjectMemberConstMacro(Resampler, InputDisplacementField, const DisplacementFieldType *);
+
+  /** Read amplification of the input requests (see StreamingWarpImageFilter) */
+  otbGetObjectMemberConstMacro(Resampler, ReadAmplification, double);
+  otbGetObjectMemberConstMacro(Resampler, LastReadAmplification, double);
+
+  /** Continuous index in the input image of an output physical point */
+  typedef typename ResamplerType::InputContinuousIndexType InputContinuousIndexType;
+  bool EvaluateInputContinuousIndex(const OriginType & outputPoint,
+                                    InputContinuousIndexType & inputIndex)
+  {
+    return m_Resampler->EvaluateInputContinuousIndex(outputPoint, inputIndex);
+  }
+
   /**
    * Set/Get input & output projections.
    * Set/Get input & output keywordlist
@@ -89,15 +89,19 @@ GenericRSResampleImageFilter<TInputImage, TOutputImage>
   if (m_EstimateOutputRpcModel)
     this->EstimateOutputRpcModel();
 
-  // Estimate the input rpc model if it is needed
-  if (m_EstimateInputRpcModel && !m_RpcEstimationUpdated)
+  // The sensor models are not needed with a precomputed displacement field
+  if (m_Resampler->GetInputDisplacementField() == ITK_NULLPTR)
     {
-    this->EstimateInputRpcModel();
+    // Estimate the input rpc model if it is needed
+    if (m_EstimateInputRpcModel && !m_RpcEstimationUpdated)
+      {
+      this->EstimateInputRpcModel();
+      }
+
+    // Instantiate the RS transform
+    this->UpdateTransform();
     }
 
-  // Instantiate the RS transform
-  this->UpdateTransform();
-
   m_Resampler->SetInput(this->GetInput());
   m_Resampler->SetTransform(m_Transform);
   m_Resampler->SetDisplacementFieldSpacing(this->GetDisplacementFieldSpacing());
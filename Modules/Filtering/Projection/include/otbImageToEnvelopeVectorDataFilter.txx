@@ -145,7 +145,7 @@ ImageToEnvelopeVectorDataFilter<TInputImage, TOutputVectorData>
   lr[1]+=size[1];
 
   // Get corners as physical points
-  typename InputImageType::PointType ulp, urp, lrp, llp, current;
+  typename InputImageType::PointType ulp, urp, lrp, llp;
   inputPtr->TransformContinuousIndexToPhysicalPoint(ul, ulp);
   inputPtr->TransformContinuousIndexToPhysicalPoint(ur, urp);
   inputPtr->TransformContinuousIndexToPhysicalPoint(lr, lrp);
@@ -156,13 +156,11 @@ ImageToEnvelopeVectorDataFilter<TInputImage, TOutputVectorData>
   itk::ContinuousIndex<double,2> edgeIndex;
   typename InputImageType::PointType edgePoint;
 
-  // Build envelope polygon
-  typename PolygonType::Pointer envelope = PolygonType::New();
-  typename PolygonType::VertexType vertex;
-  current = m_Transform->TransformPoint(ulp);
-  vertex[0] = current[0];
-  vertex[1] = current[1];
-  envelope->AddVertex(vertex);
+  // Gather the envelope points, so that the sensor model is called once
+  typename InternalTransformType::InputPointContainerType  edgePoints;
+  typename InternalTransformType::OutputPointContainerType groundPoints;
+
+  edgePoints.push_back(ulp);
 
   if (m_SamplingRate>0)
     {
@@ -171,18 +169,12 @@ ImageToEnvelopeVectorDataFilter<TInputImage, TOutputVectorData>
     while (edgeIndex[0]<ur[0])
       {
       inputPtr->TransformContinuousIndexToPhysicalPoint(edgeIndex, edgePoint);
-      current = m_Transform->TransformPoint(edgePoint);
-      vertex[0] = current[0];
-      vertex[1] = current[1];
-      envelope->AddVertex(vertex);
+      edgePoints.push_back(edgePoint);
       edgeIndex[0]+=m_SamplingRate;
       }
     }
 
-  current = m_Transform->TransformPoint(urp);
-  vertex[0] = current[0];
-  vertex[1] = current[1];
-  envelope->AddVertex(vertex);
+  edgePoints.push_back(urp);
 
   if (m_SamplingRate>0)
     {
@@ -191,18 +183,12 @@ ImageToEnvelopeVectorDataFilter<TInputImage, TOutputVectorData>
     while (edgeIndex[1]<lr[1])
       {
       inputPtr->TransformContinuousIndexToPhysicalPoint(edgeIndex, edgePoint);
-      current = m_Transform->TransformPoint(edgePoint);
-      vertex[0] = current[0];
-      vertex[1] = current[1];
-      envelope->AddVertex(vertex);
+      edgePoints.push_back(edgePoint);
       edgeIndex[1]+=m_SamplingRate;
       }
     }
 
-  current = m_Transform->TransformPoint(lrp);
-  vertex[0] = current[0];
-  vertex[1] = current[1];
-  envelope->AddVertex(vertex);
+  edgePoints.push_back(lrp);
 
   if (m_SamplingRate>0)
     {
@@ -211,18 +197,12 @@ ImageToEnvelopeVectorDataFilter<TInputImage, TOutputVectorData>
     while (edgeIndex[0]>ll[0])
       {
       inputPtr->TransformContinuousIndexToPhysicalPoint(edgeIndex, edgePoint);
-      current = m_Transform->TransformPoint(edgePoint);
-      vertex[0] = current[0];
-      vertex[1] = current[1];
-      envelope->AddVertex(vertex);
+      edgePoints.push_back(edgePoint);
       edgeIndex[0]-=m_SamplingRate;
       }
     }
 
-  current = m_Transform->TransformPoint(llp);
-  vertex[0] = current[0];
-  vertex[1] = current[1];
-  envelope->AddVertex(vertex);
+  edgePoints.push_back(llp);
 
   if (m_SamplingRate>0)
     {
@@ -231,14 +211,23 @@ ImageToEnvelopeVectorDataFilter<TInputImage, TOutputVectorData>
     while (edgeIndex[1]>ul[1])
       {
       inputPtr->TransformContinuousIndexToPhysicalPoint(edgeIndex, edgePoint);
-      current = m_Transform->TransformPoint(edgePoint);
-      vertex[0] = current[0];
-      vertex[1] = current[1];
-      envelope->AddVertex(vertex);
+      edgePoints.push_back(edgePoint);
       edgeIndex[1]-=m_SamplingRate;
       }
     }
 
+  m_Transform->TransformPoints(edgePoints, groundPoints);
+
+  // Build envelope polygon
+  typename PolygonType::Pointer envelope = PolygonType::New();
+  typename PolygonType::VertexType vertex;
+  for (unsigned int i = 0; i < groundPoints.size(); ++i)
+    {
+    vertex[0] = groundPoints[i][0];
+    vertex[1] = groundPoints[i][1];
+    envelope->AddVertex(vertex);
+    }
+
   // Add polygon to the VectorData tree
   OutputDataTreePointerType tree = outputPtr->GetDataTree();
 
@@ -23,6 +23,7 @@
 
 #include "otbTransform.h"
 #include "itkMacro.h"
+#include <algorithm>
 
 namespace otb
 {
@@ -63,6 +64,9 @@ public:
   typedef itk::Point<ScalarType, Dimension>         InputPointType;
   typedef itk::Point<ScalarType, Dimension>         OutputPointType;
 
+  typedef typename Superclass::InputPointContainerType  InputPointContainerType;
+  typedef typename Superclass::OutputPointContainerType OutputPointContainerType;
+
   typedef itk::Vector<double, Dimension> SpacingType;
   typedef itk::Point<double, Dimension>  OriginType;
 
@@ -147,6 +151,66 @@ public:
     return outputPoint;
   }
 
+  /** Transform a batch of points. Each polynomial is evaluated over the
+   * whole batch, one term at a time, which lets the compiler vectorize the
+   * evaluation. The arithmetic is the same as in TransformPoint(). */
+  void TransformPoints(const InputPointContainerType& inputPoints,
+                       OutputPointContainerType& outputPoints) const ITK_OVERRIDE
+  {
+    // Check for consistency
+    if(this->GetNumberOfParameters() != this->m_Parameters.size())
+      {
+      itkExceptionMacro(<<"Wrong number of parameters: found "<<this->m_Parameters.Size()<<", expected "<<this->GetNumberOfParameters());
+      }
+
+    const unsigned long nbPoints = inputPoints.size();
+    outputPoints.resize(nbPoints);
+
+    unsigned int dimensionStride = (m_DenominatorDegree+1)+(m_NumeratorDegree+1);
+
+    std::vector<TScalarType> coordinates(nbPoints), currentPower(nbPoints);
+    std::vector<TScalarType> num(nbPoints), denom(nbPoints);
+
+    for(unsigned int dim = 0; dim < SpaceDimension; ++dim)
+      {
+      for(unsigned long i = 0; i < nbPoints; ++i)
+        {
+        coordinates[i] = inputPoints[i][dim];
+        }
+
+      // Numerator
+      std::fill(num.begin(), num.end(), itk::NumericTraits<TScalarType>::Zero);
+      std::fill(currentPower.begin(), currentPower.end(), 1.);
+      for(unsigned int numDegree = 0; numDegree <= m_NumeratorDegree; ++numDegree)
+        {
+        const ParametersValueType coef = this->m_Parameters[dim*dimensionStride+numDegree];
+        for(unsigned long i = 0; i < nbPoints; ++i)
+          {
+          num[i] += coef * currentPower[i];
+          currentPower[i] *= coordinates[i];
+          }
+        }
+
+      // Denominator
+      std::fill(denom.begin(), denom.end(), itk::NumericTraits<TScalarType>::Zero);
+      std::fill(currentPower.begin(), currentPower.end(), 1.);
+      for(unsigned int denomDegree = 0; denomDegree <= m_DenominatorDegree; ++denomDegree)
+        {
+        const ParametersValueType coef = this->m_Parameters[dim*dimensionStride+m_NumeratorDegree+denomDegree+1];
+        for(unsigned long i = 0; i < nbPoints; ++i)
+          {
+          denom[i] += coef * currentPower[i];
+          currentPower[i] *= coordinates[i];
+          }
+        }
+
+      for(unsigned long i = 0; i < nbPoints; ++i)
+        {
+        outputPoints[i][dim] = num[i] / denom[i];
+        }
+      }
+  }
+
   /** Get the number of parameters */
   NumberOfParametersType GetNumberOfParameters() const ITK_OVERRIDE
   {
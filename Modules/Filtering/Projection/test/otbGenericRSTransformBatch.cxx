@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <iostream>
+
+#include "otbVectorImage.h"
+#include "otbImageFileReader.h"
+#include "otbGenericRSTransform.h"
+#include <ogr_spatialref.h>
+
+/*
+ * Checks that the batch projection of a grid of points gives the same
+ * result as the point by point projection, in both directions.
+ */
+int otbGenericRSTransformBatch(int itkNotUsed(argc), char* argv[])
+{
+  typedef otb::VectorImage<double, 2>     ImageType;
+  typedef otb::ImageFileReader<ImageType> ReaderType;
+  typedef otb::GenericRSTransform<>       TransformType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(argv[1]);
+  reader->UpdateOutputInformation();
+
+  OGRSpatialReference oSRS;
+  oSRS.SetWellKnownGeogCS("WGS84");
+  char * wgsRef = ITK_NULLPTR;
+  oSRS.exportToWkt(&wgsRef);
+
+  TransformType::Pointer img2wgs = TransformType::New();
+  img2wgs->SetInputProjectionRef(reader->GetOutput()->GetProjectionRef());
+  img2wgs->SetInputKeywordList(reader->GetOutput()->GetImageKeywordlist());
+  img2wgs->SetOutputProjectionRef(wgsRef);
+  img2wgs->InstantiateTransform();
+
+  TransformType::Pointer wgs2img = TransformType::New();
+  img2wgs->GetInverse(wgs2img);
+
+  CPLFree(wgsRef);
+
+  const ImageType::SizeType size = reader->GetOutput()->GetLargestPossibleRegion().GetSize();
+  const unsigned int nbSteps = 20;
+
+  TransformType::InputPointContainerType imagePoints;
+  for (unsigned int j = 0; j <= nbSteps; ++j)
+    {
+    for (unsigned int i = 0; i <= nbSteps; ++i)
+      {
+      TransformType::InputPointType p;
+      p[0] = static_cast<double>(i * size[0]) / nbSteps;
+      p[1] = static_cast<double>(j * size[1]) / nbSteps;
+      imagePoints.push_back(p);
+      }
+    }
+
+  TransformType::OutputPointContainerType geoPoints, backPoints;
+  img2wgs->TransformPoints(imagePoints, geoPoints);
+  wgs2img->TransformPoints(geoPoints, backPoints);
+
+  if (geoPoints.size() != imagePoints.size() || backPoints.size() != imagePoints.size())
+    {
+    std::cerr << "Batch output has " << geoPoints.size() << " and " << backPoints.size()
+              << " points, expected " << imagePoints.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const double tolerance = 1e-9;
+  for (unsigned int k = 0; k < imagePoints.size(); ++k)
+    {
+    const TransformType::OutputPointType geoPoint = img2wgs->TransformPoint(imagePoints[k]);
+    const TransformType::OutputPointType backPoint = wgs2img->TransformPoint(geoPoints[k]);
+
+    if (geoPoint.EuclideanDistanceTo(geoPoints[k]) > tolerance
+        || backPoint.EuclideanDistanceTo(backPoints[k]) > tolerance)
+      {
+      std::cerr << "Mismatch at " << imagePoints[k] << ": "
+                << geoPoint << " / " << geoPoints[k] << ", "
+                << backPoint << " / " << backPoints[k] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -56,6 +56,7 @@ void RegisterTests()
   REGISTER_TEST(otbGeometriesProjectionFilterFromGeoToMap);
   REGISTER_TEST(otbVectorDataProjectionFilterFromMapToImage);
   REGISTER_TEST(otbGenericRSTransformFromImage);
+  REGISTER_TEST(otbGenericRSTransformBatch);
   REGISTER_TEST(otbGenericRSTransformImageAndMNTToWGS84ConversionChecking);
   REGISTER_TEST(otbCompositeTransform);
   REGISTER_TEST(otbLeastSquareAffineTransformEstimator);
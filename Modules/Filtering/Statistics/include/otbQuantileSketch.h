@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbQuantileSketch_h
+#define otbQuantileSketch_h
+
+#include <vector>
+#include <cstddef>
+
+namespace otb
+{
+
+/** \class QuantileSketch
+ * \brief One-pass, mergeable approximation of the distribution of a scalar variable.
+ *
+ * The sketch is a merging t-digest: values are buffered, then sorted and
+ * merged into a bounded list of weighted centroids. Centroids are kept
+ * small near the tails of the distribution and larger around the median,
+ * so that extreme quantiles remain accurate. The memory footprint only
+ * depends on the compression parameter (at most about compression
+ * centroids), not on the number of values added.
+ *
+ * Two sketches can be merged, which allows accumulating one sketch per
+ * thread and per streaming chunk, and combining them at the end.
+ *
+ * Minimum and maximum are tracked exactly and quantiles 0 and 1 return them.
+ *
+ * The const methods do not modify the sketch, so that they can be called
+ * concurrently once the sketch is filled. GetQuantile() is fastest after
+ * Compress() has flushed the buffered values, which the statistics
+ * filters do at the end of their Synthetize().
+ *
+ * \ingroup OTBStatistics
+ */
+template <class TRealType = double>
+class QuantileSketch
+{
+public:
+  typedef QuantileSketch Self;
+  typedef TRealType      RealType;
+
+  explicit QuantileSketch(double compression = 100.);
+
+  /** Set/Get the compression. Larger values give more accurate quantiles
+   * at the cost of more memory. Setting it clears the sketch. */
+  void SetCompression(double compression);
+  double GetCompression() const
+  {
+    return m_Compression;
+  }
+
+  /** Add a value with the given weight */
+  void Add(RealType value, double weight = 1.)
+  {
+    if (m_Count == 0.)
+      {
+      m_Minimum = value;
+      m_Maximum = value;
+      }
+    else if (value < m_Minimum)
+      {
+      m_Minimum = value;
+      }
+    else if (value > m_Maximum)
+      {
+      m_Maximum = value;
+      }
+    m_Count += weight;
+    m_Buffer.push_back(Centroid(value, weight));
+    if (m_Buffer.size() >= m_BufferCapacity)
+      {
+      this->Compress();
+      }
+  }
+
+  /** Merge another sketch into this one */
+  void Merge(const Self & other);
+
+  /** Remove all values */
+  void Clear();
+
+  /** Total weight of the values added */
+  double GetCount() const
+  {
+    return m_Count;
+  }
+
+  bool IsEmpty() const
+  {
+    return m_Count == 0.;
+  }
+
+  RealType GetMinimum() const
+  {
+    return m_Minimum;
+  }
+
+  RealType GetMaximum() const
+  {
+    return m_Maximum;
+  }
+
+  /** Estimated value of quantile q (in [0,1]). Returns 0 on an empty sketch.
+   * If values are still buffered, they are merged in a temporary copy. */
+  RealType GetQuantile(double q) const;
+
+  /** Merge the buffered values into the centroids */
+  void Compress();
+
+  /** Number of centroids, not counting the values still buffered */
+  std::size_t GetNumberOfCentroids() const
+  {
+    return m_Centroids.size();
+  }
+
+private:
+  struct Centroid
+  {
+    Centroid(double mean = 0., double weight = 0.) : m_Mean(mean), m_Weight(weight) {}
+
+    bool operator<(const Centroid & other) const
+    {
+      return m_Mean < other.m_Mean;
+    }
+
+    double m_Mean;
+    double m_Weight;
+  };
+
+  typedef std::vector<Centroid> CentroidVectorType;
+
+  /** Largest quantile a centroid starting at quantile q may reach */
+  double GetUpperQuantileLimit(double q) const;
+
+  double                     m_Compression;
+  std::size_t                m_BufferCapacity;
+  double                     m_Count;
+  RealType                   m_Minimum;
+  RealType                   m_Maximum;
+  CentroidVectorType         m_Centroids;
+  CentroidVectorType         m_Buffer;
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbQuantileSketch.txx"
+#endif
+
+#endif
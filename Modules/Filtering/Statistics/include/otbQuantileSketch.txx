@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbQuantileSketch_txx
+#define otbQuantileSketch_txx
+
+#include "otbQuantileSketch.h"
+
+#include <algorithm>
+#include "vnl/vnl_math.h"
+
+namespace otb
+{
+
+template <class TRealType>
+QuantileSketch<TRealType>
+::QuantileSketch(double compression)
+  : m_Compression(100.),
+    m_BufferCapacity(500),
+    m_Count(0.),
+    m_Minimum(0),
+    m_Maximum(0)
+{
+  this->SetCompression(compression);
+}
+
+template <class TRealType>
+void
+QuantileSketch<TRealType>
+::SetCompression(double compression)
+{
+  m_Compression = std::max(compression, 10.);
+  m_BufferCapacity = static_cast<std::size_t>(5. * m_Compression);
+  this->Clear();
+}
+
+template <class TRealType>
+void
+QuantileSketch<TRealType>
+::Clear()
+{
+  m_Count = 0.;
+  m_Minimum = 0;
+  m_Maximum = 0;
+  m_Centroids.clear();
+  m_Buffer.clear();
+}
+
+template <class TRealType>
+void
+QuantileSketch<TRealType>
+::Merge(const Self & other)
+{
+  if (other.IsEmpty())
+    {
+    return;
+    }
+  if (this->IsEmpty())
+    {
+    m_Minimum = other.m_Minimum;
+    m_Maximum = other.m_Maximum;
+    }
+  else
+    {
+    m_Minimum = std::min(m_Minimum, other.m_Minimum);
+    m_Maximum = std::max(m_Maximum, other.m_Maximum);
+    }
+  m_Count += other.m_Count;
+  m_Buffer.insert(m_Buffer.end(), other.m_Centroids.begin(), other.m_Centroids.end());
+  m_Buffer.insert(m_Buffer.end(), other.m_Buffer.begin(), other.m_Buffer.end());
+  if (m_Buffer.size() >= m_BufferCapacity)
+    {
+    this->Compress();
+    }
+}
+
+template <class TRealType>
+void
+QuantileSketch<TRealType>
+::Compress()
+{
+  if (m_Buffer.empty())
+    {
+    return;
+    }
+  m_Buffer.insert(m_Buffer.end(), m_Centroids.begin(), m_Centroids.end());
+  std::sort(m_Buffer.begin(), m_Buffer.end());
+
+  // Greedy merge: a centroid may span at most one unit of the scale
+  // function k(q) = compression / (2 pi) asin(2q - 1), which bounds the
+  // number of centroids and keeps them small near the tails.
+  CentroidVectorType merged;
+  merged.reserve(static_cast<std::size_t>(m_Compression) + 1);
+  Centroid current = m_Buffer.front();
+  double cumulated = 0.;
+  double limit = this->GetUpperQuantileLimit(0.);
+  for (typename CentroidVectorType::const_iterator it = m_Buffer.begin() + 1; it != m_Buffer.end(); ++it)
+    {
+    const double proposed = current.m_Weight + it->m_Weight;
+    if (cumulated + proposed <= limit * m_Count)
+      {
+      current.m_Mean += (it->m_Mean - current.m_Mean) * it->m_Weight / proposed;
+      current.m_Weight = proposed;
+      }
+    else
+      {
+      cumulated += current.m_Weight;
+      merged.push_back(current);
+      current = *it;
+      limit = this->GetUpperQuantileLimit(cumulated / m_Count);
+      }
+    }
+  merged.push_back(current);
+
+  m_Centroids.swap(merged);
+  m_Buffer.clear();
+}
+
+template <class TRealType>
+double
+QuantileSketch<TRealType>
+::GetUpperQuantileLimit(double q) const
+{
+  const double angle = vcl_asin(2. * q - 1.) + 2. * vnl_math::pi / m_Compression;
+  if (angle >= vnl_math::pi_over_2)
+    {
+    return 1.;
+    }
+  return (1. + vcl_sin(angle)) / 2.;
+}
+
+template <class TRealType>
+typename QuantileSketch<TRealType>::RealType
+QuantileSketch<TRealType>
+::GetQuantile(double q) const
+{
+  if (this->IsEmpty())
+    {
+    return 0;
+    }
+  if (q <= 0.)
+    {
+    return m_Minimum;
+    }
+  if (q >= 1.)
+    {
+    return m_Maximum;
+    }
+  if (!m_Buffer.empty())
+    {
+    Self compressed(*this);
+    compressed.Compress();
+    return compressed.GetQuantile(q);
+    }
+
+  // Each centroid is located at the middle of its cumulated weight range,
+  // the minimum and maximum bound the first and last halves.
+  const double target = q * m_Count;
+  double previousMean = m_Minimum;
+  double previousPosition = 0.;
+  double cumulated = 0.;
+  for (typename CentroidVectorType::const_iterator it = m_Centroids.begin(); it != m_Centroids.end(); ++it)
+    {
+    const double position = cumulated + it->m_Weight / 2.;
+    if (target < position)
+      {
+      const double ratio = (target - previousPosition) / (position - previousPosition);
+      return static_cast<RealType>(previousMean + ratio * (it->m_Mean - previousMean));
+      }
+    previousMean = it->m_Mean;
+    previousPosition = position;
+    cumulated += it->m_Weight;
+    }
+  if (m_Count <= previousPosition)
+    {
+    return m_Maximum;
+    }
+  const double ratio = (target - previousPosition) / (m_Count - previousPosition);
+  return static_cast<RealType>(previousMean + ratio * (m_Maximum - previousMean));
+}
+
+} // end namespace otb
+
+#endif
@@ -27,13 +27,195 @@
 #include "itkArray.h"
 #include "itkSimpleDataObjectDecorator.h"
 #include "otbPersistentFilterStreamingDecorator.h"
+#include "otbQuantileSketch.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
 
 
 namespace otb
 {
 
+/** \class LabelStatisticsAccumulator
+ * \brief Flat per-label accumulator of count, sum, sum of squares, min, max and quantile sketches
+ *
+ * Each label seen is given a slot, and the statistics of all bands are
+ * stored contiguously in flat arrays indexed by slot * nbBands + band.
+ * Only a change of label between two consecutive pixels costs a hash
+ * lookup, which makes the accumulation cheap on segmentation label
+ * images where labels come in runs.
+ *
+ * \sa PersistentStreamingStatisticsMapFromLabelImageFilter
+ *
+ * \ingroup OTBStatistics
+ */
+template <class TLabel>
+class LabelStatisticsAccumulator
+{
+public:
+  typedef LabelStatisticsAccumulator Self;
+  typedef TLabel                     LabelType;
+  typedef QuantileSketch<double>     SketchType;
+  typedef std::size_t                SlotType;
+
+  LabelStatisticsAccumulator(unsigned int nbBands = 0, bool computeQuantiles = false, double compression = 200.)
+    : m_NumberOfBands(nbBands), m_ComputeQuantiles(computeQuantiles), m_Compression(compression),
+      m_LastLabel(), m_LastSlot(0), m_HasLastLabel(false)
+  {}
+
+  unsigned int GetNumberOfBands() const
+  {
+    return m_NumberOfBands;
+  }
+
+  bool GetComputeQuantiles() const
+  {
+    return m_ComputeQuantiles;
+  }
+
+  /** Return the slot of a label, creating it if the label has not been seen yet */
+  SlotType GetSlot(LabelType label)
+  {
+    if (m_HasLastLabel && label == m_LastLabel)
+      {
+      return m_LastSlot;
+      }
+    typename SlotMapType::const_iterator it = m_Slots.find(label);
+    SlotType slot;
+    if (it == m_Slots.end())
+      {
+      slot = m_Labels.size();
+      m_Slots.insert(std::make_pair(label, slot));
+      m_Labels.push_back(label);
+      m_Counts.push_back(0);
+      m_Sums.resize(m_Sums.size() + m_NumberOfBands, 0.);
+      m_SquaredSums.resize(m_SquaredSums.size() + m_NumberOfBands, 0.);
+      m_Minima.resize(m_Minima.size() + m_NumberOfBands, itk::NumericTraits<double>::max());
+      m_Maxima.resize(m_Maxima.size() + m_NumberOfBands, itk::NumericTraits<double>::NonpositiveMin());
+      if (m_ComputeQuantiles)
+        {
+        m_Sketches.resize(m_Sketches.size() + m_NumberOfBands, SketchType(m_Compression));
+        }
+      }
+    else
+      {
+      slot = it->second;
+      }
+    m_LastLabel = label;
+    m_LastSlot = slot;
+    m_HasLastLabel = true;
+    return slot;
+  }
+
+  /** Count one more pixel in a slot */
+  void AddPixel(SlotType slot)
+  {
+    ++m_Counts[slot];
+  }
+
+  /** Add the value of one band of a pixel in a slot */
+  void AddValue(SlotType slot, unsigned int band, double value)
+  {
+    const SlotType idx = slot * m_NumberOfBands + band;
+    m_Sums[idx] += value;
+    m_SquaredSums[idx] += value * value;
+    if (value < m_Minima[idx])
+      {
+      m_Minima[idx] = value;
+      }
+    if (value > m_Maxima[idx])
+      {
+      m_Maxima[idx] = value;
+      }
+    if (m_ComputeQuantiles)
+      {
+      m_Sketches[idx].Add(value);
+      }
+  }
+
+  /** Merge the statistics of another accumulator with the same number of bands */
+  void Merge(const Self & other);
+
+  /** Flush the values buffered in the quantile sketches */
+  void CompressSketches()
+  {
+    for (std::vector<SketchType>::iterator it = m_Sketches.begin(); it != m_Sketches.end(); ++it)
+      {
+      it->Compress();
+      }
+  }
+
+  SlotType GetNumberOfLabels() const
+  {
+    return m_Labels.size();
+  }
+
+  LabelType GetLabel(SlotType slot) const
+  {
+    return m_Labels[slot];
+  }
+
+  double GetCount(SlotType slot) const
+  {
+    return static_cast<double>(m_Counts[slot]);
+  }
+
+  double GetSum(SlotType slot, unsigned int band) const
+  {
+    return m_Sums[slot * m_NumberOfBands + band];
+  }
+
+  double GetSquaredSum(SlotType slot, unsigned int band) const
+  {
+    return m_SquaredSums[slot * m_NumberOfBands + band];
+  }
+
+  double GetMinimum(SlotType slot, unsigned int band) const
+  {
+    return m_Minima[slot * m_NumberOfBands + band];
+  }
+
+  double GetMaximum(SlotType slot, unsigned int band) const
+  {
+    return m_Maxima[slot * m_NumberOfBands + band];
+  }
+
+  /** Quantile sketch of a band in a slot, only valid if quantiles are computed */
+  const SketchType & GetSketch(SlotType slot, unsigned int band) const
+  {
+    return m_Sketches[slot * m_NumberOfBands + band];
+  }
+
+private:
+  typedef std::unordered_map<LabelType, SlotType> SlotMapType;
+
+  unsigned int                    m_NumberOfBands;
+  bool                            m_ComputeQuantiles;
+  double                          m_Compression;
+  SlotMapType                     m_Slots;
+  std::vector<LabelType>          m_Labels;
+  std::vector<itk::SizeValueType> m_Counts;
+  std::vector<double>             m_Sums;
+  std::vector<double>             m_SquaredSums;
+  std::vector<double>             m_Minima;
+  std::vector<double>             m_Maxima;
+  std::vector<SketchType>         m_Sketches;
+  LabelType                       m_LastLabel;
+  SlotType                        m_LastSlot;
+  bool                            m_HasLastLabel;
+};
+
 /** \class PersistentStreamingStatisticsMapFromLabelImageFilter
- * \brief Computes mean radiometric value for each label of a label image, based on a support VectorImage
+ * \brief Computes radiometric statistics for each label of a label image, based on a support VectorImage
+ *
+ * For each label and each band of the support image, the filter computes
+ * the pixel count, the minimum, the maximum, the mean and the standard
+ * deviation (biased estimator). If ComputeQuantiles is on, a
+ * QuantileSketch is also accumulated per label and band, and approximate
+ * quantiles can be retrieved with GetQuantileValueMap().
+ *
+ * Statistics are accumulated per thread in a LabelStatisticsAccumulator
+ * and merged in Synthetize().
  *
  * This filter persists its temporary data. It means that if you Update it n times on n different
  * requested regions, the output statistics will be the statitics of the whole set of n regions.
@@ -42,8 +224,6 @@ namespace otb
  *
  * To get the statistics once the regions have been processed via the pipeline, use the Synthetize() method.
  *
- * \todo Implement other statistics (min, max, stddev...)
- *
  * \sa StreamingStatisticsMapFromLabelImageFilter
  * \ingroup Streamed
  * \ingroup Multithreaded
@@ -76,8 +256,11 @@ public:
 
   typedef typename VectorImageType::PixelType                           VectorPixelType;
   typedef typename LabelImageType::PixelType                            LabelPixelType;
-  typedef std::map<LabelPixelType, itk::VariableLengthVector<double> >  MeanValueMapType;
+  typedef itk::VariableLengthVector<double>                             RealVectorPixelType;
+  typedef std::map<LabelPixelType, RealVectorPixelType>                 PixelValueMapType;
+  typedef PixelValueMapType                                             MeanValueMapType;
   typedef std::map<LabelPixelType, double>                              LabelPopulationMapType;
+  typedef LabelStatisticsAccumulator<LabelPixelType>                    AccumulatorType;
 
   itkStaticConstMacro(InputImageDimension, unsigned int,
                       TInputVectorImage::ImageDimension);
@@ -105,9 +288,31 @@ public:
   /** Return the computed Mean for each label in the input label image */
   MeanValueMapType GetMeanValueMap() const;
 
+  /** Return the computed standard deviation for each label in the input label image */
+  PixelValueMapType GetStandardDeviationValueMap() const;
+
+  /** Return the computed minimum for each label in the input label image */
+  PixelValueMapType GetMinValueMap() const;
+
+  /** Return the computed maximum for each label in the input label image */
+  PixelValueMapType GetMaxValueMap() const;
+
+  /** Return the approximate quantile q (in [0,1]) for each label in the
+   * input label image. Requires ComputeQuantiles to be on. */
+  PixelValueMapType GetQuantileValueMap(double q) const;
+
   /** Return the computed number of labeled pixels for each label in the input label image */
   LabelPopulationMapType GetLabelPopulationMap() const;
 
+  /** Set/Get whether quantile sketches are accumulated (off by default) */
+  itkSetMacro(ComputeQuantiles, bool);
+  itkGetMacro(ComputeQuantiles, bool);
+  itkBooleanMacro(ComputeQuantiles);
+
+  /** Set/Get the compression of the quantile sketches (see QuantileSketch) */
+  itkSetMacro(QuantileCompression, double);
+  itkGetMacro(QuantileCompression, double);
+
   /** Make a DataObject of the correct type to be used as the specified
    * output. */
   DataObjectPointer MakeOutput(DataObjectPointerArraySizeType idx) ITK_OVERRIDE;
@@ -133,14 +338,24 @@ protected:
   ~PersistentStreamingStatisticsMapFromLabelImageFilter() ITK_OVERRIDE {}
   void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
 
-  /** GenerateData. */
-  void  GenerateData() ITK_OVERRIDE;
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Multi-thread version GenerateData. */
+  void ThreadedGenerateData(const InputImageRegionType& outputRegionForThread,
+                            itk::ThreadIdType threadId) ITK_OVERRIDE;
 
 private:
   PersistentStreamingStatisticsMapFromLabelImageFilter(const Self &); //purposely not implemented
   void operator =(const Self&); //purposely not implemented
 
-  MeanValueMapType                       m_RadiometricValueAccumulator;
+  bool                                   m_ComputeQuantiles;
+  double                                 m_QuantileCompression;
+  std::vector<AccumulatorType>           m_ThreadAccumulators;
+  AccumulatorType                        m_Accumulator;
+  MeanValueMapType                       m_MeanValueMap;
+  PixelValueMapType                      m_StandardDeviationValueMap;
+  PixelValueMapType                      m_MinValueMap;
+  PixelValueMapType                      m_MaxValueMap;
   LabelPopulationMapType                 m_LabelPopulation;
 }; // end of class PersistentStreamingStatisticsMapFromLabelImageFilter
 
@@ -148,9 +363,10 @@ private:
 /*===========================================================================*/
 
 /** \class StreamingStatisticsMapFromLabelImageFilter
- * \brief Computes mean radiometric value for each label of a label image, based on a support VectorImage
+ * \brief Computes radiometric statistics for each label of a label image, based on a support VectorImage
  *
- * Currently the class only computes the mean value.
+ * The class computes the pixel count, minimum, maximum, mean, standard
+ * deviation and optionally approximate quantiles of each band for each label.
  *
  * This class streams the whole input image through the PersistentStreamingStatisticsMapFromLabelImageFilter.
  *
@@ -176,9 +392,6 @@ private:
  * }
  * \endcode
  *
- * \todo Implement other statistics (min, max, stddev...)
- * \todo Reimplement as a multi-threaded filter
- *
  * \sa PersistentStatisticsImageFilter
  * \sa PersistentImageFilter
  * \sa PersistentFilterStreamingDecorator
@@ -213,6 +426,7 @@ public:
   typedef TLabelImage                         LabelImageType;
 
   typedef typename Superclass::FilterType::MeanValueMapType          MeanValueMapType;
+  typedef typename Superclass::FilterType::PixelValueMapType         PixelValueMapType;
   typedef typename Superclass::FilterType::MeanValueMapObjectType    MeanValueMapObjectType;
 
   typedef typename Superclass::FilterType::LabelPopulationMapType    LabelPopulationMapType;
@@ -248,12 +462,43 @@ public:
     return this->GetFilter()->GetMeanValueMap();
   }
 
+  /** Return the computed standard deviation for each label */
+  PixelValueMapType GetStandardDeviationValueMap() const
+  {
+    return this->GetFilter()->GetStandardDeviationValueMap();
+  }
+
+  /** Return the computed minimum for each label */
+  PixelValueMapType GetMinValueMap() const
+  {
+    return this->GetFilter()->GetMinValueMap();
+  }
+
+  /** Return the computed maximum for each label */
+  PixelValueMapType GetMaxValueMap() const
+  {
+    return this->GetFilter()->GetMaxValueMap();
+  }
+
+  /** Return the approximate quantile q for each label */
+  PixelValueMapType GetQuantileValueMap(double q) const
+  {
+    return this->GetFilter()->GetQuantileValueMap(q);
+  }
+
   /** Return the computed number of labeled pixels for each label */
   LabelPopulationMapType GetLabelPopulationMap() const
   {
     return this->GetFilter()->GetLabelPopulationMap();
   }
 
+  otbSetObjectMemberMacro(Filter, ComputeQuantiles, bool);
+  otbGetObjectMemberMacro(Filter, ComputeQuantiles, bool);
+  itkBooleanMacro(ComputeQuantiles);
+
+  otbSetObjectMemberMacro(Filter, QuantileCompression, double);
+  otbGetObjectMemberMacro(Filter, QuantileCompression, double);
+
 protected:
   /** Constructor */
   StreamingStatisticsMapFromLabelImageFilter() {}
@@ -26,15 +26,45 @@
 #include "itkInputDataObjectIterator.h"
 #include "itkImageRegionIterator.h"
 #include "itkProgressReporter.h"
+#include "itkDefaultConvertPixelTraits.h"
 #include "otbMacro.h"
 
+#include <algorithm>
+
 
 namespace otb
 {
 
+template <class TLabel>
+void
+LabelStatisticsAccumulator<TLabel>
+::Merge(const Self & other)
+{
+  for (SlotType otherSlot = 0; otherSlot < other.GetNumberOfLabels(); ++otherSlot)
+    {
+    const SlotType slot = this->GetSlot(other.m_Labels[otherSlot]);
+    m_Counts[slot] += other.m_Counts[otherSlot];
+    for (unsigned int band = 0; band < m_NumberOfBands; ++band)
+      {
+      const SlotType idx = slot * m_NumberOfBands + band;
+      const SlotType otherIdx = otherSlot * m_NumberOfBands + band;
+      m_Sums[idx] += other.m_Sums[otherIdx];
+      m_SquaredSums[idx] += other.m_SquaredSums[otherIdx];
+      m_Minima[idx] = std::min(m_Minima[idx], other.m_Minima[otherIdx]);
+      m_Maxima[idx] = std::max(m_Maxima[idx], other.m_Maxima[otherIdx]);
+      if (m_ComputeQuantiles && other.m_ComputeQuantiles)
+        {
+        m_Sketches[idx].Merge(other.m_Sketches[otherIdx]);
+        }
+      }
+    }
+}
+
 template<class TInputVectorImage, class TLabelImage>
 PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>
 ::PersistentStreamingStatisticsMapFromLabelImageFilter()
+  : m_ComputeQuantiles(false),
+    m_QuantileCompression(200.)
 {
   // first output is a copy of the image, DataObject created by
   // superclass
@@ -94,7 +124,55 @@ typename PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage,
 PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>
 ::GetMeanValueMap() const
 {
-  return m_RadiometricValueAccumulator;
+  return m_MeanValueMap;
+}
+
+template<class TInputVectorImage, class TLabelImage>
+typename PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>::PixelValueMapType
+PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>
+::GetStandardDeviationValueMap() const
+{
+  return m_StandardDeviationValueMap;
+}
+
+template<class TInputVectorImage, class TLabelImage>
+typename PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>::PixelValueMapType
+PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>
+::GetMinValueMap() const
+{
+  return m_MinValueMap;
+}
+
+template<class TInputVectorImage, class TLabelImage>
+typename PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>::PixelValueMapType
+PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>
+::GetMaxValueMap() const
+{
+  return m_MaxValueMap;
+}
+
+template<class TInputVectorImage, class TLabelImage>
+typename PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>::PixelValueMapType
+PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>
+::GetQuantileValueMap(double q) const
+{
+  if (!m_Accumulator.GetComputeQuantiles())
+    {
+    itkExceptionMacro(<< "Quantiles were not computed, ComputeQuantiles must be on before the update.");
+    }
+
+  const unsigned int nbBands = m_Accumulator.GetNumberOfBands();
+  PixelValueMapType quantiles;
+  for (typename AccumulatorType::SlotType slot = 0; slot < m_Accumulator.GetNumberOfLabels(); ++slot)
+    {
+    RealVectorPixelType value(nbBands);
+    for (unsigned int band = 0; band < nbBands; ++band)
+      {
+      value[band] = m_Accumulator.GetSketch(slot, band).GetQuantile(q);
+      }
+    quantiles[m_Accumulator.GetLabel(slot)] = value;
+    }
+  return quantiles;
 }
 
 template<class TInputVectorImage, class TLabelImage>
@@ -141,11 +219,46 @@ void
 PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>
 ::Synthetize()
 {
-   typename MeanValueMapType::iterator it;
-   for(it = m_RadiometricValueAccumulator.begin(); it != m_RadiometricValueAccumulator.end(); it++)
-   {
-      it->second = it->second / m_LabelPopulation[it->first];
-   }
+  if (m_ThreadAccumulators.empty())
+    {
+    return;
+    }
+
+  m_Accumulator = m_ThreadAccumulators[0];
+  for (unsigned int i = 1; i < m_ThreadAccumulators.size(); ++i)
+    {
+    m_Accumulator.Merge(m_ThreadAccumulators[i]);
+    }
+  m_ThreadAccumulators.clear();
+  m_Accumulator.CompressSketches();
+
+  const unsigned int nbBands = m_Accumulator.GetNumberOfBands();
+  for (typename AccumulatorType::SlotType slot = 0; slot < m_Accumulator.GetNumberOfLabels(); ++slot)
+    {
+    const LabelPixelType label = m_Accumulator.GetLabel(slot);
+    const double count = m_Accumulator.GetCount(slot);
+    if (count == 0.)
+      {
+      continue;
+      }
+
+    RealVectorPixelType mean(nbBands), stdDev(nbBands), min(nbBands), max(nbBands);
+    for (unsigned int band = 0; band < nbBands; ++band)
+      {
+      mean[band] = m_Accumulator.GetSum(slot, band) / count;
+      const double variance = m_Accumulator.GetSquaredSum(slot, band) / count - mean[band] * mean[band];
+      stdDev[band] = variance > 0. ? vcl_sqrt(variance) : 0.;
+      min[band] = m_Accumulator.GetMinimum(slot, band);
+      max[band] = m_Accumulator.GetMaximum(slot, band);
+      }
+    m_LabelPopulation[label] = count;
+    m_MeanValueMap[label] = mean;
+    m_StandardDeviationValueMap[label] = stdDev;
+    m_MinValueMap[label] = min;
+    m_MaxValueMap[label] = max;
+    }
+
+  static_cast<MeanValueMapObjectType*>(this->itk::ProcessObject::GetOutput(1))->Set(m_MeanValueMap);
 }
 
 template<class TInputVectorImage, class TLabelImage>
@@ -153,7 +266,13 @@ void
 PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>
 ::Reset()
 {
-  m_RadiometricValueAccumulator.clear();
+  m_ThreadAccumulators.clear();
+  m_Accumulator = AccumulatorType();
+  m_MeanValueMap.clear();
+  m_StandardDeviationValueMap.clear();
+  m_MinValueMap.clear();
+  m_MaxValueMap.clear();
+  m_LabelPopulation.clear();
 }
 
 template<class TInputVectorImage, class TLabelImage>
@@ -189,41 +308,55 @@ PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelIm
 template<class TInputVectorImage, class TLabelImage>
 void
 PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>
-::GenerateData()
+::BeforeThreadedGenerateData()
+{
+  // Accumulators persist across the streamed regions, they are only
+  // created for the first one.
+  const unsigned int numberOfThreads = this->GetNumberOfThreads();
+  if (m_ThreadAccumulators.size() < numberOfThreads)
+    {
+    m_ThreadAccumulators.resize(numberOfThreads,
+                                AccumulatorType(this->GetInput()->GetNumberOfComponentsPerPixel(),
+                                                m_ComputeQuantiles,
+                                                m_QuantileCompression));
+    }
+}
+
+template<class TInputVectorImage, class TLabelImage>
+void
+PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelImage>
+::ThreadedGenerateData(const InputImageRegionType& outputRegionForThread, itk::ThreadIdType threadId)
 {
+  // Support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
+
   /**
    * Grab the input
    */
   InputVectorImagePointer inputPtr =  const_cast<TInputVectorImage *>(this->GetInput());
   LabelImagePointer labelInputPtr =  const_cast<TLabelImage *>(this->GetInputLabelImage());
 
-  itk::ImageRegionConstIterator<TInputVectorImage> inIt(inputPtr, inputPtr->GetRequestedRegion());
-  itk::ImageRegionConstIterator<TLabelImage> labelIt(labelInputPtr, labelInputPtr->GetRequestedRegion());
+  itk::ImageRegionConstIterator<TInputVectorImage> inIt(inputPtr, outputRegionForThread);
+  itk::ImageRegionConstIterator<TLabelImage> labelIt(labelInputPtr, outputRegionForThread);
 
-  itk::VariableLengthVector<double> zeroValue(inputPtr->GetNumberOfComponentsPerPixel());
-  zeroValue.Fill(0.0);
+  AccumulatorType & accumulator = m_ThreadAccumulators[threadId];
+  const unsigned int nbBands = accumulator.GetNumberOfBands();
 
-  typename VectorImageType::PixelType value;
-  typename LabelImageType::PixelType label;
   // do the work
   for (inIt.GoToBegin(), labelIt.GoToBegin();
        !inIt.IsAtEnd() && !labelIt.IsAtEnd();
-       ++inIt, ++labelIt)
+       ++inIt, ++labelIt, progress.CompletedPixel())
     {
-      value = inIt.Get();
-      label = labelIt.Get();
-      if (m_RadiometricValueAccumulator.count(label)<=0) //add new element to the map
-      {
-        // use a zero pixel with the right number of components to support scalar images
-        m_RadiometricValueAccumulator[label] = (zeroValue + value);
-        m_LabelPopulation[label] = 1;
-      }
-      else
+    const typename AccumulatorType::SlotType slot = accumulator.GetSlot(labelIt.Get());
+    accumulator.AddPixel(slot);
+
+    // the pixel traits allow supporting scalar images as well
+    const VectorPixelType & value = inIt.Get();
+    for (unsigned int band = 0; band < nbBands; ++band)
       {
-        m_RadiometricValueAccumulator[label] += value;
-        m_LabelPopulation[label] ++;
+      accumulator.AddValue(slot, band,
+                           static_cast<double>(itk::DefaultConvertPixelTraits<VectorPixelType>::GetNthComponent(band, value)));
       }
-
     }
 }
 
@@ -233,6 +366,10 @@ PersistentStreamingStatisticsMapFromLabelImageFilter<TInputVectorImage, TLabelIm
 ::PrintSelf(std::ostream& os, itk::Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+
+  os << indent << "ComputeQuantiles: " << m_ComputeQuantiles << std::endl;
+  os << indent << "QuantileCompression: " << m_QuantileCompression << std::endl;
+  os << indent << "Number of labels: " << m_LabelPopulation.size() << std::endl;
 }
 
 } // end namespace otb
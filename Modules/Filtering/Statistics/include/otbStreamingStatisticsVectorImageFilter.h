@@ -28,6 +28,7 @@
 #include "itkImageRegionSplitter.h"
 #include "itkVariableSizeMatrix.h"
 #include "itkVariableLengthVector.h"
+#include "otbQuantileSketch.h"
 
 namespace otb
 {
@@ -42,6 +43,11 @@ namespace otb
  *
  * To get the statistics once the regions have been processed via the pipeline, use the Synthetize() method.
  *
+ * If EnableQuantiles is on, a QuantileSketch is accumulated per band and
+ * per thread, and merged in Synthetize(). Approximate quantiles of each
+ * band are then available through GetQuantile(), without a second pass
+ * over the image and with a memory footprint independent of its size.
+ *
  * \sa PersistentImageFilter
  * \ingroup Streamed
  * \ingroup Multithreaded
@@ -90,6 +96,8 @@ public:
   typedef itk::VariableSizeMatrix<PrecisionType>        MatrixType;
   typedef itk::VariableLengthVector<PrecisionType>      RealPixelType;
   typedef itk::VariableLengthVector<unsigned long>      CountType;
+  typedef QuantileSketch<PrecisionType>                 QuantileSketchType;
+  typedef std::vector<QuantileSketchType>               QuantileSketchVectorType;
 
   /** Type of DataObjects used for outputs */
   typedef itk::SimpleDataObjectDecorator<RealType>      RealObjectType;
@@ -182,6 +190,18 @@ public:
   MatrixObjectType* GetCovarianceOutput();
   const MatrixObjectType* GetCovarianceOutput() const;
 
+  /** Return the approximate quantile q (in [0,1]) of each band.
+   * Requires EnableQuantiles to be on. If only quantiles are enabled,
+   * the update does not throw when no pixel is relevant: check
+   * GetNbRelevantPixels() before reading the quantiles. */
+  RealPixelType GetQuantile(double q) const;
+
+  /** Return the merged quantile sketch of a band */
+  const QuantileSketchType & GetQuantileSketch(unsigned int band) const
+  {
+    return m_QuantileSketches[band];
+  }
+
   /** Make a DataObject of the correct type to be used as the specified
    * output.
    */
@@ -213,6 +233,12 @@ public:
   itkSetMacro(UseUnbiasedEstimator, bool);
   itkGetMacro(UseUnbiasedEstimator, bool);
 
+  itkSetMacro(EnableQuantiles, bool);
+  itkGetMacro(EnableQuantiles, bool);
+
+  itkSetMacro(QuantileCompression, double);
+  itkGetMacro(QuantileCompression, double);
+
 protected:
   PersistentStreamingStatisticsVectorImageFilter();
 
@@ -237,7 +263,10 @@ private:
   bool m_EnableMinMax;
   bool m_EnableFirstOrderStats;
   bool m_EnableSecondOrderStats;
+  bool m_EnableQuantiles;
 
+  /* compression of the quantile sketches */
+  double m_QuantileCompression;
 
   /* use an unbiased estimator to compute the covariance */
   bool m_UseUnbiasedEstimator;
@@ -248,6 +277,8 @@ private:
   std::vector<RealType>      m_ThreadSecondOrderComponentAccumulators;
   std::vector<RealPixelType> m_ThreadFirstOrderAccumulators;
   std::vector<MatrixType>    m_ThreadSecondOrderAccumulators;
+  std::vector<QuantileSketchVectorType> m_ThreadQuantileSketches;
+  QuantileSketchVectorType   m_QuantileSketches;
 
   /* Ignored values */
   bool m_IgnoreInfiniteValues;
@@ -270,6 +301,7 @@ private:
  * internal PersistentStreamingStatisticsVectorImageFilter.
  * By default infinite values are ignored, use IgnoreInfiniteValues accessor to consider
  * infinite values in the computation.
+ * Approximate per-band quantiles are computed in the same pass when EnableQuantiles is on.
  *
  * \sa PersistentStreamingStatisticsVectorImageFilter
  * \sa PersistentImageFilter
@@ -425,6 +457,12 @@ public:
     return this->GetFilter()->GetCorrelationOutput();
   }
 
+  /** Return the approximate quantile q (in [0,1]) of each band. */
+  RealPixelType GetQuantile(double q) const
+  {
+    return this->GetFilter()->GetQuantile(q);
+  }
+
   /** Return the computed Mean. */
   RealType GetComponentMean() const
   {
@@ -488,6 +526,12 @@ public:
   otbSetObjectMemberMacro(Filter, UseUnbiasedEstimator, bool);
   otbGetObjectMemberMacro(Filter, UseUnbiasedEstimator, bool);
 
+  otbSetObjectMemberMacro(Filter, EnableQuantiles, bool);
+  otbGetObjectMemberMacro(Filter, EnableQuantiles, bool);
+
+  otbSetObjectMemberMacro(Filter, QuantileCompression, double);
+  otbGetObjectMemberMacro(Filter, QuantileCompression, double);
+
 protected:
   /** Constructor */
   StreamingStatisticsVectorImageFilter() {}
@@ -36,6 +36,8 @@ PersistentStreamingStatisticsVectorImageFilter<TInputImage, TPrecision>
  : m_EnableMinMax(true),
    m_EnableFirstOrderStats(true),
    m_EnableSecondOrderStats(true),
+   m_EnableQuantiles(false),
+   m_QuantileCompression(200.),
    m_UseUnbiasedEstimator(true),
    m_IgnoreInfiniteValues(true),
    m_IgnoreUserDefinedValue(false),
@@ -356,6 +358,13 @@ PersistentStreamingStatisticsVectorImageFilter<TInputImage, TPrecision>
     std::fill(m_ThreadSecondOrderComponentAccumulators.begin(), m_ThreadSecondOrderComponentAccumulators.end(), zeroReal);
     }
 
+  m_QuantileSketches.clear();
+  if (m_EnableQuantiles)
+    {
+    m_ThreadQuantileSketches.assign(numberOfThreads,
+                                    QuantileSketchVectorType(numberOfComponent, QuantileSketchType(m_QuantileCompression)));
+    }
+
   if (m_IgnoreInfiniteValues)
     {
       m_IgnoredInfinitePixelCount= std::vector<unsigned int>(numberOfThreads, 0);
@@ -427,12 +436,33 @@ PersistentStreamingStatisticsVectorImageFilter<TInputImage, TPrecision>
       streamSecondOrderAccumulator += m_ThreadSecondOrderAccumulators[threadId];
       streamSecondOrderComponentAccumulator += m_ThreadSecondOrderComponentAccumulators[threadId];
       }
+    if (m_EnableQuantiles)
+      {
+      if (threadId == 0)
+        {
+        m_QuantileSketches.swap(m_ThreadQuantileSketches[0]);
+        }
+      else
+        {
+        for (unsigned int j = 0; j < numberOfComponent; ++j)
+          {
+          m_QuantileSketches[j].Merge(m_ThreadQuantileSketches[threadId][j]);
+          }
+        }
+      }
+
     // Ignored Infinite Pixels
     ignoredInfinitePixelCount += m_IgnoredInfinitePixelCount[threadId];
     // Ignored Pixels
     ignoredUserPixelCount += m_IgnoredUserPixelCount[threadId];
     }
 
+  // Flush the sketches so that GetQuantile() only reads them
+  for (unsigned int j = 0; j < m_QuantileSketches.size(); ++j)
+    {
+    m_QuantileSketches[j].Compress();
+    }
+
   // There cannot be more ignored pixels than read pixels.
   assert( nbPixels >= ignoredInfinitePixelCount + ignoredUserPixelCount );
   if( nbPixels < ignoredInfinitePixelCount + ignoredUserPixelCount )
@@ -450,7 +480,10 @@ PersistentStreamingStatisticsVectorImageFilter<TInputImage, TPrecision>
 
   this->GetNbRelevantPixelsOutput()->Set(nbRelevantPixels);
 
-  if( nbRelevantPixel==0 )
+  // Quantiles alone do not need any relevant pixel: the sketches stay
+  // empty and the caller checks the NbRelevantPixels output
+  if( nbRelevantPixel==0
+      && (m_EnableMinMax || m_EnableFirstOrderStats || m_EnableSecondOrderStats) )
     {
     itkExceptionMacro(
       "Statistics cannot be calculated with zero relevant pixels."
@@ -514,6 +547,24 @@ PersistentStreamingStatisticsVectorImageFilter<TInputImage, TPrecision>
     }
 }
 
+template<class TInputImage, class TPrecision>
+typename PersistentStreamingStatisticsVectorImageFilter<TInputImage, TPrecision>::RealPixelType
+PersistentStreamingStatisticsVectorImageFilter<TInputImage, TPrecision>
+::GetQuantile(double q) const
+{
+  if (!m_EnableQuantiles || m_QuantileSketches.empty())
+    {
+    itkExceptionMacro(<< "Quantiles are not available, EnableQuantiles must be on before the update.");
+    }
+
+  RealPixelType quantile(m_QuantileSketches.size());
+  for (unsigned int j = 0; j < m_QuantileSketches.size(); ++j)
+    {
+    quantile[j] = m_QuantileSketches[j].GetQuantile(q);
+    }
+  return quantile;
+}
+
 template<class TInputImage, class TPrecision>
 void
 PersistentStreamingStatisticsVectorImageFilter<TInputImage, TPrecision>
@@ -582,6 +633,15 @@ PersistentStreamingStatisticsVectorImageFilter<TInputImage, TPrecision>
             }
           }
 
+        if (m_EnableQuantiles)
+          {
+          QuantileSketchVectorType& threadSketches = m_ThreadQuantileSketches[threadId];
+          for (unsigned int j = 0; j < vectorValue.GetSize(); ++j)
+            {
+            threadSketches[j].Add(vectorValue[j]);
+            }
+          }
+
         if (m_EnableSecondOrderStats)
           {
           MatrixType&    threadSecondOrder = m_ThreadSecondOrderAccumulators[threadId];
@@ -619,6 +679,8 @@ PersistentStreamingStatisticsVectorImageFilter<TImage, TPrecision>
   os << indent << "Component Covariance: "  << this->GetComponentCovarianceOutput()->Get()  << std::endl;
   os << indent << "Component Correlation: " << this->GetComponentCorrelationOutput()->Get() << std::endl;
   os << indent << "UseUnbiasedEstimator: "  << (this->m_UseUnbiasedEstimator ? "true" : "false")  << std::endl;
+  os << indent << "EnableQuantiles: "       << (this->m_EnableQuantiles ? "true" : "false")  << std::endl;
+  os << indent << "QuantileCompression: "   << this->m_QuantileCompression  << std::endl;
 }
 
 } // end namespace otb
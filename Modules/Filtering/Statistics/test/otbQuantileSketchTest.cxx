@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbQuantileSketch.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <algorithm>
+#include <vector>
+#include <iostream>
+
+int otbQuantileSketchTest(int itkNotUsed(argc), char * itkNotUsed(argv) [])
+{
+  typedef otb::QuantileSketch<double>                             SketchType;
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(12345);
+
+  // Skewed distribution, split between two sketches as two threads would do
+  const unsigned int nbValues = 200000;
+  std::vector<double> values(nbValues);
+  SketchType first, second;
+  for (unsigned int i = 0; i < nbValues; ++i)
+    {
+    const double value = vcl_exp(generator->GetNormalVariate(0., 1.));
+    values[i] = value;
+    if (i % 3 == 0)
+      {
+      first.Add(value);
+      }
+    else
+      {
+      second.Add(value);
+      }
+    }
+  SketchType merged;
+  merged.Merge(first);
+  merged.Merge(second);
+  std::sort(values.begin(), values.end());
+
+  if (merged.GetCount() != nbValues || merged.GetMinimum() != values.front() || merged.GetMaximum() != values.back())
+    {
+    std::cerr << "Wrong count or extrema" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Compare to the exact quantiles in terms of rank
+  const double quantiles[] = {0.001, 0.02, 0.1, 0.25, 0.5, 0.75, 0.9, 0.98, 0.999};
+  for (unsigned int i = 0; i < sizeof(quantiles) / sizeof(double); ++i)
+    {
+    const double estimate = merged.GetQuantile(quantiles[i]);
+    const double rank = static_cast<double>(std::lower_bound(values.begin(), values.end(), estimate) - values.begin())
+      / nbValues;
+    std::cout << "Quantile " << quantiles[i] << ": " << estimate << " (rank " << rank << ")" << std::endl;
+    if (vcl_abs(rank - quantiles[i]) > 0.005)
+      {
+      std::cerr << "Quantile " << quantiles[i] << " estimated at rank " << rank << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Estimates must not depend on whether the buffer was flushed
+  std::vector<double> buffered;
+  for (unsigned int i = 0; i < sizeof(quantiles) / sizeof(double); ++i)
+    {
+    buffered.push_back(merged.GetQuantile(quantiles[i]));
+    }
+  merged.Compress();
+  for (unsigned int i = 0; i < sizeof(quantiles) / sizeof(double); ++i)
+    {
+    if (merged.GetQuantile(quantiles[i]) != buffered[i])
+      {
+      std::cerr << "Quantile " << quantiles[i] << " changed after Compress()" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  if (merged.GetNumberOfCentroids() > 2 * merged.GetCompression())
+    {
+    std::cerr << "Too many centroids: " << merged.GetNumberOfCentroids() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A few values are kept exactly
+  SketchType small;
+  for (unsigned int i = 1; i <= 5; ++i)
+    {
+    small.Add(i);
+    }
+  if (small.GetQuantile(0.5) != 3. || small.GetQuantile(0.) != 1. || small.GetQuantile(1.) != 5.)
+    {
+    std::cerr << "Wrong quantiles on a small sample" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -62,6 +62,7 @@ void RegisterTests()
   REGISTER_TEST(otbListSampleToBalancedListSampleFilterNew);
   REGISTER_TEST(otbListSampleToBalancedListSampleFilter);
   REGISTER_TEST(otbStreamingStatisticsVectorImageFilter);
+  REGISTER_TEST(otbStreamingStatisticsVectorImageFilterQuantiles);
   REGISTER_TEST(otbStreamingMinMaxVectorImageFilter);
   REGISTER_TEST(otbListSampleGeneratorNew);
   REGISTER_TEST(otbListSampleGenerator);
@@ -71,4 +72,6 @@ void RegisterTests()
   REGISTER_TEST(otbPeriodicSamplerTest);
   REGISTER_TEST(otbPatternSamplerTest);
   REGISTER_TEST(otbRandomSamplerTest);
+  REGISTER_TEST(otbQuantileSketchTest);
+  REGISTER_TEST(otbStreamingStatisticsMapFromLabelImageFilterQuantiles);
 }
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbVectorImage.h"
+#include "otbImage.h"
+#include "otbImageFileReader.h"
+#include "otbStreamingStatisticsMapFromLabelImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <iostream>
+
+// Compute the label quantiles with several stream divisions, and check
+// their rank against the exact distribution of each label and band
+int otbStreamingStatisticsMapFromLabelImageFilterQuantiles(int itkNotUsed(argc), char * argv[])
+{
+  const char *       inputFilename = argv[1];
+  const char *       labelFilename = argv[2];
+  const unsigned int nbDivisions = atoi(argv[3]);
+  const double       tolerance = atof(argv[4]);
+
+  typedef otb::VectorImage<float, 2>                               ImageType;
+  typedef otb::Image<unsigned int, 2>                              LabelImageType;
+  typedef otb::ImageFileReader<ImageType>                          ReaderType;
+  typedef otb::ImageFileReader<LabelImageType>                     LabelReaderType;
+  typedef otb::StreamingStatisticsMapFromLabelImageFilter<ImageType, LabelImageType> FilterType;
+  typedef FilterType::PixelValueMapType                            PixelValueMapType;
+  typedef std::map<unsigned int, std::vector<std::vector<double> > > ValuesMapType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(inputFilename);
+  LabelReaderType::Pointer labelReader = LabelReaderType::New();
+  labelReader->SetFileName(labelFilename);
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(reader->GetOutput());
+  filter->SetInputLabelImage(labelReader->GetOutput());
+  filter->ComputeQuantilesOn();
+  filter->GetStreamer()->SetNumberOfDivisionsStrippedStreaming(nbDivisions);
+  filter->Update();
+
+  // Exact values of each label and band
+  reader->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
+  reader->Update();
+  labelReader->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
+  labelReader->Update();
+
+  const unsigned int nbBands = reader->GetOutput()->GetNumberOfComponentsPerPixel();
+  ValuesMapType values;
+  itk::ImageRegionConstIterator<ImageType> it(reader->GetOutput(), reader->GetOutput()->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<LabelImageType> lit(labelReader->GetOutput(),
+                                                    labelReader->GetOutput()->GetLargestPossibleRegion());
+  for (it.GoToBegin(), lit.GoToBegin(); !it.IsAtEnd(); ++it, ++lit)
+    {
+    std::vector<std::vector<double> > & labelValues = values[lit.Get()];
+    labelValues.resize(nbBands);
+    for (unsigned int band = 0; band < nbBands; ++band)
+      {
+      labelValues[band].push_back(it.Get()[band]);
+      }
+    }
+
+  const double quantiles[] = {0.02, 0.25, 0.5, 0.75, 0.98};
+  unsigned int nbErrors = 0;
+  for (unsigned int i = 0; i < sizeof(quantiles) / sizeof(double); ++i)
+    {
+    const PixelValueMapType quantileMap = filter->GetQuantileValueMap(quantiles[i]);
+    for (ValuesMapType::iterator vit = values.begin(); vit != values.end(); ++vit)
+      {
+      PixelValueMapType::const_iterator qit = quantileMap.find(vit->first);
+      if (qit == quantileMap.end())
+        {
+        std::cerr << "No quantile for label " << vit->first << std::endl;
+        return EXIT_FAILURE;
+        }
+      for (unsigned int band = 0; band < nbBands; ++band)
+        {
+        std::vector<double> & sorted = vit->second[band];
+        std::sort(sorted.begin(), sorted.end());
+        const double n = static_cast<double>(sorted.size());
+
+        // Pixel values have ties: the estimate is valid if q falls in the
+        // rank range of the values around it, widened by the tolerance
+        const double estimate = qit->second[band];
+        const double lowerRank = (std::lower_bound(sorted.begin(), sorted.end(), estimate) - sorted.begin()) / n;
+        const double upperRank = (std::upper_bound(sorted.begin(), sorted.end(), estimate) - sorted.begin()) / n;
+        const double allowed = tolerance + 1. / n;
+        if (quantiles[i] < lowerRank - allowed || quantiles[i] > upperRank + allowed)
+          {
+          std::cerr << "Label " << vit->first << ", band " << band << ": quantile " << quantiles[i]
+                    << " estimated at " << estimate << ", ranks [" << lowerRank << ", " << upperRank << "]"
+                    << std::endl;
+          ++nbErrors;
+          }
+        }
+      }
+    }
+
+  if (nbErrors > 0)
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
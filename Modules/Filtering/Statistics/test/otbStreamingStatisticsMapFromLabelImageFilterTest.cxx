@@ -161,6 +161,7 @@ int generic_StreamingStatisticsMapFromLabelImageFilterTest(int itkNotUsed(argc),
   m_StatisticsMapFromLabelImageFilter = StreamingStatisticsMapFromLabelImageFilterType::New();
   m_StatisticsMapFromLabelImageFilter->SetInput(supportImage);
   m_StatisticsMapFromLabelImageFilter->SetInputLabelImage(labelImage);
+  m_StatisticsMapFromLabelImageFilter->ComputeQuantilesOn();
   m_StatisticsMapFromLabelImageFilter->Update();
 
   LabelPopulationMapType labelPopulationMapBL;
@@ -209,6 +210,29 @@ int generic_StreamingStatisticsMapFromLabelImageFilterTest(int itkNotUsed(argc),
     return EXIT_FAILURE;
     }
 
+  // Each label covers a constant color: min, max and quantiles are the
+  // color and the standard deviation is null
+  MeanValueMapType minMap = m_StatisticsMapFromLabelImageFilter->GetMinValueMap();
+  MeanValueMapType maxMap = m_StatisticsMapFromLabelImageFilter->GetMaxValueMap();
+  MeanValueMapType medianMap = m_StatisticsMapFromLabelImageFilter->GetQuantileValueMap(0.5);
+  MeanValueMapType stdDevMap = m_StatisticsMapFromLabelImageFilter->GetStandardDeviationValueMap();
+  for (typename MeanValueMapType::const_iterator it = labelToMeanIntensityMapBL.begin();
+       it != labelToMeanIntensityMapBL.end(); ++it)
+    {
+    for (unsigned int band = 0; band < nbComponents; ++band)
+      {
+      if (minMap[it->first][band] != it->second[band] || maxMap[it->first][band] != it->second[band]
+          || medianMap[it->first][band] != it->second[band] || stdDevMap[it->first][band] != 0.)
+        {
+        std::cout << "ERROR with the statistics of label " << it->first << ", band " << band << ": "
+                  << "min = " << minMap[it->first][band] << ", max = " << maxMap[it->first][band]
+                  << ", median = " << medianMap[it->first][band] << ", stddev = " << stdDevMap[it->first][band]
+                  << ", expected value = " << it->second[band] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
   return EXIT_SUCCESS;
 }
 
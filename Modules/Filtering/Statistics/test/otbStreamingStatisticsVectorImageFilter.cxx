@@ -24,7 +24,9 @@
 #include "otbImageFileReader.h"
 #include "otbVectorImage.h"
 #include <fstream>
+#include <algorithm>
 #include "otbStreamingTraits.h"
+#include "itkImageRegionConstIterator.h"
 
 int otbStreamingStatisticsVectorImageFilter(int argc, char * argv[])
 {
@@ -75,3 +77,88 @@ int otbStreamingStatisticsVectorImageFilter(int argc, char * argv[])
 
   return EXIT_SUCCESS;
 }
+
+int otbStreamingStatisticsVectorImageFilterQuantiles(int itkNotUsed(argc), char * argv[])
+{
+  const char * infname = argv[1];
+
+  typedef otb::VectorImage<double, 2>                          ImageType;
+  typedef otb::ImageFileReader<ImageType>                      ReaderType;
+  typedef otb::StreamingStatisticsVectorImageFilter<ImageType> StreamingStatisticsVectorImageFilterType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(infname);
+
+  StreamingStatisticsVectorImageFilterType::Pointer filter = StreamingStatisticsVectorImageFilterType::New();
+  filter->GetStreamer()->SetNumberOfLinesStrippedStreaming( 10 );
+  filter->SetInput(reader->GetOutput());
+  filter->SetEnableQuantiles(true);
+  filter->Update();
+
+  // Exact quantiles from the sorted values of each band
+  reader->GetOutput()->SetRequestedRegion(reader->GetOutput()->GetLargestPossibleRegion());
+  reader->Update();
+  const unsigned int nbBands = reader->GetOutput()->GetNumberOfComponentsPerPixel();
+  std::vector<std::vector<double> > values(nbBands);
+  itk::ImageRegionConstIterator<ImageType> it(reader->GetOutput(), reader->GetOutput()->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    for (unsigned int band = 0; band < nbBands; ++band)
+      {
+      values[band].push_back(it.Get()[band]);
+      }
+    }
+  for (unsigned int band = 0; band < nbBands; ++band)
+    {
+    std::sort(values[band].begin(), values[band].end());
+    }
+
+  const double quantiles[] = {0., 0.02, 0.5, 0.98, 1.};
+  for (unsigned int i = 0; i < sizeof(quantiles) / sizeof(double); ++i)
+    {
+    const StreamingStatisticsVectorImageFilterType::RealPixelType estimate = filter->GetQuantile(quantiles[i]);
+    std::cout << "Quantile " << quantiles[i] << ": " << estimate << std::endl;
+    for (unsigned int band = 0; band < nbBands; ++band)
+      {
+      const std::vector<double> & bandValues = values[band];
+      // Ranks covered by the estimate (integer images have many ties)
+      const double n = bandValues.size();
+      const double lowRank = (std::lower_bound(bandValues.begin(), bandValues.end(), estimate[band]) - bandValues.begin()) / n;
+      const double highRank = (std::upper_bound(bandValues.begin(), bandValues.end(), estimate[band]) - bandValues.begin()) / n;
+      if (quantiles[i] < lowRank - 0.01 || quantiles[i] > highRank + 0.01)
+        {
+        std::cerr << "Quantile " << quantiles[i] << " of band " << band << " estimated at " << estimate[band]
+                  << ", which covers ranks [" << lowRank << ", " << highRank << "]" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // With quantiles only, an image without relevant pixel is reported
+  // through the relevant pixel count instead of an exception
+  ImageType::Pointer nullImage = ImageType::New();
+  ImageType::RegionType nullRegion = reader->GetOutput()->GetLargestPossibleRegion();
+  nullImage->SetRegions(nullRegion);
+  nullImage->SetNumberOfComponentsPerPixel(nbBands);
+  nullImage->Allocate();
+  ImageType::PixelType nullPixel(nbBands);
+  nullPixel.Fill(0.);
+  nullImage->FillBuffer(nullPixel);
+
+  StreamingStatisticsVectorImageFilterType::Pointer nullFilter = StreamingStatisticsVectorImageFilterType::New();
+  nullFilter->SetInput(nullImage);
+  nullFilter->SetEnableMinMax(false);
+  nullFilter->SetEnableFirstOrderStats(false);
+  nullFilter->SetEnableSecondOrderStats(false);
+  nullFilter->SetEnableQuantiles(true);
+  nullFilter->SetIgnoreUserDefinedValue(true);
+  nullFilter->SetUserIgnoredValue(0.);
+  nullFilter->Update();
+  if (nullFilter->GetNbRelevantPixels()[0] != 0)
+    {
+    std::cerr << "Expected no relevant pixel, got " << nullFilter->GetNbRelevantPixels() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
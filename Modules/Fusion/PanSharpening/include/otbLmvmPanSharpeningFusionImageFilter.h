@@ -99,6 +99,12 @@ public:
   itkSetMacro(Filter, ArrayType);
   itkGetConstReferenceMacro(Filter, ArrayType);
 
+  /** Number of kernel weights from which the smoothing is computed in the
+   * Fourier domain (see ConvolutionImageFilter). 0 (the default) always
+   * uses the direct convolution. */
+  itkSetMacro(FFTKernelSizeThreshold, unsigned int);
+  itkGetConstMacro(FFTKernelSizeThreshold, unsigned int);
+
   virtual void SetPanInput(const TPanImageType * image);
   const TPanImageType * GetPanInput(void) const;
 
@@ -258,6 +264,9 @@ private:
   /** Kernel used for the smoothing filter */
   ArrayType  m_Filter;
 
+  /** Kernel size from which the smoothing uses the FFT */
+  unsigned int m_FFTKernelSizeThreshold;
+
   /** The internal progress accumulator */
   typename itk::ProgressAccumulator::Pointer m_ProgressAccumulator;
 };
@@ -49,6 +49,7 @@ LmvmPanSharpeningFusionImageFilter
   m_Radius.Fill(3);
   m_Filter.SetSize(7 * 7);
   m_Filter.Fill(1);
+  m_FFTKernelSizeThreshold = 0;
 
   // Instantiate fusion filter
   m_FusionStep1Filter = FusionStep1FilterType::New();
@@ -143,10 +144,12 @@ LmvmPanSharpeningFusionImageFilter
   m_PanConvolutionFilter->SetInput(this->GetPanInput());
   m_PanConvolutionFilter->SetRadius(this->m_Radius);
   m_PanConvolutionFilter->SetFilter(this->m_Filter);
+  m_PanConvolutionFilter->SetFFTKernelSizeThreshold(m_FFTKernelSizeThreshold);
   m_PanNoiseFilter->SetRadius(this->m_Radius);
   m_PanNoiseFilter->SetInput(this->GetPanInput());
   m_XsConvolutionFilter->SetRadius(this->m_Radius);
   m_XsConvolutionFilter->SetFilter(this->m_Filter);
+  m_XsConvolutionFilter->SetFFTKernelSizeThreshold(m_FFTKernelSizeThreshold);
   m_XsVectorConvolutionFilter->SetInput(this->GetXsInput());
   m_XsVectorConvolutionFilter->SetFilter(m_XsConvolutionFilter);
   m_XsNoiseFilter->SetRadius(this->m_Radius);
@@ -179,6 +182,8 @@ LmvmPanSharpeningFusionImageFilter
   Superclass::PrintSelf(os, indent);
   os
   << indent << "Radius:" << this->m_Radius
+  << std::endl
+  << indent << "FFTKernelSizeThreshold:" << this->m_FFTKernelSizeThreshold
   << std::endl;
 }
 
@@ -22,11 +22,9 @@
 #ifndef otbSimpleRcsPanSharpeningFusionImageFilter_h
 #define otbSimpleRcsPanSharpeningFusionImageFilter_h
 
-#include "otbConvolutionImageFilter.h"
 #include "otbImage.h"
-#include "itkTernaryFunctorImageFilter.h"
-
-#include "itkProgressAccumulator.h"
+#include "itkImageToImageFilter.h"
+#include "itkArray.h"
 
 
 namespace otb
@@ -41,6 +39,15 @@ namespace otb
  *
  * \f[ \frac{XS}{\mathrm{Filtered}(PAN)} PAN  \f]
  *
+ * The smoothing of the Pan image and the fusion are computed in a single
+ * pass over each output region, so that no smoothed Pan image is ever
+ * allocated. The smoothing kernel is normalized by the sum of the
+ * absolute values of its weights and the image borders are handled by
+ * zero flux Neumann conditions, as with ConvolutionImageFilter. When
+ * all the weights of the kernel are equal (which is the default), the
+ * smoothing uses running sums and its cost no longer depends on the
+ * radius.
+ *
  * This filter supports streaming and multithreading.
  *
  * \ingroup OTBPanSharpening
@@ -97,8 +104,18 @@ protected:
   /** Destructor */
   ~SimpleRcsPanSharpeningFusionImageFilter() ITK_OVERRIDE {};
 
-  /** Call to generate data, wiring composite internal minipipeline */
-  void GenerateData() ITK_OVERRIDE;
+  /** The output has as many components as the Xs image */
+  void GenerateOutputInformation() ITK_OVERRIDE;
+
+  /** Pad the Pan requested region by the smoothing radius */
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  /** Check the inputs and read the no data flags */
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Smooth the Pan image and apply the fusion on the fly */
+  void ThreadedGenerateData(const typename TOutputImageType::RegionType& outputRegionForThread,
+                            itk::ThreadIdType threadId) ITK_OVERRIDE;
 
   /** PrintSelf method */
   void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
@@ -220,41 +237,9 @@ private:
   };
 
 
-  /**
-   *  Typedef of the TernaryFunctorImageFilter applying the fusion functor to
-   *  p, p_smooth and xs.
-   */
-  typedef itk::TernaryFunctorImageFilter<TXsImageType,
-                                         InternalImageType,
-                                         TPanImageType,
-                                         TOutputImageType,
-                                         FusionFunctor>     FusionFilterType;
-
-  /**
-   *  Typedef of the TernaryFunctorImageFilter applying the no data fusion functor to
-   *  p, p_smooth and xs.
-   */
-  typedef itk::TernaryFunctorImageFilter<TXsImageType,
-                                         InternalImageType,
-                                         TPanImageType,
-                                         TOutputImageType,
-                                         NoDataFusionFunctor>     NoDataFusionFilterType;
-
-  /** Typedef of the convolution filter performing smoothing */
-  typedef otb::ConvolutionImageFilter
-      <TPanImageType,
-       InternalImageType,
-       itk::ZeroFluxNeumannBoundaryCondition<TPanImageType>,
-       TInternalPrecision>                                  ConvolutionFilterType;
-
-  /** Pointer to the internal convolution filter */
-  typename ConvolutionFilterType::Pointer  m_ConvolutionFilter;
-
-  /** Pointer to the fusion filter */
-  typename FusionFilterType::Pointer       m_FusionFilter;
-
-  /** Pointer to the fusion filter */
-  typename NoDataFusionFilterType::Pointer m_NoDataFusionFilter;
+  /** Fusion functors */
+  FusionFunctor        m_FusionFunctor;
+  NoDataFusionFunctor  m_NoDataFusionFunctor;
 
   /** Boolean used for no data */
   bool m_UseNoData;
@@ -265,8 +250,11 @@ private:
   /** Kernel used for the smoothing filter */
   ArrayType  m_Filter;
 
-  /** The internal progress accumulator */
-  typename itk::ProgressAccumulator::Pointer m_ProgressAccumulator;
+  /** True if all the kernel weights are equal */
+  bool m_UniformFilter;
+
+  /** Sum of the absolute values of the kernel weights */
+  double m_FilterNorm;
 };
 
 } // end namespace otb
@@ -24,6 +24,14 @@
 
 #include "otbSimpleRcsPanSharpeningFusionImageFilter.h"
 
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkProgressReporter.h"
+#include "otbMetaDataKey.h"
+
+#include <algorithm>
+#include <vector>
+
 namespace otb
 {
 template <class TPanImageType, class TXsImageType, class TOutputImageType, class TInternalPrecision>
@@ -35,15 +43,13 @@ SimpleRcsPanSharpeningFusionImageFilter
   this->SetNumberOfRequiredInputs(2);
   this->m_UseNoData = false;
 
-  // Instantiate convolution filter
-  m_ConvolutionFilter = ConvolutionFilterType::New();
-  m_ConvolutionFilter->NormalizeFilterOn();
-
   // Set-up default parameters
   m_Radius.Fill(3);
   m_Filter.SetSize(7 * 7);
   m_Filter.Fill(1);
 
+  m_UniformFilter = true;
+  m_FilterNorm = 7 * 7;
 }
 
 template <class TPanImageType, class TXsImageType, class TOutputImageType, class TInternalPrecision>
@@ -108,7 +114,61 @@ template <class TPanImageType, class TXsImageType, class TOutputImageType, class
 void
 SimpleRcsPanSharpeningFusionImageFilter
 <TPanImageType, TXsImageType, TOutputImageType, TInternalPrecision>
-::GenerateData()
+::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  if (this->GetXsInput())
+    {
+    this->GetOutput()->SetNumberOfComponentsPerPixel(
+      this->GetXsInput()->GetNumberOfComponentsPerPixel());
+    }
+}
+
+template <class TPanImageType, class TXsImageType, class TOutputImageType, class TInternalPrecision>
+void
+SimpleRcsPanSharpeningFusionImageFilter
+<TPanImageType, TXsImageType, TOutputImageType, TInternalPrecision>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  TPanImageType * panPtr = const_cast<TPanImageType *>(this->GetPanInput());
+
+  if (!panPtr)
+    {
+    return;
+    }
+
+  // pad the Pan requested region by the smoothing radius
+  typename TPanImageType::RegionType panRequestedRegion = panPtr->GetRequestedRegion();
+  panRequestedRegion.PadByRadius(m_Radius);
+
+  // crop the Pan requested region at the Pan largest possible region
+  if (panRequestedRegion.Crop(panPtr->GetLargestPossibleRegion()))
+    {
+    panPtr->SetRequestedRegion(panRequestedRegion);
+    }
+  else
+    {
+    // store what we tried to request (prior to trying to crop)
+    panPtr->SetRequestedRegion(panRequestedRegion);
+
+    // build an exception
+    itk::InvalidRequestedRegionError e(__FILE__, __LINE__);
+    e.SetLocation(ITK_LOCATION);
+    e.SetDescription("Requested region is (at least partially) outside the largest possible region.");
+    e.SetDataObject(panPtr);
+    throw e;
+    }
+}
+
+template <class TPanImageType, class TXsImageType, class TOutputImageType, class TInternalPrecision>
+void
+SimpleRcsPanSharpeningFusionImageFilter
+<TPanImageType, TXsImageType, TOutputImageType, TInternalPrecision>
+::BeforeThreadedGenerateData()
 {
   //Check if size is correct
   typename TPanImageType::SizeType       sizePan;
@@ -120,14 +180,22 @@ SimpleRcsPanSharpeningFusionImageFilter
     itkExceptionMacro(<< "SimpleRcsPanSharpeningFusionImageFilter: Wrong Pan/Xs size");
     }
 
-  // Set-up progress reporting
-  m_ProgressAccumulator = itk::ProgressAccumulator::New();
-  m_ProgressAccumulator->SetMiniPipelineFilter(this);
-  m_ProgressAccumulator->RegisterInternalFilter(m_ConvolutionFilter, 0.9);
+  const unsigned int kernelSize = (2 * m_Radius[0] + 1) * (2 * m_Radius[1] + 1);
+  if (m_Filter.Size() != kernelSize)
+    {
+    itkExceptionMacro(<< "SimpleRcsPanSharpeningFusionImageFilter: the filter has "
+                      << m_Filter.Size() << " weights, " << kernelSize << " expected for radius " << m_Radius);
+    }
 
-  m_ConvolutionFilter->SetInput(this->GetPanInput());
-  m_ConvolutionFilter->SetRadius(this->m_Radius);
-  m_ConvolutionFilter->SetFilter(this->m_Filter);
+  // Normalization of the kernel and detection of the uniform kernels,
+  // which are computed with running sums
+  m_FilterNorm = 0.;
+  m_UniformFilter = true;
+  for (unsigned int i = 0; i < kernelSize; ++i)
+    {
+    m_FilterNorm += vcl_abs(static_cast<double>(m_Filter(i)));
+    m_UniformFilter = m_UniformFilter && (m_Filter(i) == m_Filter(0));
+    }
 
   typedef typename TPanImageType::InternalPixelType  PanPixelType;
   typedef typename TXsImageType::InternalPixelType   XsPixelType;
@@ -157,6 +225,7 @@ SimpleRcsPanSharpeningFusionImageFilter
   retXs &= itk::ExposeMetaData<std::vector<double> >( this->GetXsInput()->GetMetaDataDictionary(), MetaDataKey::NoDataValue, tmpNoDataValuesXs );
 
   // Check if noData is needed and update noDataValuesAvailable with return function value
+  m_UseNoData = false;
   if ( retPan || retXs )
     {
     m_UseNoData = noDataValuePanAvailable;
@@ -167,42 +236,154 @@ SimpleRcsPanSharpeningFusionImageFilter
       }
     }
 
-  // Instantiate fusion filter
   if ( m_UseNoData )
     {
-    m_NoDataFusionFilter = NoDataFusionFilterType::New();
-    m_ProgressAccumulator->RegisterInternalFilter( m_NoDataFusionFilter, 0.1 );
-
-    m_NoDataFusionFilter->SetInput2( m_ConvolutionFilter->GetOutput() );
-    m_NoDataFusionFilter->GetFunctor().SetNoDataValuesXsAvailable( noDataValuesXsAvailable );
-    m_NoDataFusionFilter->GetFunctor().SetNoDataValuePanAvailable( noDataValuePanAvailable );
-    m_NoDataFusionFilter->GetFunctor().SetNoDataValuePan( noDataValuePan );
-    m_NoDataFusionFilter->GetFunctor().SetNoDataValuesXs( noDataValuesXs );
-
-    m_NoDataFusionFilter->SetInput1( this->GetXsInput() );
-    m_NoDataFusionFilter->SetInput2( m_ConvolutionFilter->GetOutput() );
-    m_NoDataFusionFilter->SetInput3( this->GetPanInput() );
-
-    // Wire composite filter
-    m_NoDataFusionFilter->GraftOutput( this->GetOutput() );
-    m_NoDataFusionFilter->Update();
-    this->GraftOutput( m_NoDataFusionFilter->GetOutput() );
+    m_NoDataFusionFunctor.SetNoDataValuesXsAvailable( noDataValuesXsAvailable );
+    m_NoDataFusionFunctor.SetNoDataValuePanAvailable( noDataValuePanAvailable );
+    m_NoDataFusionFunctor.SetNoDataValuePan( noDataValuePan );
+    m_NoDataFusionFunctor.SetNoDataValuesXs( noDataValuesXs );
     }
-  else
+}
+
+template <class TPanImageType, class TXsImageType, class TOutputImageType, class TInternalPrecision>
+void
+SimpleRcsPanSharpeningFusionImageFilter
+<TPanImageType, TXsImageType, TOutputImageType, TInternalPrecision>
+::ThreadedGenerateData(const typename TOutputImageType::RegionType& outputRegionForThread,
+                       itk::ThreadIdType threadId)
+{
+  typedef typename TPanImageType::InternalPixelType           PanPixelType;
+  typedef typename itk::NumericTraits<PanPixelType>::RealType PanRealType;
+
+  const TPanImageType * pan = this->GetPanInput();
+  const TXsImageType *  xs  = this->GetXsInput();
+  TOutputImageType *    output = this->GetOutput();
+
+  // support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
+
+  const typename TPanImageType::RegionType panRegion = pan->GetBufferedRegion();
+  const PanPixelType * panBuffer = pan->GetBufferPointer();
+  const long panStride = panRegion.GetSize()[0];
+  const long panFirstX = panRegion.GetIndex()[0];
+  const long panFirstY = panRegion.GetIndex()[1];
+  const long panLastX  = panFirstX + static_cast<long>(panRegion.GetSize()[0]) - 1;
+  const long panLastY  = panFirstY + static_cast<long>(panRegion.GetSize()[1]) - 1;
+
+  const long radiusX = m_Radius[0];
+  const long radiusY = m_Radius[1];
+  const long startX  = outputRegionForThread.GetIndex()[0];
+  const long startY  = outputRegionForThread.GetIndex()[1];
+  const long sizeX   = outputRegionForThread.GetSize()[0];
+  const long sizeY   = outputRegionForThread.GetSize()[1];
+
+  // Offsets of the columns covered by the kernel, clamped to the Pan
+  // buffer (zero flux Neumann condition)
+  const long nbColumns = sizeX + 2 * radiusX;
+  std::vector<long> columns(nbColumns);
+  for (long j = 0; j < nbColumns; ++j)
     {
-    m_FusionFilter = FusionFilterType::New();
-    m_ProgressAccumulator->RegisterInternalFilter( m_FusionFilter, 0.1 );
+    columns[j] = std::min(std::max(startX - radiusX + j, panFirstX), panLastX) - panFirstX;
+    }
 
-    m_FusionFilter->SetInput1( this->GetXsInput() );
-    m_FusionFilter->SetInput2( m_ConvolutionFilter->GetOutput() );
-    m_FusionFilter->SetInput3( this->GetPanInput() );
+  // Rows covered by the kernel, clamped the same way
+  std::vector<const PanPixelType *> rows(2 * radiusY + 1);
 
-    // Wire composite filter
-    m_FusionFilter->GraftOutput( this->GetOutput() );
-    m_FusionFilter->Update();
-    this->GraftOutput( m_FusionFilter->GetOutput() );
+  // Vertical sums of the kernel columns, for uniform kernels
+  std::vector<PanRealType> columnSums;
+  if (m_UniformFilter)
+    {
+    columnSums.resize(nbColumns, itk::NumericTraits<PanRealType>::Zero);
     }
+  const PanRealType uniformWeight = static_cast<PanRealType>(m_Filter(0));
 
+  itk::ImageRegionConstIterator<TXsImageType> xsIt(xs, outputRegionForThread);
+  itk::ImageRegionIterator<TOutputImageType>  outIt(output, outputRegionForThread);
+  xsIt.GoToBegin();
+  outIt.GoToBegin();
+
+  for (long y = startY; y < startY + sizeY; ++y)
+    {
+    for (long dy = -radiusY; dy <= radiusY; ++dy)
+      {
+      const long row = std::min(std::max(y + dy, panFirstY), panLastY) - panFirstY;
+      rows[dy + radiusY] = panBuffer + row * panStride;
+      }
+
+    if (m_UniformFilter)
+      {
+      if (y == startY)
+        {
+        for (long dy = 0; dy <= 2 * radiusY; ++dy)
+          {
+          for (long j = 0; j < nbColumns; ++j)
+            {
+            columnSums[j] += static_cast<PanRealType>(rows[dy][columns[j]]);
+            }
+          }
+        }
+      else
+        {
+        // Slide the column sums down by one row
+        const long leavingRow = std::min(std::max(y - radiusY - 1, panFirstY), panLastY) - panFirstY;
+        const PanPixelType * leaving  = panBuffer + leavingRow * panStride;
+        const PanPixelType * entering = rows[2 * radiusY];
+        for (long j = 0; j < nbColumns; ++j)
+          {
+          columnSums[j] += static_cast<PanRealType>(entering[columns[j]])
+            - static_cast<PanRealType>(leaving[columns[j]]);
+          }
+        }
+      }
+
+    const PanPixelType * centerRow = rows[radiusY];
+    PanRealType windowSum = itk::NumericTraits<PanRealType>::Zero;
+    if (m_UniformFilter)
+      {
+      for (long j = 0; j < 2 * radiusX; ++j)
+        {
+        windowSum += columnSums[j];
+        }
+      }
+
+    for (long x = 0; x < sizeX; ++x, ++xsIt, ++outIt)
+      {
+      PanRealType sum = itk::NumericTraits<PanRealType>::Zero;
+
+      if (m_UniformFilter)
+        {
+        windowSum += columnSums[x + 2 * radiusX];
+        sum = windowSum * uniformWeight;
+        windowSum -= columnSums[x];
+        }
+      else
+        {
+        unsigned int k = 0;
+        for (long dy = 0; dy <= 2 * radiusY; ++dy)
+          {
+          const PanPixelType * kernelRow = rows[dy];
+          for (long dx = 0; dx <= 2 * radiusX; ++dx, ++k)
+            {
+            sum += static_cast<PanRealType>(kernelRow[columns[x + dx]] * m_Filter(k));
+            }
+          }
+        }
+
+      const TInternalPrecision smoothPanchro = static_cast<TInternalPrecision>(sum / m_FilterNorm);
+      const PanPixelType sharpPanchro = centerRow[columns[x + radiusX]];
+
+      if (m_UseNoData)
+        {
+        outIt.Set(m_NoDataFusionFunctor(xsIt.Get(), smoothPanchro, sharpPanchro));
+        }
+      else
+        {
+        outIt.Set(m_FusionFunctor(xsIt.Get(), smoothPanchro, sharpPanchro));
+        }
+
+      progress.CompletedPixel();
+      }
+    }
 }
 
 template <class TPanImageType, class TXsImageType, class TOutputImageType, class TInternalPrecision>
@@ -215,6 +396,7 @@ SimpleRcsPanSharpeningFusionImageFilter
   os
   << indent << "Radius:" << this->m_Radius
   << std::endl;
+  os << indent << "UniformFilter: " << this->m_UniformFilter << std::endl;
 }
 
 } // end namespace otb
@@ -26,7 +26,7 @@
 
 #include "otbLmvmPanSharpeningFusionImageFilter.h"
 
-int otbLmvmPanSharpeningFusionImageFilter(int itkNotUsed(argc), char * argv[])
+int otbLmvmPanSharpeningFusionImageFilter(int argc, char * argv[])
 {
   const char * panchro = argv[1];
   const char * multispect = argv[2];
@@ -74,6 +74,11 @@ int otbLmvmPanSharpeningFusionImageFilter(int itkNotUsed(argc), char * argv[])
   filter->SetPanInput(panchroReader->GetOutput());
   filter->SetRadius(radius);
   filter->SetFilter(filterCoeffs);
+  if (argc > 4)
+    {
+    // Kernel size from which the smoothing is computed by FFT
+    filter->SetFFTKernelSizeThreshold(atoi(argv[4]));
+    }
   writer->SetInput(filter->GetOutput());
   writer->SetFileName(output);
   writer->Update();
@@ -23,6 +23,7 @@
 void RegisterTests()
 {
   REGISTER_TEST(otbSimpleRcsPanSharpeningFusionImageFilter);
+  REGISTER_TEST(otbSimpleRcsPanSharpeningFusionImageFilterKernel);
   REGISTER_TEST(otbLmvmPanSharpeningFusionImageFilterNew);
   REGISTER_TEST(otbBayesianFusionFilterNew);
   REGISTER_TEST(otbBayesianFusionFilter);
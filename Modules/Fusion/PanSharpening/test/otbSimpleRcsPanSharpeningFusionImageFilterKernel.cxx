@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbImage.h"
+#include "otbVectorImage.h"
+#include "otbConvolutionImageFilter.h"
+#include "otbSimpleRcsPanSharpeningFusionImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <iostream>
+
+namespace
+{
+typedef otb::Image<double, 2>                             PanImageType;
+typedef otb::VectorImage<double, 2>                       XsImageType;
+typedef otb::SimpleRcsPanSharpeningFusionImageFilter
+  <PanImageType, XsImageType, XsImageType, double>        FilterType;
+typedef otb::ConvolutionImageFilter
+  <PanImageType, PanImageType,
+   itk::ZeroFluxNeumannBoundaryCondition<PanImageType>,
+   double>                                                ConvolutionFilterType;
+
+// Compare the fused filter output on the given region with the smoothing
+// done by ConvolutionImageFilter followed by the ratio
+bool CheckFusion(PanImageType * pan, XsImageType * xs,
+                 const PanImageType::SizeType & radius,
+                 const itk::Array<double> & kernel,
+                 const PanImageType::RegionType & region)
+{
+  ConvolutionFilterType::Pointer convolution = ConvolutionFilterType::New();
+  convolution->SetInput(pan);
+  convolution->SetRadius(radius);
+  convolution->SetFilter(kernel);
+  convolution->NormalizeFilterOn();
+  convolution->Update();
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetPanInput(pan);
+  filter->SetXsInput(xs);
+  filter->SetRadius(radius);
+  filter->SetFilter(kernel);
+  filter->GetOutput()->SetRequestedRegion(region);
+  filter->GetOutput()->Update();
+
+  itk::ImageRegionConstIteratorWithIndex<XsImageType> outIt(filter->GetOutput(), region);
+  for (outIt.GoToBegin(); !outIt.IsAtEnd(); ++outIt)
+    {
+    const PanImageType::IndexType index = outIt.GetIndex();
+    const double smooth = convolution->GetOutput()->GetPixel(index);
+    const double scale = vcl_abs(smooth) > 1e-10 ? pan->GetPixel(index) / smooth : 1.;
+    const XsImageType::PixelType xsPixel = xs->GetPixel(index);
+
+    for (unsigned int b = 0; b < xsPixel.Size(); ++b)
+      {
+      const double expected = xsPixel[b] * scale;
+      if (vcl_abs(outIt.Get()[b] - expected) > 1e-9 * (1. + vcl_abs(expected)))
+        {
+        std::cerr << "Pixel " << index << ", band " << b << ": got " << outIt.Get()[b]
+                  << ", expected " << expected << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+}
+
+int otbSimpleRcsPanSharpeningFusionImageFilterKernel(int itkNotUsed(argc), char * itkNotUsed(argv) [])
+{
+  PanImageType::SizeType size;
+  size[0] = 61;
+  size[1] = 47;
+  PanImageType::IndexType start;
+  start.Fill(0);
+  PanImageType::RegionType largest(start, size);
+
+  PanImageType::Pointer pan = PanImageType::New();
+  pan->SetRegions(largest);
+  pan->Allocate();
+
+  XsImageType::Pointer xs = XsImageType::New();
+  xs->SetRegions(largest);
+  xs->SetNumberOfComponentsPerPixel(3);
+  xs->Allocate();
+
+  // Non integer radiometry, with a few zero pixels
+  itk::ImageRegionIteratorWithIndex<PanImageType> panIt(pan, largest);
+  itk::ImageRegionIteratorWithIndex<XsImageType>  xsIt(xs, largest);
+  for (panIt.GoToBegin(), xsIt.GoToBegin(); !panIt.IsAtEnd(); ++panIt, ++xsIt)
+    {
+    const PanImageType::IndexType index = panIt.GetIndex();
+    panIt.Set((index[0] * 7 + index[1] * 13) % 17 == 0 ? 0. : 100. + ((index[0] * 31 + index[1] * 17) % 53) * 0.37);
+
+    XsImageType::PixelType xsPixel(3);
+    for (unsigned int b = 0; b < 3; ++b)
+      {
+      xsPixel[b] = 50. + b * 10. + ((index[0] + 3 * index[1] + b) % 11) * 1.5;
+      }
+    xsIt.Set(xsPixel);
+    }
+
+  PanImageType::SizeType radius;
+  radius[0] = 3;
+  radius[1] = 2;
+  const unsigned int kernelSize = (2 * radius[0] + 1) * (2 * radius[1] + 1);
+
+  // Uniform kernel: running sums
+  itk::Array<double> box(kernelSize);
+  box.Fill(2.);
+
+  // Separable triangle kernel: direct weighted sums
+  itk::Array<double> triangle(kernelSize);
+  unsigned int k = 0;
+  for (long dy = -static_cast<long>(radius[1]); dy <= static_cast<long>(radius[1]); ++dy)
+    {
+    for (long dx = -static_cast<long>(radius[0]); dx <= static_cast<long>(radius[0]); ++dx, ++k)
+      {
+      triangle[k] = (radius[0] + 1 - vcl_abs(dx)) * (radius[1] + 1 - vcl_abs(dy));
+      }
+    }
+
+  // A region touching the image borders, and an inner one
+  PanImageType::IndexType innerStart;
+  innerStart[0] = 11;
+  innerStart[1] = 9;
+  PanImageType::SizeType innerSize;
+  innerSize[0] = 23;
+  innerSize[1] = 17;
+  PanImageType::RegionType inner(innerStart, innerSize);
+
+  bool ok = true;
+  ok = ok && CheckFusion(pan, xs, radius, box, largest);
+  ok = ok && CheckFusion(pan, xs, radius, box, inner);
+  ok = ok && CheckFusion(pan, xs, radius, triangle, largest);
+  ok = ok && CheckFusion(pan, xs, radius, triangle, inner);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
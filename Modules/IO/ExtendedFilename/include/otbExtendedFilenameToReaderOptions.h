@@ -42,6 +42,10 @@ namespace otb
  *             - a range of bands : '3:' means 3rd band until the last one
  *                 ':-2' means the first bands until the second to last
  *                 '2:4' means bands 2,3 and 4
+ * - &blockcache : keep the blocks read from the file in an LRU cache,
+ *           so that overlapping requests are served from memory. Accepts
+ *           a boolean switch (the cache size is then derived from the
+ *           RAM hint) or a cache size in MB (values greater than 1)
  *
  *  \sa ImageFileReader
  *
@@ -75,6 +79,8 @@ public:
     std::pair< bool, bool         >  skipGeom;
     std::pair< bool, bool         >  skipRpcTag;
     std::pair< bool, std::string  >  bandRange;
+    std::pair< bool, bool         >  blockCache;
+    std::pair< bool, unsigned int >  blockCacheSize;
     std::vector<std::string>         optionList;
   };
 
@@ -99,6 +105,11 @@ public:
   /** Test if band range extended filename is set */
   bool BandRangeIsSet () const;
 
+  bool BlockCacheIsSet () const;
+  bool GetBlockCache () const;
+  /** Block cache size in MB, 0 meaning that it is derived from the RAM hint */
+  unsigned int GetBlockCacheSize () const;
+
 protected:
   ExtendedFilenameToReaderOptions();
   ~ExtendedFilenameToReaderOptions() ITK_OVERRIDE {}
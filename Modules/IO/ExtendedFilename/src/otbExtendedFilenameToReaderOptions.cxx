@@ -52,6 +52,12 @@ ExtendedFilenameToReaderOptions
   m_Options.bandRange.first = false;
   m_Options.bandRange.second = "";
 
+  m_Options.blockCache.first  = false;
+  m_Options.blockCache.second = false;
+
+  m_Options.blockCacheSize.first  = false;
+  m_Options.blockCacheSize.second = 0;
+
   m_Options.optionList.push_back("geom");
   m_Options.optionList.push_back("sdataidx");
   m_Options.optionList.push_back("resol");
@@ -59,6 +65,7 @@ ExtendedFilenameToReaderOptions
   m_Options.optionList.push_back("skipgeom");
   m_Options.optionList.push_back("skiprpctag");
   m_Options.optionList.push_back("bands");
+  m_Options.optionList.push_back("blockcache");
 }
 
 void
@@ -145,6 +152,28 @@ ExtendedFilenameToReaderOptions
       }
     }
 
+  if (!map["blockcache"].empty())
+    {
+    m_Options.blockCache.first = true;
+    const std::string & value = map["blockcache"];
+    if (   value == "On"
+        || value == "on"
+        || value == "ON"
+        || value == "true"
+        || value == "True"
+        || value == "1"   )
+      {
+      m_Options.blockCache.second = true;
+      }
+    else if (value.find_first_not_of("0123456789") == std::string::npos
+             && atoi(value.c_str()) > 1)
+      {
+      m_Options.blockCache.second = true;
+      m_Options.blockCacheSize.first  = true;
+      m_Options.blockCacheSize.second = atoi(value.c_str());
+      }
+    }
+
   //Option Checking
   MapIteratorType it;
   for ( it=map.begin(); it != map.end(); it++ )
@@ -259,4 +288,25 @@ ExtendedFilenameToReaderOptions
   return m_Options.bandRange.second;
 }
 
+bool
+ExtendedFilenameToReaderOptions
+::BlockCacheIsSet () const
+{
+  return m_Options.blockCache.first;
+}
+
+bool
+ExtendedFilenameToReaderOptions
+::GetBlockCache () const
+{
+  return m_Options.blockCache.second;
+}
+
+unsigned int
+ExtendedFilenameToReaderOptions
+::GetBlockCacheSize () const
+{
+  return m_Options.blockCacheSize.second;
+}
+
 } // end namespace otb
@@ -36,6 +36,7 @@
 #include "otbDefaultConvertPixelTraits.h"
 #include "otbImageKeywordlist.h"
 #include "otbExtendedFilenameToReaderOptions.h"
+#include "otbImageIOBlockCache.h"
 
 namespace otb
 {
@@ -76,7 +77,20 @@ public:
  * http://wiki.orfeo-toolbox.org/index.php/ExtendedFileName for more
  * information.
  *
+ * Optionally, the blocks read from the file can be kept in a least
+ * recently used cache (see SetUseBlockCache() or the blockcache
+ * extended filename option). Stream divisions of a resampling
+ * pipeline usually request overlapping input regions: with the cache
+ * enabled, the overlapping part is served from memory and only the
+ * missing blocks are read from the file. The block grid follows the
+ * tile hint of the file, grouping strips or small tiles into blocks of
+ * at least 256 pixels along each axis. The cache size defaults to a
+ * quarter of the RAM hint, and is deducted from the RAM that the
+ * streaming managers share between the stream divisions. Hit and miss
+ * counts are available from GetBlockCache().
+ *
  * \sa ExtendedFilenameToReaderOptions
+ * \sa ImageIOBlockCache
  * \sa ImageSeriesReader
  * \sa ImageIOBase
  *
@@ -117,6 +131,9 @@ public:
   /** The Filename Helper. */
   typedef ExtendedFilenameToReaderOptions            FNameHelperType;
 
+  /** The block cache. */
+  typedef ImageIOBlockCache                          BlockCacheType;
+
   /** Prepare image allocation at the first call of the pipeline processing */
   void GenerateOutputInformation(void) ITK_OVERRIDE;
 
@@ -156,6 +173,22 @@ public:
    * Returns: overview info, empty if none.*/
   std::vector<std::string> GetOverviewsInfo();
 
+  /** Set/Get whether the blocks read from the file are kept in a
+   * cache. The blockcache extended filename option takes precedence.
+   * The cache size is declared to the pipeline memory print calculator,
+   * so that the streaming managers deduct it from the available RAM. */
+  itkSetMacro(UseBlockCache, bool);
+  itkGetConstMacro(UseBlockCache, bool);
+  itkBooleanMacro(UseBlockCache);
+
+  /** Set/Get the block cache size in MB. 0 (default) means a quarter
+   * of the RAM hint. */
+  itkSetMacro(BlockCacheSizeInMB, unsigned int);
+  itkGetConstMacro(BlockCacheSizeInMB, unsigned int);
+
+  /** Get the block cache, which holds the hit and miss statistics */
+  itkGetObjectMacro(BlockCache, BlockCacheType);
+
 protected:
   ImageFileReader();
   ~ImageFileReader() ITK_OVERRIDE;
@@ -177,6 +210,13 @@ private:
 
   // Retrieve the real source file name if derived dataset */
   std::string GetDerivedDatasetSourceFileName(const std::string& filename) const;
+
+  /** Read the current IO region of m_ImageIO into buffer, through the
+   * block cache if it is enabled and the file can be streamed. */
+  void ReadImageIORegion(void* buffer);
+
+  /** Size of the block cache in MB, 0 if it is disabled */
+  unsigned int GetActualBlockCacheSizeInMB() const;
   
   ImageFileReader(const Self &); //purposely not implemented
   void operator =(const Self&); //purposely not implemented
@@ -207,6 +247,12 @@ private:
    *  This variable can be the number of components in m_ImageIO or the
    *  number of components in the m_BandList (if used) */
   unsigned int m_IOComponents;
+
+  bool m_UseBlockCache;
+
+  unsigned int m_BlockCacheSizeInMB;
+
+  BlockCacheType::Pointer m_BlockCache;
 };
 
 } //namespace otb
@@ -27,7 +27,10 @@
 #include "otbSystem.h"
 #include <itksys/SystemTools.hxx>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <cstring>
+#include <algorithm>
 
 #include "itkImageIOFactory.h"
 #include "itkPixelTraits.h"
@@ -37,6 +40,8 @@
 #include "otbConvertPixelBuffer.h"
 #include "otbImageIOFactory.h"
 #include "otbMetaDataKey.h"
+#include "otbConfigurationManager.h"
+#include "otbPipelineMemoryPrintCalculator.h"
 
 #include "otbMacro.h"
 
@@ -69,7 +74,10 @@ ImageFileReader<TOutputImage, ConvertPixelTraits>
    m_FilenameHelper(FNameHelperType::New()),
    m_AdditionalNumber(0),
    m_KeywordListUpToDate(false),
-   m_IOComponents(0)
+   m_IOComponents(0),
+   m_UseBlockCache(false),
+   m_BlockCacheSizeInMB(0),
+   m_BlockCache(BlockCacheType::New())
 {
 }
 
@@ -100,6 +108,10 @@ void ImageFileReader<TOutputImage, ConvertPixelTraits>
   os << indent << "m_UseStreaming flag: " << this->m_UseStreaming << "\n";
   os << indent << "m_ActualIORegion: " << this->m_ActualIORegion << "\n";
   os << indent << "m_AdditionalNumber: " << this->m_AdditionalNumber << "\n";
+  os << indent << "m_UseBlockCache flag: " << this->m_UseBlockCache << "\n";
+  os << indent << "m_BlockCacheSizeInMB: " << this->m_BlockCacheSizeInMB << "\n";
+  os << indent << "BlockCache: \n";
+  this->m_BlockCache->Print(os, indent.GetNextIndent());
 }
 
 template <class TOutputImage, class ConvertPixelTraits>
@@ -189,7 +201,7 @@ ImageFileReader<TOutputImage, ConvertPixelTraits>
       && !m_FilenameHelper->BandRangeIsSet())
     {
     // Have the ImageIO read directly into the allocated buffer
-    this->m_ImageIO->Read(buffer);
+    this->ReadImageIORegion(buffer);
     return;
     }
   else // a type conversion is necessary
@@ -213,7 +225,7 @@ ImageFileReader<TOutputImage, ConvertPixelTraits>
         << " , "<<m_BandList.size() << ") ) x " \
         << "Nb of Pixel to read (" << region.GetNumberOfPixels() << ")");
 
-    this->m_ImageIO->Read(loadBuffer);
+    this->ReadImageIORegion(loadBuffer);
 
     if (m_FilenameHelper->BandRangeIsSet())
       this->m_ImageIO->DoMapBuffer(loadBuffer, region.GetNumberOfPixels(), this->m_BandList);
@@ -224,6 +236,208 @@ ImageFileReader<TOutputImage, ConvertPixelTraits>
     }
 }
 
+template <class TOutputImage, class ConvertPixelTraits>
+unsigned int
+ImageFileReader<TOutputImage, ConvertPixelTraits>
+::GetActualBlockCacheSizeInMB() const
+{
+  const bool useCache = m_FilenameHelper->BlockCacheIsSet()
+    ? m_FilenameHelper->GetBlockCache() : m_UseBlockCache;
+  if (!useCache)
+    {
+    return 0;
+    }
+
+  if (m_FilenameHelper->BlockCacheIsSet() && m_FilenameHelper->GetBlockCacheSize() > 0)
+    {
+    return m_FilenameHelper->GetBlockCacheSize();
+    }
+  return m_BlockCacheSizeInMB > 0 ? m_BlockCacheSizeInMB
+    : std::max(static_cast<unsigned int>(otb::ConfigurationManager::GetMaxRAMHint() / 4), 1U);
+}
+
+template <class TOutputImage, class ConvertPixelTraits>
+void
+ImageFileReader<TOutputImage, ConvertPixelTraits>
+::ReadImageIORegion(void* buffer)
+{
+  const unsigned int cacheSizeInMB = this->GetActualBlockCacheSizeInMB();
+
+  const itk::ImageIORegion ioRegion = this->m_ImageIO->GetIORegion();
+
+  // The cache works on the 2D block grid of files that can be read by
+  // parts
+  if (cacheSizeInMB == 0
+      || !this->m_ImageIO->CanStreamRead()
+      || this->m_ImageIO->GetNumberOfDimensions() != 2
+      || ioRegion.GetImageDimension() != 2
+      || ioRegion.GetNumberOfPixels() == 0)
+    {
+    this->m_ImageIO->Read(buffer);
+    return;
+    }
+
+  typedef BlockCacheType::BlockIndexType  BlockIndexType;
+  typedef BlockCacheType::BlockBufferType BlockBufferType;
+
+  const size_t pixelSize = this->m_ImageIO->GetComponentSize()
+    * this->m_ImageIO->GetNumberOfComponents();
+
+  const long imageSizeX = this->m_ImageIO->GetDimensions(0);
+  const long imageSizeY = this->m_ImageIO->GetDimensions(1);
+
+  // Block grid: multiple of the file tiles, with at least
+  // minimumBlockSize pixels along each axis so that strips and small
+  // tiles do not end up in a myriad of tiny reads
+  const long minimumBlockSize = 256;
+
+  unsigned int tileHintX(0), tileHintY(0);
+  itk::ExposeMetaData<unsigned int>(this->m_ImageIO->GetMetaDataDictionary(),
+                                    MetaDataKey::TileHintX,
+                                    tileHintX);
+  itk::ExposeMetaData<unsigned int>(this->m_ImageIO->GetMetaDataDictionary(),
+                                    MetaDataKey::TileHintY,
+                                    tileHintY);
+
+  long blockSizeX = tileHintX > 0 ? static_cast<long>(tileHintX) : minimumBlockSize;
+  long blockSizeY = tileHintY > 0 ? static_cast<long>(tileHintY) : minimumBlockSize;
+  blockSizeX *= (minimumBlockSize + blockSizeX - 1) / blockSizeX;
+  blockSizeY *= (minimumBlockSize + blockSizeY - 1) / blockSizeY;
+  blockSizeX = std::min(blockSizeX, imageSizeX);
+  blockSizeY = std::min(blockSizeY, imageSizeY);
+
+  // Anything that changes the content or the layout of the blocks
+  // flushes the cache
+  std::ostringstream layout;
+  layout << this->m_ImageIO->GetNameOfClass() << "|"
+         << this->m_ImageIO->GetFileName() << "|"
+         << m_FilenameHelper->GetSubDatasetIndex() << "|"
+         << m_FilenameHelper->GetResolutionFactor() << "|"
+         << this->m_ImageIO->GetComponentTypeAsString(this->m_ImageIO->GetComponentType()) << "|"
+         << this->m_ImageIO->GetNumberOfComponents() << "|"
+         << imageSizeX << "x" << imageSizeY << "|"
+         << blockSizeX << "x" << blockSizeY;
+  m_BlockCache->SetLayout(layout.str());
+
+  m_BlockCache->SetCapacity(static_cast<size_t>(cacheSizeInMB) * 1024 * 1024);
+
+  const long startX = ioRegion.GetIndex()[0];
+  const long startY = ioRegion.GetIndex()[1];
+  const long sizeX  = ioRegion.GetSize()[0];
+  const long sizeY  = ioRegion.GetSize()[1];
+
+  char * outputBuffer = static_cast<char *>(buffer);
+
+  // Copy the part of a block overlapping the IO region to the output
+  // buffer
+  struct BlockCopier
+  {
+    static void Copy(const char * block, long blockStartX, long blockStartY,
+                     long blockWidth, long blockHeight,
+                     char * output, long startX, long startY, long sizeX, long sizeY,
+                     size_t pixelSize)
+    {
+      const long x0 = std::max(blockStartX, startX);
+      const long x1 = std::min(blockStartX + blockWidth, startX + sizeX);
+      const long y0 = std::max(blockStartY, startY);
+      const long y1 = std::min(blockStartY + blockHeight, startY + sizeY);
+
+      for (long y = y0; y < y1; ++y)
+        {
+        std::memcpy(output + ((y - startY) * sizeX + (x0 - startX)) * pixelSize,
+                    block + ((y - blockStartY) * blockWidth + (x0 - blockStartX)) * pixelSize,
+                    (x1 - x0) * pixelSize);
+        }
+    }
+  };
+
+  const long firstBlockX = startX / blockSizeX;
+  const long lastBlockX  = (startX + sizeX - 1) / blockSizeX;
+  const long firstBlockY = startY / blockSizeY;
+  const long lastBlockY  = (startY + sizeY - 1) / blockSizeY;
+
+  itk::ImageIORegion runRegion(2);
+  BlockBufferType runBuffer;
+
+  for (long by = firstBlockY; by <= lastBlockY; ++by)
+    {
+    const long blockStartY = by * blockSizeY;
+    const long blockHeight = std::min(blockSizeY, imageSizeY - blockStartY);
+
+    long bx = firstBlockX;
+    while (bx <= lastBlockX)
+      {
+      const BlockBufferType * cached = m_BlockCache->Find(BlockIndexType(bx, by));
+      if (cached)
+        {
+        BlockCopier::Copy(&(*cached)[0], bx * blockSizeX, blockStartY,
+                          std::min(blockSizeX, imageSizeX - bx * blockSizeX), blockHeight,
+                          outputBuffer, startX, startY, sizeX, sizeY, pixelSize);
+        ++bx;
+        continue;
+        }
+
+      // Gather the following missing blocks of the row, so that they
+      // are read in a single call. A cached block ending the run is
+      // copied right away, since inserting the run may evict it.
+      long runEnd = bx;
+      while (runEnd < lastBlockX)
+        {
+        const BlockBufferType * next = m_BlockCache->Find(BlockIndexType(runEnd + 1, by));
+        if (next)
+          {
+          const long nextStartX = (runEnd + 1) * blockSizeX;
+          BlockCopier::Copy(&(*next)[0], nextStartX, blockStartY,
+                            std::min(blockSizeX, imageSizeX - nextStartX), blockHeight,
+                            outputBuffer, startX, startY, sizeX, sizeY, pixelSize);
+          break;
+          }
+        ++runEnd;
+        }
+
+      const long runStartX = bx * blockSizeX;
+      const long runWidth  = std::min((runEnd + 1) * blockSizeX, imageSizeX) - runStartX;
+
+      runRegion.SetIndex(0, runStartX);
+      runRegion.SetIndex(1, blockStartY);
+      runRegion.SetSize(0, runWidth);
+      runRegion.SetSize(1, blockHeight);
+      this->m_ImageIO->SetIORegion(runRegion);
+
+      runBuffer.resize(static_cast<size_t>(runWidth) * blockHeight * pixelSize);
+      this->m_ImageIO->Read(&runBuffer[0]);
+
+      BlockCopier::Copy(&runBuffer[0], runStartX, blockStartY, runWidth, blockHeight,
+                        outputBuffer, startX, startY, sizeX, sizeY, pixelSize);
+
+      // Split the run into blocks
+      for (long b = bx; b <= runEnd; ++b)
+        {
+        const long blockStartX = b * blockSizeX;
+        const long blockWidth  = std::min(blockSizeX, imageSizeX - blockStartX);
+
+        BlockBufferType block(static_cast<size_t>(blockWidth) * blockHeight * pixelSize);
+        for (long y = 0; y < blockHeight; ++y)
+          {
+          std::memcpy(&block[y * blockWidth * pixelSize],
+                      &runBuffer[(y * runWidth + (blockStartX - runStartX)) * pixelSize],
+                      blockWidth * pixelSize);
+          }
+        m_BlockCache->Insert(BlockIndexType(b, by), block);
+        }
+
+      // Skip the cached block ending the run, if any
+      bx = runEnd + 2;
+      }
+    }
+
+  this->m_ImageIO->SetIORegion(ioRegion);
+
+  otbMsgDevMacro(<< "Block cache: " << m_BlockCache->GetNumberOfHits() << " hits, "
+                 << m_BlockCache->GetNumberOfMisses() << " misses, "
+                 << m_BlockCache->GetNumberOfBlocks() << " blocks in memory");
+}
+
 template <class TOutputImage, class ConvertPixelTraits>
 void
 ImageFileReader<TOutputImage, ConvertPixelTraits>
@@ -495,6 +709,12 @@ ImageFileReader<TOutputImage, ConvertPixelTraits>
     this->SetMetaDataDictionary(dictLight);
     }
 
+  // Declare the block cache to the streaming managers, which deduct it
+  // from the RAM available for the stream divisions
+  itk::EncapsulateMetaData<PipelineMemoryPrintCalculator::MemoryPrintType>(
+    this->GetMetaDataDictionary(), PipelineMemoryPrintCalculator::ReservedMemoryPrintKey,
+    static_cast<PipelineMemoryPrintCalculator::MemoryPrintType>(this->GetActualBlockCacheSizeInMB()) * 1024 * 1024);
+
   typedef typename TOutputImage::IndexType IndexType;
 
   IndexType start;
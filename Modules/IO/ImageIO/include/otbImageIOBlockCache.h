@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbImageIOBlockCache_h
+#define otbImageIOBlockCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace otb
+{
+
+/** \class ImageIOBlockCache
+ * \brief Least recently used cache of raw file blocks.
+ *
+ * This class stores blocks of raw pixel data, as returned by an
+ * ImageIO (i.e. before any band mapping or pixel conversion), indexed
+ * by their position in the block grid of the file. When the memory
+ * used by the stored blocks exceeds the capacity, the least recently
+ * used blocks are discarded.
+ *
+ * The cache is bound to a layout string describing the dataset and
+ * its block grid: changing the layout flushes the cache, so that
+ * blocks from different files or different block grids are never
+ * mixed.
+ *
+ * Hits and misses are counted on each lookup, which allows
+ * evaluating how much of the reading has been served from memory.
+ *
+ * \sa ImageFileReader
+ *
+ * \ingroup OTBImageIO
+ */
+class ITK_EXPORT ImageIOBlockCache : public itk::Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageIOBlockCache             Self;
+  typedef itk::Object                   Superclass;
+  typedef itk::SmartPointer<Self>       Pointer;
+  typedef itk::SmartPointer<const Self> ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageIOBlockCache, itk::Object);
+
+  /** Position (column, row) of a block in the block grid */
+  typedef std::pair<long, long>         BlockIndexType;
+
+  /** Raw content of a block */
+  typedef std::vector<char>             BlockBufferType;
+
+  /** Set the layout of the cached dataset. Blocks are flushed if the
+   *  layout differs from the current one. */
+  void SetLayout(const std::string & layout);
+  itkGetStringMacro(Layout);
+
+  /** Set the maximum memory used by the cached blocks, in bytes.
+   *  Blocks are evicted if the new capacity is exceeded. */
+  void SetCapacity(size_t capacity);
+  itkGetConstMacro(Capacity, size_t);
+
+  /** Memory currently used by the cached blocks, in bytes */
+  itkGetConstMacro(MemoryUsage, size_t);
+
+  /** Return the cached block at the given position, or a null pointer
+   *  if the block is not cached. The block becomes the most recently
+   *  used one. The returned pointer is only valid until the next
+   *  call to Insert(). */
+  const BlockBufferType * Find(const BlockIndexType & index);
+
+  /** Store a block. The content of data is swapped into the cache, so
+   *  that no copy occurs. Blocks larger than the capacity are not
+   *  stored. */
+  void Insert(const BlockIndexType & index, BlockBufferType & data);
+
+  /** Remove all the blocks (statistics are kept) */
+  void Clear();
+
+  /** Reset hit and miss counters */
+  void ResetStatistics();
+
+  /** Number of blocks currently cached */
+  size_t GetNumberOfBlocks() const
+  {
+    return m_Blocks.size();
+  }
+
+  itkGetConstMacro(NumberOfHits, unsigned long);
+  itkGetConstMacro(NumberOfMisses, unsigned long);
+  itkGetConstMacro(NumberOfEvictions, unsigned long);
+
+  /** Ratio of lookups served from the cache (0 if no lookup) */
+  double GetHitRate() const;
+
+protected:
+  ImageIOBlockCache();
+  ~ImageIOBlockCache() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+private:
+  ImageIOBlockCache(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+
+  /** Evict least recently used blocks until the memory usage plus
+   *  the given amount fits in the capacity */
+  void MakeRoom(size_t needed);
+
+  typedef std::list<BlockIndexType> LRUListType;
+
+  struct BlockEntry
+  {
+    BlockBufferType       data;
+    LRUListType::iterator position;
+  };
+
+  typedef std::map<BlockIndexType, BlockEntry> BlockMapType;
+
+  std::string   m_Layout;
+  size_t        m_Capacity;
+  size_t        m_MemoryUsage;
+
+  /** Blocks, with their position in the LRU list */
+  BlockMapType  m_Blocks;
+
+  /** Most recently used block first */
+  LRUListType   m_LRU;
+
+  unsigned long m_NumberOfHits;
+  unsigned long m_NumberOfMisses;
+  unsigned long m_NumberOfEvictions;
+};
+
+} // end namespace otb
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbImageIOBlockCache.h"
+
+namespace otb
+{
+
+ImageIOBlockCache
+::ImageIOBlockCache()
+ : m_Layout(""),
+   m_Capacity(0),
+   m_MemoryUsage(0),
+   m_NumberOfHits(0),
+   m_NumberOfMisses(0),
+   m_NumberOfEvictions(0)
+{
+}
+
+void
+ImageIOBlockCache
+::SetLayout(const std::string & layout)
+{
+  if (layout != m_Layout)
+    {
+    this->Clear();
+    m_Layout = layout;
+    this->Modified();
+    }
+}
+
+void
+ImageIOBlockCache
+::SetCapacity(size_t capacity)
+{
+  if (capacity != m_Capacity)
+    {
+    m_Capacity = capacity;
+    this->MakeRoom(0);
+    this->Modified();
+    }
+}
+
+const ImageIOBlockCache::BlockBufferType *
+ImageIOBlockCache
+::Find(const BlockIndexType & index)
+{
+  BlockMapType::iterator it = m_Blocks.find(index);
+
+  if (it == m_Blocks.end())
+    {
+    ++m_NumberOfMisses;
+    return ITK_NULLPTR;
+    }
+
+  ++m_NumberOfHits;
+  m_LRU.splice(m_LRU.begin(), m_LRU, it->second.position);
+  return &(it->second.data);
+}
+
+void
+ImageIOBlockCache
+::Insert(const BlockIndexType & index, BlockBufferType & data)
+{
+  const size_t size = data.size();
+
+  BlockMapType::iterator it = m_Blocks.find(index);
+  if (it != m_Blocks.end())
+    {
+    m_MemoryUsage -= it->second.data.size();
+    m_LRU.erase(it->second.position);
+    m_Blocks.erase(it);
+    }
+
+  if (size == 0 || size > m_Capacity)
+    {
+    return;
+    }
+
+  this->MakeRoom(size);
+
+  m_LRU.push_front(index);
+  BlockEntry & entry = m_Blocks[index];
+  entry.data.swap(data);
+  entry.position = m_LRU.begin();
+  m_MemoryUsage += size;
+}
+
+void
+ImageIOBlockCache
+::Clear()
+{
+  m_Blocks.clear();
+  m_LRU.clear();
+  m_MemoryUsage = 0;
+}
+
+void
+ImageIOBlockCache
+::ResetStatistics()
+{
+  m_NumberOfHits = 0;
+  m_NumberOfMisses = 0;
+  m_NumberOfEvictions = 0;
+}
+
+double
+ImageIOBlockCache
+::GetHitRate() const
+{
+  const unsigned long lookups = m_NumberOfHits + m_NumberOfMisses;
+  if (lookups == 0)
+    {
+    return 0.;
+    }
+  return static_cast<double>(m_NumberOfHits) / static_cast<double>(lookups);
+}
+
+void
+ImageIOBlockCache
+::MakeRoom(size_t needed)
+{
+  while (!m_LRU.empty() && m_MemoryUsage + needed > m_Capacity)
+    {
+    BlockMapType::iterator it = m_Blocks.find(m_LRU.back());
+    m_MemoryUsage -= it->second.data.size();
+    m_Blocks.erase(it);
+    m_LRU.pop_back();
+    ++m_NumberOfEvictions;
+    }
+}
+
+void
+ImageIOBlockCache
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Layout: " << m_Layout << std::endl;
+  os << indent << "Capacity: " << m_Capacity << " bytes" << std::endl;
+  os << indent << "MemoryUsage: " << m_MemoryUsage << " bytes" << std::endl;
+  os << indent << "NumberOfBlocks: " << m_Blocks.size() << std::endl;
+  os << indent << "NumberOfHits: " << m_NumberOfHits << std::endl;
+  os << indent << "NumberOfMisses: " << m_NumberOfMisses << std::endl;
+  os << indent << "NumberOfEvictions: " << m_NumberOfEvictions << std::endl;
+  os << indent << "HitRate: " << this->GetHitRate() << std::endl;
+}
+
+} // end namespace otb
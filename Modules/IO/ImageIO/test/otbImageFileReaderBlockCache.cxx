@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbVectorImage.h"
+#include "otbImageFileReader.h"
+#include "otbPipelineMemoryPrintCalculator.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <cstdlib>
+#include <iostream>
+
+// Read a sequence of overlapping regions with and without the block
+// cache, and check that both readers give the same pixels, that the
+// overlaps are served from the cache and that the cache is declared to
+// the pipeline memory print calculator.
+int otbImageFileReaderBlockCache(int itkNotUsed(argc), char* argv[])
+{
+  const char *       inputFilename = argv[1];
+  const unsigned int cacheSizeInMB = atoi(argv[2]);
+
+  typedef otb::VectorImage<double, 2>            ImageType;
+  typedef otb::ImageFileReader<ImageType>        ReaderType;
+  typedef itk::ImageRegionConstIterator<ImageType> IteratorType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(inputFilename);
+  reader->UpdateOutputInformation();
+
+  ReaderType::Pointer cachedReader = ReaderType::New();
+  cachedReader->SetFileName(inputFilename);
+  cachedReader->UseBlockCacheOn();
+  cachedReader->SetBlockCacheSizeInMB(cacheSizeInMB);
+  cachedReader->UpdateOutputInformation();
+
+  typedef otb::PipelineMemoryPrintCalculator CalculatorType;
+  CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetDataToWrite(reader->GetOutput());
+  calculator->Compute();
+  if (calculator->GetReservedMemoryPrint() != 0)
+    {
+    std::cerr << "Memory reserved without cache: " << calculator->GetReservedMemoryPrint() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  calculator->SetDataToWrite(cachedReader->GetOutput());
+  calculator->Compute();
+  if (calculator->GetReservedMemoryPrint() != static_cast<CalculatorType::MemoryPrintType>(cacheSizeInMB) * 1024 * 1024)
+    {
+    std::cerr << "Memory reserved with a " << cacheSizeInMB << " MB cache: "
+              << calculator->GetReservedMemoryPrint() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const ImageType::RegionType largest = reader->GetOutput()->GetLargestPossibleRegion();
+
+  ImageType::SizeType size;
+  size[0] = largest.GetSize()[0] / 3 + 1;
+  size[1] = largest.GetSize()[1] / 3 + 1;
+
+  unsigned int nbRegions = 0;
+  for (unsigned long y = 0; y + size[1] <= largest.GetSize()[1]; y += size[1] / 2)
+    {
+    for (unsigned long x = 0; x + size[0] <= largest.GetSize()[0]; x += size[0] / 2)
+      {
+      ImageType::IndexType index;
+      index[0] = x;
+      index[1] = y;
+      ImageType::RegionType region(index, size);
+
+      reader->GetOutput()->SetRequestedRegion(region);
+      reader->GetOutput()->Update();
+      cachedReader->GetOutput()->SetRequestedRegion(region);
+      cachedReader->GetOutput()->Update();
+
+      IteratorType it(reader->GetOutput(), region);
+      IteratorType cachedIt(cachedReader->GetOutput(), region);
+      for (it.GoToBegin(), cachedIt.GoToBegin(); !it.IsAtEnd(); ++it, ++cachedIt)
+        {
+        if (it.Get() != cachedIt.Get())
+          {
+          std::cerr << "Pixel " << it.GetIndex() << " differs: " << it.Get()
+                    << " (no cache) vs " << cachedIt.Get() << " (cache)" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      ++nbRegions;
+      }
+    }
+
+  const otb::ImageIOBlockCache * cache = cachedReader->GetBlockCache();
+  std::cout << nbRegions << " regions read, " << cache->GetNumberOfHits() << " hits, "
+            << cache->GetNumberOfMisses() << " misses, "
+            << cache->GetNumberOfEvictions() << " evictions, hit rate "
+            << cache->GetHitRate() << std::endl;
+
+  if (cache->GetNumberOfHits() == 0)
+    {
+    std::cerr << "Overlapping regions were not served from the cache" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (cache->GetMemoryUsage() > cache->GetCapacity())
+    {
+    std::cerr << "Cache exceeds its capacity" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
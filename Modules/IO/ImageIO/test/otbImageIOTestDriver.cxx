@@ -24,6 +24,7 @@ void RegisterTests()
 {
   REGISTER_TEST(otbImageFileWriterWithExtendedOptionBox);
   REGISTER_TEST(otbImageFileReaderONERAComplex);
+  REGISTER_TEST(otbImageFileReaderBlockCache);
   REGISTER_TEST(otbImageFileReaderRADComplexFloat);
   REGISTER_TEST(otbShortRGBImageIOTest);
   REGISTER_TEST(otbPipelineMetadataHandlingWithUFFilterTest);
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbSarDeburstCalibrationImageFilter_h
+#define otbSarDeburstCalibrationImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "otbSarDeburstImageFilter.h"
+#include "otbSarRadiometricCalibrationFunction.h"
+
+namespace otb
+{
+/** \class SarDeburstCalibrationImageFilter
+ * \brief Performs the radiometric calibration and the deburst of a SAR image in a single pass
+ *
+ * This filter produces the same output as a
+ * SarRadiometricCalibrationToImageFilter followed by a
+ * SarDeburstImageFilter, without allocating the intermediate
+ * calibrated image. Each output line is mapped to its input line with
+ * the line records of the deburst operation, and the whole line is
+ * calibrated at once with
+ * SarRadiometricCalibrationFunction::EvaluateLine(), so that the
+ * calibration lookup data is searched once per line instead of once
+ * per pixel.
+ *
+ * Calibration is done in the input geometry, so the calibration
+ * metadata of the input image is used as is. The output keyword list
+ * is the deburst one.
+ *
+ * Note that currently only Sentinel1 IW SLC products are supported.
+ *
+ * \see SarDeburstImageFilter
+ * \see SarRadiometricCalibrationToImageFilter
+ *
+ * \ingroup OTBSARCalibration
+ */
+
+template <class TInputImage, class TOutputImage>
+class ITK_EXPORT SarDeburstCalibrationImageFilter :
+    public itk::ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef SarDeburstCalibrationImageFilter                        Self;
+  typedef itk::ImageToImageFilter<TInputImage, TOutputImage>      Superclass;
+  typedef itk::SmartPointer<Self>                                 Pointer;
+  typedef itk::SmartPointer<const Self>                           ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(SarDeburstCalibrationImageFilter, ImageToImageFilter);
+
+  /** Some typedefs. */
+  typedef TInputImage                                   InputImageType;
+  typedef typename InputImageType::RegionType           InputImageRegionType;
+  typedef typename InputImageType::IndexType            InputImageIndexType;
+  typedef typename InputImageType::PointType            PointType;
+  typedef TOutputImage                                  OutputImageType;
+  typedef typename OutputImageType::RegionType          OutputImageRegionType;
+  typedef typename OutputImageType::IndexType           OutputImageIndexType;
+  typedef typename OutputImageType::PixelType           OutputImagePixelType;
+
+  typedef SarRadiometricCalibrationFunction<InputImageType> FunctionType;
+  typedef typename FunctionType::Pointer                    FunctionPointer;
+  typedef typename FunctionType::OutputType                 FunctionValueType;
+
+  typedef SarDeburstImageFilter<InputImageType>             DeburstFilterType;
+  typedef typename DeburstFilterType::Pointer               DeburstFilterPointer;
+  typedef typename DeburstFilterType::LinesRecordVectorType LinesRecordVectorType;
+
+  /** Enable/disable the noise flag in SarRadiometricCalibrationFunction */
+  void SetEnableNoise(bool inArg)
+  {
+    m_Function->SetEnableNoise(inArg);
+    this->Modified();
+  }
+
+  itkSetMacro(LookupSelected, short);
+  itkGetConstMacro(LookupSelected, short);
+
+  /** Enable/disable the precomputation of the parametric terms on a coarse
+   *  grid, once per stream */
+  void SetUseCorrectionGrid(bool inArg)
+  {
+    m_Function->SetUseCorrectionGrid(inArg);
+    this->Modified();
+  }
+
+protected:
+  /** Default constructor */
+  SarDeburstCalibrationImageFilter();
+
+  /** Destructor */
+  ~SarDeburstCalibrationImageFilter() ITK_OVERRIDE {}
+
+  /** Output size, origin and keyword list are the deburst ones */
+  void GenerateOutputInformation() ITK_OVERRIDE;
+
+  /** Needs to be re-implemented since size of output is modified */
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  /** Set up the calibration function from the input metadata */
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Calibrate and deburst the output region line by line */
+  void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                            itk::ThreadIdType threadId) ITK_OVERRIDE;
+
+  /** Compute the input line index of a given output line index */
+  long OutputLineToInputLine(long outputLine) const;
+
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+private:
+  SarDeburstCalibrationImageFilter(const Self&); // purposely not implemented
+  void operator=(const Self &); // purposely not implemented
+
+  FunctionPointer       m_Function;
+
+  DeburstFilterPointer  m_DeburstFilter;
+
+  LinesRecordVectorType m_LinesRecord;
+
+  short                 m_LookupSelected;
+};
+
+} // End namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbSarDeburstCalibrationImageFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbSarDeburstCalibrationImageFilter_txx
+#define otbSarDeburstCalibrationImageFilter_txx
+
+#include "otbSarDeburstCalibrationImageFilter.h"
+
+#include "otbSarSensorModelAdapter.h"
+#include "itkImageScanlineIterator.h"
+#include "itkProgressReporter.h"
+
+namespace otb
+{
+/**
+ * Constructor
+ */
+template <class TInputImage, class TOutputImage>
+SarDeburstCalibrationImageFilter<TInputImage, TOutputImage>
+::SarDeburstCalibrationImageFilter()
+  : m_LinesRecord(),
+    m_LookupSelected(0)
+{
+  m_Function = FunctionType::New();
+  m_DeburstFilter = DeburstFilterType::New();
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SarDeburstCalibrationImageFilter<TInputImage, TOutputImage>
+::GenerateOutputInformation()
+{
+  // Call superclass implementation
+  Superclass::GenerateOutputInformation();
+
+  const InputImageType * inputPtr = this->GetInput();
+  OutputImageType * outputPtr = this->GetOutput();
+
+  // The deburst geometry (line records, origin, size and sensor model)
+  // is computed by the deburst filter
+  m_DeburstFilter->SetInput(inputPtr);
+  m_DeburstFilter->UpdateOutputInformation();
+
+  const InputImageType * deburstPtr = m_DeburstFilter->GetOutput();
+
+  m_LinesRecord = m_DeburstFilter->GetLinesRecord();
+
+  outputPtr->SetOrigin(deburstPtr->GetOrigin());
+  outputPtr->SetLargestPossibleRegion(deburstPtr->GetLargestPossibleRegion());
+  outputPtr->SetImageKeywordList(deburstPtr->GetImageKeywordlist());
+}
+
+template <class TInputImage, class TOutputImage>
+long
+SarDeburstCalibrationImageFilter<TInputImage, TOutputImage>
+::OutputLineToInputLine(long outputLine) const
+{
+  OutputImageIndexType outputIndex;
+  outputIndex.Fill(0);
+  outputIndex[1] = outputLine;
+
+  typename OutputImageType::PointType outputPoint;
+  this->GetOutput()->TransformIndexToPhysicalPoint(outputIndex, outputPoint);
+
+  unsigned long deburstLine = static_cast<unsigned long>(outputPoint[1] - 0.5);
+  unsigned long imageLine = 0;
+
+  SarSensorModelAdapter::DeburstLineToImageLine(m_LinesRecord, deburstLine, imageLine);
+
+  long originOffset = static_cast<long>(this->GetInput()->GetOrigin()[1] - 0.5);
+
+  return static_cast<long>(imageLine) - originOffset;
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SarDeburstCalibrationImageFilter<TInputImage, TOutputImage>
+::GenerateInputRequestedRegion()
+{
+  const OutputImageRegionType outputRequestedRegion = this->GetOutput()->GetRequestedRegion();
+
+  // Kept lines are sorted, so the first and last requested lines
+  // bound the input region
+  long firstInputLine = OutputLineToInputLine(outputRequestedRegion.GetIndex()[1]);
+  long lastInputLine = OutputLineToInputLine(outputRequestedRegion.GetIndex()[1]
+                                             + outputRequestedRegion.GetSize()[1] - 1);
+
+  InputImageRegionType inputRequestedRegion;
+  typename InputImageRegionType::IndexType index;
+  typename InputImageRegionType::SizeType size;
+
+  index[0] = outputRequestedRegion.GetIndex()[0];
+  index[1] = firstInputLine;
+  size[0] = outputRequestedRegion.GetSize()[0];
+  size[1] = lastInputLine - firstInputLine + 1;
+
+  inputRequestedRegion.SetIndex(index);
+  inputRequestedRegion.SetSize(size);
+
+  InputImageType * inputPtr = const_cast<InputImageType *>(this->GetInput());
+
+  inputPtr->SetRequestedRegion(inputRequestedRegion);
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SarDeburstCalibrationImageFilter<TInputImage, TOutputImage>
+::BeforeThreadedGenerateData()
+{
+  m_Function->SetInputImage(this->GetInput());
+  m_Function->InitializeFromMetadata(m_LookupSelected);
+  m_Function->ComputeCorrectionGrid(this->GetInput()->GetRequestedRegion());
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SarDeburstCalibrationImageFilter<TInputImage, TOutputImage>
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                       itk::ThreadIdType threadId)
+{
+  itk::ImageScanlineIterator<OutputImageType> outputIt(this->GetOutput(), outputRegionForThread);
+
+  // Calibrated values of the current line
+  std::vector<FunctionValueType> values(outputRegionForThread.GetSize()[0]);
+
+  // support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetSize()[1]);
+
+  outputIt.GoToBegin();
+
+  while (!outputIt.IsAtEnd())
+    {
+    const OutputImageIndexType outputIndex = outputIt.GetIndex();
+
+    InputImageIndexType inputIndex;
+    inputIndex[0] = outputIndex[0];
+    inputIndex[1] = OutputLineToInputLine(outputIndex[1]);
+
+    m_Function->EvaluateLine(inputIndex, values);
+
+    typename std::vector<FunctionValueType>::const_iterator valueIt = values.begin();
+
+    for (; !outputIt.IsAtEndOfLine(); ++outputIt, ++valueIt)
+      {
+      outputIt.Set(static_cast<OutputImagePixelType>(*valueIt));
+      }
+
+    outputIt.NextLine();
+    progress.CompletedPixel();
+    }
+}
+
+template <class TInputImage, class TOutputImage>
+void
+SarDeburstCalibrationImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "LookupSelected: " << m_LookupSelected << std::endl;
+  os << indent << "Number of line records: " << m_LinesRecord.size() << std::endl;
+}
+
+} // End namespace otb
+
+#endif
@@ -64,6 +64,9 @@ public:
 
   typedef std::pair<unsigned long, unsigned long> LinesRecordType;
   typedef std::vector<LinesRecordType>            LinesRecordVectorType;
+
+  /** Get the line records computed by GenerateOutputInformation() */
+  itkGetConstReferenceMacro(LinesRecord, LinesRecordVectorType);
   
 protected:
   // Constructor
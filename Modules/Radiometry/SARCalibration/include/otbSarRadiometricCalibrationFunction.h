@@ -24,6 +24,9 @@
 #include "otbSarParametricMapFunction.h"
 #include "otbSarCalibrationLookupData.h"
 #include "otbMath.h"
+
+#include <vector>
+
 namespace otb
 {
 /**
@@ -69,6 +72,7 @@ public:
   typedef typename Superclass::IndexType           IndexType;
   typedef typename Superclass::ContinuousIndexType ContinuousIndexType;
   typedef typename Superclass::PointType           PointType;
+  typedef typename InputImageType::RegionType      RegionType;
 
   itkStaticConstMacro(ImageDimension, unsigned int, InputImageType::ImageDimension);
 
@@ -99,6 +103,13 @@ public:
     return this->EvaluateAtIndex(index);
   }
 
+  /** Evaluate the function on size pixels of a line, starting at index. The
+   *  result is the same as EvaluateAtIndex() on each pixel, but the lookup
+   *  data is interpolated once for the whole line. If a correction grid has
+   *  been computed, the parametric terms are interpolated from it. The
+   *  pixels must lie inside the buffer */
+  void EvaluateLine(const IndexType& index, std::vector<OutputType>& values) const;
+
   /** Set the input image.
    * \warning this method caches BufferedRegion information.
    * If the BufferedRegion has changed, user must call
@@ -166,6 +177,39 @@ public:
     m_Lut = lut;
   }
 
+  /** Set the flags, the parametric functions and the lookup data from the
+   *  metadata of the input image, which must be set. lookupSelected is one of
+   *  SarCalibrationLookupData::SIGMA, BETA, GAMMA or DN */
+  void InitializeFromMetadata(short lookupSelected);
+
+  /** Get/Set the flag to precompute the parametric terms (noise, antenna
+   *  pattern gain, incidence angle and range spread loss) on a coarse grid */
+  itkSetMacro(UseCorrectionGrid, bool);
+  itkGetMacro(UseCorrectionGrid, bool);
+
+  /** Get/Set the initial step (in pixels) of the correction grid */
+  itkSetMacro(CorrectionGridStep, unsigned int);
+  itkGetMacro(CorrectionGridStep, unsigned int);
+
+  /** Get/Set the maximum relative error allowed between the interpolated
+   *  and the exact parametric terms */
+  itkSetMacro(CorrectionGridTolerance, RealType);
+  itkGetMacro(CorrectionGridTolerance, RealType);
+
+  /** Step of the correction grid actually used, 0 if the parametric terms
+   *  are evaluated exactly */
+  itkGetConstMacro(ActualCorrectionGridStep, unsigned int);
+
+  /** Precompute the parametric terms over region, once per stream. The grid
+   *  step starts at CorrectionGridStep and is halved until the interpolated
+   *  terms match the exact ones at the center of each cell. If no step
+   *  fits, the terms are evaluated exactly. Nothing is done if
+   *  UseCorrectionGrid is off or no parametric term applies. */
+  void ComputeCorrectionGrid(const RegionType& region);
+
+  /** Release the correction grid */
+  void ClearCorrectionGrid();
+
 protected:
 
   /** ctor */
@@ -179,6 +223,13 @@ protected:
 
   /** Flags to indicate if these values needs to be applied in calibration*/
 
+  /** Exact evaluation of the subtracted noise and of the product of the
+   *  multiplicative parametric terms at point */
+  void EvaluateParametricTerms(const PointType& point, RealType& noise, RealType& gain) const;
+
+  /** Bilinear interpolation of the correction grid at index */
+  void InterpolateCorrectionGrid(const IndexType& index, RealType& noise, RealType& gain) const;
+
 private:
   SarRadiometricCalibrationFunction(const Self &);  //purposely not implemented
   void operator =(const Self&);  //purposely not implemented
@@ -198,6 +249,17 @@ private:
   ParametricFunctionPointer   m_RangeSpreadLoss;
   LookupDataPointer   m_Lut;
 
+  bool                        m_UseCorrectionGrid;
+  unsigned int                m_CorrectionGridStep;
+  RealType                    m_CorrectionGridTolerance;
+
+  /** Correction grid: nodes are at m_GridOrigin + (i, j) * step */
+  unsigned int                m_ActualCorrectionGridStep;
+  IndexType                   m_GridOrigin;
+  unsigned long               m_GridSize[2];
+  std::vector<RealType>       m_NoiseGrid;
+  std::vector<RealType>       m_GainGrid;
+
 
 };
 
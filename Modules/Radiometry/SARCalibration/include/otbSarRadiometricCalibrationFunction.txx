@@ -23,8 +23,11 @@
 #define otbSarRadiometricCalibrationFunction_txx
 
 #include "otbSarRadiometricCalibrationFunction.h"
+#include "otbSarImageMetadataInterfaceFactory.h"
 #include "itkNumericTraits.h"
 
+#include <algorithm>
+
 namespace otb
 {
 /**
@@ -41,6 +44,10 @@ SarRadiometricCalibrationFunction<TInputImage, TCoordRep>
 , m_ApplyRangeSpreadLossCorrection(true)
 , m_ApplyLookupDataCorrection(false)
 , m_ApplyRescalingFactor(false)
+, m_UseCorrectionGrid(false)
+, m_CorrectionGridStep(16)
+, m_CorrectionGridTolerance(1e-4)
+, m_ActualCorrectionGridStep(0)
 
 {
   /* initialize parametric functions */
@@ -57,6 +64,10 @@ SarRadiometricCalibrationFunction<TInputImage, TCoordRep>
   m_IncidenceAngle->SetConstantValue(CONST_PI_2);
   m_RangeSpreadLoss->SetConstantValue(1.0);
 
+  m_GridOrigin.Fill(0);
+  m_GridSize[0] = 0;
+  m_GridSize[1] = 0;
+
 //  m_Lut = 0; //new LookupTableBase();
 
 }
@@ -172,6 +183,336 @@ SarRadiometricCalibrationFunction<TInputImage, TCoordRep>
   return static_cast<OutputType>(sigma);
 }
 
+template <class TInputImage, class TCoordRep>
+void
+SarRadiometricCalibrationFunction<TInputImage, TCoordRep>
+::InitializeFromMetadata(short lookupSelected)
+{
+  // A previous correction grid does not match the new parameters
+  this->ClearCorrectionGrid();
+
+  /** cretate a SarImageMetadataInterface instance from
+   * GetMetaDataDictionary(). This will return the appropriate IMI depending on
+   * the Sensor information & co available in GetMetaDataDictionary()  */
+  SarImageMetadataInterface::Pointer imageMetadataInterface = SarImageMetadataInterfaceFactory::CreateIMI(
+      this->GetInputImage()->GetMetaDataDictionary());
+
+  /** check if there is a calibration lookupdata is available with the
+    * product. eg. Sentinel1. This means
+    * A. The computation of the backscatter is based on this lookup value which
+    * depends on the given product.*
+    * B. The other value such as antenna pattern gain, rangespread loss, incidence
+    * angle has no effect in calibration  */
+
+  bool apply = imageMetadataInterface->HasCalibrationLookupDataFlag();
+  /* Below lines will toggle the necessary flags which can help skip some
+   * computation. For example, if there is lookup value and ofcourse antenna
+   * pattern gain is not required. Even if we try to compute the value with
+   * SarParametricFunction we  get 1. This is the safe side. But as we are so sure
+   * we skip all those calls to EvaluateParametricCoefficient and also the
+   * Evaluate(). For the function the value is 1 by default.
+   */
+  this->SetApplyAntennaPatternGain(!apply);
+  this->SetApplyIncidenceAngleCorrection(!apply);
+  this->SetApplyRangeSpreadLossCorrection(!apply);
+  this->SetApplyRescalingFactor(!apply);
+  this->SetApplyLookupDataCorrection(apply);
+
+  this->SetScale(imageMetadataInterface->GetRadiometricCalibrationScale());
+
+  /* Compute noise if enabled */
+  if (m_EnableNoise)
+    {
+    m_Noise->SetPointSet(imageMetadataInterface->GetRadiometricCalibrationNoise());
+    m_Noise->SetPolynomalSize(imageMetadataInterface->GetRadiometricCalibrationNoisePolynomialDegree());
+    m_Noise->EvaluateParametricCoefficient();
+    }
+
+  /* Compute old and new antenna pattern gain */
+  if (m_ApplyAntennaPatternGain)
+    {
+    m_AntennaPatternNewGain->SetPointSet(imageMetadataInterface->GetRadiometricCalibrationAntennaPatternNewGain());
+    m_AntennaPatternNewGain->SetPolynomalSize(imageMetadataInterface->GetRadiometricCalibrationAntennaPatternNewGainPolynomialDegree());
+    m_AntennaPatternNewGain->EvaluateParametricCoefficient();
+
+    m_AntennaPatternOldGain->SetPointSet(imageMetadataInterface->GetRadiometricCalibrationAntennaPatternOldGain());
+    m_AntennaPatternOldGain->SetPolynomalSize(imageMetadataInterface->GetRadiometricCalibrationAntennaPatternOldGainPolynomialDegree());
+    m_AntennaPatternOldGain->EvaluateParametricCoefficient();
+    }
+
+  /* Compute incidence angle */
+  if (m_ApplyIncidenceAngleCorrection)
+    {
+    m_IncidenceAngle->SetPointSet(imageMetadataInterface->GetRadiometricCalibrationIncidenceAngle());
+    m_IncidenceAngle->SetPolynomalSize(imageMetadataInterface->GetRadiometricCalibrationIncidenceAnglePolynomialDegree());
+    m_IncidenceAngle->EvaluateParametricCoefficient();
+    }
+
+  /* Compute Range spread Loss */
+  if (m_ApplyRangeSpreadLossCorrection)
+    {
+    m_RangeSpreadLoss->SetPointSet(imageMetadataInterface->GetRadiometricCalibrationRangeSpreadLoss());
+    m_RangeSpreadLoss->SetPolynomalSize(imageMetadataInterface->GetRadiometricCalibrationRangeSpreadLossPolynomialDegree());
+    m_RangeSpreadLoss->EvaluateParametricCoefficient();
+    }
+
+  /** Get the lookupdata instance. unlike the all the above this is not a
+   * parametricFunction instance. But rather an internal class in IMI called
+   * SarCalibrationLookupData.
+   *
+   * NOTE: As the computation of lookup data for sensors is not universal. One must
+   * provide a sub-class.
+   * See Also: otbSentinel1ImageMetadataInterface, otbTerraSarImageMetadataInterface,
+   * otbRadarsat2ImageMetadataInterface  */
+  if (m_ApplyLookupDataCorrection)
+    {
+    this->SetCalibrationLookupData(imageMetadataInterface->GetCalibrationLookupData(lookupSelected));
+    }
+
+  /** This was introduced for cosmoskymed which required a rescaling factor */
+  if (m_ApplyRescalingFactor)
+    {
+    this->SetRescalingFactor(imageMetadataInterface->GetRescalingFactor());
+    }
+}
+
+/* Function: EvaluateLine. Same computation as EvaluateAtIndex(), for
+ * consecutive pixels of a line. The lookup values of the line are fetched
+ * at once, so that the search of the lookup vectors is done once per line.
+ * If the line is covered by the correction grid, the parametric terms are
+ * interpolated instead of being evaluated at each pixel */
+template <class TInputImage, class TCoordRep>
+void
+SarRadiometricCalibrationFunction<TInputImage, TCoordRep>
+::EvaluateLine(const IndexType& index, std::vector<OutputType>& values) const
+{
+  const InputImageType * inputPtr = this->GetInputImage();
+
+  std::vector<double> lutValues;
+  if (m_ApplyLookupDataCorrection)
+    {
+    lutValues.resize(values.size());
+    m_Lut->GetLineValues(index[0], index[1], lutValues);
+    }
+
+  bool useGrid = false;
+  if (m_ActualCorrectionGridStep > 0 && !values.empty())
+    {
+    const long step = static_cast<long>(m_ActualCorrectionGridStep);
+    const long lastX = index[0] + static_cast<long>(values.size()) - 1;
+    useGrid = index[0] >= m_GridOrigin[0]
+      && lastX <= m_GridOrigin[0] + static_cast<long>(m_GridSize[0] - 1) * step
+      && index[1] >= m_GridOrigin[1]
+      && index[1] <= m_GridOrigin[1] + static_cast<long>(m_GridSize[1] - 1) * step;
+    }
+
+  const bool needPoint = !useGrid
+    && (m_ApplyAntennaPatternGain || m_ApplyIncidenceAngleCorrection || m_ApplyRangeSpreadLossCorrection);
+
+  IndexType currentIndex = index;
+  PointType point;
+
+  for (std::size_t i = 0; i < values.size(); ++i, ++currentIndex[0])
+    {
+    if (needPoint)
+      inputPtr->TransformIndexToPhysicalPoint(currentIndex, point);
+
+    const std::complex<float> pVal = inputPtr->GetPixel(currentIndex);
+    const RealType digitalNumber = std::sqrt((pVal.real() * pVal.real()) + (pVal.imag()* pVal.imag()));
+
+    RealType sigma = m_Scale * digitalNumber * digitalNumber;
+
+    if (useGrid)
+      {
+      RealType noise, gain;
+      this->InterpolateCorrectionGrid(currentIndex, noise, gain);
+      sigma = (sigma - noise) * gain;
+      }
+    else
+      {
+      if (m_EnableNoise)
+        {
+        sigma  -= static_cast<RealType>(m_Noise->Evaluate(point));
+        }
+
+      if (m_ApplyIncidenceAngleCorrection)
+        {
+        sigma *= vcl_sin(static_cast<RealType>(m_IncidenceAngle->Evaluate(point)));
+        }
+
+      if (m_ApplyAntennaPatternGain)
+        {
+        sigma *= static_cast<RealType>(m_AntennaPatternNewGain->Evaluate(point));
+        sigma /= static_cast<RealType>(m_AntennaPatternOldGain->Evaluate(point));
+        }
+
+      if (m_ApplyRangeSpreadLossCorrection)
+        {
+        sigma *= static_cast<RealType>(m_RangeSpreadLoss->Evaluate(point));
+        }
+      }
+
+    if (m_ApplyLookupDataCorrection)
+      {
+      RealType lutVal = static_cast<RealType>(lutValues[i]);
+      sigma /= lutVal * lutVal;
+      }
+
+    if (m_ApplyRescalingFactor)
+      {
+      sigma /= m_RescalingFactor;
+      }
+
+    if(sigma < 0.0)
+      {
+      sigma = 0.0;
+      }
+
+    values[i] = static_cast<OutputType>(sigma);
+    }
+}
+
+template <class TInputImage, class TCoordRep>
+void
+SarRadiometricCalibrationFunction<TInputImage, TCoordRep>
+::EvaluateParametricTerms(const PointType& point, RealType& noise, RealType& gain) const
+{
+  noise = 0.0;
+  gain = 1.0;
+
+  if (m_EnableNoise)
+    {
+    noise = static_cast<RealType>(m_Noise->Evaluate(point));
+    }
+
+  if (m_ApplyIncidenceAngleCorrection)
+    {
+    gain *= vcl_sin(static_cast<RealType>(m_IncidenceAngle->Evaluate(point)));
+    }
+
+  if (m_ApplyAntennaPatternGain)
+    {
+    gain *= static_cast<RealType>(m_AntennaPatternNewGain->Evaluate(point));
+    gain /= static_cast<RealType>(m_AntennaPatternOldGain->Evaluate(point));
+    }
+
+  if (m_ApplyRangeSpreadLossCorrection)
+    {
+    gain *= static_cast<RealType>(m_RangeSpreadLoss->Evaluate(point));
+    }
+}
+
+template <class TInputImage, class TCoordRep>
+void
+SarRadiometricCalibrationFunction<TInputImage, TCoordRep>
+::InterpolateCorrectionGrid(const IndexType& index, RealType& noise, RealType& gain) const
+{
+  const long step = static_cast<long>(m_ActualCorrectionGridStep);
+  const long dx = index[0] - m_GridOrigin[0];
+  const long dy = index[1] - m_GridOrigin[1];
+
+  // Last node is handled as the end of the previous cell
+  const unsigned long i = std::min(static_cast<unsigned long>(dx / step), m_GridSize[0] - 2);
+  const unsigned long j = std::min(static_cast<unsigned long>(dy / step), m_GridSize[1] - 2);
+
+  const RealType fx = static_cast<RealType>(dx - static_cast<long>(i) * step) / step;
+  const RealType fy = static_cast<RealType>(dy - static_cast<long>(j) * step) / step;
+
+  const unsigned long n00 = j * m_GridSize[0] + i;
+  const unsigned long n10 = n00 + 1;
+  const unsigned long n01 = n00 + m_GridSize[0];
+  const unsigned long n11 = n01 + 1;
+
+  noise = (1 - fy) * ((1 - fx) * m_NoiseGrid[n00] + fx * m_NoiseGrid[n10])
+    +           fy * ((1 - fx) * m_NoiseGrid[n01] + fx * m_NoiseGrid[n11]);
+  gain  = (1 - fy) * ((1 - fx) * m_GainGrid[n00] + fx * m_GainGrid[n10])
+    +           fy * ((1 - fx) * m_GainGrid[n01] + fx * m_GainGrid[n11]);
+}
+
+template <class TInputImage, class TCoordRep>
+void
+SarRadiometricCalibrationFunction<TInputImage, TCoordRep>
+::ClearCorrectionGrid()
+{
+  m_ActualCorrectionGridStep = 0;
+  m_GridSize[0] = 0;
+  m_GridSize[1] = 0;
+  m_NoiseGrid.clear();
+  m_GainGrid.clear();
+}
+
+template <class TInputImage, class TCoordRep>
+void
+SarRadiometricCalibrationFunction<TInputImage, TCoordRep>
+::ComputeCorrectionGrid(const RegionType& region)
+{
+  this->ClearCorrectionGrid();
+
+  const bool parametricTerms = m_EnableNoise || m_ApplyAntennaPatternGain
+    || m_ApplyIncidenceAngleCorrection || m_ApplyRangeSpreadLossCorrection;
+
+  if (!m_UseCorrectionGrid || !parametricTerms || region.GetNumberOfPixels() == 0)
+    {
+    return;
+    }
+
+  const InputImageType * inputPtr = this->GetInputImage();
+
+  IndexType nodeIndex;
+  PointType point;
+
+  for (unsigned int step = m_CorrectionGridStep; step > 1; step /= 2)
+    {
+    // Nodes cover the region, the last ones may lie outside of it
+    m_ActualCorrectionGridStep = step;
+    m_GridOrigin = region.GetIndex();
+    m_GridSize[0] = (region.GetSize()[0] - 1) / step + 2;
+    m_GridSize[1] = (region.GetSize()[1] - 1) / step + 2;
+    m_NoiseGrid.resize(m_GridSize[0] * m_GridSize[1]);
+    m_GainGrid.resize(m_GridSize[0] * m_GridSize[1]);
+
+    for (unsigned long j = 0; j < m_GridSize[1]; ++j)
+      {
+      for (unsigned long i = 0; i < m_GridSize[0]; ++i)
+        {
+        nodeIndex[0] = m_GridOrigin[0] + static_cast<long>(i * step);
+        nodeIndex[1] = m_GridOrigin[1] + static_cast<long>(j * step);
+        inputPtr->TransformIndexToPhysicalPoint(nodeIndex, point);
+        this->EvaluateParametricTerms(point, m_NoiseGrid[j * m_GridSize[0] + i], m_GainGrid[j * m_GridSize[0] + i]);
+        }
+      }
+
+    // Check the interpolation at the center of each cell, where the error
+    // of a bilinear interpolation is the largest
+    bool valid = true;
+    for (unsigned long j = 0; valid && j + 1 < m_GridSize[1]; ++j)
+      {
+      for (unsigned long i = 0; valid && i + 1 < m_GridSize[0]; ++i)
+        {
+        nodeIndex[0] = m_GridOrigin[0] + static_cast<long>(i * step + step / 2);
+        nodeIndex[1] = m_GridOrigin[1] + static_cast<long>(j * step + step / 2);
+        inputPtr->TransformIndexToPhysicalPoint(nodeIndex, point);
+
+        RealType exactNoise, exactGain, noise, gain;
+        this->EvaluateParametricTerms(point, exactNoise, exactGain);
+        this->InterpolateCorrectionGrid(nodeIndex, noise, gain);
+
+        valid = vcl_abs(noise - exactNoise) <= m_CorrectionGridTolerance * vcl_abs(exactNoise)
+          && vcl_abs(gain - exactGain) <= m_CorrectionGridTolerance * vcl_abs(exactGain);
+        }
+      }
+
+    if (valid)
+      {
+      itkDebugMacro(<< "Correction grid step: " << step);
+      return;
+      }
+    }
+
+  // No grid is accurate enough, parametric terms will be evaluated exactly
+  this->ClearCorrectionGrid();
+}
+
 } // end namespace otb
 
 #endif
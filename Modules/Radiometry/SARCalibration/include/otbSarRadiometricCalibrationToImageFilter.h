@@ -107,6 +107,29 @@ public:
   itkSetMacro(LookupSelected, short);
   itkGetConstMacro(LookupSelected, short);
 
+  /** Enable/disable the precomputation of the parametric terms on a coarse
+   *  grid, once per stream. See
+   *  SarRadiometricCalibrationFunction::ComputeCorrectionGrid() */
+  void SetUseCorrectionGrid(bool inArg)
+  {
+    this->GetFunction()->SetUseCorrectionGrid(inArg);
+    this->Modified();
+  }
+
+  /** Set the initial step of the correction grid */
+  void SetCorrectionGridStep(unsigned int inArg)
+  {
+    this->GetFunction()->SetCorrectionGridStep(inArg);
+    this->Modified();
+  }
+
+  /** Set the relative tolerance of the correction grid */
+  void SetCorrectionGridTolerance(double inArg)
+  {
+    this->GetFunction()->SetCorrectionGridTolerance(inArg);
+    this->Modified();
+  }
+
 protected:
   /** Default ctor */
   SarRadiometricCalibrationToImageFilter();
@@ -120,6 +143,10 @@ protected:
   /** Update the function list and input parameters*/
   void BeforeThreadedGenerateData() ITK_OVERRIDE;
 
+  /** Calibrate the output region line by line */
+  void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                            itk::ThreadIdType threadId) ITK_OVERRIDE;
+
 private:
 
   SarRadiometricCalibrationToImageFilter(const Self &); //purposely not implemented
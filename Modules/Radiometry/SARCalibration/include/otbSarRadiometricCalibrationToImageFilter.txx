@@ -25,6 +25,8 @@
 #include "otbSarRadiometricCalibrationToImageFilter.h"
 #include "otbSarImageMetadataInterfaceFactory.h"
 #include "otbSarCalibrationLookupData.h"
+#include "itkImageScanlineIterator.h"
+#include "itkProgressReporter.h"
 
 namespace otb
 {
@@ -72,101 +74,44 @@ SarRadiometricCalibrationToImageFilter<TInputImage, TOutputImage>
   // will SetInputImage on the function
   Superclass::BeforeThreadedGenerateData();
 
-  /** cretate a SarImageMetadataInterface instance from
-   * GetMetaDataDictionary(). This will return the appropriate IMI depending on
-   * the Sensor information & co available in GetMetaDataDictionary()  */
-  SarImageMetadataInterface::Pointer imageMetadataInterface = SarImageMetadataInterfaceFactory::CreateIMI(
-      this->GetInput()->GetMetaDataDictionary());
-
-  /** Get the SarRadiometricCalibrationFunction function instance.  */
-  FunctionPointer function = this->GetFunction();
-
-  /** check if there is a calibration lookupdata is available with the
-    * product. eg. Sentinel1. This means
-    * A. The computation of the backscatter is based on this lookup value which
-    * depends on the given product.*
-    * B. The other value such as antenna pattern gain, rangespread loss, incidence
-    * angle has no effect in calibration  */
-
-  bool apply = imageMetadataInterface->HasCalibrationLookupDataFlag();
-  /* Below lines will toggle the necessary flags which can help skip some
-   * computation. For example, if there is lookup value and ofcourse antenna
-   * pattern gain is not required. Even if we try to compute the value with
-   * SarParametricFunction we  get 1. This is the safe side. But as we are so sure
-   * we skip all those calls to EvaluateParametricCoefficient and also the
-   * Evaluate(). For the function the value is 1 by default.
-   */
-  function->SetApplyAntennaPatternGain(!apply);
-  function->SetApplyIncidenceAngleCorrection(!apply);
-  function->SetApplyRangeSpreadLossCorrection(!apply);
-  function->SetApplyRescalingFactor(!apply);
-  function->SetApplyLookupDataCorrection(apply);
-
-  function->SetScale(imageMetadataInterface->GetRadiometricCalibrationScale());
-
-  /* Compute noise if enabled */
-  if( function->GetEnableNoise())
-    {
-    ParametricFunctionPointer   noise;
-    noise = function->GetNoise();
-    noise->SetPointSet(imageMetadataInterface->GetRadiometricCalibrationNoise());
-    noise->SetPolynomalSize(imageMetadataInterface->GetRadiometricCalibrationNoisePolynomialDegree());
-    noise->EvaluateParametricCoefficient();
-    }
+  /** Set the calibration flags, the parametric functions and the lookup
+   * data of the function from the input metadata. */
+  this->GetFunction()->InitializeFromMetadata(this->GetLookupSelected());
 
-  /* Compute old and new antenna pattern gain */
-  if(function->GetApplyAntennaPatternGain())
-    {
-    ParametricFunctionPointer   antennaPatternNewGain;
-    antennaPatternNewGain = function->GetAntennaPatternNewGain();
-    antennaPatternNewGain->SetPointSet(imageMetadataInterface->GetRadiometricCalibrationAntennaPatternNewGain());
-    antennaPatternNewGain->SetPolynomalSize(imageMetadataInterface->GetRadiometricCalibrationAntennaPatternNewGainPolynomialDegree());
-    antennaPatternNewGain->EvaluateParametricCoefficient();
-
-    ParametricFunctionPointer   antennaPatternOldGain;
-    antennaPatternOldGain = function->GetAntennaPatternOldGain();
-    antennaPatternOldGain->SetPointSet(imageMetadataInterface->GetRadiometricCalibrationAntennaPatternOldGain());
-    antennaPatternOldGain->SetPolynomalSize(imageMetadataInterface->GetRadiometricCalibrationAntennaPatternOldGainPolynomialDegree());
-    antennaPatternOldGain->EvaluateParametricCoefficient();
-    }
+  /** Precompute the parametric terms over the requested region, if enabled */
+  this->GetFunction()->ComputeCorrectionGrid(this->GetOutput()->GetRequestedRegion());
+}
 
-  /* Compute incidence angle */
-  if (function->GetApplyIncidenceAngleCorrection())
-    {
-    ParametricFunctionPointer   incidenceAngle;
-    incidenceAngle = function->GetIncidenceAngle();
-    incidenceAngle->SetPointSet(imageMetadataInterface->GetRadiometricCalibrationIncidenceAngle());
-    incidenceAngle->SetPolynomalSize(imageMetadataInterface->GetRadiometricCalibrationIncidenceAnglePolynomialDegree());
-    incidenceAngle->EvaluateParametricCoefficient();
-    }
+template<class TInputImage, class TOutputImage>
+void
+SarRadiometricCalibrationToImageFilter<TInputImage, TOutputImage>
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+                       itk::ThreadIdType threadId)
+{
+  const FunctionType * function = this->GetFunction();
 
-    /* Compute Range spread Loss */
-  if (function->GetApplyRangeSpreadLossCorrection())
-    {
-    ParametricFunctionPointer   rangeSpreadLoss;
-    rangeSpreadLoss = function->GetRangeSpreadLoss();
-    rangeSpreadLoss->SetPointSet(imageMetadataInterface->GetRadiometricCalibrationRangeSpreadLoss());
-    rangeSpreadLoss->SetPolynomalSize(imageMetadataInterface->GetRadiometricCalibrationRangeSpreadLossPolynomialDegree());
-    rangeSpreadLoss->EvaluateParametricCoefficient();
-    }
+  itk::ImageScanlineIterator<OutputImageType> outputIt(this->GetOutput(), outputRegionForThread);
 
-  /** Get the lookupdata instance. unlike the all the above this is not a
-* parametricFunction instance. But rather an internal class in IMI called
-* SarCalibrationLookupData.
-*
-*NOTE: As the computation of lookup data for sensors is not universal. One must
-*provide a sub-class.
-See Also: otbSentinel1ImageMetadataInterface, otbTerraSarImageMetadataInterface,
-*otbRadarsat2ImageMetadataInterface  */
-  if (function->GetApplyLookupDataCorrection())
-    {
-    function->SetCalibrationLookupData(imageMetadataInterface->GetCalibrationLookupData(this->GetLookupSelected()));
-    }
+  // Calibrated values of the current line
+  std::vector<FunctionValueType> values(outputRegionForThread.GetSize()[0]);
+
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetSize()[1]);
 
-  /** This was introduced for cosmoskymed which required a rescaling factor */
-  if (function->GetApplyRescalingFactor())
+  outputIt.GoToBegin();
+
+  while (!outputIt.IsAtEnd())
     {
-    function->SetRescalingFactor(imageMetadataInterface->GetRescalingFactor());
+    function->EvaluateLine(outputIt.GetIndex(), values);
+
+    typename std::vector<FunctionValueType>::const_iterator valueIt = values.begin();
+
+    for (; !outputIt.IsAtEndOfLine(); ++outputIt, ++valueIt)
+      {
+      outputIt.Set(static_cast<OutputImagePixelType>(*valueIt));
+      }
+
+    outputIt.NextLine();
+    progress.CompletedPixel();
     }
 }
 
@@ -43,4 +43,6 @@ void RegisterTests()
   REGISTER_TEST(otbSarRadiometricCalibrationToImageFilterWithComplexPixelTest);
   REGISTER_TEST(otbSarBrightnessToImageFilterTest);
   REGISTER_TEST(otbSarDeburstFilterTest);
+  REGISTER_TEST(otbSarDeburstCalibrationImageFilterTest);
+  REGISTER_TEST(otbSarRadiometricCalibrationToImageFilterCorrectionGridTest);
 }
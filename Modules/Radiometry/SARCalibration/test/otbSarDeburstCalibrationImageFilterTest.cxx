@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbSarDeburstCalibrationImageFilter.h"
+#include "otbSarRadiometricCalibrationToImageFilter.h"
+#include "otbSarDeburstImageFilter.h"
+#include "otbImage.h"
+#include "otbImageFileReader.h"
+#include "otbImageFileWriter.h"
+
+typedef otb::Image<float>                                                        ImageType;
+typedef otb::ImageFileReader<ImageType>                                          ReaderType;
+typedef otb::ImageFileWriter<ImageType>                                          WriterType;
+typedef otb::SarDeburstCalibrationImageFilter<ImageType, ImageType>              DeburstCalibrationFilterType;
+typedef otb::SarRadiometricCalibrationToImageFilter<ImageType, ImageType>        CalibrationFilterType;
+typedef otb::SarDeburstImageFilter<ImageType>                                    DeburstFilterType;
+
+int otbSarDeburstCalibrationImageFilterTest(int itkNotUsed(argc), char * argv[])
+{
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(argv[1]);
+
+  // Single pass deburst and calibration
+  DeburstCalibrationFilterType::Pointer filter = DeburstCalibrationFilterType::New();
+  filter->SetInput(reader->GetOutput());
+
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(filter->GetOutput());
+  writer->SetFileName(argv[2]);
+  writer->SetNumberOfDivisionsStrippedStreaming(4);
+  writer->Update();
+
+  // Reference: calibration followed by deburst
+  CalibrationFilterType::Pointer calibration = CalibrationFilterType::New();
+  calibration->SetInput(reader->GetOutput());
+
+  DeburstFilterType::Pointer deburst = DeburstFilterType::New();
+  deburst->SetInput(calibration->GetOutput());
+
+  WriterType::Pointer refWriter = WriterType::New();
+  refWriter->SetInput(deburst->GetOutput());
+  refWriter->SetFileName(argv[3]);
+  refWriter->Update();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "otbSarRadiometricCalibrationToImageFilter.h"
+#include "otbImageFileReader.h"
+#include "otbExtractROI.h"
+#include "itkImageRegionConstIterator.h"
+
+int otbSarRadiometricCalibrationToImageFilterCorrectionGridTest(int itkNotUsed(argc), char * argv[])
+{
+  const unsigned int Dimension = 2;
+  typedef float                                                                         RealType;
+  typedef std::complex<RealType>                                                        PixelType;
+  typedef otb::Image<PixelType, Dimension>                                              InputImageType;
+  typedef otb::Image<RealType, Dimension>                                               OutputImageType;
+  typedef otb::ImageFileReader<InputImageType>                                          ReaderType;
+  typedef otb::SarRadiometricCalibrationToImageFilter<InputImageType, OutputImageType>  FilterType;
+  typedef otb::ExtractROI<RealType, RealType>                                           ExtractorType;
+  typedef itk::ImageRegionConstIterator<OutputImageType>                                IteratorType;
+
+  const double tolerance = 1e-4;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(argv[1]);
+
+  // Exact evaluation of the parametric terms
+  FilterType::Pointer exactFilter = FilterType::New();
+  exactFilter->SetInput(reader->GetOutput());
+
+  // Parametric terms interpolated from a grid
+  FilterType::Pointer gridFilter = FilterType::New();
+  gridFilter->SetInput(reader->GetOutput());
+  gridFilter->SetUseCorrectionGrid(true);
+  gridFilter->SetCorrectionGridTolerance(tolerance);
+
+  OutputImageType::RegionType region;
+  OutputImageType::IndexType  id;
+  id[0] = atoi(argv[2]);   id[1] = atoi(argv[3]);
+  OutputImageType::SizeType size;
+  size[0] = atoi(argv[4]);   size[1] = atoi(argv[5]);
+  region.SetIndex(id);
+  region.SetSize(size);
+
+  ExtractorType::Pointer exactExtractor = ExtractorType::New();
+  exactExtractor->SetExtractionRegion(region);
+  exactExtractor->SetInput(exactFilter->GetOutput());
+
+  ExtractorType::Pointer gridExtractor = ExtractorType::New();
+  gridExtractor->SetExtractionRegion(region);
+  gridExtractor->SetInput(gridFilter->GetOutput());
+
+  exactExtractor->Update();
+  gridExtractor->Update();
+
+  // The tolerance must be reachable with a grid on this region
+  const unsigned int gridStep = gridFilter->GetFunction()->GetActualCorrectionGridStep();
+  std::cout << "Correction grid step: " << gridStep << std::endl;
+  if (gridStep == 0)
+    {
+    std::cout << "The parametric terms were evaluated exactly instead of on a grid" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  double maxError = 0.;
+  double maxValue = 0.;
+  IteratorType exactIt(exactExtractor->GetOutput(), exactExtractor->GetOutput()->GetLargestPossibleRegion());
+  IteratorType gridIt(gridExtractor->GetOutput(), gridExtractor->GetOutput()->GetLargestPossibleRegion());
+  for (exactIt.GoToBegin(), gridIt.GoToBegin(); !exactIt.IsAtEnd(); ++exactIt, ++gridIt)
+    {
+    maxError = std::max(maxError, static_cast<double>(vcl_abs(exactIt.Get() - gridIt.Get())));
+    maxValue = std::max(maxValue, static_cast<double>(vcl_abs(exactIt.Get())));
+    }
+
+  // The relative tolerance is checked on the parametric terms at the center
+  // of the grid cells only, where the bilinear interpolation error is the
+  // largest: allow twice the tolerance on the dynamic of the output, for the
+  // other pixels and the float rounding of the output
+  if (maxError > 2 * tolerance * maxValue)
+    {
+    std::cout << "Max error: " << maxError << std::endl;
+    std::cout << "Max value: " << maxValue << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbCoarseToFineDisparityRangeFilter_h
+#define otbCoarseToFineDisparityRangeFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "otbImage.h"
+#include <vector>
+
+namespace otb
+{
+
+/** \class CoarseToFineDisparityRangeFilter
+ *  \brief Derive pixel-wise horizontal disparity ranges from a coarse disparity map
+ *
+ *  This filter is the link between two levels of a coarse-to-fine
+ *  disparity search. Its input is a horizontal disparity map estimated on
+ *  subsampled images (for instance with StreamingShrinkImageFilter and
+ *  PixelWiseBlockMatchingImageFilter). Its outputs are the maps of the
+ *  minimum (output 0) and maximum (output 1) horizontal disparities to
+ *  explore on a finer grid, to be given to
+ *  PixelWiseBlockMatchingImageFilter::SetMinimumHorizontalDisparityInput()
+ *  and SetMaximumHorizontalDisparityInput().
+ *
+ *  The finer grid is set with SetOutputParametersFromImage() (typically the
+ *  left image of the finer level). Each fine pixel is associated to the
+ *  nearest coarse pixel; its range is the extent of the coarse disparities
+ *  in a (2*Radius+1)x(2*Radius+1) neighborhood, scaled by the ratio of the
+ *  spacings, enlarged by Margin fine pixels on both sides, and intersected
+ *  with the global range [MinimumHorizontalDisparity,
+ *  MaximumHorizontalDisparity]. Coarse pixels with a null mask value are
+ *  ignored; a neighborhood without any valid pixel gives the global range.
+ *
+ *  The coarse map is requested as a whole: it is small, and its ranges are
+ *  only computed again when it or the parameters are modified. After an
+ *  update, GetMeanRange() gives the mean number of disparities each fine
+ *  pixel will explore, to be compared with the size of the global range.
+ *
+ *  \sa PixelWiseBlockMatchingImageFilter
+ *  \sa StreamingShrinkImageFilter
+ *
+ *  \ingroup Streamed
+ *  \ingroup Threaded
+ *
+ * \ingroup OTBDisparityMap
+ */
+template <class TDisparityImage, class TOutputImage = TDisparityImage,
+          class TMaskImage = otb::Image<unsigned char> >
+class ITK_EXPORT CoarseToFineDisparityRangeFilter :
+    public itk::ImageToImageFilter<TDisparityImage, TOutputImage>
+{
+public:
+  /** Standard class typedef */
+  typedef CoarseToFineDisparityRangeFilter                       Self;
+  typedef itk::ImageToImageFilter<TDisparityImage, TOutputImage> Superclass;
+  typedef itk::SmartPointer<Self>                                Pointer;
+  typedef itk::SmartPointer<const Self>                          ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(CoarseToFineDisparityRangeFilter, ImageToImageFilter);
+
+  /** Useful typedefs */
+  typedef TDisparityImage                               DisparityImageType;
+  typedef TOutputImage                                  OutputImageType;
+  typedef TMaskImage                                    MaskImageType;
+
+  typedef typename OutputImageType::RegionType          RegionType;
+  typedef typename OutputImageType::PixelType           OutputPixelType;
+
+  typedef itk::ImageBase<OutputImageType::ImageDimension> ImageBaseType;
+  typedef typename ImageBaseType::SpacingType           SpacingType;
+  typedef typename ImageBaseType::SizeType              SizeType;
+  typedef typename ImageBaseType::PointType             PointType;
+  typedef typename ImageBaseType::IndexType             IndexType;
+
+  /** Set the coarse horizontal disparity map */
+  void SetHorizontalDisparityInput(const TDisparityImage * hmap);
+
+  /** Set the mask of the coarse disparity map (optional) */
+  void SetMaskInput(const TMaskImage * mask);
+
+  /** Get the inputs */
+  const TDisparityImage * GetHorizontalDisparityInput() const;
+  const TMaskImage * GetMaskInput() const;
+
+  /** Get the maps of the minimum and maximum horizontal disparities */
+  TOutputImage * GetMinimumHorizontalDisparityOutput();
+  TOutputImage * GetMaximumHorizontalDisparityOutput();
+
+  /** Set/Get the radius (in coarse pixels) of the neighborhood of coarse disparities */
+  itkSetMacro(Radius, unsigned int);
+  itkGetConstReferenceMacro(Radius, unsigned int);
+
+  /** Set/Get the margin (in fine pixels) added on both sides of the ranges */
+  itkSetMacro(Margin, double);
+  itkGetConstReferenceMacro(Margin, double);
+
+  /** Set/Get the global minimum horizontal disparity (in fine pixels) */
+  itkSetMacro(MinimumHorizontalDisparity, int);
+  itkGetConstReferenceMacro(MinimumHorizontalDisparity, int);
+
+  /** Set/Get the global maximum horizontal disparity (in fine pixels) */
+  itkSetMacro(MaximumHorizontalDisparity, int);
+  itkGetConstReferenceMacro(MaximumHorizontalDisparity, int);
+
+  /** Parameters of the fine grid */
+  itkSetMacro(OutputStartIndex, IndexType);
+  itkGetConstReferenceMacro(OutputStartIndex, IndexType);
+
+  itkSetMacro(OutputSize, SizeType);
+  itkGetConstReferenceMacro(OutputSize, SizeType);
+
+  itkSetMacro(OutputOrigin, PointType);
+  itkGetConstReferenceMacro(OutputOrigin, PointType);
+
+  itkSetMacro(OutputSpacing, SpacingType);
+  itkGetConstReferenceMacro(OutputSpacing, SpacingType);
+
+  /** Import the fine grid parameters from a given image */
+  void SetOutputParametersFromImage(const ImageBaseType * image);
+
+  /** Mean number of horizontal disparities to explore per pixel (available after an update) */
+  itkGetConstReferenceMacro(MeanRange, double);
+
+protected:
+  /** Constructor */
+  CoarseToFineDisparityRangeFilter();
+
+  /** Destructor */
+  ~CoarseToFineDisparityRangeFilter() ITK_OVERRIDE {}
+
+  /** Generate output information */
+  void GenerateOutputInformation() ITK_OVERRIDE;
+
+  /** Generate input requested region */
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  /** Computes the ranges of the coarse pixels, if needed */
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Threaded generate data */
+  void ThreadedGenerateData(const RegionType & outputRegionForThread, itk::ThreadIdType threadId) ITK_OVERRIDE;
+
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+private:
+  CoarseToFineDisparityRangeFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  /** Radius of the neighborhood of coarse disparities */
+  unsigned int m_Radius;
+
+  /** Margin added to the ranges */
+  double       m_Margin;
+
+  /** Global horizontal range */
+  int          m_MinimumHorizontalDisparity;
+  int          m_MaximumHorizontalDisparity;
+
+  /** Fine grid */
+  IndexType    m_OutputStartIndex;
+  SizeType     m_OutputSize;
+  PointType    m_OutputOrigin;
+  SpacingType  m_OutputSpacing;
+
+  /** Ranges of the coarse pixels, in fine pixels */
+  std::vector<OutputPixelType> m_CoarseMinimum;
+  std::vector<OutputPixelType> m_CoarseMaximum;
+
+  /** Time of the last computation of the coarse ranges */
+  itk::TimeStamp m_CoarseRangeTime;
+
+  /** Mean number of disparities to explore */
+  double       m_MeanRange;
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbCoarseToFineDisparityRangeFilter.txx"
+#endif
+
+#endif
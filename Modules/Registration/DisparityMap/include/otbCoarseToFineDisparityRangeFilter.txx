@@ -0,0 +1,376 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbCoarseToFineDisparityRangeFilter_txx
+#define otbCoarseToFineDisparityRangeFilter_txx
+
+#include "otbCoarseToFineDisparityRangeFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageScanlineIterator.h"
+#include "itkProgressReporter.h"
+#include "otbMacro.h"
+#include <algorithm>
+
+namespace otb
+{
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::CoarseToFineDisparityRangeFilter()
+{
+  // Set the number of inputs
+  this->SetNumberOfRequiredInputs(1);
+
+  // Set the outputs
+  this->SetNumberOfRequiredOutputs(2);
+  this->SetNthOutput(0, TOutputImage::New());
+  this->SetNthOutput(1, TOutputImage::New());
+
+  // Default parameters
+  m_Radius = 1;
+  m_Margin = 2.;
+  m_MinimumHorizontalDisparity = -10;
+  m_MaximumHorizontalDisparity = 10;
+
+  m_OutputStartIndex.Fill(0);
+  m_OutputSize.Fill(0);
+  m_OutputOrigin.Fill(0.);
+  m_OutputSpacing.Fill(1.);
+
+  m_MeanRange = 0.;
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+void
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::SetHorizontalDisparityInput(const TDisparityImage * hmap)
+{
+  // Process object is not const-correct so the const casting is required.
+  this->SetNthInput(0, const_cast<TDisparityImage *>(hmap));
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+void
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::SetMaskInput(const TMaskImage * mask)
+{
+  // Process object is not const-correct so the const casting is required.
+  this->SetNthInput(1, const_cast<TMaskImage *>(mask));
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+const TDisparityImage *
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::GetHorizontalDisparityInput() const
+{
+  if (this->GetNumberOfInputs() < 1)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TDisparityImage *>(this->itk::ProcessObject::GetInput(0));
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+const TMaskImage *
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::GetMaskInput() const
+{
+  if (this->GetNumberOfInputs() < 2)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TMaskImage *>(this->itk::ProcessObject::GetInput(1));
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+TOutputImage *
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::GetMinimumHorizontalDisparityOutput()
+{
+  return static_cast<TOutputImage *>(this->itk::ProcessObject::GetOutput(0));
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+TOutputImage *
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::GetMaximumHorizontalDisparityOutput()
+{
+  return static_cast<TOutputImage *>(this->itk::ProcessObject::GetOutput(1));
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+void
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::SetOutputParametersFromImage(const ImageBaseType * image)
+{
+  this->SetOutputOrigin(image->GetOrigin());
+  this->SetOutputSpacing(internal::GetSignedSpacing(image));
+  this->SetOutputStartIndex(image->GetLargestPossibleRegion().GetIndex());
+  this->SetOutputSize(image->GetLargestPossibleRegion().GetSize());
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+void
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::GenerateOutputInformation()
+{
+  // Call superclass implementation
+  Superclass::GenerateOutputInformation();
+
+  if (m_OutputSize[0] == 0 || m_OutputSize[1] == 0)
+    {
+    itkExceptionMacro(<<"The fine grid is empty, use SetOutputParametersFromImage() to set it.");
+    }
+
+  RegionType outputRegion;
+  outputRegion.SetIndex(m_OutputStartIndex);
+  outputRegion.SetSize(m_OutputSize);
+
+  for (unsigned int i = 0; i < 2; ++i)
+    {
+    TOutputImage * outputPtr = static_cast<TOutputImage *>(this->itk::ProcessObject::GetOutput(i));
+    outputPtr->SetLargestPossibleRegion(outputRegion);
+    outputPtr->SetOrigin(m_OutputOrigin);
+    outputPtr->SetSignedSpacing(m_OutputSpacing);
+    }
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+void
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::GenerateInputRequestedRegion()
+{
+  // The coarse grid does not match the output grid: the superclass
+  // implementation is not called
+  TDisparityImage * inHDispPtr = const_cast<TDisparityImage *>(this->GetHorizontalDisparityInput());
+  TMaskImage * inMaskPtr = const_cast<TMaskImage *>(this->GetMaskInput());
+
+  if (!inHDispPtr)
+    {
+    return;
+    }
+
+  if (inMaskPtr && inMaskPtr->GetLargestPossibleRegion() != inHDispPtr->GetLargestPossibleRegion())
+    {
+    itkExceptionMacro(<<"Disparity map and mask do not have the same size ! Disparity largest region: "<<inHDispPtr->GetLargestPossibleRegion()<<", mask largest region: "<<inMaskPtr->GetLargestPossibleRegion());
+    }
+
+  // The coarse map is small, it is requested as a whole
+  inHDispPtr->SetRequestedRegionToLargestPossibleRegion();
+  if (inMaskPtr)
+    {
+    inMaskPtr->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+void
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::BeforeThreadedGenerateData()
+{
+  if (m_MinimumHorizontalDisparity > m_MaximumHorizontalDisparity)
+    {
+    itkExceptionMacro(<<"Minimum horizontal disparity ("<<m_MinimumHorizontalDisparity<<") is greater than the maximum one ("<<m_MaximumHorizontalDisparity<<")");
+    }
+
+  const TDisparityImage * inHDispPtr = this->GetHorizontalDisparityInput();
+  const TMaskImage * inMaskPtr = this->GetMaskInput();
+
+  // The ranges only depend on the coarse inputs and on the parameters:
+  // they are kept from one streamed region to the other
+  itk::ModifiedTimeType inputTime = std::max(this->GetMTime(), inHDispPtr->GetMTime());
+  if (inMaskPtr)
+    {
+    inputTime = std::max(inputTime, inMaskPtr->GetMTime());
+    }
+  if (!m_CoarseMinimum.empty() && inputTime < m_CoarseRangeTime.GetMTime())
+    {
+    return;
+    }
+
+  typedef typename TDisparityImage::RegionType CoarseRegionType;
+  const CoarseRegionType coarseRegion = inHDispPtr->GetLargestPossibleRegion();
+  const unsigned long width = coarseRegion.GetSize(0);
+  const unsigned long height = coarseRegion.GetSize(1);
+  const long radius = static_cast<long>(m_Radius);
+
+  // Disparities are given in coarse pixels
+  const double scale = vcl_abs(internal::GetSignedSpacing(inHDispPtr)[0] / m_OutputSpacing[0]);
+
+  // Valid coarse disparities (empty ranges elsewhere)
+  const double noMinimum = itk::NumericTraits<double>::max();
+  const double noMaximum = itk::NumericTraits<double>::NonpositiveMin();
+  std::vector<double> lower(width * height, noMinimum);
+  std::vector<double> upper(width * height, noMaximum);
+
+  itk::ImageRegionConstIterator<TDisparityImage> hdispIt(inHDispPtr, coarseRegion);
+  itk::ImageRegionConstIterator<TMaskImage> maskIt;
+  if (inMaskPtr)
+    {
+    maskIt = itk::ImageRegionConstIterator<TMaskImage>(inMaskPtr, coarseRegion);
+    maskIt.GoToBegin();
+    }
+  unsigned long offset = 0;
+  for (hdispIt.GoToBegin(); !hdispIt.IsAtEnd(); ++hdispIt, ++offset)
+    {
+    if (!inMaskPtr || maskIt.Get() > 0)
+      {
+      lower[offset] = static_cast<double>(hdispIt.Get());
+      upper[offset] = lower[offset];
+      }
+    if (inMaskPtr)
+      {
+      ++maskIt;
+      }
+    }
+
+  // Extent over the neighborhoods: along the rows, then along the columns
+  std::vector<double> rowLower(width * height);
+  std::vector<double> rowUpper(width * height);
+  for (unsigned long y = 0; y < height; ++y)
+    {
+    for (long x = 0; x < static_cast<long>(width); ++x)
+      {
+      double minimum = noMinimum;
+      double maximum = noMaximum;
+      const long xEnd = std::min(x + radius, static_cast<long>(width) - 1);
+      for (long k = std::max(x - radius, 0L); k <= xEnd; ++k)
+        {
+        minimum = std::min(minimum, lower[y * width + k]);
+        maximum = std::max(maximum, upper[y * width + k]);
+        }
+      rowLower[y * width + x] = minimum;
+      rowUpper[y * width + x] = maximum;
+      }
+    }
+
+  m_CoarseMinimum.resize(width * height);
+  m_CoarseMaximum.resize(width * height);
+  double rangeSum = 0.;
+  for (long y = 0; y < static_cast<long>(height); ++y)
+    {
+    const long yEnd = std::min(y + radius, static_cast<long>(height) - 1);
+    for (unsigned long x = 0; x < width; ++x)
+      {
+      double minimum = noMinimum;
+      double maximum = noMaximum;
+      for (long k = std::max(y - radius, 0L); k <= yEnd; ++k)
+        {
+        minimum = std::min(minimum, rowLower[k * width + x]);
+        maximum = std::max(maximum, rowUpper[k * width + x]);
+        }
+
+      // Switch to fine pixels, and intersect with the global range
+      int rangeMinimum = m_MinimumHorizontalDisparity;
+      int rangeMaximum = m_MaximumHorizontalDisparity;
+      if (minimum <= maximum)
+        {
+        rangeMinimum = std::max(rangeMinimum, static_cast<int>(vcl_floor(scale * minimum - m_Margin)));
+        rangeMaximum = std::min(rangeMaximum, static_cast<int>(vcl_ceil(scale * maximum + m_Margin)));
+        if (rangeMinimum > rangeMaximum)
+          {
+          rangeMinimum = m_MinimumHorizontalDisparity;
+          rangeMaximum = m_MaximumHorizontalDisparity;
+          }
+        }
+
+      m_CoarseMinimum[y * width + x] = static_cast<OutputPixelType>(rangeMinimum);
+      m_CoarseMaximum[y * width + x] = static_cast<OutputPixelType>(rangeMaximum);
+      rangeSum += static_cast<double>(rangeMaximum - rangeMinimum + 1);
+      }
+    }
+
+  m_MeanRange = rangeSum / static_cast<double>(std::max(width * height, 1UL));
+  m_CoarseRangeTime.Modified();
+
+  otbMsgDevMacro(<< "Mean horizontal range: " << m_MeanRange << " disparities instead of "
+                 << (m_MaximumHorizontalDisparity - m_MinimumHorizontalDisparity + 1));
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+void
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::ThreadedGenerateData(const RegionType & outputRegionForThread, itk::ThreadIdType threadId)
+{
+  const TDisparityImage * inHDispPtr = this->GetHorizontalDisparityInput();
+  TOutputImage * outMinPtr = this->GetMinimumHorizontalDisparityOutput();
+  TOutputImage * outMaxPtr = this->GetMaximumHorizontalDisparityOutput();
+
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
+
+  const typename TDisparityImage::RegionType coarseRegion = inHDispPtr->GetLargestPossibleRegion();
+  const typename TDisparityImage::PointType coarseOrigin = inHDispPtr->GetOrigin();
+  const typename TDisparityImage::SpacingType coarseSpacing = internal::GetSignedSpacing(inHDispPtr);
+  const long width = static_cast<long>(coarseRegion.GetSize(0));
+
+  // Nearest coarse pixel of each fine column and row
+  std::vector<long> coarseIndex[2];
+  for (unsigned int dim = 0; dim < 2; ++dim)
+    {
+    const long coarseSize = static_cast<long>(coarseRegion.GetSize(dim));
+    coarseIndex[dim].resize(outputRegionForThread.GetSize(dim));
+    for (unsigned long i = 0; i < outputRegionForThread.GetSize(dim); ++i)
+      {
+      const double position = m_OutputOrigin[dim] + m_OutputSpacing[dim]
+        * static_cast<double>(outputRegionForThread.GetIndex(dim) + static_cast<long>(i));
+      const long index = static_cast<long>(vcl_floor((position - coarseOrigin[dim]) / coarseSpacing[dim] + 0.5))
+        - coarseRegion.GetIndex(dim);
+      coarseIndex[dim][i] = std::min(std::max(index, 0L), coarseSize - 1);
+      }
+    }
+
+  itk::ImageScanlineIterator<TOutputImage> outMinIt(outMinPtr, outputRegionForThread);
+  itk::ImageScanlineIterator<TOutputImage> outMaxIt(outMaxPtr, outputRegionForThread);
+  for (unsigned long y = 0; !outMinIt.IsAtEnd(); ++y)
+    {
+    const long rowOffset = coarseIndex[1][y] * width;
+    for (unsigned long x = 0; !outMinIt.IsAtEndOfLine(); ++x)
+      {
+      outMinIt.Set(m_CoarseMinimum[rowOffset + coarseIndex[0][x]]);
+      outMaxIt.Set(m_CoarseMaximum[rowOffset + coarseIndex[0][x]]);
+      ++outMinIt;
+      ++outMaxIt;
+      progress.CompletedPixel();
+      }
+    outMinIt.NextLine();
+    outMaxIt.NextLine();
+    }
+}
+
+template <class TDisparityImage, class TOutputImage, class TMaskImage>
+void
+CoarseToFineDisparityRangeFilter<TDisparityImage, TOutputImage, TMaskImage>
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Radius: " << m_Radius << std::endl;
+  os << indent << "Margin: " << m_Margin << std::endl;
+  os << indent << "MinimumHorizontalDisparity: " << m_MinimumHorizontalDisparity << std::endl;
+  os << indent << "MaximumHorizontalDisparity: " << m_MaximumHorizontalDisparity << std::endl;
+  os << indent << "OutputStartIndex: " << m_OutputStartIndex << std::endl;
+  os << indent << "OutputSize: " << m_OutputSize << std::endl;
+  os << indent << "OutputOrigin: " << m_OutputOrigin << std::endl;
+  os << indent << "OutputSpacing: " << m_OutputSpacing << std::endl;
+  os << indent << "MeanRange: " << m_MeanRange << std::endl;
+}
+
+} // end namespace otb
+
+#endif
@@ -27,6 +27,14 @@
 
 #include "itkTranslationTransform.h"
 #include "itkImageToImageMetric.h"
+#include "itkNormalizedCorrelationImageToImageMetric.h"
+#include "itkConfigure.h"
+
+#ifdef ITK_USE_FFTWD
+#include "itkFFTWCommon.h"
+#endif
+
+#include <vector>
 
 namespace otb
 {
@@ -63,6 +71,14 @@ namespace otb
  *
  * The FineRegistrationImageFilter allows using the full range of itk::ImageToImageMetric provided by itk.
  *
+ * When the metric is an itk::NormalizedCorrelationImageToImageMetric without masks, the
+ * UseFastCorrelationOn() flag enables a multi-threaded path: the grid nodes are shared among threads,
+ * the moving image is interpolated only once per node on the whole search window, and the
+ * correlation sums of all the offsets of the search window are computed at once, with FFTs through
+ * cached FFTW plans when ITK is built with FFTW (double) and the windows are large enough. The golden
+ * section refinement then evaluates the same normalized correlation as the itk metric, so that the
+ * outputs match the ones of the generic path up to rounding errors. Default is Off.
+ *
  * \example DisparityMap/FineRegistrationImageFilterExample.cxx
  *
  * \sa      FastCorrelationImageFilter, DisparityMapEstimationMethod
@@ -105,6 +121,8 @@ public:
   typedef typename TranslationType::Pointer                       TranslationPointerType;
   typedef typename itk::Transform<double, 2, 2>                     TransformType;
   typedef typename TransformType::Pointer                         TransformPointerType;
+  typedef itk::NormalizedCorrelationImageToImageMetric
+    <TInputImage, TInputImage>                                    NormalizedCorrelationMetricType;
 
   /** Set/Get the Metric used to compare images */
   itkSetObjectMacro(Metric, MetricType);
@@ -155,6 +173,12 @@ public:
   itkSetMacro(UseSpacing, bool);
   itkBooleanMacro(UseSpacing);
 
+  /** True if the normalized correlation should be computed by the fast multi-threaded path, when
+   *  the metric allows it. False otherwise */
+  itkSetMacro(UseFastCorrelation, bool);
+  itkGetConstReferenceMacro(UseFastCorrelation, bool);
+  itkBooleanMacro(UseFastCorrelation);
+
   /** Set default offset between the two images */
   itkSetMacro(InitialOffset, SpacingType);
   itkGetConstReferenceMacro(InitialOffset, SpacingType);
@@ -189,11 +213,19 @@ protected:
   /** Constructor */
   FineRegistrationImageFilter();
   /** Destructor */
-  ~FineRegistrationImageFilter() ITK_OVERRIDE {};
+  ~FineRegistrationImageFilter() ITK_OVERRIDE;
 
-  /** Threaded generate data */
+  /** Generate data, sequentially with the metric or through the threaded
+   *  methods for the fast correlation */
   void GenerateData() ITK_OVERRIDE;
 
+  /** Prepare the fast correlation */
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Fast correlation of the nodes of the given output region */
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            itk::ThreadIdType threadId) ITK_OVERRIDE;
+
   /** Generate the input requested regions  */
   void GenerateInputRequestedRegion(void) ITK_OVERRIDE;
 
@@ -204,7 +236,79 @@ private:
   FineRegistrationImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
   
-  inline double callMetric(double val1,double val2,double &oldRes,bool &flag);
+#ifdef ITK_USE_FFTWD
+  typedef itk::fftw::Proxy<double> FFTWProxyType;
+#endif
+
+  /** Buffers used by a thread of the fast correlation path. The patch is the fixed
+   *  neighborhood of a node, and the window is the moving image interpolated on the
+   *  patch enlarged by the search radius */
+  struct CorrelationWorkspace
+  {
+    /** Patch and window sizes */
+    unsigned int patchSizeX, patchSizeY;
+    unsigned int windowSizeX, windowSizeY;
+
+    /** Metric region (cropped patch) in patch coordinates */
+    unsigned int firstX, lastX, firstY, lastY;
+
+    /** Fixed values, zero outside of the metric region */
+    std::vector<double> patch;
+
+    /** Moving values and validity (1 inside of the moving buffer, 0 outside) */
+    std::vector<double> moving;
+    std::vector<double> valid;
+    bool                allValid;
+
+    /** Metric of each offset, and whether at least one pixel was counted */
+    std::vector<double>        metric;
+    std::vector<unsigned char> counted;
+
+#ifdef ITK_USE_FFTWD
+    /** Correlations of the patch and of its square with the window */
+    std::vector<double> sfm, sff, sf;
+
+    /** Sum tables of the moving values, of their squares and of the validity */
+    std::vector<double> movingSum, squaredMovingSum, validSum;
+
+    /** Buffers of the window size, allocated with fftw_malloc to match the alignment of the plans */
+    FFTWProxyType::PixelType *   real;
+    FFTWProxyType::ComplexType * patchFFT;
+    FFTWProxyType::ComplexType * squaredPatchFFT;
+    FFTWProxyType::ComplexType * windowFFT;
+    FFTWProxyType::ComplexType * productFFT;
+#endif
+  };
+
+  /** True if the fast correlation path can be used with the current metric */
+  bool CanUseFastCorrelation() const;
+
+  /** Metric region around a node and its local initial offset */
+  void ComputeNodeGeometry(const IndexType & nodeIndex, IndexType & currentIndex,
+                           InputImageRegionType & metricRegion, SpacingType & localOffset);
+
+  /** Normalized correlation of the metric region translated by (parx, pary), as computed
+   *  by the itk metric. Returns false if no pixel falls inside the moving buffer */
+  bool ComputeNormalizedCorrelation(const InputImageRegionType & metricRegion,
+                                    double parx, double pary, double & value);
+
+  /** Normalized correlation from the correlation sums. Centered sums whose magnitude is
+   *  below the tolerances are considered null */
+  static double NormalizedCorrelationFromSums(double sff, double smm, double sfm,
+                                              double sf, double sm, double count,
+                                              bool subtractMean,
+                                              double sffTolerance, double smmTolerance);
+
+  /** Metrics of all the pixel offsets of the search window by direct sums */
+  void ComputeOffsetMetricsDirect(CorrelationWorkspace & workspace) const;
+
+  /** Sub-pixel refinement of optParams by golden section search. The metric is evaluated
+   *  with m_Metric, or with ComputeNormalizedCorrelation() if fastCorrelation is true */
+  void RefineOffset(const InputImageRegionType & metricRegion, bool fastCorrelation,
+                    double optMetric, typename TranslationType::ParametersType & optParams);
+
+  inline double callMetric(double val1,double val2,double &oldRes,bool &flag,
+                           const InputImageRegionType & metricRegion, bool fastCorrelation);
   inline void updateOptParams(double potBestVal,double parx,double pary,                             //inputs
                               double &bestVal, typename TranslationType::ParametersType& optParams); //outputs
   inline void updatePoints(double& gn, double& in1, double& in2, double &in3,      //inputs
@@ -248,6 +352,33 @@ private:
   /** Transform for initial offset */
   TransformPointerType          m_Transform;
 
+  /** Fast correlation flag */
+  bool                          m_UseFastCorrelation;
+
+  /** Whether the current fast correlation run subtracts the mean and uses FFTs */
+  bool                          m_SubtractMean;
+  bool                          m_UseFFT;
+
+#ifdef ITK_USE_FFTWD
+  /** Metrics of all the pixel offsets of the search window through FFTs */
+  void ComputeOffsetMetricsFFT(CorrelationWorkspace & workspace) const;
+
+  /** Correlate the transformed window with a transformed patch, and store the
+   *  values of the pixel offsets in correlation */
+  void CorrelateWithPatch(const FFTWProxyType::ComplexType * windowFFT,
+                          const FFTWProxyType::ComplexType * patchFFT,
+                          CorrelationWorkspace & workspace,
+                          std::vector<double> & correlation) const;
+
+  /** Destroy the cached plans */
+  void ClearPlans();
+
+  /** Forward and inverse plans for the search window size, kept between runs */
+  FFTWProxyType::PlanType       m_ForwardPlan;
+  FFTWProxyType::PlanType       m_InversePlan;
+  SizeType                      m_PlanSize;
+#endif
+
 };
 
 } // end namespace otb
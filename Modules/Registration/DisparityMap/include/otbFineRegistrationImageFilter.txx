@@ -26,9 +26,13 @@
 #include "itkProgressReporter.h"
 #include "itkLinearInterpolateImageFunction.h"
 #include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkNormalizedCorrelationImageToImageMetric.h"
 #include "itkMacro.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace otb
 {
 /**
@@ -74,6 +78,26 @@ FineRegistrationImageFilter<TInputImage, T0utputCorrelation, TOutputDisplacement
   m_InitialOffset.Fill(0);
 
   m_Transform = ITK_NULLPTR;
+
+  // Fast correlation
+  m_UseFastCorrelation = false;
+  m_SubtractMean = false;
+  m_UseFFT = false;
+
+#ifdef ITK_USE_FFTWD
+  m_ForwardPlan = ITK_NULLPTR;
+  m_InversePlan = ITK_NULLPTR;
+  m_PlanSize.Fill(0);
+#endif
+ }
+
+template <class TInputImage, class T0utputCorrelation, class TOutputDisplacementField>
+FineRegistrationImageFilter<TInputImage, T0utputCorrelation, TOutputDisplacementField>
+::~FineRegistrationImageFilter()
+ {
+#ifdef ITK_USE_FFTWD
+  this->ClearPlans();
+#endif
  }
 
 template <class TInputImage, class T0utputCorrelation, class TOutputDisplacementField>
@@ -293,7 +317,8 @@ FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacement
 template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
 double
 FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
-::callMetric(double val1,double val2,double &oldRes,bool &flag)
+::callMetric(double val1,double val2,double &oldRes,bool &flag,
+             const InputImageRegionType & metricRegion, bool fastCorrelation)
 {
    typename TranslationType::ParametersType paramsgn(2);
    paramsgn[0]=val1;
@@ -302,6 +327,13 @@ FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacement
    double res=oldRes;
    flag=false;
    
+   if(fastCorrelation)
+   {
+      // Thread-safe evaluation, which leaves res unchanged on failure
+      flag=!this->ComputeNormalizedCorrelation(metricRegion,val1,val2,res);
+      return res;
+   }
+
    try
    {
       res=m_Metric->GetValue(paramsgn);
@@ -356,11 +388,109 @@ FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacement
 }
 
 
+template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
+void
+FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
+::RefineOffset(const InputImageRegionType & metricRegion, bool fastCorrelation,
+               double optMetric, typename TranslationType::ParametersType & optParams)
+{
+  // Get fixed image spacing
+  SpacingType fixedSpacing = this->GetFixedInput()->GetSignedSpacing();
+
+  //golden section search
+  double gn=(sqrt(5.0)-1.0)/2.0;
+  SpacingType subPixelSpacing = fixedSpacing;
+  double ax=optParams[0]-static_cast<double>(subPixelSpacing[0]);
+  double ay=optParams[1]-static_cast<double>(subPixelSpacing[1]);
+  double bx=optParams[0]+static_cast<double>(subPixelSpacing[0]);
+  double by=optParams[1]+static_cast<double>(subPixelSpacing[1]);
+
+  
+  double cx=bx-gn*(bx-ax);
+  double cy=optParams[1];//by-gn*(by-ay);
+  double dx=ax+gn*(bx-ax);
+  double dy=optParams[1];//ay+gn*(by-ay);
+  double fc=0,fd=0;
+  bool exitWhile=false;
+  int nbIter=0;
+  double bestvalold=itk::NumericTraits<double>::max(),bestval=optMetric;
+  double diff=itk::NumericTraits<double>::max();
+  double diffx=itk::NumericTraits<double>::max();
+  double diffy=itk::NumericTraits<double>::max();
+  
+  //init
+  fc=callMetric(cx,cy,fc,exitWhile,metricRegion,fastCorrelation);
+  fd=callMetric(dx,dy,fd,exitWhile,metricRegion,fastCorrelation);
+  updateMinimize(fc,fd);
+
+  //loop
+  while (  (diffx > m_SubPixelAccuracy || diffy > m_SubPixelAccuracy) 
+           && (diff>m_ConvergenceAccuracy) 
+           && (!exitWhile) 
+           && (nbIter<=m_MaxIter)) 
+  {
+      nbIter++;
+  
+      // x direction
+      if (fc<fd)
+      {
+          updateOptParams(fc,cx,cy,bestval,optParams);   
+          updatePoints(gn,ay,by,cx,bx,dx,dy,cy);
+          fc=callMetric(cx,cy,fc,exitWhile,metricRegion,fastCorrelation);
+          fd=callMetric(dx,dy,fd,exitWhile,metricRegion,fastCorrelation);
+      }
+      else
+      {
+          updateOptParams(fd,dx,dy,bestval,optParams);
+          updatePoints(gn,by,ay,dx,ax,cx,cy,dy);
+          fc=callMetric(cx,cy,fc,exitWhile,metricRegion,fastCorrelation);
+          fd=callMetric(dx,dy,fd,exitWhile,metricRegion,fastCorrelation);
+      }
+      updateMinimize(fc,fd);
+      
+      // y direction
+      if (fc<fd)
+      {
+          updateOptParams(fc,cx,cy,bestval,optParams);
+          updatePoints(gn,ax,bx,cy,by,dy,dx,cx);
+          fc=callMetric(cx,cy,fc,exitWhile,metricRegion,fastCorrelation);
+          fd=callMetric(dx,dy,fd,exitWhile,metricRegion,fastCorrelation);
+      }
+      else
+      {
+          updateOptParams(fd,dx,dy,bestval,optParams);
+          updatePoints(gn,bx,ax,dy,ay,cy,cx,dx);
+          fc=callMetric(cx,cy,fc,exitWhile,metricRegion,fastCorrelation);
+          fd=callMetric(dx,dy,fd,exitWhile,metricRegion,fastCorrelation);
+      }
+      updateMinimize(fc,fd);
+      
+      // Before eventual exit, take benefit from the last evaluations of fd and fc
+      updateOptParams(fd,dx,dy,bestval,optParams);
+      updateOptParams(fc,cx,cy,bestval,optParams);
+      
+      if(!m_Minimize)
+          bestval=-bestval;
+          
+      diff= fabs(bestval-bestvalold);
+      bestvalold=bestval;
+      diffx=fabs(bx-ax);
+      diffy=fabs(by-ay);
+  }
+}
+
 template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
 void
 FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
 ::GenerateData()
  {
+  // The fast correlation processes the nodes in the threaded methods
+  if (this->CanUseFastCorrelation())
+    {
+    Superclass::GenerateData();
+    return;
+    }
+
   // Allocate outputs
   this->AllocateOutputs();
 
@@ -424,39 +554,12 @@ FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacement
     optParams.Fill(0);
 
     // Build the region on which to compute the currentMetric
+    IndexType currentIndex;
     InputImageRegionType currentMetricRegion;
-
-    // Apply grid step
-    IndexType currentIndex = outputIt.GetIndex();
-    for(unsigned int dim = 0; dim < TInputImage::ImageDimension; ++dim)
-      {
-      currentIndex[dim] *= m_GridStep[dim];
-      }
-    currentMetricRegion.SetIndex(currentIndex);
-    SizeType size;
-    size.Fill(1);
-    currentMetricRegion.SetSize(size);
-    currentMetricRegion.PadByRadius(m_Radius);
-    currentMetricRegion.Crop(fixedPtr->GetLargestPossibleRegion());
+    this->ComputeNodeGeometry(outputIt.GetIndex(), currentIndex, currentMetricRegion, localOffset);
     m_Metric->SetFixedImageRegion(currentMetricRegion);
     m_Metric->Initialize();
 
-
-    // Compute the local offset if required (and the transform was specified)
-    if (m_Transform.IsNotNull())
-      {
-      PointType inputPoint, outputPoint;
-      for(unsigned int dim = 0; dim < TInputImage::ImageDimension; ++dim)
-        {
-        inputPoint[dim] = currentIndex[dim];
-        }
-      outputPoint = m_Transform->TransformPoint(inputPoint);
-      for(unsigned int dim = 0; dim < TInputImage::ImageDimension; ++dim)
-        {
-        localOffset[dim] = outputPoint[dim] - inputPoint[dim]; //FIXME check the direction
-        }
-      }
-
     // Compute the correlation at each location
     for(int i = -static_cast<int>(m_SearchRadius[0]); i <= static_cast<int>(m_SearchRadius[0]); ++i)
       {
@@ -486,87 +589,395 @@ FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacement
   
     
 
-    //golden section search
-    typename TranslationType::ParametersType paramsgn(2);
-    double gn=(sqrt(5.0)-1.0)/2.0;
-    SpacingType subPixelSpacing = fixedSpacing;
-    double ax=optParams[0]-static_cast<double>(subPixelSpacing[0]);
-    double ay=optParams[1]-static_cast<double>(subPixelSpacing[1]);
-    double bx=optParams[0]+static_cast<double>(subPixelSpacing[0]);
-    double by=optParams[1]+static_cast<double>(subPixelSpacing[1]);
+    // Sub-pixel refinement
+    this->RefineOffset(currentMetricRegion, false, optMetric, optParams);
 
+    // Store the offset and the correlation value
+    outputIt.Set(optMetric);
+    if(m_UseSpacing)
+      {
+      displacementValue[0] = optParams[0];
+      displacementValue[1] = optParams[1];
+      }
+    else
+      {
+      displacementValue[0] = optParams[0]/fixedSpacing[0];
+      displacementValue[1] = optParams[1]/fixedSpacing[1];
+      }
+    outputDfIt.Set(displacementValue);
     
-    double cx=bx-gn*(bx-ax);
-    double cy=optParams[1];//by-gn*(by-ay);
-    double dx=ax+gn*(bx-ax);
-    double dy=optParams[1];//ay+gn*(by-ay);
-    double fc=0,fd=0;
-    bool exitWhile=false;
-    int nbIter=0;
-    double bestvalold=itk::NumericTraits<double>::max(),bestval=optMetric;
-    double diff=itk::NumericTraits<double>::max();
-    double diffx=itk::NumericTraits<double>::max();
-    double diffy=itk::NumericTraits<double>::max();
-    
-    //init
-    fc=callMetric(cx,cy,fc,exitWhile);
-    fd=callMetric(dx,dy,fd,exitWhile);
-    updateMinimize(fc,fd);
-
-    //loop
-    while (  (diffx > m_SubPixelAccuracy || diffy > m_SubPixelAccuracy) 
-             && (diff>m_ConvergenceAccuracy) 
-             && (!exitWhile) 
-             && (nbIter<=m_MaxIter)) 
-    {
-        nbIter++;
     
-        // x direction
-        if (fc<fd)
-        {
-            updateOptParams(fc,cx,cy,bestval,optParams);   
-            updatePoints(gn,ay,by,cx,bx,dx,dy,cy);
-            fc=callMetric(cx,cy,fc,exitWhile);
-            fd=callMetric(dx,dy,fd,exitWhile);
-        }
-        else
+    // Update iterators
+    ++outputIt;
+    ++outputDfIt;
+
+    // Update progress
+    progress.CompletedPixel();
+    }
+ }
+
+template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
+bool
+FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
+::CanUseFastCorrelation() const
+{
+  if (!m_UseFastCorrelation)
+    {
+    return false;
+    }
+
+  // The fast path reproduces the normalized correlation metric only
+  const NormalizedCorrelationMetricType * metric =
+    dynamic_cast<const NormalizedCorrelationMetricType *>(m_Metric.GetPointer());
+
+  return metric != ITK_NULLPTR
+         && metric->GetFixedImageMask() == ITK_NULLPTR
+         && metric->GetMovingImageMask() == ITK_NULLPTR;
+}
+
+template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
+void
+FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
+::ComputeNodeGeometry(const IndexType & nodeIndex, IndexType & currentIndex,
+                      InputImageRegionType & metricRegion, SpacingType & localOffset)
+{
+  // Apply grid step
+  for(unsigned int dim = 0; dim < TInputImage::ImageDimension; ++dim)
+    {
+    currentIndex[dim] = nodeIndex[dim] * m_GridStep[dim];
+    }
+  metricRegion.SetIndex(currentIndex);
+  SizeType size;
+  size.Fill(1);
+  metricRegion.SetSize(size);
+  metricRegion.PadByRadius(m_Radius);
+  metricRegion.Crop(this->GetFixedInput()->GetLargestPossibleRegion());
+
+  localOffset = m_InitialOffset;
+
+  // Compute the local offset if required (and the transform was specified)
+  if (m_Transform.IsNotNull())
+    {
+    PointType inputPoint, outputPoint;
+    for(unsigned int dim = 0; dim < TInputImage::ImageDimension; ++dim)
+      {
+      inputPoint[dim] = currentIndex[dim];
+      }
+    outputPoint = m_Transform->TransformPoint(inputPoint);
+    for(unsigned int dim = 0; dim < TInputImage::ImageDimension; ++dim)
+      {
+      localOffset[dim] = outputPoint[dim] - inputPoint[dim]; //FIXME check the direction
+      }
+    }
+}
+
+template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
+double
+FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
+::NormalizedCorrelationFromSums(double sff, double smm, double sfm,
+                                double sf, double sm, double count,
+                                bool subtractMean,
+                                double sffTolerance, double smmTolerance)
+{
+  if (subtractMean && count > 0)
+    {
+    sff -= sf * sf / count;
+    smm -= sm * sm / count;
+    sfm -= sf * sm / count;
+    }
+
+  if (vcl_abs(sff) <= sffTolerance)
+    {
+    sff = 0.0;
+    }
+  if (vcl_abs(smm) <= smmTolerance)
+    {
+    smm = 0.0;
+    }
+
+  // Same sign convention as itk::NormalizedCorrelationImageToImageMetric
+  const double denom = -1.0 * vcl_sqrt(sff * smm);
+
+  if (count > 0 && denom != 0.0)
+    {
+    return sfm / denom;
+    }
+  return 0.0;
+}
+
+template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
+bool
+FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
+::ComputeNormalizedCorrelation(const InputImageRegionType & metricRegion,
+                               double parx, double pary, double & value)
+{
+  const TInputImage * fixedPtr = this->GetFixedInput();
+
+  double sff = 0.0, smm = 0.0, sfm = 0.0, sf = 0.0, sm = 0.0;
+  unsigned long count = 0;
+
+  itk::ImageRegionConstIteratorWithIndex<TInputImage> fixedIt(fixedPtr, metricRegion);
+  PointType point;
+
+  for (fixedIt.GoToBegin(); !fixedIt.IsAtEnd(); ++fixedIt)
+    {
+    fixedPtr->TransformIndexToPhysicalPoint(fixedIt.GetIndex(), point);
+    point[0] += parx;
+    point[1] += pary;
+
+    if (m_Interpolator->IsInsideBuffer(point))
+      {
+      const double movingValue = m_Interpolator->Evaluate(point);
+      const double fixedValue = static_cast<double>(fixedIt.Get());
+      sff += fixedValue * fixedValue;
+      smm += movingValue * movingValue;
+      sfm += fixedValue * movingValue;
+      if (m_SubtractMean)
         {
-            updateOptParams(fd,dx,dy,bestval,optParams);
-            updatePoints(gn,by,ay,dx,ax,cx,cy,dy);
-            fc=callMetric(cx,cy,fc,exitWhile);
-            fd=callMetric(dx,dy,fd,exitWhile);
+        sf += fixedValue;
+        sm += movingValue;
         }
-        updateMinimize(fc,fd);
-        
-        // y direction
-        if (fc<fd)
+      ++count;
+      }
+    }
+
+  // The metric throws in this case
+  if (count == 0)
+    {
+    return false;
+    }
+
+  value = NormalizedCorrelationFromSums(sff, smm, sfm, sf, sm, count, m_SubtractMean, 0.0, 0.0);
+  return true;
+}
+
+template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
+void
+FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
+::BeforeThreadedGenerateData()
+{
+  const NormalizedCorrelationMetricType * metric =
+    dynamic_cast<const NormalizedCorrelationMetricType *>(m_Metric.GetPointer());
+  m_SubtractMean = metric->GetSubtractMean();
+
+  // The interpolator is only evaluated by the threads
+  m_Interpolator->SetInputImage(this->GetMovingInput());
+
+  SizeType windowSize;
+  double windowNbOfPixels = 1.0, patchNbOfPixels = 1.0, nbOfOffsets = 1.0;
+  for(unsigned int dim = 0; dim < TInputImage::ImageDimension; ++dim)
+    {
+    windowSize[dim] = 2 * (m_Radius[dim] + m_SearchRadius[dim]) + 1;
+    windowNbOfPixels *= windowSize[dim];
+    patchNbOfPixels *= 2 * m_Radius[dim] + 1;
+    nbOfOffsets *= 2 * m_SearchRadius[dim] + 1;
+    }
+
+  m_UseFFT = false;
+
+#ifdef ITK_USE_FFTWD
+  // Direct sums cost one product per offset and patch pixel, whereas the FFT
+  // path costs up to seven transforms of the window
+  m_UseFFT = nbOfOffsets * patchNbOfPixels > 8.0 * windowNbOfPixels * vcl_log(windowNbOfPixels) / vcl_log(2.0);
+
+  if (m_UseFFT && (m_ForwardPlan == ITK_NULLPTR || m_PlanSize != windowSize))
+    {
+    this->ClearPlans();
+
+    const unsigned long sizeFFT = (windowSize[0] / 2 + 1) * windowSize[1];
+
+    // Planning with FFTW_MEASURE overwrites the arrays, so that the
+    // plans are created on scratch arrays
+    FFTWProxyType::PixelType * realWindow =
+      static_cast<FFTWProxyType::PixelType*>(fftw_malloc(windowSize[0] * windowSize[1] * sizeof(FFTWProxyType::PixelType)));
+    FFTWProxyType::ComplexType * complexWindow =
+      static_cast<FFTWProxyType::ComplexType*>(fftw_malloc(sizeFFT * sizeof(FFTWProxyType::ComplexType)));
+
+    m_ForwardPlan = FFTWProxyType::Plan_dft_r2c_2d(windowSize[1],
+                                                   windowSize[0],
+                                                   realWindow,
+                                                   complexWindow,
+                                                   FFTW_MEASURE);
+    m_InversePlan = FFTWProxyType::Plan_dft_c2r_2d(windowSize[1],
+                                                   windowSize[0],
+                                                   complexWindow,
+                                                   realWindow,
+                                                   FFTW_MEASURE);
+    m_PlanSize = windowSize;
+
+    fftw_free(realWindow);
+    fftw_free(complexWindow);
+    }
+#endif
+}
+
+template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
+void
+FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                       itk::ThreadIdType threadId)
+{
+  // Get the image pointers
+  const TInputImage * fixedPtr = this->GetFixedInput();
+  TOutputCorrelation * outputPtr = this->GetOutput();
+  TOutputDisplacementField * outputDfPtr = this->GetOutputDisplacementField();
+
+  // support progress methods/callbacks
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels());
+
+  const int searchRadiusX = static_cast<int>(m_SearchRadius[0]);
+  const int searchRadiusY = static_cast<int>(m_SearchRadius[1]);
+  const unsigned int nbOffsetsX = 2 * searchRadiusX + 1;
+  const unsigned int nbOffsetsY = 2 * searchRadiusY + 1;
+
+  CorrelationWorkspace workspace;
+  workspace.patchSizeX = 2 * m_Radius[0] + 1;
+  workspace.patchSizeY = 2 * m_Radius[1] + 1;
+  workspace.windowSizeX = workspace.patchSizeX + 2 * searchRadiusX;
+  workspace.windowSizeY = workspace.patchSizeY + 2 * searchRadiusY;
+
+  const unsigned int windowNbOfPixels = workspace.windowSizeX * workspace.windowSizeY;
+
+  workspace.patch.resize(workspace.patchSizeX * workspace.patchSizeY);
+  workspace.moving.resize(windowNbOfPixels);
+  workspace.valid.resize(windowNbOfPixels);
+  workspace.metric.resize(nbOffsetsX * nbOffsetsY);
+  workspace.counted.resize(nbOffsetsX * nbOffsetsY);
+
+#ifdef ITK_USE_FFTWD
+  if (m_UseFFT)
+    {
+    const unsigned long sizeFFT = (workspace.windowSizeX / 2 + 1) * workspace.windowSizeY;
+    const unsigned long tableSize = (workspace.windowSizeX + 1) * (workspace.windowSizeY + 1);
+
+    workspace.sfm.resize(nbOffsetsX * nbOffsetsY);
+    workspace.sff.resize(nbOffsetsX * nbOffsetsY);
+    workspace.sf.resize(nbOffsetsX * nbOffsetsY);
+
+    // The first row and column of the sum tables stay null
+    workspace.movingSum.resize(tableSize, 0.0);
+    workspace.squaredMovingSum.resize(tableSize, 0.0);
+    workspace.validSum.resize(tableSize, 0.0);
+
+    workspace.real =
+      static_cast<FFTWProxyType::PixelType*>(fftw_malloc(windowNbOfPixels * sizeof(FFTWProxyType::PixelType)));
+    workspace.patchFFT =
+      static_cast<FFTWProxyType::ComplexType*>(fftw_malloc(sizeFFT * sizeof(FFTWProxyType::ComplexType)));
+    workspace.squaredPatchFFT =
+      static_cast<FFTWProxyType::ComplexType*>(fftw_malloc(sizeFFT * sizeof(FFTWProxyType::ComplexType)));
+    workspace.windowFFT =
+      static_cast<FFTWProxyType::ComplexType*>(fftw_malloc(sizeFFT * sizeof(FFTWProxyType::ComplexType)));
+    workspace.productFFT =
+      static_cast<FFTWProxyType::ComplexType*>(fftw_malloc(sizeFFT * sizeof(FFTWProxyType::ComplexType)));
+    }
+#endif
+
+  // Get fixed image spacing
+  SpacingType fixedSpacing = fixedPtr->GetSignedSpacing();
+
+  // Optimal translation parameters
+  typename TranslationType::ParametersType optParams(2);
+
+  // Final displacement value
+  DisplacementValueType displacementValue;
+
+  IndexType currentIndex, patchIndex, windowIndex;
+  InputImageRegionType metricRegion;
+  SpacingType localOffset;
+  PointType windowPoint;
+
+  /** Output iterators */
+  itk::ImageRegionIteratorWithIndex<TOutputCorrelation> outputIt(outputPtr, outputRegionForThread);
+  itk::ImageRegionIterator<TOutputDisplacementField> outputDfIt(outputDfPtr, outputRegionForThread);
+
+  for (outputIt.GoToBegin(), outputDfIt.GoToBegin(); !outputIt.IsAtEnd(); ++outputIt, ++outputDfIt)
+    {
+    this->ComputeNodeGeometry(outputIt.GetIndex(), currentIndex, metricRegion, localOffset);
+
+    // Fixed patch around the node
+    patchIndex[0] = currentIndex[0] - static_cast<long>(m_Radius[0]);
+    patchIndex[1] = currentIndex[1] - static_cast<long>(m_Radius[1]);
+
+    workspace.firstX = metricRegion.GetIndex()[0] - patchIndex[0];
+    workspace.firstY = metricRegion.GetIndex()[1] - patchIndex[1];
+    workspace.lastX = workspace.firstX + metricRegion.GetSize()[0] - 1;
+    workspace.lastY = workspace.firstY + metricRegion.GetSize()[1] - 1;
+
+    std::fill(workspace.patch.begin(), workspace.patch.end(), 0.0);
+
+    itk::ImageRegionConstIteratorWithIndex<TInputImage> fixedIt(fixedPtr, metricRegion);
+    for (fixedIt.GoToBegin(); !fixedIt.IsAtEnd(); ++fixedIt)
+      {
+      const IndexType & fixedIndex = fixedIt.GetIndex();
+      workspace.patch[(fixedIndex[1] - patchIndex[1]) * workspace.patchSizeX + fixedIndex[0] - patchIndex[0]]
+        = static_cast<double>(fixedIt.Get());
+      }
+
+    // Moving image interpolated once on the whole search window: the pixel
+    // offset (i, j) of the metric reads this window shifted by (i, j)
+    workspace.allValid = true;
+    unsigned int pos = 0;
+    for (unsigned int y = 0; y < workspace.windowSizeY; ++y)
+      {
+      for (unsigned int x = 0; x < workspace.windowSizeX; ++x, ++pos)
         {
-            updateOptParams(fc,cx,cy,bestval,optParams);
-            updatePoints(gn,ax,bx,cy,by,dy,dx,cx);
-            fc=callMetric(cx,cy,fc,exitWhile);
-            fd=callMetric(dx,dy,fd,exitWhile);
-        }
+        windowIndex[0] = patchIndex[0] - searchRadiusX + static_cast<long>(x);
+        windowIndex[1] = patchIndex[1] - searchRadiusY + static_cast<long>(y);
+        fixedPtr->TransformIndexToPhysicalPoint(windowIndex, windowPoint);
+        windowPoint[0] += localOffset[0];
+        windowPoint[1] += localOffset[1];
+
+        if (m_Interpolator->IsInsideBuffer(windowPoint))
+          {
+          workspace.moving[pos] = m_Interpolator->Evaluate(windowPoint);
+          workspace.valid[pos] = 1.0;
+          }
         else
+          {
+          workspace.moving[pos] = 0.0;
+          workspace.valid[pos] = 0.0;
+          workspace.allValid = false;
+          }
+        }
+      }
+
+    if (m_UseFFT)
+      {
+#ifdef ITK_USE_FFTWD
+      this->ComputeOffsetMetricsFFT(workspace);
+#endif
+      }
+    else
+      {
+      this->ComputeOffsetMetricsDirect(workspace);
+      }
+
+    // Look for the optimum in the same order as the sequential path
+    double optMetric = m_Minimize ? itk::NumericTraits<double>::max() : itk::NumericTraits<double>::NonpositiveMin();
+    optParams.Fill(0);
+
+    for(int i = -searchRadiusX; i <= searchRadiusX; ++i)
+      {
+      for(int j = -searchRadiusY; j <= searchRadiusY; ++j)
         {
-            updateOptParams(fd,dx,dy,bestval,optParams);
-            updatePoints(gn,bx,ax,dy,ay,cy,cx,dx);
-            fc=callMetric(cx,cy,fc,exitWhile);
-            fd=callMetric(dx,dy,fd,exitWhile);
+        const unsigned int offsetPos = (j + searchRadiusY) * nbOffsetsX + i + searchRadiusX;
+        if (!workspace.counted[offsetPos])
+          {
+          continue;
+          }
+
+        const double currentMetric = workspace.metric[offsetPos];
+        if((m_Minimize && (currentMetric < optMetric)) || (!m_Minimize && (currentMetric > optMetric)))
+          {
+          optMetric = currentMetric;
+          optParams[0] = localOffset[0] + static_cast<double>(i*fixedSpacing[0]);
+          optParams[1] = localOffset[1] + static_cast<double>(j*fixedSpacing[1]);
+          }
         }
-        updateMinimize(fc,fd);
-        
-        // Before eventual exit, take benefit from the last evaluations of fd and fc
-        updateOptParams(fd,dx,dy,bestval,optParams);
-        updateOptParams(fc,cx,cy,bestval,optParams);
-        
-        if(!m_Minimize)
-            bestval=-bestval;
-            
-        diff= fabs(bestval-bestvalold);
-        bestvalold=bestval;
-        diffx=fabs(bx-ax);
-        diffy=fabs(by-ay);
-	}
+      }
+
+    // Sub-pixel refinement
+    this->RefineOffset(metricRegion, true, optMetric, optParams);
 
     // Store the offset and the correlation value
     outputIt.Set(optMetric);
@@ -581,16 +992,245 @@ FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacement
       displacementValue[1] = optParams[1]/fixedSpacing[1];
       }
     outputDfIt.Set(displacementValue);
-    
-    
-    // Update iterators
-    ++outputIt;
-    ++outputDfIt;
 
-    // Update progress
     progress.CompletedPixel();
     }
- }
+
+#ifdef ITK_USE_FFTWD
+  if (m_UseFFT)
+    {
+    fftw_free(workspace.real);
+    fftw_free(workspace.patchFFT);
+    fftw_free(workspace.squaredPatchFFT);
+    fftw_free(workspace.windowFFT);
+    fftw_free(workspace.productFFT);
+    }
+#endif
+}
+
+template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
+void
+FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
+::ComputeOffsetMetricsDirect(CorrelationWorkspace & workspace) const
+{
+  const unsigned int nbOffsetsX = workspace.windowSizeX - workspace.patchSizeX + 1;
+  const unsigned int nbOffsetsY = workspace.windowSizeY - workspace.patchSizeY + 1;
+
+  for (unsigned int ty = 0; ty < nbOffsetsY; ++ty)
+    {
+    for (unsigned int tx = 0; tx < nbOffsetsX; ++tx)
+      {
+      double sff = 0.0, smm = 0.0, sfm = 0.0, sf = 0.0, sm = 0.0;
+      unsigned long count = 0;
+
+      // Same accumulation order as the metric
+      for (unsigned int y = workspace.firstY; y <= workspace.lastY; ++y)
+        {
+        const double * patchRow = &workspace.patch[y * workspace.patchSizeX];
+        const unsigned int windowRow = (y + ty) * workspace.windowSizeX + tx;
+
+        for (unsigned int x = workspace.firstX; x <= workspace.lastX; ++x)
+          {
+          if (workspace.valid[windowRow + x] != 0.0)
+            {
+            const double fixedValue = patchRow[x];
+            const double movingValue = workspace.moving[windowRow + x];
+            sff += fixedValue * fixedValue;
+            smm += movingValue * movingValue;
+            sfm += fixedValue * movingValue;
+            if (m_SubtractMean)
+              {
+              sf += fixedValue;
+              sm += movingValue;
+              }
+            ++count;
+            }
+          }
+        }
+
+      const unsigned int offsetPos = ty * nbOffsetsX + tx;
+      workspace.counted[offsetPos] = (count > 0);
+      workspace.metric[offsetPos] = (count > 0)
+        ? NormalizedCorrelationFromSums(sff, smm, sfm, sf, sm, count, m_SubtractMean, 0.0, 0.0)
+        : 0.0;
+      }
+    }
+}
+
+#ifdef ITK_USE_FFTWD
+template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
+void
+FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
+::CorrelateWithPatch(const FFTWProxyType::ComplexType * windowFFT,
+                     const FFTWProxyType::ComplexType * patchFFT,
+                     CorrelationWorkspace & workspace,
+                     std::vector<double> & correlation) const
+{
+  const unsigned long sizeFFT = (workspace.windowSizeX / 2 + 1) * workspace.windowSizeY;
+
+  // Multiplying by the conjugate transform of the patch gives the
+  // correlation, sum over k of patch(k) * window(k + offset)
+  for (unsigned long i = 0; i < sizeFFT; ++i)
+    {
+    workspace.productFFT[i][0] = windowFFT[i][0] * patchFFT[i][0] + windowFFT[i][1] * patchFFT[i][1];
+    workspace.productFFT[i][1] = windowFFT[i][1] * patchFFT[i][0] - windowFFT[i][0] * patchFFT[i][1];
+    }
+
+  fftw_execute_dft_c2r(m_InversePlan, workspace.productFFT, workspace.real);
+
+  // The patch lies in the upper left corner of the window, so that the
+  // circular correlation does not wrap for the offsets of the search window
+  const unsigned int nbOffsetsX = workspace.windowSizeX - workspace.patchSizeX + 1;
+  const unsigned int nbOffsetsY = workspace.windowSizeY - workspace.patchSizeY + 1;
+
+  for (unsigned int ty = 0; ty < nbOffsetsY; ++ty)
+    {
+    for (unsigned int tx = 0; tx < nbOffsetsX; ++tx)
+      {
+      correlation[ty * nbOffsetsX + tx] = workspace.real[ty * workspace.windowSizeX + tx];
+      }
+    }
+}
+
+template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
+void
+FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
+::ComputeOffsetMetricsFFT(CorrelationWorkspace & workspace) const
+{
+  const unsigned int windowSizeX = workspace.windowSizeX;
+  const unsigned int windowNbOfPixels = windowSizeX * workspace.windowSizeY;
+  const unsigned int nbOffsetsX = windowSizeX - workspace.patchSizeX + 1;
+  const unsigned int nbOffsetsY = workspace.windowSizeY - workspace.patchSizeY + 1;
+
+  // The normalization by the number of pixels of the unnormalized inverse
+  // transform is folded into the patch
+  const double norm = 1.0 / windowNbOfPixels;
+
+  double patchSum = 0.0, squaredPatchSum = 0.0;
+
+  memset(workspace.real, 0, windowNbOfPixels * sizeof(FFTWProxyType::PixelType));
+  for (unsigned int y = 0; y < workspace.patchSizeY; ++y)
+    {
+    for (unsigned int x = 0; x < workspace.patchSizeX; ++x)
+      {
+      const double fixedValue = workspace.patch[y * workspace.patchSizeX + x];
+      workspace.real[y * windowSizeX + x] = fixedValue * norm;
+      patchSum += fixedValue;
+      squaredPatchSum += fixedValue * fixedValue;
+      }
+    }
+  fftw_execute_dft_r2c(m_ForwardPlan, workspace.real, workspace.patchFFT);
+
+  // Without missing moving pixels, the fixed sums do not depend on the offset
+  if (!workspace.allValid)
+    {
+    for (unsigned int y = 0; y < workspace.patchSizeY; ++y)
+      {
+      for (unsigned int x = 0; x < workspace.patchSizeX; ++x)
+        {
+        const double fixedValue = workspace.patch[y * workspace.patchSizeX + x];
+        workspace.real[y * windowSizeX + x] = fixedValue * fixedValue * norm;
+        }
+      }
+    fftw_execute_dft_r2c(m_ForwardPlan, workspace.real, workspace.squaredPatchFFT);
+    }
+
+  // Moving values are null outside of the moving buffer
+  std::copy(workspace.moving.begin(), workspace.moving.end(), workspace.real);
+  fftw_execute_dft_r2c(m_ForwardPlan, workspace.real, workspace.windowFFT);
+  this->CorrelateWithPatch(workspace.windowFFT, workspace.patchFFT, workspace, workspace.sfm);
+
+  if (!workspace.allValid)
+    {
+    std::copy(workspace.valid.begin(), workspace.valid.end(), workspace.real);
+    fftw_execute_dft_r2c(m_ForwardPlan, workspace.real, workspace.windowFFT);
+    this->CorrelateWithPatch(workspace.windowFFT, workspace.squaredPatchFFT, workspace, workspace.sff);
+    if (m_SubtractMean)
+      {
+      this->CorrelateWithPatch(workspace.windowFFT, workspace.patchFFT, workspace, workspace.sf);
+      }
+    }
+
+  // Sum tables of the moving sums, which only depend on the metric region
+  const unsigned int tableSizeX = windowSizeX + 1;
+  for (unsigned int y = 0; y < workspace.windowSizeY; ++y)
+    {
+    double rowMovingSum = 0.0, rowSquaredMovingSum = 0.0, rowValidSum = 0.0;
+    for (unsigned int x = 0; x < windowSizeX; ++x)
+      {
+      const double movingValue = workspace.moving[y * windowSizeX + x];
+      rowMovingSum += movingValue;
+      rowSquaredMovingSum += movingValue * movingValue;
+      rowValidSum += workspace.valid[y * windowSizeX + x];
+
+      const unsigned int tablePos = (y + 1) * tableSizeX + x + 1;
+      workspace.movingSum[tablePos] = workspace.movingSum[tablePos - tableSizeX] + rowMovingSum;
+      workspace.squaredMovingSum[tablePos] = workspace.squaredMovingSum[tablePos - tableSizeX] + rowSquaredMovingSum;
+      workspace.validSum[tablePos] = workspace.validSum[tablePos - tableSizeX] + rowValidSum;
+      }
+    }
+
+  // The transforms and the sum tables leave rounding errors relative to the
+  // whole patch and window, which must not turn an uniform patch or window
+  // into a tiny non-null variance
+  const double relativeTolerance = 1e-10;
+  const double sffTolerance = relativeTolerance * squaredPatchSum;
+  const double smmTolerance = relativeTolerance * workspace.squaredMovingSum.back();
+
+  for (unsigned int ty = 0; ty < nbOffsetsY; ++ty)
+    {
+    for (unsigned int tx = 0; tx < nbOffsetsX; ++tx)
+      {
+      const unsigned int top = (workspace.firstY + ty) * tableSizeX;
+      const unsigned int bottom = (workspace.lastY + ty + 1) * tableSizeX;
+      const unsigned int left = workspace.firstX + tx;
+      const unsigned int right = workspace.lastX + tx + 1;
+
+      const unsigned int offsetPos = ty * nbOffsetsX + tx;
+
+      const double count = vcl_floor(workspace.validSum[bottom + right] - workspace.validSum[top + right]
+                                     - workspace.validSum[bottom + left] + workspace.validSum[top + left] + 0.5);
+      if (count <= 0.0)
+        {
+        workspace.counted[offsetPos] = false;
+        workspace.metric[offsetPos] = 0.0;
+        continue;
+        }
+
+      const double sm = workspace.movingSum[bottom + right] - workspace.movingSum[top + right]
+                        - workspace.movingSum[bottom + left] + workspace.movingSum[top + left];
+      const double smm = workspace.squaredMovingSum[bottom + right] - workspace.squaredMovingSum[top + right]
+                         - workspace.squaredMovingSum[bottom + left] + workspace.squaredMovingSum[top + left];
+
+      const double sff = workspace.allValid ? squaredPatchSum : workspace.sff[offsetPos];
+      const double sf = workspace.allValid ? patchSum : workspace.sf[offsetPos];
+
+      workspace.counted[offsetPos] = true;
+      workspace.metric[offsetPos] = NormalizedCorrelationFromSums(sff, smm, workspace.sfm[offsetPos], sf, sm, count,
+                                                                  m_SubtractMean, sffTolerance, smmTolerance);
+      }
+    }
+}
+
+template <class TInputImage, class TOutputCorrelation, class TOutputDisplacementField>
+void
+FineRegistrationImageFilter<TInputImage, TOutputCorrelation, TOutputDisplacementField>
+::ClearPlans()
+{
+  if (m_ForwardPlan != ITK_NULLPTR)
+    {
+    FFTWProxyType::DestroyPlan(m_ForwardPlan);
+    m_ForwardPlan = ITK_NULLPTR;
+    }
+  if (m_InversePlan != ITK_NULLPTR)
+    {
+    FFTWProxyType::DestroyPlan(m_InversePlan);
+    m_InversePlan = ITK_NULLPTR;
+    }
+  m_PlanSize.Fill(0);
+}
+#endif
+
 } // end namespace otb
 
 #endif
@@ -26,6 +26,8 @@
 #include "itkConstNeighborhoodIterator.h"
 #include "itkImageRegionIterator.h"
 #include "otbImage.h"
+#include <vector>
+#include <algorithm>
 
 namespace otb
 {
@@ -215,6 +217,11 @@ public:
       }
     }
 
+  double GetP() const
+    {
+    return m_P;
+    }
+
   // Implement the Lp metric
   inline MetricValueType operator()(ConstNeighborhoodIteratorType & a, ConstNeighborhoodIteratorType & b) const
   {
@@ -234,6 +241,148 @@ private:
   double m_P;
 };
 
+/** \class BlockMatchingBoxFilterTraits
+ *  \brief Box filter decomposition of a block-matching functor
+ *
+ *  The box filter mode of the PixelWiseBlockMatchingImageFilter
+ *  requires the block-matching metric to be a function of the sums,
+ *  over the block, of a few per-pixel terms computed from the left and
+ *  right values. This traits class gives the number of terms, the
+ *  per-pixel terms, and the metric computed from the block sums.
+ *
+ *  It is specialized for the SSD, SSDDivMean, NCC and Lp functors.
+ *  Other functors do not support the box filter mode, and are always
+ *  evaluated on the neighborhoods.
+ *
+ * \ingroup OTBDisparityMap
+ */
+template <class TFunctor>
+class BlockMatchingBoxFilterTraits
+{
+public:
+  static const bool         IsSupported = false;
+  static const unsigned int NumberOfTerms = 1;
+
+  static void ComputeTerms(const TFunctor &, double, double, double *)
+  {
+  }
+
+  static double ComputeMetric(const TFunctor &, const double *, double)
+  {
+    return 0.;
+  }
+};
+
+/** Sum of (a-b)^2 */
+template <class TInputImage, class TOutputMetricImage>
+class BlockMatchingBoxFilterTraits<SSDBlockMatching<TInputImage, TOutputMetricImage> >
+{
+public:
+  typedef SSDBlockMatching<TInputImage, TOutputMetricImage> FunctorType;
+
+  static const bool         IsSupported = true;
+  static const unsigned int NumberOfTerms = 1;
+
+  static void ComputeTerms(const FunctorType &, double a, double b, double * terms)
+  {
+    terms[0] = (a - b) * (a - b);
+  }
+
+  static double ComputeMetric(const FunctorType &, const double * sums, double)
+  {
+    return sums[0] > 0. ? sums[0] : 0.;
+  }
+};
+
+/** Sum of |a-b|^p */
+template <class TInputImage, class TOutputMetricImage>
+class BlockMatchingBoxFilterTraits<LPBlockMatching<TInputImage, TOutputMetricImage> >
+{
+public:
+  typedef LPBlockMatching<TInputImage, TOutputMetricImage> FunctorType;
+
+  static const bool         IsSupported = true;
+  static const unsigned int NumberOfTerms = 1;
+
+  static void ComputeTerms(const FunctorType & functor, double a, double b, double * terms)
+  {
+    terms[0] = vcl_pow(vcl_abs(a - b), functor.GetP());
+  }
+
+  static double ComputeMetric(const FunctorType &, const double * sums, double)
+  {
+    return sums[0] > 0. ? sums[0] : 0.;
+  }
+};
+
+/** Sums of a, b, a^2, b^2 and ab */
+template <class TInputImage, class TOutputMetricImage>
+class BlockMatchingBoxFilterTraits<NCCBlockMatching<TInputImage, TOutputMetricImage> >
+{
+public:
+  typedef NCCBlockMatching<TInputImage, TOutputMetricImage> FunctorType;
+
+  static const bool         IsSupported = true;
+  static const unsigned int NumberOfTerms = 5;
+
+  static void ComputeTerms(const FunctorType &, double a, double b, double * terms)
+  {
+    terms[0] = a;
+    terms[1] = b;
+    terms[2] = a * a;
+    terms[3] = b * b;
+    terms[4] = a * b;
+  }
+
+  static double ComputeMetric(const FunctorType &, const double * sums, double size)
+  {
+    // Centred sums, the (size-1) normalizations cancel out
+    const double cov  = sums[4] - sums[0] * sums[1] / size;
+    const double varA = sums[2] - sums[0] * sums[0] / size;
+    const double varB = sums[3] - sums[1] * sums[1] / size;
+
+    // The subtractions cancel when the blocks are flat compared to their
+    // mean: the variances are only trusted above a fraction of the sums of
+    // squares, below which the block is handled as uniform
+    const double relativeEpsilon = 1e-10;
+    if (varA > relativeEpsilon * sums[2] && varB > relativeEpsilon * sums[3])
+      {
+      return std::min(vcl_abs(cov) / vcl_sqrt(varA * varB), 1.);
+      }
+    return 0.;
+  }
+};
+
+/** Sums of a, b, a^2, b^2 and ab, expanding (a/meanA - b/meanB)^2 */
+template <class TInputImage, class TOutputMetricImage>
+class BlockMatchingBoxFilterTraits<SSDDivMeanBlockMatching<TInputImage, TOutputMetricImage> >
+{
+public:
+  typedef SSDDivMeanBlockMatching<TInputImage, TOutputMetricImage> FunctorType;
+
+  static const bool         IsSupported = true;
+  static const unsigned int NumberOfTerms = 5;
+
+  static void ComputeTerms(const FunctorType &, double a, double b, double * terms)
+  {
+    terms[0] = a;
+    terms[1] = b;
+    terms[2] = a * a;
+    terms[3] = b * b;
+    terms[4] = a * b;
+  }
+
+  static double ComputeMetric(const FunctorType &, const double * sums, double size)
+  {
+    double meanA = sums[0] / size;
+    double meanB = sums[1] / size;
+    double ssd = sums[2] / (meanA * meanA)
+      - 2. * sums[4] / (meanA * meanB)
+      + sums[3] / (meanB * meanB);
+    return ssd > 0. ? ssd : 0.;
+  }
+};
+
 } // End Namespace Functor
 
 /** \class PixelWiseBlockMatchingImageFilter
@@ -284,6 +433,28 @@ private:
  *  an exploration radius indicates the disparity range to be explored around
  *  the initial estimate (global minimum and maximum values are still in use).
  *
+ *  The horizontal exploration can also be bounded pixel-wise, with maps of
+ *  the minimum and maximum horizontal disparities (same size as the left
+ *  image, see CoarseToFineDisparityRangeFilter). Each pixel only explores
+ *  the intersection of its own range with the global one, and each thread
+ *  only loops on the union of the ranges of its region.
+ *
+ *  The box filter mode (UseBoxFilterOn()) evaluates the SSD, SSDDivMean,
+ *  NCC and Lp metrics without iterating over the blocks: for each
+ *  disparity, the per-pixel terms of the metric are computed once, and
+ *  aggregated over the blocks with running sums along the columns and
+ *  the rows. The cost per pixel and disparity does not depend on the
+ *  radius anymore. Results are the same as the neighborhood evaluation,
+ *  up to rounding errors (sums are computed in double precision). The
+ *  mode is ignored for other functors (see BlockMatchingBoxFilterTraits).
+ *
+ *  With ComputeNeighborMetricsOn(), two more outputs keep the metric values
+ *  at the best horizontal disparity minus one and plus one (same vertical
+ *  disparity), as seen during the search. SubPixelDisparityImageFilter can
+ *  then refine the disparities without evaluating these positions again.
+ *  Positions that were not explored hold the largest metric value
+ *  (itk::NumericTraits<MetricValueType>::max()).
+ *
  *  \sa FineRegistrationImageFilter
  *  \sa StereorectificationDisplacementFieldSource
  *  \sa SubPixelDisparityImageFilter
@@ -333,6 +504,9 @@ public:
 
   typedef itk::ConstNeighborhoodIterator<TInputImage>       ConstNeighborhoodIteratorType;
 
+  /** Rank of the disparities in the exploration order (internal purpose only) */
+  typedef itk::Image<int, InputImageType::ImageDimension>   DisparityRankImageType;
+
   /** Set left input */
   void SetLeftInput( const TInputImage * image);
 
@@ -363,6 +537,15 @@ public:
   const TOutputDisparityImage * GetVerticalDisparityOutput() const;
   TOutputDisparityImage * GetVerticalDisparityOutput();
 
+  /** Get the metric at the best horizontal disparity minus one (null
+   * unless ComputeNeighborMetrics is on) */
+  const TOutputMetricImage * GetPreviousHorizontalMetricOutput() const;
+  TOutputMetricImage * GetPreviousHorizontalMetricOutput();
+
+  /** Get the metric at the best horizontal disparity plus one (null
+   * unless ComputeNeighborMetrics is on) */
+  const TOutputMetricImage * GetNextHorizontalMetricOutput() const;
+  TOutputMetricImage * GetNextHorizontalMetricOutput();
 
   /** Set unsigned int radius */
   void SetRadius(unsigned int radius)
@@ -394,6 +577,17 @@ public:
   itkGetConstReferenceMacro(Minimize,bool);
   itkBooleanMacro(Minimize);
 
+  /** Set/Get the box filter mode (off by default) */
+  itkSetMacro(UseBoxFilter, bool);
+  itkGetConstReferenceMacro(UseBoxFilter, bool);
+  itkBooleanMacro(UseBoxFilter);
+
+  /** Set/Get the export of the metric values around the best horizontal
+   * disparity (off by default). Turning it on adds the two outputs. */
+  void SetComputeNeighborMetrics(bool flag);
+  itkGetConstReferenceMacro(ComputeNeighborMetrics, bool);
+  itkBooleanMacro(ComputeNeighborMetrics);
+
   /** Set/Get the exploration radius in the disparity space */
   itkSetMacro(ExplorationRadius, SizeType);
   itkGetConstReferenceMacro(ExplorationRadius, SizeType);
@@ -428,6 +622,16 @@ public:
   const TOutputDisparityImage * GetHorizontalDisparityInput() const;
   const TOutputDisparityImage * GetVerticalDisparityInput() const;
 
+  /** Set the map of the minimum horizontal disparity to explore at each pixel (optional) */
+  void SetMinimumHorizontalDisparityInput( const TOutputDisparityImage * minfield);
+
+  /** Set the map of the maximum horizontal disparity to explore at each pixel (optional) */
+  void SetMaximumHorizontalDisparityInput( const TOutputDisparityImage * maxfield);
+
+  /** Get the horizontal disparity range maps */
+  const TOutputDisparityImage * GetMinimumHorizontalDisparityInput() const;
+  const TOutputDisparityImage * GetMaximumHorizontalDisparityInput() const;
+
   /** Set/Get macro for the subsampling step */
   itkSetMacro(Step, unsigned int);
   itkGetMacro(Step, unsigned int);
@@ -462,6 +666,11 @@ protected:
   void ThreadedGenerateData(const RegionType & outputRegionForThread, itk::ThreadIdType threadId) ITK_OVERRIDE;
 
 private:
+  /** Compute the metric of every pixel of the left region for the given
+   * disparity, with box sums of the per-pixel terms */
+  void ComputeBoxFilterMetric(const RegionType & leftRegion, int hdisparity, int vdisparity,
+                              std::vector<double> & metric) const;
+
   PixelWiseBlockMatchingImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemeFnted
 
@@ -489,6 +698,12 @@ private:
   /** Block-matching functor */
   BlockMatchingFunctorType      m_Functor;
 
+  /** Use running box sums instead of the neighborhoods to compute the metric */
+  bool                          m_UseBoxFilter;
+
+  /** Export the metric values around the best horizontal disparity */
+  bool                          m_ComputeNeighborMetrics;
+
   /** Initial horizontal disparity (0 by default, used if an exploration radius is set and if no input horizontal
     disparity map is given) */
   int                           m_InitHorizontalDisparity;
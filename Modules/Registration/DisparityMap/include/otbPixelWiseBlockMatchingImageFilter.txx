@@ -24,6 +24,7 @@
 #include "otbPixelWiseBlockMatchingImageFilter.h"
 #include "itkProgressReporter.h"
 #include "itkConstantBoundaryCondition.h"
+#include <algorithm>
 
 namespace otb
 {
@@ -65,6 +66,12 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
   // Default step
   m_Step = 1;
 
+  // Neighborhood evaluation of the metric by default
+  m_UseBoxFilter = false;
+
+  // No neighbor metric outputs by default
+  m_ComputeNeighborMetrics = false;
+
   // Default grid index
   m_GridIndex[0] = 0;
   m_GridIndex[1] = 0;
@@ -264,6 +271,89 @@ if (this->GetNumberOfOutputs()<3)
   return static_cast<TOutputDisparityImage *>(this->itk::ProcessObject::GetOutput(2));
 }
 
+template <class TInputImage, class TOutputMetricImage,
+class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+const TOutputMetricImage *
+PixelWiseBlockMatchingImageFilter<TInputImage,TOutputMetricImage,
+TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::GetPreviousHorizontalMetricOutput() const
+{
+  if (this->GetNumberOfOutputs()<4)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TOutputMetricImage *>(this->itk::ProcessObject::GetOutput(3));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+TOutputMetricImage *
+PixelWiseBlockMatchingImageFilter<TInputImage,TOutputMetricImage,
+TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::GetPreviousHorizontalMetricOutput()
+{
+  if (this->GetNumberOfOutputs()<4)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<TOutputMetricImage *>(this->itk::ProcessObject::GetOutput(3));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+const TOutputMetricImage *
+PixelWiseBlockMatchingImageFilter<TInputImage,TOutputMetricImage,
+TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::GetNextHorizontalMetricOutput() const
+{
+  if (this->GetNumberOfOutputs()<5)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TOutputMetricImage *>(this->itk::ProcessObject::GetOutput(4));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+TOutputMetricImage *
+PixelWiseBlockMatchingImageFilter<TInputImage,TOutputMetricImage,
+TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::GetNextHorizontalMetricOutput()
+{
+  if (this->GetNumberOfOutputs()<5)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<TOutputMetricImage *>(this->itk::ProcessObject::GetOutput(4));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+void
+PixelWiseBlockMatchingImageFilter<TInputImage,TOutputMetricImage,
+TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::SetComputeNeighborMetrics(bool flag)
+{
+  if (flag == m_ComputeNeighborMetrics)
+    {
+    return;
+    }
+  m_ComputeNeighborMetrics = flag;
+
+  // The neighbor metric outputs only exist when needed, so that they are
+  // not allocated otherwise
+  if (flag)
+    {
+    this->SetNthOutput(3,TOutputMetricImage::New());
+    this->SetNthOutput(4,TOutputMetricImage::New());
+    }
+  else
+    {
+    this->SetNumberOfIndexedOutputs(3);
+    }
+  this->Modified();
+}
+
 template <class TInputImage, class TOutputMetricImage,
 class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
 void
@@ -314,6 +404,56 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
   return static_cast<const TOutputDisparityImage *>(this->itk::ProcessObject::GetInput(5));
 }
 
+template <class TInputImage, class TOutputMetricImage,
+class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+void
+PixelWiseBlockMatchingImageFilter<TInputImage,TOutputMetricImage,
+TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::SetMinimumHorizontalDisparityInput( const TOutputDisparityImage * minfield)
+{
+  // Process object is not const-correct so the const casting is required.
+  this->SetNthInput(6, const_cast<TOutputDisparityImage *>( minfield ));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+void
+PixelWiseBlockMatchingImageFilter<TInputImage,TOutputMetricImage,
+TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::SetMaximumHorizontalDisparityInput( const TOutputDisparityImage * maxfield)
+{
+  // Process object is not const-correct so the const casting is required.
+  this->SetNthInput(7, const_cast<TOutputDisparityImage *>( maxfield ));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+const TOutputDisparityImage *
+PixelWiseBlockMatchingImageFilter<TInputImage,TOutputMetricImage,
+TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::GetMinimumHorizontalDisparityInput() const
+{
+  if(this->GetNumberOfInputs()<7)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TOutputDisparityImage *>(this->itk::ProcessObject::GetInput(6));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+const TOutputDisparityImage *
+PixelWiseBlockMatchingImageFilter<TInputImage,TOutputMetricImage,
+TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::GetMaximumHorizontalDisparityInput() const
+{
+  if(this->GetNumberOfInputs()<8)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TOutputDisparityImage *>(this->itk::ProcessObject::GetInput(7));
+}
+
 template <class TInputImage, class TOutputMetricImage,
 class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
 void
@@ -360,6 +500,15 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
   outMetricPtr->SetOrigin(outOrigin);
   outHDispPtr->SetOrigin(outOrigin);
   outVDispPtr->SetOrigin(outOrigin);
+
+  // Neighbor metrics share the metric grid
+  TOutputMetricImage * outPrevMetricPtr = this->GetPreviousHorizontalMetricOutput();
+  TOutputMetricImage * outNextMetricPtr = this->GetNextHorizontalMetricOutput();
+  if (outPrevMetricPtr && outNextMetricPtr)
+    {
+    outPrevMetricPtr->CopyInformation(outMetricPtr);
+    outNextMetricPtr->CopyInformation(outMetricPtr);
+    }
 }
 
 template <class TInputImage, class TOutputMetricImage,
@@ -379,6 +528,8 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
   TMaskImage *  inRightMaskPtr  = const_cast<TMaskImage * >(this->GetRightMaskInput());
   TOutputDisparityImage * inHDispPtr = const_cast<TOutputDisparityImage * >(this->GetHorizontalDisparityInput());
   TOutputDisparityImage * inVDispPtr = const_cast<TOutputDisparityImage * >(this->GetVerticalDisparityInput());
+  TOutputDisparityImage * inMinHDispPtr = const_cast<TOutputDisparityImage * >(this->GetMinimumHorizontalDisparityInput());
+  TOutputDisparityImage * inMaxHDispPtr = const_cast<TOutputDisparityImage * >(this->GetMaximumHorizontalDisparityInput());
 
   TOutputMetricImage    * outMetricPtr = this->GetMetricOutput();
   TOutputDisparityImage * outHDispPtr = this->GetHorizontalDisparityOutput();
@@ -419,6 +570,16 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
     itkExceptionMacro(<<"Left image and initial vertical disparity map do not have the same size ! Left largest region: "<<inLeftPtr->GetLargestPossibleRegion()<<", vertical disparity largest region: "<<inVDispPtr->GetLargestPossibleRegion());
     }
 
+  // We check that the disparity range maps have the same size if present
+  if (inMinHDispPtr && inLeftPtr->GetLargestPossibleRegion() != inMinHDispPtr->GetLargestPossibleRegion())
+    {
+    itkExceptionMacro(<<"Left image and minimum horizontal disparity map do not have the same size ! Left largest region: "<<inLeftPtr->GetLargestPossibleRegion()<<", minimum horizontal disparity largest region: "<<inMinHDispPtr->GetLargestPossibleRegion());
+    }
+  if (inMaxHDispPtr && inLeftPtr->GetLargestPossibleRegion() != inMaxHDispPtr->GetLargestPossibleRegion())
+    {
+    itkExceptionMacro(<<"Left image and maximum horizontal disparity map do not have the same size ! Left largest region: "<<inLeftPtr->GetLargestPossibleRegion()<<", maximum horizontal disparity largest region: "<<inMaxHDispPtr->GetLargestPossibleRegion());
+    }
+
   // Sanity check
   if (this->m_Step == 0) this->m_Step = 1;
   this->m_GridIndex[0] = this->m_GridIndex[0] % this->m_Step;
@@ -509,6 +670,12 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
     inVDispPtr->SetRequestedRegion( inputLeftRegion );
     }
 
+  if (inMinHDispPtr && inMaxHDispPtr)
+    {
+    inMinHDispPtr->SetRequestedRegion( inputLeftRegion );
+    inMaxHDispPtr->SetRequestedRegion( inputLeftRegion );
+    }
+
 }
 template <class TInputImage, class TOutputMetricImage,
 class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
@@ -532,6 +699,12 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
                           static_cast<DisparityPixelType>(m_Step));
   outVDispPtr->FillBuffer(static_cast<DisparityPixelType>(m_MinimumVerticalDisparity) /
                           static_cast<DisparityPixelType>(m_Step));
+
+  if (m_ComputeNeighborMetrics)
+    {
+    this->GetPreviousHorizontalMetricOutput()->FillBuffer(itk::NumericTraits<MetricValueType>::max());
+    this->GetNextHorizontalMetricOutput()->FillBuffer(itk::NumericTraits<MetricValueType>::max());
+    }
 }
 
 template <class TInputImage, class TOutputMetricImage,
@@ -548,13 +721,46 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
   const TMaskImage  *     inRightMaskPtr    = this->GetRightMaskInput();
   const TOutputDisparityImage * inHDispPtr = this->GetHorizontalDisparityInput();
   const TOutputDisparityImage * inVDispPtr = this->GetVerticalDisparityInput();
+  const TOutputDisparityImage * inMinHDispPtr = this->GetMinimumHorizontalDisparityInput();
+  const TOutputDisparityImage * inMaxHDispPtr = this->GetMaximumHorizontalDisparityInput();
   TOutputMetricImage    * outMetricPtr = this->GetMetricOutput();
   TOutputDisparityImage * outHDispPtr   = this->GetHorizontalDisparityOutput();
   TOutputDisparityImage * outVDispPtr   = this->GetVerticalDisparityOutput();
+  TOutputMetricImage    * outPrevMetricPtr = this->GetPreviousHorizontalMetricOutput();
+  TOutputMetricImage    * outNextMetricPtr = this->GetNextHorizontalMetricOutput();
+
+  // Compute region for thread at full resolution
+  RegionType fullRegionForThread = this->ConvertSubsampledToFullRegion(outputRegionForThread, this->m_Step, this->m_GridIndex);
+
+  // With disparity range maps, only the union of the ranges of the
+  // region is explored
+  const bool useRangeMaps = (inMinHDispPtr && inMaxHDispPtr);
+  int loopMinHDisp = m_MinimumHorizontalDisparity;
+  int loopMaxHDisp = m_MaximumHorizontalDisparity;
+  if (useRangeMaps)
+    {
+    RegionType rangeRegion = fullRegionForThread;
+    rangeRegion.Crop(inMinHDispPtr->GetBufferedRegion());
+
+    double regionMin = itk::NumericTraits<double>::max();
+    double regionMax = itk::NumericTraits<double>::NonpositiveMin();
+    itk::ImageRegionConstIterator<TOutputDisparityImage> minIt(inMinHDispPtr, rangeRegion);
+    itk::ImageRegionConstIterator<TOutputDisparityImage> maxIt(inMaxHDispPtr, rangeRegion);
+    for (minIt.GoToBegin(), maxIt.GoToBegin(); !minIt.IsAtEnd(); ++minIt, ++maxIt)
+      {
+      regionMin = std::min(regionMin, static_cast<double>(minIt.Get()));
+      regionMax = std::max(regionMax, static_cast<double>(maxIt.Get()));
+      }
+    if (regionMin <= regionMax)
+      {
+      loopMinHDisp = std::max(loopMinHDisp, static_cast<int>(vcl_floor(regionMin)));
+      loopMaxHDisp = std::min(loopMaxHDisp, static_cast<int>(vcl_ceil(regionMax)));
+      }
+    }
 
   // Set-up progress reporting (this is not exact, since we do not
   // account for pixels that are out of range for a given disparity
-  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels()*(m_MaximumHorizontalDisparity - m_MinimumHorizontalDisparity + 1)*(m_MaximumVerticalDisparity - m_MinimumVerticalDisparity + 1),100);
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels()*std::max(loopMaxHDisp - loopMinHDisp + 1, 0)*(m_MaximumVerticalDisparity - m_MinimumVerticalDisparity + 1),100);
 
 
   // Handle initialization properly
@@ -563,8 +769,24 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
   initMaskPtr->Allocate();
   initMaskPtr->FillBuffer(0);
 
-  // Compute region for thread at full resolution
-  RegionType fullRegionForThread = this->ConvertSubsampledToFullRegion(outputRegionForThread, this->m_Step, this->m_GridIndex);
+  // To export the neighbor metrics, keep the last metric evaluated at each
+  // pixel, and the rank of its disparity in the exploration order. The init
+  // mask is set to 2 when this last metric is the current best one.
+  const bool computeNeighborMetrics = m_ComputeNeighborMetrics && outPrevMetricPtr && outNextMetricPtr;
+  const MetricValueType noDataMetric = itk::NumericTraits<MetricValueType>::max();
+  const int nbExploredHDisp = std::max(loopMaxHDisp - loopMinHDisp + 1, 0);
+  typename TOutputMetricImage::Pointer lastMetricPtr;
+  typename DisparityRankImageType::Pointer lastRankPtr;
+  if (computeNeighborMetrics)
+    {
+    lastMetricPtr = TOutputMetricImage::New();
+    lastMetricPtr->SetRegions(outputRegionForThread);
+    lastMetricPtr->Allocate();
+    lastRankPtr = DisparityRankImageType::New();
+    lastRankPtr->SetRegions(outputRegionForThread);
+    lastRankPtr->Allocate();
+    lastRankPtr->FillBuffer(-1);
+    }
 
   // Check if we use initial disparities and exploration radius
   bool useExplorationRadius = false;
@@ -581,10 +803,21 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
   // step value as disparityType
   DisparityPixelType stepDisparityInv = 1. / static_cast<DisparityPixelType>(this->m_Step);
 
+  // With the box filter, the metric is read from a buffer, and the
+  // neighborhood iterators are only used to walk the region
+  const bool useBoxFilter = m_UseBoxFilter
+    && Functor::BlockMatchingBoxFilterTraits<BlockMatchingFunctorType>::IsSupported;
+  SizeType iteratorRadius = m_Radius;
+  if (useBoxFilter)
+    {
+    iteratorRadius.Fill(0);
+    }
+  std::vector<double> boxMetric;
+
   // We loop on disparities
   for(int vdisparity = m_MinimumVerticalDisparity; vdisparity <= m_MaximumVerticalDisparity; ++vdisparity)
     {
-  for(int hdisparity = m_MinimumHorizontalDisparity; hdisparity <= m_MaximumHorizontalDisparity; ++hdisparity)
+  for(int hdisparity = loopMinHDisp; hdisparity <= loopMaxHDisp; ++hdisparity)
     {
     // First, we cast output region to the right image
     IndexType rightRequestedRegionIndex = fullRegionForThread.GetIndex();
@@ -609,9 +842,15 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
     // Compute the equivalent region in subsampled grid
     RegionType outputRegion = this->ConvertFullToSubsampledRegion(inputLeftRegion, this->m_Step, this->m_GridIndex);
 
+    if (useBoxFilter)
+      {
+      this->ComputeBoxFilterMetric(inputLeftRegion, hdisparity, vdisparity, boxMetric);
+      }
+    unsigned long boxOffset = 0;
+
     // Define iterators
-    itk::ConstNeighborhoodIterator<TInputImage>     leftIt(m_Radius,inLeftPtr,inputLeftRegion);
-    itk::ConstNeighborhoodIterator<TInputImage>     rightIt(m_Radius,inRightPtr,inputRightRegion);
+    itk::ConstNeighborhoodIterator<TInputImage>     leftIt(iteratorRadius,inLeftPtr,inputLeftRegion);
+    itk::ConstNeighborhoodIterator<TInputImage>     rightIt(iteratorRadius,inRightPtr,inputRightRegion);
     itk::ImageRegionIterator<TOutputMetricImage>    outMetricIt(outMetricPtr,outputRegion);
     itk::ImageRegionIterator<TOutputDisparityImage> outHDispIt(outHDispPtr,outputRegion);
     itk::ImageRegionIterator<TOutputDisparityImage> outVDispIt(outVDispPtr,outputRegion);
@@ -619,7 +858,25 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
     itk::ImageRegionConstIterator<TMaskImage>       inRightMaskIt;
     itk::ImageRegionConstIterator<TOutputDisparityImage>       inHDispIt;
     itk::ImageRegionConstIterator<TOutputDisparityImage>       inVDispIt;
+    itk::ImageRegionConstIterator<TOutputDisparityImage>       inMinHDispIt;
+    itk::ImageRegionConstIterator<TOutputDisparityImage>       inMaxHDispIt;
     itk::ImageRegionIterator<TMaskImage>            initIt(initMaskPtr,outputRegion);
+    itk::ImageRegionIterator<TOutputMetricImage>    outPrevMetricIt;
+    itk::ImageRegionIterator<TOutputMetricImage>    outNextMetricIt;
+    itk::ImageRegionIterator<TOutputMetricImage>    lastMetricIt;
+    itk::ImageRegionIterator<DisparityRankImageType> lastRankIt;
+    if (computeNeighborMetrics)
+      {
+      outPrevMetricIt = itk::ImageRegionIterator<TOutputMetricImage>(outPrevMetricPtr,outputRegion);
+      outNextMetricIt = itk::ImageRegionIterator<TOutputMetricImage>(outNextMetricPtr,outputRegion);
+      lastMetricIt = itk::ImageRegionIterator<TOutputMetricImage>(lastMetricPtr,outputRegion);
+      lastRankIt = itk::ImageRegionIterator<DisparityRankImageType>(lastRankPtr,outputRegion);
+      outPrevMetricIt.GoToBegin();
+      outNextMetricIt.GoToBegin();
+      lastMetricIt.GoToBegin();
+      lastRankIt.GoToBegin();
+      }
+    const int disparityRank = (vdisparity - m_MinimumVerticalDisparity) * nbExploredHDisp + hdisparity - loopMinHDisp;
 
     itk::ConstantBoundaryCondition<TInputImage> nbc1;
     itk::ConstantBoundaryCondition<TInputImage> nbc2;
@@ -648,6 +905,15 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
       inVDispIt.GoToBegin();
       }
 
+    // If we use disparity range maps, define the iterators
+    if (useRangeMaps)
+      {
+      inMinHDispIt = itk::ImageRegionConstIterator<TOutputDisparityImage>(inMinHDispPtr,inputLeftRegion);
+      inMaxHDispIt = itk::ImageRegionConstIterator<TOutputDisparityImage>(inMaxHDispPtr,inputLeftRegion);
+      inMinHDispIt.GoToBegin();
+      inMaxHDispIt.GoToBegin();
+      }
+
     // Initialize iterators
     leftIt.GoToBegin();
     rightIt.GoToBegin();
@@ -705,12 +971,22 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
                 estimatedMinVDisp = m_MinimumVerticalDisparity;
                 }
               }
+            if (useRangeMaps)
+              {
+              // intersect with the horizontal range of the pixel
+              estimatedMinHDisp = std::max(estimatedMinHDisp, static_cast<int>(vcl_floor(inMinHDispIt.Get())));
+              estimatedMaxHDisp = std::min(estimatedMaxHDisp, static_cast<int>(vcl_ceil(inMaxHDispIt.Get())));
+              }
 
             if (vdisparity >= estimatedMinVDisp && vdisparity <= estimatedMaxVDisp &&
                 hdisparity >= estimatedMinHDisp && hdisparity <= estimatedMaxHDisp)
               {
               // Compute the block matching value
-            double metric = m_Functor(leftIt,rightIt);
+              double metric = useBoxFilter ?
+                static_cast<double>(static_cast<MetricValueType>(boxMetric[boxOffset]))
+                : static_cast<double>(m_Functor(leftIt,rightIt));
+
+              bool isBest = false;
 
               // If we are at first loop, fill both outputs
               // We adapt the disparity value to keep consistent with disparity map index space
@@ -720,18 +996,43 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
                 outVDispIt.Set(static_cast<DisparityPixelType>(vdisparity) * stepDisparityInv);
                 outMetricIt.Set(metric);
                 initIt.Set(1);
+                isBest = true;
                 }
               else if(m_Minimize && metric < outMetricIt.Get())
                 {
                 outHDispIt.Set(static_cast<DisparityPixelType>(hdisparity) * stepDisparityInv);
                 outVDispIt.Set(static_cast<DisparityPixelType>(vdisparity) * stepDisparityInv);
                 outMetricIt.Set(metric);
+                isBest = true;
                 }
               else if(!m_Minimize && metric > outMetricIt.Get())
                 {
                 outHDispIt.Set(static_cast<DisparityPixelType>(hdisparity) * stepDisparityInv);
                 outVDispIt.Set(static_cast<DisparityPixelType>(vdisparity) * stepDisparityInv);
                 outMetricIt.Set(metric);
+                isBest = true;
+                }
+
+              if (computeNeighborMetrics)
+                {
+                // Was the previous evaluation at this pixel done at hdisparity-1 ?
+                const bool followsPrevious = (hdisparity > loopMinHDisp && lastRankIt.Get() == disparityRank - 1);
+                if (isBest)
+                  {
+                  outPrevMetricIt.Set(followsPrevious ? lastMetricIt.Get() : noDataMetric);
+                  outNextMetricIt.Set(noDataMetric);
+                  initIt.Set(2);
+                  }
+                else
+                  {
+                  if (followsPrevious && initIt.Get() == 2)
+                    {
+                    outNextMetricIt.Set(metric);
+                    }
+                  initIt.Set(1);
+                  }
+                lastMetricIt.Set(metric);
+                lastRankIt.Set(disparityRank);
                 }
               }
             }
@@ -740,10 +1041,18 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
         ++outHDispIt;
         ++outVDispIt;
         ++initIt;
+        if (computeNeighborMetrics)
+          {
+          ++outPrevMetricIt;
+          ++outNextMetricIt;
+          ++lastMetricIt;
+          ++lastRankIt;
+          }
         progress.CompletedPixel();
         }
       ++leftIt;
       ++rightIt;
+      ++boxOffset;
 
       if(inLeftMaskPtr)
         {
@@ -760,9 +1069,136 @@ TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
         ++inHDispIt;
         ++inVDispIt;
         }
+
+      if(useRangeMaps)
+        {
+        ++inMinHDispIt;
+        ++inMaxHDispIt;
+        }
+      }
+
+    }
+    }
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TOutputDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+void
+PixelWiseBlockMatchingImageFilter<TInputImage,TOutputMetricImage,
+TOutputDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::ComputeBoxFilterMetric(const RegionType & leftRegion, int hdisparity, int vdisparity,
+                         std::vector<double> & metric) const
+{
+  typedef Functor::BlockMatchingBoxFilterTraits<BlockMatchingFunctorType> BoxFilterTraitsType;
+  const unsigned int nbTerms = BoxFilterTraitsType::NumberOfTerms;
+
+  const TInputImage * inLeftPtr  = this->GetLeftInput();
+  const TInputImage * inRightPtr = this->GetRightInput();
+
+  const unsigned int width  = leftRegion.GetSize(0);
+  const unsigned int height = leftRegion.GetSize(1);
+  const unsigned int winX = 2 * m_Radius[0] + 1;
+  const unsigned int winY = 2 * m_Radius[1] + 1;
+  const unsigned int paddedWidth  = width + winX - 1;
+  const unsigned int paddedHeight = height + winY - 1;
+  const double blockSize = static_cast<double>(winX) * static_cast<double>(winY);
+
+  metric.resize(width * height);
+  if (width == 0 || height == 0)
+    {
+    return;
+    }
+
+  // Per-pixel terms on the left region padded by the radius. As with the
+  // ConstantBoundaryCondition of the neighborhood iterators, pixels
+  // outside the buffered regions are 0.
+  const RegionType & leftBuffer  = inLeftPtr->GetBufferedRegion();
+  const RegionType & rightBuffer = inRightPtr->GetBufferedRegion();
+  const typename TInputImage::PixelType * leftData  = inLeftPtr->GetBufferPointer();
+  const typename TInputImage::PixelType * rightData = inRightPtr->GetBufferPointer();
+
+  std::vector<double> terms(paddedWidth * paddedHeight * nbTerms);
+
+  const long startX = leftRegion.GetIndex(0) - static_cast<long>(m_Radius[0]);
+  const long startY = leftRegion.GetIndex(1) - static_cast<long>(m_Radius[1]);
+
+  for (unsigned int py = 0; py < paddedHeight; ++py)
+    {
+    const long leftY  = startY + py;
+    const long rightY = leftY + vdisparity;
+    const bool leftRowInside = leftY >= leftBuffer.GetIndex(1)
+      && leftY < leftBuffer.GetIndex(1) + static_cast<long>(leftBuffer.GetSize(1));
+    const bool rightRowInside = rightY >= rightBuffer.GetIndex(1)
+      && rightY < rightBuffer.GetIndex(1) + static_cast<long>(rightBuffer.GetSize(1));
+    const long leftRowOffset = (leftY - leftBuffer.GetIndex(1)) * static_cast<long>(leftBuffer.GetSize(0));
+    const long rightRowOffset = (rightY - rightBuffer.GetIndex(1)) * static_cast<long>(rightBuffer.GetSize(0));
+
+    double * rowTerms = &terms[py * paddedWidth * nbTerms];
+
+    for (unsigned int px = 0; px < paddedWidth; ++px)
+      {
+      const long leftX  = startX + px - leftBuffer.GetIndex(0);
+      const long rightX = startX + px + hdisparity - rightBuffer.GetIndex(0);
+
+      double a = 0.;
+      double b = 0.;
+      if (leftRowInside && leftX >= 0 && leftX < static_cast<long>(leftBuffer.GetSize(0)))
+        {
+        a = static_cast<double>(leftData[leftRowOffset + leftX]);
+        }
+      if (rightRowInside && rightX >= 0 && rightX < static_cast<long>(rightBuffer.GetSize(0)))
+        {
+        b = static_cast<double>(rightData[rightRowOffset + rightX]);
+        }
+      BoxFilterTraitsType::ComputeTerms(m_Functor, a, b, rowTerms + px * nbTerms);
       }
+    }
 
+  // Sums over the block height, for each column of the padded region,
+  // updated row after row
+  const unsigned int rowLength = paddedWidth * nbTerms;
+  std::vector<double> columnSums(rowLength, 0.);
+  for (unsigned int py = 0; py < winY; ++py)
+    {
+    const double * rowTerms = &terms[py * rowLength];
+    for (unsigned int k = 0; k < rowLength; ++k)
+      {
+      columnSums[k] += rowTerms[k];
+      }
     }
+
+  std::vector<double> sums(nbTerms);
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    if (y > 0)
+      {
+      const double * addedRow   = &terms[(y + winY - 1) * rowLength];
+      const double * removedRow = &terms[(y - 1) * rowLength];
+      for (unsigned int k = 0; k < rowLength; ++k)
+        {
+        columnSums[k] += addedRow[k] - removedRow[k];
+        }
+      }
+
+    // Running sum over the block width
+    std::fill(sums.begin(), sums.end(), 0.);
+    for (unsigned int px = 0; px < winX; ++px)
+      {
+      for (unsigned int k = 0; k < nbTerms; ++k)
+        {
+        sums[k] += columnSums[px * nbTerms + k];
+        }
+      }
+    metric[y * width] = BoxFilterTraitsType::ComputeMetric(m_Functor, &sums[0], blockSize);
+
+    for (unsigned int x = 1; x < width; ++x)
+      {
+      for (unsigned int k = 0; k < nbTerms; ++k)
+        {
+        sums[k] += columnSums[(x + winX - 1) * nbTerms + k] - columnSums[(x - 1) * nbTerms + k];
+        }
+      metric[y * width + x] = BoxFilterTraitsType::ComputeMetric(m_Functor, &sums[0], blockSize);
+      }
     }
 }
 
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbSemiGlobalMatchingImageFilter_h
+#define otbSemiGlobalMatchingImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkIntTypes.h"
+#include "otbImage.h"
+#include <vector>
+
+namespace otb
+{
+
+/** \class SemiGlobalMatchingImageFilter
+ *  \brief Dense disparity estimation by Semi-Global Matching
+ *
+ *  This filter estimates the horizontal disparity between a pair of
+ *  images in epipolar geometry (see
+ *  StereorectificationDisplacementFieldSource), with the Semi-Global
+ *  Matching method of H. Hirschmuller.
+ *
+ *  The matching cost is the Hamming distance between the census
+ *  transforms of the left and right images, computed on a window
+ *  whose radius is set with SetRadius() (1 to 3). The costs are then
+ *  aggregated along 4, 8 or 16 paths (SetNumberOfPaths()), with a
+ *  penalty P1 for disparity changes of one pixel and P2 for larger
+ *  changes. The disparity minimizing the aggregated cost is selected,
+ *  and refined by a parabola fit unless SubPixelInterpolationOff() is
+ *  called.
+ *
+ *  The aggregation paths cannot follow the image across tiles: each
+ *  block is processed with a margin of TileMargin pixels (32 by
+ *  default) on each side, which gives enough context to the paths for
+ *  the result to be independent of the streaming in practice. Costs
+ *  are stored on 8 bits and aggregated costs on 16 bits. Blocks are
+ *  sized so that the cost volumes of all the threads fit in the
+ *  MaximumMemory (in MB), which defaults to the RAM hint of the
+ *  ConfigurationManager.
+ *
+ *  The outputs follow the layout of the
+ *  PixelWiseBlockMatchingImageFilter: the first is the metric image
+ *  (aggregated cost of the selected disparity), the second and third
+ *  are the horizontal and vertical disparity maps. The vertical
+ *  disparity is always 0. Pixels for which the left mask is null get
+ *  a null metric and the maximum disparity. Pixels for which the
+ *  right mask is null can not be matched.
+ *
+ *  \sa PixelWiseBlockMatchingImageFilter
+ *  \sa StereorectificationDisplacementFieldSource
+ *
+ *  \ingroup Streamed
+ *  \ingroup Threaded
+ *
+ * \ingroup OTBDisparityMap
+ */
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage = TOutputMetricImage,
+          class TMaskImage = otb::Image<unsigned char> >
+class ITK_EXPORT SemiGlobalMatchingImageFilter :
+    public itk::ImageToImageFilter<TInputImage, TOutputDisparityImage>
+{
+public:
+  /** Standard class typedef */
+  typedef SemiGlobalMatchingImageFilter                               Self;
+  typedef itk::ImageToImageFilter<TInputImage, TOutputDisparityImage> Superclass;
+  typedef itk::SmartPointer<Self>                                     Pointer;
+  typedef itk::SmartPointer<const Self>                               ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(SemiGlobalMatchingImageFilter, ImageToImageFilter);
+
+  /** Useful typedefs */
+  typedef TInputImage                                       InputImageType;
+  typedef TOutputMetricImage                                OutputMetricImageType;
+  typedef TOutputDisparityImage                             OutputDisparityImageType;
+  typedef TMaskImage                                        InputMaskImageType;
+
+  typedef typename InputImageType::SizeType                 SizeType;
+  typedef typename InputImageType::IndexType                IndexType;
+  typedef typename InputImageType::RegionType               RegionType;
+
+  typedef typename TOutputMetricImage::ValueType            MetricValueType;
+  typedef typename OutputDisparityImageType::PixelType      DisparityPixelType;
+
+  /** Census transform of a pixel */
+  typedef itk::uint64_t                                     CensusType;
+
+  /** Matching cost (Hamming distance between census transforms) */
+  typedef unsigned char                                     CostType;
+
+  /** Cost aggregated along one path, and summed over the paths */
+  typedef unsigned short                                    AggregatedCostType;
+
+  /** Set left input */
+  void SetLeftInput(const TInputImage * image);
+
+  /** Set right input */
+  void SetRightInput(const TInputImage * image);
+
+  /** Set mask input (optional) */
+  void SetLeftMaskInput(const TMaskImage * image);
+
+  /** Set right mask input (optional) */
+  void SetRightMaskInput(const TMaskImage * image);
+
+  /** Get the inputs */
+  const TInputImage * GetLeftInput() const;
+  const TInputImage * GetRightInput() const;
+  const TMaskImage  * GetLeftMaskInput() const;
+  const TMaskImage  * GetRightMaskInput() const;
+
+  /** Get the metric output */
+  const TOutputMetricImage * GetMetricOutput() const;
+  TOutputMetricImage * GetMetricOutput();
+
+  /** Get the disparity output */
+  const TOutputDisparityImage * GetHorizontalDisparityOutput() const;
+  TOutputDisparityImage * GetHorizontalDisparityOutput();
+
+  /** Get the disparity output */
+  const TOutputDisparityImage * GetVerticalDisparityOutput() const;
+  TOutputDisparityImage * GetVerticalDisparityOutput();
+
+  /** Set/Get the radius of the census window (1 to 3) */
+  itkSetClampMacro(Radius, unsigned int, 1, 3);
+  itkGetConstMacro(Radius, unsigned int);
+
+  /*** Set/Get the minimum disparity to explore */
+  itkSetMacro(MinimumHorizontalDisparity, int);
+  itkGetConstReferenceMacro(MinimumHorizontalDisparity, int);
+
+  /*** Set/Get the maximum disparity to explore */
+  itkSetMacro(MaximumHorizontalDisparity, int);
+  itkGetConstReferenceMacro(MaximumHorizontalDisparity, int);
+
+  /** Set/Get the penalty of one pixel disparity changes */
+  itkSetMacro(P1, unsigned int);
+  itkGetConstMacro(P1, unsigned int);
+
+  /** Set/Get the penalty of larger disparity changes */
+  itkSetMacro(P2, unsigned int);
+  itkGetConstMacro(P2, unsigned int);
+
+  /** Set/Get the number of aggregation paths (4, 8 or 16) */
+  itkSetMacro(NumberOfPaths, unsigned int);
+  itkGetConstMacro(NumberOfPaths, unsigned int);
+
+  /** Set/Get the margin added around each block, in pixels */
+  itkSetMacro(TileMargin, unsigned int);
+  itkGetConstMacro(TileMargin, unsigned int);
+
+  /** Set/Get the memory available for the cost volumes, in MB (0 means
+   * the RAM hint of the ConfigurationManager) */
+  itkSetMacro(MaximumMemory, unsigned int);
+  itkGetConstMacro(MaximumMemory, unsigned int);
+
+  /** Set/Get the sub-pixel refinement of the disparities */
+  itkSetMacro(SubPixelInterpolation, bool);
+  itkGetConstMacro(SubPixelInterpolation, bool);
+  itkBooleanMacro(SubPixelInterpolation);
+
+protected:
+  /** Constructor */
+  SemiGlobalMatchingImageFilter();
+
+  /** Destructor */
+  ~SemiGlobalMatchingImageFilter() ITK_OVERRIDE;
+
+  /** Generate input requested region */
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  /** Before threaded generate data */
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  /** Threaded generate data */
+  void ThreadedGenerateData(const RegionType & outputRegionForThread, itk::ThreadIdType threadId) ITK_OVERRIDE;
+
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+private:
+  SemiGlobalMatchingImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  /** Estimate the disparities of one block of the output */
+  void ProcessBlock(const RegionType & outputBlock);
+
+  /** Census transform of the image on the region, the pixels outside
+   * the buffered region being replaced by the nearest buffered pixel */
+  void ComputeCensus(const TInputImage * image, const RegionType & region,
+                     std::vector<CensusType> & census) const;
+
+  /** Aggregate the costs along the direction (dx, dy) and add them
+   * to the summed costs */
+  void AggregatePath(const std::vector<CostType> & costs, unsigned int width, unsigned int height,
+                     int dx, int dy, std::vector<AggregatedCostType> & summedCosts) const;
+
+  /** Number of differing bits between two census transforms */
+  static CostType HammingDistance(CensusType a, CensusType b)
+  {
+    CensusType v = a ^ b;
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<CostType>((v * 0x0101010101010101ULL) >> 56);
+  }
+
+  /** Number of rows of the blocks processed by each thread, given the
+   * width of the blocks and the rows added by their margin */
+  unsigned int ComputeBlockHeight(unsigned int paddedWidth, unsigned int extraRows,
+                                  unsigned int numberOfThreads) const;
+
+  /** The radius of the census window */
+  unsigned int                  m_Radius;
+
+  /** The min disparity to explore */
+  int                           m_MinimumHorizontalDisparity;
+
+  /** The max disparity to explore */
+  int                           m_MaximumHorizontalDisparity;
+
+  /** Penalty of one pixel disparity changes */
+  unsigned int                  m_P1;
+
+  /** Penalty of larger disparity changes */
+  unsigned int                  m_P2;
+
+  /** Number of aggregation paths */
+  unsigned int                  m_NumberOfPaths;
+
+  /** Margin around each block */
+  unsigned int                  m_TileMargin;
+
+  /** Memory available for the cost volumes (in MB) */
+  unsigned int                  m_MaximumMemory;
+
+  /** Sub-pixel refinement flag */
+  bool                          m_SubPixelInterpolation;
+
+  /** Number of rows of the blocks, computed before the threads start */
+  unsigned int                  m_BlockHeight;
+};
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbSemiGlobalMatchingImageFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,731 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbSemiGlobalMatchingImageFilter_txx
+#define otbSemiGlobalMatchingImageFilter_txx
+
+#include "otbSemiGlobalMatchingImageFilter.h"
+#include "otbConfigurationManager.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace otb
+{
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::SemiGlobalMatchingImageFilter()
+{
+  // Set the number of inputs
+  this->SetNumberOfRequiredInputs(2);
+
+  // Set the outputs
+  this->SetNumberOfRequiredOutputs(3);
+  this->SetNthOutput(0, TOutputMetricImage::New());
+  this->SetNthOutput(1, TOutputDisparityImage::New());
+  this->SetNthOutput(2, TOutputDisparityImage::New());
+
+  // Default parameters
+  m_Radius = 2;
+  m_MinimumHorizontalDisparity = -10;
+  m_MaximumHorizontalDisparity =  10;
+  m_P1 = 8;
+  m_P2 = 32;
+  m_NumberOfPaths = 8;
+  m_TileMargin = 32;
+  m_MaximumMemory = 0;
+  m_SubPixelInterpolation = true;
+  m_BlockHeight = 1;
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::~SemiGlobalMatchingImageFilter()
+{}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+void
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::SetLeftInput(const TInputImage * image)
+{
+  // Process object is not const-correct so the const casting is required.
+  this->SetNthInput(0, const_cast<TInputImage *>(image));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+void
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::SetRightInput(const TInputImage * image)
+{
+  // Process object is not const-correct so the const casting is required.
+  this->SetNthInput(1, const_cast<TInputImage *>(image));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+void
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::SetLeftMaskInput(const TMaskImage * image)
+{
+  // Process object is not const-correct so the const casting is required.
+  this->SetNthInput(2, const_cast<TMaskImage *>(image));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+void
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::SetRightMaskInput(const TMaskImage * image)
+{
+  // Process object is not const-correct so the const casting is required.
+  this->SetNthInput(3, const_cast<TMaskImage *>(image));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+const TInputImage *
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::GetLeftInput() const
+{
+  if (this->GetNumberOfInputs() < 1)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TInputImage *>(this->itk::ProcessObject::GetInput(0));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+const TInputImage *
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::GetRightInput() const
+{
+  if (this->GetNumberOfInputs() < 2)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TInputImage *>(this->itk::ProcessObject::GetInput(1));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+const TMaskImage *
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::GetLeftMaskInput() const
+{
+  if (this->GetNumberOfInputs() < 3)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TMaskImage *>(this->itk::ProcessObject::GetInput(2));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+const TMaskImage *
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::GetRightMaskInput() const
+{
+  if (this->GetNumberOfInputs() < 4)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TMaskImage *>(this->itk::ProcessObject::GetInput(3));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+const TOutputMetricImage *
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::GetMetricOutput() const
+{
+  if (this->GetNumberOfOutputs() < 1)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TOutputMetricImage *>(this->itk::ProcessObject::GetOutput(0));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+TOutputMetricImage *
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::GetMetricOutput()
+{
+  if (this->GetNumberOfOutputs() < 1)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<TOutputMetricImage *>(this->itk::ProcessObject::GetOutput(0));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+const TOutputDisparityImage *
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::GetHorizontalDisparityOutput() const
+{
+  if (this->GetNumberOfOutputs() < 2)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TOutputDisparityImage *>(this->itk::ProcessObject::GetOutput(1));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+TOutputDisparityImage *
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::GetHorizontalDisparityOutput()
+{
+  if (this->GetNumberOfOutputs() < 2)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<TOutputDisparityImage *>(this->itk::ProcessObject::GetOutput(1));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+const TOutputDisparityImage *
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::GetVerticalDisparityOutput() const
+{
+  if (this->GetNumberOfOutputs() < 3)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TOutputDisparityImage *>(this->itk::ProcessObject::GetOutput(2));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+TOutputDisparityImage *
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::GetVerticalDisparityOutput()
+{
+  if (this->GetNumberOfOutputs() < 3)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<TOutputDisparityImage *>(this->itk::ProcessObject::GetOutput(2));
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+void
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::GenerateInputRequestedRegion()
+{
+  // Call superclass implementation
+  Superclass::GenerateInputRequestedRegion();
+
+  // Retrieve input pointers
+  TInputImage * inLeftPtr  = const_cast<TInputImage *>(this->GetLeftInput());
+  TInputImage * inRightPtr = const_cast<TInputImage *>(this->GetRightInput());
+  TMaskImage *  inLeftMaskPtr  = const_cast<TMaskImage *>(this->GetLeftMaskInput());
+  TMaskImage *  inRightMaskPtr = const_cast<TMaskImage *>(this->GetRightMaskInput());
+
+  TOutputMetricImage * outMetricPtr = this->GetMetricOutput();
+
+  // Check pointers before using them
+  if (!inLeftPtr || !inRightPtr || !outMetricPtr)
+    {
+    return;
+    }
+
+  // Now, we impose that both inputs have the same size
+  if (inLeftPtr->GetLargestPossibleRegion() != inRightPtr->GetLargestPossibleRegion())
+    {
+    itkExceptionMacro(<<"Left and right images do not have the same size ! Left largest region: "<<inLeftPtr->GetLargestPossibleRegion()<<", right largest region: "<<inRightPtr->GetLargestPossibleRegion());
+    }
+
+  // We also check that the masks have the same size if present
+  if (inLeftMaskPtr && inLeftPtr->GetLargestPossibleRegion() != inLeftMaskPtr->GetLargestPossibleRegion())
+    {
+    itkExceptionMacro(<<"Left and mask images do not have the same size ! Left largest region: "<<inLeftPtr->GetLargestPossibleRegion()<<", mask largest region: "<<inLeftMaskPtr->GetLargestPossibleRegion());
+    }
+  if (inRightMaskPtr && inRightPtr->GetLargestPossibleRegion() != inRightMaskPtr->GetLargestPossibleRegion())
+    {
+    itkExceptionMacro(<<"Right and mask images do not have the same size ! Right largest region: "<<inRightPtr->GetLargestPossibleRegion()<<", mask largest region: "<<inRightMaskPtr->GetLargestPossibleRegion());
+    }
+
+  // The blocks are processed with their margin, and the census
+  // transform needs its window around them
+  RegionType inputLeftRegion = outMetricPtr->GetRequestedRegion();
+  SizeType padding;
+  padding.Fill(m_TileMargin + m_Radius);
+  inputLeftRegion.PadByRadius(padding);
+
+  // The right region covers the explored disparities
+  RegionType inputRightRegion = inputLeftRegion;
+  IndexType rightIndex = inputRightRegion.GetIndex();
+  SizeType  rightSize  = inputRightRegion.GetSize();
+  rightIndex[0] += m_MinimumHorizontalDisparity;
+  rightSize[0]  += m_MaximumHorizontalDisparity - m_MinimumHorizontalDisparity;
+  inputRightRegion.SetIndex(rightIndex);
+  inputRightRegion.SetSize(rightSize);
+
+  // crop the left region at the left's largest possible region
+  if (inputLeftRegion.Crop(inLeftPtr->GetLargestPossibleRegion()))
+    {
+    inLeftPtr->SetRequestedRegion(inputLeftRegion);
+    }
+  else
+    {
+    // Couldn't crop the region (requested region is outside the largest
+    // possible region).  Throw an exception.
+    // store what we tried to request (prior to trying to crop)
+    inLeftPtr->SetRequestedRegion(inputLeftRegion);
+
+    // build an exception
+    itk::InvalidRequestedRegionError e(__FILE__, __LINE__);
+    std::ostringstream msg;
+    msg << this->GetNameOfClass()
+                << "::GenerateInputRequestedRegion()";
+    e.SetLocation(msg.str().c_str());
+    e.SetDescription("Requested region is (at least partially) outside the largest possible region of left image.");
+    e.SetDataObject(inLeftPtr);
+    throw e;
+    }
+
+  // crop the right region at the right's largest possible region
+  if (inputRightRegion.Crop(inRightPtr->GetLargestPossibleRegion()))
+    {
+    inRightPtr->SetRequestedRegion(inputRightRegion);
+    }
+  else
+    {
+    // Couldn't crop the region (requested region is outside the largest
+    // possible region).  Throw an exception.
+    // store what we tried to request (prior to trying to crop)
+    inRightPtr->SetRequestedRegion(inputRightRegion);
+
+    // build an exception
+    itk::InvalidRequestedRegionError e(__FILE__, __LINE__);
+    std::ostringstream msg;
+    msg << this->GetNameOfClass()
+                << "::GenerateInputRequestedRegion()";
+    e.SetLocation(msg.str().c_str());
+    e.SetDescription("Requested region is (at least partially) outside the largest possible region of right image.");
+    e.SetDataObject(inRightPtr);
+    throw e;
+    }
+
+  if (inLeftMaskPtr)
+    {
+    // no need to crop the mask region : left mask and left image have same largest possible region
+    inLeftMaskPtr->SetRequestedRegion(inputLeftRegion);
+    }
+
+  if (inRightMaskPtr)
+    {
+    // no need to crop the mask region : right mask and right image have same largest possible region
+    inRightMaskPtr->SetRequestedRegion(inputRightRegion);
+    }
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+void
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::BeforeThreadedGenerateData()
+{
+  if (m_NumberOfPaths != 4 && m_NumberOfPaths != 8 && m_NumberOfPaths != 16)
+    {
+    itkExceptionMacro(<<"Number of paths must be 4, 8 or 16, not "<<m_NumberOfPaths);
+    }
+  if (m_MaximumHorizontalDisparity < m_MinimumHorizontalDisparity)
+    {
+    itkExceptionMacro(<<"Maximum disparity "<<m_MaximumHorizontalDisparity<<" is lower than minimum disparity "<<m_MinimumHorizontalDisparity);
+    }
+  if (m_P1 > m_P2)
+    {
+    itkExceptionMacro(<<"P1 ("<<m_P1<<") must not be greater than P2 ("<<m_P2<<")");
+    }
+
+  // The cost aggregated along a path is bounded by the maximum cost plus
+  // P2, the sum over the paths must fit in the aggregated cost type
+  const unsigned int maxCost = (2 * m_Radius + 1) * (2 * m_Radius + 1) - 1;
+  if (static_cast<double>(m_NumberOfPaths) * (maxCost + m_P2)
+      > static_cast<double>(std::numeric_limits<AggregatedCostType>::max()))
+    {
+    itkExceptionMacro(<<"P2 ("<<m_P2<<") is too large for "<<m_NumberOfPaths<<" paths");
+    }
+
+  TOutputMetricImage    * outMetricPtr = this->GetMetricOutput();
+  TOutputDisparityImage * outHDispPtr  = this->GetHorizontalDisparityOutput();
+  TOutputDisparityImage * outVDispPtr  = this->GetVerticalDisparityOutput();
+
+  // Fill buffers with default values
+  outMetricPtr->FillBuffer(0.);
+  outHDispPtr->FillBuffer(static_cast<DisparityPixelType>(m_MaximumHorizontalDisparity));
+  outVDispPtr->FillBuffer(0.);
+
+  // Size of the blocks with their margin, which can not exceed the left
+  // buffered region
+  RegionType paddedRegion = outMetricPtr->GetRequestedRegion();
+  SizeType margin;
+  margin.Fill(m_TileMargin);
+  paddedRegion.PadByRadius(margin);
+  paddedRegion.Crop(this->GetLeftInput()->GetBufferedRegion());
+
+  const unsigned int extraRows = paddedRegion.GetSize(1) - outMetricPtr->GetRequestedRegion().GetSize(1);
+  m_BlockHeight = this->ComputeBlockHeight(paddedRegion.GetSize(0), extraRows, this->GetNumberOfThreads());
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+unsigned int
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::ComputeBlockHeight(unsigned int paddedWidth, unsigned int extraRows, unsigned int numberOfThreads) const
+{
+  double availableMemory = m_MaximumMemory;
+  if (m_MaximumMemory == 0)
+    {
+    availableMemory = static_cast<double>(ConfigurationManager::GetMaxRAMHint());
+    }
+  availableMemory *= 1024. * 1024. / std::max(numberOfThreads, 1U);
+
+  const double nbDisp = m_MaximumHorizontalDisparity - m_MinimumHorizontalDisparity + 1;
+
+  // Per row: costs, summed costs and both census transforms. The path
+  // costs are kept on at most three rows.
+  const double rowMemory = static_cast<double>(paddedWidth) * nbDisp * (sizeof(CostType) + sizeof(AggregatedCostType))
+    + (2 * paddedWidth + nbDisp) * sizeof(CensusType);
+  const double pathMemory = 3. * paddedWidth * (nbDisp + 1) * sizeof(AggregatedCostType);
+
+  const double nbRows = (availableMemory - pathMemory) / rowMemory - extraRows;
+  if (nbRows < 1.)
+    {
+    return 1;
+    }
+  if (nbRows > static_cast<double>(std::numeric_limits<unsigned int>::max()))
+    {
+    return std::numeric_limits<unsigned int>::max();
+    }
+  return static_cast<unsigned int>(nbRows);
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+void
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::ThreadedGenerateData(const RegionType & outputRegionForThread, itk::ThreadIdType threadId)
+{
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels(), 100);
+
+  // The region of the thread is split in blocks of rows, so that the
+  // cost volumes stay within the available memory
+  const long startRow = static_cast<long>(outputRegionForThread.GetIndex(1));
+  const long endRow = startRow + static_cast<long>(outputRegionForThread.GetSize(1));
+
+  for (long row = startRow; row < endRow; row += m_BlockHeight)
+    {
+    RegionType block = outputRegionForThread;
+    IndexType blockIndex = block.GetIndex();
+    SizeType  blockSize = block.GetSize();
+    blockIndex[1] = row;
+    blockSize[1] = std::min(static_cast<long>(m_BlockHeight), endRow - row);
+    block.SetIndex(blockIndex);
+    block.SetSize(blockSize);
+
+    this->ProcessBlock(block);
+
+    for (unsigned long i = 0; i < block.GetNumberOfPixels(); ++i)
+      {
+      progress.CompletedPixel();
+      }
+    }
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+void
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::ProcessBlock(const RegionType & outputBlock)
+{
+  const TInputImage * inLeftPtr      = this->GetLeftInput();
+  const TInputImage * inRightPtr     = this->GetRightInput();
+  const TMaskImage  * inLeftMaskPtr  = this->GetLeftMaskInput();
+  const TMaskImage  * inRightMaskPtr = this->GetRightMaskInput();
+  TOutputMetricImage    * outMetricPtr = this->GetMetricOutput();
+  TOutputDisparityImage * outHDispPtr  = this->GetHorizontalDisparityOutput();
+
+  const unsigned int nbDisp = m_MaximumHorizontalDisparity - m_MinimumHorizontalDisparity + 1;
+
+  // The block is processed with its margin, so that the aggregation paths
+  // have some context at its borders
+  RegionType region = outputBlock;
+  SizeType margin;
+  margin.Fill(m_TileMargin);
+  region.PadByRadius(margin);
+  region.Crop(inLeftPtr->GetBufferedRegion());
+
+  const unsigned int width  = region.GetSize(0);
+  const unsigned int height = region.GetSize(1);
+  const long startX = region.GetIndex(0);
+  const long startY = region.GetIndex(1);
+
+  // Census transforms, on the disparity range for the right image
+  RegionType rightRegion = region;
+  IndexType rightIndex = rightRegion.GetIndex();
+  SizeType  rightSize  = rightRegion.GetSize();
+  rightIndex[0] += m_MinimumHorizontalDisparity;
+  rightSize[0]  += nbDisp - 1;
+  rightRegion.SetIndex(rightIndex);
+  rightRegion.SetSize(rightSize);
+  const unsigned int rightWidth = rightSize[0];
+
+  std::vector<CensusType> leftCensus;
+  std::vector<CensusType> rightCensus;
+  this->ComputeCensus(inLeftPtr, region, leftCensus);
+  this->ComputeCensus(inRightPtr, rightRegion, rightCensus);
+
+  // Right pixels which can be matched: inside the right buffered region,
+  // and valid in the right mask
+  const RegionType & rightBuffer = inRightPtr->GetBufferedRegion();
+  std::vector<bool> rightValid(rightWidth * height);
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    for (unsigned int x = 0; x < rightWidth; ++x)
+      {
+      IndexType index;
+      index[0] = rightIndex[0] + x;
+      index[1] = startY + y;
+      bool valid = rightBuffer.IsInside(index);
+      if (valid && inRightMaskPtr)
+        {
+        valid = inRightMaskPtr->GetPixel(index) > 0;
+        }
+      rightValid[y * rightWidth + x] = valid;
+      }
+    }
+
+  // Cost volume, the unmatched pixels getting the maximum cost
+  const CostType invalidCost = static_cast<CostType>((2 * m_Radius + 1) * (2 * m_Radius + 1) - 1);
+  std::vector<CostType> costs(static_cast<size_t>(width) * height * nbDisp);
+
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    for (unsigned int x = 0; x < width; ++x)
+      {
+      const CensusType leftValue = leftCensus[y * width + x];
+      CostType * pixelCosts = &costs[(static_cast<size_t>(y) * width + x) * nbDisp];
+      const size_t rightOffset = static_cast<size_t>(y) * rightWidth + x;
+
+      for (unsigned int d = 0; d < nbDisp; ++d)
+        {
+        pixelCosts[d] = rightValid[rightOffset + d] ?
+          HammingDistance(leftValue, rightCensus[rightOffset + d]) : invalidCost;
+        }
+      }
+    }
+
+  // Aggregation along the paths
+  static const int directions[16][2] = {
+    { 1,  0}, {-1,  0}, { 0,  1}, { 0, -1},
+    { 1,  1}, {-1, -1}, { 1, -1}, {-1,  1},
+    { 2,  1}, {-2, -1}, { 2, -1}, {-2,  1},
+    { 1,  2}, {-1, -2}, { 1, -2}, {-1,  2}};
+
+  std::vector<AggregatedCostType> summedCosts(costs.size(), 0);
+  for (unsigned int p = 0; p < m_NumberOfPaths; ++p)
+    {
+    this->AggregatePath(costs, width, height, directions[p][0], directions[p][1], summedCosts);
+    }
+
+  // Disparity selection on the block
+  itk::ImageRegionIterator<TOutputMetricImage>             outMetricIt(outMetricPtr, outputBlock);
+  itk::ImageRegionIteratorWithIndex<TOutputDisparityImage> outHDispIt(outHDispPtr, outputBlock);
+
+  for (outMetricIt.GoToBegin(), outHDispIt.GoToBegin(); !outHDispIt.IsAtEnd(); ++outMetricIt, ++outHDispIt)
+    {
+    const IndexType index = outHDispIt.GetIndex();
+    if (inLeftMaskPtr && !(inLeftMaskPtr->GetPixel(index) > 0))
+      {
+      continue;
+      }
+
+    const AggregatedCostType * pixelCosts =
+      &summedCosts[(static_cast<size_t>(index[1] - startY) * width + (index[0] - startX)) * nbDisp];
+
+    unsigned int best = 0;
+    for (unsigned int d = 1; d < nbDisp; ++d)
+      {
+      if (pixelCosts[d] < pixelCosts[best])
+        {
+        best = d;
+        }
+      }
+
+    double disparity = static_cast<double>(m_MinimumHorizontalDisparity + static_cast<int>(best));
+    if (m_SubPixelInterpolation && best > 0 && best + 1 < nbDisp)
+      {
+      const double previous = pixelCosts[best - 1];
+      const double current  = pixelCosts[best];
+      const double next     = pixelCosts[best + 1];
+      const double denominator = previous - 2. * current + next;
+      if (denominator > 0.)
+        {
+        disparity += 0.5 * (previous - next) / denominator;
+        }
+      }
+
+    outHDispIt.Set(static_cast<DisparityPixelType>(disparity));
+    outMetricIt.Set(static_cast<MetricValueType>(pixelCosts[best]));
+    }
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+void
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::ComputeCensus(const TInputImage * image, const RegionType & region, std::vector<CensusType> & census) const
+{
+  const RegionType & buffer = image->GetBufferedRegion();
+  const typename TInputImage::PixelType * data = image->GetBufferPointer();
+
+  const long bufferStartX = buffer.GetIndex(0);
+  const long bufferStartY = buffer.GetIndex(1);
+  const long bufferEndX = bufferStartX + static_cast<long>(buffer.GetSize(0)) - 1;
+  const long bufferEndY = bufferStartY + static_cast<long>(buffer.GetSize(1)) - 1;
+  const long bufferWidth = buffer.GetSize(0);
+  const long radius = m_Radius;
+
+  const unsigned int width  = region.GetSize(0);
+  const unsigned int height = region.GetSize(1);
+  census.resize(static_cast<size_t>(width) * height);
+
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    const long cy = std::min(std::max(static_cast<long>(region.GetIndex(1)) + static_cast<long>(y), bufferStartY), bufferEndY);
+
+    for (unsigned int x = 0; x < width; ++x)
+      {
+      const long cx = std::min(std::max(static_cast<long>(region.GetIndex(0)) + static_cast<long>(x), bufferStartX), bufferEndX);
+      const typename TInputImage::PixelType center =
+        data[(cy - bufferStartY) * bufferWidth + (cx - bufferStartX)];
+
+      CensusType bits = 0;
+      for (long j = -radius; j <= radius; ++j)
+        {
+        const long ny = std::min(std::max(cy + j, bufferStartY), bufferEndY);
+        const typename TInputImage::PixelType * row = data + (ny - bufferStartY) * bufferWidth;
+
+        for (long i = -radius; i <= radius; ++i)
+          {
+          if (i == 0 && j == 0)
+            {
+            continue;
+            }
+          const long nx = std::min(std::max(cx + i, bufferStartX), bufferEndX);
+          bits <<= 1;
+          if (row[nx - bufferStartX] < center)
+            {
+            bits |= 1;
+            }
+          }
+        }
+      census[static_cast<size_t>(y) * width + x] = bits;
+      }
+    }
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+void
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::AggregatePath(const std::vector<CostType> & costs, unsigned int width, unsigned int height,
+                int dx, int dy, std::vector<AggregatedCostType> & summedCosts) const
+{
+  const unsigned int nbDisp = m_MaximumHorizontalDisparity - m_MinimumHorizontalDisparity + 1;
+
+  // Rows are visited along dy and pixels along dx, so that the previous
+  // pixel on the path is always computed. Only the last |dy|+1 rows of
+  // path costs are kept.
+  const unsigned int rowStep = std::abs(dy);
+  const unsigned int nbRows = rowStep + 1;
+  std::vector<AggregatedCostType> pathCosts(static_cast<size_t>(nbRows) * width * nbDisp);
+  std::vector<AggregatedCostType> minPathCosts(static_cast<size_t>(nbRows) * width);
+
+  for (unsigned int k = 0; k < height; ++k)
+    {
+    const unsigned int y = dy >= 0 ? k : height - 1 - k;
+    const unsigned int slot = k % nbRows;
+    const unsigned int previousSlot = (k + nbRows - rowStep) % nbRows;
+
+    for (unsigned int j = 0; j < width; ++j)
+      {
+      const unsigned int x = dx >= 0 ? j : width - 1 - j;
+      const long previousX = static_cast<long>(x) - dx;
+      const size_t offset = (static_cast<size_t>(y) * width + x) * nbDisp;
+
+      const CostType * pixelCosts = &costs[offset];
+      AggregatedCostType * sums = &summedCosts[offset];
+      AggregatedCostType * current = &pathCosts[(static_cast<size_t>(slot) * width + x) * nbDisp];
+      unsigned int minCurrent = std::numeric_limits<unsigned int>::max();
+
+      if (k < rowStep || previousX < 0 || previousX >= static_cast<long>(width))
+        {
+        // First pixel of the path
+        for (unsigned int d = 0; d < nbDisp; ++d)
+          {
+          current[d] = pixelCosts[d];
+          minCurrent = std::min(minCurrent, static_cast<unsigned int>(current[d]));
+          }
+        }
+      else
+        {
+        const AggregatedCostType * previous =
+          &pathCosts[(static_cast<size_t>(previousSlot) * width + previousX) * nbDisp];
+        const unsigned int minPrevious = minPathCosts[static_cast<size_t>(previousSlot) * width + previousX];
+        const unsigned int jump = minPrevious + m_P2;
+
+        for (unsigned int d = 0; d < nbDisp; ++d)
+          {
+          unsigned int best = std::min(static_cast<unsigned int>(previous[d]), jump);
+          if (d > 0)
+            {
+            best = std::min(best, previous[d - 1] + m_P1);
+            }
+          if (d + 1 < nbDisp)
+            {
+            best = std::min(best, previous[d + 1] + m_P1);
+            }
+          current[d] = static_cast<AggregatedCostType>(pixelCosts[d] + best - minPrevious);
+          minCurrent = std::min(minCurrent, static_cast<unsigned int>(current[d]));
+          }
+        }
+
+      minPathCosts[static_cast<size_t>(slot) * width + x] = static_cast<AggregatedCostType>(minCurrent);
+
+      for (unsigned int d = 0; d < nbDisp; ++d)
+        {
+        sums[d] += current[d];
+        }
+      }
+    }
+}
+
+template <class TInputImage, class TOutputMetricImage, class TOutputDisparityImage, class TMaskImage>
+void
+SemiGlobalMatchingImageFilter<TInputImage, TOutputMetricImage, TOutputDisparityImage, TMaskImage>
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Radius: " << m_Radius << std::endl;
+  os << indent << "MinimumHorizontalDisparity: " << m_MinimumHorizontalDisparity << std::endl;
+  os << indent << "MaximumHorizontalDisparity: " << m_MaximumHorizontalDisparity << std::endl;
+  os << indent << "P1: " << m_P1 << std::endl;
+  os << indent << "P2: " << m_P2 << std::endl;
+  os << indent << "NumberOfPaths: " << m_NumberOfPaths << std::endl;
+  os << indent << "TileMargin: " << m_TileMargin << std::endl;
+  os << indent << "MaximumMemory: " << m_MaximumMemory << std::endl;
+  os << indent << "SubPixelInterpolation: " << m_SubPixelInterpolation << std::endl;
+}
+
+} // End namespace otb
+
+#endif
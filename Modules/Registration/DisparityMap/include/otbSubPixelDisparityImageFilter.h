@@ -52,6 +52,14 @@ namespace otb
  *  method tries to fit local scores to a circular cone. The dichotomy method tries to find the local extrema by
  *  a dichotomic search (non-integer disparity positions are tested after a resampling of the right image).
  *
+ *  The fast dichotomy method performs the same search, without running a resampler for each tested position: the
+ *  shifted right window is linearly interpolated row by row in a buffer of the window size, with the interpolation
+ *  weights computed once per position. It can also reuse the metric values of the integer search : when the metrics
+ *  around the best horizontal disparity are given (see SetPreviousHorizontalMetricInput() and
+ *  PixelWiseBlockMatchingImageFilter::ComputeNeighborMetricsOn()), the metric input and these maps replace the
+ *  evaluation of the centre and horizontal neighbors of the 3x3 neighborhood. They must come from the block-matching
+ *  run that produced the input disparities.
+ *
  *  \sa PixelWiseBlockMatchingImageFilter
  *  \sa FineRegistrationImageFilter
  *  \sa StereorectificationDisplacementFieldSource
@@ -113,6 +121,7 @@ public:
   itkStaticConstMacro(PARABOLIC,int,0);
   itkStaticConstMacro(TRIANGULAR,int,1);
   itkStaticConstMacro(DICHOTOMY,int,2);
+  itkStaticConstMacro(FAST_DICHOTOMY,int,3);
 
   /** Set left input */
   void SetLeftInput( const TInputImage * image);
@@ -129,6 +138,17 @@ public:
   /** Set the input metric image */
   void SetMetricInput(const TOutputMetricImage * image);
 
+  /** Set the metric at the best horizontal disparity minus one (optional) */
+  void SetPreviousHorizontalMetricInput(const TOutputMetricImage * image);
+
+  /** Set the metric at the best horizontal disparity plus one (optional) */
+  void SetNextHorizontalMetricInput(const TOutputMetricImage * image);
+
+  /** Get the metric inputs */
+  const TOutputMetricImage * GetMetricInput() const;
+  const TOutputMetricImage * GetPreviousHorizontalMetricInput() const;
+  const TOutputMetricImage * GetNextHorizontalMetricInput() const;
+
   /** Get the initial disparity fields */
   const TDisparityImage * GetHorizontalDisparityInput() const;
   const TDisparityImage * GetVerticalDisparityInput() const;
@@ -199,7 +219,7 @@ public:
     return m_Functor;
   }
 
-  /** Set/Get the refinement method (PARABOLIC, TRIANGULAR or DICHOTOMY) */
+  /** Set/Get the refinement method (PARABOLIC, TRIANGULAR, DICHOTOMY or FAST_DICHOTOMY) */
   itkSetMacro(RefineMethod,int);
   itkGetMacro(RefineMethod,int);
 
@@ -247,6 +267,32 @@ private:
   /** dichotomy refinement method */
   void DichotomyRefinement(const RegionType& outputRegionForThread, itk::ThreadIdType threadId);
 
+  /** dichotomy refinement method, with direct interpolation of the right windows */
+  void FastDichotomyRefinement(const RegionType& outputRegionForThread, itk::ThreadIdType threadId);
+
+  /** Evaluate the metric at the integer right position and its neighbors, and check that the position is an
+   *  extremum along each axis (shared by the dichotomy methods). The metrics of the centre and of the horizontal
+   *  neighbors are read from searchMetrics (previous, centre, next) when it is not null, and computed otherwise. */
+  void EvaluateNeighborsMetric(ConstNeighborhoodIteratorType & leftIt, ConstNeighborhoodIteratorType & rightIt,
+                               const IndexType & rightPos, int hDisp_i, int vDisp_i, const double * searchMetrics,
+                               double neighborsMetric[3][3], bool & horizontalInterpolation,
+                               bool & verticalInterpolation);
+
+  /** One step of the dichotomy along the given axis : the larger half of the bracket [lower,upper] is split
+   *  and the metric is evaluated at its middle (the tested shift). Shifts are relative to rightPos. Returns
+   *  true if the centre of the bracket has moved. */
+  bool DichotomyStep(ConstNeighborhoodIteratorType & leftIt, const IndexType & rightPos, unsigned int axis,
+                     double otherShift, double & lower, double & centre, double & upper, double & score,
+                     double & tested, TInputImage * patch, ConstNeighborhoodIteratorType & patchIt);
+
+  /** Interpolate the right window around rightPos shifted by (dx,dy) in the patch, and evaluate the metric */
+  double EvaluateShiftedMetric(ConstNeighborhoodIteratorType & leftIt, const IndexType & rightPos,
+                               double dx, double dy, TInputImage * patch, ConstNeighborhoodIteratorType & patchIt);
+
+  /** Linear interpolation of the right image at a continuous index, as done by the resampler of the
+   *  dichotomy method (0 outside the buffered region) */
+  double InterpolateRightPixel(double x, double y) const;
+
   /** The radius of the blocks */
   SizeType                      m_Radius;
 
@@ -268,7 +314,7 @@ private:
   /** Block-matching functor */
   BlockMatchingFunctorType      m_Functor;
 
-  /** Refinement method (PARABOLIC, TRIANGULAR or DICHOTOMY)*/
+  /** Refinement method (PARABOLIC, TRIANGULAR, DICHOTOMY or FAST_DICHOTOMY)*/
   int                           m_RefineMethod;
 
   /** Stores the number of pixels whose refined position has a worse metric than the initial position */
@@ -22,6 +22,7 @@
 #define otbSubPixelDisparityImageFilter_txx
 
 #include "otbSubPixelDisparityImageFilter.h"
+#include <algorithm>
 
 namespace otb
 {
@@ -147,6 +148,70 @@ TDisparityImage,TMaskImage,TBlockMatchingFunctor>
   this->SetNthInput(6, const_cast<TOutputMetricImage *>( image ));
 }
 
+template <class TInputImage, class TOutputMetricImage,
+class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+void
+SubPixelDisparityImageFilter<TInputImage,TOutputMetricImage,
+TDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::SetPreviousHorizontalMetricInput(const TOutputMetricImage * image)
+{
+  // Process object is not const-correct so the const casting is required.
+  this->SetNthInput(7, const_cast<TOutputMetricImage *>( image ));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+void
+SubPixelDisparityImageFilter<TInputImage,TOutputMetricImage,
+TDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::SetNextHorizontalMetricInput(const TOutputMetricImage * image)
+{
+  // Process object is not const-correct so the const casting is required.
+  this->SetNthInput(8, const_cast<TOutputMetricImage *>( image ));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+const TOutputMetricImage *
+SubPixelDisparityImageFilter<TInputImage,TOutputMetricImage,
+TDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::GetMetricInput() const
+{
+  if(this->GetNumberOfIndexedInputs()<7)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TOutputMetricImage *>(this->itk::ProcessObject::GetInput(6));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+const TOutputMetricImage *
+SubPixelDisparityImageFilter<TInputImage,TOutputMetricImage,
+TDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::GetPreviousHorizontalMetricInput() const
+{
+  if(this->GetNumberOfIndexedInputs()<8)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TOutputMetricImage *>(this->itk::ProcessObject::GetInput(7));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+const TOutputMetricImage *
+SubPixelDisparityImageFilter<TInputImage,TOutputMetricImage,
+TDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::GetNextHorizontalMetricInput() const
+{
+  if(this->GetNumberOfIndexedInputs()<9)
+    {
+    return ITK_NULLPTR;
+    }
+  return static_cast<const TOutputMetricImage *>(this->itk::ProcessObject::GetInput(8));
+}
+
 template <class TInputImage, class TOutputMetricImage,
 class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
 const TInputImage *
@@ -353,6 +418,11 @@ TDisparityImage,TMaskImage,TBlockMatchingFunctor>
     {
     this->SetRightMaskInput(filter->GetRightMaskInput());
     }
+  if (filter->GetPreviousHorizontalMetricOutput() && filter->GetNextHorizontalMetricOutput())
+    {
+    this->SetPreviousHorizontalMetricInput(filter->GetPreviousHorizontalMetricOutput());
+    this->SetNextHorizontalMetricInput(filter->GetNextHorizontalMetricOutput());
+    }
 
 }
 
@@ -370,6 +440,8 @@ TDisparityImage,TMaskImage,TBlockMatchingFunctor>
   const TMaskImage *      inRightMaskPtr  = this->GetRightMaskInput();
   const TDisparityImage * inHDispPtr      = this->GetHorizontalDisparityInput();
   const TDisparityImage * inVDispPtr      = this->GetVerticalDisparityInput();
+  const TOutputMetricImage * inPrevMetricPtr = this->GetPreviousHorizontalMetricInput();
+  const TOutputMetricImage * inNextMetricPtr = this->GetNextHorizontalMetricInput();
 
   // Check pointers before using them
   if(!inLeftPtr || !inRightPtr)
@@ -407,6 +479,17 @@ TDisparityImage,TMaskImage,TBlockMatchingFunctor>
     itkExceptionMacro(<<"Initial horizontal and vertical disparity maps don't have the same size ! Horizontal disparity largest region: "<<inHDispPtr->GetLargestPossibleRegion()<<", vertical disparity largest region: "<<inVDispPtr->GetLargestPossibleRegion());
     }
 
+  // The neighbor metrics of the integer search are on the disparity grid
+  if (inPrevMetricPtr && inHDispPtr->GetLargestPossibleRegion() != inPrevMetricPtr->GetLargestPossibleRegion())
+    {
+    itkExceptionMacro(<<"Initial horizontal disparity map and previous horizontal metric don't have the same size ! Horizontal disparity largest region: "<<inHDispPtr->GetLargestPossibleRegion()<<", metric largest region: "<<inPrevMetricPtr->GetLargestPossibleRegion());
+    }
+
+  if (inNextMetricPtr && inHDispPtr->GetLargestPossibleRegion() != inNextMetricPtr->GetLargestPossibleRegion())
+    {
+    itkExceptionMacro(<<"Initial horizontal disparity map and next horizontal metric don't have the same size ! Horizontal disparity largest region: "<<inHDispPtr->GetLargestPossibleRegion()<<", metric largest region: "<<inNextMetricPtr->GetLargestPossibleRegion());
+    }
+
 }
 
 template <class TInputImage, class TOutputMetricImage,
@@ -467,6 +550,9 @@ TDisparityImage,TMaskImage,TBlockMatchingFunctor>
   TMaskImage *  inRightMaskPtr  = const_cast<TMaskImage * >(this->GetRightMaskInput());
   TDisparityImage * inHDispPtr = const_cast<TDisparityImage * >(this->GetHorizontalDisparityInput());
   TDisparityImage * inVDispPtr = const_cast<TDisparityImage * >(this->GetVerticalDisparityInput());
+  TOutputMetricImage * inMetricPtr = const_cast<TOutputMetricImage * >(this->GetMetricInput());
+  TOutputMetricImage * inPrevMetricPtr = const_cast<TOutputMetricImage * >(this->GetPreviousHorizontalMetricInput());
+  TOutputMetricImage * inNextMetricPtr = const_cast<TOutputMetricImage * >(this->GetNextHorizontalMetricInput());
 
   TDisparityImage * outHDispPtr = this->GetHorizontalDisparityOutput();
 
@@ -573,6 +659,21 @@ TDisparityImage,TMaskImage,TBlockMatchingFunctor>
     {
     inVDispPtr->SetRequestedRegion( outputRequestedRegion );
     }
+
+  if (inMetricPtr)
+    {
+    inMetricPtr->SetRequestedRegion( outputRequestedRegion );
+    }
+
+  if (inPrevMetricPtr)
+    {
+    inPrevMetricPtr->SetRequestedRegion( outputRequestedRegion );
+    }
+
+  if (inNextMetricPtr)
+    {
+    inNextMetricPtr->SetRequestedRegion( outputRequestedRegion );
+    }
 }
 
 template <class TInputImage, class TOutputMetricImage,
@@ -617,6 +718,10 @@ TDisparityImage,TMaskImage,TBlockMatchingFunctor>
     // 2 = dichotomy search
     case 2 : DichotomyRefinement(outputRegionForThread, threadId);
       break;
+
+    // 3 = dichotomy search with direct interpolation
+    case 3 : FastDichotomyRefinement(outputRegionForThread, threadId);
+      break;
     default : break;
     }
 }
@@ -1700,133 +1805,8 @@ TDisparityImage,TMaskImage,TBlockMatchingFunctor>
           {
           if(!inRightMaskPtr || (inRightMaskPtr && inRightMaskIt.Get() > 0) )
             {
-            RegionType smallRightRegion;
-            smallRightRegion.SetIndex(0,curRightPos[0]-1);
-            smallRightRegion.SetIndex(1,curRightPos[1]-1);
-            smallRightRegion.SetSize(0,3);
-            smallRightRegion.SetSize(1,3);
-
-            rightIt.Initialize(m_Radius,inRightPtr,smallRightRegion);
-
-            // compute metric at centre position
-            rightIt.SetLocation(curRightPos);
-            neighborsMetric[1][1] = m_Functor(leftIt,rightIt);
-
-            if (m_MinimumVerticalDisparity < vDisp_i && vDisp_i < m_MaximumVerticalDisparity)
-              {
-              IndexType upIndex(curRightPos);
-              upIndex[1]+= (-1);
-              IndexType downIndex(curRightPos);
-              downIndex[1]+= 1;
-              if ( rightBufferedRegion.IsInside(upIndex) && rightBufferedRegion.IsInside(downIndex) )
-                {
-                rightIt.SetLocation(upIndex);
-                neighborsMetric[1][0] = m_Functor(leftIt,rightIt);
-
-                rightIt.SetLocation(downIndex);
-                neighborsMetric[1][2] = m_Functor(leftIt,rightIt);
-
-                // check that current position is an extrema
-                if (m_Minimize)
-                  {
-                  if (neighborsMetric[1][1] < neighborsMetric[1][0] && neighborsMetric[1][1] < neighborsMetric[1][2])
-                    {
-                    verticalInterpolation = true;
-                    }
-                  }
-                else
-                  {
-                  if (neighborsMetric[1][1] > neighborsMetric[1][0] && neighborsMetric[1][1] > neighborsMetric[1][2])
-                    {
-                    verticalInterpolation = true;
-                    }
-                  }
-                }
-              }
-
-            if (m_MinimumHorizontalDisparity < hDisp_i && hDisp_i < m_MaximumHorizontalDisparity)
-              {
-              IndexType leftIndex(curRightPos);
-              leftIndex[0]+= (-1);
-              IndexType rightIndex(curRightPos);
-              rightIndex[0]+= 1;
-              if ( rightBufferedRegion.IsInside(leftIndex) && rightBufferedRegion.IsInside(rightIndex) )
-                {
-                rightIt.SetLocation(rightIndex);
-                neighborsMetric[2][1] = m_Functor(leftIt,rightIt);
-
-                rightIt.SetLocation(leftIndex);
-                neighborsMetric[0][1] = m_Functor(leftIt,rightIt);
-
-                // check that current position is an extrema
-                if (m_Minimize)
-                  {
-                  if (neighborsMetric[1][1] < neighborsMetric[0][1] && neighborsMetric[1][1] < neighborsMetric[2][1])
-                    {
-                    horizontalInterpolation = true;
-                    }
-                  }
-                else
-                  {
-                  if (neighborsMetric[1][1] > neighborsMetric[0][1] && neighborsMetric[1][1] > neighborsMetric[2][1])
-                    {
-                    horizontalInterpolation = true;
-                    }
-                  }
-                }
-              }
-
-            // if both vertical and horizontal interpolation, compute metrics on corners
-            if (verticalInterpolation && horizontalInterpolation)
-              {
-              IndexType uprightIndex(curRightPos);
-              uprightIndex[0]+= 1;
-              uprightIndex[1]+= (-1);
-              rightIt.SetLocation(uprightIndex);
-              neighborsMetric[2][0] = m_Functor(leftIt,rightIt);
-
-              IndexType downrightIndex(curRightPos);
-              downrightIndex[0]+= 1;
-              downrightIndex[1]+= 1;
-              rightIt.SetLocation(downrightIndex);
-              neighborsMetric[2][2] = m_Functor(leftIt,rightIt);
-
-              IndexType downleftIndex(curRightPos);
-              downleftIndex[0]+= (-1);
-              downleftIndex[1]+= 1;
-              rightIt.SetLocation(downleftIndex);
-              neighborsMetric[0][2] = m_Functor(leftIt,rightIt);
-
-              IndexType upleftIndex(curRightPos);
-              upleftIndex[0]+= (-1);
-              upleftIndex[1]+= (-1);
-              rightIt.SetLocation(upleftIndex);
-              neighborsMetric[0][0] = m_Functor(leftIt,rightIt);
-
-              //check that it is an extrema
-              if (m_Minimize)
-                {
-                if (neighborsMetric[1][1] > neighborsMetric[2][0] ||
-                    neighborsMetric[1][1] > neighborsMetric[2][2] ||
-                    neighborsMetric[1][1] > neighborsMetric[0][2] ||
-                    neighborsMetric[1][1] > neighborsMetric[0][0])
-                  {
-                  verticalInterpolation = false;
-                  horizontalInterpolation = false;
-                  }
-                }
-              else
-                {
-                if (neighborsMetric[1][1] < neighborsMetric[2][0] ||
-                    neighborsMetric[1][1] < neighborsMetric[2][2] ||
-                    neighborsMetric[1][1] < neighborsMetric[0][2] ||
-                    neighborsMetric[1][1] < neighborsMetric[0][0])
-                  {
-                  verticalInterpolation = false;
-                  horizontalInterpolation = false;
-                  }
-                }
-              }
+            this->EvaluateNeighborsMetric(leftIt, rightIt, curRightPos, hDisp_i, vDisp_i, ITK_NULLPTR,
+                                          neighborsMetric, horizontalInterpolation, verticalInterpolation);
             }
           }
         }
@@ -2180,6 +2160,661 @@ TDisparityImage,TMaskImage,TBlockMatchingFunctor>
       static_cast<double>(outputRegionForThread.GetNumberOfPixels());
 }
 
+template <class TInputImage, class TOutputMetricImage,
+class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+void
+SubPixelDisparityImageFilter<TInputImage,TOutputMetricImage,
+TDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::FastDichotomyRefinement(const RegionType& outputRegionForThread, itk::ThreadIdType threadId)
+{
+  // Retrieve pointers
+  const TInputImage *     inLeftPtr    = this->GetLeftInput();
+  const TInputImage *     inRightPtr   = this->GetRightInput();
+  const TMaskImage  *     inLeftMaskPtr    = this->GetLeftMaskInput();
+  const TMaskImage  *     inRightMaskPtr    = this->GetRightMaskInput();
+  const TDisparityImage * inHDispPtr = this->GetHorizontalDisparityInput();
+  const TDisparityImage * inVDispPtr = this->GetVerticalDisparityInput();
+  const TOutputMetricImage * inMetricPtr = this->GetMetricInput();
+  const TOutputMetricImage * inPrevMetricPtr = this->GetPreviousHorizontalMetricInput();
+  const TOutputMetricImage * inNextMetricPtr = this->GetNextHorizontalMetricInput();
+  TOutputMetricImage    * outMetricPtr = this->GetMetricOutput();
+  TDisparityImage * outHDispPtr   = this->GetHorizontalDisparityOutput();
+  TDisparityImage * outVDispPtr   = this->GetVerticalDisparityOutput();
+
+  unsigned int nb_WrongExtrema = 0;
+
+  // Set-up progress reporting (this is not exact, since we do not
+  // account for pixels that won't be refined)
+  itk::ProgressReporter progress(this, threadId, outputRegionForThread.GetNumberOfPixels(),100);
+
+  RegionType fullRegionForThread = BlockMatchingFilterType::ConvertSubsampledToFullRegion(outputRegionForThread, this->m_Step, this->m_GridIndex);
+
+  itk::ConstNeighborhoodIterator<TInputImage>     leftIt(m_Radius,inLeftPtr,fullRegionForThread);
+  itk::ImageRegionIterator<TDisparityImage>       outHDispIt(outHDispPtr,outputRegionForThread);
+  itk::ImageRegionIterator<TDisparityImage>       outVDispIt(outVDispPtr,outputRegionForThread);
+  itk::ImageRegionIterator<TOutputMetricImage>    outMetricIt(outMetricPtr,outputRegionForThread);
+  itk::ImageRegionConstIterator<TDisparityImage>  inHDispIt;
+  itk::ImageRegionConstIterator<TDisparityImage>  inVDispIt;
+  itk::ImageRegionConstIterator<TMaskImage>       inLeftMaskIt;
+  itk::ImageRegionConstIterator<TMaskImage>       inRightMaskIt;
+  itk::ImageRegionConstIterator<TOutputMetricImage> inMetricIt;
+  itk::ImageRegionConstIterator<TOutputMetricImage> inPrevMetricIt;
+  itk::ImageRegionConstIterator<TOutputMetricImage> inNextMetricIt;
+
+  bool useHorizontalDisparity = false;
+  bool useVerticalDisparity = false;
+
+  if (inHDispPtr)
+    {
+    useHorizontalDisparity = true;
+    inHDispIt = itk::ImageRegionConstIterator<TDisparityImage>(inHDispPtr,outputRegionForThread);
+    inHDispIt.GoToBegin();
+    }
+  if (inVDispPtr)
+    {
+    useVerticalDisparity = true;
+    inVDispIt = itk::ImageRegionConstIterator<TDisparityImage>(inVDispPtr,outputRegionForThread);
+    inVDispIt.GoToBegin();
+    }
+
+  // Metric values of the integer search (centre and horizontal neighbors)
+  const bool useSearchMetrics = (useHorizontalDisparity && inMetricPtr && inPrevMetricPtr && inNextMetricPtr);
+  const MetricValueType noDataMetric = itk::NumericTraits<MetricValueType>::max();
+  if (useSearchMetrics)
+    {
+    inMetricIt = itk::ImageRegionConstIterator<TOutputMetricImage>(inMetricPtr,outputRegionForThread);
+    inPrevMetricIt = itk::ImageRegionConstIterator<TOutputMetricImage>(inPrevMetricPtr,outputRegionForThread);
+    inNextMetricIt = itk::ImageRegionConstIterator<TOutputMetricImage>(inNextMetricPtr,outputRegionForThread);
+    inMetricIt.GoToBegin();
+    inPrevMetricIt.GoToBegin();
+    inNextMetricIt.GoToBegin();
+    }
+
+  if(inLeftMaskPtr)
+    {
+    inLeftMaskIt = itk::ImageRegionConstIterator<TMaskImage>(inLeftMaskPtr,fullRegionForThread);
+    inLeftMaskIt.GoToBegin();
+    }
+  RegionType rightBufferedRegion = inRightPtr->GetBufferedRegion();
+  if(inRightMaskPtr)
+    {
+    RegionType inRightMaskRegion = inRightMaskPtr->GetBufferedRegion();
+    inRightMaskIt = itk::ImageRegionConstIterator<TMaskImage>(inRightMaskPtr,inRightMaskRegion);
+    }
+
+  itk::ConstantBoundaryCondition<TInputImage> nbc1;
+  leftIt.OverrideBoundaryCondition(&nbc1);
+
+  leftIt.GoToBegin();
+  outHDispIt.GoToBegin();
+  outVDispIt.GoToBegin();
+  outMetricIt.GoToBegin();
+
+  /* Specific variables */
+  IndexType curLeftPos;
+  IndexType curRightPos;
+
+  float hDisp_f;
+  float vDisp_f;
+  int hDisp_i;
+  int vDisp_i;
+
+  // compute metric around current right position
+  bool horizontalInterpolation = false;
+  bool verticalInterpolation = false;
+  bool reuseSearchMetrics = false;
+
+  // metrics for neighbors positions : first index is x, second is y
+  double neighborsMetric[3][3] = {{0,0,0},{0,0,0},{0,0,0}};
+  unsigned int nbIterMax = 10;
+
+  // The shifted right windows are interpolated in a patch of the window
+  // size, allocated once for the thread
+  RegionType patchRegion;
+  patchRegion.SetIndex(0, 0);
+  patchRegion.SetIndex(1, 0);
+  patchRegion.SetSize(0, 2 * m_Radius[0] + 1);
+  patchRegion.SetSize(1, 2 * m_Radius[1] + 1);
+
+  typename TInputImage::Pointer patchPtr = TInputImage::New();
+  patchPtr->SetRegions(patchRegion);
+  patchPtr->Allocate();
+
+  RegionType patchCentreRegion;
+  patchCentreRegion.SetIndex(0, m_Radius[0]);
+  patchCentreRegion.SetIndex(1, m_Radius[1]);
+  patchCentreRegion.SetSize(0, 1);
+  patchCentreRegion.SetSize(1, 1);
+
+  itk::ConstNeighborhoodIterator<TInputImage>     patchIt(m_Radius,patchPtr,patchCentreRegion);
+  patchIt.GoToBegin();
+
+  // step value as disparityType
+  DisparityPixelType stepDisparity = static_cast<DisparityPixelType>(this->m_Step);
+  DisparityPixelType stepDisparityInv = 1. / stepDisparity;
+
+  // iterator on right image
+  itk::ConstNeighborhoodIterator<TInputImage>     rightIt;
+  itk::ConstantBoundaryCondition<TInputImage>     nbc2;
+  rightIt.OverrideBoundaryCondition(&nbc2);
+
+  while (!leftIt.IsAtEnd()
+        || !outHDispIt.IsAtEnd()
+        || !outVDispIt.IsAtEnd()
+        || !outMetricIt.IsAtEnd())
+    {
+    // If the pixel location is on the subsampled grid
+    curLeftPos = leftIt.GetIndex();
+    if (((curLeftPos[0] - this->m_GridIndex[0] + this->m_Step) % this->m_Step == 0) &&
+        ((curLeftPos[1] - this->m_GridIndex[1] + this->m_Step) % this->m_Step == 0))
+      {
+      horizontalInterpolation = false;
+      verticalInterpolation = false;
+
+      /* compute estimated right position */
+      if (useHorizontalDisparity)
+        {
+        hDisp_f = static_cast<float>(inHDispIt.Get()) * stepDisparity;
+        hDisp_i = static_cast<int>(vcl_floor(hDisp_f + 0.5));
+        curRightPos[0] = curLeftPos[0] + hDisp_i;
+        }
+      else
+        {
+        hDisp_i = 0;
+        curRightPos[0] = curLeftPos[0];
+        }
+
+
+      if (useVerticalDisparity)
+        {
+        vDisp_f = static_cast<float>(inVDispIt.Get()) * stepDisparity;
+        vDisp_i = static_cast<int>(vcl_floor(vDisp_f + 0.5));
+        curRightPos[1] = curLeftPos[1] + vDisp_i;
+        }
+      else
+        {
+        vDisp_i = 0;
+        curRightPos[1] = curLeftPos[1];
+        }
+
+      // The search metrics are only used if both horizontal neighbors were explored
+      reuseSearchMetrics = useSearchMetrics
+        && inPrevMetricIt.Get() != noDataMetric
+        && inNextMetricIt.Get() != noDataMetric;
+
+      // check if the current right position is inside the right image
+      if (rightBufferedRegion.IsInside(curRightPos))
+        {
+        if (inRightMaskPtr)
+          {
+          // Set right mask iterator position
+          inRightMaskIt.SetIndex(curRightPos);
+          }
+        // check that the current positions are not masked
+        if(!inLeftMaskPtr || (inLeftMaskPtr && inLeftMaskIt.Get() > 0) )
+          {
+          if(!inRightMaskPtr || (inRightMaskPtr && inRightMaskIt.Get() > 0) )
+            {
+            // The centre and horizontal neighbors metrics come from the integer search if available
+            double searchMetrics[3] = {0., 0., 0.};
+            if (reuseSearchMetrics)
+              {
+              searchMetrics[0] = static_cast<double>(inPrevMetricIt.Get());
+              searchMetrics[1] = static_cast<double>(inMetricIt.Get());
+              searchMetrics[2] = static_cast<double>(inNextMetricIt.Get());
+              }
+            this->EvaluateNeighborsMetric(leftIt, rightIt, curRightPos, hDisp_i, vDisp_i,
+                                          reuseSearchMetrics ? searchMetrics : ITK_NULLPTR,
+                                          neighborsMetric, horizontalInterpolation, verticalInterpolation);
+            }
+          }
+        }
+
+      // Interpolate position : dichotomy, with shifts relative to the integer position
+      if (verticalInterpolation && !horizontalInterpolation)
+        {
+        double ya = -1.0;
+        double yb = 0.0;
+        double yc = 1.0;
+        double yd = 0.0;
+        double s_yb = neighborsMetric[1][1];
+
+        for (unsigned int k=0; k<nbIterMax; k++)
+          {
+          this->DichotomyStep(leftIt, curRightPos, 1, 0.0, ya, yb, yc, s_yb, yd, patchPtr, patchIt);
+          }
+
+        outVDispIt.Set( (static_cast<double>(vDisp_i) + yb) * stepDisparityInv );
+        outMetricIt.Set( s_yb );
+        }
+      else if (!verticalInterpolation && horizontalInterpolation)
+        {
+        double xa = -1.0;
+        double xb = 0.0;
+        double xc = 1.0;
+        double xd = 0.0;
+        double s_xb = neighborsMetric[1][1];
+
+        for (unsigned int k=0; k<nbIterMax; k++)
+          {
+          this->DichotomyStep(leftIt, curRightPos, 0, 0.0, xa, xb, xc, s_xb, xd, patchPtr, patchIt);
+          }
+
+        outHDispIt.Set( (static_cast<double>(hDisp_i) + xb) * stepDisparityInv );
+        outMetricIt.Set( s_xb );
+        }
+      else if (verticalInterpolation && horizontalInterpolation)
+        {
+        // Alternate vertical and horizontal steps. As in the dichotomy
+        // method, each step uses the last tested shift along the other axis.
+        double ya = -1.0;
+        double yb = 0.0;
+        double yc = 1.0;
+        double yd = 0.0;
+        double xe = -1.0;
+        double xb = 0.0;
+        double xf = 1.0;
+        double xd = 0.0;
+        double s_b = neighborsMetric[1][1];
+
+        for (unsigned int k=0; k<nbIterMax; k++)
+          {
+          this->DichotomyStep(leftIt, curRightPos, 1, xd, ya, yb, yc, s_b, yd, patchPtr, patchIt);
+          this->DichotomyStep(leftIt, curRightPos, 0, yd, xe, xb, xf, s_b, xd, patchPtr, patchIt);
+          }
+
+        outHDispIt.Set( (static_cast<double>(hDisp_i) + xb) * stepDisparityInv);
+        outVDispIt.Set( (static_cast<double>(vDisp_i) + yb) * stepDisparityInv);
+        outMetricIt.Set( s_b );
+        }
+
+      if (!verticalInterpolation)
+        {
+        // No vertical interpolation done : simply copy the integer vertical disparity
+        outVDispIt.Set( static_cast<double>(vDisp_i) * stepDisparityInv);
+        }
+
+      if (!horizontalInterpolation)
+        {
+        // No horizontal interpolation done : simply copy the integer horizontal disparity
+        outHDispIt.Set( static_cast<double>(hDisp_i) * stepDisparityInv);
+        }
+
+      if (!verticalInterpolation && !horizontalInterpolation)
+        {
+        outMetricIt.Set(static_cast<double>(neighborsMetric[1][1]));
+        }
+      else
+        {
+        if ((outMetricIt.Get() > neighborsMetric[1][1] && m_Minimize) ||
+            (outMetricIt.Get() < neighborsMetric[1][1] && !m_Minimize))
+          {
+          nb_WrongExtrema++;
+          }
+        }
+
+      progress.CompletedPixel();
+
+      ++outHDispIt;
+      ++outVDispIt;
+      ++outMetricIt;
+
+      if (useHorizontalDisparity)
+        {
+        ++inHDispIt;
+        }
+      if (useVerticalDisparity)
+        {
+        ++inVDispIt;
+        }
+      if (useSearchMetrics)
+        {
+        ++inMetricIt;
+        ++inPrevMetricIt;
+        ++inNextMetricIt;
+        }
+      }
+    ++leftIt;
+
+    if(inLeftMaskPtr)
+      {
+      ++inLeftMaskIt;
+      }
+    }
+
+  m_WrongExtrema[threadId] = static_cast<double>(nb_WrongExtrema) /
+      static_cast<double>(outputRegionForThread.GetNumberOfPixels());
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+void
+SubPixelDisparityImageFilter<TInputImage,TOutputMetricImage,
+TDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::EvaluateNeighborsMetric(ConstNeighborhoodIteratorType & leftIt, ConstNeighborhoodIteratorType & rightIt,
+                          const IndexType & rightPos, int hDisp_i, int vDisp_i, const double * searchMetrics,
+                          double neighborsMetric[3][3], bool & horizontalInterpolation, bool & verticalInterpolation)
+{
+  const RegionType & rightBufferedRegion = this->GetRightInput()->GetBufferedRegion();
+
+  RegionType smallRightRegion;
+  smallRightRegion.SetIndex(0,rightPos[0]-1);
+  smallRightRegion.SetIndex(1,rightPos[1]-1);
+  smallRightRegion.SetSize(0,3);
+  smallRightRegion.SetSize(1,3);
+
+  rightIt.Initialize(m_Radius,this->GetRightInput(),smallRightRegion);
+
+  // compute metric at centre position
+  if (searchMetrics)
+    {
+    neighborsMetric[1][1] = searchMetrics[1];
+    }
+  else
+    {
+    rightIt.SetLocation(rightPos);
+    neighborsMetric[1][1] = m_Functor(leftIt,rightIt);
+    }
+
+  if (m_MinimumVerticalDisparity < vDisp_i && vDisp_i < m_MaximumVerticalDisparity)
+    {
+    IndexType upIndex(rightPos);
+    upIndex[1]+= (-1);
+    IndexType downIndex(rightPos);
+    downIndex[1]+= 1;
+    if ( rightBufferedRegion.IsInside(upIndex) && rightBufferedRegion.IsInside(downIndex) )
+      {
+      rightIt.SetLocation(upIndex);
+      neighborsMetric[1][0] = m_Functor(leftIt,rightIt);
+
+      rightIt.SetLocation(downIndex);
+      neighborsMetric[1][2] = m_Functor(leftIt,rightIt);
+
+      // check that current position is an extrema
+      if (m_Minimize)
+        {
+        if (neighborsMetric[1][1] < neighborsMetric[1][0] && neighborsMetric[1][1] < neighborsMetric[1][2])
+          {
+          verticalInterpolation = true;
+          }
+        }
+      else
+        {
+        if (neighborsMetric[1][1] > neighborsMetric[1][0] && neighborsMetric[1][1] > neighborsMetric[1][2])
+          {
+          verticalInterpolation = true;
+          }
+        }
+      }
+    }
+
+  if (m_MinimumHorizontalDisparity < hDisp_i && hDisp_i < m_MaximumHorizontalDisparity)
+    {
+    IndexType leftIndex(rightPos);
+    leftIndex[0]+= (-1);
+    IndexType rightIndex(rightPos);
+    rightIndex[0]+= 1;
+    if ( rightBufferedRegion.IsInside(leftIndex) && rightBufferedRegion.IsInside(rightIndex) )
+      {
+      if (searchMetrics)
+        {
+        neighborsMetric[0][1] = searchMetrics[0];
+        neighborsMetric[2][1] = searchMetrics[2];
+        }
+      else
+        {
+        rightIt.SetLocation(rightIndex);
+        neighborsMetric[2][1] = m_Functor(leftIt,rightIt);
+
+        rightIt.SetLocation(leftIndex);
+        neighborsMetric[0][1] = m_Functor(leftIt,rightIt);
+        }
+
+      // check that current position is an extrema
+      if (m_Minimize)
+        {
+        if (neighborsMetric[1][1] < neighborsMetric[0][1] && neighborsMetric[1][1] < neighborsMetric[2][1])
+          {
+          horizontalInterpolation = true;
+          }
+        }
+      else
+        {
+        if (neighborsMetric[1][1] > neighborsMetric[0][1] && neighborsMetric[1][1] > neighborsMetric[2][1])
+          {
+          horizontalInterpolation = true;
+          }
+        }
+      }
+    }
+
+  // if both vertical and horizontal interpolation, compute metrics on corners
+  if (verticalInterpolation && horizontalInterpolation)
+    {
+    IndexType uprightIndex(rightPos);
+    uprightIndex[0]+= 1;
+    uprightIndex[1]+= (-1);
+    rightIt.SetLocation(uprightIndex);
+    neighborsMetric[2][0] = m_Functor(leftIt,rightIt);
+
+    IndexType downrightIndex(rightPos);
+    downrightIndex[0]+= 1;
+    downrightIndex[1]+= 1;
+    rightIt.SetLocation(downrightIndex);
+    neighborsMetric[2][2] = m_Functor(leftIt,rightIt);
+
+    IndexType downleftIndex(rightPos);
+    downleftIndex[0]+= (-1);
+    downleftIndex[1]+= 1;
+    rightIt.SetLocation(downleftIndex);
+    neighborsMetric[0][2] = m_Functor(leftIt,rightIt);
+
+    IndexType upleftIndex(rightPos);
+    upleftIndex[0]+= (-1);
+    upleftIndex[1]+= (-1);
+    rightIt.SetLocation(upleftIndex);
+    neighborsMetric[0][0] = m_Functor(leftIt,rightIt);
+
+    //check that it is an extrema
+    if (m_Minimize)
+      {
+      if (neighborsMetric[1][1] > neighborsMetric[2][0] ||
+          neighborsMetric[1][1] > neighborsMetric[2][2] ||
+          neighborsMetric[1][1] > neighborsMetric[0][2] ||
+          neighborsMetric[1][1] > neighborsMetric[0][0])
+        {
+        verticalInterpolation = false;
+        horizontalInterpolation = false;
+        }
+      }
+    else
+      {
+      if (neighborsMetric[1][1] < neighborsMetric[2][0] ||
+          neighborsMetric[1][1] < neighborsMetric[2][2] ||
+          neighborsMetric[1][1] < neighborsMetric[0][2] ||
+          neighborsMetric[1][1] < neighborsMetric[0][0])
+        {
+        verticalInterpolation = false;
+        horizontalInterpolation = false;
+        }
+      }
+    }
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+bool
+SubPixelDisparityImageFilter<TInputImage,TOutputMetricImage,
+TDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::DichotomyStep(ConstNeighborhoodIteratorType & leftIt, const IndexType & rightPos, unsigned int axis,
+                double otherShift, double & lower, double & centre, double & upper, double & score,
+                double & tested, TInputImage * patch, ConstNeighborhoodIteratorType & patchIt)
+{
+  // Split the larger half of the bracket
+  const bool upperHalf = (centre - lower) < (upper - centre);
+  tested = upperHalf ? 0.5 * (upper + centre) : 0.5 * (lower + centre);
+
+  double testedScore;
+  if (axis == 0)
+    {
+    testedScore = this->EvaluateShiftedMetric(leftIt, rightPos, tested, otherShift, patch, patchIt);
+    }
+  else
+    {
+    testedScore = this->EvaluateShiftedMetric(leftIt, rightPos, otherShift, tested, patch, patchIt);
+    }
+
+  if ((testedScore<score && m_Minimize) || (testedScore>score && !m_Minimize))
+    {
+    if (upperHalf)
+      {
+      lower = centre;
+      }
+    else
+      {
+      upper = centre;
+      }
+    centre = tested;
+    score = testedScore;
+    return true;
+    }
+
+  if (upperHalf)
+    {
+    upper = tested;
+    }
+  else
+    {
+    lower = tested;
+    }
+  return false;
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+double
+SubPixelDisparityImageFilter<TInputImage,TOutputMetricImage,
+TDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::EvaluateShiftedMetric(ConstNeighborhoodIteratorType & leftIt, const IndexType & rightPos,
+                        double dx, double dy, TInputImage * patch, ConstNeighborhoodIteratorType & patchIt)
+{
+  typedef typename TInputImage::PixelType InputPixelType;
+
+  const TInputImage * inRightPtr = this->GetRightInput();
+  const RegionType & rightBuffer = inRightPtr->GetBufferedRegion();
+  const InputPixelType * rightData = inRightPtr->GetBufferPointer();
+  InputPixelType * patchData = patch->GetBufferPointer();
+
+  const long winX = 2 * static_cast<long>(m_Radius[0]) + 1;
+  const long winY = 2 * static_cast<long>(m_Radius[1]) + 1;
+  const long bufStartX = rightBuffer.GetIndex(0);
+  const long bufStartY = rightBuffer.GetIndex(1);
+  const long bufSizeX  = static_cast<long>(rightBuffer.GetSize(0));
+  const long bufSizeY  = static_cast<long>(rightBuffer.GetSize(1));
+
+  // The integer part and the interpolation weights of the shift are the
+  // same for the whole window
+  const long shiftX = static_cast<long>(vcl_floor(dx));
+  const long shiftY = static_cast<long>(vcl_floor(dy));
+  const double fx = dx - static_cast<double>(shiftX);
+  const double fy = dy - static_cast<double>(shiftY);
+  const long nextX = (fx > 0. ? 1 : 0);
+  const long nextY = (fy > 0. ? 1 : 0);
+
+  const long startX = rightPos[0] - static_cast<long>(m_Radius[0]);
+  const long startY = rightPos[1] - static_cast<long>(m_Radius[1]);
+  const long baseX = startX + shiftX;
+  const long baseY = startY + shiftY;
+
+  const bool inside = baseX >= bufStartX && baseX + winX - 1 + nextX < bufStartX + bufSizeX
+    && baseY >= bufStartY && baseY + winY - 1 + nextY < bufStartY + bufSizeY;
+
+  for (long py = 0; py < winY; ++py)
+    {
+    InputPixelType * patchRow = patchData + py * winX;
+    if (inside)
+      {
+      const InputPixelType * row0 = rightData + (baseY + py - bufStartY) * bufSizeX + (baseX - bufStartX);
+      const InputPixelType * row1 = row0 + nextY * bufSizeX;
+      for (long px = 0; px < winX; ++px)
+        {
+        const double v00 = static_cast<double>(row0[px]);
+        const double v10 = static_cast<double>(row0[px + nextX]);
+        const double v01 = static_cast<double>(row1[px]);
+        const double v11 = static_cast<double>(row1[px + nextX]);
+        const double vx0 = v00 + (v10 - v00) * fx;
+        const double vx1 = v01 + (v11 - v01) * fx;
+        patchRow[px] = static_cast<InputPixelType>(vx0 + (vx1 - vx0) * fy);
+        }
+      }
+    else
+      {
+      // Near the buffer borders, use the same rules as the resampler
+      for (long px = 0; px < winX; ++px)
+        {
+        patchRow[px] = static_cast<InputPixelType>(this->InterpolateRightPixel(
+          static_cast<double>(startX + px) + dx, static_cast<double>(startY + py) + dy));
+        }
+      }
+    }
+
+  return static_cast<double>(m_Functor(leftIt,patchIt));
+}
+
+template <class TInputImage, class TOutputMetricImage,
+class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
+double
+SubPixelDisparityImageFilter<TInputImage,TOutputMetricImage,
+TDisparityImage,TMaskImage,TBlockMatchingFunctor>
+::InterpolateRightPixel(double x, double y) const
+{
+  const TInputImage * inRightPtr = this->GetRightInput();
+  const RegionType & rightBuffer = inRightPtr->GetBufferedRegion();
+  const typename TInputImage::PixelType * rightData = inRightPtr->GetBufferPointer();
+
+  const long startX = rightBuffer.GetIndex(0);
+  const long startY = rightBuffer.GetIndex(1);
+  const long endX = startX + static_cast<long>(rightBuffer.GetSize(0)) - 1;
+  const long endY = startY + static_cast<long>(rightBuffer.GetSize(1)) - 1;
+  const long sizeX = static_cast<long>(rightBuffer.GetSize(0));
+
+  // Outside the buffer (half a pixel margin), the resampler gives 0
+  if (x < static_cast<double>(startX) - 0.5 || x >= static_cast<double>(endX) + 0.5 ||
+      y < static_cast<double>(startY) - 0.5 || y >= static_cast<double>(endY) + 0.5)
+    {
+    return 0.;
+    }
+
+  long bx = static_cast<long>(vcl_floor(x));
+  long by = static_cast<long>(vcl_floor(y));
+  bx = std::max(bx, startX);
+  by = std::max(by, startY);
+  const double dx = x - static_cast<double>(bx);
+  const double dy = y - static_cast<double>(by);
+
+  const typename TInputImage::PixelType * p00 = rightData + (by - startY) * sizeX + (bx - startX);
+  const double v00 = static_cast<double>(*p00);
+  const bool hasNextX = (dx > 0. && bx + 1 <= endX);
+  const bool hasNextY = (dy > 0. && by + 1 <= endY);
+
+  if (!hasNextX && !hasNextY)
+    {
+    return v00;
+    }
+  if (!hasNextY)
+    {
+    return v00 + (static_cast<double>(p00[1]) - v00) * dx;
+    }
+  if (!hasNextX)
+    {
+    return v00 + (static_cast<double>(p00[sizeX]) - v00) * dy;
+    }
+  const double vx0 = v00 + (static_cast<double>(p00[1]) - v00) * dx;
+  const double vx1 = static_cast<double>(p00[sizeX])
+    + (static_cast<double>(p00[sizeX + 1]) - static_cast<double>(p00[sizeX])) * dx;
+  return vx0 + (vx1 - vx0) * dy;
+}
+
 template <class TInputImage, class TOutputMetricImage,
 class TDisparityImage, class TMaskImage, class TBlockMatchingFunctor>
 void
@@ -36,6 +36,7 @@ otb_module(OTBDisparityMap
 
   TEST_DEPENDS
     OTBImageIO
+    OTBImageManipulation
     OTBObjectList
     OTBTestKernel
 
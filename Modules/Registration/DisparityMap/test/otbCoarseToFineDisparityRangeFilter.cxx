@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbCoarseToFineDisparityRangeFilter.h"
+#include "otbPixelWiseBlockMatchingImageFilter.h"
+#include "otbStreamingShrinkImageFilter.h"
+#include "otbImageFileReader.h"
+#include "otbImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+
+typedef otb::Image<unsigned short>                     CFImageType;
+typedef otb::Image<float>                              CFFloatImageType;
+typedef otb::ImageFileReader<CFImageType>              CFReaderType;
+typedef otb::ImageFileWriter<CFFloatImageType>         CFFloatWriterType;
+typedef otb::StreamingShrinkImageFilter<CFImageType>   CFShrinkFilterType;
+
+typedef otb::PixelWiseBlockMatchingImageFilter<CFImageType, CFFloatImageType,
+                                               CFFloatImageType, CFImageType> CFBlockMatchingFilterType;
+
+typedef otb::CoarseToFineDisparityRangeFilter<CFFloatImageType> CoarseToFineDisparityRangeFilterType;
+
+int otbCoarseToFineDisparityRangeFilterNew(int itkNotUsed(argc), char * itkNotUsed(argv) [])
+{
+  // Instantiation
+  CoarseToFineDisparityRangeFilterType::Pointer rangeFilter = CoarseToFineDisparityRangeFilterType::New();
+
+  std::cout << rangeFilter << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+int otbCoarseToFineDisparityRangeFilter(int argc, char * argv[])
+{
+  CFReaderType::Pointer leftReader = CFReaderType::New();
+  leftReader->SetFileName(argv[1]);
+  leftReader->UpdateOutputInformation();
+
+  CFReaderType::Pointer rightReader = CFReaderType::New();
+  rightReader->SetFileName(argv[2]);
+
+  const unsigned int radius = atoi(argv[5]);
+  const int minHDisp = atoi(argv[6]);
+  const int maxHDisp = atoi(argv[7]);
+  const double margin = atof(argv[8]);
+
+  // Coarse level, at half resolution
+  CFShrinkFilterType::Pointer leftShrink = CFShrinkFilterType::New();
+  leftShrink->SetInput(leftReader->GetOutput());
+  leftShrink->SetShrinkFactor(2);
+  leftShrink->Update();
+
+  CFShrinkFilterType::Pointer rightShrink = CFShrinkFilterType::New();
+  rightShrink->SetInput(rightReader->GetOutput());
+  rightShrink->SetShrinkFactor(2);
+  rightShrink->Update();
+
+  CFBlockMatchingFilterType::Pointer coarseMatcher = CFBlockMatchingFilterType::New();
+  coarseMatcher->SetLeftInput(leftShrink->GetShrunkOutput());
+  coarseMatcher->SetRightInput(rightShrink->GetShrunkOutput());
+  coarseMatcher->SetRadius(radius);
+  coarseMatcher->SetMinimumHorizontalDisparity(static_cast<int>(vcl_floor(minHDisp / 2.)));
+  coarseMatcher->SetMaximumHorizontalDisparity(static_cast<int>(vcl_ceil(maxHDisp / 2.)));
+
+  CoarseToFineDisparityRangeFilterType::Pointer rangeFilter = CoarseToFineDisparityRangeFilterType::New();
+  rangeFilter->SetHorizontalDisparityInput(coarseMatcher->GetHorizontalDisparityOutput());
+  rangeFilter->SetMinimumHorizontalDisparity(minHDisp);
+  rangeFilter->SetMaximumHorizontalDisparity(maxHDisp);
+  rangeFilter->SetMargin(margin);
+  rangeFilter->SetOutputParametersFromImage(leftReader->GetOutput());
+
+  // Full resolution level, streamed
+  CFBlockMatchingFilterType::Pointer fineMatcher = CFBlockMatchingFilterType::New();
+  fineMatcher->SetLeftInput(leftReader->GetOutput());
+  fineMatcher->SetRightInput(rightReader->GetOutput());
+  fineMatcher->SetRadius(radius);
+  fineMatcher->SetMinimumHorizontalDisparity(minHDisp);
+  fineMatcher->SetMaximumHorizontalDisparity(maxHDisp);
+  fineMatcher->SetMinimumHorizontalDisparityInput(rangeFilter->GetMinimumHorizontalDisparityOutput());
+  fineMatcher->SetMaximumHorizontalDisparityInput(rangeFilter->GetMaximumHorizontalDisparityOutput());
+
+  CFFloatWriterType::Pointer dispWriter = CFFloatWriterType::New();
+  dispWriter->SetInput(fineMatcher->GetHorizontalDisparityOutput());
+  dispWriter->SetFileName(argv[3]);
+  dispWriter->SetNumberOfDivisionsStrippedStreaming(4);
+  dispWriter->Update();
+
+  CFFloatWriterType::Pointer metricWriter = CFFloatWriterType::New();
+  metricWriter->SetInput(fineMatcher->GetMetricOutput());
+  metricWriter->SetFileName(argv[4]);
+  metricWriter->SetNumberOfDivisionsStrippedStreaming(4);
+  metricWriter->Update();
+
+  const double fullRange = maxHDisp - minHDisp + 1;
+  std::cout << "Mean horizontal range: " << rangeFilter->GetMeanRange()
+            << " disparities instead of " << fullRange << std::endl;
+
+  if (argc < 10)
+    {
+    return EXIT_SUCCESS;
+    }
+  const double minAgreement = atof(argv[9]);
+
+  // The ranges must be pruned
+  if (rangeFilter->GetMeanRange() >= fullRange)
+    {
+    std::cerr << "The mean horizontal range (" << rangeFilter->GetMeanRange()
+              << ") does not shrink the full range (" << fullRange << ")" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Exhaustive search on the full range
+  CFBlockMatchingFilterType::Pointer exhaustiveMatcher = CFBlockMatchingFilterType::New();
+  exhaustiveMatcher->SetLeftInput(leftReader->GetOutput());
+  exhaustiveMatcher->SetRightInput(rightReader->GetOutput());
+  exhaustiveMatcher->SetRadius(radius);
+  exhaustiveMatcher->SetMinimumHorizontalDisparity(minHDisp);
+  exhaustiveMatcher->SetMaximumHorizontalDisparity(maxHDisp);
+  exhaustiveMatcher->UpdateLargestPossibleRegion();
+
+  fineMatcher->UpdateLargestPossibleRegion();
+  rangeFilter->UpdateLargestPossibleRegion();
+
+  // Where the exhaustive disparity lies in the pruned range, the pruned
+  // search must find it too
+  const CFFloatImageType::RegionType region = leftReader->GetOutput()->GetLargestPossibleRegion();
+  itk::ImageRegionConstIterator<CFFloatImageType> exhaustiveIt(exhaustiveMatcher->GetHorizontalDisparityOutput(), region);
+  itk::ImageRegionConstIterator<CFFloatImageType> prunedIt(fineMatcher->GetHorizontalDisparityOutput(), region);
+  itk::ImageRegionConstIterator<CFFloatImageType> minIt(rangeFilter->GetMinimumHorizontalDisparityOutput(), region);
+  itk::ImageRegionConstIterator<CFFloatImageType> maxIt(rangeFilter->GetMaximumHorizontalDisparityOutput(), region);
+
+  unsigned long nbPixels = 0;
+  unsigned long nbInRange = 0;
+  unsigned long nbInRangeMatches = 0;
+  unsigned long nbMatches = 0;
+  for (exhaustiveIt.GoToBegin(), prunedIt.GoToBegin(), minIt.GoToBegin(), maxIt.GoToBegin();
+       !exhaustiveIt.IsAtEnd();
+       ++exhaustiveIt, ++prunedIt, ++minIt, ++maxIt)
+    {
+    ++nbPixels;
+    const bool match = (exhaustiveIt.Get() == prunedIt.Get());
+    if (match)
+      {
+      ++nbMatches;
+      }
+    if (exhaustiveIt.Get() >= minIt.Get() && exhaustiveIt.Get() <= maxIt.Get())
+      {
+      ++nbInRange;
+      if (match)
+        {
+        ++nbInRangeMatches;
+        }
+      }
+    }
+
+  const double inRangeAgreement = static_cast<double>(nbInRangeMatches) / std::max(nbInRange, 1UL);
+  std::cout << "Exhaustive disparities in the pruned ranges: "
+            << static_cast<double>(nbInRange) / nbPixels << std::endl;
+  std::cout << "Agreement with the exhaustive search: "
+            << static_cast<double>(nbMatches) / nbPixels
+            << ", in the pruned ranges: " << inRangeAgreement << std::endl;
+
+  if (inRangeAgreement < minAgreement)
+    {
+    std::cerr << "Only " << inRangeAgreement << " of the pixels whose exhaustive disparity lies in the "
+              << "pruned range match it, expected at least " << minAgreement << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -31,6 +31,7 @@ void RegisterTests()
   REGISTER_TEST(otbDisparityTranslateFilter);
   REGISTER_TEST(otbSubPixelDisparityImageFilterNew);
   REGISTER_TEST(otbSubPixelDisparityImageFilter);
+  REGISTER_TEST(otbSubPixelDisparityImageFilterBenchmark);
   REGISTER_TEST(otbDisparityMapEstimationMethodNew);
   REGISTER_TEST(otbDisparityMapTo3DFilterNew);
   REGISTER_TEST(otbDisparityMapTo3DFilter);
@@ -38,9 +39,16 @@ void RegisterTests()
   REGISTER_TEST(otbMultiDisparityMapTo3DFilter);
   REGISTER_TEST(otbFineRegistrationImageFilterNew);
   REGISTER_TEST(otbFineRegistrationImageFilterTest);
+  REGISTER_TEST(otbFineRegistrationImageFilterFastCorrelation);
   REGISTER_TEST(otbNCCRegistrationFilter);
   REGISTER_TEST(otbNCCRegistrationFilterNew);
   REGISTER_TEST(otbPixelWiseBlockMatchingImageFilter);
   REGISTER_TEST(otbPixelWiseBlockMatchingImageFilterNew);
   REGISTER_TEST(otbPixelWiseBlockMatchingImageFilterNCC);
+  REGISTER_TEST(otbPixelWiseBlockMatchingImageFilterBoxFilter);
+  REGISTER_TEST(otbSemiGlobalMatchingImageFilterNew);
+  REGISTER_TEST(otbSemiGlobalMatchingImageFilter);
+  REGISTER_TEST(otbSemiGlobalMatchingImageFilterSyntheticShift);
+  REGISTER_TEST(otbCoarseToFineDisparityRangeFilterNew);
+  REGISTER_TEST(otbCoarseToFineDisparityRangeFilter);
 }
@@ -27,6 +27,10 @@
 #include "otbStandardFilterWatcher.h"
 #include "itkTimeProbe.h"
 #include "otbExtractROI.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <fstream>
+#include <algorithm>
 
 
 #include "itkNormalizedCorrelationImageToImageMetric.h"
@@ -174,3 +178,111 @@ int otbFineRegistrationImageFilterTest( int argc, char * argv[] )
 
   return EXIT_SUCCESS;
 }
+
+int otbFineRegistrationImageFilterFastCorrelation( int argc, char * argv[] )
+{
+  if(argc!=10)
+    {
+    std::cerr<<"Usage: "<<argv[0]<<" fixed_fname moving_fname radius search_radius gridStep ";
+    std::cerr<<"subtractMean sizeX sizeY report_fname"<<std::endl;
+    return EXIT_FAILURE;
+    }
+  const unsigned int radius       = atoi(argv[3]);
+  const unsigned int sradius      = atoi(argv[4]);
+  const unsigned int gridStep     = atoi(argv[5]);
+  const bool         subtractMean = atoi(argv[6]) != 0;
+  const unsigned int sizeX        = atoi(argv[7]);
+  const unsigned int sizeY        = atoi(argv[8]);
+
+  typedef double      PixelType;
+  const unsigned int  Dimension = 2;
+
+  typedef itk::FixedArray<PixelType, Dimension>                                  DisplacementValueType;
+  typedef otb::Image< PixelType,  Dimension >                                    ImageType;
+  typedef otb::Image<DisplacementValueType, Dimension>                           FieldImageType;
+  typedef otb::ImageFileReader< ImageType >                                      ReaderType;
+  typedef otb::ExtractROI<PixelType, PixelType>                                  ExtractFiltertype;
+  typedef otb::FineRegistrationImageFilter<ImageType, ImageType, FieldImageType> RegistrationFilterType;
+  typedef itk::NormalizedCorrelationImageToImageMetric<ImageType, ImageType>     NCCType;
+
+  ReaderType::Pointer freader = ReaderType::New();
+  freader->SetFileName(argv[1]);
+
+  ReaderType::Pointer mreader = ReaderType::New();
+  mreader->SetFileName(argv[2]);
+
+  ExtractFiltertype::Pointer fextract = ExtractFiltertype::New();
+  fextract->SetInput(freader->GetOutput());
+  fextract->SetSizeX(sizeX);
+  fextract->SetSizeY(sizeY);
+  ExtractFiltertype::Pointer mextract = ExtractFiltertype::New();
+  mextract->SetInput(mreader->GetOutput());
+  mextract->SetSizeX(sizeX);
+  mextract->SetSizeY(sizeY);
+
+  // Same registration with the metric (0) and with the fast correlation (1)
+  RegistrationFilterType::Pointer registrations[2];
+  double times[2];
+
+  for(unsigned int i = 0; i < 2; ++i)
+    {
+    NCCType::Pointer metricPtr = NCCType::New();
+    metricPtr->SetSubtractMean(subtractMean);
+
+    registrations[i] = RegistrationFilterType::New();
+    registrations[i]->SetFixedInput(fextract->GetOutput());
+    registrations[i]->SetMovingInput(mextract->GetOutput());
+    registrations[i]->SetRadius(radius);
+    registrations[i]->SetSearchRadius(sradius);
+    registrations[i]->SetConvergenceAccuracy(0.01);
+    registrations[i]->SetGridStep(gridStep);
+    registrations[i]->SetMetric(metricPtr);
+    registrations[i]->MinimizeOn();
+    registrations[i]->SetUseFastCorrelation(i == 1);
+
+    itk::TimeProbe chrono;
+    chrono.Start();
+    registrations[i]->Update();
+    chrono.Stop();
+    times[i] = chrono.GetTotal();
+    }
+
+  itk::ImageRegionConstIterator<ImageType> refMetricIt(registrations[0]->GetOutput(),
+    registrations[0]->GetOutput()->GetBufferedRegion());
+  itk::ImageRegionConstIterator<ImageType> metricIt(registrations[1]->GetOutput(),
+    registrations[1]->GetOutput()->GetBufferedRegion());
+  itk::ImageRegionConstIterator<FieldImageType> refFieldIt(registrations[0]->GetOutputDisplacementField(),
+    registrations[0]->GetOutputDisplacementField()->GetBufferedRegion());
+  itk::ImageRegionConstIterator<FieldImageType> fieldIt(registrations[1]->GetOutputDisplacementField(),
+    registrations[1]->GetOutputDisplacementField()->GetBufferedRegion());
+
+  double maxMetricDiff = 0.;
+  unsigned long nbOfNodes = 0;
+  unsigned long nbOfDifferentDisplacements = 0;
+  for(refMetricIt.GoToBegin(), metricIt.GoToBegin(), refFieldIt.GoToBegin(), fieldIt.GoToBegin();
+      !refMetricIt.IsAtEnd(); ++refMetricIt, ++metricIt, ++refFieldIt, ++fieldIt)
+    {
+    maxMetricDiff = std::max(maxMetricDiff, vcl_abs(metricIt.Get() - refMetricIt.Get()));
+    if(vcl_abs(fieldIt.Get()[0] - refFieldIt.Get()[0]) > 1e-6
+       || vcl_abs(fieldIt.Get()[1] - refFieldIt.Get()[1]) > 1e-6)
+      {
+      ++nbOfDifferentDisplacements;
+      }
+    ++nbOfNodes;
+    }
+
+  std::ofstream report(argv[9]);
+  report<<"metric time (s)\tfast correlation time (s)\tmax. metric diff.\tdifferent displacements"<<std::endl;
+  report<<times[0]<<"\t"<<times[1]<<"\t"<<maxMetricDiff<<"\t"<<nbOfDifferentDisplacements<<"/"<<nbOfNodes<<std::endl;
+  report.close();
+
+  // Rounding errors may only break exact ties between offsets
+  if(maxMetricDiff > 1e-6 || nbOfDifferentDisplacements * 100 > nbOfNodes)
+    {
+    std::cerr<<"Fast correlation differs from the metric: max. metric diff. = "<<maxMetricDiff;
+    std::cerr<<", different displacements = "<<nbOfDifferentDisplacements<<"/"<<nbOfNodes<<std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
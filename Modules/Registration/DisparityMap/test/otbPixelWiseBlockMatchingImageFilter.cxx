@@ -126,3 +126,45 @@ int otbPixelWiseBlockMatchingImageFilterNCC(int argc, char * argv[])
 
   return EXIT_SUCCESS;
 }
+
+template <class TBlockMatchingFilter>
+int RunPixelWiseBlockMatchingBoxFilter(char * argv[], bool minimize)
+{
+  ReaderType::Pointer leftReader = ReaderType::New();
+  leftReader->SetFileName(argv[1]);
+
+  ReaderType::Pointer rightReader = ReaderType::New();
+  rightReader->SetFileName(argv[2]);
+
+  typename TBlockMatchingFilter::Pointer bmFilter = TBlockMatchingFilter::New();
+  bmFilter->SetLeftInput(leftReader->GetOutput());
+  bmFilter->SetRightInput(rightReader->GetOutput());
+  bmFilter->SetRadius(atoi(argv[5]));
+  bmFilter->SetMinimumHorizontalDisparity(atoi(argv[6]));
+  bmFilter->SetMaximumHorizontalDisparity(atoi(argv[7]));
+  bmFilter->SetMinimize(minimize);
+  bmFilter->UseBoxFilterOn();
+
+  FloatWriterType::Pointer dispWriter = FloatWriterType::New();
+  dispWriter->SetInput(bmFilter->GetHorizontalDisparityOutput());
+  dispWriter->SetFileName(argv[3]);
+  dispWriter->Update();
+
+  FloatWriterType::Pointer metricWriter = FloatWriterType::New();
+  metricWriter->SetInput(bmFilter->GetMetricOutput());
+  metricWriter->SetFileName(argv[4]);
+  metricWriter->Update();
+
+  return EXIT_SUCCESS;
+}
+
+int otbPixelWiseBlockMatchingImageFilterBoxFilter(int itkNotUsed(argc), char * argv[])
+{
+  std::string metric(argv[8]);
+
+  if (metric == "ncc")
+    {
+    return RunPixelWiseBlockMatchingBoxFilter<PixelWiseNCCBlockMatchingImageFilterType>(argv, false);
+    }
+  return RunPixelWiseBlockMatchingBoxFilter<PixelWiseBlockMatchingImageFilterType>(argv, true);
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbSemiGlobalMatchingImageFilter.h"
+#include "otbImageFileReader.h"
+#include "otbImageFileWriter.h"
+#include "itkStreamingImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+typedef otb::Image<unsigned short>           SGMImageType;
+typedef otb::Image<float>                    SGMFloatImageType;
+typedef otb::ImageFileReader<SGMImageType>   SGMReaderType;
+typedef otb::ImageFileWriter<SGMFloatImageType> SGMFloatWriterType;
+typedef itk::StreamingImageFilter<SGMFloatImageType, SGMFloatImageType> SGMStreamingFilterType;
+
+typedef otb::SemiGlobalMatchingImageFilter<SGMImageType, SGMFloatImageType> SemiGlobalMatchingImageFilterType;
+
+int otbSemiGlobalMatchingImageFilterNew(int itkNotUsed(argc), char * itkNotUsed(argv) [])
+{
+  // Instantiation
+  SemiGlobalMatchingImageFilterType::Pointer sgmFilter = SemiGlobalMatchingImageFilterType::New();
+
+  std::cout << sgmFilter << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+int otbSemiGlobalMatchingImageFilter(int itkNotUsed(argc), char * argv[])
+{
+  SGMReaderType::Pointer leftReader = SGMReaderType::New();
+  leftReader->SetFileName(argv[1]);
+
+  SGMReaderType::Pointer rightReader = SGMReaderType::New();
+  rightReader->SetFileName(argv[2]);
+
+  // Whole image, in one stream
+  SemiGlobalMatchingImageFilterType::Pointer sgmFilter = SemiGlobalMatchingImageFilterType::New();
+  sgmFilter->SetLeftInput(leftReader->GetOutput());
+  sgmFilter->SetRightInput(rightReader->GetOutput());
+  sgmFilter->SetMinimumHorizontalDisparity(atoi(argv[5]));
+  sgmFilter->SetMaximumHorizontalDisparity(atoi(argv[6]));
+  sgmFilter->SetNumberOfPaths(atoi(argv[7]));
+  sgmFilter->SetTileMargin(10000);
+
+  SGMFloatWriterType::Pointer writer1 = SGMFloatWriterType::New();
+  writer1->SetInput(sgmFilter->GetHorizontalDisparityOutput());
+  writer1->SetFileName(argv[3]);
+  writer1->Update();
+
+  // Streamed. With a margin covering the image, the disparities must be
+  // the same.
+  SemiGlobalMatchingImageFilterType::Pointer streamedSgmFilter = SemiGlobalMatchingImageFilterType::New();
+  streamedSgmFilter->SetLeftInput(leftReader->GetOutput());
+  streamedSgmFilter->SetRightInput(rightReader->GetOutput());
+  streamedSgmFilter->SetMinimumHorizontalDisparity(atoi(argv[5]));
+  streamedSgmFilter->SetMaximumHorizontalDisparity(atoi(argv[6]));
+  streamedSgmFilter->SetNumberOfPaths(atoi(argv[7]));
+  streamedSgmFilter->SetTileMargin(10000);
+
+  SGMFloatWriterType::Pointer writer2 = SGMFloatWriterType::New();
+  writer2->SetInput(streamedSgmFilter->GetHorizontalDisparityOutput());
+  writer2->SetFileName(argv[4]);
+  writer2->SetNumberOfDivisionsStrippedStreaming(4);
+  writer2->Update();
+
+  return EXIT_SUCCESS;
+}
+
+int otbSemiGlobalMatchingImageFilterSyntheticShift(int itkNotUsed(argc), char * argv[])
+{
+  const unsigned int size = atoi(argv[1]);
+  const int shift = atoi(argv[2]);
+  const unsigned int nbDivisions = atoi(argv[3]);
+  const double tolerance = atof(argv[4]);
+  const double minFraction = atof(argv[5]);
+  const int minDisparity = shift - 4;
+  const int maxDisparity = shift + 4;
+
+  // Random texture, the right image being the left one shifted by "shift"
+  // pixels: right(x + shift, y) = left(x, y)
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(12345);
+
+  const unsigned int textureWidth = size + std::abs(shift);
+  std::vector<unsigned short> texture(textureWidth * size);
+  for (unsigned int i = 0; i < texture.size(); ++i)
+    {
+    texture[i] = static_cast<unsigned short>(generator->GetIntegerVariate(1000));
+    }
+
+  SGMImageType::RegionType region;
+  region.SetIndex(0, 0);
+  region.SetIndex(1, 0);
+  region.SetSize(0, size);
+  region.SetSize(1, size);
+
+  SGMImageType::Pointer left = SGMImageType::New();
+  left->SetRegions(region);
+  left->Allocate();
+  SGMImageType::Pointer right = SGMImageType::New();
+  right->SetRegions(region);
+  right->Allocate();
+
+  const int offset = shift < 0 ? -shift : 0;
+  for (unsigned int y = 0; y < size; ++y)
+    {
+    for (unsigned int x = 0; x < size; ++x)
+      {
+      SGMImageType::IndexType index;
+      index[0] = x;
+      index[1] = y;
+      left->SetPixel(index, texture[y * textureWidth + x + offset + shift]);
+      right->SetPixel(index, texture[y * textureWidth + x + offset]);
+      }
+    }
+
+  // Whole image, in one stream
+  SemiGlobalMatchingImageFilterType::Pointer sgmFilter = SemiGlobalMatchingImageFilterType::New();
+  sgmFilter->SetLeftInput(left);
+  sgmFilter->SetRightInput(right);
+  sgmFilter->SetMinimumHorizontalDisparity(minDisparity);
+  sgmFilter->SetMaximumHorizontalDisparity(maxDisparity);
+  sgmFilter->Update();
+
+  // Streamed, with the default tile margin
+  SemiGlobalMatchingImageFilterType::Pointer streamedSgmFilter = SemiGlobalMatchingImageFilterType::New();
+  streamedSgmFilter->SetLeftInput(left);
+  streamedSgmFilter->SetRightInput(right);
+  streamedSgmFilter->SetMinimumHorizontalDisparity(minDisparity);
+  streamedSgmFilter->SetMaximumHorizontalDisparity(maxDisparity);
+  std::cout << "Tile margin: " << streamedSgmFilter->GetTileMargin() << std::endl;
+
+  SGMStreamingFilterType::Pointer streamer = SGMStreamingFilterType::New();
+  streamer->SetInput(streamedSgmFilter->GetHorizontalDisparityOutput());
+  streamer->SetNumberOfStreamDivisions(nbDivisions);
+  streamer->Update();
+
+  // Pixels whose census window and disparity range stay in the images
+  const int border = std::max(std::abs(minDisparity), std::abs(maxDisparity)) + 3;
+  unsigned int nbPixels = 0;
+  unsigned int nbShiftMatches = 0;
+  unsigned int nbStreamingMatches = 0;
+  itk::ImageRegionConstIteratorWithIndex<SGMFloatImageType> it(sgmFilter->GetHorizontalDisparityOutput(), region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    const SGMFloatImageType::IndexType index = it.GetIndex();
+    if (index[0] < border || index[0] >= static_cast<int>(size) - border
+        || index[1] < 3 || index[1] >= static_cast<int>(size) - 3)
+      {
+      continue;
+      }
+    ++nbPixels;
+    if (vcl_abs(it.Get() - shift) <= tolerance)
+      {
+      ++nbShiftMatches;
+      }
+    if (vcl_abs(streamer->GetOutput()->GetPixel(index) - it.Get()) <= tolerance)
+      {
+      ++nbStreamingMatches;
+      }
+    }
+
+  const double shiftFraction = static_cast<double>(nbShiftMatches) / nbPixels;
+  const double streamingFraction = static_cast<double>(nbStreamingMatches) / nbPixels;
+  std::cout << "Fraction of pixels at the shift: " << shiftFraction << std::endl;
+  std::cout << "Fraction of pixels independent of the streaming: " << streamingFraction << std::endl;
+
+  if (shiftFraction < minFraction)
+    {
+    std::cerr << "Only " << shiftFraction << " of the pixels are within " << tolerance
+              << " of the shift " << shift << ", expected at least " << minFraction << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (streamingFraction < minFraction)
+    {
+    std::cerr << "Only " << streamingFraction << " of the streamed pixels are within " << tolerance
+              << " of the whole image disparities, expected at least " << minFraction << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -23,6 +23,8 @@
 #include "otbImageFileWriter.h"
 #include "otbStandardWriterWatcher.h"
 #include "otbImage.h"
+#include "itkTimeProbe.h"
+#include <fstream>
 
 
   const unsigned int Dimension = 2;
@@ -55,6 +57,12 @@
                                                   LPBlockMatchingFunctorType> LPSubPixelDisparityFilterType;
 
 
+  typedef otb::PixelWiseBlockMatchingImageFilter<FloatImageType,
+                                                FloatImageType,
+                                                FloatImageType,
+                                                FloatImageType,
+                                                SSDBlockMatchingFunctorType> SSDBlockMatchingFilterType;
+
   typedef otb::ImageFileReader<FloatImageType>               ReaderType;
   typedef otb::ImageFileWriter<FloatImageType>      WriterType;
 
@@ -127,6 +135,9 @@ template<class TImage,class TFunctorType> int ProcessAndWriteOutput(otb::SubPixe
     case 3:
       subPixFilter->SetRefineMethod(NCCSubPixelDisparityFilterType::DICHOTOMY);
       break;
+    case 4:
+      subPixFilter->SetRefineMethod(NCCSubPixelDisparityFilterType::FAST_DICHOTOMY);
+      break;
     default:
       std::cout << "wrong pixel mode" << std::endl;
       return EXIT_FAILURE;
@@ -170,7 +181,7 @@ int otbSubPixelDisparityImageFilter(int argc, char* argv[])
         << " leftinput_fname rightinput_fname blockmatchinginput_fname blockmatchingmetricinput_fname ";
     std::cerr << "hdispoutput_fname vdispoutput_fname metricoutput_fname " << std::endl;
     std::cerr << "metric (0=SSD, 1=NCC, 2=LP pseudo norm) ";
-    std::cerr << "subpixelmode (1=parabolic,2=triangular,3=dichotomy)" << std::endl;
+    std::cerr << "subpixelmode (1=parabolic,2=triangular,3=dichotomy,4=fast dichotomy)" << std::endl;
     std::cerr << "radius minhdisp maxhdisp minvdisp maxvdisp " << std::endl;
     std::cerr << "(leftmaskinput_fname) (rightmaskinput_fname)" << std::endl;
     return EXIT_FAILURE;
@@ -203,3 +214,98 @@ int otbSubPixelDisparityImageFilter(int argc, char* argv[])
 
   return EXIT_FAILURE;
 }
+
+int otbSubPixelDisparityImageFilterBenchmark(int argc, char* argv[])
+{
+  if (argc != 7)
+    {
+    std::cerr << "Usage: " << argv[0]
+        << " leftinput_fname rightinput_fname radius minhdisp maxhdisp report_fname" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ReaderType::Pointer leftReader = ReaderType::New();
+  leftReader->SetFileName(argv[1]);
+
+  ReaderType::Pointer rightReader = ReaderType::New();
+  rightReader->SetFileName(argv[2]);
+
+  // Integer search, keeping the metrics around the best disparities
+  SSDBlockMatchingFilterType::Pointer blockMatcher = SSDBlockMatchingFilterType::New();
+  blockMatcher->SetLeftInput(leftReader->GetOutput());
+  blockMatcher->SetRightInput(rightReader->GetOutput());
+  blockMatcher->SetRadius(atoi(argv[3]));
+  blockMatcher->SetMinimumHorizontalDisparity(atoi(argv[4]));
+  blockMatcher->SetMaximumHorizontalDisparity(atoi(argv[5]));
+  blockMatcher->SetMinimumVerticalDisparity(0);
+  blockMatcher->SetMaximumVerticalDisparity(0);
+  blockMatcher->MinimizeOn();
+  blockMatcher->ComputeNeighborMetricsOn();
+  blockMatcher->Update();
+
+  const int methods[4] = {SSDSubPixelDisparityFilterType::PARABOLIC,
+                          SSDSubPixelDisparityFilterType::TRIANGULAR,
+                          SSDSubPixelDisparityFilterType::DICHOTOMY,
+                          SSDSubPixelDisparityFilterType::FAST_DICHOTOMY};
+  const char * names[4] = {"parabolic", "triangular", "dichotomy", "fast dichotomy"};
+  SSDSubPixelDisparityFilterType::Pointer subPixFilters[4];
+  double times[4];
+
+  for (unsigned int i = 0; i < 4; ++i)
+    {
+    subPixFilters[i] = SSDSubPixelDisparityFilterType::New();
+    subPixFilters[i]->SetInputsFromBlockMatchingFilter(blockMatcher);
+    subPixFilters[i]->SetRefineMethod(methods[i]);
+
+    itk::TimeProbe probe;
+    probe.Start();
+    subPixFilters[i]->Update();
+    probe.Stop();
+    times[i] = probe.GetTotal();
+    }
+
+  // The dichotomy is the reference for the accuracy
+  std::ofstream report(argv[6]);
+  report << "method\ttime (s)\tmean abs. diff. to dichotomy (px)\tmean metric" << std::endl;
+
+  double fastDichotomyDiff = 0.;
+  for (unsigned int i = 0; i < 4; ++i)
+    {
+    itk::ImageRegionConstIterator<FloatImageType> refIt(subPixFilters[2]->GetHorizontalDisparityOutput(),
+      subPixFilters[2]->GetHorizontalDisparityOutput()->GetBufferedRegion());
+    itk::ImageRegionConstIterator<FloatImageType> dispIt(subPixFilters[i]->GetHorizontalDisparityOutput(),
+      subPixFilters[i]->GetHorizontalDisparityOutput()->GetBufferedRegion());
+    itk::ImageRegionConstIterator<FloatImageType> metricIt(subPixFilters[i]->GetMetricOutput(),
+      subPixFilters[i]->GetMetricOutput()->GetBufferedRegion());
+
+    double diff = 0.;
+    double metric = 0.;
+    unsigned long count = 0;
+    for (refIt.GoToBegin(), dispIt.GoToBegin(), metricIt.GoToBegin(); !refIt.IsAtEnd(); ++refIt, ++dispIt, ++metricIt)
+      {
+      diff += vcl_abs(static_cast<double>(dispIt.Get()) - static_cast<double>(refIt.Get()));
+      metric += static_cast<double>(metricIt.Get());
+      ++count;
+      }
+    if (count > 0)
+      {
+      diff /= static_cast<double>(count);
+      metric /= static_cast<double>(count);
+      }
+    if (methods[i] == SSDSubPixelDisparityFilterType::FAST_DICHOTOMY)
+      {
+      fastDichotomyDiff = diff;
+      }
+    report << names[i] << "\t" << times[i] << "\t" << diff << "\t" << metric << std::endl;
+    }
+  report.close();
+
+  // The fast dichotomy performs the same search as the dichotomy
+  if (fastDichotomyDiff > 1e-2)
+    {
+    std::cerr << "Fast dichotomy differs from dichotomy: mean abs. difference = " << fastDichotomyDiff << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -39,7 +39,8 @@ enum CellFusionMode {
   MIN = 0,
   MAX = 1,
   MEAN = 2,
-  ACC = 3 //return accumulator for debug purpose
+  ACC = 3, //return accumulator for debug purpose
+  MEDIAN = 4
   };
 }
 
@@ -55,6 +56,7 @@ enum CellFusionMode {
  * - 1 MAX : we keep the maximum altitude
  * - 2 MEAN : mean is computed
  * - 3 ACC : returns cell count (useful to create mask from output)
+ * - 4 MEDIAN : median altitude is computed
  *
  *  empty cell are filled with the NoDataValue (-32768 by default)
  *
@@ -68,6 +70,12 @@ enum CellFusionMode {
  *  Origin, Spacing, Size, StartIndex, ProjectionRef
  *  thus DEMGridStep parameter is ignored in this case (replaced by Spacing)
  *
+ *  The 3D maps are processed one after the other. The points of a map are projected
+ *  in parallel and binned by output tile (a band of rows of the output requested region),
+ *  then each tile is fused by a single thread, so that no locking and no per-thread copy
+ *  of the DEM is needed. Apart from the MEDIAN mode, which keeps every height until all
+ *  the maps are fused, the memory used does not depend on the number of 3D maps.
+ *
  *  \sa FineRegistrationImageFilter
  *  \sa MultiDisparityMapTo3DFilter
  *
@@ -243,7 +251,7 @@ protected:
   /** Before threaded generate data */
   void BeforeThreadedGenerateData() ITK_OVERRIDE;
 
-  /** Threaded generate data */
+  /** Threaded generate data: turns the fused cells into DEM values */
   void ThreadedGenerateData(const RegionType & outputRegionForThread, itk::ThreadIdType threadId) ITK_OVERRIDE;
 
   /** After threaded generate data */
@@ -261,6 +269,25 @@ private:
 
   void SetOutputParametersFromImage();
 
+  struct FusionThreadStruct
+  {
+    Self *       Filter;
+    unsigned int MapIndex;
+    bool         IsLastMap;
+  };
+
+  /** Projects the splits of a 3D map in parallel */
+  static ITK_THREAD_RETURN_TYPE ScatterThreaderCallback(void * arg);
+
+  /** Fuses the output tiles in parallel */
+  static ITK_THREAD_RETURN_TYPE FuseThreaderCallback(void * arg);
+
+  /** Projects a split of a 3D map and bins its points by output tile */
+  void ScatterSplit(unsigned int mapIndex, unsigned int splitIndex, unsigned int bucketIndex);
+
+  /** Fuses the points binned in an output tile */
+  void FuseTile(unsigned int tileIndex, bool isLastMap);
+
   Multi3DMapToDEMFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
@@ -279,10 +306,30 @@ private:
   /** DEM grid step (in meters) */
   double m_DEMGridStep;
 
-  /** Temporary DEMs for multithreading */
-   std::vector<typename OutputImageType::Pointer>      m_TempDEMRegions;
-   /** Temporary accumulator for multithreading and mean calculus*/
-   std::vector<typename AccumulatorImageType::Pointer> m_TempDEMAccumulatorRegions;
+  /** Height of a projected point, with the offset of its cell in the output requested region */
+  struct CellHeight
+  {
+    itk::OffsetValueType Offset;
+    DEMPixelType         Height;
+
+    bool operator<(const CellHeight & other) const
+    {
+      return (Offset < other.Offset) || (Offset == other.Offset && Height < other.Height);
+    }
+  };
+  typedef std::vector<CellHeight> CellHeightListType;
+
+  /** Points of the current map, binned by projecting thread then by output tile */
+  std::vector<std::vector<CellHeightListType> > m_Buckets;
+
+  /** Heights gathered over all the maps, by output tile (MEDIAN mode only) */
+  std::vector<CellHeightListType> m_TileHeights;
+
+  /** Output tile of each row of the output requested region */
+  std::vector<unsigned int> m_RowTiles;
+
+  /** Number of points fused in each cell */
+  typename AccumulatorImageType::Pointer m_Accumulator;
 
 
   std::vector<unsigned int> m_NumberOfSplit; // number of split for each map
@@ -26,6 +26,7 @@
 #include "itkImageRegionIterator.h"
 #include "otbStreamingStatisticsVectorImageFilter.h"
 #include "otbInverseSensorModel.h"
+#include <algorithm>
 
 namespace otb
 {
@@ -495,18 +496,25 @@ void Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::GenerateInput
 template<class T3DImage, class TMaskImage, class TOutputDEMImage>
 void Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::BeforeThreadedGenerateData()
 {
-  const TOutputDEMImage * outputDEM = this->GetDEMOutput();
+  if (m_CellFusionMode < otb::CellFusionMode::MIN || m_CellFusionMode > otb::CellFusionMode::MEDIAN)
+    {
+    itkExceptionMacro(<< "Unexpected value cell fusion mode :"<<this->m_CellFusionMode);
+    }
+
+  TOutputDEMImage * outputDEM = this->GetDEMOutput();
+  const RegionType outputRequestedRegion = outputDEM->GetRequestedRegion();
+  const unsigned int nbThreads = this->GetNumberOfThreads();
 
   //create splits
   // for each map we check if the input region can be split into threadNb
+  m_MapSplitterList->Clear();
   m_NumberOfSplit.resize(this->GetNumberOf3DMaps());
 
-  unsigned int maximumRegionsNumber = 1;
-
+  int lastMap = -1;
   for (unsigned int k = 0; k < this->GetNumberOf3DMaps(); ++k)
     {
     m_MapSplitterList->PushBack(SplitterType::New());
-    T3DImage *imgPtr = const_cast<T3DImage *> (this->Get3DMapInput(k));
+    const T3DImage *imgPtr = this->Get3DMapInput(k);
 
     typename T3DImage::RegionType requestedRegion = imgPtr->GetRequestedRegion();
 
@@ -514,39 +522,39 @@ void Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::BeforeThreade
     unsigned int regionsNumber =0;
     if(requestedSize[0]*requestedSize[1]!=0)
       {
-    regionsNumber = m_MapSplitterList->GetNthElement(k)->GetNumberOfSplits(requestedRegion,
-                                                                                        this->GetNumberOfThreads());
+      regionsNumber = m_MapSplitterList->GetNthElement(k)->GetNumberOfSplits(requestedRegion, nbThreads);
+      lastMap = k;
       }
     m_NumberOfSplit[k] = regionsNumber;
     otbMsgDevMacro( "map " << k << " will be split into " << regionsNumber << " regions" );
-    if (maximumRegionsNumber < regionsNumber) maximumRegionsNumber = regionsNumber;
-
     }
 
-  m_TempDEMRegions.clear();
-  m_TempDEMAccumulatorRegions.clear();
-  //m_ThreadProcessed.resize(maximumRegionsNumber);
+  // The output requested region is cut into bands of rows, each of them fused by a single thread
+  const unsigned long nbRows = outputRequestedRegion.GetSize(1);
+  const unsigned int nbTiles = static_cast<unsigned int>(std::max(1UL, std::min(static_cast<unsigned long>(nbThreads), nbRows)));
+  m_RowTiles.resize(nbRows);
+  for (unsigned int j = 0; j < nbTiles; ++j)
+    {
+    for (unsigned long row = j * nbRows / nbTiles; row < (j + 1) * nbRows / nbTiles; ++row)
+      {
+      m_RowTiles[row] = j;
+      }
+    }
 
-  for (unsigned int i = 0; i < maximumRegionsNumber; i++)
+  m_Buckets.assign(nbThreads, std::vector<CellHeightListType>(nbTiles));
+  m_TileHeights.clear();
+  if (m_CellFusionMode == otb::CellFusionMode::MEDIAN)
     {
-    //m_ThreadProcessed[i] = 0;
-    typename TOutputDEMImage::Pointer tmpImg = TOutputDEMImage::New();
-    tmpImg->SetNumberOfComponentsPerPixel(1); //Two components for mean calculus ?
-    tmpImg->SetRegions(outputDEM->GetRequestedRegion());
-    tmpImg->Allocate();
-
-    tmpImg->FillBuffer(m_NoDataValue);
-    m_TempDEMRegions.push_back(tmpImg);
-
-    typename AccumulatorImageType::Pointer tmpImg2 = AccumulatorImageType::New();
-    tmpImg2->SetNumberOfComponentsPerPixel(1); //Two components for mean calculus ?
-    tmpImg2->SetRegions(outputDEM->GetRequestedRegion());
-    tmpImg2->Allocate();
-
-    tmpImg2->FillBuffer(0.);
-    m_TempDEMAccumulatorRegions.push_back(tmpImg2);
+    m_TileHeights.resize(nbTiles);
     }
 
+  m_Accumulator = AccumulatorImageType::New();
+  m_Accumulator->SetRegions(outputRequestedRegion);
+  m_Accumulator->Allocate();
+  m_Accumulator->FillBuffer(0);
+
+  outputDEM->FillBuffer(m_NoDataValue);
+
   if (!this->m_IsGeographic)
     {
     m_GroundTransform = RSTransform2DType::New();
@@ -555,347 +563,278 @@ void Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::BeforeThreade
     m_GroundTransform->InstantiateTransform();
     }
 
+  // Maps are fused one after the other: their points are first binned by output tile, then
+  // each tile is fused by a single thread
+  FusionThreadStruct str;
+  str.Filter = this;
+  for (unsigned int k = 0; k < this->GetNumberOf3DMaps(); ++k)
+    {
+    if (m_NumberOfSplit[k] == 0)
+      {
+      continue;
+      }
+    str.MapIndex = k;
+    str.IsLastMap = (static_cast<int>(k) == lastMap);
+
+    this->GetMultiThreader()->SetNumberOfThreads(std::min(nbThreads, m_NumberOfSplit[k]));
+    this->GetMultiThreader()->SetSingleMethod(this->ScatterThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+
+    this->GetMultiThreader()->SetNumberOfThreads(nbTiles);
+    this->GetMultiThreader()->SetSingleMethod(this->FuseThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
+  this->GetMultiThreader()->SetNumberOfThreads(nbThreads);
 }
 
 template<class T3DImage, class TMaskImage, class TOutputDEMImage>
-void Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::ThreadedGenerateData(
-  const RegionType & itkNotUsed(outputRegionForThread),
-  itk::ThreadIdType threadId)
+ITK_THREAD_RETURN_TYPE
+Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::ScatterThreaderCallback(void * arg)
 {
-  TOutputDEMImage * outputPtr = this->GetOutput();
+  itk::MultiThreader::ThreadInfoStruct * info = static_cast<itk::MultiThreader::ThreadInfoStruct *>(arg);
+  FusionThreadStruct * str = static_cast<FusionThreadStruct *>(info->UserData);
+  const unsigned int threadId = info->ThreadID;
+  const unsigned int nbThreads = info->NumberOfThreads;
 
-  typename OutputImageType::PointType pointRef;
-  typename OutputImageType::PointType pointRefStep;
-  typename OutputImageType::RegionType requestedRegion = outputPtr->GetRequestedRegion();
+  for (unsigned int i = threadId; i < str->Filter->m_NumberOfSplit[str->MapIndex]; i += nbThreads)
+    {
+    str->Filter->ScatterSplit(str->MapIndex, i, threadId);
+    }
 
-//  typename TOutputDEMImage::SpacingType step = outputPtr->GetSignedSpacing();
+  return ITK_THREAD_RETURN_VALUE;
+}
 
-  //convert requested region to Long/Lat
+template<class T3DImage, class TMaskImage, class TOutputDEMImage>
+ITK_THREAD_RETURN_TYPE
+Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::FuseThreaderCallback(void * arg)
+{
+  itk::MultiThreader::ThreadInfoStruct * info = static_cast<itk::MultiThreader::ThreadInfoStruct *>(arg);
+  FusionThreadStruct * str = static_cast<FusionThreadStruct *>(info->UserData);
+  const unsigned int threadId = info->ThreadID;
+  const unsigned int nbThreads = info->NumberOfThreads;
 
-//  typename TOutputDEMImage::SizeType size = requestedRegion.GetSize();
+  const unsigned int nbTiles = str->Filter->m_Buckets.front().size();
+  for (unsigned int j = threadId; j < nbTiles; j += nbThreads)
+    {
+    str->Filter->FuseTile(j, str->IsLastMap);
+    }
 
-  typename TOutputDEMImage::IndexType index = requestedRegion.GetIndex();
-  outputPtr->TransformIndexToPhysicalPoint(index, pointRef);
-  /*
-  InputInternalPixelType regionLong1 = pointRef[0];
-  InputInternalPixelType regionLat1 = pointRef[1];
-  InputInternalPixelType regionLong2 = pointRef[0] + size[0] * step[0];
-  InputInternalPixelType regionLat2 = pointRef[1] + size[1] * step[1];
-  InputInternalPixelType minLong = std::min(regionLong1, regionLong2);
-  InputInternalPixelType minLat = std::min(regionLat1, regionLat2);
-  InputInternalPixelType maxLong = std::max(regionLong1, regionLong2);
-  InputInternalPixelType maxLat = std::max(regionLat1, regionLat2);
-  */
+  return ITK_THREAD_RETURN_VALUE;
+}
 
-  TOutputDEMImage * tmpDEM = ITK_NULLPTR;
-  AccumulatorImageType *tmpAcc = ITK_NULLPTR;
-  typename TOutputDEMImage::RegionType outputRequestedRegion = outputPtr->GetRequestedRegion();
+template<class T3DImage, class TMaskImage, class TOutputDEMImage>
+void Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::ScatterSplit(unsigned int mapIndex,
+                                                                                unsigned int splitIndex,
+                                                                                unsigned int bucketIndex)
+{
+  const TOutputDEMImage * outputPtr = this->GetDEMOutput();
+  const RegionType outputRequestedRegion = outputPtr->GetRequestedRegion();
 
-  typename T3DImage::RegionType splitRegion;
+  const T3DImage *imgPtr = this->Get3DMapInput(mapIndex);
+  const TMaskImage *mskPtr = this->GetMaskInput(mapIndex);
 
-  MapPixelType position;
+  typename T3DImage::RegionType splitRegion =
+    m_MapSplitterList->GetNthElement(mapIndex)->GetSplit(splitIndex, m_NumberOfSplit[mapIndex],
+                                                         imgPtr->GetRequestedRegion());
 
-  itk::ImageRegionConstIterator<InputMapType> mapIt;
-  for (unsigned int k = 0; k < this->GetNumberOf3DMaps(); ++k)
-    {
-    if (m_NumberOfSplit[k] > 0)
-      {
-      T3DImage *imgPtr = const_cast<T3DImage *> (this->Get3DMapInput(k));
-      TMaskImage *mskPtr = const_cast<TMaskImage *> (this->GetMaskInput(k));
+  std::vector<CellHeightListType> & buckets = m_Buckets[bucketIndex];
 
-      typename InputMapType::PointType origin;
-      origin = imgPtr->GetOrigin();
-      typename InputMapType::SpacingType spacing;
-      spacing = imgPtr->GetSignedSpacing();
+  itk::ImageRegionConstIterator<InputMapType> mapIt(imgPtr, splitRegion);
+  itk::ImageRegionConstIterator<MaskImageType> maskIt;
+  bool useMask = false;
+  if (mskPtr)
+    {
+    useMask = true;
+    maskIt = itk::ImageRegionConstIterator<MaskImageType>(mskPtr, splitRegion);
+    maskIt.GoToBegin();
+    }
 
-      if (static_cast<unsigned int> (threadId) < m_NumberOfSplit[k])
+  MapPixelType position;
+  for (mapIt.GoToBegin(); !mapIt.IsAtEnd(); ++mapIt)
+    {
+    // check mask value if any
+    if (useMask)
+      {
+      const bool isMasked = !(maskIt.Get() > 0);
+      ++maskIt;
+      if (isMasked)
         {
-        splitRegion = m_MapSplitterList->GetNthElement(k)->GetSplit(threadId, m_NumberOfSplit[k],
-                                                                    imgPtr->GetRequestedRegion());
+        continue;
+        }
+      }
 
-        tmpDEM = m_TempDEMRegions[threadId];
-        tmpAcc = m_TempDEMAccumulatorRegions[threadId];
+    position = mapIt.Get();
 
-        mapIt = itk::ImageRegionConstIterator<InputMapType>(imgPtr, splitRegion);
-        mapIt.GoToBegin();
-        itk::ImageRegionConstIterator<MaskImageType> maskIt;
-        bool useMask = false;
-        if (mskPtr)
-          {
-          useMask = true;
-          maskIt = itk::ImageRegionConstIterator<MaskImageType>(mskPtr, splitRegion);
-          maskIt.GoToBegin();
-          }
+    if (!this->m_IsGeographic)
+      {
+      typename RSTransform2DType::InputPointType tmpPoint;
+      tmpPoint[0] = position[0];
+      tmpPoint[1] = position[1];
+      RSTransform2DType::OutputPointType groundPosition = m_GroundTransform->TransformPoint(tmpPoint);
+      position[0] = groundPosition[0];
+      position[1] = groundPosition[1];
+      }
 
-        while (!mapIt.IsAtEnd())
-          {
-          // check mask value if any
-          if (useMask)
-            {
-            if (!(maskIt.Get() > 0))
-              {
-              ++mapIt;
-              ++maskIt;
-              continue;
-              }
-            }
+    // Is point inside DEM area ?
+    typename OutputImageType::PointType point2D;
+    point2D[0] = position[0];
+    point2D[1] = position[1];
+    itk::ContinuousIndex<double, 2> continuousIndex;
 
-          position = mapIt.Get();
+    // The DEM cell at index 'n' contains continuous indexes from 'n-0.5' to 'n+0.5'
+    outputPtr->TransformPhysicalPointToContinuousIndex(point2D, continuousIndex);
+    typename OutputImageType::IndexType cellIndex;
+    cellIndex[0] = static_cast<int> (vcl_floor(continuousIndex[0] + 0.5));
+    cellIndex[1] = static_cast<int> (vcl_floor(continuousIndex[1] + 0.5));
 
-          //std::cout<<"position"<<position<<std::endl;
-          if (!this->m_IsGeographic)
-            {
-            //std::cout<<"is geographic "<<std::endl;
-            typename RSTransform2DType::InputPointType tmpPoint;
-            tmpPoint[0] = position[0];
-            tmpPoint[1] = position[1];
-            RSTransform2DType::OutputPointType groundPosition = m_GroundTransform->TransformPoint(tmpPoint);
-            position[0] = groundPosition[0];
-            position[1] = groundPosition[1];
-            }
+    if (outputRequestedRegion.IsInside(cellIndex))
+      {
+      CellHeight cell;
+      cell.Offset = outputPtr->ComputeOffset(cellIndex);
+      cell.Height = static_cast<DEMPixelType> (position[2]);
+      buckets[m_RowTiles[cellIndex[1] - outputRequestedRegion.GetIndex(1)]].push_back(cell);
+      }
+    }
+}
 
-          //test if position is in DEM BBOX
-          /**    -Wunused-variable
-          bool isInDEM = (position[0] >= minLong) && (position[0] < maxLong) && (position[1] >= minLat) && (position[1]
-                      < maxLat);
-          **/
-          // Is point inside DEM area ?
-          typename OutputImageType::PointType point2D;
-          point2D[0] = position[0];
-          point2D[1] = position[1];
-          itk::ContinuousIndex<double, 2> continuousIndex;
-
-          //std::cout<<"point2D "<<point2D<<std::endl;
-          // The DEM cell at index 'n' contains continuous indexes from 'n-0.5' to 'n+0.5'
-          outputPtr->TransformPhysicalPointToContinuousIndex(point2D, continuousIndex);
-          typename OutputImageType::IndexType cellIndex;
-          cellIndex[0] = static_cast<int> (vcl_floor(continuousIndex[0] + 0.5));
-          cellIndex[1] = static_cast<int> (vcl_floor(continuousIndex[1] + 0.5));
-          //std::cout<<"cellindex "<<cellIndex<<std::endl;
-          //index from physical
-          /** -Wunused-variable
-            typename OutputImageType::IndexType physCellIndex;
-
-          //double CellIndexLong=(position[0]-outOrigin[0])/step[0];
-          //double CellIndexLat=(position[1]-outOrigin[1])/step[1];
-          typename OutputImageType::IndexType cellIndex2;
-          **/
-          if (outputRequestedRegion.IsInside(cellIndex))
-            {
-            //std::cout<<"is inside "<<std::endl;
-            // Add point to its corresponding cell (keep maximum)
-            DEMPixelType cellHeight = static_cast<DEMPixelType> (position[2]);
-            //if (cellHeight > tmpDEM->GetPixel(cellIndex) && cellHeight < static_cast<DEMPixelType>(m_ElevationMax))
-            //  {
-            // tmpDEM->SetPixel(cellIndex,tmpDEM->GetPixel(cellIndex)+1);
+template<class T3DImage, class TMaskImage, class TOutputDEMImage>
+void Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::FuseTile(unsigned int tileIndex, bool isLastMap)
+{
+  DEMPixelType * dem = this->GetDEMOutput()->GetBufferPointer();
+  AccumulatorPixelType * acc = m_Accumulator->GetBufferPointer();
+
+  for (unsigned int i = 0; i < m_Buckets.size(); ++i)
+    {
+    CellHeightListType & bucket = m_Buckets[i][tileIndex];
 
-            AccumulatorPixelType accPixel = tmpAcc->GetPixel(cellIndex);
-            tmpAcc->SetPixel(cellIndex, tmpAcc->GetPixel(cellIndex) + 1);
+    if (m_CellFusionMode == otb::CellFusionMode::MEDIAN)
+      {
+      m_TileHeights[tileIndex].insert(m_TileHeights[tileIndex].end(), bucket.begin(), bucket.end());
+      }
+    else
+      {
+      for (typename CellHeightListType::const_iterator it = bucket.begin(); it != bucket.end(); ++it)
+        {
+        const itk::OffsetValueType offset = it->Offset;
+        const DEMPixelType cellHeight = it->Height;
 
-            if (accPixel == 0)
+        if (acc[offset] == 0)
+          {
+          dem[offset] = cellHeight;
+          }
+        else
+          {
+          switch (this->m_CellFusionMode)
+            {
+            case otb::CellFusionMode::MIN:
               {
-              tmpDEM->SetPixel(cellIndex, cellHeight);
+              if (cellHeight < dem[offset])
+                {
+                dem[offset] = cellHeight;
+                }
               }
-            else
+              break;
+            case otb::CellFusionMode::MAX:
               {
-              DEMPixelType cellCurrentValue = tmpDEM->GetPixel(cellIndex);
-
-              switch (this->m_CellFusionMode)
+              if (cellHeight > dem[offset])
                 {
-                case otb::CellFusionMode::MIN:
-                  {
-                  if (cellHeight < cellCurrentValue)
-                    {
-                    tmpDEM->SetPixel(cellIndex, cellHeight);
-                    }
-                  }
-                  break;
-                case otb::CellFusionMode::MAX:
-                  {
-                  if (cellHeight > cellCurrentValue)
-                    {
-                    tmpDEM->SetPixel(cellIndex, cellHeight);
-                    }
-                  }
-                  break;
-                case otb::CellFusionMode::MEAN:
-                  {
-                  tmpDEM->SetPixel(cellIndex, cellCurrentValue + cellHeight);
-                  }
-                  break;
-                case otb::CellFusionMode::ACC:
-                  {
-                  }
-                  break;
-                default:
-
-                  itkExceptionMacro(<< "Unexpected value cell fusion mode :"<<this->m_CellFusionMode)
-;
-                  break;
+                dem[offset] = cellHeight;
                 }
               }
-
+              break;
+            case otb::CellFusionMode::MEAN:
+              {
+              dem[offset] += cellHeight;
+              }
+              break;
+            default:
+              break;
             }
+          }
+        ++acc[offset];
+        }
+      }
 
-          ++mapIt;
+    // Keep the capacity: the next map will likely fill this bucket again
+    bucket.clear();
+    }
 
-          if (useMask) ++maskIt;
+  if (m_CellFusionMode == otb::CellFusionMode::MEDIAN && isLastMap)
+    {
+    CellHeightListType & heights = m_TileHeights[tileIndex];
 
-          }
+    // Sorting by offset then height groups the heights of each cell in ascending order
+    std::sort(heights.begin(), heights.end());
+
+    typename CellHeightListType::size_type cellEnd = 0;
+    for (typename CellHeightListType::size_type cellBegin = 0; cellBegin < heights.size(); cellBegin = cellEnd)
+      {
+      const itk::OffsetValueType offset = heights[cellBegin].Offset;
+      cellEnd = cellBegin + 1;
+      while (cellEnd < heights.size() && heights[cellEnd].Offset == offset)
+        {
+        ++cellEnd;
+        }
+
+      const typename CellHeightListType::size_type count = cellEnd - cellBegin;
+      const typename CellHeightListType::size_type middle = cellBegin + count / 2;
+      if (count % 2)
+        {
+        dem[offset] = heights[middle].Height;
         }
       else
         {
-        splitRegion = requestedRegion;
-        otbMsgDevMacro( "map " << k << " will not be split " );
+        dem[offset] = static_cast<DEMPixelType>(0.5 * (heights[middle - 1].Height + heights[middle].Height));
         }
+      acc[offset] = static_cast<AccumulatorPixelType>(count);
       }
+
+    CellHeightListType().swap(heights);
     }
 }
 
 template<class T3DImage, class TMaskImage, class TOutputDEMImage>
-void Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::AfterThreadedGenerateData()
+void Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::ThreadedGenerateData(
+  const RegionType & outputRegionForThread,
+  itk::ThreadIdType itkNotUsed(threadId))
 {
-
-  TOutputDEMImage * outputDEM = this->GetOutput();
-
-  //check is that case can occur
-  if (m_TempDEMRegions.size() < 1)
+  // MIN, MAX and MEDIAN cells already hold their final value, and empty cells hold the NoDataValue
+  if (m_CellFusionMode != otb::CellFusionMode::MEAN && m_CellFusionMode != otb::CellFusionMode::ACC)
     {
-    outputDEM->FillBuffer(m_NoDataValue);
     return;
     }
 
-  itk::ImageRegionIterator<OutputImageType> outputDEMIt(outputDEM, outputDEM->GetRequestedRegion());
-  itk::ImageRegionIterator<OutputImageType> firstDEMIt(m_TempDEMRegions[0], outputDEM->GetRequestedRegion());
-  itk::ImageRegionIterator<AccumulatorImageType> firstDEMAccIt(m_TempDEMAccumulatorRegions[0],
-                                                               outputDEM->GetRequestedRegion());
-  //we use the first accumulator as global accumulator over tmpAcc for mean calculus
+  itk::ImageRegionIterator<OutputImageType> outputDEMIt(this->GetDEMOutput(), outputRegionForThread);
+  itk::ImageRegionConstIterator<AccumulatorImageType> accIt(m_Accumulator, outputRegionForThread);
 
-  outputDEMIt.GoToBegin();
-  firstDEMIt.GoToBegin();
-  firstDEMAccIt.GoToBegin();
-  // Copy first DEM
-
-  while (!outputDEMIt.IsAtEnd() && !firstDEMIt.IsAtEnd() && !firstDEMAccIt.IsAtEnd())
+  for (outputDEMIt.GoToBegin(), accIt.GoToBegin(); !outputDEMIt.IsAtEnd(); ++outputDEMIt, ++accIt)
     {
-
-    AccumulatorPixelType accPixel = firstDEMAccIt.Get();
-    //useless test tempDEm is initialized with NoDataValue
+    const AccumulatorPixelType accPixel = accIt.Get();
     if (accPixel == 0)
       {
-      outputDEMIt.Set(m_NoDataValue);
+      continue;
       }
-    else
-      {
-
-      DEMPixelType pixelValue = firstDEMIt.Get();
 
-      outputDEMIt.Set(pixelValue);
-
-      if ((this->m_CellFusionMode == otb::CellFusionMode::MEAN) && (m_TempDEMRegions.size() == 1))
-        {
-        outputDEMIt.Set(firstDEMIt.Get() / static_cast<DEMPixelType> (accPixel));
-        }
-      if (this->m_CellFusionMode == otb::CellFusionMode::ACC)
-        {
-        outputDEMIt.Set(static_cast<DEMPixelType> (accPixel));
-        }
+    if (m_CellFusionMode == otb::CellFusionMode::MEAN)
+      {
+      outputDEMIt.Set(outputDEMIt.Get() / static_cast<DEMPixelType> (accPixel));
       }
-    ++outputDEMIt;
-    ++firstDEMIt;
-    ++firstDEMAccIt;
-    }
-
-  // Check DEMs from other threads and keep the maximum elevation
-  for (unsigned int i = 1; i < m_TempDEMRegions.size(); i++)
-    {
-
-    itk::ImageRegionIterator<OutputImageType> tmpDEMIt(m_TempDEMRegions[i], outputDEM->GetRequestedRegion());
-    itk::ImageRegionIterator<AccumulatorImageType> tmpDEMAccIt(m_TempDEMAccumulatorRegions[i],
-                                                               outputDEM->GetRequestedRegion());
-
-    outputDEMIt.GoToBegin();
-    tmpDEMIt.GoToBegin();
-    tmpDEMAccIt.GoToBegin();
-    firstDEMAccIt.GoToBegin(); //Global Accumulator
-    while (!outputDEMIt.IsAtEnd() && !tmpDEMIt.IsAtEnd() && !tmpDEMAccIt.IsAtEnd() && !firstDEMAccIt.IsAtEnd())
+    else
       {
-
-      // get the accumulator value
-      AccumulatorPixelType accPixel = tmpDEMAccIt.Get();
-      if (accPixel != 0)
-        {
-
-        DEMPixelType cellCurrentValue = outputDEMIt.Get();
-        DEMPixelType cellHeight = tmpDEMIt.Get();
-        switch (this->m_CellFusionMode)
-          {
-          case otb::CellFusionMode::MIN:
-            {
-            if ((cellHeight < cellCurrentValue) || (cellCurrentValue == m_NoDataValue))
-              {
-              outputDEMIt.Set(cellHeight);
-              }
-            }
-            break;
-          case otb::CellFusionMode::MAX:
-            {
-            if ((cellHeight > cellCurrentValue) || ((cellCurrentValue == m_NoDataValue)))
-              {
-              outputDEMIt.Set(cellHeight);
-              }
-            }
-            break;
-          case otb::CellFusionMode::MEAN:
-            {
-
-            outputDEMIt.Set(
-                            cellCurrentValue * static_cast<DEMPixelType> (cellCurrentValue != m_NoDataValue)
-                                + cellHeight);
-            firstDEMAccIt.Set(firstDEMAccIt.Get() + accPixel);
-
-            }
-            break;
-          case otb::CellFusionMode::ACC:
-            {
-            firstDEMAccIt.Set(firstDEMAccIt.Get() + accPixel);
-            }
-            break;
-
-          default:
-            itkExceptionMacro(<< "Unexpected value cell fusion mode :"<<this->m_CellFusionMode);
-            break;
-          }
-        }
-
-      if (i == (m_TempDEMRegions.size() - 1))
-        {
-        if (this->m_CellFusionMode == otb::CellFusionMode::MEAN)
-          {
-          if (static_cast<DEMPixelType> (firstDEMAccIt.Get()) != 0)
-            {
-            outputDEMIt.Set(outputDEMIt.Get() / static_cast<DEMPixelType> (firstDEMAccIt.Get()));
-            }
-          else
-            {
-            outputDEMIt.Set(m_NoDataValue);
-            }
-          }
-        else
-          if (this->m_CellFusionMode == otb::CellFusionMode::ACC)
-            {
-            outputDEMIt.Set(static_cast<DEMPixelType> (firstDEMAccIt.Get()));
-            }
-
-        }
-      ++outputDEMIt;
-      ++tmpDEMIt;
-      ++tmpDEMAccIt;
-      ++firstDEMAccIt;
+      outputDEMIt.Set(static_cast<DEMPixelType> (accPixel));
       }
-
     }
+}
 
+template<class T3DImage, class TMaskImage, class TOutputDEMImage>
+void Multi3DMapToDEMFilter<T3DImage, TMaskImage, TOutputDEMImage>::AfterThreadedGenerateData()
+{
+  // Release the fusion buffers
+  m_Buckets.clear();
+  m_TileHeights.clear();
+  m_RowTiles.clear();
+  m_Accumulator = ITK_NULLPTR;
+  m_MapSplitterList->Clear();
 }
 
 }
@@ -24,8 +24,7 @@
 #include "otbImage.h"
 #include "otbVectorImage.h"
 #include "itkImageToImageFilter.h"
-
-#include <set>
+#include "otbRegionAdjacencyGraph.h"
 
 namespace otb
 {
@@ -36,6 +35,9 @@ namespace otb
  * This class merges regions in the input label image according to the input
  * image of spectral values and the RangeBandwidth parameter.
  *
+ * The region adjacency graph is built once from the label image, then
+ * contracted after each merging iteration.
+ *
  *
  * \ingroup ImageSegmentation
  *
@@ -86,10 +88,9 @@ public:
 
   itkStaticConstMacro(ImageDimension, unsigned int, InputLabelImageType::ImageDimension);
 
-  /** Typedefs for region adjacency map */
+  /** Typedefs for region adjacency graph */
   typedef InputLabelType      LabelType;
-  typedef std::set<LabelType> AdjacentLabelsContainerType;
-  typedef std::vector<AdjacentLabelsContainerType> RegionAdjacencyMapType;
+  typedef RegionAdjacencyGraph<LabelType> RegionAdjacencyGraphType;
 
 
   /** Setters / Getters */
@@ -130,8 +131,8 @@ protected:
   /** PrintSelf method */
   void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
 
-  /** Method to build a map of adjacent regions */
-  RegionAdjacencyMapType LabelImageToRegionAdjacencyMap(typename OutputLabelImageType::Pointer inputLabelImage);
+  /** Method to build the graph of adjacent regions */
+  typename RegionAdjacencyGraphType::Pointer LabelImageToRegionAdjacencyGraph(typename OutputLabelImageType::Pointer inputLabelImage);
 
 private:
   LabelImageRegionMergingFilter(const Self &);     //purposely not implemented
@@ -25,8 +25,7 @@
 #include "otbVectorImage.h"
 #include "itkImageToImageFilter.h"
 #include "itkNumericTraits.h"
-
-#include <set>
+#include "otbRegionAdjacencyGraph.h"
 
 namespace otb
 {
@@ -87,10 +86,9 @@ public:
 
   itkStaticConstMacro(ImageDimension, unsigned int, InputLabelImageType::ImageDimension);
 
-  /** Typedefs for region adjacency map */
+  /** Typedefs for region adjacency graph */
   typedef InputLabelType      LabelType;
-  typedef std::set<LabelType> AdjacentLabelsContainerType;
-  typedef std::vector<AdjacentLabelsContainerType> RegionAdjacencyMapType;
+  typedef RegionAdjacencyGraph<LabelType> RegionAdjacencyGraphType;
 
   itkSetMacro(MinRegionSize, RealType);
   itkGetConstMacro(MinRegionSize, RealType);
@@ -129,8 +127,8 @@ protected:
   /** PrintSelf method */
   void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
 
-  /** Method to build a map of adjacent regions */
-  RegionAdjacencyMapType LabelImageToRegionAdjacencyMap(typename OutputLabelImageType::Pointer inputLabelImage);
+  /** Method to build the graph of adjacent regions */
+  typename RegionAdjacencyGraphType::Pointer LabelImageToRegionAdjacencyGraph(typename OutputLabelImageType::Pointer inputLabelImage);
 
 private:
   LabelImageRegionPruningFilter(const Self &);     //purposely not implemented
@@ -197,8 +197,9 @@ LabelImageRegionPruningFilter<TInputLabelImage, TInputSpectralImage, TOutputLabe
     ++outputIt;
     }
 
-  RegionAdjacencyMapType regionAdjacencyMap = LabelImageToRegionAdjacencyMap(outputLabelImage);
-  unsigned int regionCount = regionAdjacencyMap.size() - 1;
+  typename RegionAdjacencyGraphType::Pointer regionAdjacencyGraph = LabelImageToRegionAdjacencyGraph(outputLabelImage);
+  const typename RegionAdjacencyGraphType::RegionIdType nbRegions = regionAdjacencyGraph->GetNumberOfRegions();
+  unsigned int regionCount = nbRegions > 0 ? regionAdjacencyGraph->GetLabel(nbRegions - 1) : 0;
 
   // Initialize arrays for mode information
   m_CanonicalLabels.clear();
@@ -265,14 +266,16 @@ LabelImageRegionPruningFilter<TInputLabelImage, TInputSpectralImage, TOutputLabe
       const SpectralPixelType & curSpectral = m_Modes[curLabel];
 
       // Iterate over all adjacent regions and check for merge
-      typename AdjacentLabelsContainerType::const_iterator adjIt = regionAdjacencyMap[curLabel].begin();
+      const typename RegionAdjacencyGraphType::RegionIdType curId = regionAdjacencyGraph->GetRegionId(curLabel);
+      const unsigned int nbNeighbours = curId < regionAdjacencyGraph->GetNumberOfRegions() ?
+        regionAdjacencyGraph->GetNumberOfNeighbours(curId) : 0;
 
       LabelType neighborCandidate=0;
       RealType bestNorm2=itk::NumericTraits< float >::max();
 
-      while (adjIt != regionAdjacencyMap[curLabel].end())
+      for (unsigned int k = 0; k < nbNeighbours; ++k)
         {
-        LabelType adjLabel = *adjIt;
+        LabelType adjLabel = regionAdjacencyGraph->GetLabel(regionAdjacencyGraph->GetNeighbour(curId, k));
         assert(adjLabel <= regionCount);
         const SpectralPixelType & adjSpectral = m_Modes[adjLabel];
         // Check condition to merge regions
@@ -292,7 +295,6 @@ LabelImageRegionPruningFilter<TInputLabelImage, TInputSpectralImage, TOutputLabe
            bestNorm2=norm2;
            neighborCandidate=adjLabel;
           };
-         ++adjIt;
         } // end of loop over adjacent labels
 
         if(neighborCandidate!=0)
@@ -418,8 +420,20 @@ LabelImageRegionPruningFilter<TInputLabelImage, TInputSpectralImage, TOutputLabe
 
     if(!finishedPruning)
       {
-      /* Update adjacency table */
-      regionAdjacencyMap = LabelImageToRegionAdjacencyMap(outputLabelImage);
+      /* Update adjacency graph: merged regions take their new label */
+      typename RegionAdjacencyGraphType::RegionIdVectorType groups(regionAdjacencyGraph->GetNumberOfRegions());
+      for(typename RegionAdjacencyGraphType::RegionIdType id = 0; id < groups.size(); ++id)
+        {
+        groups[id] = newLabels[m_CanonicalLabels[regionAdjacencyGraph->GetLabel(id)]];
+        }
+      typename RegionAdjacencyGraphType::LabelVectorType groupLabels(regionCount+1);
+      for(unsigned int i = 0; i < regionCount+1; ++i)
+        {
+        groupLabels[i] = i;
+        }
+      typename RegionAdjacencyGraphType::Pointer contractedGraph = RegionAdjacencyGraphType::New();
+      regionAdjacencyGraph->Contract(groups, groupLabels, contractedGraph);
+      regionAdjacencyGraph = contractedGraph;
       }
 
     pruneIterations++;
@@ -454,27 +468,21 @@ LabelImageRegionPruningFilter<TInputLabelImage, TInputSpectralImage, TOutputLabe
 
 
 template <class TInputLabelImage, class TInputSpectralImage, class TOutputLabelImage, class TOutputClusteredImage>
-typename LabelImageRegionPruningFilter<TInputLabelImage, TInputSpectralImage, TOutputLabelImage, TOutputClusteredImage>::RegionAdjacencyMapType
+typename LabelImageRegionPruningFilter<TInputLabelImage, TInputSpectralImage, TOutputLabelImage, TOutputClusteredImage>::RegionAdjacencyGraphType::Pointer
 LabelImageRegionPruningFilter<TInputLabelImage, TInputSpectralImage, TOutputLabelImage, TOutputClusteredImage>
-::LabelImageToRegionAdjacencyMap(typename OutputLabelImageType::Pointer  labelImage)
+::LabelImageToRegionAdjacencyGraph(typename OutputLabelImageType::Pointer  labelImage)
 {
-  // declare the output map
-  RegionAdjacencyMapType ram;
+  typename RegionAdjacencyGraphType::Accumulator accumulator;
 
-  // Find the maximum label value
-  itk::ImageRegionConstIterator<OutputLabelImageType> it(labelImage, labelImage->GetRequestedRegion());
+  // Every label of the image is a region of the graph
+  itk::ImageRegionConstIteratorWithIndex<OutputLabelImageType> it(labelImage, labelImage->GetRequestedRegion());
   it.GoToBegin();
-  LabelType maxLabel = 0;
   while(!it.IsAtEnd())
     {
-    LabelType label = it.Get();
-    maxLabel = vcl_max(maxLabel, label);
+    accumulator.AddPixel(it.Get(), it.GetIndex()[0], it.GetIndex()[1], ITK_NULLPTR);
     ++it;
     }
 
-  // Set the size of the adjacency map
-  ram.resize(maxLabel+1);
-
   // set the image region without bottom and right borders so that bottom and
   // right neighbors always exist
   RegionType regionWithoutBottomRightBorders  = labelImage->GetRequestedRegion();
@@ -500,14 +508,15 @@ LabelImageRegionPruningFilter<TInputLabelImage, TInputSpectralImage, TOutputLabe
       // add adjacency if different labels
       if(neighborLabel != label)
         {
-        ram[label].insert(neighborLabel);
-        ram[neighborLabel].insert(label);
+        accumulator.AddBorder(label, neighborLabel);
         }
       }
     ++inputIt;
     }
 
-  return ram;
+  typename RegionAdjacencyGraphType::Pointer rag = RegionAdjacencyGraphType::New();
+  rag->Build(accumulator);
+  return rag;
 }
 
 } // end namespace otb
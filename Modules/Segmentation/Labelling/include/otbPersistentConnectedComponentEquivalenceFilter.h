@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbPersistentConnectedComponentEquivalenceFilter_h
+#define otbPersistentConnectedComponentEquivalenceFilter_h
+
+#include "otbPersistentImageFilter.h"
+#include "otbTileConnectedComponentLabeller.h"
+#include "itkMultiThreader.h"
+#include <map>
+
+namespace otb
+{
+
+/** \class PersistentConnectedComponentEquivalenceFilter
+ * \brief First pass of the streaming tile based labelling.
+ *
+ * The largest possible region of the input image is cut into a fixed grid
+ * of square tiles of TileSize pixels. Each tile is labelled independently
+ * by a copy of the tile labeller returned by GetLabeller() (by default a
+ * TileConnectedComponentLabeller). Tiles of a stream are labelled in
+ * parallel, then only the labels and border information of the tile sides
+ * are kept: as soon as two adjacent tiles have been processed, the
+ * components touching their common edge (or corner, with 8-connectivity)
+ * are merged in a global union-find structure, and the border data is
+ * released once all the neighbours of a tile are done. Memory usage
+ * therefore depends on the number of components touching tile borders,
+ * not on the image size.
+ *
+ * A tile is processed during the stream containing its first pixel, so the
+ * result does not depend on the streaming layout. Synthetize() resolves the
+ * equivalences and assigns consecutive global labels: components crossing
+ * tile borders first, then the components inside each tile, in tile order.
+ * GetGlobalLabel() then maps a (tile, local label) pair to its global label.
+ *
+ * Subclasses can gather more information on the tiles through
+ * TileLabelled() and AddBorderAdjacency(), and merge the resulting labels
+ * further with SetMergedLabels().
+ *
+ * This filter is only intended for 2D scalar images.
+ *
+ * \sa StreamingConnectedComponentImageFilter
+ * \sa TileConnectedComponentLabeller
+ *
+ * \ingroup Streamed
+ * \ingroup Multithreaded
+ *
+ * \ingroup OTBLabelling
+ */
+template <class TInputImage, class TTileLabeller = TileConnectedComponentLabeller<TInputImage> >
+class ITK_EXPORT PersistentConnectedComponentEquivalenceFilter :
+  public PersistentImageFilter<TInputImage, TInputImage>
+{
+public:
+  /** Standard Self typedef */
+  typedef PersistentConnectedComponentEquivalenceFilter   Self;
+  typedef PersistentImageFilter<TInputImage, TInputImage> Superclass;
+  typedef itk::SmartPointer<Self>                         Pointer;
+  typedef itk::SmartPointer<const Self>                   ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(PersistentConnectedComponentEquivalenceFilter, PersistentImageFilter);
+
+  /** Image related typedefs. */
+  typedef TInputImage                          ImageType;
+  typedef typename ImageType::PixelType        PixelType;
+  typedef typename ImageType::RegionType       RegionType;
+  typedef typename ImageType::IndexType        IndexType;
+  typedef typename ImageType::SizeType         SizeType;
+
+  typedef TTileLabeller                                 LabellerType;
+  typedef typename LabellerType::LocalLabelType         LocalLabelType;
+  typedef typename LabellerType::BorderPixelType        BorderPixelType;
+  typedef std::vector<BorderPixelType>                  BorderPixelVectorType;
+  typedef std::vector<LocalLabelType>                   LocalLabelVectorType;
+
+  typedef itk::IdentifierType                           LabelType;
+  typedef std::vector<LabelType>                        LabelVectorType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TInputImage::ImageDimension);
+
+  /** Set/Get the tile size (in pixels) of the labelling grid */
+  itkSetMacro(TileSize, unsigned int);
+  itkGetConstMacro(TileSize, unsigned int);
+
+  /** Get the tile labeller. Its parameters are used by all the copies
+   * labelling the tiles. */
+  LabellerType * GetLabeller()
+  {
+    return &m_Labeller;
+  }
+  const LabellerType * GetLabeller() const
+  {
+    return &m_Labeller;
+  }
+
+  /** Number of components found in the whole image (valid after Synthetize()) */
+  itkGetConstMacro(NumberOfObjects, LabelType);
+
+  /** Number of tiles in each direction of the labelling grid */
+  unsigned int GetNumberOfTilesX() const
+  {
+    return m_NumberOfTiles[0];
+  }
+  unsigned int GetNumberOfTilesY() const
+  {
+    return m_NumberOfTiles[1];
+  }
+
+  /** Region of a tile of the labelling grid */
+  RegionType GetTileRegion(unsigned int tx, unsigned int ty) const;
+
+  /** Index range [start, end[ of the tiles intersecting a region */
+  void GetTileRange(const RegionType & region, IndexType & start, IndexType & end) const;
+
+  /** Region needed to label the tiles in the index range [start, end[ */
+  RegionType GetTileRangeInputRegion(const IndexType & start, const IndexType & end) const;
+
+  /** Label of a local label of a tile after the resolution of border
+   * equivalences (valid after Synthetize()) */
+  LabelType GetBaseLabel(unsigned int tileId, LocalLabelType label) const
+  {
+    if (label == 0)
+      {
+      return 0;
+      }
+    if (label <= m_NumberOfBorderLabels[tileId])
+      {
+      return m_BorderLabels[m_BorderOffset[tileId] + label - 1];
+      }
+    return m_InteriorOffset[tileId] + (label - m_NumberOfBorderLabels[tileId]);
+  }
+
+  /** Global label of a local label of a tile (valid after Synthetize()) */
+  LabelType GetGlobalLabel(unsigned int tileId, LocalLabelType label) const
+  {
+    const LabelType base = this->GetBaseLabel(tileId, label);
+    return m_MergedLabels.empty() ? base : m_MergedLabels[base];
+  }
+
+  void AllocateOutputs() ITK_OVERRIDE;
+
+  void GenerateOutputInformation() ITK_OVERRIDE;
+
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  void Synthetize(void) ITK_OVERRIDE;
+
+  void Reset(void) ITK_OVERRIDE;
+
+protected:
+  PersistentConnectedComponentEquivalenceFilter();
+  ~PersistentConnectedComponentEquivalenceFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+  void GenerateData() ITK_OVERRIDE;
+
+  /** Called, possibly from several threads at once, each time a tile has
+   * been labelled. Does nothing by default. */
+  virtual void TileLabelled(unsigned int itkNotUsed(tileId), const LabellerType & itkNotUsed(labeller)) {}
+
+  /** Called for each pair of neighbouring labelled pixels of two adjacent
+   * tiles which are not connected, (dx, dy) being the offset from a to b.
+   * Does nothing by default. */
+  virtual void AddBorderAdjacency(unsigned int itkNotUsed(tileA), LocalLabelType itkNotUsed(labelA),
+                                  const BorderPixelType & itkNotUsed(a),
+                                  unsigned int itkNotUsed(tileB), LocalLabelType itkNotUsed(labelB),
+                                  const BorderPixelType & itkNotUsed(b),
+                                  int itkNotUsed(dx), int itkNotUsed(dy)) {}
+
+  /** Set a lookup table from the base labels to the final labels. Its
+   * content is swapped with the given vector. */
+  void SetMergedLabels(LabelVectorType & labels, LabelType numberOfObjects)
+  {
+    m_MergedLabels.swap(labels);
+    m_NumberOfObjects = numberOfObjects;
+  }
+
+private:
+  PersistentConnectedComponentEquivalenceFilter(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+
+  enum BorderSide
+  {
+    TOP = 0,
+    BOTTOM = 1,
+    LEFT = 2,
+    RIGHT = 3
+  };
+
+  /** Labels and border information along the four sides of a tile */
+  struct TileBorder
+  {
+    BorderPixelVectorType pixels[4];
+    LocalLabelVectorType  labels[4];
+  };
+
+  /** Result of the labelling of a tile */
+  struct TileJob
+  {
+    unsigned int   tx;
+    unsigned int   ty;
+    LocalLabelType numberOfBorderLabels;
+    LocalLabelType numberOfLabels;
+    TileBorder     border;
+  };
+
+  struct TileThreadStruct
+  {
+    Self *                 Filter;
+    const ImageType *      Input;
+    std::vector<TileJob> * Jobs;
+  };
+
+  typedef std::map<unsigned int, TileBorder> TileBorderMapType;
+
+  /** Labels the tiles of a stream, in parallel */
+  static ITK_THREAD_RETURN_TYPE TileThreaderCallback(void * arg);
+
+  /** Allocate the bookkeeping of the tiles of the current grid */
+  void AllocateTiles();
+
+  /** Owned tiles index range [start, end[ of a stream region */
+  void GetOwnedTileRange(const RegionType & region, IndexType & start, IndexType & end) const;
+
+  /** Label a tile and keep its borders */
+  void LabelTile(LabellerType & labeller, const ImageType * input, TileJob & job);
+
+  /** Record a labelled tile and merge it with its processed neighbours */
+  void RecordTile(TileJob & job);
+
+  /** Merge the components along a side of tile a with the opposite side of tile b */
+  void MergeSides(unsigned int a, BorderSide sideA, unsigned int b, BorderSide sideB);
+
+  /** Merge the components of two diagonal corner pixels, taken at the
+   * first or last position of a side */
+  void MergeCorners(unsigned int a, BorderSide sideA, bool lastA,
+                    unsigned int b, BorderSide sideB, bool lastB);
+
+  /** Merge two border pixels of neighbouring tiles if they are connected,
+   * (dx, dy) being the offset from a to b */
+  void MergePixels(unsigned int a, LocalLabelType labelA, const BorderPixelType & pixelA,
+                   unsigned int b, LocalLabelType labelB, const BorderPixelType & pixelB,
+                   int dx, int dy);
+
+  /** Release the border of a tile if all its neighbours are processed */
+  void ReleaseBorderIfDone(unsigned int tx, unsigned int ty);
+
+  LabelType FindRoot(LabelType id);
+  void Union(LabelType a, LabelType b);
+
+  unsigned int   m_TileSize;
+  LabellerType   m_Labeller;
+
+  RegionType     m_LargestRegion;
+  unsigned int   m_NumberOfTiles[2];
+
+  std::vector<bool>               m_TileProcessed;
+  std::vector<LocalLabelType>     m_NumberOfBorderLabels;
+  std::vector<LocalLabelType>     m_NumberOfLabels;
+  LabelVectorType                 m_BorderOffset;
+  LabelVectorType                 m_InteriorOffset;
+  TileBorderMapType               m_TileBorders;
+
+  /** Union-find parents of the border components, then their global labels */
+  LabelVectorType                 m_BorderParent;
+  LabelVectorType                 m_BorderLabels;
+
+  /** Optional lookup table set by subclasses */
+  LabelVectorType                 m_MergedLabels;
+
+  LabelType                       m_NumberOfObjects;
+}; // end of class PersistentConnectedComponentEquivalenceFilter
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbPersistentConnectedComponentEquivalenceFilter.txx"
+#endif
+
+#endif
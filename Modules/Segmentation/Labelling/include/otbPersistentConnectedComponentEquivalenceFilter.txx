@@ -0,0 +1,584 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbPersistentConnectedComponentEquivalenceFilter_txx
+#define otbPersistentConnectedComponentEquivalenceFilter_txx
+
+#include "otbPersistentConnectedComponentEquivalenceFilter.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+
+namespace otb
+{
+
+template <class TInputImage, class TTileLabeller>
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::PersistentConnectedComponentEquivalenceFilter()
+  : m_TileSize(256),
+    m_NumberOfObjects(0)
+{
+  m_NumberOfTiles[0] = 0;
+  m_NumberOfTiles[1] = 0;
+}
+
+template <class TInputImage, class TTileLabeller>
+typename PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>::RegionType
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::GetTileRegion(unsigned int tx, unsigned int ty) const
+{
+  const unsigned int tile[2] = {tx, ty};
+  IndexType index;
+  SizeType size;
+  for (unsigned int dim = 0; dim < 2; ++dim)
+    {
+    const unsigned long offset = static_cast<unsigned long>(tile[dim]) * m_TileSize;
+    index[dim] = m_LargestRegion.GetIndex()[dim] + offset;
+    size[dim] = std::min(static_cast<unsigned long>(m_TileSize),
+                         static_cast<unsigned long>(m_LargestRegion.GetSize()[dim] - offset));
+    }
+  RegionType region;
+  region.SetIndex(index);
+  region.SetSize(size);
+  return region;
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::GetTileRange(const RegionType & region, IndexType & start, IndexType & end) const
+{
+  for (unsigned int dim = 0; dim < 2; ++dim)
+    {
+    const long first = std::max(0L, static_cast<long>(region.GetIndex()[dim] - m_LargestRegion.GetIndex()[dim]));
+    const long last = first + static_cast<long>(region.GetSize()[dim]);
+    start[dim] = first / m_TileSize;
+    end[dim] = std::min(static_cast<long>(m_NumberOfTiles[dim]), (last + m_TileSize - 1) / m_TileSize);
+    }
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::GetOwnedTileRange(const RegionType & region, IndexType & start, IndexType & end) const
+{
+  // A tile is owned by the stream containing its first pixel
+  for (unsigned int dim = 0; dim < 2; ++dim)
+    {
+    const long first = std::max(0L, static_cast<long>(region.GetIndex()[dim] - m_LargestRegion.GetIndex()[dim]));
+    const long last = first + static_cast<long>(region.GetSize()[dim]);
+    start[dim] = (first + m_TileSize - 1) / m_TileSize;
+    end[dim] = std::min(static_cast<long>(m_NumberOfTiles[dim]), (last + m_TileSize - 1) / m_TileSize);
+    }
+}
+
+template <class TInputImage, class TTileLabeller>
+typename PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>::RegionType
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::GetTileRangeInputRegion(const IndexType & start, const IndexType & end) const
+{
+  const RegionType first = this->GetTileRegion(start[0], start[1]);
+  const RegionType last = this->GetTileRegion(end[0] - 1, end[1] - 1);
+  SizeType size;
+  for (unsigned int dim = 0; dim < 2; ++dim)
+    {
+    size[dim] = last.GetIndex()[dim] + last.GetSize()[dim] - first.GetIndex()[dim];
+    }
+  RegionType region;
+  region.SetIndex(first.GetIndex());
+  region.SetSize(size);
+
+  // Some labellers need a margin around the tiles
+  region.PadByRadius(m_Labeller.GetRadius());
+  region.Crop(m_LargestRegion);
+  return region;
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::AllocateOutputs()
+{
+  // Nothing that needs to be allocated : the output image of this filter is
+  // not intended to be used.
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  if (m_TileSize == 0)
+    {
+    itkExceptionMacro(<< "TileSize must be strictly positive");
+    }
+
+  if (this->GetInput())
+    {
+    this->GetOutput()->CopyInformation(this->GetInput());
+    this->GetOutput()->SetLargestPossibleRegion(this->GetInput()->GetLargestPossibleRegion());
+
+    if (this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() == 0)
+      {
+      this->GetOutput()->SetRequestedRegion(this->GetOutput()->GetLargestPossibleRegion());
+      }
+
+    m_LargestRegion = this->GetInput()->GetLargestPossibleRegion();
+    for (unsigned int dim = 0; dim < 2; ++dim)
+      {
+      m_NumberOfTiles[dim] = (m_LargestRegion.GetSize()[dim] + m_TileSize - 1) / m_TileSize;
+      }
+
+    // Tile bookkeeping is allocated by Reset() for the current grid, and
+    // again here when the grid changes
+    if (m_TileProcessed.size() != m_NumberOfTiles[0] * m_NumberOfTiles[1])
+      {
+      this->AllocateTiles();
+      }
+    }
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::AllocateTiles()
+{
+  const unsigned int nbTiles = m_NumberOfTiles[0] * m_NumberOfTiles[1];
+  m_TileProcessed.assign(nbTiles, false);
+  m_NumberOfBorderLabels.assign(nbTiles, 0);
+  m_NumberOfLabels.assign(nbTiles, 0);
+  m_BorderOffset.assign(nbTiles, 0);
+  m_InteriorOffset.assign(nbTiles, 0);
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  ImageType * input = const_cast<ImageType *>(this->GetInput());
+  if (!input)
+    {
+    return;
+    }
+
+  const RegionType outputRegion = this->GetOutput()->GetRequestedRegion();
+  IndexType start, end;
+  this->GetOwnedTileRange(outputRegion, start, end);
+
+  RegionType inputRegion;
+  if (start[0] < end[0] && start[1] < end[1])
+    {
+    inputRegion = this->GetTileRangeInputRegion(start, end);
+    }
+  else
+    {
+    // No tile starts in this stream : only request a single pixel
+    SizeType size;
+    size.Fill(1);
+    inputRegion.SetIndex(outputRegion.GetIndex());
+    inputRegion.SetSize(size);
+    }
+  input->SetRequestedRegion(inputRegion);
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::Reset()
+{
+  // GenerateOutputInformation() is not called again when only the
+  // parameters of the labeller changed, so the tiles of the current grid
+  // are allocated here
+  this->AllocateTiles();
+  m_TileBorders.clear();
+  LabelVectorType().swap(m_BorderParent);
+  LabelVectorType().swap(m_BorderLabels);
+  LabelVectorType().swap(m_MergedLabels);
+  m_NumberOfObjects = 0;
+}
+
+template <class TInputImage, class TTileLabeller>
+typename PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>::LabelType
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::FindRoot(LabelType id)
+{
+  while (m_BorderParent[id] != id)
+    {
+    m_BorderParent[id] = m_BorderParent[m_BorderParent[id]];
+    id = m_BorderParent[id];
+    }
+  return id;
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::Union(LabelType a, LabelType b)
+{
+  LabelType ra = FindRoot(a);
+  LabelType rb = FindRoot(b);
+  if (ra < rb)
+    {
+    m_BorderParent[rb] = ra;
+    }
+  else if (rb < ra)
+    {
+    m_BorderParent[ra] = rb;
+    }
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::MergePixels(unsigned int a, LocalLabelType labelA, const BorderPixelType & pixelA,
+              unsigned int b, LocalLabelType labelB, const BorderPixelType & pixelB,
+              int dx, int dy)
+{
+  if (labelA == 0 || labelB == 0)
+    {
+    return;
+    }
+  if (m_Labeller.IsConnected(pixelA, pixelB, dx, dy))
+    {
+    this->Union(m_BorderOffset[a] + labelA - 1, m_BorderOffset[b] + labelB - 1);
+    }
+  else
+    {
+    this->AddBorderAdjacency(a, labelA, pixelA, b, labelB, pixelB, dx, dy);
+    }
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::MergeSides(unsigned int a, BorderSide sideA, unsigned int b, BorderSide sideB)
+{
+  const TileBorder & borderA = m_TileBorders[a];
+  const TileBorder & borderB = m_TileBorders[b];
+  const LocalLabelVectorType & labelsA = borderA.labels[sideA];
+  const LocalLabelVectorType & labelsB = borderB.labels[sideB];
+  const BorderPixelVectorType & pixelsA = borderA.pixels[sideA];
+  const BorderPixelVectorType & pixelsB = borderB.pixels[sideB];
+
+  // Tile b is either on the right of or below tile a
+  const bool horizontal = (sideA == RIGHT);
+  const long length = static_cast<long>(labelsA.size());
+  const long reach = m_Labeller.GetFullyConnected() ? 1 : 0;
+  for (long i = 0; i < length; ++i)
+    {
+    for (long j = std::max(0L, i - reach); j <= std::min(length - 1, i + reach); ++j)
+      {
+      const int dx = horizontal ? 1 : static_cast<int>(j - i);
+      const int dy = horizontal ? static_cast<int>(j - i) : 1;
+      this->MergePixels(a, labelsA[i], pixelsA[i], b, labelsB[j], pixelsB[j], dx, dy);
+      }
+    }
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::MergeCorners(unsigned int a, BorderSide sideA, bool lastA,
+               unsigned int b, BorderSide sideB, bool lastB)
+{
+  // Tile b is always below tile a, on its left or on its right
+  const TileBorder & borderA = m_TileBorders[a];
+  const TileBorder & borderB = m_TileBorders[b];
+  const unsigned int posA = lastA ? borderA.labels[sideA].size() - 1 : 0;
+  const unsigned int posB = lastB ? borderB.labels[sideB].size() - 1 : 0;
+
+  this->MergePixels(a, borderA.labels[sideA][posA], borderA.pixels[sideA][posA],
+                    b, borderB.labels[sideB][posB], borderB.pixels[sideB][posB],
+                    lastA ? 1 : -1, 1);
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::ReleaseBorderIfDone(unsigned int tx, unsigned int ty)
+{
+  const unsigned int tileId = ty * m_NumberOfTiles[0] + tx;
+  if (!m_TileProcessed[tileId])
+    {
+    return;
+    }
+  const unsigned int xStart = tx > 0 ? tx - 1 : 0;
+  const unsigned int yStart = ty > 0 ? ty - 1 : 0;
+  const unsigned int xEnd = std::min(tx + 2, m_NumberOfTiles[0]);
+  const unsigned int yEnd = std::min(ty + 2, m_NumberOfTiles[1]);
+  for (unsigned int y = yStart; y < yEnd; ++y)
+    {
+    for (unsigned int x = xStart; x < xEnd; ++x)
+      {
+      if (!m_TileProcessed[y * m_NumberOfTiles[0] + x])
+        {
+        return;
+        }
+      }
+    }
+  m_TileBorders.erase(tileId);
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::LabelTile(LabellerType & labeller, const ImageType * input, TileJob & job)
+{
+  labeller.Label(input, this->GetTileRegion(job.tx, job.ty));
+
+  const unsigned int width = labeller.GetRegion().GetSize()[0];
+  const unsigned int height = labeller.GetRegion().GetSize()[1];
+  job.numberOfBorderLabels = labeller.GetNumberOfBorderLabels();
+  job.numberOfLabels = labeller.GetNumberOfLabels();
+
+  // Keep the four sides of the tile
+  TileBorder & border = job.border;
+  for (unsigned int side = 0; side < 4; ++side)
+    {
+    const unsigned int length = side < 2 ? width : height;
+    border.pixels[side].resize(length);
+    border.labels[side].resize(length);
+    }
+  for (unsigned int x = 0; x < width; ++x)
+    {
+    border.pixels[TOP][x] = labeller.GetBorderPixel(x, 0);
+    border.labels[TOP][x] = labeller.GetLabel(x, 0);
+    border.pixels[BOTTOM][x] = labeller.GetBorderPixel(x, height - 1);
+    border.labels[BOTTOM][x] = labeller.GetLabel(x, height - 1);
+    }
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    border.pixels[LEFT][y] = labeller.GetBorderPixel(0, y);
+    border.labels[LEFT][y] = labeller.GetLabel(0, y);
+    border.pixels[RIGHT][y] = labeller.GetBorderPixel(width - 1, y);
+    border.labels[RIGHT][y] = labeller.GetLabel(width - 1, y);
+    }
+
+  this->TileLabelled(job.ty * m_NumberOfTiles[0] + job.tx, labeller);
+}
+
+template <class TInputImage, class TTileLabeller>
+ITK_THREAD_RETURN_TYPE
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::TileThreaderCallback(void * arg)
+{
+  itk::MultiThreader::ThreadInfoStruct * info = static_cast<itk::MultiThreader::ThreadInfoStruct *>(arg);
+  TileThreadStruct * str = static_cast<TileThreadStruct *>(info->UserData);
+  const unsigned int threadId = info->ThreadID;
+  const unsigned int nbThreads = info->NumberOfThreads;
+
+  // Each thread works on its own copy of the labeller
+  LabellerType labeller(str->Filter->m_Labeller);
+  std::vector<TileJob> & jobs = *(str->Jobs);
+  for (unsigned int i = threadId; i < jobs.size(); i += nbThreads)
+    {
+    str->Filter->LabelTile(labeller, str->Input, jobs[i]);
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::RecordTile(TileJob & job)
+{
+  const unsigned int tx = job.tx;
+  const unsigned int ty = job.ty;
+  const unsigned int nx = m_NumberOfTiles[0];
+  const unsigned int ny = m_NumberOfTiles[1];
+  const unsigned int tileId = ty * nx + tx;
+
+  m_NumberOfBorderLabels[tileId] = job.numberOfBorderLabels;
+  m_NumberOfLabels[tileId] = job.numberOfLabels;
+  m_BorderOffset[tileId] = m_BorderParent.size();
+  for (LabelType i = 0; i < job.numberOfBorderLabels; ++i)
+    {
+    m_BorderParent.push_back(m_BorderOffset[tileId] + i);
+    }
+
+  TileBorder & border = m_TileBorders[tileId];
+  for (unsigned int side = 0; side < 4; ++side)
+    {
+    border.pixels[side].swap(job.border.pixels[side]);
+    border.labels[side].swap(job.border.labels[side]);
+    }
+  m_TileProcessed[tileId] = true;
+
+  // Merge with the neighbours already processed
+  if (tx > 0 && m_TileProcessed[tileId - 1])
+    {
+    this->MergeSides(tileId - 1, RIGHT, tileId, LEFT);
+    }
+  if (tx + 1 < nx && m_TileProcessed[tileId + 1])
+    {
+    this->MergeSides(tileId, RIGHT, tileId + 1, LEFT);
+    }
+  if (ty > 0 && m_TileProcessed[tileId - nx])
+    {
+    this->MergeSides(tileId - nx, BOTTOM, tileId, TOP);
+    }
+  if (ty + 1 < ny && m_TileProcessed[tileId + nx])
+    {
+    this->MergeSides(tileId, BOTTOM, tileId + nx, TOP);
+    }
+
+  if (m_Labeller.GetFullyConnected())
+    {
+    if (tx > 0 && ty > 0 && m_TileProcessed[tileId - nx - 1])
+      {
+      this->MergeCorners(tileId - nx - 1, BOTTOM, true, tileId, TOP, false);
+      }
+    if (tx + 1 < nx && ty > 0 && m_TileProcessed[tileId - nx + 1])
+      {
+      this->MergeCorners(tileId - nx + 1, BOTTOM, false, tileId, TOP, true);
+      }
+    if (tx > 0 && ty + 1 < ny && m_TileProcessed[tileId + nx - 1])
+      {
+      this->MergeCorners(tileId, BOTTOM, false, tileId + nx - 1, TOP, true);
+      }
+    if (tx + 1 < nx && ty + 1 < ny && m_TileProcessed[tileId + nx + 1])
+      {
+      this->MergeCorners(tileId, BOTTOM, true, tileId + nx + 1, TOP, false);
+      }
+    }
+
+  // Release the borders which are no longer needed
+  const unsigned int xStart = tx > 0 ? tx - 1 : 0;
+  const unsigned int yStart = ty > 0 ? ty - 1 : 0;
+  const unsigned int xEnd = std::min(tx + 2, nx);
+  const unsigned int yEnd = std::min(ty + 2, ny);
+  for (unsigned int y = yStart; y < yEnd; ++y)
+    {
+    for (unsigned int x = xStart; x < xEnd; ++x)
+      {
+      this->ReleaseBorderIfDone(x, y);
+      }
+    }
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::GenerateData()
+{
+  IndexType start, end;
+  this->GetOwnedTileRange(this->GetOutput()->GetRequestedRegion(), start, end);
+
+  std::vector<TileJob> jobs;
+  for (long ty = start[1]; ty < end[1]; ++ty)
+    {
+    for (long tx = start[0]; tx < end[0]; ++tx)
+      {
+      if (!m_TileProcessed[ty * m_NumberOfTiles[0] + tx])
+        {
+        TileJob job;
+        job.tx = tx;
+        job.ty = ty;
+        jobs.push_back(job);
+        }
+      }
+    }
+  if (jobs.empty())
+    {
+    return;
+    }
+
+  // Label the tiles in parallel
+  TileThreadStruct str;
+  str.Filter = this;
+  str.Input = this->GetInput();
+  str.Jobs = &jobs;
+
+  const unsigned int nbThreads = std::min(static_cast<unsigned int>(this->GetNumberOfThreads()),
+                                          static_cast<unsigned int>(jobs.size()));
+  this->GetMultiThreader()->SetNumberOfThreads(nbThreads);
+  this->GetMultiThreader()->SetSingleMethod(this->TileThreaderCallback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  // Then merge them, in tile order
+  itk::ProgressReporter progress(this, 0, jobs.size());
+  for (unsigned int i = 0; i < jobs.size(); ++i)
+    {
+    this->RecordTile(jobs[i]);
+    progress.CompletedPixel();
+    }
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::Synthetize()
+{
+  const unsigned int nbTiles = m_TileProcessed.size();
+  for (unsigned int tileId = 0; tileId < nbTiles; ++tileId)
+    {
+    if (!m_TileProcessed[tileId])
+      {
+      itkExceptionMacro(<< "Tile " << tileId << " has not been processed, the whole image must be streamed");
+      }
+    }
+
+  // Consecutive labels for the components crossing tile borders, numbered
+  // in tile order so that they do not depend on the streaming layout
+  m_BorderLabels.assign(m_BorderParent.size(), 0);
+  LabelType nextLabel = 0;
+  for (unsigned int tileId = 0; tileId < nbTiles; ++tileId)
+    {
+    for (LabelType id = m_BorderOffset[tileId];
+         id < m_BorderOffset[tileId] + m_NumberOfBorderLabels[tileId]; ++id)
+      {
+      const LabelType root = this->FindRoot(id);
+      if (m_BorderLabels[root] == 0)
+        {
+        m_BorderLabels[root] = ++nextLabel;
+        }
+      m_BorderLabels[id] = m_BorderLabels[root];
+      }
+    }
+  LabelVectorType().swap(m_BorderParent);
+  m_TileBorders.clear();
+
+  // Then the components inside each tile
+  for (unsigned int tileId = 0; tileId < nbTiles; ++tileId)
+    {
+    m_InteriorOffset[tileId] = nextLabel;
+    nextLabel += m_NumberOfLabels[tileId] - m_NumberOfBorderLabels[tileId];
+    }
+  m_NumberOfObjects = nextLabel;
+}
+
+template <class TInputImage, class TTileLabeller>
+void
+PersistentConnectedComponentEquivalenceFilter<TInputImage, TTileLabeller>
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "TileSize: " << m_TileSize << std::endl;
+  os << indent << "NumberOfObjects: " << m_NumberOfObjects << std::endl;
+}
+
+} // end namespace otb
+
+#endif
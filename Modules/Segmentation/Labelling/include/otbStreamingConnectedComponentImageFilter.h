@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbStreamingConnectedComponentImageFilter_h
+#define otbStreamingConnectedComponentImageFilter_h
+
+#include "otbTiledLabellingImageFilterBase.h"
+#include "otbPersistentConnectedComponentEquivalenceFilter.h"
+
+namespace otb
+{
+
+/** \class StreamingConnectedComponentImageFilter
+ * \brief Out-of-core connected component labelling of binary or label images.
+ *
+ * Unlike itk::ConnectedComponentImageFilter, this filter never needs the
+ * whole input in memory and its output can be streamed. Tiles are labelled
+ * by a TileConnectedComponentLabeller, and the components crossing tile
+ * borders are merged by a PersistentConnectedComponentEquivalenceFilter
+ * (see TiledLabellingImageFilterBase for the two passes).
+ *
+ * The result is exact across tile borders. Labels are consecutive, starting
+ * at 1, with 0 for the background. Their order differs from the one of
+ * itk::ConnectedComponentImageFilter : components crossing tile borders get
+ * the first labels.
+ *
+ * By default, every non-background pixel is connected to its non-background
+ * neighbours. With ConnectEqualValuesOnly, neighbours are only connected if
+ * they have the same value, which splits each class of a label image into
+ * its connected regions.
+ *
+ * This filter is only intended for 2D scalar images.
+ *
+ * \sa TiledLabellingImageFilterBase
+ * \sa TileConnectedComponentLabeller
+ *
+ * \ingroup Streamed
+ * \ingroup Multithreaded
+ *
+ * \ingroup OTBLabelling
+ */
+template <class TInputImage, class TOutputImage>
+class ITK_EXPORT StreamingConnectedComponentImageFilter :
+  public TiledLabellingImageFilterBase<TInputImage, TOutputImage,
+                                       PersistentConnectedComponentEquivalenceFilter<TInputImage> >
+{
+public:
+  /** Standard class typedefs. */
+  typedef StreamingConnectedComponentImageFilter Self;
+  typedef TiledLabellingImageFilterBase<TInputImage, TOutputImage,
+    PersistentConnectedComponentEquivalenceFilter<TInputImage> > Superclass;
+  typedef itk::SmartPointer<Self>                            Pointer;
+  typedef itk::SmartPointer<const Self>                      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(StreamingConnectedComponentImageFilter, TiledLabellingImageFilterBase);
+
+  typedef typename Superclass::InputPixelType        InputPixelType;
+  typedef typename Superclass::LabellerType          LabellerType;
+  typedef typename Superclass::PersistentFilterType  PersistentFilterType;
+
+  /** Set/Get the connectivity: 8-connectivity if true, 4-connectivity otherwise */
+  itkSetMacro(FullyConnected, bool);
+  itkGetConstMacro(FullyConnected, bool);
+  itkBooleanMacro(FullyConnected);
+
+  /** Set/Get the background value */
+  itkSetMacro(BackgroundValue, InputPixelType);
+  itkGetConstMacro(BackgroundValue, InputPixelType);
+
+  /** Set/Get the flag telling if only neighbours with the same value are connected */
+  itkSetMacro(ConnectEqualValuesOnly, bool);
+  itkGetConstMacro(ConnectEqualValuesOnly, bool);
+  itkBooleanMacro(ConnectEqualValuesOnly);
+
+protected:
+  StreamingConnectedComponentImageFilter();
+  ~StreamingConnectedComponentImageFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+  void ComputeEquivalences() ITK_OVERRIDE;
+
+private:
+  StreamingConnectedComponentImageFilter(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+
+  bool           m_FullyConnected;
+  InputPixelType m_BackgroundValue;
+  bool           m_ConnectEqualValuesOnly;
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbStreamingConnectedComponentImageFilter.txx"
+#endif
+
+#endif
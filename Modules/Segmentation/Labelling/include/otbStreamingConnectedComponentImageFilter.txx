@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbStreamingConnectedComponentImageFilter_txx
+#define otbStreamingConnectedComponentImageFilter_txx
+
+#include "otbStreamingConnectedComponentImageFilter.h"
+#include "itkNumericTraits.h"
+
+namespace otb
+{
+
+template <class TInputImage, class TOutputImage>
+StreamingConnectedComponentImageFilter<TInputImage, TOutputImage>
+::StreamingConnectedComponentImageFilter()
+  : m_FullyConnected(false),
+    m_BackgroundValue(itk::NumericTraits<InputPixelType>::ZeroValue()),
+    m_ConnectEqualValuesOnly(false)
+{
+}
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingConnectedComponentImageFilter<TInputImage, TOutputImage>
+::ComputeEquivalences()
+{
+  LabellerType * labeller = this->GetEquivalenceFilter()->GetFilter()->GetLabeller();
+  labeller->SetFullyConnected(m_FullyConnected);
+  labeller->SetBackgroundValue(m_BackgroundValue);
+  labeller->SetConnectEqualValuesOnly(m_ConnectEqualValuesOnly);
+
+  Superclass::ComputeEquivalences();
+}
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingConnectedComponentImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "FullyConnected: " << m_FullyConnected << std::endl;
+  os << indent << "BackgroundValue: " << m_BackgroundValue << std::endl;
+  os << indent << "ConnectEqualValuesOnly: " << m_ConnectEqualValuesOnly << std::endl;
+}
+
+} // end namespace otb
+
+#endif
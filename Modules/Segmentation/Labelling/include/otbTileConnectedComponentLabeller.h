@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbTileConnectedComponentLabeller_h
+#define otbTileConnectedComponentLabeller_h
+
+#include <vector>
+#include "itkImageRegion.h"
+
+namespace otb
+{
+
+/** \class TileConnectedComponentLabeller
+ * \brief Deterministic connected component labelling of one image tile.
+ *
+ * This helper labels the connected components of a single 2D tile of a
+ * scalar image with a two-pass union-find algorithm. Pixels equal to the
+ * background value get the label 0. Two neighbouring foreground pixels are
+ * connected if ConnectEqualValuesOnly is off, or if they have the same value
+ * when it is on (which allows to split the regions of a label image).
+ *
+ * Local labels are consecutive and start at 1. Components touching the tile
+ * border are numbered first, in a fixed scan order (top row, bottom row,
+ * left column, right column), so that labels in [1, NumberOfBorderLabels]
+ * are exactly the components that may continue in a neighbouring tile.
+ * Labelling the same tile twice always yields the same labels, which is
+ * what StreamingConnectedComponentImageFilter relies on to relabel tiles
+ * in its second pass.
+ *
+ * This class is the reference model of the tile labellers used by
+ * PersistentConnectedComponentEquivalenceFilter: GetRadius(),
+ * GetBorderPixel() and IsConnected() with an offset describe how tiles are
+ * read and connected to their neighbours.
+ *
+ * \sa StreamingConnectedComponentImageFilter
+ * \sa PersistentConnectedComponentEquivalenceFilter
+ *
+ * \ingroup OTBLabelling
+ */
+template <class TInputImage>
+class TileConnectedComponentLabeller
+{
+public:
+  typedef TInputImage                            InputImageType;
+  typedef typename InputImageType::PixelType     InputPixelType;
+  typedef typename InputImageType::RegionType    RegionType;
+  typedef typename InputImageType::IndexType     IndexType;
+  typedef typename InputImageType::SizeType      SizeType;
+
+  typedef unsigned int                           LocalLabelType;
+  typedef std::vector<InputPixelType>            ValueVectorType;
+  typedef std::vector<LocalLabelType>            LabelVectorType;
+
+  /** Information kept along tile borders to connect neighbouring tiles */
+  typedef InputPixelType                         BorderPixelType;
+
+  TileConnectedComponentLabeller();
+  virtual ~TileConnectedComponentLabeller() {}
+
+  /** Set/Get the connectivity: 8-connectivity if true, 4-connectivity otherwise */
+  void SetFullyConnected(bool flag)
+  {
+    m_FullyConnected = flag;
+  }
+  bool GetFullyConnected() const
+  {
+    return m_FullyConnected;
+  }
+
+  /** Set/Get the background value */
+  void SetBackgroundValue(const InputPixelType & value)
+  {
+    m_BackgroundValue = value;
+  }
+  const InputPixelType & GetBackgroundValue() const
+  {
+    return m_BackgroundValue;
+  }
+
+  /** Set/Get the flag telling if only pixels with the same value are connected */
+  void SetConnectEqualValuesOnly(bool flag)
+  {
+    m_ConnectEqualValuesOnly = flag;
+  }
+  bool GetConnectEqualValuesOnly() const
+  {
+    return m_ConnectEqualValuesOnly;
+  }
+
+  /** Number of pixels needed around a tile to label it. No margin is
+   * needed for connected components. */
+  unsigned int GetRadius() const
+  {
+    return 0;
+  }
+
+  /** Label the given tile. The tile must be inside the buffered region of
+   * the image. */
+  void Label(const InputImageType * image, const RegionType & tile);
+
+  /** Tile processed by the last call to Label() */
+  const RegionType & GetRegion() const
+  {
+    return m_Region;
+  }
+
+  /** Number of components touching the border of the tile */
+  LocalLabelType GetNumberOfBorderLabels() const
+  {
+    return m_NumberOfBorderLabels;
+  }
+
+  /** Total number of components in the tile */
+  LocalLabelType GetNumberOfLabels() const
+  {
+    return m_NumberOfLabels;
+  }
+
+  /** Local label of the pixel (x, y), in tile coordinates */
+  LocalLabelType GetLabel(unsigned int x, unsigned int y) const
+  {
+    return m_Labels[y * m_Region.GetSize()[0] + x];
+  }
+
+  /** Value of the pixel (x, y), in tile coordinates */
+  const InputPixelType & GetValue(unsigned int x, unsigned int y) const
+  {
+    return m_Values[y * m_Region.GetSize()[0] + x];
+  }
+
+  /** Border information of the pixel (x, y), in tile coordinates */
+  BorderPixelType GetBorderPixel(unsigned int x, unsigned int y) const
+  {
+    return GetValue(x, y);
+  }
+
+  /** Tells if a pixel is part of the foreground */
+  bool IsForeground(const InputPixelType & value) const
+  {
+    return value != m_BackgroundValue;
+  }
+
+  /** Tells if two neighbouring pixels belong to the same component */
+  bool IsConnected(const InputPixelType & a, const InputPixelType & b) const
+  {
+    return IsForeground(a) && IsForeground(b) && (!m_ConnectEqualValuesOnly || a == b);
+  }
+
+  /** Tells if two border pixels of neighbouring tiles belong to the same
+   * component, (dx, dy) being the offset from a to b */
+  bool IsConnected(const BorderPixelType & a, const BorderPixelType & b, int itkNotUsed(dx), int itkNotUsed(dy)) const
+  {
+    return IsConnected(a, b);
+  }
+
+private:
+  /** Find the root of a provisional label, with path halving */
+  LocalLabelType FindRoot(LocalLabelType label);
+
+  /** Merge the sets of two provisional labels, keeping the smallest root */
+  void Union(LocalLabelType a, LocalLabelType b);
+
+  /** Connect the current pixel to an already visited neighbour */
+  void ConnectToNeighbour(LocalLabelType & label, unsigned int neighbour, const InputPixelType & value);
+
+  /** Assign the next final label to the component of a pixel, if needed */
+  void AssignFinalLabel(unsigned int pos, LabelVectorType & finalLabels);
+
+  bool            m_FullyConnected;
+  InputPixelType  m_BackgroundValue;
+  bool            m_ConnectEqualValuesOnly;
+
+  RegionType      m_Region;
+  ValueVectorType m_Values;
+  LabelVectorType m_Labels;
+  LabelVectorType m_Parent;
+  LocalLabelType  m_NumberOfBorderLabels;
+  LocalLabelType  m_NumberOfLabels;
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbTileConnectedComponentLabeller.txx"
+#endif
+
+#endif
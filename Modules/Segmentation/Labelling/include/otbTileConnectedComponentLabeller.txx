@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbTileConnectedComponentLabeller_txx
+#define otbTileConnectedComponentLabeller_txx
+
+#include "otbTileConnectedComponentLabeller.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkNumericTraits.h"
+
+namespace otb
+{
+
+template <class TInputImage>
+TileConnectedComponentLabeller<TInputImage>
+::TileConnectedComponentLabeller()
+  : m_FullyConnected(false),
+    m_BackgroundValue(itk::NumericTraits<InputPixelType>::ZeroValue()),
+    m_ConnectEqualValuesOnly(false),
+    m_NumberOfBorderLabels(0),
+    m_NumberOfLabels(0)
+{
+}
+
+template <class TInputImage>
+typename TileConnectedComponentLabeller<TInputImage>::LocalLabelType
+TileConnectedComponentLabeller<TInputImage>
+::FindRoot(LocalLabelType label)
+{
+  while (m_Parent[label] != label)
+    {
+    m_Parent[label] = m_Parent[m_Parent[label]];
+    label = m_Parent[label];
+    }
+  return label;
+}
+
+template <class TInputImage>
+void
+TileConnectedComponentLabeller<TInputImage>
+::Union(LocalLabelType a, LocalLabelType b)
+{
+  LocalLabelType ra = FindRoot(a);
+  LocalLabelType rb = FindRoot(b);
+  if (ra < rb)
+    {
+    m_Parent[rb] = ra;
+    }
+  else if (rb < ra)
+    {
+    m_Parent[ra] = rb;
+    }
+}
+
+template <class TInputImage>
+void
+TileConnectedComponentLabeller<TInputImage>
+::ConnectToNeighbour(LocalLabelType & label, unsigned int neighbour, const InputPixelType & value)
+{
+  if (!IsConnected(m_Values[neighbour], value))
+    {
+    return;
+    }
+  if (label == 0)
+    {
+    label = FindRoot(m_Labels[neighbour]);
+    }
+  else
+    {
+    Union(label, m_Labels[neighbour]);
+    }
+}
+
+template <class TInputImage>
+void
+TileConnectedComponentLabeller<TInputImage>
+::AssignFinalLabel(unsigned int pos, LabelVectorType & finalLabels)
+{
+  if (m_Labels[pos] == 0)
+    {
+    return;
+    }
+  LocalLabelType root = FindRoot(m_Labels[pos]);
+  if (finalLabels[root] == 0)
+    {
+    finalLabels[root] = ++m_NumberOfLabels;
+    }
+}
+
+template <class TInputImage>
+void
+TileConnectedComponentLabeller<TInputImage>
+::Label(const InputImageType * image, const RegionType & tile)
+{
+  m_Region = tile;
+  const unsigned int width  = tile.GetSize()[0];
+  const unsigned int height = tile.GetSize()[1];
+  const unsigned int nbPixels = width * height;
+
+  m_Values.resize(nbPixels);
+  m_Labels.assign(nbPixels, 0);
+  m_Parent.clear();
+  m_Parent.push_back(0);
+  m_NumberOfBorderLabels = 0;
+  m_NumberOfLabels = 0;
+
+  if (nbPixels == 0)
+    {
+    return;
+    }
+
+  // Copy the tile values in a contiguous row-major buffer
+  itk::ImageRegionConstIterator<InputImageType> it(image, tile);
+  typename ValueVectorType::iterator valueIt = m_Values.begin();
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it, ++valueIt)
+    {
+    *valueIt = it.Get();
+    }
+
+  // First pass : provisional labels and equivalences
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    for (unsigned int x = 0; x < width; ++x)
+      {
+      const unsigned int pos = y * width + x;
+      const InputPixelType & value = m_Values[pos];
+      if (!IsForeground(value))
+        {
+        continue;
+        }
+
+      LocalLabelType label = 0;
+      if (x > 0)
+        {
+        ConnectToNeighbour(label, pos - 1, value);
+        }
+      if (y > 0)
+        {
+        ConnectToNeighbour(label, pos - width, value);
+        if (m_FullyConnected)
+          {
+          if (x > 0)
+            {
+            ConnectToNeighbour(label, pos - width - 1, value);
+            }
+          if (x + 1 < width)
+            {
+            ConnectToNeighbour(label, pos - width + 1, value);
+            }
+          }
+        }
+
+      if (label == 0)
+        {
+        label = static_cast<LocalLabelType>(m_Parent.size());
+        m_Parent.push_back(label);
+        }
+      m_Labels[pos] = label;
+      }
+    }
+
+  // Second pass : consecutive labels, border components first
+  LabelVectorType finalLabels(m_Parent.size(), 0);
+  for (unsigned int x = 0; x < width; ++x)
+    {
+    AssignFinalLabel(x, finalLabels);
+    }
+  for (unsigned int x = 0; x < width; ++x)
+    {
+    AssignFinalLabel((height - 1) * width + x, finalLabels);
+    }
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    AssignFinalLabel(y * width, finalLabels);
+    }
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    AssignFinalLabel(y * width + width - 1, finalLabels);
+    }
+  m_NumberOfBorderLabels = m_NumberOfLabels;
+
+  for (unsigned int pos = 0; pos < nbPixels; ++pos)
+    {
+    AssignFinalLabel(pos, finalLabels);
+    }
+
+  for (unsigned int pos = 0; pos < nbPixels; ++pos)
+    {
+    if (m_Labels[pos] != 0)
+      {
+      m_Labels[pos] = finalLabels[FindRoot(m_Labels[pos])];
+      }
+    }
+}
+
+} // end namespace otb
+
+#endif
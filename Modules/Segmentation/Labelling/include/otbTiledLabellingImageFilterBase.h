@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbTiledLabellingImageFilterBase_h
+#define otbTiledLabellingImageFilterBase_h
+
+#include "itkImageToImageFilter.h"
+#include "otbPersistentFilterStreamingDecorator.h"
+
+namespace otb
+{
+
+/** \class TiledLabellingImageFilterBase
+ * \brief Base class of the streaming labelling filters working on a tile grid.
+ *
+ * The labelling is done in two passes on a fixed grid of TileSize x
+ * TileSize tiles:
+ *
+ * - During GenerateOutputInformation(), the input is streamed once through
+ * the persistent filter TPersistentFilter (a
+ * PersistentConnectedComponentEquivalenceFilter or a subclass), which
+ * labels each tile independently and merges the labels crossing tile
+ * borders in a global equivalence table.
+ * - Each requested output region is then produced by labelling the tiles
+ * covering it again, in parallel (tile labelling is deterministic), and
+ * mapping the local labels to global ones through the table.
+ *
+ * The first pass is run again each time the input pipeline or the filter
+ * parameters are modified. Its streaming can be tuned through
+ * GetEquivalenceFilter()->GetStreamer(). Subclasses set the parameters of
+ * the tile labeller in ComputeEquivalences().
+ *
+ * \sa PersistentConnectedComponentEquivalenceFilter
+ *
+ * \ingroup Streamed
+ * \ingroup Multithreaded
+ *
+ * \ingroup OTBLabelling
+ */
+template <class TInputImage, class TOutputImage, class TPersistentFilter>
+class ITK_EXPORT TiledLabellingImageFilterBase :
+  public itk::ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef TiledLabellingImageFilterBase                      Self;
+  typedef itk::ImageToImageFilter<TInputImage, TOutputImage> Superclass;
+  typedef itk::SmartPointer<Self>                            Pointer;
+  typedef itk::SmartPointer<const Self>                      ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(TiledLabellingImageFilterBase, ImageToImageFilter);
+
+  typedef TInputImage                              InputImageType;
+  typedef typename InputImageType::PixelType       InputPixelType;
+  typedef TOutputImage                             OutputImageType;
+  typedef typename OutputImageType::PixelType      OutputPixelType;
+  typedef typename OutputImageType::RegionType     RegionType;
+  typedef typename OutputImageType::IndexType      IndexType;
+  typedef typename OutputImageType::SizeType       SizeType;
+
+  typedef TPersistentFilter                                         PersistentFilterType;
+  typedef PersistentFilterStreamingDecorator<PersistentFilterType>  EquivalenceFilterType;
+  typedef typename PersistentFilterType::LabellerType               LabellerType;
+  typedef typename PersistentFilterType::LabelType                  LabelType;
+
+  /** Set/Get the tile size (in pixels) of the labelling grid */
+  itkSetMacro(TileSize, unsigned int);
+  itkGetConstMacro(TileSize, unsigned int);
+
+  /** Get the filter computing the equivalence table (first pass) */
+  itkGetObjectMacro(EquivalenceFilter, EquivalenceFilterType);
+
+  /** Number of labels in the output image. Available once the output
+   * information has been updated. */
+  LabelType GetObjectCount() const
+  {
+    return m_EquivalenceFilter->GetFilter()->GetNumberOfObjects();
+  }
+
+protected:
+  TiledLabellingImageFilterBase();
+  ~TiledLabellingImageFilterBase() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+  /** Runs the first pass. Subclasses configure the labeller of the
+   * persistent filter before calling this implementation. */
+  virtual void ComputeEquivalences();
+
+  /** Runs the first pass if the equivalence table is out of date */
+  void GenerateOutputInformation() ITK_OVERRIDE;
+
+  /** Requests the tiles covering the output requested region */
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  void GenerateData() ITK_OVERRIDE;
+
+private:
+  TiledLabellingImageFilterBase(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+
+  struct RelabelThreadStruct
+  {
+    Self *                      Filter;
+    std::vector<unsigned int> * Tiles;
+  };
+
+  /** Relabels the tiles covering the output requested region, in parallel */
+  static ITK_THREAD_RETURN_TYPE RelabelThreaderCallback(void * arg);
+
+  /** Relabels the part of a tile inside the output requested region */
+  void RelabelTile(LabellerType & labeller, unsigned int tileId);
+
+  unsigned int m_TileSize;
+
+  typename EquivalenceFilterType::Pointer m_EquivalenceFilter;
+  itk::TimeStamp                          m_EquivalenceTime;
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbTiledLabellingImageFilterBase.txx"
+#endif
+
+#endif
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbTiledLabellingImageFilterBase_txx
+#define otbTiledLabellingImageFilterBase_txx
+
+#include "otbTiledLabellingImageFilterBase.h"
+#include "itkImageScanlineIterator.h"
+#include "otbMacro.h"
+
+namespace otb
+{
+
+template <class TInputImage, class TOutputImage, class TPersistentFilter>
+TiledLabellingImageFilterBase<TInputImage, TOutputImage, TPersistentFilter>
+::TiledLabellingImageFilterBase()
+  : m_TileSize(256)
+{
+  m_EquivalenceFilter = EquivalenceFilterType::New();
+}
+
+template <class TInputImage, class TOutputImage, class TPersistentFilter>
+void
+TiledLabellingImageFilterBase<TInputImage, TOutputImage, TPersistentFilter>
+::ComputeEquivalences()
+{
+  PersistentFilterType * persistent = m_EquivalenceFilter->GetFilter();
+  persistent->SetInput(this->GetInput());
+  persistent->SetTileSize(m_TileSize);
+  persistent->SetNumberOfThreads(this->GetNumberOfThreads());
+
+  // The parameters of the labeller are not part of the MTime of the
+  // persistent filter
+  persistent->Modified();
+  m_EquivalenceFilter->Update();
+
+  otbMsgDevMacro(<< "Tiled labelling: " << persistent->GetNumberOfObjects() << " objects found");
+}
+
+template <class TInputImage, class TOutputImage, class TPersistentFilter>
+void
+TiledLabellingImageFilterBase<TInputImage, TOutputImage, TPersistentFilter>
+::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  const InputImageType * input = this->GetInput();
+  if (!input)
+    {
+    return;
+    }
+
+  if (m_EquivalenceTime < this->GetMTime() || m_EquivalenceTime < input->GetPipelineMTime())
+    {
+    this->ComputeEquivalences();
+    m_EquivalenceTime.Modified();
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TPersistentFilter>
+void
+TiledLabellingImageFilterBase<TInputImage, TOutputImage, TPersistentFilter>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * input = const_cast<InputImageType *>(this->GetInput());
+  if (!input)
+    {
+    return;
+    }
+
+  const PersistentFilterType * persistent = m_EquivalenceFilter->GetFilter();
+  IndexType start, end;
+  persistent->GetTileRange(this->GetOutput()->GetRequestedRegion(), start, end);
+
+  if (start[0] < end[0] && start[1] < end[1])
+    {
+    input->SetRequestedRegion(persistent->GetTileRangeInputRegion(start, end));
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TPersistentFilter>
+void
+TiledLabellingImageFilterBase<TInputImage, TOutputImage, TPersistentFilter>
+::RelabelTile(LabellerType & labeller, unsigned int tileId)
+{
+  const PersistentFilterType * persistent = m_EquivalenceFilter->GetFilter();
+  OutputImageType * output = this->GetOutput();
+
+  const unsigned int nbTilesX = persistent->GetNumberOfTilesX();
+  const RegionType tileRegion = persistent->GetTileRegion(tileId % nbTilesX, tileId / nbTilesX);
+  labeller.Label(this->GetInput(), tileRegion);
+
+  RegionType region = tileRegion;
+  region.Crop(output->GetRequestedRegion());
+
+  itk::ImageScanlineIterator<OutputImageType> outIt(output, region);
+  for (outIt.GoToBegin(); !outIt.IsAtEnd(); outIt.NextLine())
+    {
+    const unsigned int y = outIt.GetIndex()[1] - tileRegion.GetIndex()[1];
+    unsigned int x = outIt.GetIndex()[0] - tileRegion.GetIndex()[0];
+    while (!outIt.IsAtEndOfLine())
+      {
+      outIt.Set(static_cast<OutputPixelType>(persistent->GetGlobalLabel(tileId, labeller.GetLabel(x, y))));
+      ++outIt;
+      ++x;
+      }
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TPersistentFilter>
+ITK_THREAD_RETURN_TYPE
+TiledLabellingImageFilterBase<TInputImage, TOutputImage, TPersistentFilter>
+::RelabelThreaderCallback(void * arg)
+{
+  itk::MultiThreader::ThreadInfoStruct * info = static_cast<itk::MultiThreader::ThreadInfoStruct *>(arg);
+  RelabelThreadStruct * str = static_cast<RelabelThreadStruct *>(info->UserData);
+  const unsigned int threadId = info->ThreadID;
+  const unsigned int nbThreads = info->NumberOfThreads;
+
+  // Each thread works on its own copy of the labeller
+  LabellerType labeller(*(str->Filter->m_EquivalenceFilter->GetFilter()->GetLabeller()));
+  const std::vector<unsigned int> & tiles = *(str->Tiles);
+  for (unsigned int i = threadId; i < tiles.size(); i += nbThreads)
+    {
+    str->Filter->RelabelTile(labeller, tiles[i]);
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template <class TInputImage, class TOutputImage, class TPersistentFilter>
+void
+TiledLabellingImageFilterBase<TInputImage, TOutputImage, TPersistentFilter>
+::GenerateData()
+{
+  this->AllocateOutputs();
+
+  const PersistentFilterType * persistent = m_EquivalenceFilter->GetFilter();
+  IndexType start, end;
+  persistent->GetTileRange(this->GetOutput()->GetRequestedRegion(), start, end);
+
+  std::vector<unsigned int> tiles;
+  for (long ty = start[1]; ty < end[1]; ++ty)
+    {
+    for (long tx = start[0]; tx < end[0]; ++tx)
+      {
+      tiles.push_back(ty * persistent->GetNumberOfTilesX() + tx);
+      }
+    }
+  if (tiles.empty())
+    {
+    return;
+    }
+
+  RelabelThreadStruct str;
+  str.Filter = this;
+  str.Tiles = &tiles;
+
+  const unsigned int nbThreads = std::min(static_cast<unsigned int>(this->GetNumberOfThreads()),
+                                          static_cast<unsigned int>(tiles.size()));
+  this->GetMultiThreader()->SetNumberOfThreads(nbThreads);
+  this->GetMultiThreader()->SetSingleMethod(this->RelabelThreaderCallback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template <class TInputImage, class TOutputImage, class TPersistentFilter>
+void
+TiledLabellingImageFilterBase<TInputImage, TOutputImage, TPersistentFilter>
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "TileSize: " << m_TileSize << std::endl;
+}
+
+} // end namespace otb
+
+#endif
@@ -30,4 +30,5 @@ void RegisterTests()
   REGISTER_TEST(otbLabelizeConfidenceConnectedImageFilterNew);
   REGISTER_TEST(otbLabelToBoundaryImageFilter);
   REGISTER_TEST(otbLabelToBoundaryImageFilterNew);
+  REGISTER_TEST(otbStreamingConnectedComponentImageFilter);
 }
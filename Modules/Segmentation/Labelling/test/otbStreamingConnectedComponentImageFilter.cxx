@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "otbStreamingConnectedComponentImageFilter.h"
+#include "otbImage.h"
+#include "itkConnectedComponentImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include <map>
+
+typedef otb::Image<unsigned char, 2> CCInputImageType;
+typedef otb::Image<unsigned int, 2>  CCLabelImageType;
+
+// Compare the streaming labelling of an image with the one of
+// itk::ConnectedComponentImageFilter
+template <class TFilter>
+int CheckStreamingConnectedComponents(TFilter * filter, const CCInputImageType * image, bool fullyConnected)
+{
+  typedef itk::ConnectedComponentImageFilter<CCInputImageType, CCLabelImageType> ReferenceFilterType;
+  typedef CCLabelImageType::PixelType                                           LabelPixelType;
+
+  ReferenceFilterType::Pointer reference = ReferenceFilterType::New();
+  reference->SetInput(image);
+  reference->SetFullyConnected(fullyConnected);
+  reference->Update();
+
+  if (filter->GetObjectCount() != reference->GetObjectCount())
+    {
+    std::cerr << "Wrong number of objects: " << filter->GetObjectCount()
+              << " instead of " << reference->GetObjectCount()
+              << " (FullyConnected: " << fullyConnected << ")" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Both labellings must describe the same partition of the image
+  const CCLabelImageType::RegionType region = image->GetLargestPossibleRegion();
+  std::map<LabelPixelType, LabelPixelType> forward, backward;
+  itk::ImageRegionConstIterator<CCLabelImageType> outIt(filter->GetOutput(), region);
+  itk::ImageRegionConstIterator<CCLabelImageType> refIt(reference->GetOutput(), region);
+  for (outIt.GoToBegin(), refIt.GoToBegin(); !outIt.IsAtEnd(); ++outIt, ++refIt)
+    {
+    const LabelPixelType label = outIt.Get();
+    const LabelPixelType refLabel = refIt.Get();
+    if ((label == 0) != (refLabel == 0))
+      {
+      std::cerr << "Background mismatch at " << outIt.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (label == 0)
+      {
+      continue;
+      }
+    if ((forward.count(label) && forward[label] != refLabel)
+        || (backward.count(refLabel) && backward[refLabel] != label))
+      {
+      std::cerr << "Component mismatch at " << outIt.GetIndex()
+                << " (FullyConnected: " << fullyConnected << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    forward[label] = refLabel;
+    backward[refLabel] = label;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+int otbStreamingConnectedComponentImageFilter(int argc, char * argv [])
+{
+  if (argc != 4)
+    {
+    std::cerr << "Usage : " << argv[0] << " tileSize fullyConnected nbDivisions" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef CCInputImageType InputImageType;
+  typedef CCLabelImageType LabelImageType;
+
+  typedef otb::StreamingConnectedComponentImageFilter<InputImageType, LabelImageType> StreamingFilterType;
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator                     GeneratorType;
+
+  const unsigned int tileSize = atoi(argv[1]);
+  const bool fullyConnected = atoi(argv[2]) != 0;
+  const unsigned int nbDivisions = atoi(argv[3]);
+
+  // Random binary image, with enough foreground to get components crossing
+  // many tile borders
+  InputImageType::SizeType size;
+  size[0] = 301;
+  size[1] = 257;
+  InputImageType::RegionType region;
+  region.SetSize(size);
+
+  InputImageType::Pointer image = InputImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(12345);
+  itk::ImageRegionIterator<InputImageType> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    it.Set(generator->GetUniformVariate(0., 1.) < 0.55 ? 255 : 0);
+    }
+
+  StreamingFilterType::Pointer filter = StreamingFilterType::New();
+  filter->SetInput(image);
+  filter->SetTileSize(tileSize);
+  filter->SetFullyConnected(fullyConnected);
+  filter->GetEquivalenceFilter()->GetStreamer()->SetNumberOfDivisionsStrippedStreaming(nbDivisions);
+  filter->Update();
+
+  if (CheckStreamingConnectedComponents(filter.GetPointer(), image, fullyConnected) == EXIT_FAILURE)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Run again with another connectivity: only the tile labeller changes,
+  // the labelling grid is the same
+  filter->SetFullyConnected(!fullyConnected);
+  filter->Update();
+
+  return CheckStreamingConnectedComponents(filter.GetPointer(), image, !fullyConnected);
+}
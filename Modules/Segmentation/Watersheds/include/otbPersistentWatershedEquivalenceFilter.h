@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbPersistentWatershedEquivalenceFilter_h
+#define otbPersistentWatershedEquivalenceFilter_h
+
+#include "otbPersistentConnectedComponentEquivalenceFilter.h"
+#include "otbTileWatershedLabeller.h"
+
+namespace otb
+{
+
+/** \class PersistentWatershedEquivalenceFilter
+ * \brief First pass of the streaming watershed segmentation.
+ *
+ * Tiles are flooded independently by TileWatershedLabeller, and the basins
+ * cut by tile borders are reconciled by the superclass. The exits of the
+ * flat zones found inside tiles and across tile borders are gathered, and
+ * Synthetize() first connects each flat zone having a lower neighbour to
+ * the basin of its lowest exit, so that only the regional minima of the
+ * image start a basin. When FloodLevel is positive, a merge graph of the
+ * basins is also built: its nodes are the basins with their minimum height,
+ * and its edges the lowest saddles between neighbouring basins, inside
+ * tiles and across tile borders.
+ *
+ * Synthetize() then merges the basins hierarchically, always merging first
+ * the pair whose shallowest basin is the least deep below their common
+ * saddle, until this depth reaches FloodLevel. Equal depths are ordered by
+ * the position of their saddle, so the result does not depend on the tile
+ * size nor on the streaming. This is the merge tree built
+ * by itk::WatershedImageFilter, computed on the basin graph only, so that
+ * its memory usage depends on the number of basins and not on the image
+ * size.
+ *
+ * \sa StreamingWatershedSegmentationFilter
+ * \sa PersistentConnectedComponentEquivalenceFilter
+ *
+ * \ingroup Streamed
+ * \ingroup Multithreaded
+ *
+ * \ingroup OTBWatersheds
+ */
+template <class TInputImage>
+class ITK_EXPORT PersistentWatershedEquivalenceFilter :
+  public PersistentConnectedComponentEquivalenceFilter<TInputImage, TileWatershedLabeller<TInputImage> >
+{
+public:
+  /** Standard Self typedef */
+  typedef PersistentWatershedEquivalenceFilter Self;
+  typedef PersistentConnectedComponentEquivalenceFilter<TInputImage,
+    TileWatershedLabeller<TInputImage> >      Superclass;
+  typedef itk::SmartPointer<Self>              Pointer;
+  typedef itk::SmartPointer<const Self>        ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(PersistentWatershedEquivalenceFilter, PersistentConnectedComponentEquivalenceFilter);
+
+  typedef typename Superclass::PixelType              PixelType;
+  typedef typename Superclass::LabellerType           LabellerType;
+  typedef typename Superclass::LocalLabelType         LocalLabelType;
+  typedef typename Superclass::BorderPixelType        BorderPixelType;
+  typedef typename LabellerType::SaddleType           SaddleType;
+  typedef typename LabellerType::DrainType            DrainType;
+  typedef typename LabellerType::DrainVectorType      DrainVectorType;
+  typedef typename Superclass::LabelType              LabelType;
+  typedef typename Superclass::LabelVectorType        LabelVectorType;
+
+  /** Set/Get the maximum depth of the basins merged together, in height
+   * units. No merge is done if it is not positive. */
+  itkSetMacro(FloodLevel, double);
+  itkGetConstMacro(FloodLevel, double);
+
+  /** Number of basins before merging (valid after Synthetize()) */
+  itkGetConstMacro(NumberOfBasins, LabelType);
+
+  void GenerateOutputInformation() ITK_OVERRIDE;
+
+  void Synthetize(void) ITK_OVERRIDE;
+
+  void Reset(void) ITK_OVERRIDE;
+
+protected:
+  PersistentWatershedEquivalenceFilter();
+  ~PersistentWatershedEquivalenceFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+  void TileLabelled(unsigned int tileId, const LabellerType & labeller) ITK_OVERRIDE;
+
+  void AddBorderAdjacency(unsigned int tileA, LocalLabelType labelA, const BorderPixelType & a,
+                          unsigned int tileB, LocalLabelType labelB, const BorderPixelType & b,
+                          int dx, int dy) ITK_OVERRIDE;
+
+private:
+  PersistentWatershedEquivalenceFilter(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+
+  /** Saddle between two basins of the same tile */
+  struct TileEdge
+  {
+    LocalLabelType labelA;
+    LocalLabelType labelB;
+    SaddleType     saddle;
+  };
+
+  /** Saddle between two basins of adjacent tiles */
+  struct BorderEdge
+  {
+    unsigned int   tileA;
+    LocalLabelType labelA;
+    unsigned int   tileB;
+    LocalLabelType labelB;
+    SaddleType     saddle;
+  };
+
+  /** Exit of a flat zone towards an adjacent tile, source and target
+   * being local labels of tileSource and tileTarget */
+  struct BorderDrain
+  {
+    unsigned int tileSource;
+    unsigned int tileTarget;
+    DrainType    drain;
+  };
+
+  /** Saddle between two basins, with base labels */
+  struct Edge
+  {
+    LabelType  a;
+    LabelType  b;
+    SaddleType saddle;
+  };
+
+  /** Entry of the merge queue: depth of an edge when it was pushed, with
+   * its saddle to order equal depths */
+  struct QueueItem
+  {
+    double      depth;
+    SaddleType  saddle;
+    std::size_t edge;
+
+    bool operator>(const QueueItem & other) const
+    {
+      if (depth != other.depth)
+        {
+        return depth > other.depth;
+        }
+      return other.saddle < saddle;
+    }
+  };
+
+  typedef std::vector<PixelType>              PixelVectorType;
+  typedef std::vector<TileEdge>               TileEdgeVectorType;
+
+  /** Allocate the per tile slots for the current labelling grid */
+  void AllocateTileData();
+
+  /** Connect the flat zones to the basin of their lowest exit, and fill
+   * the basin of each base label */
+  void DrainFlatZones(LabelVectorType & basins);
+
+  /** Merge the basins, and set the lookup table of the superclass */
+  void MergeBasins(const LabelVectorType & basins);
+
+  /** Depth of the shallowest of two basins below their saddle */
+  double GetDepth(const SaddleType & saddle, const PixelType & minimumA, const PixelType & minimumB) const;
+
+  LabelType FindRoot(LabelVectorType & parent, LabelType id) const;
+
+  double                            m_FloodLevel;
+  LabelType                         m_NumberOfBasins;
+
+  /** Per tile exits, minima and edges, filled concurrently by
+   * TileLabelled() */
+  std::vector<DrainVectorType>      m_TileDrains;
+  std::vector<PixelVectorType>      m_TileMinima;
+  std::vector<TileEdgeVectorType>   m_TileEdges;
+  std::vector<BorderDrain>          m_BorderDrains;
+  std::vector<BorderEdge>           m_BorderEdges;
+}; // end of class PersistentWatershedEquivalenceFilter
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbPersistentWatershedEquivalenceFilter.txx"
+#endif
+
+#endif
@@ -0,0 +1,421 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbPersistentWatershedEquivalenceFilter_txx
+#define otbPersistentWatershedEquivalenceFilter_txx
+
+#include "otbPersistentWatershedEquivalenceFilter.h"
+#include "otbMacro.h"
+#include <queue>
+#include <functional>
+
+namespace otb
+{
+
+template <class TInputImage>
+PersistentWatershedEquivalenceFilter<TInputImage>
+::PersistentWatershedEquivalenceFilter()
+  : m_FloodLevel(0.),
+    m_NumberOfBasins(0)
+{
+}
+
+template <class TInputImage>
+void
+PersistentWatershedEquivalenceFilter<TInputImage>
+::GenerateOutputInformation()
+{
+  Superclass::GenerateOutputInformation();
+
+  // Per tile slots are allocated by Reset() for the current grid, and
+  // again here when the grid changes, so that the tiles can fill them from
+  // several threads
+  if (m_TileDrains.size() != this->GetNumberOfTilesX() * this->GetNumberOfTilesY())
+    {
+    this->AllocateTileData();
+    }
+}
+
+template <class TInputImage>
+void
+PersistentWatershedEquivalenceFilter<TInputImage>
+::AllocateTileData()
+{
+  this->GetLabeller()->SetComputeAdjacency(m_FloodLevel > 0.);
+
+  const unsigned int nbTiles = this->GetNumberOfTilesX() * this->GetNumberOfTilesY();
+  m_TileDrains.assign(nbTiles, DrainVectorType());
+  if (m_FloodLevel > 0.)
+    {
+    m_TileMinima.assign(nbTiles, PixelVectorType());
+    m_TileEdges.assign(nbTiles, TileEdgeVectorType());
+    }
+  else
+    {
+    std::vector<PixelVectorType>().swap(m_TileMinima);
+    std::vector<TileEdgeVectorType>().swap(m_TileEdges);
+    }
+}
+
+template <class TInputImage>
+void
+PersistentWatershedEquivalenceFilter<TInputImage>
+::Reset()
+{
+  Superclass::Reset();
+
+  // The flood level may have changed without a new call to
+  // GenerateOutputInformation()
+  this->AllocateTileData();
+  m_BorderDrains.clear();
+  m_BorderEdges.clear();
+  m_NumberOfBasins = 0;
+}
+
+template <class TInputImage>
+void
+PersistentWatershedEquivalenceFilter<TInputImage>
+::TileLabelled(unsigned int tileId, const LabellerType & labeller)
+{
+  m_TileDrains[tileId] = labeller.GetDrains();
+
+  if (m_FloodLevel <= 0.)
+    {
+    return;
+    }
+
+  m_TileMinima[tileId] = labeller.GetMinimumValues();
+
+  TileEdgeVectorType & edges = m_TileEdges[tileId];
+  edges.clear();
+  edges.reserve(labeller.GetAdjacency().size());
+  typename LabellerType::AdjacencyMapType::const_iterator it = labeller.GetAdjacency().begin();
+  for (; it != labeller.GetAdjacency().end(); ++it)
+    {
+    TileEdge edge;
+    edge.labelA = it->first.first;
+    edge.labelB = it->first.second;
+    edge.saddle = it->second;
+    edges.push_back(edge);
+    }
+}
+
+template <class TInputImage>
+void
+PersistentWatershedEquivalenceFilter<TInputImage>
+::AddBorderAdjacency(unsigned int tileA, LocalLabelType labelA, const BorderPixelType & a,
+                     unsigned int tileB, LocalLabelType labelB, const BorderPixelType & b,
+                     int dx, int dy)
+{
+  // Exit of a flat zone towards the adjacent tile
+  const LabellerType * labeller = this->GetLabeller();
+  if (labeller->IsDrain(a, dx, dy) || labeller->IsDrain(b, -dx, -dy))
+    {
+    const bool fromA = labeller->IsDrain(a, dx, dy);
+    BorderDrain border;
+    border.tileSource = fromA ? tileA : tileB;
+    border.tileTarget = fromA ? tileB : tileA;
+    border.drain.source = fromA ? labelA : labelB;
+    border.drain.target = fromA ? labelB : labelA;
+    border.drain.value = fromA ? b.value : a.value;
+    border.drain.position = fromA ? a.position : b.position;
+    m_BorderDrains.push_back(border);
+    }
+
+  if (m_FloodLevel <= 0.)
+    {
+    return;
+    }
+
+  BorderEdge edge;
+  edge.tileA = tileA;
+  edge.labelA = labelA;
+  edge.tileB = tileB;
+  edge.labelB = labelB;
+  edge.saddle.value = a.value < b.value ? b.value : a.value;
+  edge.saddle.first = a.position < b.position ? a.position : b.position;
+  edge.saddle.second = a.position < b.position ? b.position : a.position;
+  m_BorderEdges.push_back(edge);
+}
+
+template <class TInputImage>
+void
+PersistentWatershedEquivalenceFilter<TInputImage>
+::Synthetize()
+{
+  Superclass::Synthetize();
+
+  LabelVectorType basins;
+  this->DrainFlatZones(basins);
+
+  if (m_FloodLevel > 0.)
+    {
+    this->MergeBasins(basins);
+    }
+  else
+    {
+    this->SetMergedLabels(basins, m_NumberOfBasins);
+    }
+
+  std::vector<DrainVectorType>().swap(m_TileDrains);
+  std::vector<BorderDrain>().swap(m_BorderDrains);
+  std::vector<PixelVectorType>().swap(m_TileMinima);
+  std::vector<TileEdgeVectorType>().swap(m_TileEdges);
+  std::vector<BorderEdge>().swap(m_BorderEdges);
+}
+
+template <class TInputImage>
+typename PersistentWatershedEquivalenceFilter<TInputImage>::LabelType
+PersistentWatershedEquivalenceFilter<TInputImage>
+::FindRoot(LabelVectorType & parent, LabelType id) const
+{
+  while (parent[id] != id)
+    {
+    parent[id] = parent[parent[id]];
+    id = parent[id];
+    }
+  return id;
+}
+
+template <class TInputImage>
+double
+PersistentWatershedEquivalenceFilter<TInputImage>
+::GetDepth(const SaddleType & saddle, const PixelType & minimumA, const PixelType & minimumB) const
+{
+  const PixelType & highest = minimumA < minimumB ? minimumB : minimumA;
+  return static_cast<double>(saddle.value) - static_cast<double>(highest);
+}
+
+template <class TInputImage>
+void
+PersistentWatershedEquivalenceFilter<TInputImage>
+::DrainFlatZones(LabelVectorType & basins)
+{
+  const LabelType nbObjects = this->GetNumberOfObjects();
+  const unsigned int nbTiles = m_TileDrains.size();
+
+  // Lowest exit of the flat zone of each base label, if any
+  LabelVectorType target(nbObjects + 1, 0);
+  DrainVectorType exits(nbObjects + 1);
+  for (unsigned int tileId = 0; tileId < nbTiles; ++tileId)
+    {
+    const DrainVectorType & tileDrains = m_TileDrains[tileId];
+    for (typename DrainVectorType::const_iterator it = tileDrains.begin(); it != tileDrains.end(); ++it)
+      {
+      const LabelType source = this->GetBaseLabel(tileId, it->source);
+      const LabelType dest = this->GetBaseLabel(tileId, it->target);
+      if (source != dest && (target[source] == 0 || *it < exits[source]))
+        {
+        target[source] = dest;
+        exits[source] = *it;
+        }
+      }
+    DrainVectorType().swap(m_TileDrains[tileId]);
+    }
+  for (typename std::vector<BorderDrain>::const_iterator it = m_BorderDrains.begin(); it != m_BorderDrains.end(); ++it)
+    {
+    const LabelType source = this->GetBaseLabel(it->tileSource, it->drain.source);
+    const LabelType dest = this->GetBaseLabel(it->tileTarget, it->drain.target);
+    if (source != dest && (target[source] == 0 || it->drain < exits[source]))
+      {
+      target[source] = dest;
+      exits[source] = it->drain;
+      }
+    }
+  std::vector<BorderDrain>().swap(m_BorderDrains);
+
+  // Basins are numbered in the order of the base labels of their minima.
+  // Exits always lead to lower pixels, so following them from any label
+  // ends on a minimum.
+  basins.assign(nbObjects + 1, 0);
+  m_NumberOfBasins = 0;
+  for (LabelType id = 1; id <= nbObjects; ++id)
+    {
+    if (target[id] == 0)
+      {
+      basins[id] = ++m_NumberOfBasins;
+      }
+    }
+  LabelVectorType path;
+  for (LabelType id = 1; id <= nbObjects; ++id)
+    {
+    LabelType current = id;
+    while (basins[current] == 0)
+      {
+      path.push_back(current);
+      current = target[current];
+      }
+    for (typename LabelVectorType::const_iterator it = path.begin(); it != path.end(); ++it)
+      {
+      basins[*it] = basins[current];
+      }
+    path.clear();
+    }
+
+  otbMsgDevMacro(<< "Watershed flat zones: " << nbObjects << " labels drained into " << m_NumberOfBasins << " basins");
+}
+
+template <class TInputImage>
+void
+PersistentWatershedEquivalenceFilter<TInputImage>
+::MergeBasins(const LabelVectorType & basins)
+{
+  const LabelType nbBasins = m_NumberOfBasins;
+  const LabelType nbObjects = this->GetNumberOfObjects();
+  const unsigned int nbTiles = m_TileMinima.size();
+
+  // Minimum height of each basin
+  PixelVectorType minima(nbBasins + 1, itk::NumericTraits<PixelType>::max());
+  for (unsigned int tileId = 0; tileId < nbTiles; ++tileId)
+    {
+    const PixelVectorType & tileMinima = m_TileMinima[tileId];
+    for (LocalLabelType label = 1; label < tileMinima.size(); ++label)
+      {
+      const LabelType basin = basins[this->GetBaseLabel(tileId, label)];
+      if (tileMinima[label] < minima[basin])
+        {
+        minima[basin] = tileMinima[label];
+        }
+      }
+    PixelVectorType().swap(m_TileMinima[tileId]);
+    }
+
+  // Edges of the merge graph, with base labels
+  std::vector<Edge> edges;
+  for (unsigned int tileId = 0; tileId < nbTiles; ++tileId)
+    {
+    const TileEdgeVectorType & tileEdges = m_TileEdges[tileId];
+    for (typename TileEdgeVectorType::const_iterator it = tileEdges.begin(); it != tileEdges.end(); ++it)
+      {
+      Edge edge;
+      edge.a = basins[this->GetBaseLabel(tileId, it->labelA)];
+      edge.b = basins[this->GetBaseLabel(tileId, it->labelB)];
+      edge.saddle = it->saddle;
+      if (edge.a != edge.b)
+        {
+        edges.push_back(edge);
+        }
+      }
+    TileEdgeVectorType().swap(m_TileEdges[tileId]);
+    }
+  for (typename std::vector<BorderEdge>::const_iterator it = m_BorderEdges.begin(); it != m_BorderEdges.end(); ++it)
+    {
+    Edge edge;
+    edge.a = basins[this->GetBaseLabel(it->tileA, it->labelA)];
+    edge.b = basins[this->GetBaseLabel(it->tileB, it->labelB)];
+    edge.saddle = it->saddle;
+    if (edge.a != edge.b)
+      {
+      edges.push_back(edge);
+      }
+    }
+  std::vector<BorderEdge>().swap(m_BorderEdges);
+
+  // Hierarchical merge: the depth of an edge is the height of its saddle
+  // above the highest of the two basin minima. Merging basins can only
+  // lower their minimum, so depths only increase and outdated entries of
+  // the queue are pushed again with their new depth.
+  typedef std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > QueueType;
+
+  LabelVectorType parent(nbBasins + 1);
+  for (LabelType id = 0; id <= nbBasins; ++id)
+    {
+    parent[id] = id;
+    }
+
+  QueueType queue;
+  for (std::size_t e = 0; e < edges.size(); ++e)
+    {
+    QueueItem item;
+    item.depth = this->GetDepth(edges[e].saddle, minima[edges[e].a], minima[edges[e].b]);
+    item.saddle = edges[e].saddle;
+    item.edge = e;
+    queue.push(item);
+    }
+
+  while (!queue.empty())
+    {
+    QueueItem item = queue.top();
+    if (item.depth >= m_FloodLevel)
+      {
+      break;
+      }
+    queue.pop();
+
+    const Edge & edge = edges[item.edge];
+    const LabelType ra = this->FindRoot(parent, edge.a);
+    const LabelType rb = this->FindRoot(parent, edge.b);
+    if (ra == rb)
+      {
+      continue;
+      }
+    const double depth = this->GetDepth(edge.saddle, minima[ra], minima[rb]);
+    if (depth > item.depth)
+      {
+      item.depth = depth;
+      queue.push(item);
+      continue;
+      }
+
+    const LabelType root = ra < rb ? ra : rb;
+    const LabelType child = ra < rb ? rb : ra;
+    parent[child] = root;
+    if (minima[child] < minima[root])
+      {
+      minima[root] = minima[child];
+      }
+    }
+
+  // Consecutive final labels, in the order of the basins
+  LabelVectorType finalLabels(nbBasins + 1, 0);
+  LabelType nbRegions = 0;
+  for (LabelType id = 1; id <= nbBasins; ++id)
+    {
+    const LabelType root = this->FindRoot(parent, id);
+    if (finalLabels[root] == 0)
+      {
+      finalLabels[root] = ++nbRegions;
+      }
+    finalLabels[id] = finalLabels[root];
+    }
+  LabelVectorType mergedLabels(nbObjects + 1, 0);
+  for (LabelType id = 1; id <= nbObjects; ++id)
+    {
+    mergedLabels[id] = finalLabels[basins[id]];
+    }
+
+  otbMsgDevMacro(<< "Watershed merge: " << nbBasins << " basins merged into " << nbRegions << " regions");
+
+  this->SetMergedLabels(mergedLabels, nbRegions);
+}
+
+template <class TInputImage>
+void
+PersistentWatershedEquivalenceFilter<TInputImage>
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "FloodLevel: " << m_FloodLevel << std::endl;
+  os << indent << "NumberOfBasins: " << m_NumberOfBasins << std::endl;
+}
+
+} // end namespace otb
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbStreamingWatershedSegmentationFilter_h
+#define otbStreamingWatershedSegmentationFilter_h
+
+#include "otbTiledLabellingImageFilterBase.h"
+#include "otbPersistentWatershedEquivalenceFilter.h"
+
+namespace otb
+{
+
+/** \class StreamingWatershedSegmentationFilter
+ * \brief Out-of-core watershed segmentation of a height image.
+ *
+ * This filter is a streaming counterpart of WatershedSegmentationFilter:
+ * the input is never loaded as a whole and the label output can be
+ * streamed, so that it can segment full scenes. Tiles are flooded in
+ * parallel by a TileWatershedLabeller with a one pixel overlap, the basins
+ * cut by tile borders are reconciled, and the basins are merged through a
+ * merge graph by a PersistentWatershedEquivalenceFilter (see
+ * TiledLabellingImageFilterBase for the two passes).
+ *
+ * Threshold and Level have the same meaning as in itk::WatershedImageFilter:
+ * heights below min + Threshold * (max - min) are ignored, and neighbouring
+ * basins less deep than Level times the height range above this threshold
+ * are merged. The extrema of the input are computed by an additional
+ * streaming pass when one of them is positive. Before merging, there is
+ * one basin per regional minimum of the thresholded input, like the
+ * regions of itk::MorphologicalWatershedImageFilter at level 0, flat zones
+ * having a lower neighbour being drained to the basin of their lowest
+ * exit. The result does not depend
+ * on the tile size, the streaming layout nor the number of threads, but
+ * it is not identical to the one of itk::WatershedImageFilter, whose
+ * segmenter and merge tree are built differently.
+ *
+ * Labels are consecutive and start at 1. The input is typically a gradient
+ * magnitude image.
+ *
+ * \sa WatershedSegmentationFilter
+ * \sa PersistentWatershedEquivalenceFilter
+ *
+ * \ingroup Streamed
+ * \ingroup Multithreaded
+ *
+ * \ingroup OTBWatersheds
+ */
+template <class TInputImage, class TOutputImage>
+class ITK_EXPORT StreamingWatershedSegmentationFilter :
+  public TiledLabellingImageFilterBase<TInputImage, TOutputImage,
+                                       PersistentWatershedEquivalenceFilter<TInputImage> >
+{
+public:
+  /** Standard class typedefs. */
+  typedef StreamingWatershedSegmentationFilter Self;
+  typedef TiledLabellingImageFilterBase<TInputImage, TOutputImage,
+    PersistentWatershedEquivalenceFilter<TInputImage> > Superclass;
+  typedef itk::SmartPointer<Self>                        Pointer;
+  typedef itk::SmartPointer<const Self>                  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(StreamingWatershedSegmentationFilter, TiledLabellingImageFilterBase);
+
+  typedef typename Superclass::InputPixelType        InputPixelType;
+  typedef typename Superclass::LabellerType          LabellerType;
+  typedef typename Superclass::PersistentFilterType  PersistentFilterType;
+
+  /** Set/Get the threshold, as a fraction of the height range of the input */
+  itkSetClampMacro(Threshold, double, 0., 1.);
+  itkGetConstMacro(Threshold, double);
+
+  /** Set/Get the flood level, as a fraction of the height range above the threshold */
+  itkSetClampMacro(Level, double, 0., 1.);
+  itkGetConstMacro(Level, double);
+
+  /** Set/Get the connectivity: 8-connectivity if true, 4-connectivity otherwise */
+  itkSetMacro(FullyConnected, bool);
+  itkGetConstMacro(FullyConnected, bool);
+  itkBooleanMacro(FullyConnected);
+
+protected:
+  StreamingWatershedSegmentationFilter();
+  ~StreamingWatershedSegmentationFilter() ITK_OVERRIDE {}
+  void PrintSelf(std::ostream& os, itk::Indent indent) const ITK_OVERRIDE;
+
+  void ComputeEquivalences() ITK_OVERRIDE;
+
+private:
+  StreamingWatershedSegmentationFilter(const Self &); //purposely not implemented
+  void operator =(const Self&); //purposely not implemented
+
+  double m_Threshold;
+  double m_Level;
+  bool   m_FullyConnected;
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbStreamingWatershedSegmentationFilter.txx"
+#endif
+
+#endif
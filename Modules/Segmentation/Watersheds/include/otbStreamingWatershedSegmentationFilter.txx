@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbStreamingWatershedSegmentationFilter_txx
+#define otbStreamingWatershedSegmentationFilter_txx
+
+#include "otbStreamingWatershedSegmentationFilter.h"
+#include "otbStreamingMinMaxImageFilter.h"
+#include "itkNumericTraits.h"
+
+namespace otb
+{
+
+template <class TInputImage, class TOutputImage>
+StreamingWatershedSegmentationFilter<TInputImage, TOutputImage>
+::StreamingWatershedSegmentationFilter()
+  : m_Threshold(0.),
+    m_Level(0.),
+    m_FullyConnected(false)
+{
+}
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingWatershedSegmentationFilter<TInputImage, TOutputImage>
+::ComputeEquivalences()
+{
+  PersistentFilterType * persistent = this->GetEquivalenceFilter()->GetFilter();
+  LabellerType * labeller = persistent->GetLabeller();
+  labeller->SetFullyConnected(m_FullyConnected);
+  labeller->SetThreshold(itk::NumericTraits<InputPixelType>::NonpositiveMin());
+  persistent->SetFloodLevel(0.);
+
+  if (m_Threshold > 0. || m_Level > 0.)
+    {
+    typedef StreamingMinMaxImageFilter<TInputImage> MinMaxFilterType;
+    typename MinMaxFilterType::Pointer minMax = MinMaxFilterType::New();
+    minMax->SetInput(this->GetInput());
+    minMax->Update();
+
+    const double minimum = static_cast<double>(minMax->GetMinimum());
+    const double maximum = static_cast<double>(minMax->GetMaximum());
+    const double threshold = minimum + m_Threshold * (maximum - minimum);
+    if (m_Threshold > 0.)
+      {
+      labeller->SetThreshold(static_cast<InputPixelType>(threshold));
+      }
+    persistent->SetFloodLevel(m_Level * (maximum - threshold));
+    }
+
+  Superclass::ComputeEquivalences();
+}
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingWatershedSegmentationFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream& os, itk::Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "Threshold: " << m_Threshold << std::endl;
+  os << indent << "Level: " << m_Level << std::endl;
+  os << indent << "FullyConnected: " << m_FullyConnected << std::endl;
+}
+
+} // end namespace otb
+
+#endif
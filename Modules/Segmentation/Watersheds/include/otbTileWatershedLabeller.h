@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbTileWatershedLabeller_h
+#define otbTileWatershedLabeller_h
+
+#include <vector>
+#include <map>
+#include <utility>
+#include "itkImageRegion.h"
+
+namespace otb
+{
+
+/** \class TileWatershedLabeller
+ * \brief Deterministic watershed labelling of one image tile.
+ *
+ * This helper computes the catchment basins of a single 2D tile of a
+ * height image by steepest descent: each pixel is connected to its lowest
+ * strictly lower neighbour (the first one in a fixed neighbour order in case
+ * of tie). The pixels of a flat zone (neighbouring pixels of equal height)
+ * are connected together, and the flat zone as a whole descends through its
+ * lowest exit: the pixel of the zone having the lowest lower neighbour, the
+ * first one in the image scan order in case of tie. Only the flat zones
+ * without lower neighbour, which are the regional minima of the image, start
+ * a basin. Pixels below Threshold are raised to Threshold beforehand, which
+ * merges the shallow basins of the low areas.
+ *
+ * The tile is read with a margin of one pixel so that the descent of its
+ * border pixels is the same as if the whole image had been processed: two
+ * border pixels of neighbouring tiles are connected if they have the same
+ * height, or if one of them is not in a flat zone and descends to the other.
+ * The exits of a flat zone may lie in other tiles, so they are not connected
+ * in the tile: GetDrains() gives the lowest exit of the local basins whose
+ * flat zone overflows into another basin of the tile, and IsDrain() tells
+ * if a border pixel overflows into a neighbouring tile. Choosing the lowest
+ * exit of each flat zone after the merge of the tiles therefore gives
+ * exactly the basins of the whole image.
+ *
+ * Local labels are consecutive, start at 1 and follow the conventions of
+ * TileConnectedComponentLabeller (border basins first). When
+ * ComputeAdjacency is on, the minimum height of each basin and the lowest
+ * saddle between neighbouring basins of the tile are also collected, to
+ * build the merge graph of PersistentWatershedEquivalenceFilter. Saddles
+ * carry the position of their pixels so that equal saddles are always
+ * ordered the same way, whatever the tiling.
+ *
+ * \sa TileConnectedComponentLabeller
+ * \sa StreamingWatershedSegmentationFilter
+ *
+ * \ingroup OTBWatersheds
+ */
+template <class TInputImage>
+class TileWatershedLabeller
+{
+public:
+  typedef TInputImage                            InputImageType;
+  typedef typename InputImageType::PixelType     InputPixelType;
+  typedef typename InputImageType::RegionType    RegionType;
+  typedef typename InputImageType::IndexType     IndexType;
+  typedef typename InputImageType::SizeType      SizeType;
+
+  typedef unsigned int                           LocalLabelType;
+  typedef std::vector<InputPixelType>            ValueVectorType;
+  typedef std::vector<LocalLabelType>            LabelVectorType;
+
+  /** Linear position of a pixel in the largest possible region */
+  typedef itk::SizeValueType                     PositionType;
+
+  /** Height and position of a border pixel, offset of its steepest
+   * descent, (0, 0) for a pixel without lower neighbour, and flag telling
+   * if it belongs to a flat zone */
+  struct BorderPixelType
+  {
+    InputPixelType value;
+    PositionType   position;
+    signed char    dx;
+    signed char    dy;
+    bool           flat;
+  };
+
+  /** Saddle between two neighbouring pixels: the highest of their heights,
+   * and their positions (first < second) to order equal saddles */
+  struct SaddleType
+  {
+    InputPixelType value;
+    PositionType   first;
+    PositionType   second;
+
+    bool operator<(const SaddleType & other) const
+    {
+      if (value != other.value)
+        {
+        return value < other.value;
+        }
+      if (first != other.first)
+        {
+        return first < other.first;
+        }
+      return second < other.second;
+    }
+  };
+
+  /** Exit of the flat zone of a local basin: the pixel at position
+   * overflows into the basin target, through a neighbour of height value.
+   * The lowest exit is the smallest one. */
+  struct DrainType
+  {
+    LocalLabelType source;
+    LocalLabelType target;
+    InputPixelType value;
+    PositionType   position;
+
+    bool operator<(const DrainType & other) const
+    {
+      if (value != other.value)
+        {
+        return value < other.value;
+        }
+      return position < other.position;
+    }
+  };
+  typedef std::vector<DrainType>                           DrainVectorType;
+
+  /** Lowest saddle between two neighbouring local basins (a < b) */
+  typedef std::pair<LocalLabelType, LocalLabelType>        LabelPairType;
+  typedef std::map<LabelPairType, SaddleType>              AdjacencyMapType;
+
+  TileWatershedLabeller();
+  virtual ~TileWatershedLabeller() {}
+
+  /** Set/Get the connectivity: 8-connectivity if true, 4-connectivity otherwise */
+  void SetFullyConnected(bool flag)
+  {
+    m_FullyConnected = flag;
+  }
+  bool GetFullyConnected() const
+  {
+    return m_FullyConnected;
+  }
+
+  /** Set/Get the height below which pixels are raised */
+  void SetThreshold(const InputPixelType & value)
+  {
+    m_Threshold = value;
+  }
+  const InputPixelType & GetThreshold() const
+  {
+    return m_Threshold;
+  }
+
+  /** Set/Get the flag telling if basin minima and saddles are collected */
+  void SetComputeAdjacency(bool flag)
+  {
+    m_ComputeAdjacency = flag;
+  }
+  bool GetComputeAdjacency() const
+  {
+    return m_ComputeAdjacency;
+  }
+
+  /** One pixel is needed around a tile to compute the descent of its border */
+  unsigned int GetRadius() const
+  {
+    return 1;
+  }
+
+  /** Label the given tile. The tile, padded by GetRadius() and cropped to
+   * the largest possible region, must be inside the buffered region of
+   * the image. */
+  void Label(const InputImageType * image, const RegionType & tile);
+
+  /** Tile processed by the last call to Label() */
+  const RegionType & GetRegion() const
+  {
+    return m_Region;
+  }
+
+  /** Number of basins touching the border of the tile */
+  LocalLabelType GetNumberOfBorderLabels() const
+  {
+    return m_NumberOfBorderLabels;
+  }
+
+  /** Total number of basins in the tile */
+  LocalLabelType GetNumberOfLabels() const
+  {
+    return m_NumberOfLabels;
+  }
+
+  /** Local label of the pixel (x, y), in tile coordinates */
+  LocalLabelType GetLabel(unsigned int x, unsigned int y) const
+  {
+    return m_Labels[y * m_Region.GetSize()[0] + x];
+  }
+
+  /** Height of the pixel (x, y), in tile coordinates, after thresholding */
+  const InputPixelType & GetValue(unsigned int x, unsigned int y) const
+  {
+    return m_Values[(y + m_Margin[1]) * m_PaddedWidth + x + m_Margin[0]];
+  }
+
+  /** Position of the pixel (x, y), in tile coordinates */
+  PositionType GetPosition(unsigned int x, unsigned int y) const
+  {
+    return (m_Region.GetIndex()[1] - m_ImageOrigin[1] + y) * m_ImageWidth
+      + (m_Region.GetIndex()[0] - m_ImageOrigin[0] + x);
+  }
+
+  /** Border information of the pixel (x, y), in tile coordinates */
+  BorderPixelType GetBorderPixel(unsigned int x, unsigned int y) const
+  {
+    const unsigned int pos = y * m_Region.GetSize()[0] + x;
+    BorderPixelType pixel;
+    pixel.value = GetValue(x, y);
+    pixel.position = GetPosition(x, y);
+    pixel.dx = m_DescentX[pos];
+    pixel.dy = m_DescentY[pos];
+    pixel.flat = m_Flat[pos];
+    return pixel;
+  }
+
+  /** Tells if two border pixels of neighbouring tiles belong to the same
+   * basin, (dx, dy) being the offset from a to b */
+  bool IsConnected(const BorderPixelType & a, const BorderPixelType & b, int dx, int dy) const
+  {
+    if (a.value == b.value)
+      {
+      return true;
+      }
+    if (!a.flat && a.dx == dx && a.dy == dy)
+      {
+      return true;
+      }
+    return !b.flat && b.dx == -dx && b.dy == -dy;
+  }
+
+  /** Tells if the flat zone of a border pixel overflows into its neighbour
+   * of the adjacent tile at offset (dx, dy) */
+  bool IsDrain(const BorderPixelType & a, int dx, int dy) const
+  {
+    return a.flat && a.dx == dx && a.dy == dy;
+  }
+
+  /** Lowest exit inside the tile of the flat zones of the local basins,
+   * for the basins having one */
+  const DrainVectorType & GetDrains() const
+  {
+    return m_Drains;
+  }
+
+  /** Minimum height of each local basin, indexed by local label (valid
+   * with ComputeAdjacency) */
+  const ValueVectorType & GetMinimumValues() const
+  {
+    return m_MinimumValues;
+  }
+
+  /** Lowest saddle between neighbouring local basins (valid with
+   * ComputeAdjacency) */
+  const AdjacencyMapType & GetAdjacency() const
+  {
+    return m_Adjacency;
+  }
+
+private:
+  typedef std::vector<signed char> OffsetVectorType;
+  typedef std::vector<bool>        FlagVectorType;
+
+  LocalLabelType FindRoot(LocalLabelType pos);
+  void Union(LocalLabelType a, LocalLabelType b);
+
+  /** Assign the next final label to the basin of a pixel, if needed */
+  void AssignFinalLabel(unsigned int pos, LabelVectorType & finalLabels);
+
+  /** Record the saddle between two neighbouring pixels of the tile */
+  void AddSaddle(unsigned int xa, unsigned int ya, unsigned int xb, unsigned int yb);
+
+  bool             m_FullyConnected;
+  InputPixelType   m_Threshold;
+  bool             m_ComputeAdjacency;
+
+  RegionType       m_Region;
+  IndexType        m_ImageOrigin;
+  PositionType     m_ImageWidth;
+  unsigned int     m_Margin[2];
+  unsigned int     m_PaddedWidth;
+  ValueVectorType  m_Values;
+  OffsetVectorType m_DescentX;
+  OffsetVectorType m_DescentY;
+  FlagVectorType   m_Flat;
+  LabelVectorType  m_Labels;
+  LabelVectorType  m_Parent;
+  LocalLabelType   m_NumberOfBorderLabels;
+  LocalLabelType   m_NumberOfLabels;
+  DrainVectorType  m_Drains;
+
+  ValueVectorType  m_MinimumValues;
+  AdjacencyMapType m_Adjacency;
+};
+
+} // end namespace otb
+
+#ifndef OTB_MANUAL_INSTANTIATION
+#include "otbTileWatershedLabeller.txx"
+#endif
+
+#endif
@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef otbTileWatershedLabeller_txx
+#define otbTileWatershedLabeller_txx
+
+#include "otbTileWatershedLabeller.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkNumericTraits.h"
+
+namespace otb
+{
+
+template <class TInputImage>
+TileWatershedLabeller<TInputImage>
+::TileWatershedLabeller()
+  : m_FullyConnected(false),
+    m_Threshold(itk::NumericTraits<InputPixelType>::NonpositiveMin()),
+    m_ComputeAdjacency(false),
+    m_ImageWidth(0),
+    m_PaddedWidth(0),
+    m_NumberOfBorderLabels(0),
+    m_NumberOfLabels(0)
+{
+  m_ImageOrigin.Fill(0);
+  m_Margin[0] = 0;
+  m_Margin[1] = 0;
+}
+
+template <class TInputImage>
+typename TileWatershedLabeller<TInputImage>::LocalLabelType
+TileWatershedLabeller<TInputImage>
+::FindRoot(LocalLabelType pos)
+{
+  while (m_Parent[pos] != pos)
+    {
+    m_Parent[pos] = m_Parent[m_Parent[pos]];
+    pos = m_Parent[pos];
+    }
+  return pos;
+}
+
+template <class TInputImage>
+void
+TileWatershedLabeller<TInputImage>
+::Union(LocalLabelType a, LocalLabelType b)
+{
+  LocalLabelType ra = FindRoot(a);
+  LocalLabelType rb = FindRoot(b);
+  if (ra < rb)
+    {
+    m_Parent[rb] = ra;
+    }
+  else if (rb < ra)
+    {
+    m_Parent[ra] = rb;
+    }
+}
+
+template <class TInputImage>
+void
+TileWatershedLabeller<TInputImage>
+::AssignFinalLabel(unsigned int pos, LabelVectorType & finalLabels)
+{
+  LocalLabelType root = FindRoot(pos);
+  if (finalLabels[root] == 0)
+    {
+    finalLabels[root] = ++m_NumberOfLabels;
+    }
+}
+
+template <class TInputImage>
+void
+TileWatershedLabeller<TInputImage>
+::AddSaddle(unsigned int xa, unsigned int ya, unsigned int xb, unsigned int yb)
+{
+  const unsigned int width = m_Region.GetSize()[0];
+  const LocalLabelType labelA = m_Labels[ya * width + xa];
+  const LocalLabelType labelB = m_Labels[yb * width + xb];
+  if (labelA == labelB)
+    {
+    return;
+    }
+
+  // Pixel b is always after pixel a in the scan order
+  SaddleType saddle;
+  saddle.value = GetValue(xa, ya) < GetValue(xb, yb) ? GetValue(xb, yb) : GetValue(xa, ya);
+  saddle.first = GetPosition(xa, ya);
+  saddle.second = GetPosition(xb, yb);
+
+  const LabelPairType key = labelA < labelB ? LabelPairType(labelA, labelB) : LabelPairType(labelB, labelA);
+  typename AdjacencyMapType::iterator it = m_Adjacency.find(key);
+  if (it == m_Adjacency.end())
+    {
+    m_Adjacency.insert(std::make_pair(key, saddle));
+    }
+  else if (saddle < it->second)
+    {
+    it->second = saddle;
+    }
+}
+
+template <class TInputImage>
+void
+TileWatershedLabeller<TInputImage>
+::Label(const InputImageType * image, const RegionType & tile)
+{
+  // Neighbour offsets, in a fixed order used to break ties
+  static const int offsets4[4][2] = {{0, -1}, {-1, 0}, {1, 0}, {0, 1}};
+  static const int offsets8[8][2] = {{-1, -1}, {0, -1}, {1, -1}, {-1, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+  const int (*offsets)[2] = m_FullyConnected ? offsets8 : offsets4;
+  const unsigned int nbOffsets = m_FullyConnected ? 8 : 4;
+
+  m_Region = tile;
+  const unsigned int width  = tile.GetSize()[0];
+  const unsigned int height = tile.GetSize()[1];
+  const unsigned int nbPixels = width * height;
+
+  m_Labels.assign(nbPixels, 0);
+  m_DescentX.assign(nbPixels, 0);
+  m_DescentY.assign(nbPixels, 0);
+  m_Flat.assign(nbPixels, false);
+  m_Drains.clear();
+  m_MinimumValues.clear();
+  m_Adjacency.clear();
+  m_NumberOfBorderLabels = 0;
+  m_NumberOfLabels = 0;
+
+  if (nbPixels == 0)
+    {
+    m_Values.clear();
+    m_Parent.clear();
+    return;
+    }
+
+  // Copy the tile and its margin in a contiguous row-major buffer, raising
+  // the pixels below the threshold
+  const RegionType largest = image->GetLargestPossibleRegion();
+  m_ImageOrigin = largest.GetIndex();
+  m_ImageWidth = largest.GetSize()[0];
+
+  RegionType padded = tile;
+  padded.PadByRadius(this->GetRadius());
+  padded.Crop(largest);
+  for (unsigned int dim = 0; dim < 2; ++dim)
+    {
+    m_Margin[dim] = static_cast<unsigned int>(tile.GetIndex()[dim] - padded.GetIndex()[dim]);
+    }
+  m_PaddedWidth = padded.GetSize()[0];
+  const int paddedWidth = static_cast<int>(padded.GetSize()[0]);
+  const int paddedHeight = static_cast<int>(padded.GetSize()[1]);
+
+  m_Values.resize(padded.GetNumberOfPixels());
+  itk::ImageRegionConstIterator<InputImageType> it(image, padded);
+  typename ValueVectorType::iterator valueIt = m_Values.begin();
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it, ++valueIt)
+    {
+    const InputPixelType value = it.Get();
+    *valueIt = value < m_Threshold ? m_Threshold : value;
+    }
+
+  // Steepest descent of each pixel of the tile, and flat zone pixels
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    const int py = static_cast<int>(y + m_Margin[1]);
+    for (unsigned int x = 0; x < width; ++x)
+      {
+      const int px = static_cast<int>(x + m_Margin[0]);
+      const InputPixelType & center = m_Values[py * paddedWidth + px];
+      InputPixelType lowest = center;
+      const unsigned int pos = y * width + x;
+      for (unsigned int k = 0; k < nbOffsets; ++k)
+        {
+        const int qx = px + offsets[k][0];
+        const int qy = py + offsets[k][1];
+        if (qx < 0 || qy < 0 || qx >= paddedWidth || qy >= paddedHeight)
+          {
+          continue;
+          }
+        const InputPixelType & value = m_Values[qy * paddedWidth + qx];
+        if (value == center)
+          {
+          m_Flat[pos] = true;
+          }
+        else if (value < lowest)
+          {
+          lowest = value;
+          m_DescentX[pos] = static_cast<signed char>(offsets[k][0]);
+          m_DescentY[pos] = static_cast<signed char>(offsets[k][1]);
+          }
+        }
+      }
+    }
+
+  // Basins: pixels are connected to their descent, and flat zone pixels
+  // to their equal neighbours. Flat zones are connected to their lowest
+  // exit only once the whole zone is known.
+  m_Parent.resize(nbPixels);
+  for (unsigned int pos = 0; pos < nbPixels; ++pos)
+    {
+    m_Parent[pos] = pos;
+    }
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    for (unsigned int x = 0; x < width; ++x)
+      {
+      const unsigned int pos = y * width + x;
+      if (!m_Flat[pos])
+        {
+        const int dx = m_DescentX[pos];
+        const int dy = m_DescentY[pos];
+        const int tx = static_cast<int>(x) + dx;
+        const int ty = static_cast<int>(y) + dy;
+        if ((dx != 0 || dy != 0)
+            && tx >= 0 && ty >= 0 && tx < static_cast<int>(width) && ty < static_cast<int>(height))
+          {
+          Union(pos, ty * width + tx);
+          }
+        continue;
+        }
+
+      const InputPixelType & value = GetValue(x, y);
+      for (unsigned int k = 0; k < nbOffsets / 2; ++k)
+        {
+        // The first half of the offsets are the already visited neighbours
+        const int tx = static_cast<int>(x) + offsets[k][0];
+        const int ty = static_cast<int>(y) + offsets[k][1];
+        if (tx < 0 || ty < 0 || tx >= static_cast<int>(width))
+          {
+          continue;
+          }
+        if (GetValue(tx, ty) == value)
+          {
+          Union(pos, ty * width + tx);
+          }
+        }
+      }
+    }
+
+  // Consecutive labels, border basins first
+  LabelVectorType finalLabels(nbPixels, 0);
+  for (unsigned int x = 0; x < width; ++x)
+    {
+    AssignFinalLabel(x, finalLabels);
+    }
+  for (unsigned int x = 0; x < width; ++x)
+    {
+    AssignFinalLabel((height - 1) * width + x, finalLabels);
+    }
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    AssignFinalLabel(y * width, finalLabels);
+    }
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    AssignFinalLabel(y * width + width - 1, finalLabels);
+    }
+  m_NumberOfBorderLabels = m_NumberOfLabels;
+
+  for (unsigned int pos = 0; pos < nbPixels; ++pos)
+    {
+    AssignFinalLabel(pos, finalLabels);
+    }
+  for (unsigned int pos = 0; pos < nbPixels; ++pos)
+    {
+    m_Labels[pos] = finalLabels[FindRoot(pos)];
+    }
+
+  // Lowest exit inside the tile of the flat zone of each basin. Exits
+  // towards the margin are found when merging the tiles.
+  DrainVectorType drains(m_NumberOfLabels + 1);
+  for (LocalLabelType label = 0; label <= m_NumberOfLabels; ++label)
+    {
+    drains[label].source = label;
+    drains[label].target = 0;
+    }
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    for (unsigned int x = 0; x < width; ++x)
+      {
+      const unsigned int pos = y * width + x;
+      const int tx = static_cast<int>(x) + m_DescentX[pos];
+      const int ty = static_cast<int>(y) + m_DescentY[pos];
+      if (!m_Flat[pos] || (tx == static_cast<int>(x) && ty == static_cast<int>(y))
+          || tx < 0 || ty < 0 || tx >= static_cast<int>(width) || ty >= static_cast<int>(height))
+        {
+        continue;
+        }
+      DrainType drain;
+      drain.source = m_Labels[pos];
+      drain.target = m_Labels[ty * width + tx];
+      drain.value = GetValue(tx, ty);
+      drain.position = GetPosition(x, y);
+      if (drains[drain.source].target == 0 || drain < drains[drain.source])
+        {
+        drains[drain.source] = drain;
+        }
+      }
+    }
+  for (LocalLabelType label = 1; label <= m_NumberOfLabels; ++label)
+    {
+    if (drains[label].target != 0)
+      {
+      m_Drains.push_back(drains[label]);
+      }
+    }
+
+  if (!m_ComputeAdjacency)
+    {
+    return;
+    }
+
+  // Basin minima and lowest saddles between neighbouring basins
+  m_MinimumValues.assign(m_NumberOfLabels + 1, itk::NumericTraits<InputPixelType>::max());
+  for (unsigned int y = 0; y < height; ++y)
+    {
+    for (unsigned int x = 0; x < width; ++x)
+      {
+      const unsigned int pos = y * width + x;
+      const InputPixelType & value = GetValue(x, y);
+      if (value < m_MinimumValues[m_Labels[pos]])
+        {
+        m_MinimumValues[m_Labels[pos]] = value;
+        }
+      for (unsigned int k = nbOffsets - nbOffsets / 2; k < nbOffsets; ++k)
+        {
+        // The second half of the offsets are the next neighbours
+        const int tx = static_cast<int>(x) + offsets[k][0];
+        const int ty = static_cast<int>(y) + offsets[k][1];
+        if (tx < 0 || tx >= static_cast<int>(width) || ty >= static_cast<int>(height))
+          {
+          continue;
+          }
+        AddSaddle(x, y, tx, ty);
+        }
+      }
+    }
+}
+
+} // end namespace otb
+
+#endif
@@ -18,12 +18,16 @@
 # limitations under the License.
 #
 
-set(DOCUMENTATION "OTB implementation of Watersheds segmentation algorithm.")
+set(DOCUMENTATION "OTB implementation of Watersheds segmentation algorithm,
+including a streaming tiled watershed for images that do not fit in memory.")
 
 otb_module(OTBWatersheds
   DEPENDS
     OTBCommon
     OTBITK
+    OTBLabelling
+    OTBStatistics
+    OTBStreaming
 
   TEST_DEPENDS
     OTBTestKernel
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2005-2017 Centre National d'Etudes Spatiales (CNES)
+ *
+ * This file is part of Orfeo Toolbox
+ *
+ *     https://www.orfeo-toolbox.org/
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "otbStreamingWatershedSegmentationFilter.h"
+#include "otbImage.h"
+#include "otbImageFileReader.h"
+#include "itkGradientMagnitudeImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkMorphologicalWatershedImageFilter.h"
+#include "itkRegionalMinimaImageFilter.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "vcl_cmath.h"
+#include <map>
+#include <set>
+#include <algorithm>
+
+int otbStreamingWatershedSegmentationFilter(int argc, char * argv[])
+{
+  if (argc != 6)
+    {
+    std::cerr << "Usage: " << argv[0] <<
+    " inputFileName tileSize nbDivisions threshold level"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const char *       inputFileName = argv[1];
+  const unsigned int tileSize      = atoi(argv[2]);
+  const unsigned int nbDivisions   = atoi(argv[3]);
+  const double       threshold     = atof(argv[4]);
+  const double       level         = atof(argv[5]);
+
+  const unsigned int Dimension = 2;
+  typedef float                                            PixelType;
+  typedef unsigned int                                     LabelPixelType;
+  typedef otb::Image<PixelType,Dimension>                  InputImageType;
+  typedef otb::Image<LabelPixelType, Dimension>            LabelImageType;
+  typedef otb::ImageFileReader<InputImageType>             ReaderType;
+
+  typedef itk::GradientMagnitudeImageFilter<InputImageType,InputImageType>          GradientMagnitudeFilterType;
+  typedef otb::StreamingWatershedSegmentationFilter<InputImageType, LabelImageType> FilterType;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(inputFileName);
+
+  GradientMagnitudeFilterType::Pointer gradientMagnitudeFilter = GradientMagnitudeFilterType::New();
+  gradientMagnitudeFilter->SetInput(reader->GetOutput());
+  gradientMagnitudeFilter->Update();
+  const InputImageType::RegionType region = gradientMagnitudeFilter->GetOutput()->GetLargestPossibleRegion();
+
+  // Tiled and streamed segmentation
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(gradientMagnitudeFilter->GetOutput());
+  filter->SetTileSize(tileSize);
+  filter->SetThreshold(threshold);
+  filter->SetLevel(level);
+  filter->GetEquivalenceFilter()->GetStreamer()->SetNumberOfDivisionsStrippedStreaming(nbDivisions);
+  filter->Update();
+
+  // Same segmentation with a single tile
+  FilterType::Pointer reference = FilterType::New();
+  reference->SetInput(gradientMagnitudeFilter->GetOutput());
+  reference->SetTileSize(std::max(region.GetSize()[0], region.GetSize()[1]));
+  reference->SetThreshold(threshold);
+  reference->SetLevel(level);
+  reference->GetEquivalenceFilter()->GetStreamer()->SetNumberOfDivisionsStrippedStreaming(1);
+  reference->Update();
+
+  if (filter->GetObjectCount() != reference->GetObjectCount())
+    {
+    std::cerr << "Wrong number of regions: " << filter->GetObjectCount()
+              << " instead of " << reference->GetObjectCount() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Tiling must not change the segmentation
+  std::map<LabelPixelType, LabelPixelType> forward, backward;
+  itk::ImageRegionConstIterator<LabelImageType> outIt(filter->GetOutput(), region);
+  itk::ImageRegionConstIterator<LabelImageType> refIt(reference->GetOutput(), region);
+  for (outIt.GoToBegin(), refIt.GoToBegin(); !outIt.IsAtEnd(); ++outIt, ++refIt)
+    {
+    const LabelPixelType label = outIt.Get();
+    const LabelPixelType refLabel = refIt.Get();
+    if (label == 0 || label > filter->GetObjectCount())
+      {
+      std::cerr << "Invalid label " << label << " at " << outIt.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    if ((forward.count(label) && forward[label] != refLabel)
+        || (backward.count(refLabel) && backward[refLabel] != label))
+      {
+      std::cerr << "Region mismatch at " << outIt.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    forward[label] = refLabel;
+    backward[refLabel] = label;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+typedef otb::Image<float, 2>         WSHeightImageType;
+typedef otb::Image<unsigned int, 2>  WSLabelImageType;
+typedef otb::Image<unsigned char, 2> WSMaskImageType;
+
+// Compare the basins of the streaming watershed at level 0 with the regions
+// of itk::MorphologicalWatershedImageFilter: both must have one region per
+// regional minimum, and label each minimum the same way
+template <class TFilter>
+int CheckWatershedMinima(TFilter * filter, const WSHeightImageType * image, bool fullyConnected)
+{
+  typedef itk::MorphologicalWatershedImageFilter<WSHeightImageType, WSLabelImageType> ReferenceFilterType;
+  typedef itk::RegionalMinimaImageFilter<WSHeightImageType, WSMaskImageType>         MinimaFilterType;
+  typedef WSLabelImageType::PixelType                                                LabelPixelType;
+
+  ReferenceFilterType::Pointer reference = ReferenceFilterType::New();
+  reference->SetInput(image);
+  reference->SetLevel(0.);
+  reference->SetMarkWatershedLine(false);
+  reference->SetFullyConnected(fullyConnected);
+  reference->Update();
+
+  MinimaFilterType::Pointer minima = MinimaFilterType::New();
+  minima->SetInput(image);
+  minima->SetFullyConnected(fullyConnected);
+  minima->SetFlatIsMinima(true);
+  minima->SetForegroundValue(1);
+  minima->SetBackgroundValue(0);
+  minima->Update();
+
+  const WSLabelImageType::RegionType region = image->GetLargestPossibleRegion();
+  std::set<LabelPixelType> referenceLabels;
+  std::map<LabelPixelType, LabelPixelType> forward, backward;
+  itk::ImageRegionConstIterator<WSLabelImageType> outIt(filter->GetOutput(), region);
+  itk::ImageRegionConstIterator<WSLabelImageType> refIt(reference->GetOutput(), region);
+  itk::ImageRegionConstIterator<WSMaskImageType>  minIt(minima->GetOutput(), region);
+  for (outIt.GoToBegin(), refIt.GoToBegin(), minIt.GoToBegin(); !outIt.IsAtEnd(); ++outIt, ++refIt, ++minIt)
+    {
+    const LabelPixelType label = outIt.Get();
+    const LabelPixelType refLabel = refIt.Get();
+    if (label == 0 || label > filter->GetObjectCount())
+      {
+      std::cerr << "Invalid label " << label << " at " << outIt.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    referenceLabels.insert(refLabel);
+    if (minIt.Get() == 0)
+      {
+      continue;
+      }
+    if ((forward.count(label) && forward[label] != refLabel)
+        || (backward.count(refLabel) && backward[refLabel] != label))
+      {
+      std::cerr << "Minimum mismatch at " << outIt.GetIndex()
+                << " (FullyConnected: " << fullyConnected << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    forward[label] = refLabel;
+    backward[refLabel] = label;
+    }
+
+  if (filter->GetObjectCount() != referenceLabels.size() || forward.size() != referenceLabels.size())
+    {
+    std::cerr << "Wrong number of basins: " << filter->GetObjectCount() << " with "
+              << forward.size() << " minima instead of " << referenceLabels.size()
+              << " (FullyConnected: " << fullyConnected << ")" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+int otbStreamingWatershedSegmentationFilterMorphological(int argc, char * argv[])
+{
+  if (argc != 4)
+    {
+    std::cerr << "Usage: " << argv[0] << " tileSize nbDivisions fullyConnected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const unsigned int tileSize       = atoi(argv[1]);
+  const unsigned int nbDivisions    = atoi(argv[2]);
+  const bool         fullyConnected = atoi(argv[3]) != 0;
+
+  typedef otb::StreamingWatershedSegmentationFilter<WSHeightImageType, WSLabelImageType> FilterType;
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator                         GeneratorType;
+
+  // Smooth relief with integer heights and noise, so that many flat zones,
+  // minimal or not, cross the tile borders
+  WSHeightImageType::SizeType size;
+  size[0] = 211;
+  size[1] = 173;
+  WSHeightImageType::RegionType region;
+  region.SetSize(size);
+
+  WSHeightImageType::Pointer image = WSHeightImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize(4321);
+  itk::ImageRegionIterator<WSHeightImageType> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    const double x = it.GetIndex()[0];
+    const double y = it.GetIndex()[1];
+    const double relief = 4. * (vcl_sin(x / 9.) + vcl_cos(y / 7. + x / 23.));
+    it.Set(static_cast<float>(vcl_floor(relief + 3. * generator->GetUniformVariate(0., 1.))));
+    }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetTileSize(tileSize);
+  filter->SetFullyConnected(fullyConnected);
+  filter->GetEquivalenceFilter()->GetStreamer()->SetNumberOfDivisionsStrippedStreaming(nbDivisions);
+  filter->Update();
+
+  if (CheckWatershedMinima(filter.GetPointer(), image, fullyConnected) == EXIT_FAILURE)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Run again with another connectivity, on the same labelling grid
+  filter->SetFullyConnected(!fullyConnected);
+  filter->Update();
+
+  if (CheckWatershedMinima(filter.GetPointer(), image, !fullyConnected) == EXIT_FAILURE)
+    {
+    return EXIT_FAILURE;
+    }
+  const unsigned int nbBasins = filter->GetObjectCount();
+
+  // Then merge the shallow basins, still on the same grid
+  filter->SetLevel(0.2);
+  filter->Update();
+
+  if (filter->GetObjectCount() == 0 || filter->GetObjectCount() >= nbBasins)
+    {
+    std::cerr << "Wrong number of regions after merge: " << filter->GetObjectCount()
+              << " for " << nbBasins << " basins" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
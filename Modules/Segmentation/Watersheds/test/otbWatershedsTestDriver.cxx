@@ -23,4 +23,6 @@
 void RegisterTests()
 {
   REGISTER_TEST(otbWatershedSegmentationFilter);
+  REGISTER_TEST(otbStreamingWatershedSegmentationFilter);
+  REGISTER_TEST(otbStreamingWatershedSegmentationFilterMorphological);
 }
@@ -79,6 +79,14 @@ void ElevationParametersHandler::AddElevationParameters(Application::Pointer app
   app->SetParameterDescription(oss.str(),"This parameter allows setting the default height above ellipsoid when there is no DEM available, no coverage for some points or pixels with no_data in the DEM tiles, and no geoid file has been set. This is also used by some application as an average elevation value.");
   app->SetDefaultParameterFloat(oss.str(), 0.);
 
+  // In-memory DEM cache
+  oss.str("");
+  oss << key <<".cache";
+  app->AddParameter(ParameterType_Empty, oss.str(), "Cache elevation in memory");
+  app->SetParameterDescription(oss.str(),"If activated, elevation is sampled once per 1x1 degree tile at 3 arc-second posts and later lookups are interpolated from memory, which speeds up geometric processing on large images. Elevation sources finer than 3 arc-seconds are smoothed accordingly.");
+  app->MandatoryOff(oss.str());
+  app->DisableParameter(oss.str());
+
  // TODO : not implemented yet
  //   // Tiff image
  //   oss << ".tiff";
@@ -125,6 +133,13 @@ void ElevationParametersHandler::SetupDEMHandlerFromElevationParameters(const Ap
       app->GetLogger()->Warning( oss.str() );
       }
     }
+
+  // Enable the in-memory cache once the elevation sources are set
+  otb::DEMHandler::Instance()->SetUseCache(IsCacheUsed(app,key));
+  if(IsCacheUsed(app,key))
+    {
+    app->GetLogger()->Info("Elevation management: caching elevation tiles in memory\n");
+    }
 }
 
 /**
@@ -180,6 +195,19 @@ ElevationParametersHandler::IsDEMUsed(const Application::Pointer app, const std:
   return app->IsParameterEnabled(demKey.str()) && app->HasValue(demKey.str());
 }
 
+/**
+ *
+ * Is the elevation cache used
+ */
+bool
+ElevationParametersHandler::IsCacheUsed(const Application::Pointer app, const std::string& key)
+{
+  std::ostringstream cacheKey;
+  cacheKey<< key<<".cache";
+
+  return app->IsParameterEnabled(cacheKey.str());
+}
+
 
 const std::string
 ElevationParametersHandler::GetDEMDirectory(const Application::Pointer app, const std::string& key)